@@ -207,6 +207,12 @@ public:
      */
     bool isVisibleInFrustum(const AABB* aabb) const;
     
+    /**
+     * Get the frustum of the camera, e.g. to query an AABBTree.
+     * @since v3.18
+     */
+    const Frustum& getFrustum() const;
+    
     /**
      * Get object depth towards camera
      */
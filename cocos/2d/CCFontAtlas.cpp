@@ -30,12 +30,18 @@
 #elif CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
 #include "platform/android/jni/Java_org_cocos2dx_lib_Cocos2dxHelper.h"
 #endif
+#include <algorithm>
+#include <chrono>
+#include <deque>
+
 #include "2d/CCFontFreeType.h"
 #include "base/ccUTF8.h"
 #include "base/CCDirector.h"
 #include "base/CCEventListenerCustom.h"
 #include "base/CCEventDispatcher.h"
 #include "base/CCEventType.h"
+#include "base/CCScheduler.h"
+#include "base/CCAsyncTaskPool.h"
 
 NS_CC_BEGIN
 
@@ -43,6 +49,34 @@ const int FontAtlas::CacheTextureWidth = 512;
 const int FontAtlas::CacheTextureHeight = 512;
 const char* FontAtlas::CMD_PURGE_FONTATLAS = "__cc_PURGE_FONTATLAS";
 const char* FontAtlas::CMD_RESET_FONTATLAS = "__cc_RESET_FONTATLAS";
+const char* FontAtlas::CMD_LETTERS_ADDED = "__cc_LETTERS_ADDED_FONTATLAS";
+bool FontAtlas::s_defaultAsyncRasterizationEnabled = false;
+float FontAtlas::s_uploadBudget = 0.002f;
+
+// letters rasterized by a task, a task per letter would cost more than the small glyphs
+static const size_t LETTERS_PER_TASK = 8;
+static const char* ADD_LETTERS_KEY = "FontAtlas::addRasterizedLetters";
+
+struct FontAtlas::AsyncLetters
+{
+    struct Letter
+    {
+        char32_t utf32Char;
+        unsigned int code;
+        FontFreeType::GlyphBitmap glyph;
+    };
+
+    // everything but the letters of the running tasks is only touched on the cocos thread
+    FontAtlas* atlas;
+    // bumped when the atlas is reset, the letters of the former generation are dropped
+    unsigned int generation;
+    // letters with a placeholder definition
+    size_t pendingCount;
+    std::deque<Letter> rasterizedLetters;
+    std::vector<AsyncTaskPool::TaskHandle> tasks;
+    std::vector<std::function<void()>> prewarmCallbacks;
+    bool scheduled;
+};
 
 FontAtlas::FontAtlas(Font &theFont) 
 : _font(&theFont)
@@ -53,6 +87,7 @@ FontAtlas::FontAtlas(Font &theFont)
 , _rendererRecreatedListener(nullptr)
 , _antialiasEnabled(true)
 , _currLineHeight(0)
+, _asyncRasterizationEnabled(s_defaultAsyncRasterizationEnabled)
 {
     _font->retain();
 
@@ -72,9 +107,9 @@ FontAtlas::FontAtlas(Font &theFont)
             _letterPadding += 2 * FontFreeType::DistanceMapSpread;    
         }
 
-#if CC_ENABLE_CACHE_TEXTURE_DATA
         auto eventDispatcher = Director::getInstance()->getEventDispatcher();
 
+#if CC_ENABLE_CACHE_TEXTURE_DATA
         _rendererRecreatedListener = EventListenerCustom::create(EVENT_RENDERER_RECREATED, CC_CALLBACK_1(FontAtlas::listenRendererRecreated, this));
         eventDispatcher->addEventListenerWithFixedPriority(_rendererRecreatedListener, 1);
 #endif
@@ -83,6 +118,8 @@ FontAtlas::FontAtlas(Font &theFont)
 
 void FontAtlas::reinit()
 {
+    _dirtyRects.clear();
+
     if (_currentPageData)
     {
         delete []_currentPageData;
@@ -113,6 +150,27 @@ void FontAtlas::reinit()
 
 FontAtlas::~FontAtlas()
 {
+    if (_asyncLetters)
+    {
+        // the tasks use the font, which is released below
+        _asyncLetters->atlas = nullptr;
+        if (_asyncLetters->scheduled)
+        {
+            Director::getInstance()->getScheduler()->unschedule(ADD_LETTERS_KEY, this);
+        }
+        for (auto& task : _asyncLetters->tasks)
+        {
+            task->cancel();
+        }
+        for (auto& task : _asyncLetters->tasks)
+        {
+            if (!task->isDone())
+            {
+                AsyncTaskPool::getInstance()->wait(task);
+            }
+        }
+    }
+
 #if CC_ENABLE_CACHE_TEXTURE_DATA
     if (_fontFreeType && _rendererRecreatedListener)
     {
@@ -138,6 +196,24 @@ FontAtlas::~FontAtlas()
 
 void FontAtlas::reset()
 {
+    if (_asyncLetters)
+    {
+        for (auto& task : _asyncLetters->tasks)
+        {
+            task->cancel();
+        }
+        _asyncLetters->tasks.clear();
+        _asyncLetters->generation++;
+        _asyncLetters->pendingCount = 0;
+        _asyncLetters->rasterizedLetters.clear();
+        if (_asyncLetters->scheduled)
+        {
+            Director::getInstance()->getScheduler()->unschedule(ADD_LETTERS_KEY, this);
+            _asyncLetters->scheduled = false;
+        }
+        notifyPrewarmCallbacks();
+    }
+
     releaseTextures();
     
     _currLineHeight = 0;
@@ -352,6 +428,12 @@ bool FontAtlas::prepareLetterDefinitions(const std::u32string& utf32Text)
         return false;
     }
 
+    if (_asyncRasterizationEnabled)
+    {
+        rasterizeLettersAsync(codeMapOfNewChar, false);
+        return true;
+    }
+
     int adjustForDistanceMap = _letterPadding / 2;
     int adjustForExtend = _letterEdgeExtend / 2;
     long bitmapWidth;
@@ -361,9 +443,8 @@ bool FontAtlas::prepareLetterDefinitions(const std::u32string& utf32Text)
     FontLetterDefinition tempDef;
 
     auto scaleFactor = CC_CONTENT_SCALE_FACTOR();
-    auto  pixelFormat = _fontFreeType->getOutlineSize() > 0 ? Texture2D::PixelFormat::AI88 : Texture2D::PixelFormat::A8;
-
-    float startY = _currentPageOrigY;
+    // renderCharAt() writes the distance map around the glyph
+    int distanceMapMargin = _fontFreeType->isDistanceFieldEnabled() ? 2 * FontFreeType::DistanceMapSpread : 0;
 
     for (auto&& it : codeMapOfNewChar)
     {
@@ -376,51 +457,15 @@ bool FontAtlas::prepareLetterDefinitions(const std::u32string& utf32Text)
             tempDef.offsetX = tempRect.origin.x - adjustForDistanceMap - adjustForExtend;
             tempDef.offsetY = _fontAscender + tempRect.origin.y - adjustForDistanceMap - adjustForExtend;
 
-            if (_currentPageOrigX + tempDef.width > CacheTextureWidth)
-            {
-                _currentPageOrigY += _currLineHeight;
-                _currLineHeight = 0;
-                _currentPageOrigX = 0;
-                if (_currentPageOrigY + _lineHeight + _letterPadding + _letterEdgeExtend >= CacheTextureHeight)
-                {
-                    unsigned char *data = nullptr;
-                    if (pixelFormat == Texture2D::PixelFormat::AI88)
-                    {
-                        data = _currentPageData + CacheTextureWidth * (int)startY * 2;
-                    }
-                    else
-                    {
-                        data = _currentPageData + CacheTextureWidth * (int)startY;
-                    }
-                    _atlasTextures[_currentPage]->updateWithData(data, 0, startY,
-                        CacheTextureWidth, CacheTextureHeight - startY);
-
-                    startY = 0.0f;
-
-                    _currentPageOrigY = 0;
-                    memset(_currentPageData, 0, _currentPageDataSize);
-                    _currentPage++;
-                    auto tex = new (std::nothrow) Texture2D;
-                    if (_antialiasEnabled)
-                    {
-                        tex->setAntiAliasTexParameters();
-                    }
-                    else
-                    {
-                        tex->setAliasTexParameters();
-                    }
-                    tex->initWithData(_currentPageData, _currentPageDataSize,
-                        pixelFormat, CacheTextureWidth, CacheTextureHeight, Size(CacheTextureWidth, CacheTextureHeight));
-                    addTexture(tex, _currentPage);
-                    tex->release();
-                }
-            }
+            makeRoomForLetter(tempDef.width);
             glyphHeight = static_cast<int>(bitmapHeight) + _letterPadding + _letterEdgeExtend;
             if (glyphHeight > _currLineHeight)
             {
                 _currLineHeight = glyphHeight;
             }
             _fontFreeType->renderCharAt(_currentPageData, _currentPageOrigX + adjustForExtend, _currentPageOrigY + adjustForExtend, bitmap, bitmapWidth, bitmapHeight);
+            addDirtyRect(_currentPageOrigX + adjustForExtend, _currentPageOrigY + adjustForExtend,
+                         bitmapWidth + distanceMapMargin, bitmapHeight + distanceMapMargin);
 
             tempDef.U = _currentPageOrigX;
             tempDef.V = _currentPageOrigY;
@@ -453,18 +498,357 @@ bool FontAtlas::prepareLetterDefinitions(const std::u32string& utf32Text)
         _letterDefinitions[it.first] = tempDef;
     }
 
-    unsigned char *data = nullptr;
-    if (pixelFormat == Texture2D::PixelFormat::AI88)
+    return true;
+}
+
+void FontAtlas::makeRoomForLetter(float letterWidth)
+{
+    if (_currentPageOrigX + letterWidth > CacheTextureWidth)
     {
-        data = _currentPageData + CacheTextureWidth * (int)startY * 2;
+        _currentPageOrigY += _currLineHeight;
+        _currLineHeight = 0;
+        _currentPageOrigX = 0;
+        if (_currentPageOrigY + _lineHeight + _letterPadding + _letterEdgeExtend >= CacheTextureHeight)
+        {
+            // the page data is reused for the new page
+            uploadDirtyRects();
+
+            _currentPageOrigY = 0;
+            memset(_currentPageData, 0, _currentPageDataSize);
+            _currentPage++;
+            auto  pixelFormat = _fontFreeType->getOutlineSize() > 0 ? Texture2D::PixelFormat::AI88 : Texture2D::PixelFormat::A8;
+            auto tex = new (std::nothrow) Texture2D;
+            if (_antialiasEnabled)
+            {
+                tex->setAntiAliasTexParameters();
+            }
+            else
+            {
+                tex->setAliasTexParameters();
+            }
+            tex->initWithData(_currentPageData, _currentPageDataSize,
+                pixelFormat, CacheTextureWidth, CacheTextureHeight, Size(CacheTextureWidth, CacheTextureHeight));
+            addTexture(tex, _currentPage);
+            tex->release();
+        }
     }
-    else
+}
+
+void FontAtlas::addDirtyRect(int x, int y, int width, int height)
+{
+    // the upload rows stay a multiple of 8 bytes, which is fine whatever GL_UNPACK_ALIGNMENT is
+    int minX = x & ~7;
+    int maxX = std::min((x + width + 7) & ~7, CacheTextureWidth);
+    int minY = y;
+    int maxY = std::min(y + height, CacheTextureHeight);
+    if (minX >= maxX || minY >= maxY)
+        return;
+
+    // the letters of a line share a rectangle
+    if (!_dirtyRects.empty())
     {
-        data = _currentPageData + CacheTextureWidth * (int)startY;
+        auto& last = _dirtyRects.back();
+        if (minY < last.maxY && maxY > last.minY)
+        {
+            last.minX = std::min(last.minX, minX);
+            last.maxX = std::max(last.maxX, maxX);
+            last.minY = std::min(last.minY, minY);
+            last.maxY = std::max(last.maxY, maxY);
+            return;
+        }
     }
-    _atlasTextures[_currentPage]->updateWithData(data, 0, startY, CacheTextureWidth, _currentPageOrigY - startY + _currLineHeight);
 
-    return true;
+    DirtyRect rect;
+    rect.minX = minX;
+    rect.minY = minY;
+    rect.maxX = maxX;
+    rect.maxY = maxY;
+    _dirtyRects.push_back(rect);
+}
+
+void FontAtlas::uploadDirtyRects()
+{
+    if (_dirtyRects.empty() || !_currentPageData)
+        return;
+
+    auto texture = _atlasTextures[_currentPage];
+    int bytesPerPixel = _fontFreeType->getOutlineSize() > 0 ? 2 : 1;
+    int pageRowSize = CacheTextureWidth * bytesPerPixel;
+
+    for (auto& rect : _dirtyRects)
+    {
+        int width = rect.maxX - rect.minX;
+        int height = rect.maxY - rect.minY;
+        auto source = _currentPageData + rect.minY * pageRowSize + rect.minX * bytesPerPixel;
+
+        if (width == CacheTextureWidth)
+        {
+            texture->updateWithData(source, 0, rect.minY, width, height);
+            continue;
+        }
+
+        // glTexSubImage2D() can't skip the rest of the page rows on GLES 2
+        int rowSize = width * bytesPerPixel;
+        _uploadBuffer.resize(rowSize * height);
+        for (int y = 0; y < height; ++y)
+        {
+            memcpy(_uploadBuffer.data() + y * rowSize, source + y * pageRowSize, rowSize);
+        }
+        texture->updateWithData(_uploadBuffer.data(), rect.minX, rect.minY, width, height);
+    }
+    _dirtyRects.clear();
+}
+
+void FontAtlas::rasterizeLettersAsync(const std::unordered_map<unsigned int, unsigned int>& codeMapOfNewChar, bool prewarm)
+{
+    if (!_asyncLetters)
+    {
+        _asyncLetters = std::make_shared<AsyncLetters>();
+        _asyncLetters->atlas = this;
+        _asyncLetters->generation = 0;
+        _asyncLetters->pendingCount = 0;
+        _asyncLetters->scheduled = false;
+    }
+
+    auto asyncLetters = _asyncLetters;
+    auto& tasks = asyncLetters->tasks;
+    tasks.erase(std::remove_if(tasks.begin(), tasks.end(), [](const AsyncTaskPool::TaskHandle& task) {
+        return task->isDone();
+    }), tasks.end());
+
+    auto pool = AsyncTaskPool::getInstance();
+    auto fontFreeType = _fontFreeType;
+    auto generation = asyncLetters->generation;
+    auto priority = prewarm ? AsyncTaskPool::Priority::LOW : AsyncTaskPool::Priority::NORMAL;
+
+    auto submitLetters = [&](std::shared_ptr<std::vector<AsyncLetters::Letter>> letters) {
+        tasks.push_back(pool->submit([fontFreeType, letters]() {
+            for (auto& letter : *letters)
+            {
+                fontFreeType->rasterizeGlyph(letter.code, letter.glyph);
+            }
+        }, [asyncLetters, letters, generation]() {
+            auto atlas = asyncLetters->atlas;
+            if (atlas == nullptr || asyncLetters->generation != generation)
+                return;
+
+            for (auto& letter : *letters)
+            {
+                asyncLetters->rasterizedLetters.push_back(std::move(letter));
+            }
+            if (!asyncLetters->scheduled)
+            {
+                asyncLetters->scheduled = true;
+                Director::getInstance()->getScheduler()->schedule(CC_CALLBACK_1(FontAtlas::addRasterizedLetters, atlas),
+                                                                  atlas, 0, false, ADD_LETTERS_KEY);
+            }
+        }, priority));
+    };
+
+    // blank until the glyph lands, with the right advance so that the text doesn't move
+    FontLetterDefinition placeholder;
+    placeholder.U = 0;
+    placeholder.V = 0;
+    placeholder.width = 0;
+    placeholder.height = 0;
+    placeholder.offsetX = 0;
+    placeholder.offsetY = 0;
+    placeholder.textureID = 0;
+
+    std::shared_ptr<std::vector<AsyncLetters::Letter>> letters;
+    for (auto&& it : codeMapOfNewChar)
+    {
+        placeholder.xAdvance = _fontFreeType->getGlyphAdvance(it.second);
+        placeholder.validDefinition = placeholder.xAdvance != 0;
+        _letterDefinitions[it.first] = placeholder;
+
+        if (!letters)
+        {
+            letters = std::make_shared<std::vector<AsyncLetters::Letter>>();
+            letters->reserve(LETTERS_PER_TASK);
+        }
+        AsyncLetters::Letter letter;
+        letter.utf32Char = it.first;
+        letter.code = it.second;
+        letters->push_back(std::move(letter));
+        if (letters->size() == LETTERS_PER_TASK)
+        {
+            submitLetters(letters);
+            letters.reset();
+        }
+    }
+    if (letters)
+    {
+        submitLetters(letters);
+    }
+    asyncLetters->pendingCount += codeMapOfNewChar.size();
+}
+
+void FontAtlas::addRasterizedLetters(float /*dt*/)
+{
+    auto startTime = std::chrono::steady_clock::now();
+    auto& letters = _asyncLetters->rasterizedLetters;
+
+    int adjustForDistanceMap = _letterPadding / 2;
+    int adjustForExtend = _letterEdgeExtend / 2;
+    int glyphHeight;
+    auto scaleFactor = CC_CONTENT_SCALE_FACTOR();
+    // same layout as FontFreeType::renderCharAt()
+    int bytesPerPixel = !_fontFreeType->isDistanceFieldEnabled() && _fontFreeType->getOutlineSize() > 0 ? 2 : 1;
+
+    bool added = false;
+
+    while (!letters.empty())
+    {
+        auto& letter = letters.front();
+        auto& glyph = letter.glyph;
+        FontLetterDefinition tempDef;
+        tempDef.xAdvance = glyph.xAdvance;
+
+        if (!glyph.pixels.empty())
+        {
+            tempDef.validDefinition = true;
+            tempDef.width = glyph.rect.size.width + _letterPadding + _letterEdgeExtend;
+            tempDef.height = glyph.rect.size.height + _letterPadding + _letterEdgeExtend;
+            tempDef.offsetX = glyph.rect.origin.x - adjustForDistanceMap - adjustForExtend;
+            tempDef.offsetY = _fontAscender + glyph.rect.origin.y - adjustForDistanceMap - adjustForExtend;
+
+            makeRoomForLetter(tempDef.width);
+            glyphHeight = static_cast<int>(glyph.bitmapHeight) + _letterPadding + _letterEdgeExtend;
+            if (glyphHeight > _currLineHeight)
+            {
+                _currLineHeight = glyphHeight;
+            }
+
+            int posX = static_cast<int>(_currentPageOrigX) + adjustForExtend;
+            int posY = static_cast<int>(_currentPageOrigY) + adjustForExtend;
+            size_t rowSize = glyph.pixelsWidth * bytesPerPixel;
+            for (long y = 0; y < glyph.pixelsHeight; ++y)
+            {
+                memcpy(_currentPageData + (posX + (posY + y) * CacheTextureWidth) * bytesPerPixel,
+                       glyph.pixels.data() + y * rowSize, rowSize);
+            }
+            addDirtyRect(posX, posY, glyph.pixelsWidth, glyph.pixelsHeight);
+
+            tempDef.U = _currentPageOrigX;
+            tempDef.V = _currentPageOrigY;
+            tempDef.textureID = _currentPage;
+            _currentPageOrigX += tempDef.width + 1;
+            // take from pixels to points
+            tempDef.width = tempDef.width / scaleFactor;
+            tempDef.height = tempDef.height / scaleFactor;
+            tempDef.U = tempDef.U / scaleFactor;
+            tempDef.V = tempDef.V / scaleFactor;
+        }
+        else
+        {
+            tempDef.validDefinition = glyph.valid && tempDef.xAdvance != 0;
+            tempDef.width = 0;
+            tempDef.height = 0;
+            tempDef.U = 0;
+            tempDef.V = 0;
+            tempDef.offsetX = 0;
+            tempDef.offsetY = 0;
+            tempDef.textureID = 0;
+            _currentPageOrigX += 1;
+        }
+
+        _letterDefinitions[letter.utf32Char] = tempDef;
+        letters.pop_front();
+        _asyncLetters->pendingCount--;
+        added = true;
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime);
+        if (s_uploadBudget > 0 && elapsed.count() > s_uploadBudget * 1000000)
+            break;
+    }
+
+    if (letters.empty())
+    {
+        Director::getInstance()->getScheduler()->unschedule(ADD_LETTERS_KEY, this);
+        _asyncLetters->scheduled = false;
+    }
+
+    // keep the atlas alive while the labels and the callbacks look at it
+    retain();
+    if (added)
+    {
+        Director::getInstance()->getEventDispatcher()->dispatchCustomEvent(CMD_LETTERS_ADDED, this);
+    }
+    if (_asyncLetters->pendingCount == 0)
+    {
+        notifyPrewarmCallbacks();
+    }
+    release();
+}
+
+void FontAtlas::notifyPrewarmCallbacks()
+{
+    std::vector<std::function<void()>> callbacks;
+    callbacks.swap(_asyncLetters->prewarmCallbacks);
+    for (auto& callback : callbacks)
+    {
+        callback();
+    }
+}
+
+void FontAtlas::prewarmCharset(const std::u32string& utf32Text, const std::function<void()>& callback)
+{
+    if (_fontFreeType == nullptr)
+    {
+        if (callback)
+        {
+            callback();
+        }
+        return;
+    }
+
+    if (!_currentPageData)
+        reinit();
+
+    std::unordered_map<unsigned int, unsigned int> codeMapOfNewChar;
+    findNewCharacters(utf32Text, codeMapOfNewChar);
+    if (!codeMapOfNewChar.empty())
+    {
+        if (_asyncRasterizationEnabled)
+        {
+            rasterizeLettersAsync(codeMapOfNewChar, true);
+        }
+        else
+        {
+            prepareLetterDefinitions(utf32Text);
+        }
+    }
+
+    if (callback)
+    {
+        if (hasPendingLetters())
+        {
+            _asyncLetters->prewarmCallbacks.push_back(callback);
+        }
+        else
+        {
+            callback();
+        }
+    }
+}
+
+void FontAtlas::prewarmCharset(const std::string& utf8Text, const std::function<void()>& callback)
+{
+    std::u32string utf32Text;
+    if (StringUtils::UTF8ToUTF32(utf8Text, utf32Text))
+    {
+        prewarmCharset(utf32Text, callback);
+    }
+    else if (callback)
+    {
+        callback();
+    }
+}
+
+bool FontAtlas::hasPendingLetters() const
+{
+    return _asyncLetters && _asyncLetters->pendingCount > 0;
 }
 
 void FontAtlas::addTexture(Texture2D *texture, int slot)
@@ -31,6 +31,9 @@
 
 #include <string>
 #include <unordered_map>
+#include <functional>
+#include <memory>
+#include <vector>
 
 #include "platform/CCPlatformMacros.h"
 #include "base/CCRef.h"
@@ -64,6 +67,8 @@ public:
     static const int CacheTextureHeight;
     static const char* CMD_PURGE_FONTATLAS;
     static const char* CMD_RESET_FONTATLAS;
+    /** dispatched with the atlas as user data when letters rasterized in the background were added */
+    static const char* CMD_LETTERS_ADDED;
     /**
      * @js ctor
      */
@@ -79,6 +84,48 @@ public:
     
     bool prepareLetterDefinitions(const std::u32string& utf16String);
 
+    /**
+     * Rasterizes the missing letters on the AsyncTaskPool workers instead of the cocos thread.
+     *
+     * A letter waiting for its glyph is blank but already has its advance, so the text doesn't move
+     * when the glyph lands. The glyphs are added to the pages every frame within the upload budget,
+     * then CMD_LETTERS_ADDED is dispatched so that the labels using the atlas update.
+     * Only effective for TTF fonts.
+     */
+    void setAsyncRasterizationEnabled(bool enabled) { _asyncRasterizationEnabled = enabled; }
+    bool isAsyncRasterizationEnabled() const { return _asyncRasterizationEnabled; }
+
+    /** Whether the atlases created from now on rasterize their letters in the background, false by default. */
+    static void setDefaultAsyncRasterizationEnabled(bool enabled) { s_defaultAsyncRasterizationEnabled = enabled; }
+    static bool isDefaultAsyncRasterizationEnabled() { return s_defaultAsyncRasterizationEnabled; }
+
+    /**
+     * Sets the time spent at most per frame adding the background rasterized glyphs to the pages,
+     * at least one glyph is added every frame. 2ms by default.
+     */
+    static void setUploadBudget(float seconds) { s_uploadBudget = seconds; }
+    static float getUploadBudget() { return s_uploadBudget; }
+
+    /**
+     * Adds the letters of a charset to the atlas ahead of time, e.g. during a loading scene.
+     * The letters are rasterized in the background if async rasterization is enabled.
+     *
+     * @param callback Called on the cocos thread once no letter of the atlas is waiting for its glyph anymore,
+     * right away if there was nothing to rasterize in the background.
+     */
+    void prewarmCharset(const std::u32string& utf32Text, const std::function<void()>& callback = nullptr);
+    void prewarmCharset(const std::string& utf8Text, const std::function<void()>& callback = nullptr);
+
+    /** Whether some letters are waiting for their glyph. */
+    bool hasPendingLetters() const;
+
+    /**
+     * Uploads the letters added to the current page since the last call, at once.
+     * The labels call it before they are drawn, so that every render sees their letters,
+     * e.g. into a RenderTexture or by utils::captureNode(). Does nothing if no letter was added.
+     */
+    void uploadDirtyRects();
+
     const std::unordered_map<ssize_t, Texture2D*>& getTextures() const { return _atlasTextures; }
     void  addTexture(Texture2D *texture, int slot);
     float getLineHeight() const { return _lineHeight; }
@@ -122,6 +169,15 @@ protected:
 
     void conversionU32TOGB2312(const std::u32string& u32Text, std::unordered_map<unsigned int, unsigned int>& charCodeMap);
 
+    // moves the pen to the next line, or to a new page, when a letter of the given width doesn't fit on the line
+    void makeRoomForLetter(float letterWidth);
+    // marks pixels of the current page as written, they are uploaded by uploadDirtyRects()
+    void addDirtyRect(int x, int y, int width, int height);
+
+    void rasterizeLettersAsync(const std::unordered_map<unsigned int, unsigned int>& codeMapOfNewChar, bool prewarm);
+    void addRasterizedLetters(float dt);
+    void notifyPrewarmCallbacks();
+
     /**
      * Scale each font letter by scaleFactor.
      *
@@ -150,6 +206,24 @@ protected:
     bool _antialiasEnabled;
     int _currLineHeight;
 
+    // areas of the current page not uploaded yet, in pixels
+    struct DirtyRect
+    {
+        int minX;
+        int minY;
+        int maxX;
+        int maxY;
+    };
+    std::vector<DirtyRect> _dirtyRects;
+    std::vector<unsigned char> _uploadBuffer;
+
+    // state shared with the background rasterization tasks
+    struct AsyncLetters;
+    std::shared_ptr<AsyncLetters> _asyncLetters;
+    bool _asyncRasterizationEnabled;
+    static bool s_defaultAsyncRasterizationEnabled;
+    static float s_uploadBudget;
+
     friend class Label;
 };
 
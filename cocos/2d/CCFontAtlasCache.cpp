@@ -36,6 +36,8 @@
 NS_CC_BEGIN
 
 std::unordered_map<std::string, FontAtlas *> FontAtlasCache::_atlasMap;
+bool FontAtlasCache::_sharedDistanceFieldEnabled = false;
+float FontAtlasCache::_sharedDistanceFieldFontSize = 48;
 #define ATLAS_MAP_KEY_PREFIX_BUFFER_SIZE 255
 
 void FontAtlasCache::purgeCachedData()
@@ -60,9 +62,13 @@ FontAtlas* FontAtlasCache::getFontAtlasTTF(const _ttfConfig* config)
         useDistanceField = false;
     }
 
+    // all the sizes share the atlas, Label scales the letters
+    bool sharedAtlas = useDistanceField && _sharedDistanceFieldEnabled;
+    float fontSize = sharedAtlas ? _sharedDistanceFieldFontSize : config->fontSize;
+
     std::string key;
     char keyPrefix[ATLAS_MAP_KEY_PREFIX_BUFFER_SIZE];
-    snprintf(keyPrefix, ATLAS_MAP_KEY_PREFIX_BUFFER_SIZE, useDistanceField ? "df %.2f %d " : "%.2f %d ", config->fontSize, config->outlineSize);
+    snprintf(keyPrefix, ATLAS_MAP_KEY_PREFIX_BUFFER_SIZE, useDistanceField ? "df %.2f %d " : "%.2f %d ", fontSize, config->outlineSize);
     std::string atlasName(keyPrefix);
     atlasName += realFontFilename;
 
@@ -70,11 +76,12 @@ FontAtlas* FontAtlasCache::getFontAtlasTTF(const _ttfConfig* config)
 
     if ( it == _atlasMap.end() )
     {
-        auto font = FontFreeType::create(realFontFilename, config->fontSize, config->glyphs,
+        auto font = FontFreeType::create(realFontFilename, fontSize, config->glyphs,
             config->customGlyphs, useDistanceField, config->outlineSize);
         if (font)
         {
-            auto tempAtlas = font->createFontAtlas();
+            // the distance maps of the big glyphs are slow to compute, even the preloaded glyphs are made in the background
+            auto tempAtlas = font->createFontAtlas(sharedAtlas || FontAtlas::isDefaultAsyncRasterizationEnabled());
             if (tempAtlas)
             {
                 _atlasMap[atlasName] = tempAtlas;
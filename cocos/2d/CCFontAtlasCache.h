@@ -67,8 +67,22 @@ public:
     */
     static void unloadFontAtlasTTF(const std::string& fontFileName);
 
+    /** Serves every size of a font with distance field enabled from a single atlas.
+     The glyphs are rasterized once at the shared size, in the background, and the labels scale them.
+     Glow uses the same atlas, outlines still need an atlas per size.
+     Only affects the atlases created afterwards, disabled by default.
+     */
+    static void setSharedDistanceFieldEnabled(bool enabled) { _sharedDistanceFieldEnabled = enabled; }
+    static bool isSharedDistanceFieldEnabled() { return _sharedDistanceFieldEnabled; }
+
+    /** Sets the size, in points, the glyphs of the shared distance field atlases are rasterized at. 48 by default. */
+    static void setSharedDistanceFieldFontSize(float fontSize) { _sharedDistanceFieldFontSize = fontSize; }
+    static float getSharedDistanceFieldFontSize() { return _sharedDistanceFieldFontSize; }
+
 private:
     static std::unordered_map<std::string, FontAtlas *> _atlasMap;
+    static bool _sharedDistanceFieldEnabled;
+    static float _sharedDistanceFieldFontSize;
 };
 
 NS_CC_END
@@ -44,7 +44,7 @@ const char* FontFreeType::_glyphNEHE = "!\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFG
 
 typedef struct _DataRef
 {
-    Data data;
+    std::shared_ptr<Data> data;
     unsigned int referenceCount;
 }DataRef;
 
@@ -102,6 +102,8 @@ FontFreeType::FontFreeType(bool distanceFieldEnabled /* = false */, float outlin
 : _fontRef(nullptr)
 , _stroker(nullptr)
 , _encoding(FT_ENCODING_UNICODE)
+, _fontSizePoints(0)
+, _fontSize(0.0f)
 , _distanceFieldEnabled(distanceFieldEnabled)
 , _outlineSize(0.0f)
 , _lineHeight(0)
@@ -134,15 +136,16 @@ bool FontFreeType::createFontObject(const std::string &fontName, float fontSize)
     else
     {
         s_cacheFontData[fontName].referenceCount = 1;
-        s_cacheFontData[fontName].data = FileUtils::getInstance()->getDataFromFile(fontName);    
+        s_cacheFontData[fontName].data = std::make_shared<Data>(FileUtils::getInstance()->getDataFromFile(fontName));
 
-        if (s_cacheFontData[fontName].data.isNull())
+        if (s_cacheFontData[fontName].data->isNull())
         {
             return false;
         }
     }
+    _fontData = s_cacheFontData[fontName].data;
 
-    if (FT_New_Memory_Face(getFTLibrary(), s_cacheFontData[fontName].data.getBytes(), s_cacheFontData[fontName].data.getSize(), 0, &face ))
+    if (FT_New_Memory_Face(getFTLibrary(), _fontData->getBytes(), _fontData->getSize(), 0, &face ))
         return false;
 
     if (FT_Select_Charmap(face, FT_ENCODING_UNICODE))
@@ -174,6 +177,8 @@ bool FontFreeType::createFontObject(const std::string &fontName, float fontSize)
     int fontSizePoints = (int)(64.f * fontSize * CC_CONTENT_SCALE_FACTOR());
     if (FT_Set_Char_Size(face, fontSizePoints, fontSizePoints, dpi, dpi))
         return false;
+    _fontSizePoints = fontSizePoints;
+    _fontSize = fontSize;
     
     // store the face globally
     _fontRef = face;
@@ -185,6 +190,18 @@ bool FontFreeType::createFontObject(const std::string &fontName, float fontSize)
 
 FontFreeType::~FontFreeType()
 {
+    // the callers of rasterizeGlyph() are done with the font at this point
+    for (auto workerFace : _workerFaces)
+    {
+        if (workerFace->stroker)
+        {
+            FT_Stroker_Done(workerFace->stroker);
+        }
+        FT_Done_Face(workerFace->face);
+        FT_Done_FreeType(workerFace->library);
+        delete workerFace;
+    }
+
     if (_FTInitialized)
     {
         if (_stroker)
@@ -209,10 +226,19 @@ FontFreeType::~FontFreeType()
 }
 
 FontAtlas * FontFreeType::createFontAtlas()
+{
+    return createFontAtlas(FontAtlas::isDefaultAsyncRasterizationEnabled());
+}
+
+FontAtlas * FontFreeType::createFontAtlas(bool asyncRasterization)
 {
     if (_fontAtlas == nullptr)
     {
         _fontAtlas = new (std::nothrow) FontAtlas(*this);
+        if (_fontAtlas)
+        {
+            _fontAtlas->setAsyncRasterizationEnabled(asyncRasterization);
+        }
         if (_fontAtlas && _usedGlyphs != GlyphCollection::DYNAMIC)
         {
             std::u32string utf32;
@@ -247,7 +273,14 @@ int * FontFreeType::getHorizontalKerningForTextUTF32(const std::u32string& text,
     {
         for (int c = 1; c < outNumLetters; ++c)
         {
-            sizes[c] = getHorizontalKerningForChars(text[c-1], text[c]);
+            // labels ask for the same pairs every time their text changes
+            uint64_t pair = (static_cast<uint64_t>(text[c-1]) << 32) | text[c];
+            auto iter = _kerningCache.find(pair);
+            if (iter == _kerningCache.end())
+            {
+                iter = _kerningCache.emplace(pair, getHorizontalKerningForChars(text[c-1], text[c])).first;
+            }
+            sizes[c] = iter->second;
         }
     }
     
@@ -289,38 +322,53 @@ const char* FontFreeType::getFontFamily() const
     return _fontRef->family_name;
 }
 
+FT_Int32 FontFreeType::getGlyphLoadFlags() const
+{
+    if (_distanceFieldEnabled)
+    {
+        return FT_LOAD_NO_HINTING | FT_LOAD_NO_AUTOHINT;
+    }
+    return FT_LOAD_NO_AUTOHINT;
+}
+
 unsigned char* FontFreeType::getGlyphBitmap(uint64_t theChar, long &outWidth, long &outHeight, Rect &outRect,int &xAdvance)
+{
+    return renderGlyph(_FTlibrary, _fontRef, _stroker, theChar, outWidth, outHeight, outRect, xAdvance);
+}
+
+int FontFreeType::getGlyphAdvance(uint64_t theChar)
+{
+    if (_fontRef == nullptr || FT_Load_Char(_fontRef, theChar, getGlyphLoadFlags()))
+        return 0;
+
+    return static_cast<int>(_fontRef->glyph->metrics.horiAdvance >> 6);
+}
+
+unsigned char* FontFreeType::renderGlyph(FT_Library library, FT_Face face, FT_Stroker stroker, uint64_t theChar,
+                                         long &outWidth, long &outHeight, Rect &outRect, int &xAdvance)
 {
     bool invalidChar = true;
     unsigned char* ret = nullptr;
 
     do
     {
-        if (_fontRef == nullptr)
+        if (face == nullptr)
             break;
 
-        if (_distanceFieldEnabled)
-        {
-            if (FT_Load_Char(_fontRef, theChar, FT_LOAD_RENDER | FT_LOAD_NO_HINTING | FT_LOAD_NO_AUTOHINT))
-                break;
-        }
-        else
-        {
-            if (FT_Load_Char(_fontRef, theChar, FT_LOAD_RENDER | FT_LOAD_NO_AUTOHINT))
-                break;
-        }
+        if (FT_Load_Char(face, theChar, FT_LOAD_RENDER | getGlyphLoadFlags()))
+            break;
 
-        auto& metrics = _fontRef->glyph->metrics;
+        auto& metrics = face->glyph->metrics;
         outRect.origin.x = metrics.horiBearingX >> 6;
         outRect.origin.y = -(metrics.horiBearingY >> 6);
         outRect.size.width = (metrics.width >> 6);
         outRect.size.height = (metrics.height >> 6);
 
-        xAdvance = (static_cast<int>(_fontRef->glyph->metrics.horiAdvance >> 6));
+        xAdvance = (static_cast<int>(face->glyph->metrics.horiAdvance >> 6));
 
-        outWidth  = _fontRef->glyph->bitmap.width;
-        outHeight = _fontRef->glyph->bitmap.rows;
-        ret = _fontRef->glyph->bitmap.buffer;
+        outWidth  = face->glyph->bitmap.width;
+        outHeight = face->glyph->bitmap.rows;
+        ret = face->glyph->bitmap.buffer;
 
         if (_outlineSize > 0 && outWidth > 0 && outHeight > 0)
         {
@@ -328,7 +376,7 @@ unsigned char* FontFreeType::getGlyphBitmap(uint64_t theChar, long &outWidth, lo
             memcpy(copyBitmap,ret,outWidth * outHeight * sizeof(unsigned char));
 
             FT_BBox bbox;
-            auto outlineBitmap = getGlyphBitmapWithOutline(theChar,bbox);
+            auto outlineBitmap = getGlyphBitmapWithOutline(library, face, stroker, theChar, bbox);
             if(outlineBitmap == nullptr)
             {
                 ret = nullptr;
@@ -415,17 +463,17 @@ unsigned char* FontFreeType::getGlyphBitmap(uint64_t theChar, long &outWidth, lo
     }
 }
 
-unsigned char * FontFreeType::getGlyphBitmapWithOutline(uint64_t theChar, FT_BBox &bbox)
+unsigned char * FontFreeType::getGlyphBitmapWithOutline(FT_Library library, FT_Face face, FT_Stroker stroker, uint64_t theChar, FT_BBox &bbox)
 {   
     unsigned char* ret = nullptr;
-    if (FT_Load_Char(_fontRef, theChar, FT_LOAD_NO_BITMAP) == 0)
+    if (FT_Load_Char(face, theChar, FT_LOAD_NO_BITMAP) == 0)
     {
-        if (_fontRef->glyph->format == FT_GLYPH_FORMAT_OUTLINE)
+        if (face->glyph->format == FT_GLYPH_FORMAT_OUTLINE)
         {
             FT_Glyph glyph;
-            if (FT_Get_Glyph(_fontRef->glyph, &glyph) == 0)
+            if (FT_Get_Glyph(face->glyph, &glyph) == 0)
             {
-                FT_Glyph_StrokeBorder(&glyph, _stroker, 0, 1);
+                FT_Glyph_StrokeBorder(&glyph, stroker, 0, 1);
                 if (glyph->format == FT_GLYPH_FORMAT_OUTLINE)
                 {
                     FT_Outline *outline = &reinterpret_cast<FT_OutlineGlyph>(glyph)->outline;
@@ -448,7 +496,7 @@ unsigned char * FontFreeType::getGlyphBitmapWithOutline(uint64_t theChar, FT_BBo
                     params.target = &bmp;
                     params.flags = FT_RASTER_FLAG_AA;
                     FT_Outline_Translate(outline,-bbox.xMin,-bbox.yMin);
-                    FT_Outline_Render(_FTlibrary, outline, &params);
+                    FT_Outline_Render(library, outline, &params);
 
                     ret = bmp.buffer;
                 }
@@ -621,6 +669,132 @@ void FontFreeType::renderCharAt(unsigned char *dest,int posX, int posY, unsigned
     } 
 }
 
+void FontFreeType::rasterizeGlyph(uint64_t theChar, GlyphBitmap &outGlyph)
+{
+    outGlyph.valid = false;
+    outGlyph.pixels.clear();
+    outGlyph.pixelsWidth = 0;
+    outGlyph.pixelsHeight = 0;
+
+    auto workerFace = acquireWorkerFace();
+    if (workerFace == nullptr)
+    {
+        outGlyph.rect = Rect::ZERO;
+        outGlyph.xAdvance = 0;
+        outGlyph.bitmapWidth = 0;
+        outGlyph.bitmapHeight = 0;
+        return;
+    }
+
+    long width = 0;
+    long height = 0;
+    auto bitmap = renderGlyph(workerFace->library, workerFace->face, workerFace->stroker, theChar,
+                              width, height, outGlyph.rect, outGlyph.xAdvance);
+    outGlyph.valid = bitmap != nullptr || outGlyph.xAdvance != 0;
+    outGlyph.bitmapWidth = width;
+    outGlyph.bitmapHeight = height;
+
+    if (bitmap && width > 0 && height > 0)
+    {
+        // same pixels as renderCharAt(), minus the copy into the page
+        if (_distanceFieldEnabled)
+        {
+            auto distanceMap = makeDistanceMap(bitmap, width, height);
+            outGlyph.pixelsWidth = width + 2 * DistanceMapSpread;
+            outGlyph.pixelsHeight = height + 2 * DistanceMapSpread;
+            outGlyph.pixels.assign(distanceMap, distanceMap + outGlyph.pixelsWidth * outGlyph.pixelsHeight);
+            free(distanceMap);
+        }
+        else
+        {
+            auto bytesPerPixel = _outlineSize > 0 ? 2 : 1;
+            outGlyph.pixelsWidth = width;
+            outGlyph.pixelsHeight = height;
+            outGlyph.pixels.assign(bitmap, bitmap + width * height * bytesPerPixel);
+        }
+    }
+
+    // outlined glyphs are blended in a new buffer, the other ones belong to the face
+    if (bitmap && _outlineSize > 0)
+    {
+        delete [] bitmap;
+    }
+
+    releaseWorkerFace(workerFace);
+}
+
+FontFreeType::WorkerFace* FontFreeType::acquireWorkerFace()
+{
+    {
+        std::lock_guard<std::mutex> lock(_workerFacesMutex);
+        if (!_idleWorkerFaces.empty())
+        {
+            auto workerFace = _idleWorkerFaces.back();
+            _idleWorkerFaces.pop_back();
+            return workerFace;
+        }
+    }
+
+    if (_fontRef == nullptr || !_fontData)
+        return nullptr;
+
+    auto workerFace = new (std::nothrow) WorkerFace();
+    if (workerFace == nullptr)
+        return nullptr;
+
+    workerFace->library = nullptr;
+    workerFace->face = nullptr;
+    workerFace->stroker = nullptr;
+    do
+    {
+        if (FT_Init_FreeType(&workerFace->library))
+        {
+            workerFace->library = nullptr;
+            break;
+        }
+        if (FT_New_Memory_Face(workerFace->library, _fontData->getBytes(), _fontData->getSize(), 0, &workerFace->face))
+        {
+            workerFace->face = nullptr;
+            break;
+        }
+        if (FT_Select_Charmap(workerFace->face, _encoding))
+            break;
+        if (FT_Set_Char_Size(workerFace->face, _fontSizePoints, _fontSizePoints, 72, 72))
+            break;
+
+        if (_outlineSize > 0)
+        {
+            FT_Stroker_New(workerFace->library, &workerFace->stroker);
+            FT_Stroker_Set(workerFace->stroker,
+                (int)(_outlineSize * 64),
+                FT_STROKER_LINECAP_ROUND,
+                FT_STROKER_LINEJOIN_ROUND,
+                0);
+        }
+
+        std::lock_guard<std::mutex> lock(_workerFacesMutex);
+        _workerFaces.push_back(workerFace);
+        return workerFace;
+    } while (0);
+
+    if (workerFace->face)
+    {
+        FT_Done_Face(workerFace->face);
+    }
+    if (workerFace->library)
+    {
+        FT_Done_FreeType(workerFace->library);
+    }
+    delete workerFace;
+    return nullptr;
+}
+
+void FontFreeType::releaseWorkerFace(WorkerFace* workerFace)
+{
+    std::lock_guard<std::mutex> lock(_workerFacesMutex);
+    _idleWorkerFaces.push_back(workerFace);
+}
+
 void FontFreeType::setGlyphCollection(GlyphCollection glyphs, const char* customGlyphs /* = nullptr */)
 {
     _usedGlyphs = glyphs;
@@ -30,8 +30,13 @@
 /// @cond DO_NOT_SHOW
 
 #include "2d/CCFont.h"
+#include "base/CCData.h"
 
 #include <string>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <unordered_map>
 #include "ft2build.h"
 
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_WINRT)
@@ -54,6 +59,23 @@ class CC_DLL FontFreeType : public Font
 public:
     static const int DistanceMapSpread;
 
+    /** A glyph rasterized by rasterizeGlyph(). */
+    struct GlyphBitmap
+    {
+        /** false if the glyph couldn't be loaded */
+        bool valid;
+        /** same as the outRect of getGlyphBitmap() */
+        Rect rect;
+        int xAdvance;
+        /** size of the bitmap returned by getGlyphBitmap() */
+        long bitmapWidth;
+        long bitmapHeight;
+        /** pixels as renderCharAt() writes them in an atlas page: the distance map if distance field is enabled, two channels if outlined */
+        std::vector<unsigned char> pixels;
+        long pixelsWidth;
+        long pixelsHeight;
+    };
+
     static FontFreeType* create(const std::string &fontName, float fontSize, GlyphCollection glyphs,
         const char *customGlyphs,bool distanceFieldEnabled = false, float outline = 0);
 
@@ -63,6 +85,9 @@ public:
 
     float getOutlineSize() const { return _outlineSize; }
 
+    /** The size the glyphs are rasterized at, in points. */
+    float getFontSize() const { return _fontSize; }
+
     void renderCharAt(unsigned char *dest,int posX, int posY, unsigned char* bitmap,long bitmapWidth,long bitmapHeight); 
 
     FT_Encoding getEncoding() const { return _encoding; }
@@ -70,17 +95,37 @@ public:
     int* getHorizontalKerningForTextUTF32(const std::u32string& text, int &outNumLetters) const override;
     
     unsigned char* getGlyphBitmap(uint64_t theChar, long &outWidth, long &outHeight, Rect &outRect,int &xAdvance);
+
+    /**
+     * Rasterizes a glyph, can be called from any thread.
+     * The glyph is rendered with a face owned by the calling thread for the duration of the call,
+     * the faces are created on demand and kept until the font is destroyed.
+     */
+    void rasterizeGlyph(uint64_t theChar, GlyphBitmap &outGlyph);
+
+    /** Gets the advance of a glyph without rendering it. */
+    int getGlyphAdvance(uint64_t theChar);
     
     int getFontAscender() const;
     const char* getFontFamily() const;
     std::string getFontName() const { return _fontName; }
 
     virtual FontAtlas* createFontAtlas() override;
+    /** Creates the atlas with the given rasterization mode, the preloaded glyphs included. */
+    FontAtlas* createFontAtlas(bool asyncRasterization);
     virtual int getFontMaxHeight() const override { return _lineHeight; }
 
     static void releaseFont(const std::string &fontName);
 
 private:
+    // a face used off the cocos thread, with its own library since a library can't be shared between threads
+    struct WorkerFace
+    {
+        FT_Library library;
+        FT_Face face;
+        FT_Stroker stroker;
+    };
+
     static const char* _glyphASCII;
     static const char* _glyphNEHE;
     static FT_Library _FTlibrary;
@@ -95,7 +140,13 @@ private:
     FT_Library getFTLibrary();
     
     int getHorizontalKerningForChars(uint64_t firstChar, uint64_t secondChar) const;
-    unsigned char* getGlyphBitmapWithOutline(uint64_t code, FT_BBox &bbox);
+    unsigned char* renderGlyph(FT_Library library, FT_Face face, FT_Stroker stroker, uint64_t theChar,
+                               long &outWidth, long &outHeight, Rect &outRect, int &xAdvance);
+    unsigned char* getGlyphBitmapWithOutline(FT_Library library, FT_Face face, FT_Stroker stroker, uint64_t code, FT_BBox &bbox);
+    FT_Int32 getGlyphLoadFlags() const;
+
+    WorkerFace* acquireWorkerFace();
+    void releaseWorkerFace(WorkerFace* workerFace);
 
     void setGlyphCollection(GlyphCollection glyphs, const char* customGlyphs = nullptr);
     const char* getGlyphCollection() const;
@@ -103,6 +154,17 @@ private:
     FT_Face _fontRef;
     FT_Stroker _stroker;
     FT_Encoding _encoding;
+    FT_F26Dot6 _fontSizePoints;
+    float _fontSize;
+    // keeps the font file alive for the faces, even if releaseFont() drops it from the cache
+    std::shared_ptr<Data> _fontData;
+
+    // kerning of the pairs already looked up, keyed by (first << 32) | second
+    mutable std::unordered_map<uint64_t, int> _kerningCache;
+
+    std::mutex _workerFacesMutex;
+    std::vector<WorkerFace*> _workerFaces;
+    std::vector<WorkerFace*> _idleWorkerFaces;
 
     std::string _fontName;
     bool _distanceFieldEnabled;
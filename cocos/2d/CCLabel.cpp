@@ -39,6 +39,8 @@
 #include "platform/CCFileUtils.h"
 #include "renderer/CCRenderer.h"
 #include "renderer/ccGLStateCache.h"
+#include "renderer/CCGLProgramCache.h"
+#include "renderer/CCGLProgramStateCache.h"
 #include "base/CCDirector.h"
 #include "base/CCEventListenerCustom.h"
 #include "base/CCEventDispatcher.h"
@@ -47,6 +49,48 @@
 
 NS_CC_BEGIN
 
+// width of the edge of distance field letters drawn at the atlas size
+static const float DISTANCE_FIELD_SMOOTHING = 0.04f;
+
+// the smoothing of batched distance field labels is rounded so that labels of close sizes share a program state
+static const float DISTANCE_FIELD_SMOOTHING_STEP = 0.005f;
+
+static float getDistanceFieldSmoothing(float bmfontScale)
+{
+    return clampf(DISTANCE_FIELD_SMOOTHING / bmfontScale, 0.01f, 0.25f);
+}
+
+// labels drawn with the same program state, atlas texture and blending are batched by the renderer,
+// so their text color is in the vertices and the uniforms are the same for all of them.
+// The labels retain the state they use, the unused ones may be removed from the cache.
+static GLProgramState* getBatchedGLProgramState(bool distanceField, float smoothing)
+{
+    int step = distanceField ? static_cast<int>(smoothing / DISTANCE_FIELD_SMOOTHING_STEP + 0.5f) : 0;
+    auto key = StringUtils::format("LabelBatched %d", step);
+    auto glProgramStateCache = GLProgramStateCache::getInstance();
+    auto glProgramState = glProgramStateCache->getGLProgramState(key);
+    if (glProgramState)
+        return glProgramState;
+
+    auto glProgram = GLProgramCache::getInstance()->getGLProgram(distanceField ?
+        GLProgram::SHADER_NAME_LABEL_DISTANCEFIELD_NORMAL_NO_MVP : GLProgram::SHADER_NAME_LABEL_NORMAL_NO_MVP);
+    glProgramState = GLProgramState::create(glProgram);
+    glProgramState->setUniformVec4("u_textColor", Vec4::ONE);
+    if (distanceField)
+    {
+        glProgramState->setUniformFloat("u_smoothing", step * DISTANCE_FIELD_SMOOTHING_STEP);
+    }
+    // the cache is purged with the director
+    glProgramStateCache->addGLProgramState(glProgramState, key);
+    return glProgramState;
+}
+
+static Color4B multiplyColor(const Color4B& color, const Color4F& factor)
+{
+    return Color4B(static_cast<GLubyte>(color.r * factor.r), static_cast<GLubyte>(color.g * factor.g),
+                   static_cast<GLubyte>(color.b * factor.b), static_cast<GLubyte>(color.a * factor.a));
+}
+
 /**
  * LabelLetter used to update the quad in texture atlas without SpriteBatchNode.
  */
@@ -384,6 +428,7 @@ Label::Label(TextHAlignment hAlignment /* = TextHAlignment::LEFT */,
              TextVAlignment vAlignment /* = TextVAlignment::TOP */)
 : _textSprite(nullptr)
 , _shadowNode(nullptr)
+, _batchedGLProgramState(nullptr)
 , _fontAtlas(nullptr)
 , _reusedLetter(nullptr)
 , _horizontalKernings(nullptr)
@@ -410,6 +455,7 @@ Label::Label(TextHAlignment hAlignment /* = TextHAlignment::LEFT */,
                 it.second->setTexture(nullptr);
             }
             _batchNodes.clear();
+            _lineStarts.clear();
 
             if (_fontAtlas)
             {
@@ -436,6 +482,16 @@ Label::Label(TextHAlignment hAlignment /* = TextHAlignment::LEFT */,
         }
     });
     _eventDispatcher->addEventListenerWithFixedPriority(_resetTextureListener, 2);
+
+    _lettersAddedListener = EventListenerCustom::create(FontAtlas::CMD_LETTERS_ADDED, [this](EventCustom* event){
+        if (_fontAtlas && _currentLabelType == LabelType::TTF && event->getUserData() == _fontAtlas)
+        {
+            // the glyphs rasterized in the background replace the blank letters
+            _lineStarts.clear();
+            _contentDirty = true;
+        }
+    });
+    _eventDispatcher->addEventListenerWithFixedPriority(_lettersAddedListener, 3);
 }
 
 Label::~Label()
@@ -451,9 +507,11 @@ Label::~Label()
     }
     _eventDispatcher->removeEventListener(_purgeTextureListener);
     _eventDispatcher->removeEventListener(_resetTextureListener);
+    _eventDispatcher->removeEventListener(_lettersAddedListener);
 
     CC_SAFE_RELEASE_NULL(_textSprite);
     CC_SAFE_RELEASE_NULL(_shadowNode);
+    CC_SAFE_RELEASE_NULL(_batchedGLProgramState);
 }
 
 void Label::reset()
@@ -476,6 +534,9 @@ void Label::reset()
     _contentDirty = false;
     _numberOfLines = 0;
     _lengthOfString = 0;
+    _lineStarts.clear();
+    _layoutLength = 0;
+    _reflowStart = 0;
     _utf32Text.clear();
     _utf8Text.clear();
 
@@ -516,6 +577,8 @@ void Label::reset()
     _uniformEffectColor = -1;
     _uniformEffectType = -1;
     _uniformTextColor = -1;
+    _uniformSmoothing = -1;
+    _batchableGLProgramState = nullptr;
 
     _useDistanceField = false;
     _useA8Shader = false;
@@ -562,8 +625,6 @@ void Label::updateShaderProgram()
             setGLProgramState(GLProgramState::getOrCreateWithGLProgramName(GLProgram::SHADER_NAME_LABEL_DISTANCEFIELD_NORMAL));
         else if (_useA8Shader)
             setGLProgramState(GLProgramState::getOrCreateWithGLProgramName(GLProgram::SHADER_NAME_LABEL_NORMAL));
-        else if (_shadowEnabled)
-            setGLProgramState(GLProgramState::getOrCreateWithGLProgramName(GLProgram::SHADER_NAME_POSITION_TEXTURE_COLOR, _getTexture(this)));
         else
             setGLProgramState(GLProgramState::getOrCreateWithGLProgramName(GLProgram::SHADER_NAME_POSITION_TEXTURE_COLOR_NO_MVP, _getTexture(this)));
 
@@ -585,6 +646,10 @@ void Label::updateShaderProgram()
     }
     
     _uniformTextColor = glGetUniformLocation(getGLProgram()->getProgram(), "u_textColor");
+    _uniformSmoothing = _useDistanceField ? glGetUniformLocation(getGLProgram()->getProgram(), "u_smoothing") : -1;
+
+    bool batchable = _currLabelEffect == LabelEffect::NORMAL && (_useDistanceField || _useA8Shader);
+    _batchableGLProgramState = batchable ? getGLProgramState() : nullptr;
 }
 
 void Label::setFontAtlas(FontAtlas* atlas,bool distanceFieldEnabled /* = false */, bool useA8Shader /* = false */)
@@ -604,6 +669,7 @@ void Label::setFontAtlas(FontAtlas* atlas,bool distanceFieldEnabled /* = false *
         FontAtlasCache::releaseFontAtlas(_fontAtlas);
     }
     _fontAtlas = atlas;
+    _lineStarts.clear();
     
     if (_reusedLetter == nullptr)
     {
@@ -676,6 +742,10 @@ void Label::setString(const std::string& text)
         std::u32string utf32String;
         if (StringUtils::UTF8ToUTF32(_utf8Text, utf32String))
         {
+            // the layout is kept up to the first changed letter
+            auto mismatch = std::mismatch(_utf32Text.begin(), _utf32Text.begin() + std::min(_utf32Text.length(), utf32String.length()),
+                                          utf32String.begin());
+            _reflowStart = std::min(_reflowStart, static_cast<int>(mismatch.first - _utf32Text.begin()));
             _utf32Text  = utf32String;
         }
 
@@ -796,8 +866,8 @@ void Label::updateLabelLetters()
                         letterSprite->setAtlasIndex(_lettersInfo[letterIndex].atlasIndex);
                     }
 
-                    auto px = letterInfo.positionX + letterDef.width / 2 + _linesOffsetX[letterInfo.lineIndex];
-                    auto py = letterInfo.positionY - letterDef.height / 2 + _letterOffsetY;
+                    auto px = letterInfo.positionX + letterDef.width / 2 * _bmfontScale + _linesOffsetX[letterInfo.lineIndex];
+                    auto py = letterInfo.positionY - letterDef.height / 2 * _bmfontScale + _letterOffsetY;
                     letterSprite->setPosition(px, py);
                 }
                 else
@@ -853,7 +923,6 @@ bool Label::alignText()
         
         _lengthOfString = 0;
         _textDesiredHeight = 0.f;
-        _linesWidth.clear();
         if (_maxLineWidth > 0.f && !_lineBreakWithoutSpaces)
         {
             multilineTextWrapByWord();
@@ -888,6 +957,99 @@ bool Label::alignText()
     return ret;
 }
 
+// letters which don't change the line breaks when they are replaced by a letter of the same metrics
+static bool isSwappableLetter(char32_t character)
+{
+    return character != StringUtils::UnicodeCharacters::NewLine
+        && character != StringUtils::UnicodeCharacters::CarriageReturn
+        && character != StringUtils::UnicodeCharacters::NextCharNoChangeX
+        && !StringUtils::isUnicodeSpace(character)
+        && !StringUtils::isCJKUnicode(character);
+}
+
+static bool haveSameMetrics(const FontLetterDefinition& letterDef, const FontLetterDefinition& otherLetterDef, bool wrapping)
+{
+    if (letterDef.validDefinition != otherLetterDef.validDefinition || letterDef.xAdvance != otherLetterDef.xAdvance
+        || letterDef.offsetY != otherLetterDef.offsetY || letterDef.height != otherLetterDef.height)
+        return false;
+
+    // the width decides where the lines break
+    return !wrapping || (letterDef.offsetX == otherLetterDef.offsetX && letterDef.width == otherLetterDef.width);
+}
+
+bool Label::swapChangedLetters()
+{
+    // e.g. a counter: same length, the changed letters have the same advance, only their quads change
+    int textLen = static_cast<int>(_utf32Text.length());
+    if (_lineStarts.empty() || _reflowStart >= textLen || textLen != _layoutLength
+        || _overflow == Overflow::SHRINK || _batchNodes.empty())
+        return false;
+
+    updateBMFontScale();
+    if (!(getLayoutParameters() == _layoutParameters))
+        return false;
+
+    _fontAtlas->prepareLetterDefinitions(_utf32Text.substr(_reflowStart));
+    if (_lineStarts.empty() || _fontAtlas->getTextures().size() > static_cast<size_t>(_batchNodes.size()))
+        return false;
+
+    int letterCount = 0;
+    int* kernings = _fontAtlas->getFont()->getHorizontalKerningForTextUTF32(_utf32Text, letterCount);
+    bool wrapping = _enableWrap && _maxLineWidth > 0.f;
+    bool swappable = (kernings == nullptr) == (_horizontalKernings == nullptr);
+    FontLetterDefinition letterDef;
+    FontLetterDefinition oldLetterDef;
+
+    for (int index = _reflowStart; index < textLen && swappable; ++index)
+    {
+        char32_t character = _utf32Text[index];
+        char32_t oldCharacter = _lettersInfo[index].utf32Char;
+        if (character == oldCharacter)
+            continue;
+
+        swappable = isSwappableLetter(character) && isSwappableLetter(oldCharacter)
+            && getFontLetterDef(character, letterDef) && getFontLetterDef(oldCharacter, oldLetterDef)
+            && haveSameMetrics(letterDef, oldLetterDef, wrapping);
+
+        if (swappable && kernings)
+        {
+            swappable = kernings[index] == _horizontalKernings[index]
+                && (index + 1 == textLen || kernings[index + 1] == _horizontalKernings[index + 1]);
+        }
+    }
+
+    if (!swappable)
+    {
+        delete [] kernings;
+        return false;
+    }
+
+    delete [] _horizontalKernings;
+    _horizontalKernings = kernings;
+
+    auto contentScaleFactor = CC_CONTENT_SCALE_FACTOR();
+    for (int index = _reflowStart; index < textLen; ++index)
+    {
+        auto& letterInfo = _lettersInfo[index];
+        if (_utf32Text[index] == letterInfo.utf32Char)
+            continue;
+
+        getFontLetterDef(_utf32Text[index], letterDef);
+        getFontLetterDef(letterInfo.utf32Char, oldLetterDef);
+        letterInfo.positionX += (letterDef.offsetX - oldLetterDef.offsetX) * _bmfontScale / contentScaleFactor;
+        letterInfo.utf32Char = _utf32Text[index];
+        letterInfo.valid = _fontAtlas->_letterDefinitions[letterInfo.utf32Char].validDefinition;
+    }
+    _reflowStart = textLen;
+
+    // Overflow::SHRINK doesn't come here, the quads can't be clamped
+    updateQuads();
+    updateLabelLetters();
+    updateColor();
+
+    return true;
+}
+
 bool Label::computeHorizontalKernings(const std::u32string& stringToRender)
 {
     if (_horizontalKernings)
@@ -1003,6 +1165,7 @@ bool Label::setTTFConfigInternal(const TTFConfig& ttfConfig)
     setFontAtlas(newAtlas,ttfConfig.distanceFieldEnabled,true);
 
     _fontConfig = ttfConfig;
+    updateBMFontScale();
 
     if (_fontConfig.outlineSize > 0)
     {
@@ -1155,11 +1318,6 @@ void Label::enableShadow(const Color4B& shadowColor /* = Color4B::BLACK */,
     _shadowColor4F.g = shadowColor.g / 255.0f;
     _shadowColor4F.b = shadowColor.b / 255.0f;
     _shadowColor4F.a = shadowColor.a / 255.0f;
-
-    if (_currentLabelType == LabelType::BMFONT || _currentLabelType == LabelType::CHARMAP)
-    {
-        setGLProgramState(GLProgramState::getOrCreateWithGLProgramName(_shadowEnabled ? GLProgram::SHADER_NAME_POSITION_TEXTURE_COLOR : GLProgram::SHADER_NAME_POSITION_TEXTURE_COLOR_NO_MVP, _getTexture(this)));
-    }
 }
 
 void Label::enableItalics()
@@ -1415,14 +1573,12 @@ void Label::updateContent()
 
     if (_fontAtlas)
     {
-        std::u32string utf32String;
-        if (StringUtils::UTF8ToUTF32(_utf8Text, utf32String))
+        // setString() already converted the text
+        if (!swapChangedLetters())
         {
-            _utf32Text = utf32String;
+            computeHorizontalKernings(_utf32Text);
+            updateFinished = alignText();
         }
-
-        computeHorizontalKernings(_utf32Text);
-        updateFinished = alignText();
     }
     else
     {
@@ -1503,52 +1659,116 @@ float Label::getBMFontSize()const
 
 void Label::onDrawShadow(GLProgram* glProgram, const Color4F& shadowColor)
 {
-    if (_currentLabelType == LabelType::TTF)
+    // only TTF labels come here, the shadow of the other ones is in their quad command
+    if (_currLabelEffect == LabelEffect::OUTLINE)
     {
-        if (_currLabelEffect == LabelEffect::OUTLINE)
+        glProgram->setUniformLocationWith1i(_uniformEffectType, 2); // 2: shadow
+        glProgram->setUniformLocationWith4f(_uniformEffectColor, shadowColor.r, shadowColor.g, shadowColor.b, shadowColor.a);
+    }
+    else
+    {
+        glProgram->setUniformLocationWith4f(_uniformTextColor, shadowColor.r, shadowColor.g, shadowColor.b, shadowColor.a);
+        if (_currLabelEffect == LabelEffect::GLOW)
         {
-            glProgram->setUniformLocationWith1i(_uniformEffectType, 2); // 2: shadow
             glProgram->setUniformLocationWith4f(_uniformEffectColor, shadowColor.r, shadowColor.g, shadowColor.b, shadowColor.a);
         }
-        else
-        {
-            glProgram->setUniformLocationWith4f(_uniformTextColor, shadowColor.r, shadowColor.g, shadowColor.b, shadowColor.a);
-            if (_currLabelEffect == LabelEffect::GLOW)
-            {
-                glProgram->setUniformLocationWith4f(_uniformEffectColor, shadowColor.r, shadowColor.g, shadowColor.b, shadowColor.a);
-            }
-        }
+    }
 
-        glProgram->setUniformsForBuiltins(_shadowTransform);
-        for (auto&& it : _letters)
-        {
-            it.second->updateTransform();
-        }
-        for (auto&& batchNode : _batchNodes)
+    glProgram->setUniformsForBuiltins(_shadowTransform);
+    for (auto&& it : _letters)
+    {
+        it.second->updateTransform();
+    }
+    for (auto&& batchNode : _batchNodes)
+    {
+        batchNode->getTextureAtlas()->drawQuads();
+    }
+}
+
+void Label::addQuadCommand(Renderer* renderer, const Mat4& transform, uint32_t flags)
+{
+    for (auto&& it : _letters)
+    {
+        it.second->updateTransform();
+    }
+
+    // ETC1 ALPHA supports for BMFONT & CHARMAP
+    auto textureAtlas = _batchNodes.at(0)->getTextureAtlas();
+    auto texture = textureAtlas->getTexture();
+    auto quads = textureAtlas->getQuads();
+    auto quadCount = textureAtlas->getTotalQuads();
+    bool isTTF = _currentLabelType == LabelType::TTF;
+    bool tinted = isTTF && _textColor != Color4B::WHITE;
+
+    auto glProgramState = getGLProgramState();
+    if (isTTF)
+    {
+        glProgramState = getBatchedGLProgramState(_useDistanceField, getDistanceFieldSmoothing(_bmfontScale));
+        if (glProgramState != _batchedGLProgramState)
         {
-            batchNode->getTextureAtlas()->drawQuads();
+            CC_SAFE_RETAIN(glProgramState);
+            CC_SAFE_RELEASE(_batchedGLProgramState);
+            _batchedGLProgramState = glProgramState;
         }
     }
-    else
+
+    // the shadow and the text color are baked in the vertices, labels of any color batch together
+    if (_shadowEnabled || tinted)
     {
-        Color3B oldColor = _realColor;
-        GLubyte oldOPacity = _displayedOpacity;
-        _displayedOpacity = shadowColor.a * 255;
-        setColor(Color3B(shadowColor));
+        auto textOffset = _shadowEnabled ? quadCount : 0;
+        _batchedQuads.resize(textOffset + quadCount);
 
-        glProgram->setUniformsForBuiltins(_shadowTransform);
-        for (auto&& it : _letters)
+        if (_shadowEnabled)
         {
-            it.second->updateTransform();
+            // the shadow is drawn with the transform of the text
+            Mat4 shadowTransform = transform.getInversed() * _shadowTransform;
+            Color4F shadowColor = _boldEnabled ? _textColorF : _shadowColor4F;
+            if (!isTTF)
+            {
+                // the vertex colors of the TTF letters carry the cascaded color and opacity, the other ones
+                // are replaced: the shadow gets the color of the parents and the opacity of the label
+                shadowColor.r *= _realColor.r > 0 ? _displayedColor.r / (float)_realColor.r : 1.f;
+                shadowColor.g *= _realColor.g > 0 ? _displayedColor.g / (float)_realColor.g : 1.f;
+                shadowColor.b *= _realColor.b > 0 ? _displayedColor.b / (float)_realColor.b : 1.f;
+                shadowColor.a *= _displayedOpacity / 255.f;
+            }
+            Color4B shadowColor4B(shadowColor);
+            if (!isTTF && _isOpacityModifyRGB)
+            {
+                shadowColor4B = multiplyColor(shadowColor4B, Color4F(shadowColor.a, shadowColor.a, shadowColor.a, 1.f));
+            }
+
+            for (ssize_t index = 0; index < quadCount; ++index)
+            {
+                auto& quad = _batchedQuads[index];
+                quad = quads[index];
+                for (auto vertex : { &quad.tl, &quad.bl, &quad.tr, &quad.br })
+                {
+                    shadowTransform.transformPoint(&vertex->vertices);
+                    vertex->colors = isTTF ? multiplyColor(vertex->colors, shadowColor) : shadowColor4B;
+                }
+            }
         }
-        for (auto&& batchNode : _batchNodes)
+
+        for (ssize_t index = 0; index < quadCount; ++index)
         {
-            batchNode->getTextureAtlas()->drawQuads();
+            auto& quad = _batchedQuads[textOffset + index];
+            quad = quads[index];
+            if (tinted)
+            {
+                for (auto vertex : { &quad.tl, &quad.bl, &quad.tr, &quad.br })
+                {
+                    vertex->colors = multiplyColor(vertex->colors, _textColorF);
+                }
+            }
         }
 
-        _displayedOpacity = oldOPacity;
-        setColor(oldColor);
+        quads = _batchedQuads.data();
+        quadCount = _batchedQuads.size();
     }
+
+    _quadCommand.init(_globalZOrder, texture, glProgramState, _blendFunc, quads, quadCount, transform, flags);
+    renderer->addCommand(&_quadCommand);
 }
 
 void Label::onDraw(const Mat4& transform, bool /*transformUpdated*/)
@@ -1557,6 +1777,12 @@ void Label::onDraw(const Mat4& transform, bool /*transformUpdated*/)
     glprogram->use();
     GL::blendFunc(_blendFunc.src, _blendFunc.dst);
 
+    if (_uniformSmoothing >= 0)
+    {
+        // keeps the edges about one pixel wide whatever the atlas scale is
+        glprogram->setUniformLocationWith1f(_uniformSmoothing, getDistanceFieldSmoothing(_bmfontScale));
+    }
+
     if (_shadowEnabled)
     {
         if (_boldEnabled)
@@ -1628,18 +1854,11 @@ void Label::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
     if (_insideBounds)
 #endif
     {
-        if (!_shadowEnabled && (_currentLabelType == LabelType::BMFONT || _currentLabelType == LabelType::CHARMAP))
+        // TTF labels spread over several atlas pages, with an outline, a glow or a custom shader draw themselves
+        if (_currentLabelType != LabelType::TTF
+            || (getGLProgramState() == _batchableGLProgramState && _batchNodes.size() == 1))
         {
-            for (auto&& it : _letters)
-            {
-                it.second->updateTransform();
-            }
-            // ETC1 ALPHA supports for BMFONT & CHARMAP
-            auto textureAtlas = _batchNodes.at(0)->getTextureAtlas();
-            auto texture = textureAtlas->getTexture();
-            _quadCommand.init(_globalZOrder, texture, getGLProgramState(), 
-                _blendFunc, textureAtlas->getQuads(), textureAtlas->getTotalQuads(), transform, flags);
-            renderer->addCommand(&_quadCommand);
+            addQuadCommand(renderer, transform, flags);
         }
         else
         {
@@ -1662,6 +1881,12 @@ void Label::visit(Renderer *renderer, const Mat4 &parentTransform, uint32_t pare
     {
         updateContent();
     }
+
+    // the letters added to the atlas, by this label or another one, are uploaded before they are drawn
+    if (_fontAtlas)
+    {
+        _fontAtlas->uploadDirtyRects();
+    }
     
     uint32_t flags = processParentFlags(parentTransform, parentFlags);
 
@@ -2228,7 +2453,7 @@ Label::Overflow Label::getOverflow()const
 
 void Label::updateLetterSpriteScale(Sprite* sprite)
 {
-    if (_currentLabelType == LabelType::BMFONT && _bmFontSize > 0)
+    if ((_currentLabelType == LabelType::BMFONT && _bmFontSize > 0) || _currentLabelType == LabelType::TTF)
     {
         sprite->setScale(_bmfontScale);
     }
@@ -660,6 +660,47 @@ protected:
         int lineIndex;
     };
 
+    // layout state at the beginning of a line, the layout can resume from there
+    struct LineStart
+    {
+        int letterIndex;
+        float nextTokenY;
+        float highestY;
+        float lowestY;
+        float nextWhitespaceWidth;
+        bool nextChangeSize;
+        bool afterNewLine;
+    };
+
+    // what the line starts and the letter positions depend on, besides the text and the letter definitions
+    struct LayoutParameters
+    {
+        FontAtlas* fontAtlas;
+        float maxLineWidth;
+        bool enableWrap;
+        bool lineBreakWithoutSpaces;
+        float bmfontScale;
+        float lineHeight;
+        float lineSpacing;
+        float additionalKerning;
+        float labelWidth;
+        float labelHeight;
+        TextHAlignment hAlignment;
+        TextVAlignment vAlignment;
+        Overflow overflow;
+
+        bool operator==(const LayoutParameters& other) const
+        {
+            return fontAtlas == other.fontAtlas && maxLineWidth == other.maxLineWidth
+                && enableWrap == other.enableWrap && lineBreakWithoutSpaces == other.lineBreakWithoutSpaces
+                && bmfontScale == other.bmfontScale && lineHeight == other.lineHeight
+                && lineSpacing == other.lineSpacing && additionalKerning == other.additionalKerning
+                && labelWidth == other.labelWidth && labelHeight == other.labelHeight
+                && hAlignment == other.hAlignment && vAlignment == other.vAlignment
+                && overflow == other.overflow;
+        }
+    };
+
     virtual void setFontAtlas(FontAtlas* atlas, bool distanceFieldEnabled = false, bool useA8Shader = false);
     bool getFontLetterDef(char32_t character, FontLetterDefinition& letterDef) const;
 
@@ -667,12 +708,15 @@ protected:
 
     void onDraw(const Mat4& transform, bool transformUpdated);
     void onDrawShadow(GLProgram* glProgram, const Color4F& shadowColor);
+    void addQuadCommand(Renderer* renderer, const Mat4& transform, uint32_t flags);
     void drawSelf(bool visibleByCamera, Renderer* renderer, uint32_t flags);
 
     bool multilineTextWrapByChar();
     bool multilineTextWrapByWord();
     bool multilineTextWrap(const std::function<int(const std::u32string&, int, int)>& lambda);
     void shrinkLabelToContentSize(const std::function<bool(void)>& lambda);
+    LayoutParameters getLayoutParameters() const;
+    bool swapChangedLetters();
     bool isHorizontalClamp();
     bool isVerticalClamp();
     void rescaleWithOriginalFontSize();
@@ -732,6 +776,13 @@ protected:
     Rect _reusedRect;
     int _lengthOfString;
 
+    // see multilineTextWrap(), invalidated by clearing _lineStarts
+    std::vector<LineStart> _lineStarts;
+    LayoutParameters _layoutParameters;
+    int _layoutLength;
+    // first letter changed by setString() since the last layout
+    int _reflowStart;
+
     //layout relevant properties.
     float _lineHeight;
     float _lineSpacing;
@@ -759,10 +810,17 @@ protected:
 
     QuadCommand _quadCommand;
     CustomCommand _customCommand;
+    // the program state of TTF labels which are drawn with _quadCommand, a custom one disables the batching
+    GLProgramState* _batchableGLProgramState;
+    // the shared program state drawing the TTF label, retained so that the cache doesn't remove it while it is used
+    GLProgramState* _batchedGLProgramState;
+    // vertices of the shadow and of the tinted text, see addQuadCommand()
+    std::vector<V3F_C4B_T2F_Quad> _batchedQuads;
     Mat4  _shadowTransform;
     GLint _uniformEffectColor;
     GLint _uniformEffectType; // 0: None, 1: Outline, 2: Shadow; Only used when outline is enabled.
     GLint _uniformTextColor;
+    GLint _uniformSmoothing;
     bool _useDistanceField;
     bool _useA8Shader;
 
@@ -788,6 +846,7 @@ protected:
 
     EventListenerCustom* _purgeTextureListener;
     EventListenerCustom* _resetTextureListener;
+    EventListenerCustom* _lettersAddedListener;
 
 #if CC_LABEL_DEBUG_DRAW
     DrawNode* _debugDrawNode;
@@ -26,10 +26,12 @@
 
 #include "2d/CCLabel.h"
 #include <vector>
+#include <cmath>
 #include "base/ccUTF8.h"
 #include "base/CCDirector.h"
 #include "2d/CCFontAtlas.h"
 #include "2d/CCFontFNT.h"
+#include "2d/CCFontFreeType.h"
 
 NS_CC_BEGIN
 
@@ -142,11 +144,33 @@ void Label::updateBMFontScale()
         FontFNT *bmFont = (FontFNT*)font;
         float originalFontSize = bmFont->getOriginalFontSize();
         _bmfontScale = _bmFontSize * CC_CONTENT_SCALE_FACTOR() / originalFontSize;
+    }else if (_currentLabelType == LabelType::TTF && _fontAtlas->_fontFreeType && _fontAtlas->_fontFreeType->getFontSize() > 0) {
+        // the atlas may be rasterized at another size, see FontAtlasCache::setSharedDistanceFieldEnabled()
+        _bmfontScale = _fontConfig.fontSize / _fontAtlas->_fontFreeType->getFontSize();
     }else{
         _bmfontScale = 1.0f;
     }
 }
 
+Label::LayoutParameters Label::getLayoutParameters() const
+{
+    LayoutParameters parameters;
+    parameters.fontAtlas = _fontAtlas;
+    parameters.maxLineWidth = _maxLineWidth;
+    parameters.enableWrap = _enableWrap;
+    parameters.lineBreakWithoutSpaces = _lineBreakWithoutSpaces;
+    parameters.bmfontScale = _bmfontScale;
+    parameters.lineHeight = _lineHeight;
+    parameters.lineSpacing = _lineSpacing;
+    parameters.additionalKerning = _additionalKerning;
+    parameters.labelWidth = _labelWidth;
+    parameters.labelHeight = _labelHeight;
+    parameters.hAlignment = _hAlignment;
+    parameters.vAlignment = _vAlignment;
+    parameters.overflow = _overflow;
+    return parameters;
+}
+
 bool Label::multilineTextWrap(const std::function<int(const std::u32string&, int, int)>& nextTokenLen)
 {
     int textLen = getStringLength();
@@ -167,7 +191,41 @@ bool Label::multilineTextWrap(const std::function<int(const std::u32string&, int
 
     this->updateBMFontScale();
 
-    for (int index = 0; index < textLen; )
+    int index = 0;
+    auto parameters = getLayoutParameters();
+    if (!_lineStarts.empty() && _reflowStart > 0 && parameters == _layoutParameters)
+    {
+        // the lines before the first changed letter don't move. The line before it is laid out again when
+        // the change may pull back the word wrapped to the changed line, or changes the kerning at its end
+        lineIndex = static_cast<int>(_lineStarts.size()) - 1;
+        while (lineIndex > 0 && _lineStarts[lineIndex].letterIndex > _reflowStart)
+        {
+            --lineIndex;
+        }
+        if (lineIndex > 0 && !_lineStarts[lineIndex].afterNewLine)
+        {
+            --lineIndex;
+        }
+
+        auto& lineStart = _lineStarts[lineIndex];
+        index = lineStart.letterIndex;
+        nextTokenY = lineStart.nextTokenY;
+        highestY = lineStart.highestY;
+        lowestY = lineStart.lowestY;
+        nextWhitespaceWidth = lineStart.nextWhitespaceWidth;
+        nextChangeSize = lineStart.nextChangeSize;
+        _lineStarts.resize(lineIndex + 1);
+        _linesWidth.resize(lineIndex);
+    }
+    else
+    {
+        _lineStarts.clear();
+        _lineStarts.push_back({ 0, 0.f, 0.f, 0.f, 0.f, true, true });
+        _linesWidth.clear();
+        _layoutParameters = parameters;
+    }
+
+    while (index < textLen)
     {
         char32_t character = _utf32Text[index];
         if (character == StringUtils::UnicodeCharacters::NewLine)
@@ -179,6 +237,7 @@ bool Label::multilineTextWrap(const std::function<int(const std::u32string&, int
             nextTokenY -= _lineHeight*_bmfontScale + lineSpacing;
             recordPlaceholderInfo(index, character);
             index++;
+            _lineStarts.push_back({ index, nextTokenY, highestY, lowestY, nextWhitespaceWidth, nextChangeSize, true });
             continue;
         }
 
@@ -225,6 +284,7 @@ bool Label::multilineTextWrap(const std::function<int(const std::u32string&, int
                 nextTokenX = 0.f;
                 nextTokenY -= (_lineHeight*_bmfontScale + lineSpacing);
                 newLine = true;
+                _lineStarts.push_back({ index, nextTokenY, highestY, lowestY, 0.f, true, false });
                 break;
             }
             else
@@ -238,7 +298,7 @@ bool Label::multilineTextWrap(const std::function<int(const std::u32string&, int
             {
                 float newLetterWidth = 0.f;
                 if (_horizontalKernings && letterIndex < textLen - 1)
-                    newLetterWidth = _horizontalKernings[letterIndex + 1];
+                    newLetterWidth = _currentLabelType == LabelType::TTF ? _horizontalKernings[letterIndex + 1] * _bmfontScale : _horizontalKernings[letterIndex + 1];
                 newLetterWidth += letterDef.xAdvance * _bmfontScale + _additionalKerning;
 
                 nextLetterX += newLetterWidth;
@@ -291,6 +351,9 @@ bool Label::multilineTextWrap(const std::function<int(const std::u32string&, int
         }
     }
 
+    _layoutLength = textLen;
+    _reflowStart = textLen;
+
     _numberOfLines = lineIndex + 1;
     _textDesiredHeight = (_numberOfLines * _lineHeight * _bmfontScale) / contentScaleFactor;
     if (_numberOfLines > 1)
@@ -371,24 +434,38 @@ bool Label::isHorizontalClamp()
 
 void Label::shrinkLabelToContentSize(const std::function<bool(void)>& lambda)
 {
-    float fontSize = this->getRenderingFontSize();
+    if (!lambda())
+        return;
 
-    int i = 0;
-    auto letterDefinition = _fontAtlas->_letterDefinitions;
-    auto tempLetterDefinition = letterDefinition;
+    float fontSize = this->getRenderingFontSize();
     float originalLineHeight = _lineHeight;
-    bool flag = true;
-    while (lambda()) {
-        ++i;
-        float newFontSize = fontSize - i;
-        flag = false;
-        if (newFontSize <= 0) {
-            break;
+
+    // only the letters of the text are scaled, the atlas may hold many more
+    std::unordered_map<char32_t, FontLetterDefinition> letterDefinitions;
+    for (auto character : _utf32Text)
+    {
+        for (auto letter : { character, static_cast<char32_t>(StringUtils::UnicodeCharacters::Space) })
+        {
+            auto iter = _fontAtlas->_letterDefinitions.find(letter);
+            if (iter != _fontAtlas->_letterDefinitions.end())
+                letterDefinitions.emplace(letter, iter->second);
         }
+    }
+
+    auto isClampedAtFontSize = [&](float newFontSize) {
         float scale = newFontSize / fontSize;
-        std::swap(_fontAtlas->_letterDefinitions, tempLetterDefinition);
-        _fontAtlas->scaleFontLetterDefinition(scale);
+        for (auto&& it : letterDefinitions)
+        {
+            auto& letterDefinition = _fontAtlas->_letterDefinitions[it.first];
+            letterDefinition = it.second;
+            letterDefinition.width *= scale;
+            letterDefinition.height *= scale;
+            letterDefinition.offsetX *= scale;
+            letterDefinition.offsetY *= scale;
+            letterDefinition.xAdvance *= scale;
+        }
         this->setLineHeight(originalLineHeight * scale);
+        _lineStarts.clear();
         if (_maxLineWidth > 0.f && !_lineBreakWithoutSpaces)
         {
             multilineTextWrapByWord();
@@ -398,15 +475,31 @@ void Label::shrinkLabelToContentSize(const std::function<bool(void)>& lambda)
             multilineTextWrapByChar();
         }
         computeAlignmentOffset();
-        tempLetterDefinition = letterDefinition;
+        return lambda();
+    };
+
+    // the text only gets smaller with the font size: look for the smallest decrement which fits,
+    // decrementing down to a null font size gives up
+    int low = 1;
+    int high = static_cast<int>(std::ceil(fontSize));
+    while (low < high)
+    {
+        int middle = (low + high) / 2;
+        if (isClampedAtFontSize(fontSize - middle))
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    for (auto&& it : letterDefinitions)
+    {
+        _fontAtlas->_letterDefinitions[it.first] = it.second;
     }
     this->setLineHeight(originalLineHeight);
-    std::swap(_fontAtlas->_letterDefinitions, letterDefinition);
+    _lineStarts.clear();
 
-    if (!flag) {
-        if (fontSize - i >= 0) {
-            this->scaleFontSizeDown(fontSize - i);
-        }
+    if (fontSize - low >= 0) {
+        this->scaleFontSizeDown(fontSize - low);
     }
 }
 
@@ -150,6 +150,11 @@ void ParticleBatchNode::addChild(Node * aChild, int zOrder, int tag)
     CCASSERT( aChild != nullptr, "Argument must be non-nullptr");
     CCASSERT( dynamic_cast<ParticleSystem*>(aChild) != nullptr, "CCParticleBatchNode only supports QuadParticleSystems as children");
     ParticleSystem* child = static_cast<ParticleSystem*>(aChild);
+    // a system created from a binary definition may still be loading its texture, it won't replace this one
+    if (child->getTexture() == nullptr)
+    {
+        child->setTexture(_textureAtlas->getTexture());
+    }
     CCASSERT( child->getTexture()->getName() == _textureAtlas->getTexture()->getName(), "CCParticleSystem is not using the same texture id");
     
     addChildByTagOrName(child, zOrder, tag, "", true);
@@ -160,6 +165,11 @@ void ParticleBatchNode::addChild(Node * aChild, int zOrder, const std::string &n
     CCASSERT( aChild != nullptr, "Argument must be non-nullptr");
     CCASSERT( dynamic_cast<ParticleSystem*>(aChild) != nullptr, "CCParticleBatchNode only supports QuadParticleSystems as children");
     ParticleSystem* child = static_cast<ParticleSystem*>(aChild);
+    // a system created from a binary definition may still be loading its texture, it won't replace this one
+    if (child->getTexture() == nullptr)
+    {
+        child->setTexture(_textureAtlas->getTexture());
+    }
     CCASSERT( child->getTexture()->getName() == _textureAtlas->getTexture()->getName(), "CCParticleSystem is not using the same texture id");
    
     addChildByTagOrName(child, zOrder, 0, name, false);
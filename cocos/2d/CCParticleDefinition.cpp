@@ -0,0 +1,295 @@
+/****************************************************************************
+Copyright (c) 2017-2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "2d/CCParticleDefinition.h"
+
+#include <string.h>
+
+#include "base/ccMacros.h"
+
+NS_CC_BEGIN
+
+namespace
+{
+    // Binary particle definition layout, all values little endian.
+    // Must match tools/particle/compile_particles.py.
+    struct BinaryHeader
+    {
+        char magic[4];              // "CCPD"
+        uint32_t version;
+        int32_t maxParticles;
+        int32_t emitterMode;
+        uint32_t blendSrc;
+        uint32_t blendDst;
+        int32_t yCoordFlipped;
+        uint32_t rotationIsDir;
+        float angle, angleVar;
+        float duration;
+        float startColor[4], startColorVar[4];
+        float endColor[4], endColorVar[4];
+        float startSize, startSizeVar;
+        float endSize, endSizeVar;
+        float sourcePositionX, sourcePositionY;
+        float posVarX, posVarY;
+        float startSpin, startSpinVar;
+        float endSpin, endSpinVar;
+        float gravityX, gravityY;
+        float speed, speedVar;
+        float radialAccel, radialAccelVar;
+        float tangentialAccel, tangentialAccelVar;
+        float startRadius, startRadiusVar;
+        float endRadius, endRadiusVar;
+        float rotatePerSecond, rotatePerSecondVar;
+        float life, lifeVar;
+        // offsets from the start of the data
+        uint32_t configNameOffset;
+        uint32_t configNameLength;
+        uint32_t textureNameOffset;
+        uint32_t textureNameLength;
+        uint32_t textureImageOffset;
+        uint32_t textureImageLength;
+    };
+
+    const char BINARY_MAGIC[4] = { 'C', 'C', 'P', 'D' };
+    const uint32_t BINARY_VERSION = 1;
+
+    bool inRange(size_t offset, size_t length, size_t size)
+    {
+        return offset <= size && length <= size - offset;
+    }
+
+    const Value& getValue(const ValueMap& dictionary, const std::string& key)
+    {
+        auto iter = dictionary.find(key);
+        return iter != dictionary.end() ? iter->second : Value::Null;
+    }
+
+    Color4F getColor(const float* values)
+    {
+        return Color4F(values[0], values[1], values[2], values[3]);
+    }
+}
+
+ParticleDefinition::ParticleDefinition()
+: maxParticles(0)
+, angle(0)
+, angleVar(0)
+, duration(0)
+, blendFunc(BlendFunc::ALPHA_PREMULTIPLIED)
+, startSize(0)
+, startSizeVar(0)
+, endSize(0)
+, endSizeVar(0)
+, startSpin(0)
+, startSpinVar(0)
+, endSpin(0)
+, endSpinVar(0)
+, emitterMode(0)
+, speed(0)
+, speedVar(0)
+, radialAccel(0)
+, radialAccelVar(0)
+, tangentialAccel(0)
+, tangentialAccelVar(0)
+, rotationIsDir(false)
+, startRadius(0)
+, startRadiusVar(0)
+, endRadius(0)
+, endRadiusVar(0)
+, rotatePerSecond(0)
+, rotatePerSecondVar(0)
+, life(0)
+, lifeVar(0)
+, yCoordFlipped(1)
+, textureImageDataEncoded(false)
+{
+}
+
+bool ParticleDefinition::isBinary(const unsigned char* bytes, size_t size)
+{
+    return size >= sizeof(BinaryHeader) && memcmp(bytes, BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0;
+}
+
+bool ParticleDefinition::initWithDictionary(const ValueMap& dictionary)
+{
+    *this = ParticleDefinition();
+
+    auto get = [&dictionary](const char* key) -> const Value& {
+        return getValue(dictionary, key);
+    };
+
+    maxParticles = get("maxParticles").asInt();
+    configName = get("configName").asString();
+
+    angle = get("angle").asFloat();
+    angleVar = get("angleVariance").asFloat();
+    duration = get("duration").asFloat();
+
+    // Particle Designer 2.0 writes the source blend function as a real
+    if (!configName.empty())
+    {
+        blendFunc.src = get("blendFuncSource").asFloat();
+    }
+    else
+    {
+        blendFunc.src = get("blendFuncSource").asInt();
+    }
+    blendFunc.dst = get("blendFuncDestination").asInt();
+
+    startColor = Color4F(get("startColorRed").asFloat(), get("startColorGreen").asFloat(),
+                         get("startColorBlue").asFloat(), get("startColorAlpha").asFloat());
+    startColorVar = Color4F(get("startColorVarianceRed").asFloat(), get("startColorVarianceGreen").asFloat(),
+                            get("startColorVarianceBlue").asFloat(), get("startColorVarianceAlpha").asFloat());
+    endColor = Color4F(get("finishColorRed").asFloat(), get("finishColorGreen").asFloat(),
+                       get("finishColorBlue").asFloat(), get("finishColorAlpha").asFloat());
+    endColorVar = Color4F(get("finishColorVarianceRed").asFloat(), get("finishColorVarianceGreen").asFloat(),
+                          get("finishColorVarianceBlue").asFloat(), get("finishColorVarianceAlpha").asFloat());
+
+    startSize = get("startParticleSize").asFloat();
+    startSizeVar = get("startParticleSizeVariance").asFloat();
+    endSize = get("finishParticleSize").asFloat();
+    endSizeVar = get("finishParticleSizeVariance").asFloat();
+
+    sourcePosition.set(get("sourcePositionx").asFloat(), get("sourcePositiony").asFloat());
+    posVar.set(get("sourcePositionVariancex").asFloat(), get("sourcePositionVariancey").asFloat());
+
+    startSpin = get("rotationStart").asFloat();
+    startSpinVar = get("rotationStartVariance").asFloat();
+    endSpin = get("rotationEnd").asFloat();
+    endSpinVar = get("rotationEndVariance").asFloat();
+
+    // 0: gravity, 1: radius, see ParticleSystem::Mode
+    emitterMode = get("emitterType").asInt();
+    if (emitterMode == 0)
+    {
+        gravity.set(get("gravityx").asFloat(), get("gravityy").asFloat());
+        speed = get("speed").asFloat();
+        speedVar = get("speedVariance").asFloat();
+        radialAccel = get("radialAcceleration").asFloat();
+        radialAccelVar = get("radialAccelVariance").asFloat();
+        tangentialAccel = get("tangentialAcceleration").asFloat();
+        tangentialAccelVar = get("tangentialAccelVariance").asFloat();
+        rotationIsDir = get("rotationIsDir").asBool();
+    }
+    else if (emitterMode == 1)
+    {
+        // Particle Designer 2.0 radii and rotation are integers
+        if (!configName.empty())
+        {
+            startRadius = get("maxRadius").asInt();
+            endRadius = get("minRadius").asInt();
+            rotatePerSecond = get("rotatePerSecond").asInt();
+        }
+        else
+        {
+            startRadius = get("maxRadius").asFloat();
+            endRadius = get("minRadius").asFloat();
+            rotatePerSecond = get("rotatePerSecond").asFloat();
+        }
+        startRadiusVar = get("maxRadiusVariance").asFloat();
+        endRadiusVar = get("minRadiusVariance").asFloat();
+        rotatePerSecondVar = get("rotatePerSecondVariance").asFloat();
+    }
+
+    life = get("particleLifespan").asFloat();
+    lifeVar = get("particleLifespanVariance").asFloat();
+
+    textureFileName = get("textureFileName").asString();
+    auto imageData = dictionary.find("textureImageData");
+    if (imageData != dictionary.end())
+    {
+        textureImageData = imageData->second.asString();
+        textureImageDataEncoded = true;
+    }
+
+    auto flipped = dictionary.find("yCoordFlipped");
+    yCoordFlipped = flipped == dictionary.end() ? 1 : flipped->second.asInt();
+    return true;
+}
+
+bool ParticleDefinition::initWithBinary(const unsigned char* bytes, size_t size)
+{
+    *this = ParticleDefinition();
+
+    if (!isBinary(bytes, size))
+        return false;
+
+    BinaryHeader header;
+    memcpy(&header, bytes, sizeof(header));
+    if (header.version != BINARY_VERSION
+        || !inRange(header.configNameOffset, header.configNameLength, size)
+        || !inRange(header.textureNameOffset, header.textureNameLength, size)
+        || !inRange(header.textureImageOffset, header.textureImageLength, size))
+    {
+        CCLOG("cocos2d: ParticleDefinition: malformed binary particle definition");
+        return false;
+    }
+
+    maxParticles = header.maxParticles;
+    emitterMode = header.emitterMode;
+    blendFunc.src = header.blendSrc;
+    blendFunc.dst = header.blendDst;
+    yCoordFlipped = header.yCoordFlipped;
+    rotationIsDir = header.rotationIsDir != 0;
+    angle = header.angle;
+    angleVar = header.angleVar;
+    duration = header.duration;
+    startColor = getColor(header.startColor);
+    startColorVar = getColor(header.startColorVar);
+    endColor = getColor(header.endColor);
+    endColorVar = getColor(header.endColorVar);
+    startSize = header.startSize;
+    startSizeVar = header.startSizeVar;
+    endSize = header.endSize;
+    endSizeVar = header.endSizeVar;
+    sourcePosition.set(header.sourcePositionX, header.sourcePositionY);
+    posVar.set(header.posVarX, header.posVarY);
+    startSpin = header.startSpin;
+    startSpinVar = header.startSpinVar;
+    endSpin = header.endSpin;
+    endSpinVar = header.endSpinVar;
+    gravity.set(header.gravityX, header.gravityY);
+    speed = header.speed;
+    speedVar = header.speedVar;
+    radialAccel = header.radialAccel;
+    radialAccelVar = header.radialAccelVar;
+    tangentialAccel = header.tangentialAccel;
+    tangentialAccelVar = header.tangentialAccelVar;
+    startRadius = header.startRadius;
+    startRadiusVar = header.startRadiusVar;
+    endRadius = header.endRadius;
+    endRadiusVar = header.endRadiusVar;
+    rotatePerSecond = header.rotatePerSecond;
+    rotatePerSecondVar = header.rotatePerSecondVar;
+    life = header.life;
+    lifeVar = header.lifeVar;
+
+    configName.assign((const char*)bytes + header.configNameOffset, header.configNameLength);
+    textureFileName.assign((const char*)bytes + header.textureNameOffset, header.textureNameLength);
+    textureImageData.assign((const char*)bytes + header.textureImageOffset, header.textureImageLength);
+    textureImageDataEncoded = false;
+    return true;
+}
+
+NS_CC_END
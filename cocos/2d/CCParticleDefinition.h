@@ -0,0 +1,130 @@
+/****************************************************************************
+Copyright (c) 2017-2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CC_PARTICLE_DEFINITION_H__
+#define __CC_PARTICLE_DEFINITION_H__
+
+#include <string>
+
+#include "platform/CCPlatformMacros.h"
+#include "base/CCValue.h"
+#include "base/ccTypes.h"
+#include "math/Vec2.h"
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup _2d
+ * @{
+ */
+
+/**
+ * Settings of a ParticleSystem, decoded without creating any engine object.
+ *
+ * A definition can be decoded from a particle plist (Particle Designer format) or from a binary
+ * particle definition. Binary definitions are a fixed size record followed by the strings and the
+ * embedded image, decoding them doesn't parse anything, and the embedded image is stored as is
+ * instead of base64 encoded and gzipped. Use `tools/particle/compile_particles.py` to convert
+ * plists to binary definitions.
+ *
+ * The values are already interpreted the way ParticleSystem::initWithDictionary() does, so both
+ * sources give the same system.
+ * @since v3.18
+ * @js NA
+ * @lua NA
+ */
+class CC_DLL ParticleDefinition
+{
+public:
+    ParticleDefinition();
+
+    /** Reads a particle plist dictionary, replacing the current content. */
+    bool initWithDictionary(const ValueMap& dictionary);
+
+    /** Decodes a binary particle definition, replacing the current content. */
+    bool initWithBinary(const unsigned char* bytes, size_t size);
+
+    /** Checks whether the data starts like a binary particle definition. */
+    static bool isBinary(const unsigned char* bytes, size_t size);
+
+    int maxParticles;
+    /** emitter name in Particle Designer 2.0, may be empty */
+    std::string configName;
+    float angle;
+    float angleVar;
+    float duration;
+    BlendFunc blendFunc;
+    Color4F startColor;
+    Color4F startColorVar;
+    Color4F endColor;
+    Color4F endColorVar;
+    float startSize;
+    float startSizeVar;
+    float endSize;
+    float endSizeVar;
+    Vec2 sourcePosition;
+    Vec2 posVar;
+    float startSpin;
+    float startSpinVar;
+    float endSpin;
+    float endSpinVar;
+    /** ParticleSystem::Mode */
+    int emitterMode;
+
+    // gravity mode
+    Vec2 gravity;
+    float speed;
+    float speedVar;
+    float radialAccel;
+    float radialAccelVar;
+    float tangentialAccel;
+    float tangentialAccelVar;
+    bool rotationIsDir;
+
+    // radius mode
+    float startRadius;
+    float startRadiusVar;
+    float endRadius;
+    float endRadiusVar;
+    float rotatePerSecond;
+    float rotatePerSecondVar;
+
+    float life;
+    float lifeVar;
+    int yCoordFlipped;
+
+    /** texture file name relative to the definition, may be empty */
+    std::string textureFileName;
+    /** image used when the texture file can't be loaded, may be empty */
+    std::string textureImageData;
+    /** whether textureImageData is base64 encoded and gzipped as in plists, or the image file itself */
+    bool textureImageDataEncoded;
+};
+
+// end of _2d group
+/// @}
+
+NS_CC_END
+
+#endif // __CC_PARTICLE_DEFINITION_H__
@@ -0,0 +1,670 @@
+/****************************************************************************
+Copyright (c) 2017-2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "2d/CCParticleKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "2d/CCParticleSystem.h"
+#include "base/ccMacros.h"
+
+//#define PARTICLE_KERNELS_SSE     : SSE2 code used
+//#define PARTICLE_KERNELS_NEON    : NEON code used
+//#define PARTICLE_KERNELS_VECTOR  : one of them is used
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PARTICLE_KERNELS_SSE
+#include <emmintrin.h>
+#elif defined (__ARM_NEON__) || defined (__ARM_NEON) || defined (__aarch64__)
+#define PARTICLE_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined (PARTICLE_KERNELS_SSE) || defined (PARTICLE_KERNELS_NEON)
+#define PARTICLE_KERNELS_VECTOR
+#endif
+
+NS_CC_BEGIN
+
+// LCG from ejoy2d, the 15 low bits of the seed become the mantissa of a float in [2, 4)
+static const uint32_t RANDOM_MULTIPLIER = 134775813;
+
+inline static float nextRandom(uint32_t* seed)
+{
+    *seed = *seed * RANDOM_MULTIPLIER + 1;
+    union {
+        uint32_t d;
+        float f;
+    } u;
+    u.d = ((*seed & 0x7fff) << 8) | 0x40000000;
+    return u.f - 3.0f;
+}
+
+inline static void normalizePoint(float x, float y, particle_point* out)
+{
+    float n = x * x + y * y;
+    // Too close to zero.
+    if (n <= 0)
+        return;
+
+    n = 1.0f / sqrtf(n);
+    out->x = x * n;
+    out->y = y * n;
+}
+
+inline static void updatePosWithParticle(V3F_C4B_T2F_Quad *quad, float x, float y, float size, float rotation)
+{
+    // vertices
+    float size_2 = size / 2;
+    float x1 = -size_2;
+    float y1 = -size_2;
+
+    float x2 = size_2;
+    float y2 = size_2;
+
+    float r = -CC_DEGREES_TO_RADIANS(rotation);
+    float cr = cosf(r);
+    float sr = sinf(r);
+
+    // bottom-left
+    quad->bl.vertices.x = x1 * cr - y1 * sr + x;
+    quad->bl.vertices.y = x1 * sr + y1 * cr + y;
+
+    // bottom-right vertex:
+    quad->br.vertices.x = x2 * cr - y1 * sr + x;
+    quad->br.vertices.y = x2 * sr + y1 * cr + y;
+
+    // top-left vertex:
+    quad->tl.vertices.x = x1 * cr - y2 * sr + x;
+    quad->tl.vertices.y = x1 * sr + y2 * cr + y;
+
+    // top-right vertex:
+    quad->tr.vertices.x = x2 * cr - y2 * sr + x;
+    quad->tr.vertices.y = x2 * sr + y2 * cr + y;
+}
+
+// the colors can go out of [0, 1] when the variance is added, the vector path clamps them the same way
+inline static GLubyte toColorByte(float value)
+{
+    return static_cast<GLubyte>(clampf(value, 0.f, 255.f));
+}
+
+inline static void setQuadColor(V3F_C4B_T2F_Quad* quad, GLubyte r, GLubyte g, GLubyte b, GLubyte a)
+{
+    quad->bl.colors.set(r, g, b, a);
+    quad->br.colors.set(r, g, b, a);
+    quad->tl.colors.set(r, g, b, a);
+    quad->tr.colors.set(r, g, b, a);
+}
+
+#ifdef PARTICLE_KERNELS_SSE
+
+typedef __m128 float4;
+typedef __m128 mask4;
+typedef __m128i uint4;
+
+inline static float4 splat4(float f) { return _mm_set1_ps(f); }
+inline static float4 load4(const float* p) { return _mm_loadu_ps(p); }
+inline static void store4(float* p, float4 v) { _mm_storeu_ps(p, v); }
+inline static float4 add4(float4 a, float4 b) { return _mm_add_ps(a, b); }
+inline static float4 sub4(float4 a, float4 b) { return _mm_sub_ps(a, b); }
+inline static float4 mul4(float4 a, float4 b) { return _mm_mul_ps(a, b); }
+inline static float4 div4(float4 a, float4 b) { return _mm_div_ps(a, b); }
+inline static float4 min4(float4 a, float4 b) { return _mm_min_ps(a, b); }
+inline static float4 max4(float4 a, float4 b) { return _mm_max_ps(a, b); }
+inline static float4 abs4(float4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+inline static mask4 greater4(float4 a, float4 b) { return _mm_cmpgt_ps(a, b); }
+inline static float4 select4(mask4 m, float4 a, float4 b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+inline static float4 round4(float4 a) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a)); }
+inline static float4 invSqrt4(float4 a) { return _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(a)); }
+inline static void storeInt4(int32_t* p, float4 v) { _mm_storeu_si128((__m128i*)p, _mm_cvttps_epi32(v)); }
+
+inline static uint4 loadSeeds4(const uint32_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+inline static void storeSeeds4(uint32_t* p, uint4 v) { _mm_storeu_si128((__m128i*)p, v); }
+
+inline static uint4 nextSeeds4(uint4 seeds)
+{
+    // SSE2 has no 32 bits multiplication, multiply the even and odd lanes as 64 bits
+    const __m128i multiplier = _mm_set1_epi32(RANDOM_MULTIPLIER);
+    __m128i even = _mm_mul_epu32(seeds, multiplier);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(seeds, 32), _mm_srli_epi64(multiplier, 32));
+    __m128i product = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                         _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+    return _mm_add_epi32(product, _mm_set1_epi32(1));
+}
+
+inline static float4 seedsToRandom4(uint4 seeds)
+{
+    __m128i bits = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(seeds, _mm_set1_epi32(0x7fff)), 8),
+                                _mm_set1_epi32(0x40000000));
+    return _mm_sub_ps(_mm_castsi128_ps(bits), _mm_set1_ps(3.0f));
+}
+
+#elif defined (PARTICLE_KERNELS_NEON)
+
+typedef float32x4_t float4;
+typedef uint32x4_t mask4;
+typedef uint32x4_t uint4;
+
+inline static float4 splat4(float f) { return vdupq_n_f32(f); }
+inline static float4 load4(const float* p) { return vld1q_f32(p); }
+inline static void store4(float* p, float4 v) { vst1q_f32(p, v); }
+inline static float4 add4(float4 a, float4 b) { return vaddq_f32(a, b); }
+inline static float4 sub4(float4 a, float4 b) { return vsubq_f32(a, b); }
+inline static float4 mul4(float4 a, float4 b) { return vmulq_f32(a, b); }
+inline static float4 min4(float4 a, float4 b) { return vminq_f32(a, b); }
+inline static float4 max4(float4 a, float4 b) { return vmaxq_f32(a, b); }
+inline static float4 abs4(float4 a) { return vabsq_f32(a); }
+inline static mask4 greater4(float4 a, float4 b) { return vcgtq_f32(a, b); }
+inline static float4 select4(mask4 m, float4 a, float4 b) { return vbslq_f32(m, a, b); }
+inline static void storeInt4(int32_t* p, float4 v) { vst1q_s32(p, vcvtq_s32_f32(v)); }
+
+inline static float4 div4(float4 a, float4 b)
+{
+#if defined (__aarch64__)
+    return vdivq_f32(a, b);
+#else
+    // estimate refined by two Newton-Raphson steps
+    float32x4_t r = vrecpeq_f32(b);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    return vmulq_f32(a, r);
+#endif
+}
+
+inline static float4 round4(float4 a)
+{
+    // the conversion truncates, round half away from zero
+    float32x4_t half = vbslq_f32(vcltq_f32(a, vdupq_n_f32(0)), vdupq_n_f32(-0.5f), vdupq_n_f32(0.5f));
+    return vcvtq_f32_s32(vcvtq_s32_f32(vaddq_f32(a, half)));
+}
+
+inline static float4 invSqrt4(float4 a)
+{
+    // estimate refined by two Newton-Raphson steps
+    float32x4_t e = vrsqrteq_f32(a);
+    e = vmulq_f32(vrsqrtsq_f32(vmulq_f32(a, e), e), e);
+    e = vmulq_f32(vrsqrtsq_f32(vmulq_f32(a, e), e), e);
+    return e;
+}
+
+inline static uint4 loadSeeds4(const uint32_t* p) { return vld1q_u32(p); }
+inline static void storeSeeds4(uint32_t* p, uint4 v) { vst1q_u32(p, v); }
+
+inline static uint4 nextSeeds4(uint4 seeds)
+{
+    return vmlaq_u32(vdupq_n_u32(1), seeds, vdupq_n_u32(RANDOM_MULTIPLIER));
+}
+
+inline static float4 seedsToRandom4(uint4 seeds)
+{
+    uint32x4_t bits = vorrq_u32(vshlq_n_u32(vandq_u32(seeds, vdupq_n_u32(0x7fff)), 8), vdupq_n_u32(0x40000000));
+    return vsubq_f32(vreinterpretq_f32_u32(bits), vdupq_n_f32(3.0f));
+}
+
+#endif
+
+#ifdef PARTICLE_KERNELS_VECTOR
+
+inline static float4 madd4(float4 a, float4 b, float4 c) { return add4(mul4(a, b), c); }
+inline static float4 neg4(float4 a) { return sub4(splat4(0), a); }
+
+// the last particles don't fill a whole vector, the missing lanes are zero
+inline static float4 loadN(const float* p, int n)
+{
+    if (n == 4)
+        return load4(p);
+
+    float tmp[4] = { 0, 0, 0, 0 };
+    memcpy(tmp, p, n * sizeof(float));
+    return load4(tmp);
+}
+
+inline static void storeN(float* p, float4 v, int n)
+{
+    if (n == 4)
+    {
+        store4(p, v);
+        return;
+    }
+
+    float tmp[4];
+    store4(tmp, v);
+    memcpy(p, tmp, n * sizeof(float));
+}
+
+// Accurate to about 1e-7 for |x| < 2^22 * 2 * pi.
+inline static void sinCos4(float4 x, float4* s, float4* c)
+{
+    // reduce to [-pi, pi], 2 * pi is split in two so big angles keep their precision
+    float4 k = round4(mul4(x, splat4(0.159154943f)));
+    float4 r = sub4(sub4(x, mul4(k, splat4(6.28125f))), mul4(k, splat4(1.93530717e-3f)));
+
+    // sin(r) = sign(r) * sin(|r|) and cos(r) = cos(|r|), then fold [pi / 2, pi] onto [0, pi / 2]
+    float4 a = abs4(r);
+    mask4 folded = greater4(a, splat4(1.57079637f));
+    a = select4(folded, sub4(splat4(3.14159274f), a), a);
+    float4 a2 = mul4(a, a);
+
+    // Taylor series
+    float4 sn = madd4(a2, splat4(-2.50521084e-8f), splat4(2.75573192e-6f));
+    sn = madd4(sn, a2, splat4(-1.98412698e-4f));
+    sn = madd4(sn, a2, splat4(8.33333333e-3f));
+    sn = madd4(sn, a2, splat4(-1.66666667e-1f));
+    sn = madd4(mul4(sn, a2), a, a);
+
+    float4 cs = madd4(a2, splat4(2.08767570e-9f), splat4(-2.75573192e-7f));
+    cs = madd4(cs, a2, splat4(2.48015873e-5f));
+    cs = madd4(cs, a2, splat4(-1.38888889e-3f));
+    cs = madd4(cs, a2, splat4(4.16666667e-2f));
+    cs = madd4(cs, a2, splat4(-0.5f));
+    cs = madd4(cs, a2, splat4(1.0f));
+
+    *s = select4(greater4(splat4(0), r), neg4(sn), sn);
+    *c = select4(folded, neg4(cs), cs);
+}
+
+#endif
+
+bool ParticleKernels::s_vectorized = ParticleKernels::isVectorSupported();
+
+ParticleKernels::Random::Random(uint32_t seed)
+{
+    // the lanes must not be shifted copies of the same sequence, scramble their seeds
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        uint32_t h = seed + 0x9e3779b9u * (i + 1);
+        h ^= h >> 16;
+        h *= 0x85ebca6bu;
+        h ^= h >> 13;
+        h *= 0xc2b2ae35u;
+        h ^= h >> 16;
+        seeds[i] = h;
+    }
+}
+
+bool ParticleKernels::isVectorSupported()
+{
+#ifdef PARTICLE_KERNELS_VECTOR
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ParticleKernels::setVectorized(bool vectorized)
+{
+    s_vectorized = vectorized && isVectorSupported();
+}
+
+void ParticleKernels::random(float* out, int count, float base, float variance, Random* rng, float minValue, float maxValue)
+{
+#ifdef PARTICLE_KERNELS_VECTOR
+    if (s_vectorized)
+    {
+        uint4 seeds = loadSeeds4(rng->seeds);
+        float4 vbase = splat4(base), vvariance = splat4(variance);
+        float4 vmin = splat4(minValue), vmax = splat4(maxValue);
+        for (int i = 0; i < count; i += 4)
+        {
+            seeds = nextSeeds4(seeds);
+            float4 value = madd4(vvariance, seedsToRandom4(seeds), vbase);
+            storeN(out + i, min4(max4(value, vmin), vmax), std::min(4, count - i));
+        }
+        storeSeeds4(rng->seeds, seeds);
+        return;
+    }
+#endif
+
+    for (int i = 0; i < count; i += 4)
+    {
+        // every lane moves on, even the ones past the end, to stay in step with the vector kernel
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            float value = base + variance * nextRandom(&rng->seeds[lane]);
+            if (i + lane < count)
+            {
+                out[i + lane] = clampf(value, minValue, maxValue);
+            }
+        }
+    }
+}
+
+void ParticleKernels::delta(float* endToDelta, const float* start, const float* timeToLive, int count)
+{
+#ifdef PARTICLE_KERNELS_VECTOR
+    if (s_vectorized)
+    {
+        for (int i = 0; i < count; i += 4)
+        {
+            int n = std::min(4, count - i);
+            float4 value = div4(sub4(loadN(endToDelta + i, n), loadN(start + i, n)), loadN(timeToLive + i, n));
+            storeN(endToDelta + i, value, n);
+        }
+        return;
+    }
+#endif
+
+    for (int i = 0; i < count; ++i)
+    {
+        endToDelta[i] = (endToDelta[i] - start[i]) / timeToLive[i];
+    }
+}
+
+void ParticleKernels::polarToCartesian(float* angleToX, float* lengthToY, int count)
+{
+#ifdef PARTICLE_KERNELS_VECTOR
+    if (s_vectorized)
+    {
+        for (int i = 0; i < count; i += 4)
+        {
+            int n = std::min(4, count - i);
+            float4 s, c;
+            sinCos4(loadN(angleToX + i, n), &s, &c);
+            float4 length = loadN(lengthToY + i, n);
+            storeN(angleToX + i, mul4(c, length), n);
+            storeN(lengthToY + i, mul4(s, length), n);
+        }
+        return;
+    }
+#endif
+
+    for (int i = 0; i < count; ++i)
+    {
+        float a = angleToX[i];
+        angleToX[i] = cosf(a) * lengthToY[i];
+        lengthToY[i] = sinf(a) * lengthToY[i];
+    }
+}
+
+void ParticleKernels::decrease(float* values, int count, float amount)
+{
+#ifdef PARTICLE_KERNELS_VECTOR
+    if (s_vectorized)
+    {
+        float4 vamount = splat4(amount);
+        for (int i = 0; i < count; i += 4)
+        {
+            int n = std::min(4, count - i);
+            storeN(values + i, sub4(loadN(values + i, n), vamount), n);
+        }
+        return;
+    }
+#endif
+
+    for (int i = 0; i < count; ++i)
+    {
+        values[i] -= amount;
+    }
+}
+
+void ParticleKernels::integrate(float* values, const float* deltas, int count, float dt, float minValue)
+{
+#ifdef PARTICLE_KERNELS_VECTOR
+    if (s_vectorized)
+    {
+        float4 vdt = splat4(dt), vmin = splat4(minValue);
+        for (int i = 0; i < count; i += 4)
+        {
+            int n = std::min(4, count - i);
+            float4 value = madd4(loadN(deltas + i, n), vdt, loadN(values + i, n));
+            storeN(values + i, max4(value, vmin), n);
+        }
+        return;
+    }
+#endif
+
+    for (int i = 0; i < count; ++i)
+    {
+        values[i] = MAX(values[i] + deltas[i] * dt, minValue);
+    }
+}
+
+void ParticleKernels::integrateGravity(ParticleData& data, int count, const Vec2& gravity, float dt, float yCoordFlipped)
+{
+#ifdef PARTICLE_KERNELS_VECTOR
+    if (s_vectorized)
+    {
+        float4 gx = splat4(gravity.x), gy = splat4(gravity.y);
+        float4 vdt = splat4(dt), move = splat4(dt * yCoordFlipped), zero = splat4(0);
+        for (int i = 0; i < count; i += 4)
+        {
+            int n = std::min(4, count - i);
+            float4 x = loadN(data.posx + i, n);
+            float4 y = loadN(data.posy + i, n);
+
+            // radial direction, zero at the origin
+            float4 lengthSq = madd4(x, x, mul4(y, y));
+            mask4 notOrigin = greater4(lengthSq, zero);
+            float4 invLength = invSqrt4(lengthSq);
+            float4 rx = select4(notOrigin, mul4(x, invLength), zero);
+            float4 ry = select4(notOrigin, mul4(y, invLength), zero);
+
+            // gravity + radial + tangential, the tangential direction is the radial one rotated by 90 degrees
+            float4 radialAccel = loadN(data.modeA.radialAccel + i, n);
+            float4 tangentialAccel = loadN(data.modeA.tangentialAccel + i, n);
+            float4 ax = sub4(madd4(rx, radialAccel, gx), mul4(ry, tangentialAccel));
+            float4 ay = madd4(rx, tangentialAccel, madd4(ry, radialAccel, gy));
+
+            float4 dirX = madd4(ax, vdt, loadN(data.modeA.dirX + i, n));
+            float4 dirY = madd4(ay, vdt, loadN(data.modeA.dirY + i, n));
+            storeN(data.modeA.dirX + i, dirX, n);
+            storeN(data.modeA.dirY + i, dirY, n);
+            storeN(data.posx + i, madd4(dirX, move, x), n);
+            storeN(data.posy + i, madd4(dirY, move, y), n);
+        }
+        return;
+    }
+#endif
+
+    for (int i = 0 ; i < count; ++i)
+    {
+        particle_point tmp, radial = {0.0f, 0.0f}, tangential;
+
+        // radial acceleration
+        normalizePoint(data.posx[i], data.posy[i], &radial);
+        tangential = radial;
+        radial.x *= data.modeA.radialAccel[i];
+        radial.y *= data.modeA.radialAccel[i];
+
+        // tangential acceleration
+        std::swap(tangential.x, tangential.y);
+        tangential.x *= - data.modeA.tangentialAccel[i];
+        tangential.y *= data.modeA.tangentialAccel[i];
+
+        // (gravity + radial + tangential) * dt
+        tmp.x = radial.x + tangential.x + gravity.x;
+        tmp.y = radial.y + tangential.y + gravity.y;
+        tmp.x *= dt;
+        tmp.y *= dt;
+
+        data.modeA.dirX[i] += tmp.x;
+        data.modeA.dirY[i] += tmp.y;
+
+        tmp.x = data.modeA.dirX[i] * dt * yCoordFlipped;
+        tmp.y = data.modeA.dirY[i] * dt * yCoordFlipped;
+        data.posx[i] += tmp.x;
+        data.posy[i] += tmp.y;
+    }
+}
+
+void ParticleKernels::integrateRadius(ParticleData& data, int count, float dt, float yCoordFlipped)
+{
+#ifdef PARTICLE_KERNELS_VECTOR
+    if (s_vectorized)
+    {
+        float4 vdt = splat4(dt), flip = splat4(-yCoordFlipped);
+        for (int i = 0; i < count; i += 4)
+        {
+            int n = std::min(4, count - i);
+            float4 angle = madd4(loadN(data.modeB.degreesPerSecond + i, n), vdt, loadN(data.modeB.angle + i, n));
+            float4 radius = madd4(loadN(data.modeB.deltaRadius + i, n), vdt, loadN(data.modeB.radius + i, n));
+            storeN(data.modeB.angle + i, angle, n);
+            storeN(data.modeB.radius + i, radius, n);
+
+            float4 s, c;
+            sinCos4(angle, &s, &c);
+            storeN(data.posx + i, neg4(mul4(c, radius)), n);
+            storeN(data.posy + i, mul4(mul4(s, radius), flip), n);
+        }
+        return;
+    }
+#endif
+
+    //Why use so many for-loop separately instead of putting them together?
+    //When the processor needs to read from or write to a location in memory,
+    //it first checks whether a copy of that data is in the cache.
+    //And every property's memory of the particle system is continuous,
+    //for the purpose of improving cache hit rate, we should process only one property in one for-loop AFAP.
+    //It was proved to be effective especially for low-end machine.
+    for (int i = 0; i < count; ++i)
+    {
+        data.modeB.angle[i] += data.modeB.degreesPerSecond[i] * dt;
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        data.modeB.radius[i] += data.modeB.deltaRadius[i] * dt;
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        data.posx[i] = - cosf(data.modeB.angle[i]) * data.modeB.radius[i];
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        data.posy[i] = - sinf(data.modeB.angle[i]) * data.modeB.radius[i] * yCoordFlipped;
+    }
+}
+
+void ParticleKernels::updateQuadVertices(V3F_C4B_T2F_Quad* quads, const ParticleData& data, int count, const Mat4& startTransform)
+{
+    const float* m = startTransform.m;
+
+#ifdef PARTICLE_KERNELS_VECTOR
+    if (s_vectorized)
+    {
+        float4 m0 = splat4(m[0]), m1 = splat4(m[1]), m4 = splat4(m[4]), m5 = splat4(m[5]);
+        float4 m12 = splat4(m[12]), m13 = splat4(m[13]);
+        float4 half = splat4(0.5f), toRadians = splat4(-CC_DEGREES_TO_RADIANS(1.0f));
+        for (int i = 0; i < count; i += 4)
+        {
+            int n = std::min(4, count - i);
+            float4 startX = loadN(data.startPosX + i, n);
+            float4 startY = loadN(data.startPosY + i, n);
+            float4 x = add4(loadN(data.posx + i, n), madd4(m0, startX, madd4(m4, startY, m12)));
+            float4 y = add4(loadN(data.posy + i, n), madd4(m1, startX, madd4(m5, startY, m13)));
+
+            float4 s, c;
+            sinCos4(mul4(loadN(data.rotation + i, n), toRadians), &s, &c);
+            float4 size = mul4(loadN(data.size + i, n), half);
+            float4 hc = mul4(size, c);
+            float4 hs = mul4(size, s);
+
+            // bl, br, tl, tr
+            float corners[8][4];
+            store4(corners[0], add4(x, sub4(hs, hc)));
+            store4(corners[1], sub4(y, add4(hs, hc)));
+            store4(corners[2], add4(x, add4(hc, hs)));
+            store4(corners[3], add4(y, sub4(hs, hc)));
+            store4(corners[4], sub4(x, add4(hc, hs)));
+            store4(corners[5], add4(y, sub4(hc, hs)));
+            store4(corners[6], add4(x, sub4(hc, hs)));
+            store4(corners[7], add4(y, add4(hs, hc)));
+
+            V3F_C4B_T2F_Quad* quad = quads + i;
+            for (int lane = 0; lane < n; ++lane, ++quad)
+            {
+                quad->bl.vertices.x = corners[0][lane];
+                quad->bl.vertices.y = corners[1][lane];
+                quad->br.vertices.x = corners[2][lane];
+                quad->br.vertices.y = corners[3][lane];
+                quad->tl.vertices.x = corners[4][lane];
+                quad->tl.vertices.y = corners[5][lane];
+                quad->tr.vertices.x = corners[6][lane];
+                quad->tr.vertices.y = corners[7][lane];
+            }
+        }
+        return;
+    }
+#endif
+
+    for (int i = 0; i < count; ++i)
+    {
+        float startX = data.startPosX[i];
+        float startY = data.startPosY[i];
+        float x = data.posx[i] + m[0] * startX + m[4] * startY + m[12];
+        float y = data.posy[i] + m[1] * startX + m[5] * startY + m[13];
+        updatePosWithParticle(quads + i, x, y, data.size[i], data.rotation[i]);
+    }
+}
+
+void ParticleKernels::updateQuadColors(V3F_C4B_T2F_Quad* quads, const ParticleData& data, int count, bool premultiplyAlpha)
+{
+#ifdef PARTICLE_KERNELS_VECTOR
+    if (s_vectorized)
+    {
+        float4 zero = splat4(0), full = splat4(255);
+        for (int i = 0; i < count; i += 4)
+        {
+            int n = std::min(4, count - i);
+            float4 a = mul4(loadN(data.colorA + i, n), full);
+            float4 scale = premultiplyAlpha ? a : full;
+
+            int32_t colors[4][4];
+            storeInt4(colors[0], min4(max4(mul4(loadN(data.colorR + i, n), scale), zero), full));
+            storeInt4(colors[1], min4(max4(mul4(loadN(data.colorG + i, n), scale), zero), full));
+            storeInt4(colors[2], min4(max4(mul4(loadN(data.colorB + i, n), scale), zero), full));
+            storeInt4(colors[3], min4(max4(a, zero), full));
+
+            for (int lane = 0; lane < n; ++lane)
+            {
+                setQuadColor(quads + i + lane, colors[0][lane], colors[1][lane], colors[2][lane], colors[3][lane]);
+            }
+        }
+        return;
+    }
+#endif
+
+    if (premultiplyAlpha)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            float a = data.colorA[i];
+            setQuadColor(quads + i, toColorByte(data.colorR[i] * a * 255), toColorByte(data.colorG[i] * a * 255),
+                         toColorByte(data.colorB[i] * a * 255), toColorByte(a * 255));
+        }
+    }
+    else
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            setQuadColor(quads + i, toColorByte(data.colorR[i] * 255), toColorByte(data.colorG[i] * 255),
+                         toColorByte(data.colorB[i] * 255), toColorByte(data.colorA[i] * 255));
+        }
+    }
+}
+
+NS_CC_END
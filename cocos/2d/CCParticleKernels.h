@@ -0,0 +1,116 @@
+/****************************************************************************
+Copyright (c) 2017-2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CC_PARTICLE_KERNELS_H__
+#define __CC_PARTICLE_KERNELS_H__
+
+#include <stdint.h>
+#include <float.h>
+
+#include "platform/CCPlatformMacros.h"
+#include "base/ccTypes.h"
+#include "math/Mat4.h"
+
+NS_CC_BEGIN
+
+class ParticleData;
+
+/// @cond DO_NOT_SHOW
+
+/**
+ * Loops over the ParticleData arrays used by ParticleSystem and ParticleSystemQuad.
+ *
+ * The kernels process four particles at a time with SSE2 or NEON when the target has them,
+ * and fall back to plain loops otherwise. The arrays don't need to be aligned nor padded.
+ * @since v3.18
+ * @js NA
+ * @lua NA
+ */
+class CC_DLL ParticleKernels
+{
+public:
+    /**
+     * Random number generator of the spawning kernels, four interleaved LCGs (the same
+     * generator as ParticleSystem used to call per attribute).
+     *
+     * The vector and scalar kernels produce the same numbers for the same seed.
+     */
+    struct Random
+    {
+        explicit Random(uint32_t seed);
+        uint32_t seeds[4];
+    };
+
+    /** Whether the kernels were built with SSE2 or NEON. */
+    static bool isVectorSupported();
+
+    /** Whether the vector kernels are used, true by default when they are supported. */
+    static bool isVectorized() { return s_vectorized; }
+
+    /**
+     * Switches between the vector and scalar kernels, e.g. to compare them in a benchmark.
+     * Ignored if the vector kernels aren't supported. Should be called between two frames.
+     */
+    static void setVectorized(bool vectorized);
+
+    /** out[i] = clamp(base + variance * random(-1, 1), minValue, maxValue) */
+    static void random(float* out, int count, float base, float variance, Random* rng,
+                       float minValue = -FLT_MAX, float maxValue = FLT_MAX);
+
+    /** endToDelta[i] = (endToDelta[i] - start[i]) / timeToLive[i] */
+    static void delta(float* endToDelta, const float* start, const float* timeToLive, int count);
+
+    /** Converts angles in radians and lengths to vectors, in place. */
+    static void polarToCartesian(float* angleToX, float* lengthToY, int count);
+
+    /** values[i] -= amount */
+    static void decrease(float* values, int count, float amount);
+
+    /** values[i] = max(values[i] + deltas[i] * dt, minValue) */
+    static void integrate(float* values, const float* deltas, int count, float dt, float minValue = -FLT_MAX);
+
+    /** Moves the first count particles of a gravity mode system. */
+    static void integrateGravity(ParticleData& data, int count, const Vec2& gravity, float dt, float yCoordFlipped);
+
+    /** Moves the first count particles of a radius mode system. */
+    static void integrateRadius(ParticleData& data, int count, float dt, float yCoordFlipped);
+
+    /**
+     * Updates the vertices of the quads of the first count particles. A quad is centered on the
+     * particle position plus its start position transformed by startTransform (with z = 0).
+     */
+    static void updateQuadVertices(V3F_C4B_T2F_Quad* quads, const ParticleData& data, int count, const Mat4& startTransform);
+
+    /** Updates the colors of the quads of the first count particles. */
+    static void updateQuadColors(V3F_C4B_T2F_Quad* quads, const ParticleData& data, int count, bool premultiplyAlpha);
+
+private:
+    static bool s_vectorized;
+};
+
+/// @endcond
+
+NS_CC_END
+
+#endif // __CC_PARTICLE_KERNELS_H__
@@ -46,12 +46,19 @@ THE SOFTWARE.
 #include "2d/CCParticleSystem.h"
 
 #include <string>
+#include <algorithm>
+#include <memory>
 
 #include "2d/CCParticleBatchNode.h"
+#include "2d/CCParticleKernels.h"
+#include "2d/CCParticleDefinition.h"
 #include "renderer/CCTextureAtlas.h"
 #include "base/base64.h"
 #include "base/ZipUtils.h"
 #include "base/CCDirector.h"
+#include "base/CCEventDispatcher.h"
+#include "base/CCEventListenerCustom.h"
+#include "base/CCAsyncTaskPool.h"
 #include "base/CCProfiling.h"
 #include "base/ccUTF8.h"
 #include "renderer/CCTextureCache.h"
@@ -79,36 +86,6 @@ NS_CC_BEGIN
 //
 
 
-inline void normalize_point(float x, float y, particle_point* out)
-{
-    float n = x * x + y * y;
-    // Already normalized.
-    if (n == 1.0f)
-        return;
-    
-    n = sqrt(n);
-    // Too close to zero.
-    if (n < MATH_TOLERANCE)
-        return;
-    
-    n = 1.0f / n;
-    out->x = x * n;
-    out->y = y * n;
-}
-
-/**
- A more effect random number getter function, get from ejoy2d.
- */
-inline static float RANDOM_M11(unsigned int *seed) {
-    *seed = *seed * 134775813 + 1;
-    union {
-        uint32_t d;                                     
-        float f;
-    } u;
-    u.d = (((uint32_t)(*seed) & 0x7fff) << 8) | 0x40000000;
-    return u.f - 3.0f;
-}
-
 ParticleData::ParticleData()
 {
     memset(this, 0, sizeof(ParticleData));
@@ -188,6 +165,31 @@ void ParticleData::release()
 
 Vector<ParticleSystem*> ParticleSystem::__allInstances;
 float ParticleSystem::__totalParticleCountFactor = 1.0f;
+bool ParticleSystem::__parallelSimulation = true;
+Vector<ParticleSystem*> ParticleSystem::__pendingSystems;
+
+// the pending systems are simulated by groups of about this many particles
+static const int PARTICLES_PER_SIMULATION_JOB = 2048;
+
+static EventListenerCustom* __afterUpdateListener = nullptr;
+
+// the pending systems are simulated once the scheduler is done, before the listeners of the user
+static void listenAfterUpdate()
+{
+    if (__afterUpdateListener)
+        return;
+
+    auto dispatcher = Director::getInstance()->getEventDispatcher();
+    __afterUpdateListener = EventListenerCustom::create(Director::EVENT_AFTER_UPDATE, [](EventCustom*) {
+        ParticleSystem::simulatePendingSystems();
+    });
+    dispatcher->addEventListenerWithFixedPriority(__afterUpdateListener, -1);
+    // the director removes all the listeners when it is reset, the systems left are simulated first
+    dispatcher->addCustomEventListener(Director::EVENT_RESET, [](EventCustom*) {
+        ParticleSystem::simulatePendingSystems();
+        __afterUpdateListener = nullptr;
+    });
+}
 
 ParticleSystem::ParticleSystem()
 : _isBlendAdditive(false)
@@ -225,6 +227,10 @@ ParticleSystem::ParticleSystem()
 , _positionType(PositionType::FREE)
 , _paused(false)
 , _sourcePositionCompatible(true) // In the furture this member's default value maybe false or be removed.
+, _pendingDeltaTime(0)
+, _simulationPending(false)
+, _queuedForSimulation(false)
+, _isDestroyed(std::make_shared<bool>(false))
 {
     modeA.gravity.setZero();
     modeA.speed = 0;
@@ -273,6 +279,63 @@ Vector<ParticleSystem*>& ParticleSystem::getAllParticleSystems()
     return __allInstances;
 }
 
+void ParticleSystem::setParallelSimulationEnabled(bool enabled)
+{
+    __parallelSimulation = enabled;
+}
+
+bool ParticleSystem::isParallelSimulationEnabled()
+{
+    return __parallelSimulation;
+}
+
+void ParticleSystem::simulatePendingSystems()
+{
+    if (__pendingSystems.empty())
+        return;
+
+    // finishing a system may remove it, which mustn't touch the list being walked
+    auto systems = std::move(__pendingSystems);
+    __pendingSystems.clear();
+
+    // The systems are simulated by groups of about the same number of particles, claimed by this thread
+    // and by the workers.
+    std::vector<size_t> groupEnds;
+    std::vector<char> finished(systems.size(), 0);
+    int particles = 0;
+    for (size_t i = 0; i < systems.size(); ++i)
+    {
+        particles += systems.at(i)->_particleCount;
+        if (particles >= PARTICLES_PER_SIMULATION_JOB || i + 1 == systems.size())
+        {
+            groupEnds.push_back(i + 1);
+            particles = 0;
+        }
+    }
+
+    AsyncTaskPool::getInstance()->parallelFor(groupEnds.size(), 1, [&](size_t beginGroup, size_t endGroup) {
+        for (size_t i = beginGroup > 0 ? groupEnds[beginGroup - 1] : 0; i < groupEnds[endGroup - 1]; ++i)
+        {
+            auto system = systems.at(i);
+            if (system->_simulationPending)
+            {
+                finished[i] = system->simulate(system->_pendingDeltaTime);
+            }
+        }
+    });
+
+    for (size_t i = 0; i < systems.size(); ++i)
+    {
+        auto system = systems.at(i);
+        system->_queuedForSimulation = false;
+        if (system->_simulationPending)
+        {
+            system->_simulationPending = false;
+            system->finishUpdate(finished[i] != 0);
+        }
+    }
+}
+
 void ParticleSystem::setTotalParticleCountFactor(float factor)
 {
     __totalParticleCountFactor = factor;
@@ -287,20 +350,33 @@ bool ParticleSystem::initWithFile(const std::string& plistFile)
 {
     bool ret = false;
     _plistFile = FileUtils::getInstance()->fullPathForFilename(plistFile);
-    ValueMap dict = FileUtils::getInstance()->getValueMapFromFile(_plistFile);
+    Data data = FileUtils::getInstance()->getDataFromFile(_plistFile);
 
-    CCASSERT( !dict.empty(), "Particles: file not found");
+    CCASSERT( !data.isNull(), "Particles: file not found");
     
     // FIXME: compute path from a path, should define a function somewhere to do it
     string listFilePath = plistFile;
     if (listFilePath.find('/') != string::npos)
     {
         listFilePath = listFilePath.substr(0, listFilePath.rfind('/') + 1);
-        ret = this->initWithDictionary(dict, listFilePath);
     }
     else
     {
-        ret = this->initWithDictionary(dict, "");
+        listFilePath = "";
+    }
+
+    // binary definitions are decoded without parsing and bind their texture lazily
+    if (ParticleDefinition::isBinary(data.getBytes(), data.getSize()))
+    {
+        ParticleDefinition definition;
+        ret = definition.initWithBinary(data.getBytes(), data.getSize())
+            && this->initWithDefinition(definition, listFilePath, true);
+    }
+    else
+    {
+        ValueMap dict = FileUtils::getInstance()->getValueMapFromData((const char*)data.getBytes(), (int)data.getSize());
+        CCASSERT( !dict.empty(), "Particles: file not found");
+        ret = this->initWithDictionary(dict, listFilePath);
     }
     
     return ret;
@@ -313,242 +389,260 @@ bool ParticleSystem::initWithDictionary(ValueMap& dictionary)
 
 bool ParticleSystem::initWithDictionary(ValueMap& dictionary, const std::string& dirname)
 {
-    bool ret = false;
-    unsigned char *buffer = nullptr;
-    unsigned char *deflated = nullptr;
-    Image *image = nullptr;
-    do 
+    ParticleDefinition definition;
+    return definition.initWithDictionary(dictionary) && initWithDefinition(definition, dirname, false);
+}
+
+bool ParticleSystem::initWithDefinition(const ParticleDefinition& definition, const std::string& dirname, bool lazyTexture)
+{
+    // self, not super
+    if (!this->initWithTotalParticles(definition.maxParticles))
+        return false;
+
+    // Emitter name in particle designer 2.0
+    _configName = definition.configName;
+
+    // angle
+    _angle = definition.angle;
+    _angleVar = definition.angleVar;
+
+    // duration
+    _duration = definition.duration;
+
+    // blend function 
+    _blendFunc = definition.blendFunc;
+
+    // color
+    _startColor = definition.startColor;
+    _startColorVar = definition.startColorVar;
+    _endColor = definition.endColor;
+    _endColorVar = definition.endColorVar;
+
+    // particle size
+    _startSize = definition.startSize;
+    _startSizeVar = definition.startSizeVar;
+    _endSize = definition.endSize;
+    _endSizeVar = definition.endSizeVar;
+
+    // position
+    if(!_sourcePositionCompatible) {
+        this->setSourcePosition(definition.sourcePosition);
+    }
+    else {
+        this->setPosition(definition.sourcePosition);
+    }
+    _posVar = definition.posVar;
+
+    // Spinning
+    _startSpin = definition.startSpin;
+    _startSpinVar = definition.startSpinVar;
+    _endSpin = definition.endSpin;
+    _endSpinVar = definition.endSpinVar;
+
+    _emitterMode = (Mode) definition.emitterMode;
+
+    // Mode A: Gravity + tangential accel + radial accel
+    if (_emitterMode == Mode::GRAVITY)
     {
-        int maxParticles = dictionary["maxParticles"].asInt();
-        // self, not super
-        if(this->initWithTotalParticles(maxParticles))
-        {
-            // Emitter name in particle designer 2.0
-            _configName = dictionary["configName"].asString();
+        modeA.gravity = definition.gravity;
+        modeA.speed = definition.speed;
+        modeA.speedVar = definition.speedVar;
+        modeA.radialAccel = definition.radialAccel;
+        modeA.radialAccelVar = definition.radialAccelVar;
+        modeA.tangentialAccel = definition.tangentialAccel;
+        modeA.tangentialAccelVar = definition.tangentialAccelVar;
+        modeA.rotationIsDir = definition.rotationIsDir;
+    }
 
-            // angle
-            _angle = dictionary["angle"].asFloat();
-            _angleVar = dictionary["angleVariance"].asFloat();
+    // or Mode B: radius movement
+    else if (_emitterMode == Mode::RADIUS)
+    {
+        modeB.startRadius = definition.startRadius;
+        modeB.startRadiusVar = definition.startRadiusVar;
+        modeB.endRadius = definition.endRadius;
+        modeB.endRadiusVar = definition.endRadiusVar;
+        modeB.rotatePerSecond = definition.rotatePerSecond;
+        modeB.rotatePerSecondVar = definition.rotatePerSecondVar;
+    } else {
+        CCASSERT( false, "Invalid emitterType in config file");
+        return false;
+    }
+
+    // life span
+    _life = definition.life;
+    _lifeVar = definition.lifeVar;
 
-            // duration
-            _duration = dictionary["duration"].asFloat();
+    // emission Rate
+    _emissionRate = _totalParticles / _life;
 
-            // blend function 
-            if (!_configName.empty())
+    //don't get the internal texture if a batchNode is used
+    if (!_batchNode)
+    {
+        // Set a compatible default for the alpha transfer
+        _opacityModifyRGB = false;
+
+        // texture        
+        // Try to get the texture from the cache
+        std::string textureName = definition.textureFileName;
+        
+        size_t rPos = textureName.rfind('/');
+       
+        if (rPos != string::npos)
+        {
+            string textureDir = textureName.substr(0, rPos + 1);
+            
+            if (!dirname.empty() && textureDir != dirname)
             {
-                _blendFunc.src = dictionary["blendFuncSource"].asFloat();
+                textureName = textureName.substr(rPos+1);
+                textureName = dirname + textureName;
             }
-            else
+        }
+        else if (!dirname.empty() && !textureName.empty())
+        {
+        	textureName = dirname + textureName;
+        }
+
+        if (lazyTexture)
+        {
+            loadTextureAsync(textureName, definition);
+        }
+        else
+        {
+            Texture2D *tex = nullptr;
+
+            if (!textureName.empty())
             {
-                _blendFunc.src = dictionary["blendFuncSource"].asInt();
+                // set not pop-up message box when load image failed
+                bool notify = FileUtils::getInstance()->isPopupNotify();
+                FileUtils::getInstance()->setPopupNotify(false);
+                tex = Director::getInstance()->getTextureCache()->addImage(textureName);
+                // reset the value of UIImage notify
+                FileUtils::getInstance()->setPopupNotify(notify);
             }
-            _blendFunc.dst = dictionary["blendFuncDestination"].asInt();
-
-            // color
-            _startColor.r = dictionary["startColorRed"].asFloat();
-            _startColor.g = dictionary["startColorGreen"].asFloat();
-            _startColor.b = dictionary["startColorBlue"].asFloat();
-            _startColor.a = dictionary["startColorAlpha"].asFloat();
-
-            _startColorVar.r = dictionary["startColorVarianceRed"].asFloat();
-            _startColorVar.g = dictionary["startColorVarianceGreen"].asFloat();
-            _startColorVar.b = dictionary["startColorVarianceBlue"].asFloat();
-            _startColorVar.a = dictionary["startColorVarianceAlpha"].asFloat();
-
-            _endColor.r = dictionary["finishColorRed"].asFloat();
-            _endColor.g = dictionary["finishColorGreen"].asFloat();
-            _endColor.b = dictionary["finishColorBlue"].asFloat();
-            _endColor.a = dictionary["finishColorAlpha"].asFloat();
-
-            _endColorVar.r = dictionary["finishColorVarianceRed"].asFloat();
-            _endColorVar.g = dictionary["finishColorVarianceGreen"].asFloat();
-            _endColorVar.b = dictionary["finishColorVarianceBlue"].asFloat();
-            _endColorVar.a = dictionary["finishColorVarianceAlpha"].asFloat();
-
-            // particle size
-            _startSize = dictionary["startParticleSize"].asFloat();
-            _startSizeVar = dictionary["startParticleSizeVariance"].asFloat();
-            _endSize = dictionary["finishParticleSize"].asFloat();
-            _endSizeVar = dictionary["finishParticleSizeVariance"].asFloat();
-
-            // position
-            float x = dictionary["sourcePositionx"].asFloat();
-            float y = dictionary["sourcePositiony"].asFloat();
-	    if(!_sourcePositionCompatible) {
-                this->setSourcePosition(Vec2(x, y));
-	    }
-            else {
-		this->setPosition(Vec2(x, y));
-	    }
-            _posVar.x = dictionary["sourcePositionVariancex"].asFloat();
-            _posVar.y = dictionary["sourcePositionVariancey"].asFloat();
-
-            // Spinning
-            _startSpin = dictionary["rotationStart"].asFloat();
-            _startSpinVar = dictionary["rotationStartVariance"].asFloat();
-            _endSpin= dictionary["rotationEnd"].asFloat();
-            _endSpinVar= dictionary["rotationEndVariance"].asFloat();
-
-            _emitterMode = (Mode) dictionary["emitterType"].asInt();
-
-            // Mode A: Gravity + tangential accel + radial accel
-            if (_emitterMode == Mode::GRAVITY)
+
+            if (tex)
             {
-                // gravity
-                modeA.gravity.x = dictionary["gravityx"].asFloat();
-                modeA.gravity.y = dictionary["gravityy"].asFloat();
-
-                // speed
-                modeA.speed = dictionary["speed"].asFloat();
-                modeA.speedVar = dictionary["speedVariance"].asFloat();
-
-                // radial acceleration
-                modeA.radialAccel = dictionary["radialAcceleration"].asFloat();
-                modeA.radialAccelVar = dictionary["radialAccelVariance"].asFloat();
-
-                // tangential acceleration
-                modeA.tangentialAccel = dictionary["tangentialAcceleration"].asFloat();
-                modeA.tangentialAccelVar = dictionary["tangentialAccelVariance"].asFloat();
-                
-                // rotation is dir
-                modeA.rotationIsDir = dictionary["rotationIsDir"].asBool();
+                setTexture(tex);
             }
+            else if (!definition.textureImageData.empty())
+            {
+                Image* image = createEmbeddedImage(definition);
+                if (!image)
+                    return false;
 
-            // or Mode B: radius movement
-            else if (_emitterMode == Mode::RADIUS)
+                // For android, we should retain it in VolatileTexture::addImage which invoked in Director::getInstance()->getTextureCache()->addUIImage()
+                setTexture(Director::getInstance()->getTextureCache()->addImage(image, _plistFile + textureName));
+                image->release();
+            }
+            else
             {
-                if (!_configName.empty())
-                {
-                    modeB.startRadius = dictionary["maxRadius"].asInt();
-                }
-                else
-                {
-                    modeB.startRadius = dictionary["maxRadius"].asFloat();
-                }
-                modeB.startRadiusVar = dictionary["maxRadiusVariance"].asFloat();
-                if (!_configName.empty())
-                {
-                    modeB.endRadius = dictionary["minRadius"].asInt();
-                }
-                else
-                {
-                    modeB.endRadius = dictionary["minRadius"].asFloat();
-                }
-                
-                if (dictionary.find("minRadiusVariance") != dictionary.end())
-                {
-                    modeB.endRadiusVar = dictionary["minRadiusVariance"].asFloat();
-                }
-                else
-                {
-                    modeB.endRadiusVar = 0.0f;
-                }
-                
-                if (!_configName.empty())
-                {
-                    modeB.rotatePerSecond = dictionary["rotatePerSecond"].asInt();
-                }
-                else
-                {
-                    modeB.rotatePerSecond = dictionary["rotatePerSecond"].asFloat();
-                }
-                modeB.rotatePerSecondVar = dictionary["rotatePerSecondVariance"].asFloat();
-
-            } else {
-                CCASSERT( false, "Invalid emitterType in config file");
-                CC_BREAK_IF(true);
+                CCASSERT(!definition.textureImageDataEncoded, "textureData can't be empty!");
             }
 
-            // life span
-            _life = dictionary["particleLifespan"].asFloat();
-            _lifeVar = dictionary["particleLifespanVariance"].asFloat();
+            if( !this->_texture)
+                CCLOGWARN("cocos2d: Warning: ParticleSystemQuad system without a texture");
+        }
 
-            // emission Rate
-            _emissionRate = _totalParticles / _life;
+        _yCoordFlipped = definition.yCoordFlipped;
+    }
+    return true;
+}
 
-            //don't get the internal texture if a batchNode is used
-            if (!_batchNode)
-            {
-                // Set a compatible default for the alpha transfer
-                _opacityModifyRGB = false;
-
-                // texture        
-                // Try to get the texture from the cache
-                std::string textureName = dictionary["textureFileName"].asString();
-                
-                size_t rPos = textureName.rfind('/');
-               
-                if (rPos != string::npos)
-                {
-                    string textureDir = textureName.substr(0, rPos + 1);
-                    
-                    if (!dirname.empty() && textureDir != dirname)
-                    {
-                        textureName = textureName.substr(rPos+1);
-                        textureName = dirname + textureName;
-                    }
-                }
-                else if (!dirname.empty() && !textureName.empty())
-                {
-                	textureName = dirname + textureName;
-                }
-                
-                Texture2D *tex = nullptr;
-                
-                if (!textureName.empty())
-                {
-                    // set not pop-up message box when load image failed
-                    bool notify = FileUtils::getInstance()->isPopupNotify();
-                    FileUtils::getInstance()->setPopupNotify(false);
-                    tex = Director::getInstance()->getTextureCache()->addImage(textureName);
-                    // reset the value of UIImage notify
-                    FileUtils::getInstance()->setPopupNotify(notify);
-                }
-                
-                if (tex)
-                {
-                    setTexture(tex);
-                }
-                else if( dictionary.find("textureImageData") != dictionary.end() )
-                {                        
-                    std::string textureData = dictionary.at("textureImageData").asString();
-                    CCASSERT(!textureData.empty(), "textureData can't be empty!");
-                    
-                    auto dataLen = textureData.size();
-                    if (dataLen != 0)
-                    {
-                        // if it fails, try to get it from the base64-gzipped data    
-                        int decodeLen = base64Decode((unsigned char*)textureData.c_str(), (unsigned int)dataLen, &buffer);
-                        CCASSERT( buffer != nullptr, "CCParticleSystem: error decoding textureImageData");
-                        CC_BREAK_IF(!buffer);
-                        
-                        ssize_t deflatedLen = ZipUtils::inflateMemory(buffer, decodeLen, &deflated);
-                        CCASSERT( deflated != nullptr, "CCParticleSystem: error ungzipping textureImageData");
-                        CC_BREAK_IF(!deflated);
-                        
-                        // For android, we should retain it in VolatileTexture::addImage which invoked in Director::getInstance()->getTextureCache()->addUIImage()
-                        image = new (std::nothrow) Image();
-                        bool isOK = image->initWithImageData(deflated, deflatedLen);
-                        CCASSERT(isOK, "CCParticleSystem: error init image with Data");
-                        CC_BREAK_IF(!isOK);
-                        
-                        setTexture(Director::getInstance()->getTextureCache()->addImage(image, _plistFile + textureName));
-
-                        image->release();
-                    }
-                }
-                
-                _yCoordFlipped = dictionary.find("yCoordFlipped") == dictionary.end() ? 1 : dictionary.at("yCoordFlipped").asInt();
-
-                if( !this->_texture)
-                    CCLOGWARN("cocos2d: Warning: ParticleSystemQuad system without a texture");
-            }
-            ret = true;
+Image* ParticleSystem::createEmbeddedImage(const ParticleDefinition& definition)
+{
+    const std::string& textureData = definition.textureImageData;
+    unsigned char *buffer = nullptr;
+    unsigned char *deflated = nullptr;
+    const unsigned char* imageData = (const unsigned char*)textureData.data();
+    ssize_t imageSize = (ssize_t)textureData.size();
+    Image *image = nullptr;
+    do
+    {
+        if (definition.textureImageDataEncoded)
+        {
+            // if it fails, try to get it from the base64-gzipped data    
+            int decodeLen = base64Decode((unsigned char*)textureData.c_str(), (unsigned int)textureData.size(), &buffer);
+            CCASSERT( buffer != nullptr, "CCParticleSystem: error decoding textureImageData");
+            CC_BREAK_IF(!buffer);
+            
+            imageSize = ZipUtils::inflateMemory(buffer, decodeLen, &deflated);
+            CCASSERT( deflated != nullptr, "CCParticleSystem: error ungzipping textureImageData");
+            CC_BREAK_IF(!deflated);
+            imageData = deflated;
+        }
+
+        image = new (std::nothrow) Image();
+        bool isOK = image->initWithImageData(imageData, imageSize);
+        CCASSERT(isOK, "CCParticleSystem: error init image with Data");
+        if (!isOK)
+        {
+            CC_SAFE_RELEASE_NULL(image);
         }
     } while (0);
     free(buffer);
     free(deflated);
-    return ret;
+    return image;
+}
+
+void ParticleSystem::loadTextureAsync(const std::string& textureName, const ParticleDefinition& definition)
+{
+    auto textureCache = Director::getInstance()->getTextureCache();
+    std::string imageKey = _plistFile + textureName;
+
+    // already loaded textures are bound right away
+    Texture2D* texture = textureName.empty() ? nullptr : textureCache->getTextureForKey(textureName);
+    if (!texture && !definition.textureImageData.empty())
+        texture = textureCache->getTextureForKey(imageKey);
+    if (texture)
+    {
+        setTexture(texture);
+        return;
+    }
+
+    // the system is drawn once the texture is set. It isn't retained, the callbacks may never run,
+    // e.g. after TextureCache::unbindImageAsync() or a purge of the cache, and are skipped once it is destroyed
+    auto embedded = std::make_shared<ParticleDefinition>();
+    embedded->textureImageData = definition.textureImageData;
+    embedded->textureImageDataEncoded = definition.textureImageDataEncoded;
+    std::shared_ptr<bool> isDestroyed = _isDestroyed;
+    auto loadEmbeddedImage = [this, isDestroyed, embedded, imageKey]() {
+        if (embedded->textureImageData.empty())
+        {
+            CCLOGWARN("cocos2d: Warning: ParticleSystemQuad system without a texture");
+            return;
+        }
+
+        auto image = std::make_shared<Image*>(nullptr);
+        AsyncTaskPool::getInstance()->submit([embedded, image]() {
+            *image = createEmbeddedImage(*embedded);
+        }, [this, isDestroyed, image, imageKey]() {
+            if (*image)
+            {
+                Texture2D* texture = Director::getInstance()->getTextureCache()->addImage(*image, imageKey);
+                (*image)->release();
+                if (!*isDestroyed && !_texture)
+                    setTexture(texture);
+            }
+        });
+    };
+
+    if (textureName.empty())
+    {
+        loadEmbeddedImage();
+        return;
+    }
+
+    textureCache->addImageAsync(textureName, [this, isDestroyed, loadEmbeddedImage](Texture2D* loaded) {
+        if (*isDestroyed)
+            return;
+        if (!loaded)
+        {
+            loadEmbeddedImage();
+            return;
+        }
+        if (!_texture)
+            setTexture(loaded);
+    });
 }
 
 bool ParticleSystem::initWithTotalParticles(int numberOfParticles)
@@ -606,97 +700,62 @@ ParticleSystem::~ParticleSystem()
     //unscheduleUpdate();
     _particleData.release();
     CC_SAFE_RELEASE(_texture);
+    *_isDestroyed = true;
 }
 
 void ParticleSystem::addParticles(int count)
 {
     if (_paused)
         return;
-    uint32_t RANDSEED = rand();
+    ParticleKernels::Random rng(rand());
 
     int start = _particleCount;
     _particleCount += count;
+
+    // the kernels only touch the new particles
+    auto& data = _particleData;
+    float* timeToLive = data.timeToLive + start;
     
     //life
-    for (int i = start; i < _particleCount ; ++i)
-    {
-        float theLife = _life + _lifeVar * RANDOM_M11(&RANDSEED);
-        _particleData.timeToLive[i] = MAX(0, theLife);
-    }
+    ParticleKernels::random(timeToLive, count, _life, _lifeVar, &rng, 0);
     
     //position
-    for (int i = start; i < _particleCount; ++i)
-    {
-        _particleData.posx[i] = _sourcePosition.x + _posVar.x * RANDOM_M11(&RANDSEED);
-    }
-    
-    for (int i = start; i < _particleCount; ++i)
-    {
-        _particleData.posy[i] = _sourcePosition.y + _posVar.y * RANDOM_M11(&RANDSEED);
-    }
+    ParticleKernels::random(data.posx + start, count, _sourcePosition.x, _posVar.x, &rng);
+    ParticleKernels::random(data.posy + start, count, _sourcePosition.y, _posVar.y, &rng);
     
     //color
-#define SET_COLOR(c, b, v)\
-for (int i = start; i < _particleCount; ++i)\
-{\
-c[i] = clampf( b + v * RANDOM_M11(&RANDSEED) , 0 , 1 );\
-}
+    ParticleKernels::random(data.colorR + start, count, _startColor.r, _startColorVar.r, &rng, 0, 1);
+    ParticleKernels::random(data.colorG + start, count, _startColor.g, _startColorVar.g, &rng, 0, 1);
+    ParticleKernels::random(data.colorB + start, count, _startColor.b, _startColorVar.b, &rng, 0, 1);
+    ParticleKernels::random(data.colorA + start, count, _startColor.a, _startColorVar.a, &rng, 0, 1);
     
-    SET_COLOR(_particleData.colorR, _startColor.r, _startColorVar.r);
-    SET_COLOR(_particleData.colorG, _startColor.g, _startColorVar.g);
-    SET_COLOR(_particleData.colorB, _startColor.b, _startColorVar.b);
-    SET_COLOR(_particleData.colorA, _startColor.a, _startColorVar.a);
+    ParticleKernels::random(data.deltaColorR + start, count, _endColor.r, _endColorVar.r, &rng, 0, 1);
+    ParticleKernels::random(data.deltaColorG + start, count, _endColor.g, _endColorVar.g, &rng, 0, 1);
+    ParticleKernels::random(data.deltaColorB + start, count, _endColor.b, _endColorVar.b, &rng, 0, 1);
+    ParticleKernels::random(data.deltaColorA + start, count, _endColor.a, _endColorVar.a, &rng, 0, 1);
     
-    SET_COLOR(_particleData.deltaColorR, _endColor.r, _endColorVar.r);
-    SET_COLOR(_particleData.deltaColorG, _endColor.g, _endColorVar.g);
-    SET_COLOR(_particleData.deltaColorB, _endColor.b, _endColorVar.b);
-    SET_COLOR(_particleData.deltaColorA, _endColor.a, _endColorVar.a);
-    
-#define SET_DELTA_COLOR(c, dc)\
-for (int i = start; i < _particleCount; ++i)\
-{\
-dc[i] = (dc[i] - c[i]) / _particleData.timeToLive[i];\
-}
-    
-    SET_DELTA_COLOR(_particleData.colorR, _particleData.deltaColorR);
-    SET_DELTA_COLOR(_particleData.colorG, _particleData.deltaColorG);
-    SET_DELTA_COLOR(_particleData.colorB, _particleData.deltaColorB);
-    SET_DELTA_COLOR(_particleData.colorA, _particleData.deltaColorA);
+    ParticleKernels::delta(data.deltaColorR + start, data.colorR + start, timeToLive, count);
+    ParticleKernels::delta(data.deltaColorG + start, data.colorG + start, timeToLive, count);
+    ParticleKernels::delta(data.deltaColorB + start, data.colorB + start, timeToLive, count);
+    ParticleKernels::delta(data.deltaColorA + start, data.colorA + start, timeToLive, count);
     
     //size
-    for (int i = start; i < _particleCount; ++i)
-    {
-        _particleData.size[i] = _startSize + _startSizeVar * RANDOM_M11(&RANDSEED);
-        _particleData.size[i] = MAX(0, _particleData.size[i]);
-    }
+    ParticleKernels::random(data.size + start, count, _startSize, _startSizeVar, &rng, 0);
     
     if (_endSize != START_SIZE_EQUAL_TO_END_SIZE)
     {
-        for (int i = start; i < _particleCount; ++i)
-        {
-            float endSize = _endSize + _endSizeVar * RANDOM_M11(&RANDSEED);
-            endSize = MAX(0, endSize);
-            _particleData.deltaSize[i] = (endSize - _particleData.size[i]) / _particleData.timeToLive[i];
-        }
+        ParticleKernels::random(data.deltaSize + start, count, _endSize, _endSizeVar, &rng, 0);
+        ParticleKernels::delta(data.deltaSize + start, data.size + start, timeToLive, count);
     }
     else
     {
-        for (int i = start; i < _particleCount; ++i)
-        {
-            _particleData.deltaSize[i] = 0.0f;
-        }
+        std::fill_n(data.deltaSize + start, count, 0.0f);
     }
     
     // rotation
-    for (int i = start; i < _particleCount; ++i)
-    {
-        _particleData.rotation[i] = _startSpin + _startSpinVar * RANDOM_M11(&RANDSEED);
-    }
-    for (int i = start; i < _particleCount; ++i)
-    {
-        float endA = _endSpin + _endSpinVar * RANDOM_M11(&RANDSEED);
-        _particleData.deltaRotation[i] = (endA - _particleData.rotation[i]) / _particleData.timeToLive[i];
-    }
+    ParticleKernels::random(data.rotation + start, count, _startSpin, _startSpinVar, &rng);
+    ParticleKernels::random(data.deltaRotation + start, count, _endSpin, _endSpinVar, &rng);
+    ParticleKernels::delta(data.deltaRotation + start, data.rotation + start, timeToLive, count);
     
     // position
     Vec2 pos;
@@ -708,55 +767,31 @@ dc[i] = (dc[i] - c[i]) / _particleData.timeToLive[i];\
     {
         pos = _position;
     }
-    for (int i = start; i < _particleCount; ++i)
-    {
-        _particleData.startPosX[i] = pos.x;
-    }
-    for (int i = start; i < _particleCount; ++i)
-    {
-        _particleData.startPosY[i] = pos.y;
-    }
+    std::fill_n(data.startPosX + start, count, pos.x);
+    std::fill_n(data.startPosY + start, count, pos.y);
     
     // Mode Gravity: A
     if (_emitterMode == Mode::GRAVITY)
     {
         
         // radial accel
-        for (int i = start; i < _particleCount; ++i)
-        {
-            _particleData.modeA.radialAccel[i] = modeA.radialAccel + modeA.radialAccelVar * RANDOM_M11(&RANDSEED);
-        }
+        ParticleKernels::random(data.modeA.radialAccel + start, count, modeA.radialAccel, modeA.radialAccelVar, &rng);
         
         // tangential accel
-        for (int i = start; i < _particleCount; ++i)
-        {
-            _particleData.modeA.tangentialAccel[i] = modeA.tangentialAccel + modeA.tangentialAccelVar * RANDOM_M11(&RANDSEED);
-        }
+        ParticleKernels::random(data.modeA.tangentialAccel + start, count, modeA.tangentialAccel, modeA.tangentialAccelVar, &rng);
+        
+        // direction: angle and speed, converted to a vector in place
+        ParticleKernels::random(data.modeA.dirX + start, count, CC_DEGREES_TO_RADIANS(_angle), CC_DEGREES_TO_RADIANS(_angleVar), &rng);
+        ParticleKernels::random(data.modeA.dirY + start, count, modeA.speed, modeA.speedVar, &rng);
+        ParticleKernels::polarToCartesian(data.modeA.dirX + start, data.modeA.dirY + start, count);
         
         // rotation is dir
         if( modeA.rotationIsDir )
         {
             for (int i = start; i < _particleCount; ++i)
             {
-                float a = CC_DEGREES_TO_RADIANS( _angle + _angleVar * RANDOM_M11(&RANDSEED) );
-                Vec2 v(cosf( a ), sinf( a ));
-                float s = modeA.speed + modeA.speedVar * RANDOM_M11(&RANDSEED);
-                Vec2 dir = v * s;
-                _particleData.modeA.dirX[i] = dir.x;//v * s ;
-                _particleData.modeA.dirY[i] = dir.y;
-                _particleData.rotation[i] = -CC_RADIANS_TO_DEGREES(dir.getAngle());
-            }
-        }
-        else
-        {
-            for (int i = start; i < _particleCount; ++i)
-            {
-                float a = CC_DEGREES_TO_RADIANS( _angle + _angleVar * RANDOM_M11(&RANDSEED) );
-                Vec2 v(cosf( a ), sinf( a ));
-                float s = modeA.speed + modeA.speedVar * RANDOM_M11(&RANDSEED);
-                Vec2 dir = v * s;
-                _particleData.modeA.dirX[i] = dir.x;//v * s ;
-                _particleData.modeA.dirY[i] = dir.y;
+                Vec2 dir(data.modeA.dirX[i], data.modeA.dirY[i]);
+                data.rotation[i] = -CC_RADIANS_TO_DEGREES(dir.getAngle());
             }
         }
         
@@ -767,35 +802,21 @@ dc[i] = (dc[i] - c[i]) / _particleData.timeToLive[i];\
     {
         //Need to check by Jacky
         // Set the default diameter of the particle from the source position
-        for (int i = start; i < _particleCount; ++i)
-        {
-            _particleData.modeB.radius[i] = modeB.startRadius + modeB.startRadiusVar * RANDOM_M11(&RANDSEED);
-        }
-
-        for (int i = start; i < _particleCount; ++i)
-        {
-            _particleData.modeB.angle[i] = CC_DEGREES_TO_RADIANS( _angle + _angleVar * RANDOM_M11(&RANDSEED));
-        }
+        ParticleKernels::random(data.modeB.radius + start, count, modeB.startRadius, modeB.startRadiusVar, &rng);
         
-        for (int i = start; i < _particleCount; ++i)
-        {
-            _particleData.modeB.degreesPerSecond[i] = CC_DEGREES_TO_RADIANS(modeB.rotatePerSecond + modeB.rotatePerSecondVar * RANDOM_M11(&RANDSEED));
-        }
+        ParticleKernels::random(data.modeB.angle + start, count, CC_DEGREES_TO_RADIANS(_angle), CC_DEGREES_TO_RADIANS(_angleVar), &rng);
+        
+        ParticleKernels::random(data.modeB.degreesPerSecond + start, count,
+                                CC_DEGREES_TO_RADIANS(modeB.rotatePerSecond), CC_DEGREES_TO_RADIANS(modeB.rotatePerSecondVar), &rng);
         
         if(modeB.endRadius == START_RADIUS_EQUAL_TO_END_RADIUS)
         {
-            for (int i = start; i < _particleCount; ++i)
-            {
-                _particleData.modeB.deltaRadius[i] = 0.0f;
-            }
+            std::fill_n(data.modeB.deltaRadius + start, count, 0.0f);
         }
         else
         {
-            for (int i = start; i < _particleCount; ++i)
-            {
-                float endRadius = modeB.endRadius + modeB.endRadiusVar * RANDOM_M11(&RANDSEED);
-                _particleData.modeB.deltaRadius[i] = (endRadius - _particleData.modeB.radius[i]) / _particleData.timeToLive[i];
-            }
+            ParticleKernels::random(data.modeB.deltaRadius + start, count, modeB.endRadius, modeB.endRadiusVar, &rng);
+            ParticleKernels::delta(data.modeB.deltaRadius + start, data.modeB.radius + start, timeToLive, count);
         }
     }
 }
@@ -862,9 +883,26 @@ bool ParticleSystem::isFull()
 
 // ParticleSystem - MainLoop
 void ParticleSystem::update(float dt)
+{
+    step(dt, __parallelSimulation);
+}
+
+void ParticleSystem::step(float dt, bool deferSimulation)
 {
     CC_PROFILER_START_CATEGORY(kProfilerCategoryParticles , "CCParticleSystem - update");
 
+    // updated twice in a frame, the particles of the previous update must move first
+    if (_simulationPending)
+    {
+        _simulationPending = false;
+        if (simulate(_pendingDeltaTime))
+        {
+            finishUpdate(true);
+            CC_PROFILER_STOP_CATEGORY(kProfilerCategoryParticles , "CCParticleSystem - update");
+            return;
+        }
+    }
+
     if (_isActive && _emissionRate)
     {
         float rate = 1.0f / _emissionRate;
@@ -891,156 +929,105 @@ void ParticleSystem::update(float dt)
         }
     }
     
+    // the particles of a batched system live in the atlas of the batch node, shared with other systems
+    if (deferSimulation && !_batchNode)
     {
-        for (int i = 0; i < _particleCount; ++i)
+        _pendingDeltaTime = dt;
+        _simulationPending = true;
+        if (!_queuedForSimulation)
         {
-            _particleData.timeToLive[i] -= dt;
+            _queuedForSimulation = true;
+            __pendingSystems.pushBack(this);
+            listenAfterUpdate();
         }
-        
-        for (int i = 0; i < _particleCount; ++i)
-        {
-            if (_particleData.timeToLive[i] <= 0.0f)
-            {
-                int j = _particleCount - 1;
-                while (j > 0 && _particleData.timeToLive[j] <= 0)
-                {
-                    _particleCount--;
-                    j--;
-                }
-                _particleData.copyParticle(i, _particleCount - 1);
-                if (_batchNode)
-                {
-                    //disable the switched particle
-                    int currentIndex = _particleData.atlasIndex[i];
-                    _batchNode->disableParticle(_atlasIndex + currentIndex);
-                    //switch indexes
-                    _particleData.atlasIndex[_particleCount - 1] = currentIndex;
-                }
-                --_particleCount;
-                if( _particleCount == 0 && _isAutoRemoveOnFinish )
-                {
-                    this->unscheduleUpdate();
-                    _parent->removeChild(this, true);
-                    return;
-                }
-            }
-        }
-        
-        if (_emitterMode == Mode::GRAVITY)
-        {
-            for (int i = 0 ; i < _particleCount; ++i)
-            {
-                particle_point tmp, radial = {0.0f, 0.0f}, tangential;
-                
-                // radial acceleration
-                if (_particleData.posx[i] || _particleData.posy[i])
-                {
-                    normalize_point(_particleData.posx[i], _particleData.posy[i], &radial);
-                }
-                tangential = radial;
-                radial.x *= _particleData.modeA.radialAccel[i];
-                radial.y *= _particleData.modeA.radialAccel[i];
-                
-                // tangential acceleration
-                std::swap(tangential.x, tangential.y);
-                tangential.x *= - _particleData.modeA.tangentialAccel[i];
-                tangential.y *= _particleData.modeA.tangentialAccel[i];
-                
-                // (gravity + radial + tangential) * dt
-                tmp.x = radial.x + tangential.x + modeA.gravity.x;
-                tmp.y = radial.y + tangential.y + modeA.gravity.y;
-                tmp.x *= dt;
-                tmp.y *= dt;
-                
-                _particleData.modeA.dirX[i] += tmp.x;
-                _particleData.modeA.dirY[i] += tmp.y;
-                
-                // this is cocos2d-x v3.0
-                // if (_configName.length()>0 && _yCoordFlipped != -1)
-                
-                // this is cocos2d-x v3.0
-                tmp.x = _particleData.modeA.dirX[i] * dt * _yCoordFlipped;
-                tmp.y = _particleData.modeA.dirY[i] * dt * _yCoordFlipped;
-                _particleData.posx[i] += tmp.x;
-                _particleData.posy[i] += tmp.y;
-            }
-        }
-        else
+    }
+    else
+    {
+        finishUpdate(simulate(dt));
+    }
+
+    CC_PROFILER_STOP_CATEGORY(kProfilerCategoryParticles , "CCParticleSystem - update");
+}
+
+bool ParticleSystem::simulate(float dt)
+{
+    ParticleKernels::decrease(_particleData.timeToLive, _particleCount, dt);
+    
+    for (int i = 0; i < _particleCount; ++i)
+    {
+        if (_particleData.timeToLive[i] <= 0.0f)
         {
-            //Why use so many for-loop separately instead of putting them together?
-            //When the processor needs to read from or write to a location in memory,
-            //it first checks whether a copy of that data is in the cache.
-            //And every property's memory of the particle system is continuous,
-            //for the purpose of improving cache hit rate, we should process only one property in one for-loop AFAP.
-            //It was proved to be effective especially for low-end machine. 
-            for (int i = 0; i < _particleCount; ++i)
-            {
-                _particleData.modeB.angle[i] += _particleData.modeB.degreesPerSecond[i] * dt;
-            }
-            
-            for (int i = 0; i < _particleCount; ++i)
+            int j = _particleCount - 1;
+            while (j > 0 && _particleData.timeToLive[j] <= 0)
             {
-                _particleData.modeB.radius[i] += _particleData.modeB.deltaRadius[i] * dt;
+                _particleCount--;
+                j--;
             }
-            
-            for (int i = 0; i < _particleCount; ++i)
+            _particleData.copyParticle(i, _particleCount - 1);
+            if (_batchNode)
             {
-                _particleData.posx[i] = - cosf(_particleData.modeB.angle[i]) * _particleData.modeB.radius[i];
+                //disable the switched particle
+                int currentIndex = _particleData.atlasIndex[i];
+                _batchNode->disableParticle(_atlasIndex + currentIndex);
+                //switch indexes
+                _particleData.atlasIndex[_particleCount - 1] = currentIndex;
             }
-            for (int i = 0; i < _particleCount; ++i)
+            --_particleCount;
+            if( _particleCount == 0 && _isAutoRemoveOnFinish )
             {
-                _particleData.posy[i] = - sinf(_particleData.modeB.angle[i]) * _particleData.modeB.radius[i] * _yCoordFlipped;
+                return true;
             }
         }
-        
-        //color r,g,b,a
-        for (int i = 0 ; i < _particleCount; ++i)
-        {
-            _particleData.colorR[i] += _particleData.deltaColorR[i] * dt;
-        }
-        
-        for (int i = 0 ; i < _particleCount; ++i)
-        {
-            _particleData.colorG[i] += _particleData.deltaColorG[i] * dt;
-        }
-        
-        for (int i = 0 ; i < _particleCount; ++i)
-        {
-            _particleData.colorB[i] += _particleData.deltaColorB[i] * dt;
-        }
-        
-        for (int i = 0 ; i < _particleCount; ++i)
-        {
-            _particleData.colorA[i] += _particleData.deltaColorA[i] * dt;
-        }
-        //size
-        for (int i = 0 ; i < _particleCount; ++i)
-        {
-            _particleData.size[i] += (_particleData.deltaSize[i] * dt);
-            _particleData.size[i] = MAX(0, _particleData.size[i]);
-        }
-        //angle
-        for (int i = 0 ; i < _particleCount; ++i)
+    }
+    
+    if (_emitterMode == Mode::GRAVITY)
+    {
+        ParticleKernels::integrateGravity(_particleData, _particleCount, modeA.gravity, dt, _yCoordFlipped);
+    }
+    else
+    {
+        ParticleKernels::integrateRadius(_particleData, _particleCount, dt, _yCoordFlipped);
+    }
+    
+    //color r,g,b,a
+    ParticleKernels::integrate(_particleData.colorR, _particleData.deltaColorR, _particleCount, dt);
+    ParticleKernels::integrate(_particleData.colorG, _particleData.deltaColorG, _particleCount, dt);
+    ParticleKernels::integrate(_particleData.colorB, _particleData.deltaColorB, _particleCount, dt);
+    ParticleKernels::integrate(_particleData.colorA, _particleData.deltaColorA, _particleCount, dt);
+    //size
+    ParticleKernels::integrate(_particleData.size, _particleData.deltaSize, _particleCount, dt, 0);
+    //angle
+    ParticleKernels::integrate(_particleData.rotation, _particleData.deltaRotation, _particleCount, dt);
+    
+    return false;
+}
+
+void ParticleSystem::finishUpdate(bool finished)
+{
+    if (finished)
+    {
+        this->unscheduleUpdate();
+        if (_parent)
         {
-            _particleData.rotation[i] += _particleData.deltaRotation[i] * dt;
+            _parent->removeChild(this, true);
         }
-        
-        updateParticleQuads();
-        _transformSystemDirty = false;
+        return;
     }
 
+    updateParticleQuads();
+    _transformSystemDirty = false;
+
     // only update gl buffer when visible
     if (_visible && ! _batchNode)
     {
         postStep();
     }
-
-    CC_PROFILER_STOP_CATEGORY(kProfilerCategoryParticles , "CCParticleSystem - update");
 }
 
 void ParticleSystem::updateWithNoTime(void)
 {
-    this->update(0.0f);
+    // the quads are expected to be up to date on return
+    step(0.0f, false);
 }
 
 void ParticleSystem::updateParticleQuads()
@@ -32,6 +32,8 @@ THE SOFTWARE.
 #include "2d/CCNode.h"
 #include "base/CCValue.h"
 
+#include <memory>
+
 NS_CC_BEGIN
 
 /**
@@ -40,6 +42,8 @@ NS_CC_BEGIN
  */
 
 class ParticleBatchNode;
+class ParticleDefinition;
+class Image;
 
 /** @struct sParticle
 Structure that contains the values of each particle.
@@ -255,13 +259,33 @@ public:
     /** Gets all ParticleSystem references
      */
     static Vector<ParticleSystem*>& getAllParticleSystems();
+
+    /** Sets whether the systems updated by the scheduler are simulated together, on the
+     AsyncTaskPool workers, once the scheduler is done. Enabled by default.
+     *
+     * The particles are emitted by update() as before, so a system gets the same particles either way.
+     * Their simulation and the update of the quads are deferred to simulatePendingSystems().
+     @since v3.18
+     */
+    static void setParallelSimulationEnabled(bool enabled);
+    /** Whether the systems updated by the scheduler are simulated in parallel.
+     @since v3.18
+     */
+    static bool isParallelSimulationEnabled();
+    /** Simulates the systems updated since the last call, in parallel, then updates their quads.
+     Called every frame on Director::EVENT_AFTER_UPDATE, between the scheduler and the visit of the scene.
+     @since v3.18
+     * @js NA
+     * @lua NA
+     */
+    static void simulatePendingSystems();
 public:
     void addParticles(int count);
     
-    void stopSystem();
+    virtual void stopSystem();
     /** Kill all living particles.
      */
-    void resetSystem();
+    virtual void resetSystem();
     /** Whether or not the system is full.
      *
      * @return True if the system is full.
@@ -806,6 +830,13 @@ CC_CONSTRUCTOR_ACCESS:
      @since v2.1
      */
     bool initWithDictionary(ValueMap& dictionary, const std::string& dirname);
+
+    /** initializes a particle system from a decoded definition and the path from where to load the png.
+     If lazyTexture is true and the texture isn't in the TextureCache yet, it is loaded off the cocos thread
+     and the system is drawn once it is set.
+     @since v3.18
+     */
+    bool initWithDefinition(const ParticleDefinition& definition, const std::string& dirname, bool lazyTexture);
     
     //! Initializes a system with a fixed number of particles
     virtual bool initWithTotalParticles(int numberOfParticles);
@@ -823,6 +854,21 @@ CC_CONSTRUCTOR_ACCESS:
 
 protected:
     virtual void updateBlendFunc();
+
+    /** Emits the particles of the frame, then simulates them now or defers the simulation. */
+    void step(float dt, bool deferSimulation);
+    /** Moves the particles and removes the dead ones. Only touches the particle data and the quads
+     of the system in its batch node, so that systems can be simulated in parallel.
+     @return True if the last particle died and the system removes itself on finish.
+     */
+    bool simulate(float dt);
+    /** Updates the quads after the simulation, or removes the system if it is finished. */
+    void finishUpdate(bool finished);
+
+    /** Decodes the image embedded in a definition, may be called from any thread. */
+    static Image* createEmbeddedImage(const ParticleDefinition& definition);
+    /** Sets the texture of a definition once it is loaded off the cocos thread. */
+    void loadTextureAsync(const std::string& textureName, const ParticleDefinition& definition);
     
 private:
     friend class EngineDataManager;
@@ -993,6 +1039,17 @@ protected:
     bool _sourcePositionCompatible;
 
     static Vector<ParticleSystem*> __allInstances;
+
+    /** time step of the deferred simulation */
+    float _pendingDeltaTime;
+    /** whether a simulation is deferred */
+    bool _simulationPending;
+    /** whether the system is in __pendingSystems */
+    bool _queuedForSimulation;
+    static bool __parallelSimulation;
+    static Vector<ParticleSystem*> __pendingSystems;
+    /** set when the system is destroyed, checked by the callbacks of loadTextureAsync() which don't retain it */
+    std::shared_ptr<bool> _isDestroyed;
     
 private:
     CC_DISALLOW_COPY_AND_ASSIGN(ParticleSystem);
@@ -0,0 +1,419 @@
+/****************************************************************************
+Copyright (c) 2017-2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "2d/CCParticleSystemGPU.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "renderer/CCGLProgramState.h"
+#include "renderer/CCGLProgramCache.h"
+#include "renderer/ccGLStateCache.h"
+#include "renderer/CCRenderer.h"
+#include "renderer/CCTexture2D.h"
+#include "base/CCDirector.h"
+#include "base/CCEventType.h"
+#include "base/CCEventListenerCustom.h"
+#include "base/CCEventDispatcher.h"
+#include "base/ccUTF8.h"
+
+NS_CC_BEGIN
+
+namespace
+{
+    // must match the attributes of ccShader_ParticleGPU.vert
+    struct ParticleVertex
+    {
+        float corner[2];
+        float spawnTime;
+        float timeToLive;
+        Color4B startColor;
+        Color4B endColor;
+        float motion[4];
+        float sizeRotation[4];
+    };
+
+    // the quads are drawn by chunks addressable with GLushort indices
+    const int PARTICLES_PER_DRAW = 65536 / 4;
+
+    const float EMISSION_NEVER_STOPPED = 1e30f;
+
+    inline GLubyte toByte(float value)
+    {
+        return static_cast<GLubyte>(clampf(value, 0, 1) * 255 + 0.5f);
+    }
+}
+
+ParticleSystemGPU::ParticleSystemGPU()
+: _vboDirty(true)
+, _time(0)
+, _stopTime(EMISSION_NEVER_STOPPED)
+, _period(0)
+{
+    memset(_buffersVBO, 0, sizeof(_buffersVBO));
+}
+
+ParticleSystemGPU::~ParticleSystemGPU()
+{
+    glDeleteBuffers(2, &_buffersVBO[0]);
+}
+
+ParticleSystemGPU* ParticleSystemGPU::create()
+{
+    ParticleSystemGPU* ret = new (std::nothrow) ParticleSystemGPU();
+    if (ret && ret->init())
+    {
+        ret->autorelease();
+        return ret;
+    }
+    CC_SAFE_DELETE(ret);
+    return nullptr;
+}
+
+ParticleSystemGPU* ParticleSystemGPU::createWithTotalParticles(int numberOfParticles)
+{
+    ParticleSystemGPU* ret = new (std::nothrow) ParticleSystemGPU();
+    if (ret && ret->initWithTotalParticles(numberOfParticles))
+    {
+        ret->autorelease();
+        return ret;
+    }
+    CC_SAFE_DELETE(ret);
+    return ret;
+}
+
+ParticleSystemGPU* ParticleSystemGPU::create(const std::string& filename)
+{
+    ParticleSystemGPU* ret = new (std::nothrow) ParticleSystemGPU();
+    if (ret && ret->initWithFile(filename))
+    {
+        ret->autorelease();
+        return ret;
+    }
+    CC_SAFE_DELETE(ret);
+    return ret;
+}
+
+ParticleSystemGPU* ParticleSystemGPU::create(ValueMap& dictionary)
+{
+    ParticleSystemGPU* ret = new (std::nothrow) ParticleSystemGPU();
+    if (ret && ret->initWithDictionary(dictionary))
+    {
+        ret->autorelease();
+        return ret;
+    }
+    CC_SAFE_DELETE(ret);
+    return ret;
+}
+
+bool ParticleSystemGPU::initWithTotalParticles(int numberOfParticles)
+{
+    if (!ParticleSystem::initWithTotalParticles(numberOfParticles))
+    {
+        return false;
+    }
+
+    // the particle data is only needed while generating the spawn parameters
+    _particleData.release();
+
+    setGLProgramState(GLProgramState::create(GLProgramCache::getInstance()->getGLProgram(GLProgram::SHADER_NAME_PARTICLE_GPU)));
+
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+    auto listener = EventListenerCustom::create(EVENT_RENDERER_RECREATED, CC_CALLBACK_1(ParticleSystemGPU::listenRendererRecreated, this));
+    _eventDispatcher->addEventListenerWithSceneGraphPriority(listener, this);
+#endif
+
+    return true;
+}
+
+void ParticleSystemGPU::setupVBO()
+{
+    _vboDirty = false;
+    _period = _emissionRate > 0 ? _totalParticles / _emissionRate : 0;
+    if (_totalParticles <= 0 || _period <= 0)
+    {
+        return;
+    }
+
+    if (_emitterMode == Mode::GRAVITY && (modeA.radialAccel != 0 || modeA.radialAccelVar != 0 ||
+                                          modeA.tangentialAccel != 0 || modeA.tangentialAccelVar != 0))
+    {
+        CCLOG("ParticleSystemGPU: radial and tangential accelerations are ignored");
+    }
+
+    // the spawn parameters are drawn like ParticleSystemQuad does, all at once
+    if (!_particleData.init(_totalParticles))
+    {
+        CCLOG("Particle system: not enough memory");
+        _period = 0;
+        return;
+    }
+    bool paused = _paused;
+    _paused = false;
+    _particleCount = 0;
+    addParticles(_totalParticles);
+    _paused = paused;
+
+    std::vector<ParticleVertex> vertices(_totalParticles * 4);
+    static const float corners[4][2] = { { -0.5f, -0.5f }, { 0.5f, -0.5f }, { -0.5f, 0.5f }, { 0.5f, 0.5f } };
+    auto& data = _particleData;
+    bool radiusMode = _emitterMode == Mode::RADIUS;
+    for (int i = 0; i < _totalParticles; ++i)
+    {
+        float timeToLive = data.timeToLive[i];
+
+        ParticleVertex particle;
+        particle.spawnTime = i / _emissionRate;
+        particle.timeToLive = std::min(timeToLive, _period);
+        particle.startColor = Color4B(toByte(data.colorR[i]), toByte(data.colorG[i]), toByte(data.colorB[i]), toByte(data.colorA[i]));
+        particle.endColor = Color4B(toByte(data.colorR[i] + data.deltaColorR[i] * timeToLive),
+                                    toByte(data.colorG[i] + data.deltaColorG[i] * timeToLive),
+                                    toByte(data.colorB[i] + data.deltaColorB[i] * timeToLive),
+                                    toByte(data.colorA[i] + data.deltaColorA[i] * timeToLive));
+        if (radiusMode)
+        {
+            particle.motion[0] = data.modeB.angle[i];
+            particle.motion[1] = data.modeB.degreesPerSecond[i];
+            particle.motion[2] = data.modeB.radius[i];
+            particle.motion[3] = data.modeB.deltaRadius[i];
+        }
+        else
+        {
+            particle.motion[0] = data.posx[i];
+            particle.motion[1] = data.posy[i];
+            particle.motion[2] = data.modeA.dirX[i];
+            particle.motion[3] = data.modeA.dirY[i];
+        }
+        particle.sizeRotation[0] = data.size[i];
+        particle.sizeRotation[1] = data.size[i] + data.deltaSize[i] * timeToLive;
+        particle.sizeRotation[2] = data.rotation[i];
+        particle.sizeRotation[3] = data.rotation[i] + data.deltaRotation[i] * timeToLive;
+
+        for (int corner = 0; corner < 4; ++corner)
+        {
+            particle.corner[0] = corners[corner][0];
+            particle.corner[1] = corners[corner][1];
+            vertices[i * 4 + corner] = particle;
+        }
+    }
+    _particleData.release();
+    _particleCount = 0;
+
+    // the same indices are used by every chunk
+    int quads = std::min(_totalParticles, PARTICLES_PER_DRAW);
+    std::vector<GLushort> indices(quads * 6);
+    for (int i = 0; i < quads; ++i)
+    {
+        indices[i * 6 + 0] = (GLushort)(i * 4 + 0);
+        indices[i * 6 + 1] = (GLushort)(i * 4 + 1);
+        indices[i * 6 + 2] = (GLushort)(i * 4 + 2);
+        indices[i * 6 + 3] = (GLushort)(i * 4 + 3);
+        indices[i * 6 + 4] = (GLushort)(i * 4 + 2);
+        indices[i * 6 + 5] = (GLushort)(i * 4 + 1);
+    }
+
+    if (!_buffersVBO[0])
+    {
+        glGenBuffers(2, &_buffersVBO[0]);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, _buffersVBO[0]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices[0]) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _buffersVBO[1]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices[0]) * indices.size(), indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    CHECK_GL_ERROR_DEBUG();
+}
+
+void ParticleSystemGPU::update(float dt)
+{
+    if (_vboDirty)
+    {
+        setupVBO();
+    }
+    if (_period <= 0)
+    {
+        return;
+    }
+
+    _time += dt;
+    if (_isActive && _duration != DURATION_INFINITY && _time >= _duration)
+    {
+        stopSystem();
+        _stopTime = _duration;
+    }
+
+    if (_time >= _stopTime + _period)
+    {
+        // every particle spawned before the emission stopped is dead
+        _particleCount = 0;
+        if (_isAutoRemoveOnFinish)
+        {
+            this->unscheduleUpdate();
+            if (_parent)
+            {
+                _parent->removeChild(this, true);
+            }
+        }
+        return;
+    }
+
+    // number of particle slots spawned so far, the dead ones of the current period included
+    double emitting = std::min(_time, _stopTime);
+    _particleCount = static_cast<int>(std::min<double>(_totalParticles, std::floor(emitting * _emissionRate) + 1));
+
+    // the ages only depend on the time modulo the period once every slot has spawned, which keeps it small
+    double shift = 0;
+    if (_time >= 2 * _period)
+    {
+        shift = std::floor(_time / _period - 1) * _period;
+    }
+    float stopTime = _stopTime >= EMISSION_NEVER_STOPPED ? EMISSION_NEVER_STOPPED : static_cast<float>(_stopTime - shift);
+
+    auto glProgramState = getGLProgramState();
+    glProgramState->setUniformVec4("u_time", Vec4(static_cast<float>(_time - shift), stopTime, _period, static_cast<float>(_yCoordFlipped)));
+    glProgramState->setUniformVec4("u_mode", Vec4(modeA.gravity.x, modeA.gravity.y,
+                                                  _emitterMode == Mode::RADIUS ? 1.0f : 0.0f, _opacityModifyRGB ? 1.0f : 0.0f));
+}
+
+void ParticleSystemGPU::updateWithNoTime()
+{
+    update(0.0f);
+}
+
+void ParticleSystemGPU::stopSystem()
+{
+    ParticleSystem::stopSystem();
+    _stopTime = std::min(_stopTime, _time);
+}
+
+void ParticleSystemGPU::resetSystem()
+{
+    // there is no particle data to clear
+    _particleCount = 0;
+    ParticleSystem::resetSystem();
+    _time = 0;
+    _stopTime = EMISSION_NEVER_STOPPED;
+    _vboDirty = true;
+}
+
+void ParticleSystemGPU::draw(Renderer* renderer, const Mat4& transform, uint32_t flags)
+{
+    if (_particleCount > 0 && _texture && _buffersVBO[0])
+    {
+        _customCommand.init(_globalZOrder, transform, flags);
+        _customCommand.func = CC_CALLBACK_0(ParticleSystemGPU::onDraw, this, transform, flags);
+        renderer->addCommand(&_customCommand);
+    }
+}
+
+void ParticleSystemGPU::onDraw(const Mat4& transform, uint32_t /*flags*/)
+{
+    auto glProgramState = getGLProgramState();
+    glProgramState->apply(transform);
+    auto glProgram = glProgramState->getGLProgram();
+
+    GL::bindTexture2D(_texture);
+    GL::blendFunc(_blendFunc.src, _blendFunc.dst);
+    GL::bindVAO(0);
+
+    const GLint locations[5] = {
+        glProgram->getAttribLocation("a_position"),
+        glProgram->getAttribLocation("a_color"),
+        glProgram->getAttribLocation("a_endColor"),
+        glProgram->getAttribLocation("a_motion"),
+        glProgram->getAttribLocation("a_sizeRotation"),
+    };
+    uint32_t attribFlags = 0;
+    for (auto location : locations)
+    {
+        if (location >= 0)
+        {
+            attribFlags |= 1 << location;
+        }
+    }
+    GL::enableVertexAttribs(attribFlags);
+
+    glBindBuffer(GL_ARRAY_BUFFER, _buffersVBO[0]);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _buffersVBO[1]);
+
+    int batches = 0;
+    for (int first = 0; first < _particleCount; first += PARTICLES_PER_DRAW)
+    {
+        int count = std::min(_particleCount - first, PARTICLES_PER_DRAW);
+        size_t chunk = first * 4 * sizeof(ParticleVertex);
+        const GLsizei stride = sizeof(ParticleVertex);
+        glVertexAttribPointer(locations[0], 4, GL_FLOAT, GL_FALSE, stride, (GLvoid*)(chunk + offsetof(ParticleVertex, corner)));
+        glVertexAttribPointer(locations[1], 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (GLvoid*)(chunk + offsetof(ParticleVertex, startColor)));
+        glVertexAttribPointer(locations[2], 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (GLvoid*)(chunk + offsetof(ParticleVertex, endColor)));
+        glVertexAttribPointer(locations[3], 4, GL_FLOAT, GL_FALSE, stride, (GLvoid*)(chunk + offsetof(ParticleVertex, motion)));
+        glVertexAttribPointer(locations[4], 4, GL_FLOAT, GL_FALSE, stride, (GLvoid*)(chunk + offsetof(ParticleVertex, sizeRotation)));
+        glDrawElements(GL_TRIANGLES, (GLsizei)count * 6, GL_UNSIGNED_SHORT, 0);
+        ++batches;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    CC_INCREMENT_GL_DRAWN_BATCHES_AND_VERTICES(batches, _particleCount * 4);
+    CHECK_GL_ERROR_DEBUG();
+}
+
+void ParticleSystemGPU::setBatchNode(ParticleBatchNode* batchNode)
+{
+    CCASSERT(batchNode == nullptr, "ParticleSystemGPU can't be batched");
+    CC_UNUSED_PARAM(batchNode);
+}
+
+void ParticleSystemGPU::setTotalParticles(int totalParticles)
+{
+    _totalParticles = totalParticles;
+    _allocatedParticles = totalParticles;
+
+    // same as ParticleSystemQuad, a system without lifetime keeps its emission rate
+    if (_life > 0)
+    {
+        setEmissionRate(_totalParticles / _life);
+    }
+
+    resetSystem();
+}
+
+void ParticleSystemGPU::listenRendererRecreated(EventCustom* /*event*/)
+{
+    //when comes to foreground in android, _buffersVBO is a wild handle
+    //before recreating, we need to reset it to 0
+    memset(_buffersVBO, 0, sizeof(_buffersVBO));
+    _vboDirty = true;
+}
+
+std::string ParticleSystemGPU::getDescription() const
+{
+    return StringUtils::format("<ParticleSystemGPU | Tag = %d, Total Particles = %d>", _tag, _totalParticles);
+}
+
+NS_CC_END
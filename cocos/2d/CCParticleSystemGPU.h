@@ -0,0 +1,133 @@
+/****************************************************************************
+Copyright (c) 2017-2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#ifndef __CC_PARTICLE_SYSTEM_GPU_H__
+#define __CC_PARTICLE_SYSTEM_GPU_H__
+
+#include "2d/CCParticleSystem.h"
+#include "renderer/CCCustomCommand.h"
+
+NS_CC_BEGIN
+
+class EventCustom;
+
+/**
+ * @addtogroup _2d
+ * @{
+ */
+
+/** @class ParticleSystemGPU
+ * @brief ParticleSystemGPU is a subclass of ParticleSystem whose particles are evaluated by the vertex shader.
+
+The spawn parameters of every particle are generated once, with the same distributions as ParticleSystemQuad,
+and stored in a static vertex buffer. Each frame only the time is sent to the GPU, which computes the position,
+size, rotation and color of the particles in closed form. It suits large ambient effects like rain, snow or dust.
+
+Particle slot i spawns at i / emissionRate and respawns every totalParticles / emissionRate seconds with the same
+parameters, so the effect repeats with that period.
+
+Limitations:
+- Only the closed-form subset of the modes is supported: radial and tangential accelerations are ignored.
+- The particles always move with the emitter, as with PositionType::GROUPED.
+- The lifespan of the particles is capped to the period.
+- It can't be batched with a ParticleBatchNode, and the texture is used whole.
+- The properties are read when the system is reset: call resetSystem() after changing them.
+
+Only OpenGL ES 2.0 features are used, so it also runs on software renderers.
+@since v3.18
+@js NA
+*/
+class CC_DLL ParticleSystemGPU : public ParticleSystem
+{
+public:
+    /** Creates a Particle Emitter.
+     *
+     * @return An autoreleased ParticleSystemGPU object.
+     */
+    static ParticleSystemGPU* create();
+    /** Creates a Particle Emitter with a number of particles.
+     *
+     * @param numberOfParticles A given number of particles.
+     * @return An autoreleased ParticleSystemGPU object.
+     */
+    static ParticleSystemGPU* createWithTotalParticles(int numberOfParticles);
+    /** Creates an initializes a ParticleSystemGPU from a plist file.
+     *
+     * @param filename Particle plist file name.
+     * @return An autoreleased ParticleSystemGPU object.
+     */
+    static ParticleSystemGPU* create(const std::string& filename);
+    /** Creates a Particle Emitter with a dictionary.
+     *
+     * @param dictionary Particle dictionary.
+     * @return An autoreleased ParticleSystemGPU object.
+     */
+    static ParticleSystemGPU* create(ValueMap& dictionary);
+
+    /** Listen the event that renderer was recreated on Android/WP8.
+     *
+     * @param event the event that renderer was recreated on Android/WP8.
+     */
+    void listenRendererRecreated(EventCustom* event);
+
+    // Overrides
+    virtual void update(float dt) override;
+    virtual void updateWithNoTime() override;
+    virtual void stopSystem() override;
+    virtual void resetSystem() override;
+    virtual void draw(Renderer* renderer, const Mat4& transform, uint32_t flags) override;
+    virtual void setBatchNode(ParticleBatchNode* batchNode) override;
+    virtual void setTotalParticles(int totalParticles) override;
+    virtual std::string getDescription() const override;
+
+CC_CONSTRUCTOR_ACCESS:
+    ParticleSystemGPU();
+    virtual ~ParticleSystemGPU();
+
+    virtual bool initWithTotalParticles(int numberOfParticles) override;
+
+protected:
+    /** generates the spawn parameters of the particles and uploads them */
+    void setupVBO();
+    void onDraw(const Mat4& transform, uint32_t flags);
+
+    GLuint _buffersVBO[2];  //0: vertex  1: indices
+    bool _vboDirty;
+    /** time since the system was reset, and time the emission stopped */
+    double _time;
+    double _stopTime;
+    /** period of the emission, every particle respawns once per period */
+    float _period;
+
+    CustomCommand _customCommand;
+
+private:
+    CC_DISALLOW_COPY_AND_ASSIGN(ParticleSystemGPU);
+};
+
+// end of _2d group
+/// @}
+
+NS_CC_END
+
+#endif //__CC_PARTICLE_SYSTEM_GPU_H__
@@ -34,6 +34,7 @@ THE SOFTWARE.
 #include "base/ccUTF8.h"
 #include "renderer/CCRenderer.h"
 #include "renderer/CCFrameBuffer.h"
+#include "3d/CCAABBTree.h"
 
 #if CC_USE_PHYSICS
 #include "physics/CCPhysicsWorld.h"
@@ -67,6 +68,9 @@ Scene::Scene()
     setAnchorPoint(Vec2(0.5f, 0.5f));
     
     _cameraOrderDirty = true;
+    _aabbTree = new (std::nothrow) AABBTree();
+    _aabbTreeCullingEnabled = true;
+    _renderId = 0;
     
     //create default camera
     _defaultCamera = Camera::create();
@@ -89,6 +93,7 @@ Scene::~Scene()
 #endif
     Director::getInstance()->getEventDispatcher()->removeEventListener(_event);
     CC_SAFE_RELEASE(_event);
+    CC_SAFE_DELETE(_aabbTree);
     
 #if CC_USE_PHYSICS
     delete _physicsWorld;
@@ -170,6 +175,8 @@ void Scene::onProjectionChanged(EventCustom* /*event*/)
     }
 }
 
+static unsigned int s_lastRenderId = 0;
+
 static bool camera_cmp(const Camera* a, const Camera* b)
 {
     return a->getRenderOrder() < b->getRenderOrder();
@@ -195,6 +202,7 @@ void Scene::render(Renderer* renderer, const Mat4* eyeTransforms, const Mat4* ey
     auto director = Director::getInstance();
     Camera* defaultCamera = nullptr;
     const auto& transform = getNodeToParentTransform();
+    _renderId = ++s_lastRenderId;
 
     for (const auto& camera : getCameras())
     {
@@ -226,6 +234,12 @@ void Scene::render(Renderer* renderer, const Mat4* eyeTransforms, const Mat4* ey
         camera->apply();
         //clear background with max depth
         camera->clearBackground();
+#if CC_USE_CULLING
+        // the nodes which didn't move since the last cull are culled at once through the tree,
+        // those out of the frustum skip their visit
+        if (_aabbTreeCullingEnabled && _aabbTree->getProxyCount() > 0)
+            _aabbTree->cull(camera->getFrustum(), camera);
+#endif
         //visit the scene
         visit(renderer, transform, 0);
 #if CC_USE_NAVMESH
@@ -274,6 +288,8 @@ void Scene::render(Renderer* renderer, const Mat4* eyeTransforms, const Mat4* ey
 #endif
 
     Camera::_visitingCamera = nullptr;
+    _aabbTree->resetCulling();
+    _renderId = 0;
 //    experimental::FrameBuffer::applyDefaultFBO();
 }
 
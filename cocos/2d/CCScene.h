@@ -39,6 +39,7 @@ class BaseLight;
 class Renderer;
 class EventListenerCustom;
 class EventCustom;
+class AABBTree;
 #if CC_USE_PHYSICS
 class PhysicsWorld;
 #endif
@@ -106,6 +107,29 @@ public:
      */
     const std::vector<BaseLight*>& getLights() const { return _lights; }
 
+    /** Get the bounding volume hierarchy of the 3D nodes of the scene (Sprite3D, BillBoard and Terrain), used by the cameras to cull them.
+     * Its user data are the Nodes, it can be queried e.g. to pick them with a ray.
+     * @js NA
+     * @since v3.18
+     */
+    AABBTree* getAABBTree() const { return _aabbTree; }
+
+    /** Set whether the cameras cull the 3D nodes through the AABBTree before visiting the scene, true by default.
+     * When it is disabled, every node tests its own box while it is visited, e.g. to compare both.
+     * @js NA
+     * @since v3.18
+     */
+    void setAABBTreeCullingEnabled(bool enabled) { _aabbTreeCullingEnabled = enabled; }
+    bool isAABBTreeCullingEnabled() const { return _aabbTreeCullingEnabled; }
+
+    /** Get the identifier of the current render of the scene, unique among the renders of all the scenes.
+     * It changes with every call to render(), e.g. to cache the state of the lights for one render,
+     * and is 0 outside render(), e.g. while utils::captureNode() draws a node after the lights moved.
+     * @js NA
+     * @since v3.18
+     */
+    unsigned int getRenderId() const { return _renderId; }
+
     /** Render the scene.
      * @param renderer The renderer use to render the scene.
      * @param eyeTransform The AdditionalTransform of camera.
@@ -151,6 +175,9 @@ protected:
     EventListenerCustom*       _event;
 
     std::vector<BaseLight *> _lights;
+    AABBTree*                _aabbTree;
+    bool                     _aabbTreeCullingEnabled;
+    unsigned int             _renderId;
     
 private:
     CC_DISALLOW_COPY_AND_ASSIGN(Scene);
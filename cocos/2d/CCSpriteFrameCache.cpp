@@ -31,6 +31,8 @@ THE SOFTWARE.
 #include "2d/CCSpriteFrameCache.h"
 
 #include <vector>
+#include <memory>
+#include <algorithm>
 
 
 #include "2d/CCSprite.h"
@@ -43,6 +45,8 @@ THE SOFTWARE.
 #include "renderer/CCTexture2D.h"
 #include "renderer/CCTextureCache.h"
 #include "base/CCNinePatchImageParser.h"
+#include "base/CCAsyncTaskPool.h"
+#include "2d/CCSpriteSheet.h"
 
 using namespace std;
 
@@ -50,6 +54,74 @@ NS_CC_BEGIN
 
 static SpriteFrameCache *_sharedSpriteFrameCache = nullptr;
 
+// frames created per frame by addSpriteFramesWithFileAsync()
+static const size_t ASYNC_FRAMES_PER_BATCH = 128;
+
+static bool getPixelFormatByName(const std::string& name, Texture2D::PixelFormat& pixelFormat)
+{
+    static std::unordered_map<std::string, Texture2D::PixelFormat> pixelFormats = {
+        {"RGBA8888", Texture2D::PixelFormat::RGBA8888},
+        {"RGBA4444", Texture2D::PixelFormat::RGBA4444},
+        {"RGB5A1", Texture2D::PixelFormat::RGB5A1},
+        {"RGBA5551", Texture2D::PixelFormat::RGB5A1},
+        {"RGB565", Texture2D::PixelFormat::RGB565},
+        {"A8", Texture2D::PixelFormat::A8},
+        {"ALPHA", Texture2D::PixelFormat::A8},
+        {"I8", Texture2D::PixelFormat::I8},
+        {"AI88", Texture2D::PixelFormat::AI88},
+        {"ALPHA_INTENSITY", Texture2D::PixelFormat::AI88},
+        //{"BGRA8888", Texture2D::PixelFormat::BGRA8888}, no Image conversion RGBA -> BGRA
+        {"RGB888", Texture2D::PixelFormat::RGB888}
+    };
+
+    auto pixelFormatIt = pixelFormats.find(name);
+    if (pixelFormatIt == pixelFormats.end())
+        return false;
+
+    pixelFormat = pixelFormatIt->second;
+    return true;
+}
+
+static std::string getSpriteSheetTexturePath(const std::string& textureFileName, const std::string& plist)
+{
+    if (!textureFileName.empty())
+    {
+        // build texture path relative to plist file
+        return FileUtils::getInstance()->fullPathFromRelativeFile(textureFileName, plist);
+    }
+
+    // build texture path by replacing file extension
+    std::string texturePath = plist;
+
+    // remove .xxx
+    size_t startPos = texturePath.find_last_of(".");
+    texturePath = texturePath.erase(startPos);
+
+    // append .png
+    texturePath = texturePath.append(".png");
+
+    CCLOG("cocos2d: SpriteFrameCache: Trying to use file %s as texture", texturePath.c_str());
+    return texturePath;
+}
+
+static Texture2D* addSpriteSheetTexture(const std::string& texturePath, const std::string& pixelFormatName)
+{
+    Texture2D *texture = nullptr;
+    Texture2D::PixelFormat pixelFormat;
+    if (getPixelFormatByName(pixelFormatName, pixelFormat))
+    {
+        const Texture2D::PixelFormat currentPixelFormat = Texture2D::getDefaultAlphaPixelFormat();
+        Texture2D::setDefaultAlphaPixelFormat(pixelFormat);
+        texture = Director::getInstance()->getTextureCache()->addImage(texturePath);
+        Texture2D::setDefaultAlphaPixelFormat(currentPixelFormat);
+    }
+    else
+    {
+        texture = Director::getInstance()->getTextureCache()->addImage(texturePath);
+    }
+    return texture;
+}
+
 SpriteFrameCache* SpriteFrameCache::getInstance()
 {
     if (! _sharedSpriteFrameCache)
@@ -309,50 +381,115 @@ void SpriteFrameCache::addSpriteFramesWithDictionary(ValueMap& dict, const std::
         }
     }
     
-    Texture2D *texture = nullptr;
-    static std::unordered_map<std::string, Texture2D::PixelFormat> pixelFormats = {
-        {"RGBA8888", Texture2D::PixelFormat::RGBA8888},
-        {"RGBA4444", Texture2D::PixelFormat::RGBA4444},
-        {"RGB5A1", Texture2D::PixelFormat::RGB5A1},
-        {"RGBA5551", Texture2D::PixelFormat::RGB5A1},
-        {"RGB565", Texture2D::PixelFormat::RGB565},
-        {"A8", Texture2D::PixelFormat::A8},
-        {"ALPHA", Texture2D::PixelFormat::A8},
-        {"I8", Texture2D::PixelFormat::I8},
-        {"AI88", Texture2D::PixelFormat::AI88},
-        {"ALPHA_INTENSITY", Texture2D::PixelFormat::AI88},
-        //{"BGRA8888", Texture2D::PixelFormat::BGRA8888}, no Image conversion RGBA -> BGRA
-        {"RGB888", Texture2D::PixelFormat::RGB888}
-    };
-
-    auto pixelFormatIt = pixelFormats.find(pixelFormatName);
-    if (pixelFormatIt != pixelFormats.end())
+    Texture2D *texture = addSpriteSheetTexture(texturePath, pixelFormatName);
+    if (texture)
     {
-        const Texture2D::PixelFormat pixelFormat = (*pixelFormatIt).second;
-        const Texture2D::PixelFormat currentPixelFormat = Texture2D::getDefaultAlphaPixelFormat();
-        Texture2D::setDefaultAlphaPixelFormat(pixelFormat);
-        texture = Director::getInstance()->getTextureCache()->addImage(texturePath);
-        Texture2D::setDefaultAlphaPixelFormat(currentPixelFormat);
+        addSpriteFramesWithDictionary(dict, texture, plist);
     }
     else
     {
-        texture = Director::getInstance()->getTextureCache()->addImage(texturePath);
+        CCLOG("cocos2d: SpriteFrameCache: Couldn't load texture");
     }
-    
-    if (texture)
+}
+
+bool SpriteFrameCache::readSpriteFramesFile(const std::string& fullPath, SpriteSheet& sheet, ValueMap& dict)
+{
+    Data data = FileUtils::getInstance()->getDataFromFile(fullPath);
+    if (SpriteSheet::isBinary(data.getBytes(), data.getSize()))
     {
-        addSpriteFramesWithDictionary(dict, texture, plist);
+        if (!sheet.initWithBinary(data.getBytes(), data.getSize()))
+        {
+            CCLOG("cocos2d: SpriteFrameCache: can not decode %s", fullPath.c_str());
+        }
+        return true;
     }
-    else
+
+    if (!data.isNull())
+    {
+        dict = FileUtils::getInstance()->getValueMapFromData((const char*)data.getBytes(), static_cast<int>(data.getSize()));
+    }
+    return false;
+}
+
+void SpriteFrameCache::addSpriteFramesWithSheet(const SpriteSheet& sheet, size_t first, size_t last, Texture2D *texture,
+                                                const std::string &plist, Image*& image)
+{
+    NinePatchImageParser parser;
+    for (size_t i = first; i < last; ++i)
+    {
+        const SpriteSheet::Frame& frame = sheet.frames[i];
+        if (_spriteFramesCache.at(frame.name))
+        {
+            continue;
+        }
+
+        for (const auto& alias : frame.aliases)
+        {
+            if (_spriteFramesAliases.find(alias) != _spriteFramesAliases.end())
+            {
+                CCLOGWARN("cocos2d: WARNING: an alias with name %s already exists", alias.c_str());
+            }
+            _spriteFramesAliases[alias] = Value(frame.name);
+        }
+
+        SpriteFrame* spriteFrame = SpriteFrame::createWithTexture(texture,
+                                                                  frame.rect,
+                                                                  frame.rotated,
+                                                                  frame.offset,
+                                                                  frame.originalSize);
+        if (!frame.vertices.empty())
+        {
+            PolygonInfo info;
+            initializePolygonInfo(sheet.textureSize, frame.originalSize, frame.vertices, frame.verticesUV, frame.triangles, info);
+            spriteFrame->setPolygonInfo(info);
+        }
+        if (frame.hasAnchor)
+        {
+            spriteFrame->setAnchorPoint(frame.anchor);
+        }
+
+        if (NinePatchImageParser::isNinePatchImage(frame.name))
+        {
+            if (image == nullptr) {
+                image = new (std::nothrow) Image();
+                image->initWithImageFile(Director::getInstance()->getTextureCache()->getTextureFilePath(texture));
+            }
+            parser.setSpriteFrameInfo(image, spriteFrame->getRectInPixels(), spriteFrame->isRotated());
+            texture->addSpriteFrameCapInset(spriteFrame, parser.parseCapInset());
+        }
+        // add sprite frame
+        _spriteFramesCache.insertFrame(plist, frame.name, spriteFrame);
+    }
+}
+
+void SpriteFrameCache::addSpriteFramesWithSheet(const SpriteSheet& sheet, const std::string &texturePath, const std::string &plist)
+{
+    Texture2D *texture = addSpriteSheetTexture(texturePath, sheet.pixelFormat);
+    if (!texture)
     {
         CCLOG("cocos2d: SpriteFrameCache: Couldn't load texture");
+        return;
     }
+
+    Image* image = nullptr;
+    addSpriteFramesWithSheet(sheet, 0, sheet.frames.size(), texture, plist, image);
+    _spriteFramesCache.markPlistFull(plist, true);
+    CC_SAFE_DELETE(image);
 }
 
 void SpriteFrameCache::addSpriteFramesWithFile(const std::string& plist, Texture2D *texture)
 {
     std::string fullPath = FileUtils::getInstance()->fullPathForFilename(plist);
-    ValueMap dict = FileUtils::getInstance()->getValueMapFromFile(fullPath);
+    SpriteSheet sheet;
+    ValueMap dict;
+    if (readSpriteFramesFile(fullPath, sheet, dict))
+    {
+        Image* image = nullptr;
+        addSpriteFramesWithSheet(sheet, 0, sheet.frames.size(), texture, plist, image);
+        _spriteFramesCache.markPlistFull(plist, true);
+        CC_SAFE_DELETE(image);
+        return;
+    }
 
     addSpriteFramesWithDictionary(dict, texture, plist);
 }
@@ -367,7 +504,13 @@ void SpriteFrameCache::addSpriteFramesWithFile(const std::string& plist, const s
 {
     CCASSERT(textureFileName.size()>0, "texture name should not be null");
     const std::string fullPath = FileUtils::getInstance()->fullPathForFilename(plist);
-    ValueMap dict = FileUtils::getInstance()->getValueMapFromFile(fullPath);
+    SpriteSheet sheet;
+    ValueMap dict;
+    if (readSpriteFramesFile(fullPath, sheet, dict))
+    {
+        addSpriteFramesWithSheet(sheet, textureFileName, plist);
+        return;
+    }
     addSpriteFramesWithDictionary(dict, textureFileName, plist);
 }
 
@@ -388,7 +531,13 @@ void SpriteFrameCache::addSpriteFramesWithFile(const std::string& plist)
         return;
     }
 
-    ValueMap dict = FileUtils::getInstance()->getValueMapFromFile(fullPath);
+    SpriteSheet sheet;
+    ValueMap dict;
+    if (readSpriteFramesFile(fullPath, sheet, dict))
+    {
+        addSpriteFramesWithSheet(sheet, getSpriteSheetTexturePath(sheet.textureFileName, plist), plist);
+        return;
+    }
 
     string texturePath("");
 
@@ -399,26 +548,104 @@ void SpriteFrameCache::addSpriteFramesWithFile(const std::string& plist)
         texturePath = metadataDict["textureFileName"].asString();
     }
 
-    if (!texturePath.empty())
+    texturePath = getSpriteSheetTexturePath(texturePath, plist);
+    addSpriteFramesWithDictionary(dict, texturePath, plist);
+}
+
+void SpriteFrameCache::addSpriteFramesWithFileAsync(const std::string& plist, const std::function<void(bool)>& callback)
+{
+    CCASSERT(!plist.empty(), "plist filename should not be nullptr");
+
+    if (_spriteFramesCache.isPlistFull(plist))
     {
-        // build texture path relative to plist file
-        texturePath = FileUtils::getInstance()->fullPathFromRelativeFile(texturePath, plist);
+        if (callback) callback(true);
+        return;
     }
-    else
+
+    std::string fullPath = FileUtils::getInstance()->fullPathForFilename(plist);
+    if (fullPath.empty())
     {
-        // build texture path by replacing file extension
-        texturePath = plist;
+        // return if plist file doesn't exist
+        CCLOG("cocos2d: SpriteFrameCache: can not find %s", plist.c_str());
+        if (callback) callback(false);
+        return;
+    }
 
-        // remove .xxx
-        size_t startPos = texturePath.find_last_of("."); 
-        texturePath = texturePath.erase(startPos);
+    // state of the load, shared by the steps below
+    struct AsyncLoad
+    {
+        SpriteSheet sheet;
+        bool decoded = false;
+        Texture2D* texture = nullptr;
+        Image* image = nullptr;
+        size_t nextFrame = 0;
+    };
+    auto load = std::make_shared<AsyncLoad>();
+    static unsigned int s_asyncLoadCount = 0;
+    std::string key = StringUtils::format("SpriteFrameCache#%u", s_asyncLoadCount++);
 
-        // append .png
-        texturePath = texturePath.append(".png");
+    // kept alive until the frames are added
+    retain();
 
-        CCLOG("cocos2d: SpriteFrameCache: Trying to use file %s as texture", texturePath.c_str());
-    }
-    addSpriteFramesWithDictionary(dict, texturePath, plist);
+    auto finish = [this, callback](bool succeeded) {
+        if (callback) callback(succeeded);
+        release();
+    };
+
+    auto addFrames = [this, load, plist, key, finish](float /*dt*/) {
+        size_t last = std::min(load->nextFrame + ASYNC_FRAMES_PER_BATCH, load->sheet.frames.size());
+        addSpriteFramesWithSheet(load->sheet, load->nextFrame, last, load->texture, plist, load->image);
+        load->nextFrame = last;
+        if (last < load->sheet.frames.size())
+            return;
+
+        _spriteFramesCache.markPlistFull(plist, true);
+        CC_SAFE_DELETE(load->image);
+        load->texture->release();
+        // unscheduling destroys this lambda, keep what is needed
+        auto done = finish;
+        Director::getInstance()->getScheduler()->unschedule(key, this);
+        done(true);
+    };
+
+    AsyncTaskPool::getInstance()->submit([load, fullPath]() {
+        load->decoded = load->sheet.initWithData(FileUtils::getInstance()->getDataFromFile(fullPath));
+    }, [this, load, plist, key, finish, addFrames]() {
+        if (!load->decoded)
+        {
+            // binary plists and malformed files are left to the synchronous loader
+            addSpriteFramesWithFile(plist);
+            finish(isSpriteFramesWithFileLoaded(plist));
+            return;
+        }
+
+        std::string texturePath = getSpriteSheetTexturePath(load->sheet.textureFileName, plist);
+        auto textureLoaded = [this, load, key, finish, addFrames](Texture2D* texture) {
+            if (!texture)
+            {
+                CCLOG("cocos2d: SpriteFrameCache: Couldn't load texture");
+                finish(false);
+                return;
+            }
+            load->texture = texture;
+            texture->retain();
+            Director::getInstance()->getScheduler()->schedule(addFrames, this, 0, false, key);
+        };
+
+        // the pixel format is captured when the image is queued
+        Texture2D::PixelFormat pixelFormat;
+        if (getPixelFormatByName(load->sheet.pixelFormat, pixelFormat))
+        {
+            const Texture2D::PixelFormat currentPixelFormat = Texture2D::getDefaultAlphaPixelFormat();
+            Texture2D::setDefaultAlphaPixelFormat(pixelFormat);
+            Director::getInstance()->getTextureCache()->addImageAsync(texturePath, textureLoaded);
+            Texture2D::setDefaultAlphaPixelFormat(currentPixelFormat);
+        }
+        else
+        {
+            Director::getInstance()->getTextureCache()->addImageAsync(texturePath, textureLoaded);
+        }
+    });
 }
 
 bool SpriteFrameCache::isSpriteFramesWithFileLoaded(const std::string& plist) const
@@ -484,13 +711,29 @@ void SpriteFrameCache::removeSpriteFrameByName(const std::string& name)
 void SpriteFrameCache::removeSpriteFramesFromFile(const std::string& plist)
 {
     std::string fullPath = FileUtils::getInstance()->fullPathForFilename(plist);
-    ValueMap dict = FileUtils::getInstance()->getValueMapFromFile(fullPath);
-    if (dict.empty())
+    SpriteSheet sheet;
+    ValueMap dict;
+    if (readSpriteFramesFile(fullPath, sheet, dict))
     {
-        CCLOG("cocos2d:SpriteFrameCache:removeSpriteFramesFromFile: create dict by %s fail.",plist.c_str());
-        return;
+        std::vector<std::string> keysToRemove;
+        for (const auto& frame : sheet.frames)
+        {
+            if (_spriteFramesCache.at(frame.name))
+            {
+                keysToRemove.push_back(frame.name);
+            }
+        }
+        _spriteFramesCache.eraseFrames(keysToRemove);
+    }
+    else
+    {
+        if (dict.empty())
+        {
+            CCLOG("cocos2d:SpriteFrameCache:removeSpriteFramesFromFile: create dict by %s fail.",plist.c_str());
+            return;
+        }
+        removeSpriteFramesFromDictionary(dict);
     }
-    removeSpriteFramesFromDictionary(dict);
 
     // remove it from the cache
     _spriteFramesCache.erasePlistIndex(plist);
@@ -690,11 +933,17 @@ bool SpriteFrameCache::reloadTexture(const std::string& plist)
     }
 
     std::string fullPath = FileUtils::getInstance()->fullPathForFilename(plist);
-    ValueMap dict = FileUtils::getInstance()->getValueMapFromFile(fullPath);
+    SpriteSheet sheet;
+    ValueMap dict;
+    bool isSheet = readSpriteFramesFile(fullPath, sheet, dict);
 
     string texturePath("");
 
-    if (dict.find("metadata") != dict.end())
+    if (isSheet)
+    {
+        texturePath = sheet.textureFileName;
+    }
+    else if (dict.find("metadata") != dict.end())
     {
         ValueMap& metadataDict = dict["metadata"].asValueMap();
         // try to read  texture file name from meta data
@@ -723,7 +972,17 @@ bool SpriteFrameCache::reloadTexture(const std::string& plist)
     if (Director::getInstance()->getTextureCache()->reloadTexture(texturePath))
         texture = Director::getInstance()->getTextureCache()->getTextureForKey(texturePath);
 
-    if (texture)
+    if (texture && isSheet)
+    {
+        for (const auto& frame : sheet.frames)
+        {
+            _spriteFramesCache.eraseFrame(frame.name);
+        }
+        Image* image = nullptr;
+        addSpriteFramesWithSheet(sheet, 0, sheet.frames.size(), texture, plist, image);
+        CC_SAFE_DELETE(image);
+    }
+    else if (texture)
     {
         reloadSpriteFramesWithDictionary(dict, texture, plist);
     }
@@ -34,6 +34,7 @@ THE SOFTWARE.
 #include <set>
 #include <unordered_map>
 #include <string>
+#include <functional>
 #include "2d/CCSpriteFrame.h"
 #include "base/CCRef.h"
 #include "base/CCValue.h"
@@ -44,6 +45,8 @@ NS_CC_BEGIN
 class Sprite;
 class Texture2D;
 class PolygonInfo;
+class SpriteSheet;
+class Image;
 
 /**
  * @addtogroup _2d
@@ -79,6 +82,9 @@ class PolygonInfo;
      - `size`:            size of the texture (optional)
      - `textureFileName`: name of the texture's image file
  
+ Frames can also be loaded from binary sprite sheets (.ccss, see SpriteSheet), converted from the
+ .plist files with `tools/sprite-sheet/compile_sprite_sheet.py`, which are registered without parsing.
+
  Use one of the following tools to create the .plist file and sprite sheet:
  - [TexturePacker](https://www.codeandweb.com/texturepacker/cocos2d)
  - [Zwoptex](https://zwopple.com/zwoptex/)
@@ -207,6 +213,20 @@ public:
      */
     void addSpriteFramesWithFileContent(const std::string& plist_content, Texture2D *texture);
 
+    /** Adds multiple Sprite Frames from a plist file or a binary sprite sheet, in the background.
+     * The file is read and decoded on a worker thread straight into frame descriptions, the texture is loaded
+     * with TextureCache::addImageAsync(), then the frames are created on the cocos thread, a batch per frame.
+     * The texture name is found the same way as addSpriteFramesWithFile(const std::string&) does.
+     * @since v3.18
+     * @js NA
+     * @lua NA
+     *
+     * @param plist Plist or binary sprite sheet file name.
+     * @param callback Called on the cocos thread once the frames are added, with false if the file or its texture
+     * couldn't be loaded.
+     */
+    void addSpriteFramesWithFileAsync(const std::string& plist, const std::function<void(bool)>& callback = nullptr);
+
     /** Adds an sprite frame with a given name.
      If the name already exists, then the contents of the old name will be replaced with the new one.
      *
@@ -317,6 +337,20 @@ protected:
 
     void reloadSpriteFramesWithDictionary(ValueMap& dictionary, Texture2D *texture, const std::string &plist);
 
+    /* Reads a sprite frames file, decoding it into sheet if it is a binary sprite sheet, into dict otherwise.
+     * Returns true if it is a binary sprite sheet.
+     */
+    bool readSpriteFramesFile(const std::string& fullPath, SpriteSheet& sheet, ValueMap& dict);
+
+    /* Adds the frames [first, last) of a decoded sprite sheet. The image is loaded on demand for nine-patch frames.
+     */
+    void addSpriteFramesWithSheet(const SpriteSheet& sheet, size_t first, size_t last, Texture2D *texture,
+                                  const std::string &plist, Image*& image);
+
+    /* Adds all the frames of a decoded sprite sheet, loading its texture.
+     */
+    void addSpriteFramesWithSheet(const SpriteSheet& sheet, const std::string &texturePath, const std::string &plist);
+
     ValueMap _spriteFramesAliases;
     PlistFramesCache _spriteFramesCache;
 };
@@ -0,0 +1,725 @@
+/****************************************************************************
+Copyright (c) 2017-2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "2d/CCSpriteSheet.h"
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "base/CCData.h"
+#include "base/CCNS.h"
+#include "base/ccMacros.h"
+
+NS_CC_BEGIN
+
+namespace
+{
+    // Binary sprite sheet layout, all values little endian.
+    // Must match tools/sprite-sheet/compile_sprite_sheet.py.
+    struct BinaryHeader
+    {
+        char magic[4];              // "CCSS"
+        uint32_t version;
+        uint32_t format;
+        uint32_t frameCount;
+        uint32_t aliasCount;
+        uint32_t polygonIntCount;
+        uint32_t framesOffset;
+        uint32_t aliasesOffset;
+        uint32_t polygonsOffset;
+        uint32_t stringsOffset;
+        uint32_t stringsSize;
+        float textureWidth;
+        float textureHeight;
+        uint32_t textureNameOffset;
+        uint32_t textureNameLength;
+        uint32_t pixelFormatOffset;
+        uint32_t pixelFormatLength;
+        uint32_t reserved;
+    };
+
+    struct BinaryFrame
+    {
+        uint32_t nameOffset;
+        uint32_t nameLength;
+        float x, y, width, height;
+        float offsetX, offsetY;
+        float originalWidth, originalHeight;
+        float anchorX, anchorY;
+        uint32_t flags;
+        // vertices, verticesUV (vertexIntCount ints each) then triangles, in the polygon table
+        uint32_t polygonOffset;
+        uint32_t vertexIntCount;
+        uint32_t triangleIndexCount;
+    };
+
+    struct BinaryAlias
+    {
+        uint32_t nameOffset;
+        uint32_t nameLength;
+        uint32_t frameIndex;
+    };
+
+    const char BINARY_MAGIC[4] = { 'C', 'C', 'S', 'S' };
+    const uint32_t BINARY_VERSION = 1;
+
+    const uint32_t FRAME_ROTATED = 1 << 0;
+    const uint32_t FRAME_HAS_ANCHOR = 1 << 1;
+
+    bool inRange(size_t offset, size_t length, size_t size)
+    {
+        return offset <= size && length <= size - offset;
+    }
+
+    // Minimal pull parser for the XML subset used by plists: elements without attributes
+    // that matter, text, comments, processing instructions and the DOCTYPE.
+    class PlistReader
+    {
+    public:
+        enum class Token
+        {
+            OPEN,
+            CLOSE,
+            EMPTY,      // <true/>, <array/>...
+            TEXT,
+            END,
+            ERROR
+        };
+
+        PlistReader(const char* xml, size_t size)
+        : _p(xml)
+        , _end(xml + size)
+        , _peeked(false)
+        , _peekedToken(Token::END)
+        {
+        }
+
+        // tag name of the last OPEN/CLOSE/EMPTY token, decoded content of the last TEXT token
+        const std::string& value() const { return _value; }
+
+        Token peek()
+        {
+            if (!_peeked)
+            {
+                _peekedToken = read();
+                _peeked = true;
+            }
+            return _peekedToken;
+        }
+
+        Token next()
+        {
+            Token token = peek();
+            _peeked = false;
+            return token;
+        }
+
+        // reads <tag>text</tag> once the opening tag was read
+        bool readText(const std::string& tag, std::string* text)
+        {
+            text->clear();
+            Token token = next();
+            if (token == Token::TEXT)
+            {
+                *text = _value;
+                token = next();
+            }
+            return token == Token::CLOSE && _value == tag;
+        }
+
+        // skips a value, whose first token was already read
+        bool skipValue(Token first)
+        {
+            if (first == Token::EMPTY || first == Token::TEXT)
+                return true;
+            if (first != Token::OPEN)
+                return false;
+
+            int depth = 1;
+            while (depth > 0)
+            {
+                Token token = next();
+                if (token == Token::OPEN)
+                    ++depth;
+                else if (token == Token::CLOSE)
+                    --depth;
+                else if (token == Token::END || token == Token::ERROR)
+                    return false;
+            }
+            return true;
+        }
+
+    private:
+        Token read()
+        {
+            for (;;)
+            {
+                // text, ignoring the whitespace between elements
+                const char* textStart = _p;
+                while (_p < _end && *_p != '<')
+                    ++_p;
+                if (_p != textStart && !isBlank(textStart, _p))
+                {
+                    decode(textStart, _p);
+                    return Token::TEXT;
+                }
+                if (_p >= _end)
+                    return Token::END;
+
+                if (startsWith("<!--"))
+                {
+                    if (!skipPast("-->"))
+                        return Token::ERROR;
+                    continue;
+                }
+                if (startsWith("<![CDATA["))
+                {
+                    const char* start = _p + 9;
+                    if (!skipPast("]]>"))
+                        return Token::ERROR;
+                    _value.assign(start, _p - 3);
+                    return Token::TEXT;
+                }
+                if (startsWith("<?") || startsWith("<!"))
+                {
+                    if (!skipPast(">"))
+                        return Token::ERROR;
+                    continue;
+                }
+
+                bool closing = _p + 1 < _end && _p[1] == '/';
+                const char* nameStart = _p + (closing ? 2 : 1);
+                const char* nameEnd = nameStart;
+                while (nameEnd < _end && *nameEnd != '>' && *nameEnd != '/' && !isspace((unsigned char)*nameEnd))
+                    ++nameEnd;
+                const char* tagEnd = (const char*)memchr(nameEnd, '>', _end - nameEnd);
+                if (tagEnd == nullptr || nameEnd == nameStart)
+                    return Token::ERROR;
+
+                _value.assign(nameStart, nameEnd);
+                _p = tagEnd + 1;
+                if (closing)
+                    return Token::CLOSE;
+                return tagEnd[-1] == '/' ? Token::EMPTY : Token::OPEN;
+            }
+        }
+
+        bool startsWith(const char* prefix) const
+        {
+            size_t length = strlen(prefix);
+            return (size_t)(_end - _p) >= length && memcmp(_p, prefix, length) == 0;
+        }
+
+        bool skipPast(const char* terminator)
+        {
+            size_t length = strlen(terminator);
+            for (const char* p = _p; p + length <= _end; ++p)
+            {
+                if (memcmp(p, terminator, length) == 0)
+                {
+                    _p = p + length;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        static bool isBlank(const char* begin, const char* end)
+        {
+            for (; begin < end; ++begin)
+            {
+                if (!isspace((unsigned char)*begin))
+                    return false;
+            }
+            return true;
+        }
+
+        void decode(const char* begin, const char* end)
+        {
+            _value.clear();
+            while (begin < end)
+            {
+                const char* amp = (const char*)memchr(begin, '&', end - begin);
+                if (amp == nullptr)
+                {
+                    _value.append(begin, end);
+                    break;
+                }
+                _value.append(begin, amp);
+
+                const char* semicolon = (const char*)memchr(amp, ';', end - amp);
+                if (semicolon == nullptr)
+                {
+                    _value.append(amp, end);
+                    break;
+                }
+
+                std::string entity(amp + 1, semicolon);
+                if (entity == "amp") _value += '&';
+                else if (entity == "lt") _value += '<';
+                else if (entity == "gt") _value += '>';
+                else if (entity == "quot") _value += '"';
+                else if (entity == "apos") _value += '\'';
+                else if (!entity.empty() && entity[0] == '#')
+                {
+                    unsigned long code = entity.size() > 1 && (entity[1] == 'x' || entity[1] == 'X')
+                        ? strtoul(entity.c_str() + 2, nullptr, 16)
+                        : strtoul(entity.c_str() + 1, nullptr, 10);
+                    appendUTF8(code);
+                }
+                else
+                {
+                    _value.append(amp, semicolon + 1);
+                }
+                begin = semicolon + 1;
+            }
+        }
+
+        void appendUTF8(unsigned long code)
+        {
+            if (code < 0x80)
+            {
+                _value += (char)code;
+            }
+            else if (code < 0x800)
+            {
+                _value += (char)(0xC0 | (code >> 6));
+                _value += (char)(0x80 | (code & 0x3F));
+            }
+            else if (code < 0x10000)
+            {
+                _value += (char)(0xE0 | (code >> 12));
+                _value += (char)(0x80 | ((code >> 6) & 0x3F));
+                _value += (char)(0x80 | (code & 0x3F));
+            }
+            else
+            {
+                _value += (char)(0xF0 | (code >> 18));
+                _value += (char)(0x80 | ((code >> 12) & 0x3F));
+                _value += (char)(0x80 | ((code >> 6) & 0x3F));
+                _value += (char)(0x80 | (code & 0x3F));
+            }
+        }
+
+        const char* _p;
+        const char* _end;
+        std::string _value;
+        bool _peeked;
+        Token _peekedToken;
+    };
+
+    // the values of a frame dictionary, whatever the format; interpreted once the format is known
+    struct PlistFrame
+    {
+        PlistFrame()
+        : x(0), y(0), width(0), height(0), offsetX(0), offsetY(0), originalWidth(0), originalHeight(0)
+        , rotated(false), textureRotated(false)
+        {
+        }
+
+        std::string name;
+        // format 0
+        float x, y, width, height;
+        float offsetX, offsetY;
+        int originalWidth, originalHeight;
+        // formats 1 and 2
+        std::string frame;
+        std::string offset;
+        std::string sourceSize;
+        bool rotated;
+        // format 3
+        std::string spriteSize;
+        std::string spriteOffset;
+        std::string spriteSourceSize;
+        std::string textureRect;
+        bool textureRotated;
+        std::string anchor;
+        std::vector<std::string> aliases;
+        std::string vertices;
+        std::string verticesUV;
+        std::string triangles;
+    };
+
+    // reads a scalar value: text of <string>, <integer> and <real>, "true"/"false" for booleans
+    bool readScalar(PlistReader& reader, std::string* value)
+    {
+        auto token = reader.next();
+        if (token == PlistReader::Token::EMPTY)
+        {
+            // <true/>, <false/>, or an empty value such as <string/>
+            const std::string& tag = reader.value();
+            *value = tag == "true" || tag == "false" ? tag : std::string();
+            return true;
+        }
+        if (token != PlistReader::Token::OPEN)
+            return false;
+
+        std::string tag = reader.value();
+        if (tag == "dict" || tag == "array")
+        {
+            value->clear();
+            return reader.skipValue(token);
+        }
+        return reader.readText(tag, value);
+    }
+
+    bool readStringArray(PlistReader& reader, std::vector<std::string>* values)
+    {
+        auto token = reader.next();
+        if (token == PlistReader::Token::EMPTY)
+            return true;
+        if (token != PlistReader::Token::OPEN || reader.value() != "array")
+            return reader.skipValue(token);
+
+        for (;;)
+        {
+            token = reader.peek();
+            if (token == PlistReader::Token::CLOSE)
+            {
+                reader.next();
+                return true;
+            }
+            std::string value;
+            if (!readScalar(reader, &value))
+                return false;
+            values->push_back(value);
+        }
+    }
+
+    // iterates the keys of a dictionary whose <dict> was already read, calling
+    // handler(key) which must consume the value
+    template <typename Handler>
+    bool readDict(PlistReader& reader, Handler handler)
+    {
+        std::string key;
+        for (;;)
+        {
+            auto token = reader.next();
+            if (token == PlistReader::Token::CLOSE)
+                return reader.value() == "dict";
+            if (token != PlistReader::Token::OPEN || reader.value() != "key" || !reader.readText("key", &key))
+                return false;
+            if (!handler(key))
+                return false;
+        }
+    }
+
+    bool openDict(PlistReader& reader, bool* empty)
+    {
+        auto token = reader.next();
+        *empty = token == PlistReader::Token::EMPTY;
+        return (token == PlistReader::Token::OPEN || token == PlistReader::Token::EMPTY) && reader.value() == "dict";
+    }
+
+    bool readFrame(PlistReader& reader, PlistFrame* frame)
+    {
+        bool empty = false;
+        if (!openDict(reader, &empty))
+            return false;
+        if (empty)
+            return true;
+
+        std::string value;
+        return readDict(reader, [&](const std::string& key) {
+            if (key == "aliases")
+                return readStringArray(reader, &frame->aliases);
+            if (!readScalar(reader, &value))
+                return false;
+
+            if (key == "x") frame->x = (float)atof(value.c_str());
+            else if (key == "y") frame->y = (float)atof(value.c_str());
+            else if (key == "width") frame->width = (float)atof(value.c_str());
+            else if (key == "height") frame->height = (float)atof(value.c_str());
+            else if (key == "offsetX") frame->offsetX = (float)atof(value.c_str());
+            else if (key == "offsetY") frame->offsetY = (float)atof(value.c_str());
+            else if (key == "originalWidth") frame->originalWidth = atoi(value.c_str());
+            else if (key == "originalHeight") frame->originalHeight = atoi(value.c_str());
+            else if (key == "frame") frame->frame = value;
+            else if (key == "offset") frame->offset = value;
+            else if (key == "sourceSize") frame->sourceSize = value;
+            else if (key == "rotated") frame->rotated = value == "true";
+            else if (key == "spriteSize") frame->spriteSize = value;
+            else if (key == "spriteOffset") frame->spriteOffset = value;
+            else if (key == "spriteSourceSize") frame->spriteSourceSize = value;
+            else if (key == "textureRect") frame->textureRect = value;
+            else if (key == "textureRotated") frame->textureRotated = value == "true";
+            else if (key == "anchor") frame->anchor = value;
+            else if (key == "vertices") frame->vertices = value;
+            else if (key == "verticesUV") frame->verticesUV = value;
+            else if (key == "triangles") frame->triangles = value;
+            return true;
+        });
+    }
+
+    void parseIntegerList(const std::string& string, std::vector<int>* values)
+    {
+        const char* p = string.c_str();
+        char* end = nullptr;
+        for (;;)
+        {
+            long value = strtol(p, &end, 10);
+            if (end == p)
+                break;
+            values->push_back((int)value);
+            p = end;
+        }
+    }
+
+    void convertFrame(PlistFrame& source, int format, SpriteSheet::Frame* frame)
+    {
+        frame->name = std::move(source.name);
+        frame->rotated = false;
+        frame->hasAnchor = false;
+
+        if (format == 0)
+        {
+            // check ow/oh
+            if (!source.originalWidth || !source.originalHeight)
+            {
+                CCLOGWARN("cocos2d: WARNING: originalWidth/Height not found on the SpriteFrame. AnchorPoint won't work as expected. Regenerate the .plist");
+            }
+            frame->rect.setRect(source.x, source.y, source.width, source.height);
+            frame->offset.set(source.offsetX, source.offsetY);
+            frame->originalSize.setSize((float)std::abs(source.originalWidth), (float)std::abs(source.originalHeight));
+        }
+        else if (format == 1 || format == 2)
+        {
+            frame->rect = RectFromString(source.frame);
+            frame->rotated = format == 2 && source.rotated;
+            frame->offset = PointFromString(source.offset);
+            frame->originalSize = SizeFromString(source.sourceSize);
+        }
+        else
+        {
+            Size spriteSize = SizeFromString(source.spriteSize);
+            Rect textureRect = RectFromString(source.textureRect);
+            frame->rect.setRect(textureRect.origin.x, textureRect.origin.y, spriteSize.width, spriteSize.height);
+            frame->rotated = source.textureRotated;
+            frame->offset = PointFromString(source.spriteOffset);
+            frame->originalSize = SizeFromString(source.spriteSourceSize);
+            frame->aliases = std::move(source.aliases);
+
+            if (!source.anchor.empty())
+            {
+                frame->hasAnchor = true;
+                frame->anchor = PointFromString(source.anchor);
+            }
+            if (!source.vertices.empty())
+            {
+                parseIntegerList(source.vertices, &frame->vertices);
+                parseIntegerList(source.verticesUV, &frame->verticesUV);
+                parseIntegerList(source.triangles, &frame->triangles);
+            }
+        }
+    }
+}
+
+SpriteSheet::SpriteSheet()
+: format(0)
+{
+}
+
+bool SpriteSheet::isBinary(const unsigned char* bytes, size_t size)
+{
+    return size >= sizeof(BinaryHeader) && memcmp(bytes, BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0;
+}
+
+bool SpriteSheet::initWithData(const Data& data)
+{
+    if (data.isNull())
+        return false;
+
+    if (isBinary(data.getBytes(), data.getSize()))
+        return initWithBinary(data.getBytes(), data.getSize());
+    return initWithPlist((const char*)data.getBytes(), data.getSize());
+}
+
+bool SpriteSheet::initWithPlist(const char* xml, size_t size)
+{
+    format = 0;
+    textureSize = Size::ZERO;
+    textureFileName.clear();
+    pixelFormat.clear();
+    frames.clear();
+
+    PlistReader reader(xml, size);
+    auto token = reader.next();
+    if (token != PlistReader::Token::OPEN || reader.value() != "plist")
+        return false;
+
+    bool empty = false;
+    if (!openDict(reader, &empty) || empty)
+        return false;
+
+    std::vector<PlistFrame> plistFrames;
+    bool hasFrames = false;
+    bool succeeded = readDict(reader, [&](const std::string& key) {
+        if (key == "frames")
+        {
+            bool framesEmpty = false;
+            if (!openDict(reader, &framesEmpty))
+                return false;
+            hasFrames = true;
+            if (framesEmpty)
+                return true;
+
+            return readDict(reader, [&](const std::string& name) {
+                plistFrames.push_back(PlistFrame());
+                plistFrames.back().name = name;
+                return readFrame(reader, &plistFrames.back());
+            });
+        }
+        if (key == "metadata")
+        {
+            bool metadataEmpty = false;
+            if (!openDict(reader, &metadataEmpty))
+                return false;
+            if (metadataEmpty)
+                return true;
+
+            std::string value;
+            return readDict(reader, [&](const std::string& metadataKey) {
+                if (!readScalar(reader, &value))
+                    return false;
+                if (metadataKey == "format") format = atoi(value.c_str());
+                else if (metadataKey == "size") textureSize = SizeFromString(value);
+                else if (metadataKey == "textureFileName") textureFileName = value;
+                else if (metadataKey == "pixelFormat") pixelFormat = value;
+                return true;
+            });
+        }
+        return reader.skipValue(reader.next());
+    });
+
+    if (!succeeded || !hasFrames)
+        return false;
+
+    // check the format
+    CCASSERT(format >= 0 && format <= 3, "format is not supported for SpriteSheet");
+    if (format < 0 || format > 3)
+        return false;
+
+    frames.resize(plistFrames.size());
+    for (size_t i = 0; i < plistFrames.size(); ++i)
+    {
+        convertFrame(plistFrames[i], format, &frames[i]);
+    }
+    return true;
+}
+
+bool SpriteSheet::initWithBinary(const unsigned char* bytes, size_t size)
+{
+    format = 0;
+    textureSize = Size::ZERO;
+    textureFileName.clear();
+    pixelFormat.clear();
+    frames.clear();
+
+    if (!isBinary(bytes, size))
+        return false;
+
+    BinaryHeader header;
+    memcpy(&header, bytes, sizeof(header));
+    if (header.version != BINARY_VERSION
+        || !inRange(header.framesOffset, (size_t)header.frameCount * sizeof(BinaryFrame), size)
+        || !inRange(header.aliasesOffset, (size_t)header.aliasCount * sizeof(BinaryAlias), size)
+        || !inRange(header.polygonsOffset, (size_t)header.polygonIntCount * sizeof(int32_t), size)
+        || !inRange(header.stringsOffset, header.stringsSize, size))
+    {
+        CCLOG("cocos2d: SpriteSheet: malformed binary sprite sheet");
+        return false;
+    }
+
+    const char* strings = (const char*)bytes + header.stringsOffset;
+    auto getString = [&](uint32_t offset, uint32_t length, std::string* value) {
+        if (!inRange(offset, length, header.stringsSize))
+            return false;
+        value->assign(strings + offset, length);
+        return true;
+    };
+
+    format = (int)header.format;
+    textureSize.setSize(header.textureWidth, header.textureHeight);
+    if (!getString(header.textureNameOffset, header.textureNameLength, &textureFileName)
+        || !getString(header.pixelFormatOffset, header.pixelFormatLength, &pixelFormat))
+        return false;
+
+    const unsigned char* polygons = bytes + header.polygonsOffset;
+    auto getInts = [&](size_t offset, uint32_t count, std::vector<int>* values) {
+        if (!inRange(offset, count, header.polygonIntCount))
+            return false;
+        values->resize(count);
+        if (count > 0)
+        {
+            static_assert(sizeof(int) == sizeof(int32_t), "int must be 32 bits");
+            memcpy(values->data(), polygons + (size_t)offset * sizeof(int32_t), count * sizeof(int32_t));
+        }
+        return true;
+    };
+
+    frames.resize(header.frameCount);
+    for (uint32_t i = 0; i < header.frameCount; ++i)
+    {
+        BinaryFrame record;
+        memcpy(&record, bytes + header.framesOffset + (size_t)i * sizeof(BinaryFrame), sizeof(record));
+
+        Frame& frame = frames[i];
+        frame.rect.setRect(record.x, record.y, record.width, record.height);
+        frame.rotated = (record.flags & FRAME_ROTATED) != 0;
+        frame.offset.set(record.offsetX, record.offsetY);
+        frame.originalSize.setSize(record.originalWidth, record.originalHeight);
+        frame.hasAnchor = (record.flags & FRAME_HAS_ANCHOR) != 0;
+        frame.anchor.set(record.anchorX, record.anchorY);
+
+        if (!getString(record.nameOffset, record.nameLength, &frame.name)
+            || !getInts(record.polygonOffset, record.vertexIntCount, &frame.vertices)
+            || !getInts((size_t)record.polygonOffset + record.vertexIntCount, record.vertexIntCount, &frame.verticesUV)
+            || !getInts((size_t)record.polygonOffset + (size_t)record.vertexIntCount * 2, record.triangleIndexCount, &frame.triangles))
+        {
+            CCLOG("cocos2d: SpriteSheet: malformed frame %u in binary sprite sheet", i);
+            frames.clear();
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < header.aliasCount; ++i)
+    {
+        BinaryAlias record;
+        memcpy(&record, bytes + header.aliasesOffset + (size_t)i * sizeof(BinaryAlias), sizeof(record));
+
+        std::string alias;
+        if (record.frameIndex >= header.frameCount || !getString(record.nameOffset, record.nameLength, &alias))
+        {
+            CCLOG("cocos2d: SpriteSheet: malformed alias %u in binary sprite sheet", i);
+            frames.clear();
+            return false;
+        }
+        frames[record.frameIndex].aliases.push_back(std::move(alias));
+    }
+    return true;
+}
+
+NS_CC_END
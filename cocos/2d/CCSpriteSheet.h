@@ -0,0 +1,111 @@
+/****************************************************************************
+Copyright (c) 2017-2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CC_SPRITE_SHEET_H__
+#define __CC_SPRITE_SHEET_H__
+
+#include <string>
+#include <vector>
+
+#include "platform/CCPlatformMacros.h"
+#include "math/CCGeometry.h"
+
+NS_CC_BEGIN
+
+class Data;
+
+/**
+ * @addtogroup _2d
+ * @{
+ */
+
+/**
+ * Description of the frames of a sprite sheet, decoded without creating any engine object.
+ *
+ * A sprite sheet can be decoded from a XML plist (the format read by SpriteFrameCache, without
+ * building a ValueMap) or from a binary sprite sheet. Binary sprite sheets are made of fixed
+ * size records and a string table, decoding them doesn't parse anything. Use
+ * `tools/sprite-sheet/compile_sprite_sheet.py` to convert plists to binary sprite sheets.
+ *
+ * Decoding doesn't touch any shared state, so it can be done from any thread. SpriteFrameCache
+ * creates the SpriteFrames from it on the cocos thread.
+ * @since v3.18
+ * @js NA
+ * @lua NA
+ */
+class CC_DLL SpriteSheet
+{
+public:
+    /** A frame of the sheet, geometry is normalized to what SpriteFrame::createWithTexture() expects. */
+    struct Frame
+    {
+        std::string name;
+        Rect rect;
+        bool rotated;
+        Vec2 offset;
+        Size originalSize;
+        bool hasAnchor;
+        Vec2 anchor;
+        std::vector<std::string> aliases;
+        /** polygon outline, empty if the frame is a quad */
+        std::vector<int> vertices;
+        std::vector<int> verticesUV;
+        std::vector<int> triangles;
+    };
+
+    SpriteSheet();
+
+    /**
+     * Decodes a XML plist or a binary sprite sheet, replacing the current content.
+     *
+     * @return False if the data is neither a XML plist nor a binary sprite sheet, or is malformed.
+     */
+    bool initWithData(const Data& data);
+
+    /** Decodes a XML plist sprite sheet. */
+    bool initWithPlist(const char* xml, size_t size);
+
+    /** Decodes a binary sprite sheet. */
+    bool initWithBinary(const unsigned char* bytes, size_t size);
+
+    /** Checks whether the data starts like a binary sprite sheet. */
+    static bool isBinary(const unsigned char* bytes, size_t size);
+
+    /** format of the original plist, 0 to 3 */
+    int format;
+    /** size of the texture in pixels, may be zero if the sheet doesn't tell */
+    Size textureSize;
+    /** texture file name relative to the sheet, may be empty */
+    std::string textureFileName;
+    /** pixel format name, e.g. "RGBA4444", may be empty */
+    std::string pixelFormat;
+    std::vector<Frame> frames;
+};
+
+// end of _2d group
+/// @}
+
+NS_CC_END
+
+#endif // __CC_SPRITE_SHEET_H__
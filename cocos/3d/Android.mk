@@ -9,6 +9,7 @@ LOCAL_MODULE_FILENAME := libc3d
 LOCAL_SRC_FILES := \
 CCRay.cpp \
 CCAABB.cpp \
+CCAABBTree.cpp \
 CCOBB.cpp \
 CCAnimate3D.cpp \
 CCAnimation3D.cpp \
@@ -17,6 +18,8 @@ CCBillBoard.cpp \
 CCBundle3D.cpp \
 CCBundleReader.cpp \
 CCMesh.cpp \
+CCMeshSimplifier.cpp \
+CCMeshOptimizer.cpp \
 CCMeshSkin.cpp \
 CCMeshVertexIndexData.cpp \
 CCMotionStreak3D.cpp \
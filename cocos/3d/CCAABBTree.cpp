@@ -0,0 +1,451 @@
+/****************************************************************************
+Copyright (c) 2017-2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "3d/CCAABBTree.h"
+
+#include <algorithm>
+
+#include "2d/CCCamera.h"
+#include "2d/CCScene.h"
+#include "3d/CCFrustum.h"
+#include "3d/CCRay.h"
+#include "base/ccMacros.h"
+
+NS_CC_BEGIN
+
+namespace
+{
+    const int NULL_NODE = -1;
+
+    float surfaceArea(const AABB& aabb)
+    {
+        Vec3 size = aabb._max - aabb._min;
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    AABB combine(const AABB& a, const AABB& b)
+    {
+        AABB result(a);
+        result.merge(b);
+        return result;
+    }
+
+    bool contains(const AABB& outer, const AABB& inner)
+    {
+        return outer._min.x <= inner._min.x && outer._min.y <= inner._min.y && outer._min.z <= inner._min.z
+            && outer._max.x >= inner._max.x && outer._max.y >= inner._max.y && outer._max.z >= inner._max.z;
+    }
+}
+
+AABBTree::AABBTree()
+: _root(NULL_NODE)
+, _freeList(NULL_NODE)
+, _proxyCount(0)
+, _margin(0.1f)
+, _cullingStamp(0)
+, _cullingViewer(nullptr)
+{
+}
+
+AABBTree::~AABBTree()
+{
+}
+
+int AABBTree::allocateNode()
+{
+    if (_freeList == NULL_NODE)
+    {
+        TreeNode node;
+        node.parent = NULL_NODE;
+        node.height = -1;
+        _nodes.push_back(node);
+        _freeList = (int)_nodes.size() - 1;
+    }
+
+    int nodeId = _freeList;
+    TreeNode& node = _nodes[nodeId];
+    _freeList = node.parent;
+    node.userData = nullptr;
+    node.parent = NULL_NODE;
+    node.child1 = NULL_NODE;
+    node.child2 = NULL_NODE;
+    node.height = 0;
+    node.cullingStamp = 0;
+    return nodeId;
+}
+
+void AABBTree::freeNode(int nodeId)
+{
+    _nodes[nodeId].parent = _freeList;
+    _nodes[nodeId].height = -1;
+    _freeList = nodeId;
+}
+
+int AABBTree::createProxy(const AABB& aabb, void* userData)
+{
+    int proxyId = allocateNode();
+    Vec3 margin(_margin, _margin, _margin);
+    _nodes[proxyId].aabb.set(aabb._min - margin, aabb._max + margin);
+    _nodes[proxyId].userData = userData;
+    insertLeaf(proxyId);
+    ++_proxyCount;
+    return proxyId;
+}
+
+void AABBTree::destroyProxy(int proxyId)
+{
+    CCASSERT(proxyId >= 0 && proxyId < (int)_nodes.size() && _nodes[proxyId].isLeaf(), "invalid proxy");
+    removeLeaf(proxyId);
+    freeNode(proxyId);
+    --_proxyCount;
+}
+
+bool AABBTree::moveProxy(int proxyId, const AABB& aabb)
+{
+    CCASSERT(proxyId >= 0 && proxyId < (int)_nodes.size() && _nodes[proxyId].isLeaf(), "invalid proxy");
+    if (contains(_nodes[proxyId].aabb, aabb))
+        return false;
+
+    removeLeaf(proxyId);
+    Vec3 margin(_margin, _margin, _margin);
+    _nodes[proxyId].aabb.set(aabb._min - margin, aabb._max + margin);
+    insertLeaf(proxyId);
+    return true;
+}
+
+void AABBTree::insertLeaf(int leaf)
+{
+    if (_root == NULL_NODE)
+    {
+        _root = leaf;
+        _nodes[_root].parent = NULL_NODE;
+        return;
+    }
+
+    // find the best sibling: the one which makes the surface of the tree grow the least
+    const AABB leafAABB = _nodes[leaf].aabb;
+    int index = _root;
+    while (!_nodes[index].isLeaf())
+    {
+        int child1 = _nodes[index].child1;
+        int child2 = _nodes[index].child2;
+
+        float area = surfaceArea(_nodes[index].aabb);
+        float combinedArea = surfaceArea(combine(_nodes[index].aabb, leafAABB));
+
+        // cost of making a new parent for this node and the leaf
+        float cost = 2.0f * combinedArea;
+        // minimum cost of pushing the leaf further down the tree
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        float cost1 = surfaceArea(combine(leafAABB, _nodes[child1].aabb)) + inheritanceCost;
+        if (!_nodes[child1].isLeaf())
+            cost1 -= surfaceArea(_nodes[child1].aabb);
+        float cost2 = surfaceArea(combine(leafAABB, _nodes[child2].aabb)) + inheritanceCost;
+        if (!_nodes[child2].isLeaf())
+            cost2 -= surfaceArea(_nodes[child2].aabb);
+
+        if (cost < cost1 && cost < cost2)
+            break;
+        index = cost1 < cost2 ? child1 : child2;
+    }
+
+    int sibling = index;
+    int oldParent = _nodes[sibling].parent;
+    int newParent = allocateNode();
+    _nodes[newParent].parent = oldParent;
+    _nodes[newParent].aabb = combine(leafAABB, _nodes[sibling].aabb);
+    _nodes[newParent].height = _nodes[sibling].height + 1;
+    _nodes[newParent].child1 = sibling;
+    _nodes[newParent].child2 = leaf;
+    _nodes[sibling].parent = newParent;
+    _nodes[leaf].parent = newParent;
+
+    if (oldParent != NULL_NODE)
+    {
+        if (_nodes[oldParent].child1 == sibling)
+            _nodes[oldParent].child1 = newParent;
+        else
+            _nodes[oldParent].child2 = newParent;
+    }
+    else
+    {
+        _root = newParent;
+    }
+
+    // refit and rebalance the ancestors
+    index = _nodes[leaf].parent;
+    while (index != NULL_NODE)
+    {
+        index = balance(index);
+
+        int child1 = _nodes[index].child1;
+        int child2 = _nodes[index].child2;
+        _nodes[index].height = 1 + std::max(_nodes[child1].height, _nodes[child2].height);
+        _nodes[index].aabb = combine(_nodes[child1].aabb, _nodes[child2].aabb);
+
+        index = _nodes[index].parent;
+    }
+}
+
+void AABBTree::removeLeaf(int leaf)
+{
+    if (leaf == _root)
+    {
+        _root = NULL_NODE;
+        return;
+    }
+
+    int parent = _nodes[leaf].parent;
+    int grandParent = _nodes[parent].parent;
+    int sibling = _nodes[parent].child1 == leaf ? _nodes[parent].child2 : _nodes[parent].child1;
+
+    if (grandParent == NULL_NODE)
+    {
+        _root = sibling;
+        _nodes[sibling].parent = NULL_NODE;
+        freeNode(parent);
+        return;
+    }
+
+    // the sibling takes the place of the parent
+    if (_nodes[grandParent].child1 == parent)
+        _nodes[grandParent].child1 = sibling;
+    else
+        _nodes[grandParent].child2 = sibling;
+    _nodes[sibling].parent = grandParent;
+    freeNode(parent);
+
+    int index = grandParent;
+    while (index != NULL_NODE)
+    {
+        index = balance(index);
+
+        int child1 = _nodes[index].child1;
+        int child2 = _nodes[index].child2;
+        _nodes[index].aabb = combine(_nodes[child1].aabb, _nodes[child2].aabb);
+        _nodes[index].height = 1 + std::max(_nodes[child1].height, _nodes[child2].height);
+
+        index = _nodes[index].parent;
+    }
+}
+
+int AABBTree::balance(int iA)
+{
+    // rotates the highest grand child of A up if its children heights differ by more than one,
+    // returns the node now at the place of A
+    TreeNode& A = _nodes[iA];
+    if (A.isLeaf() || A.height < 2)
+        return iA;
+
+    int iB = A.child1;
+    int iC = A.child2;
+    int balanceFactor = _nodes[iC].height - _nodes[iB].height;
+    if (balanceFactor >= -1 && balanceFactor <= 1)
+        return iA;
+
+    // the higher child goes up
+    int iUp = balanceFactor > 1 ? iC : iB;
+    int iOther = balanceFactor > 1 ? iB : iC;
+    TreeNode& up = _nodes[iUp];
+    int iF = up.child1;
+    int iG = up.child2;
+
+    up.child1 = iA;
+    up.parent = A.parent;
+    A.parent = iUp;
+
+    if (up.parent != NULL_NODE)
+    {
+        if (_nodes[up.parent].child1 == iA)
+            _nodes[up.parent].child1 = iUp;
+        else
+            _nodes[up.parent].child2 = iUp;
+    }
+    else
+    {
+        _root = iUp;
+    }
+
+    // the higher grand child stays under the raised node, the other one replaces it under A
+    int iKeep = _nodes[iF].height > _nodes[iG].height ? iF : iG;
+    int iMove = iKeep == iF ? iG : iF;
+    up.child2 = iKeep;
+    if (balanceFactor > 1)
+        A.child2 = iMove;
+    else
+        A.child1 = iMove;
+    _nodes[iMove].parent = iA;
+
+    A.aabb = combine(_nodes[iOther].aabb, _nodes[iMove].aabb);
+    A.height = 1 + std::max(_nodes[iOther].height, _nodes[iMove].height);
+    up.aabb = combine(A.aabb, _nodes[iKeep].aabb);
+    up.height = 1 + std::max(A.height, _nodes[iKeep].height);
+
+    return iUp;
+}
+
+void AABBTree::query(const AABB& aabb, const std::function<bool(int proxyId)>& callback) const
+{
+    if (_root == NULL_NODE)
+        return;
+
+    std::vector<int> stack;
+    stack.reserve(64);
+    stack.push_back(_root);
+    while (!stack.empty())
+    {
+        int nodeId = stack.back();
+        stack.pop_back();
+
+        const TreeNode& node = _nodes[nodeId];
+        if (!node.aabb.intersects(aabb))
+            continue;
+        if (node.isLeaf())
+        {
+            if (!callback(nodeId))
+                return;
+        }
+        else
+        {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+void AABBTree::query(const Frustum& frustum, const std::function<bool(int proxyId)>& callback) const
+{
+    if (_root == NULL_NODE)
+        return;
+
+    std::vector<int> stack;
+    stack.reserve(64);
+    stack.push_back(_root);
+    while (!stack.empty())
+    {
+        int nodeId = stack.back();
+        stack.pop_back();
+
+        const TreeNode& node = _nodes[nodeId];
+        if (frustum.isOutOfFrustum(node.aabb))
+            continue;
+        if (node.isLeaf())
+        {
+            if (!callback(nodeId))
+                return;
+        }
+        else
+        {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+void AABBTree::rayCast(const Ray& ray, float maxDistance, const std::function<float(int proxyId, float distance)>& callback) const
+{
+    if (_root == NULL_NODE)
+        return;
+
+    std::vector<int> stack;
+    stack.reserve(64);
+    stack.push_back(_root);
+    while (!stack.empty())
+    {
+        int nodeId = stack.back();
+        stack.pop_back();
+
+        const TreeNode& node = _nodes[nodeId];
+        float distance = 0;
+        if (!ray.intersects(node.aabb, &distance) || distance > maxDistance)
+            continue;
+        if (node.isLeaf())
+        {
+            maxDistance = callback(nodeId, distance);
+            if (maxDistance < 0)
+                return;
+        }
+        else
+        {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+void AABBTree::cull(const Frustum& frustum, const void* viewer)
+{
+    // the proxies not reached keep an older stamp and become invisible
+    ++_cullingStamp;
+    _cullingViewer = viewer;
+    query(frustum, [this](int proxyId) {
+        _nodes[proxyId].cullingStamp = _cullingStamp;
+        return true;
+    });
+}
+
+AABBTreeProxy::AABBTreeProxy()
+: _tree(nullptr)
+, _proxyId(NULL_NODE)
+, _moveStamp(0)
+{
+}
+
+void AABBTreeProxy::attach(Node* node, const AABB& aabb)
+{
+    auto scene = node->getScene();
+    if (scene && scene->getAABBTree())
+    {
+        _tree = scene->getAABBTree();
+        _proxyId = _tree->createProxy(aabb, node);
+        _moveStamp = _tree->getCullingStamp();
+    }
+}
+
+void AABBTreeProxy::detach()
+{
+    if (_tree)
+    {
+        _tree->destroyProxy(_proxyId);
+        _tree = nullptr;
+        _proxyId = NULL_NODE;
+    }
+}
+
+void AABBTreeProxy::move(const AABB& aabb)
+{
+    // while the box fits in the fat box of the proxy, the last cull still holds for it
+    if (_tree && _tree->moveProxy(_proxyId, aabb))
+    {
+        _moveStamp = _tree->getCullingStamp();
+    }
+}
+
+bool AABBTreeProxy::isCulledFor(const Camera* camera) const
+{
+    return _tree && camera && _tree->getCullingViewer() == camera && _tree->getCullingStamp() != _moveStamp;
+}
+
+NS_CC_END
@@ -0,0 +1,193 @@
+/****************************************************************************
+Copyright (c) 2017-2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CC_AABB_TREE_H__
+#define __CC_AABB_TREE_H__
+
+#include <functional>
+#include <vector>
+
+#include "3d/CCAABB.h"
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup _3d
+ * @{
+ */
+
+class Camera;
+class Frustum;
+class Node;
+class Ray;
+
+/**
+ * A dynamic bounding volume hierarchy of AABBs.
+ *
+ * Every object is a leaf (a proxy) with its box enlarged by a margin, so small moves don't change the tree.
+ * Leaves are inserted next to the sibling which enlarges the tree the least and the tree is rebalanced with
+ * rotations on the way up, so the queries stay logarithmic however the objects are added and moved.
+ *
+ * Every Scene has one holding its 3D nodes, which is used by the cameras to cull them and can be queried,
+ * e.g. for picking, see Scene::getAABBTree(). The user data of its proxies are the Nodes, see AABBTreeProxy.
+ * @since v3.18
+ * @js NA
+ * @lua NA
+ */
+class CC_DLL AABBTree
+{
+public:
+    AABBTree();
+    ~AABBTree();
+
+    /**
+     * Adds an object.
+     * @return The proxy id of the object, to move or remove it.
+     */
+    int createProxy(const AABB& aabb, void* userData);
+    /** Removes an object. */
+    void destroyProxy(int proxyId);
+    /**
+     * Updates the box of an object.
+     * @return true if the tree changed, false if the box still fits in the enlarged box of the proxy.
+     */
+    bool moveProxy(int proxyId, const AABB& aabb);
+
+    void* getUserData(int proxyId) const { return _nodes[proxyId].userData; }
+    /** enlarged box of a proxy, which contains the box it was last given */
+    const AABB& getFatAABB(int proxyId) const { return _nodes[proxyId].aabb; }
+
+    /** Number of objects */
+    int getProxyCount() const { return _proxyCount; }
+    /** Height of the tree, 0 for a single object */
+    int getHeight() const { return _root < 0 ? 0 : _nodes[_root].height; }
+
+    /** Enlargement of the boxes, in world units. Applies to the proxies created or moved afterwards. Defaults to 0.1. */
+    void setMargin(float margin) { _margin = margin; }
+    float getMargin() const { return _margin; }
+
+    /**
+     * Calls the callback with every proxy whose box intersects aabb, until it returns false.
+     */
+    void query(const AABB& aabb, const std::function<bool(int proxyId)>& callback) const;
+    /**
+     * Calls the callback with every proxy whose box isn't out of the frustum, until it returns false.
+     */
+    void query(const Frustum& frustum, const std::function<bool(int proxyId)>& callback) const;
+    /**
+     * Calls the callback with every proxy whose box is hit by the ray closer than the current maximum distance.
+     * The callback returns the new maximum distance, e.g. the distance of the hit to find the closest object,
+     * or a negative value to stop.
+     *
+     * @param maxDistance Initial maximum distance.
+     */
+    void rayCast(const Ray& ray, float maxDistance, const std::function<float(int proxyId, float distance)>& callback) const;
+
+    /**
+     * Marks the proxies which aren't out of a frustum as visible, and the others as invisible.
+     * @param viewer What the culling is done for, e.g. the camera, see getCullingViewer().
+     */
+    void cull(const Frustum& frustum, const void* viewer);
+    /** what the last cull() was done for, nullptr after resetCulling() */
+    const void* getCullingViewer() const { return _cullingViewer; }
+    void resetCulling() { _cullingViewer = nullptr; }
+    /** whether the proxy was visible at the last cull() */
+    bool isVisible(int proxyId) const { return _nodes[proxyId].cullingStamp == _cullingStamp; }
+    /** incremented by every cull(), e.g. to know whether a proxy moved since the last one */
+    unsigned int getCullingStamp() const { return _cullingStamp; }
+
+private:
+    struct TreeNode
+    {
+        AABB aabb;
+        void* userData;
+        int parent; // also the next free node when the node isn't used
+        int child1;
+        int child2;
+        int height; // 0 for a leaf, -1 for a free node
+        unsigned int cullingStamp;
+
+        bool isLeaf() const { return child1 < 0; }
+    };
+
+    int allocateNode();
+    void freeNode(int nodeId);
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    int balance(int nodeId);
+
+    std::vector<TreeNode> _nodes;
+    int _root;
+    int _freeList;
+    int _proxyCount;
+    float _margin;
+    unsigned int _cullingStamp;
+    const void* _cullingViewer;
+};
+
+/**
+ * The proxy of a node in the AABBTree of its scene, through which the cameras cull the node.
+ *
+ * The node attaches it when it enters the scene, moves it when its box changes during the visit and detaches it
+ * when it exits. A camera culls the tree before visiting the scene, so the nodes it culled out can skip their
+ * draw, or their whole visit, without testing their box. See Sprite3D, BillBoard and Terrain.
+ * @since v3.18
+ * @js NA
+ * @lua NA
+ */
+class CC_DLL AABBTreeProxy
+{
+public:
+    AABBTreeProxy();
+
+    /** Adds the node to the tree of its scene, if it has one, with its box in world space. */
+    void attach(Node* node, const AABB& aabb);
+    /** Removes the node from the tree. */
+    void detach();
+    bool isAttached() const { return _tree != nullptr; }
+    /** Updates the box of the node, in world space. */
+    void move(const AABB& aabb);
+
+    /**
+     * Whether the tree was culled for the camera since the proxy last moved in it, i.e. whether isVisible() is
+     * up to date for that camera.
+     */
+    bool isCulledFor(const Camera* camera) const;
+    /** whether the proxy was visible at the last cull of the tree */
+    bool isVisible() const { return _tree->isVisible(_proxyId); }
+    /** whether the camera culled the node out of its frustum through the tree */
+    bool isOutOfFrustum(const Camera* camera) const { return isCulledFor(camera) && !isVisible(); }
+
+private:
+    AABBTree* _tree; // tree of the scene while running, weak ref
+    int _proxyId;
+    unsigned int _moveStamp; // culling stamp of the tree when the proxy last moved
+};
+
+// end of 3d group
+/// @}
+
+NS_CC_END
+
+#endif // __CC_AABB_TREE_H__
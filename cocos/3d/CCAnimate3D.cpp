@@ -24,13 +24,20 @@
  ****************************************************************************/
 
 #include "3d/CCAnimate3D.h"
+
+#include <algorithm>
+
 #include "3d/CCSprite3D.h"
 #include "3d/CCSkeleton3D.h"
+#include "3d/CCMesh.h"
+#include "3d/CCMeshSkin.h"
 #include "platform/CCFileUtils.h"
 #include "base/CCConfiguration.h"
 #include "base/CCEventCustom.h"
 #include "base/CCDirector.h"
 #include "base/CCEventDispatcher.h"
+#include "base/CCEventListenerCustom.h"
+#include "base/CCAsyncTaskPool.h"
 
 NS_CC_BEGIN
 
@@ -38,6 +45,31 @@ std::unordered_map<Node*, Animate3D*> Animate3D::s_fadeInAnimates;
 std::unordered_map<Node*, Animate3D*> Animate3D::s_fadeOutAnimates;
 std::unordered_map<Node*, Animate3D*> Animate3D::s_runningAnimates;
 float      Animate3D::_transTime = 0.1f;
+bool       Animate3D::s_parallelEvaluation = true;
+Vector<Animate3D*> Animate3D::s_pendingAnimates;
+
+// the pending sprites are evaluated by groups of about this many animated bones
+static const int BONES_PER_EVALUATION_JOB = 512;
+
+static EventListenerCustom* s_afterUpdateListener = nullptr;
+
+// the pending animations are evaluated once the scheduler is done, before the listeners of the user
+static void listenAfterUpdate()
+{
+    if (s_afterUpdateListener)
+        return;
+
+    auto dispatcher = Director::getInstance()->getEventDispatcher();
+    s_afterUpdateListener = EventListenerCustom::create(Director::EVENT_AFTER_UPDATE, [](EventCustom*) {
+        Animate3D::evaluatePendingAnimations();
+    });
+    dispatcher->addEventListenerWithFixedPriority(s_afterUpdateListener, -1);
+    // the director removes all the listeners when it is reset, the animations left are evaluated first
+    dispatcher->addCustomEventListener(Director::EVENT_RESET, [](EventCustom*) {
+        Animate3D::evaluatePendingAnimations();
+        s_afterUpdateListener = nullptr;
+    });
+}
 
 //create Animate3D using Animation.
 Animate3D* Animate3D::create(Animation3D* animation)
@@ -148,6 +180,14 @@ Node* findChildByNameRecursively(Node* node, const std::string &childName)
 void Animate3D::startWithTarget(Node *target)
 {
     bool needReMap = (_target != target);
+    // the curves are remapped below, the pending values are for the bones of the previous target
+    if (needReMap && _evaluationPending)
+    {
+        evaluateBoneCurves(_pendingTime, _pendingWeight);
+        _evaluationPending = false;
+        CC_SAFE_RELEASE_NULL(_pendingTarget);
+    }
+
     ActionInterval::startWithTarget(target);
     
     if (needReMap)
@@ -227,6 +267,10 @@ void Animate3D::startWithTarget(Node *target)
         {
             CCLOG("warning: no animation found for the skeleton");
         }
+        
+        // translation, rotation and scale cursors of the curves, in the iteration order of the maps
+        _boneCurveCursors.assign(_boneCurves.size() * 3, 0);
+        _nodeCurveCursors.assign(_nodeCurves.size() * 3, 0);
     }
     
     auto runningAction = s_runningAnimates.find(target);
@@ -335,7 +379,6 @@ void Animate3D::update(float t)
             if (_weight > 0.0f)
             {
                 float transDst[3], rotDst[4], scaleDst[3];
-                float* trans = nullptr, *rot = nullptr, *scale = nullptr;
                 if (_playReverse){
                     t = 1 - t;
                     lastTime = 1.0f - lastTime;
@@ -344,27 +387,31 @@ void Animate3D::update(float t)
                 t = _start + t * _last;
                 lastTime = _start + lastTime * _last;
                 
-                for (const auto& it : _boneCurves) {
-                    auto bone = it.first;
-                    auto curve = it.second;
-                    if (curve->translateCurve)
-                    {
-                        curve->translateCurve->evaluate(t, transDst, _translateEvaluate);
-                        trans = &transDst[0];
-                    }
-                    if (curve->rotCurve)
+                if (s_parallelEvaluation && !_boneCurves.empty())
+                {
+                    // a second update in the frame replaces the values of the first one, as the bones would
+                    _pendingTime = t;
+                    _pendingWeight = _weight;
+                    if (!_evaluationPending)
                     {
-                        curve->rotCurve->evaluate(t, rotDst, _roteEvaluate);
-                        rot = &rotDst[0];
+                        // the sprite may be removed before the evaluation
+                        _evaluationPending = true;
+                        _pendingTarget = _target;
+                        _pendingTarget->retain();
                     }
-                    if (curve->scaleCurve)
+                    if (!_queuedForEvaluation)
                     {
-                        curve->scaleCurve->evaluate(t, scaleDst, _scaleEvaluate);
-                        scale = &scaleDst[0];
+                        _queuedForEvaluation = true;
+                        s_pendingAnimates.pushBack(this);
+                        listenAfterUpdate();
                     }
-                    bone->setAnimationValue(trans, rot, scale, this, _weight);
+                }
+                else
+                {
+                    evaluateBoneCurves(t, _weight);
                 }
                 
+                int* cursor = _nodeCurveCursors.data();
                 for (const auto& it : _nodeCurves)
                 {
                     auto node = it.first;
@@ -372,21 +419,22 @@ void Animate3D::update(float t)
                     Mat4 transform;
                     if (curve->translateCurve)
                     {
-                        curve->translateCurve->evaluate(t, transDst, _translateEvaluate);
+                        curve->translateCurve->evaluate(t, transDst, _translateEvaluate, &cursor[0]);
                         transform.translate(transDst[0], transDst[1], transDst[2]);
                     }
                     if (curve->rotCurve)
                     {
-                        curve->rotCurve->evaluate(t, rotDst, _roteEvaluate);
+                        curve->rotCurve->evaluate(t, rotDst, _roteEvaluate, &cursor[1]);
                         Quaternion qua(rotDst[0], rotDst[1], rotDst[2], rotDst[3]);
                         transform.rotate(qua);
                     }
                     if (curve->scaleCurve)
                     {
-                        curve->scaleCurve->evaluate(t, scaleDst, _scaleEvaluate);
+                        curve->scaleCurve->evaluate(t, scaleDst, _scaleEvaluate, &cursor[2]);
                         transform.scale(scaleDst[0], scaleDst[1], scaleDst[2]);
                     }
                     node->setAdditionalTransform(&transform);
+                    cursor += 3;
                 }
                 if (!_keyFrameUserInfos.empty()){
                     float prekeyTime = lastTime * getDuration() * _frameRate;
@@ -418,6 +466,131 @@ void Animate3D::update(float t)
     }
 }
 
+void Animate3D::evaluateBoneCurves(float t, float weight)
+{
+    float transDst[3], rotDst[4], scaleDst[3];
+    float* trans = nullptr, *rot = nullptr, *scale = nullptr;
+    // the key frames of the previous evaluation, found again in constant time when playing sequentially
+    int* cursor = _boneCurveCursors.data();
+    for (const auto& it : _boneCurves) {
+        auto bone = it.first;
+        auto curve = it.second;
+        if (curve->translateCurve)
+        {
+            curve->translateCurve->evaluate(t, transDst, _translateEvaluate, &cursor[0]);
+            trans = &transDst[0];
+        }
+        if (curve->rotCurve)
+        {
+            curve->rotCurve->evaluate(t, rotDst, _roteEvaluate, &cursor[1]);
+            rot = &rotDst[0];
+        }
+        if (curve->scaleCurve)
+        {
+            curve->scaleCurve->evaluate(t, scaleDst, _scaleEvaluate, &cursor[2]);
+            scale = &scaleDst[0];
+        }
+        bone->setAnimationValue(trans, rot, scale, this, weight);
+        cursor += 3;
+    }
+}
+
+void Animate3D::setParallelEvaluationEnabled(bool enabled)
+{
+    s_parallelEvaluation = enabled;
+}
+
+bool Animate3D::isParallelEvaluationEnabled()
+{
+    return s_parallelEvaluation;
+}
+
+void Animate3D::evaluatePendingAnimations()
+{
+    if (s_pendingAnimates.empty())
+        return;
+    
+    // the animates are released by the end of this function, possibly with their sprite
+    auto animates = std::move(s_pendingAnimates);
+    s_pendingAnimates.clear();
+    
+    // The animates of a sprite share its bones, they are evaluated by the same job, followed by the skeleton
+    // and the palettes. The sprites are claimed by groups of about the same number of bones, by this thread
+    // and by the workers.
+    struct Target
+    {
+        Sprite3D* sprite;
+        std::vector<Animate3D*> animates;
+    };
+    std::vector<Target> targets;
+    
+    std::unordered_map<Node*, size_t> targetIndices;
+    for (const auto& animate : animates)
+    {
+        animate->_queuedForEvaluation = false;
+        // evaluated when it was restarted with another target
+        if (!animate->_evaluationPending)
+            continue;
+        
+        // stopped animates are evaluated too, the values were set by their update
+        auto index = targetIndices.find(animate->_pendingTarget);
+        if (index == targetIndices.end())
+        {
+            // only the animates of a Sprite3D have bone curves
+            index = targetIndices.insert(std::make_pair(animate->_pendingTarget, targets.size())).first;
+            targets.push_back(Target());
+            targets.back().sprite = static_cast<Sprite3D*>(animate->_pendingTarget);
+        }
+        targets[index->second].animates.push_back(animate);
+    }
+    
+    std::vector<size_t> groupEnds;
+    int bones = 0;
+    for (size_t i = 0; i < targets.size(); ++i)
+    {
+        for (const auto& animate : targets[i].animates)
+            bones += static_cast<int>(animate->_boneCurves.size());
+        if (bones >= BONES_PER_EVALUATION_JOB || i + 1 == targets.size())
+        {
+            groupEnds.push_back(i + 1);
+            bones = 0;
+        }
+    }
+    
+    AsyncTaskPool::getInstance()->parallelFor(groupEnds.size(), 1, [&](size_t beginGroup, size_t endGroup) {
+        for (size_t i = beginGroup > 0 ? groupEnds[beginGroup - 1] : 0; i < groupEnds[endGroup - 1]; ++i)
+        {
+            auto& target = targets[i];
+            for (const auto& animate : target.animates)
+            {
+                animate->evaluateBoneCurves(animate->_pendingTime, animate->_pendingWeight);
+            }
+            
+            auto skeleton = target.sprite->getSkeleton();
+            if (skeleton)
+            {
+                skeleton->updateBoneMatrix();
+            }
+            // the palettes are computed once per pose, the draw of the meshes only reads them
+            for (const auto& mesh : target.sprite->getMeshes())
+            {
+                auto skin = mesh->getSkin();
+                if (skin)
+                    skin->getMatrixPalette();
+            }
+        }
+    });
+    
+    for (const auto& target : targets)
+    {
+        for (const auto& animate : target.animates)
+        {
+            animate->_evaluationPending = false;
+            CC_SAFE_RELEASE_NULL(animate->_pendingTarget);
+        }
+    }
+}
+
 float Animate3D::getSpeed() const
 {
     return _playReverse ? -_absSpeed : _absSpeed;
@@ -497,6 +670,11 @@ Animate3D::Animate3D()
 , _lastTime(0.0f)
 , _originInterval(0.0f)
 , _frameRate(30.0f)
+, _pendingTime(0.0f)
+, _pendingWeight(0.0f)
+, _pendingTarget(nullptr)
+, _evaluationPending(false)
+, _queuedForEvaluation(false)
 {
     setQuality(Animate3DQuality::QUALITY_HIGH);
 }
@@ -32,6 +32,7 @@
 #include "3d/CCAnimation3D.h"
 #include "base/ccMacros.h"
 #include "base/CCRef.h"
+#include "base/CCVector.h"
 #include "2d/CCActionInterval.h"
 
 NS_CC_BEGIN
@@ -119,6 +120,30 @@ public:
     
     /**get animate quality*/
     Animate3DQuality getQuality() const;
+    
+    /**
+     * Sets whether the bone curves of the animations updated by the scheduler are evaluated together,
+     * on the AsyncTaskPool workers, once the scheduler is done. Enabled by default.
+     *
+     * The evaluation of a sprite is followed by the update of its skeleton and of the matrix palettes
+     * of its skins, so the draw only reads them. The node curves and the key frame events stay in update().
+     * @since v3.18
+     */
+    static void setParallelEvaluationEnabled(bool enabled);
+    /**
+     * Whether the bone curves are evaluated in parallel.
+     * @since v3.18
+     */
+    static bool isParallelEvaluationEnabled();
+    /**
+     * Evaluates the bone curves of the animations updated since the last call, in parallel, then updates
+     * the skeletons and the matrix palettes of their sprites.
+     * Called every frame on Director::EVENT_AFTER_UPDATE, between the scheduler and the visit of the scene.
+     * @since v3.18
+     * @js NA
+     * @lua NA
+     */
+    static void evaluatePendingAnimations();
 
 
     struct Animate3DDisplayedEventInfo
@@ -147,6 +172,11 @@ CC_CONSTRUCTOR_ACCESS:
     
 protected:
     
+    /** Evaluates the bone curves at t, in animation time, and sets the values to the bones with the blend weight. Only touches
+     the bones of the target, so that the animations of different sprites can be evaluated in parallel.
+     */
+    void evaluateBoneCurves(float t, float weight);
+    
     enum class Animate3DState
     {
         FadeIn,
@@ -175,6 +205,8 @@ protected:
     
     std::unordered_map<Bone3D*, Animation3D::Curve*> _boneCurves; //weak ref
     std::unordered_map<Node*, Animation3D::Curve*> _nodeCurves;
+    std::vector<int> _boneCurveCursors; // key frames found by the last evaluation of _boneCurves, 3 per curve
+    std::vector<int> _nodeCurveCursors; // same for _nodeCurves
     
     std::unordered_map<int, ValueMap> _keyFrameUserInfos;
     std::unordered_map<int, EventCustom*> _keyFrameEvent;
@@ -184,6 +216,14 @@ protected:
     static std::unordered_map<Node*, Animate3D*> s_fadeInAnimates;
     static std::unordered_map<Node*, Animate3D*> s_fadeOutAnimates;
     static std::unordered_map<Node*, Animate3D*> s_runningAnimates;
+    
+    float      _pendingTime; // animation time of the deferred evaluation
+    float      _pendingWeight; // blend weight of the deferred evaluation
+    Node*      _pendingTarget; // target of the deferred evaluation, retained
+    bool       _evaluationPending; // whether an evaluation is deferred
+    bool       _queuedForEvaluation; // whether the animate is in s_pendingAnimates
+    static bool s_parallelEvaluation;
+    static Vector<Animate3D*> s_pendingAnimates;
 };
 
 // end of 3d group
@@ -183,6 +183,38 @@ bool Animation3D::init(const Animation3DData &data)
         if(curve->scaleCurve) curve->scaleCurve->retain();
     }
     
+    // the tracks of a compressed animation stay quantized as they were in the file
+    auto getCurve = [this](const std::string& boneName) {
+        Curve*& curve = _boneCurves[boneName];
+        if (curve == nullptr)
+            curve = new (std::nothrow) Curve();
+        return curve;
+    };
+    for(const auto& iter : data._quantizedTranslations)
+    {
+        Curve* curve = getCurve(iter.first);
+        const auto& track = iter.second;
+        if(track.keytimes.empty()) continue;
+        curve->translateCurve = Curve::AnimationCurveVec3::createQuantized(&track.keytimes[0], &track.values[0], track.minValue, track.step, (int)track.keytimes.size());
+        if(curve->translateCurve) curve->translateCurve->retain();
+    }
+    for(const auto& iter : data._quantizedRotations)
+    {
+        Curve* curve = getCurve(iter.first);
+        const auto& track = iter.second;
+        if(track.keytimes.empty()) continue;
+        curve->rotCurve = Curve::AnimationCurveQuat::createQuantized(&track.keytimes[0], &track.values[0], track.minValue, track.step, (int)track.keytimes.size());
+        if(curve->rotCurve) curve->rotCurve->retain();
+    }
+    for(const auto& iter : data._quantizedScales)
+    {
+        Curve* curve = getCurve(iter.first);
+        const auto& track = iter.second;
+        if(track.keytimes.empty()) continue;
+        curve->scaleCurve = Curve::AnimationCurveVec3::createQuantized(&track.keytimes[0], &track.values[0], track.minValue, track.step, (int)track.keytimes.size());
+        if(curve->scaleCurve) curve->scaleCurve->retain();
+    }
+    
     return true;
 }
 
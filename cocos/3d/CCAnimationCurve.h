@@ -25,6 +25,7 @@
 #ifndef __CCANIMATIONCURVE_H__
 #define __CCANIMATIONCURVE_H__
 
+#include <algorithm>
 #include <cmath>
 #include <functional>
 
@@ -67,6 +68,20 @@ public:
     /**create animation curve*/
     static AnimationCurve* create(float* keytime, float* value, int count);
     
+    /**
+     * create animation curve keeping the values as 16 bit integers, quantized over the range of each component,
+     * which takes half the memory. Quaternions are normalized when evaluated.
+     * @since v3.18
+     */
+    static AnimationCurve* createQuantized(float* keytime, float* value, int count);
+    
+    /**
+     * create animation curve from values already quantized, value = minValue + quantized * step for each component,
+     * e.g. the tracks of a compressed animation.
+     * @since v3.18
+     */
+    static AnimationCurve* createQuantized(const float* keytime, const unsigned short* quantized, const float* minValue, const float* step, int count);
+    
     /**
      * evaluate value of time
      * @param time Time to be estimated
@@ -75,6 +90,17 @@ public:
      */
     void evaluate(float time, float* dst, EvaluateType type) const;
     
+    /**
+     * evaluate value of time, looking for the key frames from a cursor
+     * @param time Time to be estimated
+     * @param dst Estimated value of that time
+     * @param type EvaluateType
+     * @param cursor Key frame found by the previous evaluation, updated. Playing forward or backward
+     * finds the key frames in constant time, the cursor must not be shared between threads.
+     * @since v3.18
+     */
+    void evaluate(float time, float* dst, EvaluateType type, int* cursor) const;
+    
     /**set evaluate function, allow the user use own function*/
     void setEvaluateFun(std::function<void(float time, float* dst)> fun);
     
@@ -94,13 +120,25 @@ CC_CONSTRUCTOR_ACCESS:
      */
     int determineIndex(float time) const;
     
+    /**
+     * Determine index by time, checking the key frame at hint and its neighbors before searching.
+     */
+    int determineIndex(float time, int hint) const;
+    
 protected:
     
+    /** gets the value of a key frame */
+    void getKeyValue(int index, float* dst) const;
+    
     float* _value;   //
     float* _keytime; //key time(0 - 1), start time _keytime[0], end time _keytime[_count - 1]
     int _count;
     int _componentSizeByte; //component size in byte, position and scale 3 * sizeof(float), rotation 4 * sizeof(float)
     
+    unsigned short* _quantizedValue; //values of a quantized curve instead of _value, value = min + quantized * scale
+    float _quantizedMin[componentSize];
+    float _quantizedScale[componentSize];
+    
     std::function<void(float time, float* dst)> _evaluateFun; //user defined function
 };
 
@@ -3,25 +3,34 @@ NS_CC_BEGIN
 
 template <int componentSize>
 void AnimationCurve<componentSize>::evaluate(float time, float* dst, EvaluateType type) const
+{
+    evaluate(time, dst, type, nullptr);
+}
+
+template <int componentSize>
+void AnimationCurve<componentSize>::evaluate(float time, float* dst, EvaluateType type, int* cursor) const
 {
     if (_count == 1 || time <= _keytime[0])
     {
-        memcpy(dst, _value, _componentSizeByte);
+        getKeyValue(0, dst);
         return;
     }
     else if (time >= _keytime[_count - 1])
     {
-        memcpy(dst, &_value[(_count - 1) * componentSize], _componentSizeByte);
+        getKeyValue(_count - 1, dst);
         return;
     }
     
-    unsigned int index = determineIndex(time);
+    unsigned int index = cursor ? determineIndex(time, *cursor) : determineIndex(time);
+    if (cursor)
+        *cursor = index;
     
     float scale = (_keytime[index + 1] - _keytime[index]);
     float t = (time - _keytime[index]) / scale;
     
-    float* fromValue = &_value[index * componentSize];
-    float* toValue = fromValue + componentSize;
+    float fromValue[componentSize], toValue[componentSize];
+    getKeyValue(index, fromValue);
+    getKeyValue(index + 1, toValue);
     
     switch (type) {
         case EvaluateType::INT_LINEAR:
@@ -33,7 +42,7 @@ void AnimationCurve<componentSize>::evaluate(float time, float* dst, EvaluateTyp
         break;
         case EvaluateType::INT_NEAR:
         {
-            float* src = std::abs(t) > 0.5f ? toValue : fromValue;
+            const float* src = std::abs(t) > 0.5f ? toValue : fromValue;
             memcpy(dst, src, _componentSizeByte);
         }
         break;
@@ -64,6 +73,32 @@ void AnimationCurve<componentSize>::evaluate(float time, float* dst, EvaluateTyp
     }
 }
 
+template <int componentSize>
+void AnimationCurve<componentSize>::getKeyValue(int index, float* dst) const
+{
+    if (_value)
+    {
+        memcpy(dst, &_value[index * componentSize], _componentSizeByte);
+        return;
+    }
+    
+    const unsigned short* quantized = &_quantizedValue[index * componentSize];
+    for (int i = 0; i < componentSize; i++) {
+        dst[i] = _quantizedMin[i] + quantized[i] * _quantizedScale[i];
+    }
+    // quantized quaternions are close to unit length, slerp expects them normalized
+    if (componentSize == 4)
+    {
+        float length = std::sqrt(dst[0] * dst[0] + dst[1] * dst[1] + dst[2] * dst[2] + dst[3] * dst[3]);
+        if (length > 0.f)
+        {
+            for (int i = 0; i < componentSize; i++) {
+                dst[i] /= length;
+            }
+        }
+    }
+}
+
 template <int componentSize>
 void AnimationCurve<componentSize>::setEvaluateFun(std::function<void(float time, float* dst)> fun)
 {
@@ -91,6 +126,59 @@ AnimationCurve<componentSize>* AnimationCurve<componentSize>::create(float* keyt
     return curve;
 }
 
+template <int componentSize>
+AnimationCurve<componentSize>* AnimationCurve<componentSize>::createQuantized(float* keytime, float* value, int count)
+{
+    AnimationCurve* curve = new (std::nothrow) AnimationCurve();
+    curve->_keytime = new float[count];
+    memcpy(curve->_keytime, keytime, count * sizeof(float));
+    
+    // each component is quantized over its own range, 65535 steps between its minimum and its maximum
+    for (int i = 0; i < componentSize; i++) {
+        float minValue = value[i], maxValue = value[i];
+        for (int key = 1; key < count; key++) {
+            minValue = std::min(minValue, value[key * componentSize + i]);
+            maxValue = std::max(maxValue, value[key * componentSize + i]);
+        }
+        curve->_quantizedMin[i] = minValue;
+        curve->_quantizedScale[i] = (maxValue - minValue) / 65535.f;
+    }
+    
+    curve->_quantizedValue = new unsigned short[count * componentSize];
+    for (int key = 0; key < count; key++) {
+        for (int i = 0; i < componentSize; i++) {
+            float scale = curve->_quantizedScale[i];
+            float quantized = scale > 0.f ? (value[key * componentSize + i] - curve->_quantizedMin[i]) / scale : 0.f;
+            curve->_quantizedValue[key * componentSize + i] = (unsigned short)std::min(std::max(quantized + 0.5f, 0.f), 65535.f);
+        }
+    }
+    
+    curve->_count = count;
+    curve->_componentSizeByte = componentSize * sizeof(float);
+    
+    curve->autorelease();
+    return curve;
+}
+
+template <int componentSize>
+AnimationCurve<componentSize>* AnimationCurve<componentSize>::createQuantized(const float* keytime, const unsigned short* quantized, const float* minValue, const float* step, int count)
+{
+    AnimationCurve* curve = new (std::nothrow) AnimationCurve();
+    curve->_keytime = new float[count];
+    memcpy(curve->_keytime, keytime, count * sizeof(float));
+    
+    memcpy(curve->_quantizedMin, minValue, sizeof(curve->_quantizedMin));
+    memcpy(curve->_quantizedScale, step, sizeof(curve->_quantizedScale));
+    curve->_quantizedValue = new unsigned short[count * componentSize];
+    memcpy(curve->_quantizedValue, quantized, count * componentSize * sizeof(unsigned short));
+    
+    curve->_count = count;
+    curve->_componentSizeByte = componentSize * sizeof(float);
+    
+    curve->autorelease();
+    return curve;
+}
+
 template <int componentSize>
 float AnimationCurve<componentSize>::getStartTime() const
 {
@@ -110,6 +198,7 @@ AnimationCurve<componentSize>::AnimationCurve()
 , _keytime(nullptr)
 , _count(0)
 , _componentSizeByte(0)
+, _quantizedValue(nullptr)
 , _evaluateFun(nullptr)
 {
     
@@ -119,6 +208,7 @@ AnimationCurve<componentSize>::~AnimationCurve()
 {
     CC_SAFE_DELETE_ARRAY(_keytime);
     CC_SAFE_DELETE_ARRAY(_value);
+    CC_SAFE_DELETE_ARRAY(_quantizedValue);
 }
 
 template <int componentSize>
@@ -144,4 +234,15 @@ int AnimationCurve<componentSize>::determineIndex(float time) const
     return -1;
 }
 
+template <int componentSize>
+int AnimationCurve<componentSize>::determineIndex(float time, int hint) const
+{
+    // the previous key frame, or the next or previous one when playing sequentially
+    for (int index = std::max(hint - 1, 0), end = std::min(hint + 1, _count - 2); index <= end; index++) {
+        if (time >= _keytime[index] && time <= _keytime[index + 1])
+            return index;
+    }
+    return determineIndex(time);
+}
+
 NS_CC_END
\ No newline at end of file
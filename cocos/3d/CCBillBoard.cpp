@@ -112,6 +112,18 @@ void BillBoard::visit(Renderer *renderer, const Mat4& parentTransform, uint32_t
     
     uint32_t flags = processParentFlags(parentTransform, parentFlags);
     
+    if (_aabbTreeProxy.isAttached() && (flags & FLAGS_DIRTY_MASK))
+    {
+        _aabbTreeProxy.move(calculateBillboardAABB(getNodeToWorldTransform()));
+    }
+#if CC_USE_CULLING
+    // culled out through the tree, there is nothing else to do without children
+    if (_children.empty() && _aabbTreeProxy.isOutOfFrustum(Camera::getVisitingCamera()))
+    {
+        return;
+    }
+#endif
+    
     //Add 3D flag so all the children will be rendered as 3D object
     flags |= FLAGS_RENDER_AS_3D;
     
@@ -230,9 +242,38 @@ bool BillBoard::calculateBillbaordTransform()
     return calculateBillboardTransform();
 }
 
+AABB BillBoard::calculateBillboardAABB(const Mat4& transform) const
+{
+    // the rotation towards the camera keeps the anchor point and the scale, so the billboard stays in the sphere around them
+    Vec3 center;
+    transform.transformPoint(Vec3(_anchorPointInPoints.x, _anchorPointInPoints.y, 0.0f), &center);
+    float xlen = sqrtf(transform.m[0] * transform.m[0] + transform.m[1] * transform.m[1] + transform.m[2] * transform.m[2]);
+    float ylen = sqrtf(transform.m[4] * transform.m[4] + transform.m[5] * transform.m[5] + transform.m[6] * transform.m[6]);
+    float width = std::max(_anchorPointInPoints.x, _contentSize.width - _anchorPointInPoints.x) * xlen;
+    float height = std::max(_anchorPointInPoints.y, _contentSize.height - _anchorPointInPoints.y) * ylen;
+    float radius = sqrtf(width * width + height * height);
+    Vec3 extents(radius, radius, radius);
+    return AABB(center - extents, center + extents);
+}
+
+void BillBoard::onEnter()
+{
+    Sprite::onEnter();
+    _aabbTreeProxy.attach(this, calculateBillboardAABB(getNodeToWorldTransform()));
+}
+
+void BillBoard::onExit()
+{
+    _aabbTreeProxy.detach();
+    Sprite::onExit();
+}
+
 void BillBoard::draw(Renderer *renderer, const Mat4 &/*transform*/, uint32_t flags)
 {
-    //FIXME: frustum culling here
+#if CC_USE_CULLING
+    if (_aabbTreeProxy.isOutOfFrustum(Camera::getVisitingCamera()))
+        return;
+#endif
     flags |= Node::FLAGS_RENDER_AS_3D;
     _trianglesCommand.init(0, _texture->getName(), getGLProgramState(), _blendFunc, _polyInfo.triangles, _modelViewTransform, flags);
     _trianglesCommand.setTransparent(true);
@@ -27,6 +27,7 @@
 #define __CCBILLBOARD_H__
 
 #include "2d/CCSprite.h"
+#include "3d/CCAABBTree.h"
 
 NS_CC_BEGIN
 /**
@@ -104,6 +105,9 @@ public:
      */
     virtual void draw(Renderer *renderer, const Mat4 &transform, uint32_t flags) override;
 
+    virtual void onEnter() override;
+    virtual void onExit() override;
+
 
 CC_CONSTRUCTOR_ACCESS:
     BillBoard();
@@ -118,12 +122,19 @@ protected:
 
     /** @deprecated Use calculateBillboardTransform instead. */
     CC_DEPRECATED_ATTRIBUTE bool calculateBillbaordTransform();
+
+    /**
+     * box of the billboard in world space whichever way it faces, given its transform to the world
+     * with or without the rotation towards the camera
+     */
+    AABB calculateBillboardAABB(const Mat4& transform) const;
     
     Mat4 _camWorldMat;
     Mat4 _mvTransform;
 
     Mode _mode;
     bool _modeDirty;
+    AABBTreeProxy _aabbTreeProxy; // culls the billboard through the tree of the scene
 
 private:
     CC_DISALLOW_COPY_AND_ASSIGN(BillBoard);
@@ -38,6 +38,7 @@ THE SOFTWARE.
 #define BUNDLE_TYPE_ANIMATIONS          3
 #define BUNDLE_TYPE_ANIMATION           4
 #define BUNDLE_TYPE_ANIMATION_CHANNEL   5
+#define BUNDLE_TYPE_ANIMATIONS_COMPRESSED   6
 #define BUNDLE_TYPE_MODEL               10
 #define BUNDLE_TYPE_MATERIAL            16
 #define BUNDLE_TYPE_EFFECT              18
@@ -163,7 +164,7 @@ void Bundle3D::clear()
 {
     if (_isBinary)
     {
-        _binaryBuffer.clear();
+        _binaryBuffer.reset();
         CC_SAFE_DELETE_ARRAY(_references);
     }
     else
@@ -279,6 +280,7 @@ bool Bundle3D::loadObj(MeshDatas& meshdatas, MaterialDatas& materialdatas, NodeD
             }
             
             auto vertexNum = mesh.positions.size() / 3;
+            meshdata->vertex.reserve(vertexNum * (3 + (hasnormal ? 3 : 0) + (hastex ? 2 : 0)));
             for(unsigned int k = 0; k < vertexNum; ++k)
             {
                 meshdata->vertex.push_back(mesh.positions[k * 3]);
@@ -398,6 +400,9 @@ bool  Bundle3D::loadMeshDatasBinary(MeshDatas& meshdatas)
         CCLOG("warning: Failed to read meshdata: attribCount '%s'.", _path.c_str());
         return false;
     }
+    // files older than 0.6 don't store the AABBs of the sub meshes, they are computed from copies of the buffers
+    const bool hasAABB = (_version != "0.3" && _version != "0.4" && _version != "0.5");
+    const bool useViews = _meshBufferViewsEnabled && hasAABB;
     MeshData*   meshData = nullptr;
     for(unsigned int i = 0; i < meshSize ; ++i)
     {
@@ -435,11 +440,25 @@ bool  Bundle3D::loadMeshDatasBinary(MeshDatas& meshdatas)
             goto FAILED;
         }
 
-        meshData->vertex.resize(vertexSizeInFloat);
-        if (_binaryReader.read(&meshData->vertex[0], 4, vertexSizeInFloat) != vertexSizeInFloat)
+        meshData->vertexSizeInFloat = vertexSizeInFloat;
+        if (useViews)
         {
-            CCLOG("warning: Failed to read meshdata: vertex element '%s'.", _path.c_str());
-            goto FAILED;
+            meshData->bufferSource = _binaryBuffer;
+            meshData->vertexView = _binaryReader.readBytes(vertexSizeInFloat * 4);
+            if (!meshData->vertexView)
+            {
+                CCLOG("warning: Failed to read meshdata: vertex element '%s'.", _path.c_str());
+                goto FAILED;
+            }
+        }
+        else
+        {
+            meshData->vertex.resize(vertexSizeInFloat);
+            if (_binaryReader.read(&meshData->vertex[0], 4, vertexSizeInFloat) != vertexSizeInFloat)
+            {
+                CCLOG("warning: Failed to read meshdata: vertex element '%s'.", _path.c_str());
+                goto FAILED;
+            }
         }
 
         // Read index data
@@ -457,16 +476,30 @@ bool  Bundle3D::loadMeshDatasBinary(MeshDatas& meshdatas)
                 CCLOG("warning: Failed to read meshdata: nIndexCount '%s'.", _path.c_str());
                 goto FAILED;
             }
-            indexArray.resize(nIndexCount);
-            if (_binaryReader.read(&indexArray[0], 2, nIndexCount) != nIndexCount)
+            if (useViews)
             {
-                CCLOG("warning: Failed to read meshdata: indices '%s'.", _path.c_str());
-                goto FAILED;
+                const char* indices = _binaryReader.readBytes(nIndexCount * 2);
+                if (!indices)
+                {
+                    CCLOG("warning: Failed to read meshdata: indices '%s'.", _path.c_str());
+                    goto FAILED;
+                }
+                meshData->subMeshIndexViews.push_back(std::make_pair(indices, nIndexCount));
+                meshData->numIndex = (int)meshData->subMeshIndexViews.size();
+            }
+            else
+            {
+                indexArray.resize(nIndexCount);
+                if (_binaryReader.read(&indexArray[0], 2, nIndexCount) != nIndexCount)
+                {
+                    CCLOG("warning: Failed to read meshdata: indices '%s'.", _path.c_str());
+                    goto FAILED;
+                }
+                meshData->subMeshIndices.push_back(indexArray);
+                meshData->numIndex = (int)meshData->subMeshIndices.size();
             }
-            meshData->subMeshIndices.push_back(indexArray);
-            meshData->numIndex = (int)meshData->subMeshIndices.size();
             //meshData->subMeshAABB.push_back(calculateAABB(meshData->vertex, meshData->getPerVertexSize(), indexArray));
-            if (_version != "0.3" && _version != "0.4" && _version != "0.5")
+            if (hasAABB)
             {
                 //read mesh aabb
                 float aabb[6];
@@ -1080,10 +1113,9 @@ bool Bundle3D::loadBinary(const std::string& path)
 {
     clear();
     
-    // get file data
-    _binaryBuffer.clear();
-    _binaryBuffer = FileUtils::getInstance()->getDataFromFile(path);
-    if (_binaryBuffer.isNull())
+    // get file data, mapped so that mesh data can view the buffers without copying them
+    _binaryBuffer = std::make_shared<Data>(FileUtils::getInstance()->getMappedDataFromFile(path));
+    if (_binaryBuffer->isNull())
     {
         clear();
         CCLOG("warning: Failed to read file: %s", path.c_str());
@@ -1091,7 +1123,7 @@ bool Bundle3D::loadBinary(const std::string& path)
     }
     
     // Initialise bundle reader
-    _binaryReader.init( (char*)_binaryBuffer.getBytes(),  _binaryBuffer.getSize() );
+    _binaryReader.init( (char*)_binaryBuffer->getBytes(),  _binaryBuffer->getSize() );
     
     // Read identifier info
     char identifier[] = { 'C', '3', 'B', '\0'};
@@ -1538,6 +1570,8 @@ bool Bundle3D::loadAnimationDataBinary(const std::string& id, Animation3DData* a
  
     if( _version == "0.1"|| _version == "0.2" || _version == "0.3"|| _version == "0.4")
     {
+        if (seekToFirstType(BUNDLE_TYPE_ANIMATIONS_COMPRESSED))
+            return loadCompressedAnimationDataBinary(id, animationdata);
         if (!seekToFirstType(BUNDLE_TYPE_ANIMATIONS))
             return false;
     }
@@ -1547,6 +1581,8 @@ bool Bundle3D::loadAnimationDataBinary(const std::string& id, Animation3DData* a
         std::string id_ = id;
         if(id != "") id_ = id + "animation";
         
+        if (seekToFirstType(BUNDLE_TYPE_ANIMATIONS_COMPRESSED, id_))
+            return loadCompressedAnimationDataBinary(id, animationdata);
         if (!seekToFirstType(BUNDLE_TYPE_ANIMATIONS, id_))
             return false;
     }
@@ -1677,6 +1713,76 @@ bool Bundle3D::loadAnimationDataBinary(const std::string& id, Animation3DData* a
     return true;
 }
 
+// Reads a track of a compressed animation: the key times, then for each component the minimum and the step,
+// then the values quantized to 16 bits. Must match tools/c3b/compress_animations.py.
+template <int componentSize>
+static bool readQuantizedTrack(BundleReader& reader, Animation3DData::QuantizedTrack* track)
+{
+    unsigned int keyCount;
+    if (!reader.readArray(&keyCount, &track->keytimes))
+        return false;
+    track->values.clear();
+    if (keyCount == 0)
+        return true;
+    
+    unsigned int quantizedCount;
+    return reader.read(track->minValue, 4, componentSize) == componentSize
+        && reader.read(track->step, 4, componentSize) == componentSize
+        && reader.readArray(&quantizedCount, &track->values)
+        && quantizedCount == keyCount * componentSize;
+}
+
+bool Bundle3D::loadCompressedAnimationDataBinary(const std::string& id, Animation3DData* animationdata)
+{
+    unsigned int animNum;
+    if (!_binaryReader.read(&animNum))
+    {
+        CCLOG("warning: Failed to read AnimationData: animNum '%s'.", _path.c_str());
+        return false;
+    }
+    
+    for (unsigned int k = 0; k < animNum; ++k)
+    {
+        animationdata->resetData();
+        std::string animId = _binaryReader.readString();
+        
+        unsigned int nodeAnimationNum;
+        if (!_binaryReader.read(&animationdata->_totalTime) || !_binaryReader.read(&nodeAnimationNum))
+        {
+            CCLOG("warning: Failed to read AnimationData: totalTime '%s'.", _path.c_str());
+            return false;
+        }
+        
+        // the values stay quantized, the curves evaluate them as they are
+        for (unsigned int i = 0; i < nodeAnimationNum; ++i)
+        {
+            std::string boneName = _binaryReader.readString();
+            
+            // the tracks are reduced separately, they have their own key times
+            if (!readQuantizedTrack<4>(_binaryReader, &animationdata->_quantizedRotations[boneName]))
+            {
+                CCLOG("warning: Failed to read AnimationData: rotate '%s'.", _path.c_str());
+                return false;
+            }
+            if (!readQuantizedTrack<3>(_binaryReader, &animationdata->_quantizedScales[boneName]))
+            {
+                CCLOG("warning: Failed to read AnimationData: scale '%s'.", _path.c_str());
+                return false;
+            }
+            if (!readQuantizedTrack<3>(_binaryReader, &animationdata->_quantizedTranslations[boneName]))
+            {
+                CCLOG("warning: Failed to read AnimationData: position '%s'.", _path.c_str());
+                return false;
+            }
+        }
+        
+        if (id == animId || id.empty())
+            return true;
+    }
+    
+    animationdata->resetData();
+    return false;
+}
 
 bool Bundle3D::loadNodesJson(NodeDatas& nodedatas)
 {
@@ -2227,7 +2333,8 @@ _path(""),
 _version(""),
 _referenceCount(0),
 _references(nullptr),
-_isBinary(false)
+_isBinary(false),
+_meshBufferViewsEnabled(false)
 {
 
 }
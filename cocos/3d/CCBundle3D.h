@@ -67,6 +67,15 @@ public:
      * @return result of load
      */
     virtual bool load(const std::string& path);
+
+    /**
+     * Whether the mesh data loaded from c3b files view the vertices and the indices in the mapped
+     * file instead of copying them, see MeshData::vertexView. The file stays mapped as long as the
+     * mesh data is alive. Disabled by default.
+     * @since v3.18
+     */
+    void setMeshBufferViewsEnabled(bool enabled) { _meshBufferViewsEnabled = enabled; }
+    bool isMeshBufferViewsEnabled() const { return _meshBufferViewsEnabled; }
     
     /**
      * load skin data from bundle
@@ -125,6 +134,8 @@ protected:
     bool loadMaterialDataJson_0_2(MaterialData* materialdata);
     bool loadAnimationDataJson(const std::string& id,Animation3DData* animationdata);
     bool loadAnimationDataBinary(const std::string& id,Animation3DData* animationdata);
+    /** loads animations compressed by tools/c3b/compress_animations.py, the section is at the reader position */
+    bool loadCompressedAnimationDataBinary(const std::string& id,Animation3DData* animationdata);
 
     /**
      * load nodes of json
@@ -183,11 +194,12 @@ protected:
     rapidjson::Document _jsonReader;
 
     // for binary reading
-    Data _binaryBuffer;
+    std::shared_ptr<Data> _binaryBuffer;
     BundleReader _binaryReader;
     unsigned int _referenceCount;
     Reference* _references;
     bool  _isBinary;
+    bool  _meshBufferViewsEnabled;
 };
 
 // end of 3d group
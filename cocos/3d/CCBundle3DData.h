@@ -28,11 +28,14 @@
 
 #include "base/CCRef.h"
 #include "base/ccTypes.h"
+#include "base/CCData.h"
 #include "math/CCMath.h"
 #include "3d/CCAABB.h"
 
 #include <vector>
 #include <map>
+#include <memory>
+#include <string.h>
  
 NS_CC_BEGIN
 
@@ -44,7 +47,7 @@ struct MeshVertexAttrib
 {
     //attribute size
     GLint size;
-    //GL_FLOAT
+    //GL_FLOAT, or GL_SHORT, GL_UNSIGNED_SHORT, GL_UNSIGNED_BYTE for normalized attributes, see MeshOptimizer
     GLenum type;
     //VERTEX_ATTRIB_POSITION,VERTEX_ATTRIB_COLOR,VERTEX_ATTRIB_TEX_COORD,VERTEX_ATTRIB_NORMAL, VERTEX_ATTRIB_BLEND_WEIGHT, VERTEX_ATTRIB_BLEND_INDEX, GLProgram for detail
     int  vertexAttrib;
@@ -154,7 +157,66 @@ struct MeshData
     std::vector<MeshVertexAttrib> attribs;
     int attribCount;
 
+    /**
+     * Zero-copy buffers (since v3.18): when vertexView is set, the vertices and the indices are read
+     * from the bundle file held by bufferSource instead of vertex and subMeshIndices, which are empty.
+     * The views are not aligned, use the accessors below or copyViews() to read them.
+     */
+    std::shared_ptr<Data> bufferSource;
+    const char* vertexView;
+    /** first index and index count of every sub mesh */
+    std::vector<std::pair<const char*, unsigned int>> subMeshIndexViews;
+
+    /** A simplified triangle list of a sub mesh, using the same vertices (since v3.18) */
+    struct LOD
+    {
+        IndexArray indices;
+        float error; // relative to the size of the mesh
+    };
+    /** Levels of detail of every sub mesh, from the finest to the coarsest, see MeshSimplifier */
+    std::vector<std::vector<LOD>> subMeshLODs;
+
 public:
+    /** Vertices, vertexSizeInFloat floats */
+    const void* getVertexData() const
+    {
+        return vertexView ? (const void*)vertexView : (const void*)vertex.data();
+    }
+    int getVertexSizeInFloat() const
+    {
+        return vertexView ? vertexSizeInFloat : (int)vertex.size();
+    }
+    size_t getSubMeshCount() const
+    {
+        return vertexView ? subMeshIndexViews.size() : subMeshIndices.size();
+    }
+    const void* getIndexData(size_t subMesh) const
+    {
+        return vertexView ? (const void*)subMeshIndexViews[subMesh].first : (const void*)subMeshIndices[subMesh].data();
+    }
+    size_t getIndexCount(size_t subMesh) const
+    {
+        return vertexView ? subMeshIndexViews[subMesh].second : subMeshIndices[subMesh].size();
+    }
+
+    /** Copies the buffers viewed in the bundle into vertex and subMeshIndices, and releases the bundle. */
+    void copyViews()
+    {
+        if (!vertexView)
+            return;
+        vertex.resize(vertexSizeInFloat);
+        memcpy(vertex.data(), vertexView, vertexSizeInFloat * sizeof(float));
+        subMeshIndices.resize(subMeshIndexViews.size());
+        for (size_t i = 0; i < subMeshIndexViews.size(); ++i)
+        {
+            subMeshIndices[i].resize(subMeshIndexViews[i].second);
+            memcpy(subMeshIndices[i].data(), subMeshIndexViews[i].first, subMeshIndexViews[i].second * sizeof(unsigned short));
+        }
+        vertexView = nullptr;
+        subMeshIndexViews.clear();
+        bufferSource.reset();
+    }
+
     /**
      * Get per vertex size
      * @return return the sum of each vertex's all attribute size.
@@ -181,11 +243,16 @@ public:
         vertexSizeInFloat = 0;
         numIndex = 0;
         attribCount = 0;
+        bufferSource.reset();
+        vertexView = nullptr;
+        subMeshIndexViews.clear();
+        subMeshLODs.clear();
     }
     MeshData()
     : vertexSizeInFloat(0)
     , numIndex(0)
     , attribCount(0)
+    , vertexView(nullptr)
     {
     }
     ~MeshData()
@@ -404,11 +471,24 @@ public:
         Quaternion _key;
     };
 
+    // track of a compressed animation, kept quantized by the curves: value = minValue + quantized * step
+    struct QuantizedTrack
+    {
+        std::vector<float> keytimes;
+        std::vector<unsigned short> values;
+        float minValue[4];
+        float step[4];
+    };
+
 public:
     std::map<std::string, std::vector<Vec3Key>> _translationKeys;
     std::map<std::string, std::vector<QuatKey>> _rotationKeys;
     std::map<std::string, std::vector<Vec3Key>> _scaleKeys;
     
+    std::map<std::string, QuantizedTrack> _quantizedTranslations;
+    std::map<std::string, QuantizedTrack> _quantizedRotations;
+    std::map<std::string, QuantizedTrack> _quantizedScales;
+    
     float _totalTime;
 
 public:
@@ -421,6 +501,9 @@ public:
     : _translationKeys(other._translationKeys)
     , _rotationKeys(other._rotationKeys)
     , _scaleKeys(other._scaleKeys)
+    , _quantizedTranslations(other._quantizedTranslations)
+    , _quantizedRotations(other._quantizedRotations)
+    , _quantizedScales(other._quantizedScales)
     , _totalTime(other._totalTime)
     {
     }
@@ -431,6 +514,9 @@ public:
         _translationKeys.clear();
         _rotationKeys.clear();
         _scaleKeys.clear();
+        _quantizedTranslations.clear();
+        _quantizedRotations.clear();
+        _quantizedScales.clear();
     }
 };
 
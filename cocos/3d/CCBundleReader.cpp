@@ -188,4 +188,17 @@ bool BundleReader::readMatrix(float* m)
     return (read(m, sizeof(float), 16) == 16);
 }
 
+const char* BundleReader::readBytes(ssize_t size)
+{
+    if (!_buffer || size < 0 || size > _length - _position)
+    {
+        CCLOG("warning: bundle reader out of range");
+        return nullptr;
+    }
+
+    const char* bytes = _buffer + _position;
+    _position += size;
+    return bytes;
+}
+
 NS_CC_END
@@ -124,6 +124,13 @@ public:
      */
     bool readMatrix(float* m);
 
+    /**
+     * Skips bytes without copying them.
+     * @return the skipped bytes in the buffer, nullptr if there are not enough bytes left
+     * @note the bytes are not aligned
+     */
+    const char* readBytes(ssize_t size);
+
 private:
     ssize_t _position;
     ssize_t  _length;
@@ -41,6 +41,8 @@
 #include "renderer/CCVertexAttribBinding.h"
 #include "math/Mat4.h"
 
+#include <algorithm>
+
 using namespace std;
 
 NS_CC_BEGIN
@@ -128,10 +130,12 @@ Mesh::Mesh()
 , _isTransparent(false)
 , _force2DQueue(false)
 , _meshIndexData(nullptr)
+, _lod(0)
 , _glProgramState(nullptr)
 , _blend(BlendFunc::ALPHA_NON_PREMULTIPLIED)
 , _blendDirty(true)
 , _material(nullptr)
+, _hasAmbientLight(false)
 , _texFile("")
 {
     
@@ -391,6 +395,7 @@ void Mesh::draw(Renderer* renderer, float globalZOrder, const Mat4& transform, u
                       getIndexCount(),
                       transform,
                       flags);
+    _meshCommand.setIndexOffset(_meshIndexData->getIndexStart(_lod) * sizeof(unsigned short));
 
 
    if (isTransparent && !forceDepthWrite)
@@ -407,6 +412,9 @@ void Mesh::draw(Renderer* renderer, float globalZOrder, const Mat4& transform, u
     // set default uniforms for Mesh
     // 'u_color' and others
     const auto scene = Director::getInstance()->getRunningScene();
+    bool useLights = scene && scene->getLights().size() > 0;
+    if (useLights)
+        updateLightUniformValues(scene, lightMask, transform);
     auto technique = _material->_currentTechnique;
     for(const auto pass : technique->_passes)
     {
@@ -416,8 +424,8 @@ void Mesh::draw(Renderer* renderer, float globalZOrder, const Mat4& transform, u
         if (_skin)
             programState->setUniformVec4v("u_matrixPalette", (GLsizei)_skin->getMatrixPaletteSize(), _skin->getMatrixPalette());
 
-        if (scene && scene->getLights().size() > 0)
-            setLightUniforms(pass, scene, color, lightMask);
+        if (useLights)
+            setLightUniforms(pass, color);
     }
 
     renderer->addCommand(&_meshCommand);
@@ -441,6 +449,7 @@ void Mesh::setMeshIndexData(MeshIndexData* subMesh)
         CC_SAFE_RETAIN(subMesh);
         CC_SAFE_RELEASE(_meshIndexData);
         _meshIndexData = subMesh;
+        _lod = 0;
         calculateAABB();
         bindMeshCommand();
     }
@@ -517,97 +526,200 @@ void Mesh::bindMeshCommand()
     }
 }
 
-void Mesh::setLightUniforms(Pass* pass, Scene* scene, const Vec4& color, unsigned int lightmask)
+namespace
 {
-    CCASSERT(pass, "Invalid Pass");
-    CCASSERT(scene, "Invalid scene");
+    // world space state of a light, computed once per render of the scene for all the meshes
+    struct LightInfo
+    {
+        LightType type;
+        unsigned int flag;
+        Vec3 color;
+        Vec3 position;
+        Vec3 direction;
+        float range;
+        float cosInnerAngle;
+        float cosOuterAngle;
+    };
+
+    std::vector<LightInfo> s_lightInfos;
+    const Scene* s_lightInfoScene = nullptr;
+    unsigned int s_lightInfoRenderId = 0;
+
+    // the lights may change between the renders of a frame, and at any time outside the render of
+    // the scene, e.g. for utils::captureNode(), where they are gathered for each mesh
+    const std::vector<LightInfo>& getLightInfos(const Scene* scene)
+    {
+        unsigned int renderId = scene->getRenderId();
+        if (renderId != 0 && scene == s_lightInfoScene && renderId == s_lightInfoRenderId)
+            return s_lightInfos;
+
+        s_lightInfoScene = scene;
+        s_lightInfoRenderId = renderId;
+        s_lightInfos.clear();
+        for (const auto& light : scene->getLights())
+        {
+            if (!light->isEnabled())
+                continue;
+
+            LightInfo info;
+            info.type = light->getLightType();
+            info.flag = (unsigned int)light->getLightFlag();
+            const Color3B& col = light->getDisplayedColor();
+            float intensity = light->getIntensity();
+            info.color.set(col.r / 255.0f * intensity, col.g / 255.0f * intensity, col.b / 255.0f * intensity);
+            info.range = 0;
+            info.cosInnerAngle = 1.0f;
+            info.cosOuterAngle = 0.0f;
+            switch (info.type)
+            {
+                case LightType::DIRECTIONAL:
+                    info.direction = static_cast<DirectionLight*>(light)->getDirectionInWorld();
+                    info.direction.normalize();
+                    break;
+                case LightType::POINT:
+                {
+                    Mat4 mat = light->getNodeToWorldTransform();
+                    info.position.set(mat.m[12], mat.m[13], mat.m[14]);
+                    info.range = static_cast<PointLight*>(light)->getRange();
+                }
+                    break;
+                case LightType::SPOT:
+                {
+                    auto spotLight = static_cast<SpotLight*>(light);
+                    Mat4 mat = light->getNodeToWorldTransform();
+                    info.position.set(mat.m[12], mat.m[13], mat.m[14]);
+                    info.direction = spotLight->getDirectionInWorld();
+                    info.direction.normalize();
+                    info.range = spotLight->getRange();
+                    info.cosInnerAngle = spotLight->getCosInnerAngle();
+                    info.cosOuterAngle = spotLight->getCosOuterAngle();
+                }
+                    break;
+                default:
+                    break;
+            }
+            s_lightInfos.push_back(info);
+        }
+        return s_lightInfos;
+    }
 
+    // how much a point or spot light may light a box, 0 if the box is out of its range,
+    // following the attenuation of the shaders
+    float getLightInfluence(const LightInfo& light, const AABB& aabb)
+    {
+        Vec3 closest(clampf(light.position.x, aabb._min.x, aabb._max.x),
+                     clampf(light.position.y, aabb._min.y, aabb._max.y),
+                     clampf(light.position.z, aabb._min.z, aabb._max.z));
+        float distanceSquared = light.position.distanceSquared(closest);
+        float rangeSquared = light.range * light.range;
+        if (distanceSquared >= rangeSquared)
+            return 0;
+        float brightness = light.color.x * 0.299f + light.color.y * 0.587f + light.color.z * 0.114f;
+        return brightness * (1.0f - distanceSquared / rangeSquared);
+    }
+
+    // keeps the lights with the most influence on the box, at most maxCount
+    void selectLights(std::vector<std::pair<float, int>>& candidates, int maxCount)
+    {
+        if ((int)candidates.size() <= maxCount)
+            return;
+        std::partial_sort(candidates.begin(), candidates.begin() + maxCount, candidates.end(),
+                          [](const std::pair<float, int>& a, const std::pair<float, int>& b) {
+                              return a.first > b.first;
+                          });
+        candidates.resize(maxCount);
+    }
+}
+
+void Mesh::updateLightUniformValues(Scene* scene, unsigned int lightmask, const Mat4& transform)
+{
     const auto& conf = Configuration::getInstance();
     int maxDirLight = conf->getMaxSupportDirLightInShader();
     int maxPointLight = conf->getMaxSupportPointLightInShader();
     int maxSpotLight = conf->getMaxSupportSpotLightInShader();
-    auto &lights = scene->getLights();
 
-    auto glProgramState = pass->getGLProgramState();
-    auto attributes = pass->getVertexAttributeBinding()->getVertexAttribsFlags();
+    resetLightUniformValues();
+    _ambientLightColor.setZero();
+    _hasAmbientLight = false;
 
-    if (attributes & (1 << GLProgram::VERTEX_ATTRIB_NORMAL))
+    // the point and spot lights are culled against the bounds of the mesh, the closest and brightest are kept
+    AABB worldAABB(_aabb);
+    worldAABB.transform(transform);
+    _pointLightCandidates.clear();
+    _spotLightCandidates.clear();
+
+    const auto& lightInfos = getLightInfos(scene);
+    int enabledDirLightNum = 0;
+    for (int index = 0; index < (int)lightInfos.size(); ++index)
     {
-        resetLightUniformValues();
+        const LightInfo& light = lightInfos[index];
+        if (!(light.flag & lightmask))
+            continue;
 
-        GLint enabledDirLightNum = 0;
-        GLint enabledPointLightNum = 0;
-        GLint enabledSpotLightNum = 0;
-        Vec3 ambientColor;
-        for (const auto& light : lights)
+        switch (light.type)
         {
-            bool useLight = light->isEnabled() && ((unsigned int)light->getLightFlag() & lightmask);
-            if (useLight)
-            {
-                float intensity = light->getIntensity();
-                switch (light->getLightType())
+            case LightType::DIRECTIONAL:
+                if (enabledDirLightNum < maxDirLight)
                 {
-                    case LightType::DIRECTIONAL:
-                    {
-                        if(enabledDirLightNum < maxDirLight)
-                        {
-                            auto dirLight = static_cast<DirectionLight *>(light);
-                            Vec3 dir = dirLight->getDirectionInWorld();
-                            dir.normalize();
-                            const Color3B &col = dirLight->getDisplayedColor();
-                            _dirLightUniformColorValues[enabledDirLightNum].set(col.r / 255.0f * intensity, col.g / 255.0f * intensity, col.b / 255.0f * intensity);
-                            _dirLightUniformDirValues[enabledDirLightNum] = dir;
-                            ++enabledDirLightNum;
-                        }
-
-                    }
-                        break;
-                    case LightType::POINT:
-                    {
-                        if(enabledPointLightNum < maxPointLight)
-                        {
-                            auto pointLight = static_cast<PointLight *>(light);
-                            Mat4 mat= pointLight->getNodeToWorldTransform();
-                            const Color3B &col = pointLight->getDisplayedColor();
-                            _pointLightUniformColorValues[enabledPointLightNum].set(col.r / 255.0f * intensity, col.g / 255.0f * intensity, col.b / 255.0f * intensity);
-                            _pointLightUniformPositionValues[enabledPointLightNum].set(mat.m[12], mat.m[13], mat.m[14]);
-                            _pointLightUniformRangeInverseValues[enabledPointLightNum] = 1.0f / pointLight->getRange();
-                            ++enabledPointLightNum;
-                        }
-                    }
-                        break;
-                    case LightType::SPOT:
-                    {
-                        if(enabledSpotLightNum < maxSpotLight)
-                        {
-                            auto spotLight = static_cast<SpotLight *>(light);
-                            Vec3 dir = spotLight->getDirectionInWorld();
-                            dir.normalize();
-                            Mat4 mat= light->getNodeToWorldTransform();
-                            const Color3B &col = spotLight->getDisplayedColor();
-                            _spotLightUniformColorValues[enabledSpotLightNum].set(col.r / 255.0f * intensity, col.g / 255.0f * intensity, col.b / 255.0f * intensity);
-                            _spotLightUniformPositionValues[enabledSpotLightNum].set(mat.m[12], mat.m[13], mat.m[14]);
-                            _spotLightUniformDirValues[enabledSpotLightNum] = dir;
-                            _spotLightUniformInnerAngleCosValues[enabledSpotLightNum] = spotLight->getCosInnerAngle();
-                            _spotLightUniformOuterAngleCosValues[enabledSpotLightNum] = spotLight->getCosOuterAngle();
-                            _spotLightUniformRangeInverseValues[enabledSpotLightNum] = 1.0f / spotLight->getRange();
-                            ++enabledSpotLightNum;
-                        }
-                    }
-                        break;
-                    case LightType::AMBIENT:
-                    {
-                        auto ambLight = static_cast<AmbientLight *>(light);
-                        const Color3B &col = ambLight->getDisplayedColor();
-                        ambientColor.add(col.r / 255.0f * intensity, col.g / 255.0f * intensity, col.b / 255.0f * intensity);
-                    }
-                        break;
-                    default:
-                        break;
+                    _dirLightUniformColorValues[enabledDirLightNum] = light.color;
+                    _dirLightUniformDirValues[enabledDirLightNum] = light.direction;
+                    ++enabledDirLightNum;
                 }
+                break;
+            case LightType::POINT:
+            case LightType::SPOT:
+            {
+                float influence = getLightInfluence(light, worldAABB);
+                if (influence > 0)
+                    (light.type == LightType::POINT ? _pointLightCandidates : _spotLightCandidates).push_back(std::make_pair(influence, index));
             }
+                break;
+            case LightType::AMBIENT:
+                _ambientLightColor.add(light.color);
+                _hasAmbientLight = true;
+                break;
+            default:
+                break;
         }
+    }
+
+    selectLights(_pointLightCandidates, maxPointLight);
+    for (size_t i = 0; i < _pointLightCandidates.size(); ++i)
+    {
+        const LightInfo& light = lightInfos[_pointLightCandidates[i].second];
+        _pointLightUniformColorValues[i] = light.color;
+        _pointLightUniformPositionValues[i] = light.position;
+        _pointLightUniformRangeInverseValues[i] = 1.0f / light.range;
+    }
+
+    selectLights(_spotLightCandidates, maxSpotLight);
+    for (size_t i = 0; i < _spotLightCandidates.size(); ++i)
+    {
+        const LightInfo& light = lightInfos[_spotLightCandidates[i].second];
+        _spotLightUniformColorValues[i] = light.color;
+        _spotLightUniformPositionValues[i] = light.position;
+        _spotLightUniformDirValues[i] = light.direction;
+        _spotLightUniformInnerAngleCosValues[i] = light.cosInnerAngle;
+        _spotLightUniformOuterAngleCosValues[i] = light.cosOuterAngle;
+        _spotLightUniformRangeInverseValues[i] = 1.0f / light.range;
+    }
+}
+
+void Mesh::setLightUniforms(Pass* pass, const Vec4& color)
+{
+    CCASSERT(pass, "Invalid Pass");
+
+    const auto& conf = Configuration::getInstance();
+    int maxDirLight = conf->getMaxSupportDirLightInShader();
+    int maxPointLight = conf->getMaxSupportPointLightInShader();
+    int maxSpotLight = conf->getMaxSupportSpotLightInShader();
 
+    auto glProgramState = pass->getGLProgramState();
+    auto attributes = pass->getVertexAttributeBinding()->getVertexAttribsFlags();
+
+    if (attributes & (1 << GLProgram::VERTEX_ATTRIB_NORMAL))
+    {
+        // the shaders loop over all the slots, so the unused ones are uploaded too, with a black color
         if (0 < maxDirLight)
         {
             glProgramState->setUniformVec3v(s_dirLightUniformColorName, _dirLightUniformColorValues.size(), &_dirLightUniformColorValues[0]);
@@ -631,32 +743,14 @@ void Mesh::setLightUniforms(Pass* pass, Scene* scene, const Vec4& color, unsigne
             glProgramState->setUniformFloatv(s_spotLightUniformRangeInverseName, _spotLightUniformRangeInverseValues.size(), &_spotLightUniformRangeInverseValues[0]);
         }
 
-        glProgramState->setUniformVec3(s_ambientLightUniformColorName, Vec3(ambientColor.x, ambientColor.y, ambientColor.z));
+        glProgramState->setUniformVec3(s_ambientLightUniformColorName, _ambientLightColor);
     }
     else // normal does not exist
     {
-        Vec3 ambient(0.0f, 0.0f, 0.0f);
-        bool hasAmbient = false;
-        for (const auto& light : lights)
+        if (_hasAmbientLight)
         {
-            if (light->getLightType() == LightType::AMBIENT)
-            {
-                bool useLight = light->isEnabled() && ((unsigned int)light->getLightFlag() & lightmask);
-                if (useLight)
-                {
-                    hasAmbient = true;
-                    const Color3B &col = light->getDisplayedColor();
-                    ambient.x += col.r * light->getIntensity();
-                    ambient.y += col.g * light->getIntensity();
-                    ambient.z += col.b * light->getIntensity();
-                }
-            }
-        }
-        if (hasAmbient)
-        {
-            ambient.x /= 255.f; ambient.y /= 255.f; ambient.z /= 255.f;
             //override the uniform value of u_color using the calculated color 
-            glProgramState->setUniformVec4("u_color", Vec4(color.x * ambient.x, color.y * ambient.y, color.z * ambient.z, color.w));
+            glProgramState->setUniformVec4("u_color", Vec4(color.x * _ambientLightColor.x, color.y * _ambientLightColor.y, color.z * _ambientLightColor.z, color.w));
         }
     }
 }
@@ -691,7 +785,12 @@ GLenum Mesh::getPrimitiveType() const
 
 ssize_t Mesh::getIndexCount() const
 {
-    return _meshIndexData->getIndexBuffer()->getIndexNumber();
+    return _meshIndexData->getIndexCount(_lod);
+}
+
+void Mesh::setLOD(int lod)
+{
+    _lod = _meshIndexData ? std::max(0, std::min(lod, _meshIndexData->getLODCount() - 1)) : 0;
 }
 
 GLenum Mesh::getIndexFormat() const
@@ -169,11 +169,17 @@ public:
      */
     GLenum getPrimitiveType() const;
     /**
-     * get index count
+     * get index count of the current level of detail
      *
      * @lua NA
      */
     ssize_t getIndexCount() const;
+    /**
+     * Sets the level of detail drawn, clamped to the levels of the MeshIndexData. 0 is the full resolution mesh.
+     * @since v3.18
+     */
+    void setLOD(int lod);
+    int getLOD() const { return _lod; }
     /**
      * get index format
      *
@@ -235,7 +241,9 @@ CC_CONSTRUCTOR_ACCESS:
 
 protected:
     void resetLightUniformValues();
-    void setLightUniforms(Pass* pass, Scene* scene, const Vec4& color, unsigned int lightmask);
+    /** selects the lights of the scene lighting the mesh, shared by all the passes */
+    void updateLightUniformValues(Scene* scene, unsigned int lightmask, const Mat4& transform);
+    void setLightUniforms(Pass* pass, const Vec4& color);
     void bindMeshCommand();
 
     std::map<NTextureData::Usage, Texture2D*> _textures; //textures that submesh is using
@@ -247,6 +255,7 @@ protected:
     std::string         _name;
     MeshCommand         _meshCommand;
     MeshIndexData*      _meshIndexData;
+    int                 _lod; // level of detail of _meshIndexData drawn
     GLProgramState*     _glProgramState;
     BlendFunc           _blend;
     bool                _blendDirty;
@@ -268,6 +277,11 @@ protected:
     std::vector<float> _spotLightUniformInnerAngleCosValues;
     std::vector<float> _spotLightUniformOuterAngleCosValues;
     std::vector<float> _spotLightUniformRangeInverseValues;
+    Vec3 _ambientLightColor;
+    bool _hasAmbientLight;
+    // point and spot lights reaching the mesh: influence and index in the lights of the scene, kept to not allocate every draw
+    std::vector<std::pair<float, int>> _pointLightCandidates;
+    std::vector<std::pair<float, int>> _spotLightCandidates;
 
     std::string _texFile;
 };
@@ -0,0 +1,484 @@
+/****************************************************************************
+Copyright (c) 2017-2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "3d/CCMeshOptimizer.h"
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+#include <string.h>
+#include <math.h>
+
+#include "3d/CCBundle3DData.h"
+#include "math/Vec3.h"
+#include "renderer/CCGLProgram.h"
+
+NS_CC_BEGIN
+
+namespace
+{
+    // scores of "Linear-Speed Vertex Cache Optimisation", Tom Forsyth
+    const int CACHE_SIZE = 32;
+    const float CACHE_DECAY_POWER = 1.5f;
+    const float LAST_TRIANGLE_SCORE = 0.75f;
+    const float VALENCE_BOOST_SCALE = 2.0f;
+    const float VALENCE_BOOST_POWER = 0.5f;
+
+    // size of the FIFO cache simulated to find the runs of triangles for the overdraw optimization
+    const unsigned int OVERDRAW_CACHE_SIZE = 16;
+
+    float vertexScore(int cachePosition, unsigned int liveTriangles)
+    {
+        // no triangle left to draw with it
+        if (liveTriangles == 0)
+            return -1.0f;
+
+        float score = 0.0f;
+        if (cachePosition >= 0)
+        {
+            // the vertices of the last triangle are in the cache whatever the next triangle is
+            if (cachePosition < 3)
+                score = LAST_TRIANGLE_SCORE;
+            else
+                score = powf(1.0f - (cachePosition - 3) * (1.0f / (CACHE_SIZE - 3)), CACHE_DECAY_POWER);
+        }
+        // finishes the vertices with few triangles left, so they don't have to come back later
+        score += VALENCE_BOOST_SCALE * powf((float)liveTriangles, -VALENCE_BOOST_POWER);
+        return score;
+    }
+
+    bool areIndicesInRange(const unsigned short* indices, size_t indexCount, size_t vertexCount)
+    {
+        return std::all_of(indices, indices + indexCount, [vertexCount](unsigned short index) {
+            return index < vertexCount;
+        });
+    }
+
+    Vec3 readPosition(const void* positions, size_t stride, unsigned short index)
+    {
+        Vec3 position;
+        memcpy(&position.x, (const char*)positions + index * stride, 3 * sizeof(float));
+        return position;
+    }
+
+    int findAttribOffset(const MeshData* meshdata, int vertexAttrib)
+    {
+        int offset = 0;
+        for (const auto& attrib : meshdata->attribs)
+        {
+            if (attrib.vertexAttrib == vertexAttrib)
+                return offset;
+            offset += attrib.attribSizeBytes;
+        }
+        return -1;
+    }
+
+    // sorts the vertices in the order the sub meshes and their levels of detail use them, and drops the unused ones
+    void optimizeVertexFetch(MeshData* meshdata, size_t stride, size_t vertexCount)
+    {
+        std::vector<MeshData::IndexArray*> indexArrays;
+        for (auto& indices : meshdata->subMeshIndices)
+            indexArrays.push_back(&indices);
+        for (auto& lods : meshdata->subMeshLODs)
+        {
+            for (auto& lod : lods)
+                indexArrays.push_back(&lod.indices);
+        }
+        for (const auto indices : indexArrays)
+        {
+            if (!areIndicesInRange(indices->data(), indices->size(), vertexCount))
+                return;
+        }
+
+        std::vector<int> remap(vertexCount, -1);
+        int usedVertexCount = 0;
+        for (auto indices : indexArrays)
+        {
+            for (auto& index : *indices)
+            {
+                if (remap[index] < 0)
+                    remap[index] = usedVertexCount++;
+                index = (unsigned short)remap[index];
+            }
+        }
+
+        const size_t floatsPerVertex = stride / sizeof(float);
+        std::vector<float> vertices(usedVertexCount * floatsPerVertex);
+        for (size_t i = 0; i < vertexCount; ++i)
+        {
+            if (remap[i] >= 0)
+                memcpy(&vertices[remap[i] * floatsPerVertex], &meshdata->vertex[i * floatsPerVertex], stride);
+        }
+        meshdata->vertex.swap(vertices);
+        meshdata->vertexSizeInFloat = (int)meshdata->vertex.size();
+    }
+
+    int roundUp4(int size)
+    {
+        return (size + 3) & ~3;
+    }
+
+    bool isInRange(const MeshData* meshdata, size_t stride, size_t vertexCount, int offset, int size, float minValue, float maxValue)
+    {
+        for (size_t i = 0; i < vertexCount; ++i)
+        {
+            const float* values = (const float*)((const char*)meshdata->vertex.data() + i * stride + offset);
+            for (int j = 0; j < size; ++j)
+            {
+                if (!(values[j] >= minValue && values[j] <= maxValue))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    // stores the attributes which allow it as normalized integers, the vertex attrib bindings turn them back into floats
+    void quantize(MeshData* meshdata, size_t stride, size_t vertexCount)
+    {
+        auto attribs = meshdata->attribs;
+        int offset = 0;
+        bool changed = false;
+        for (auto& attrib : attribs)
+        {
+            int attribOffset = offset;
+            offset += attrib.attribSizeBytes;
+            if (attrib.type != GL_FLOAT)
+                continue;
+
+            switch (attrib.vertexAttrib)
+            {
+            case GLProgram::VERTEX_ATTRIB_NORMAL:
+            case GLProgram::VERTEX_ATTRIB_TANGENT:
+            case GLProgram::VERTEX_ATTRIB_BINORMAL:
+                if (isInRange(meshdata, stride, vertexCount, attribOffset, attrib.size, -1.0f, 1.0f))
+                    attrib.type = GL_SHORT;
+                break;
+            case GLProgram::VERTEX_ATTRIB_TEX_COORD:
+            case GLProgram::VERTEX_ATTRIB_TEX_COORD1:
+            case GLProgram::VERTEX_ATTRIB_TEX_COORD2:
+            case GLProgram::VERTEX_ATTRIB_TEX_COORD3:
+            case GLProgram::VERTEX_ATTRIB_BLEND_WEIGHT:
+                // repeated textures have coordinates out of [0, 1]
+                if (isInRange(meshdata, stride, vertexCount, attribOffset, attrib.size, 0.0f, 1.0f))
+                    attrib.type = GL_UNSIGNED_SHORT;
+                break;
+            case GLProgram::VERTEX_ATTRIB_COLOR:
+                if (isInRange(meshdata, stride, vertexCount, attribOffset, attrib.size, 0.0f, 1.0f))
+                    attrib.type = GL_UNSIGNED_BYTE;
+                break;
+            default:
+                break;
+            }
+            if (attrib.type != GL_FLOAT)
+            {
+                // the attributes stay aligned on 4 bytes
+                attrib.attribSizeBytes = roundUp4(attrib.size * (attrib.type == GL_UNSIGNED_BYTE ? 1 : 2));
+                changed = true;
+            }
+        }
+        if (!changed)
+            return;
+
+        int newStride = 0;
+        for (const auto& attrib : attribs)
+            newStride += attrib.attribSizeBytes;
+
+        std::vector<float> vertices(vertexCount * newStride / sizeof(float));
+        for (size_t i = 0; i < vertexCount; ++i)
+        {
+            const char* source = (const char*)meshdata->vertex.data() + i * stride;
+            char* destination = (char*)vertices.data() + i * newStride;
+            for (size_t k = 0; k < attribs.size(); ++k)
+            {
+                const auto& attrib = attribs[k];
+                const float* values = (const float*)source;
+                switch (attrib.type)
+                {
+                case GL_SHORT:
+                    for (int j = 0; j < attrib.size; ++j)
+                        ((short*)destination)[j] = (short)roundf(values[j] * 32767.0f);
+                    break;
+                case GL_UNSIGNED_SHORT:
+                    for (int j = 0; j < attrib.size; ++j)
+                        ((unsigned short*)destination)[j] = (unsigned short)roundf(values[j] * 65535.0f);
+                    break;
+                case GL_UNSIGNED_BYTE:
+                    for (int j = 0; j < attrib.size; ++j)
+                        ((unsigned char*)destination)[j] = (unsigned char)roundf(values[j] * 255.0f);
+                    break;
+                default:
+                    memcpy(destination, source, attrib.attribSizeBytes);
+                    break;
+                }
+                source += meshdata->attribs[k].attribSizeBytes;
+                destination += attrib.attribSizeBytes;
+            }
+        }
+        meshdata->vertex.swap(vertices);
+        meshdata->vertexSizeInFloat = (int)meshdata->vertex.size();
+        meshdata->attribs = attribs;
+    }
+}
+
+void MeshOptimizer::optimizeVertexCache(unsigned short* indices, size_t indexCount, size_t vertexCount)
+{
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2 || !areIndicesInRange(indices, triangleCount * 3, vertexCount))
+        return;
+
+    // the triangles using each vertex, the ones not drawn yet first
+    std::vector<unsigned int> liveTriangles(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i)
+        ++liveTriangles[indices[i]];
+    std::vector<unsigned int> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < vertexCount; ++i)
+        adjacencyOffsets[i + 1] = adjacencyOffsets[i] + liveTriangles[i];
+    std::vector<unsigned int> adjacency(triangleCount * 3);
+    std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (size_t i = 0; i < triangleCount * 3; ++i)
+        adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+
+    std::vector<int> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i)
+        vertexScores[i] = vertexScore(-1, liveTriangles[i]);
+
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    int bestTriangle = 0;
+    for (size_t i = 0; i < triangleCount; ++i)
+    {
+        triangleScores[i] = vertexScores[indices[i * 3]] + vertexScores[indices[i * 3 + 1]] + vertexScores[indices[i * 3 + 2]];
+        if (triangleScores[i] > triangleScores[bestTriangle])
+            bestTriangle = (int)i;
+    }
+
+    std::vector<unsigned short> result;
+    result.reserve(triangleCount * 3);
+    int cache[CACHE_SIZE + 3];
+    int cacheCount = 0;
+    size_t nextCandidate = 0;
+    while (bestTriangle >= 0)
+    {
+        const unsigned short* triangle = indices + bestTriangle * 3;
+        result.insert(result.end(), triangle, triangle + 3);
+        emitted[bestTriangle] = true;
+
+        // the triangle isn't live anymore
+        for (int k = 0; k < 3; ++k)
+        {
+            auto begin = adjacency.begin() + adjacencyOffsets[triangle[k]];
+            auto end = begin + liveTriangles[triangle[k]];
+            std::iter_swap(std::find(begin, end, (unsigned int)bestTriangle), end - 1);
+            --liveTriangles[triangle[k]];
+        }
+
+        // its vertices move to the front of the cache
+        int newCache[CACHE_SIZE + 3];
+        int newCacheCount = 0;
+        for (int k = 0; k < 3; ++k)
+        {
+            if (std::find(newCache, newCache + newCacheCount, triangle[k]) == newCache + newCacheCount)
+                newCache[newCacheCount++] = triangle[k];
+        }
+        const int triangleVertexCount = newCacheCount;
+        for (int i = 0; i < cacheCount; ++i)
+        {
+            if (std::find(newCache, newCache + triangleVertexCount, cache[i]) == newCache + triangleVertexCount)
+                newCache[newCacheCount++] = cache[i];
+        }
+
+        // the scores of the vertices which moved in or out of the cache change, and so do the ones of their triangles
+        for (int i = 0; i < newCacheCount; ++i)
+        {
+            int vertex = newCache[i];
+            cachePositions[vertex] = i < CACHE_SIZE ? i : -1;
+            float score = vertexScore(cachePositions[vertex], liveTriangles[vertex]);
+            float delta = score - vertexScores[vertex];
+            vertexScores[vertex] = score;
+            for (unsigned int j = 0; j < liveTriangles[vertex]; ++j)
+                triangleScores[adjacency[adjacencyOffsets[vertex] + j]] += delta;
+        }
+        cacheCount = std::min(newCacheCount, CACHE_SIZE);
+        memcpy(cache, newCache, cacheCount * sizeof(int));
+
+        // the next triangle uses the vertices in the cache
+        bestTriangle = -1;
+        float bestScore = -1.0f;
+        for (int i = 0; i < cacheCount; ++i)
+        {
+            int vertex = cache[i];
+            for (unsigned int j = 0; j < liveTriangles[vertex]; ++j)
+            {
+                unsigned int candidate = adjacency[adjacencyOffsets[vertex] + j];
+                if (triangleScores[candidate] > bestScore)
+                {
+                    bestScore = triangleScores[candidate];
+                    bestTriangle = (int)candidate;
+                }
+            }
+        }
+        // or starts somewhere else
+        if (bestTriangle < 0)
+        {
+            while (nextCandidate < triangleCount && emitted[nextCandidate])
+                ++nextCandidate;
+            bestTriangle = nextCandidate < triangleCount ? (int)nextCandidate : -1;
+        }
+    }
+    memcpy(indices, result.data(), result.size() * sizeof(unsigned short));
+}
+
+void MeshOptimizer::optimizeOverdraw(unsigned short* indices, size_t indexCount, const void* positions, size_t stride, size_t vertexCount)
+{
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2 || !areIndicesInRange(indices, triangleCount * 3, vertexCount))
+        return;
+
+    // the runs start where the cache misses all the vertices of a triangle, reordering them barely changes the cache efficiency
+    std::vector<size_t> clusterStarts;
+    std::vector<unsigned int> cacheTimes(vertexCount, 0);
+    unsigned int time = OVERDRAW_CACHE_SIZE + 1;
+    for (size_t i = 0; i < triangleCount; ++i)
+    {
+        int misses = 0;
+        for (int k = 0; k < 3; ++k)
+        {
+            unsigned short index = indices[i * 3 + k];
+            if (time - cacheTimes[index] > OVERDRAW_CACHE_SIZE)
+            {
+                cacheTimes[index] = time++;
+                ++misses;
+            }
+        }
+        if (i == 0 || misses == 3)
+            clusterStarts.push_back(i);
+    }
+    if (clusterStarts.size() < 2)
+        return;
+    clusterStarts.push_back(triangleCount);
+
+    // the clusters facing away from the center of the mesh are drawn first, they hide the others
+    const size_t clusterCount = clusterStarts.size() - 1;
+    std::vector<Vec3> clusterCentroids(clusterCount);
+    std::vector<Vec3> clusterNormals(clusterCount);
+    Vec3 meshCentroid;
+    float meshArea = 0.0f;
+    for (size_t c = 0; c < clusterCount; ++c)
+    {
+        Vec3 centroid;
+        Vec3 normal;
+        float area = 0.0f;
+        for (size_t i = clusterStarts[c]; i < clusterStarts[c + 1]; ++i)
+        {
+            Vec3 p0 = readPosition(positions, stride, indices[i * 3]);
+            Vec3 p1 = readPosition(positions, stride, indices[i * 3 + 1]);
+            Vec3 p2 = readPosition(positions, stride, indices[i * 3 + 2]);
+            Vec3 cross;
+            Vec3::cross(p1 - p0, p2 - p0, &cross);
+            float triangleArea = cross.length();
+            centroid += (p0 + p1 + p2) * (triangleArea / 3.0f);
+            normal += cross;
+            area += triangleArea;
+        }
+        meshCentroid += centroid;
+        meshArea += area;
+        clusterCentroids[c] = area > 0.0f ? centroid / area : centroid;
+        normal.normalize();
+        clusterNormals[c] = normal;
+    }
+    if (meshArea > 0.0f)
+        meshCentroid = meshCentroid / meshArea;
+
+    std::vector<float> sortKeys(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c)
+        sortKeys[c] = (clusterCentroids[c] - meshCentroid).dot(clusterNormals[c]);
+    std::vector<size_t> order(clusterCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&sortKeys](size_t a, size_t b) {
+        return sortKeys[a] > sortKeys[b];
+    });
+
+    std::vector<unsigned short> result;
+    result.reserve(triangleCount * 3);
+    for (auto c : order)
+        result.insert(result.end(), indices + clusterStarts[c] * 3, indices + clusterStarts[c + 1] * 3);
+    memcpy(indices, result.data(), result.size() * sizeof(unsigned short));
+}
+
+float MeshOptimizer::getACMR(const unsigned short* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize)
+{
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0 || !areIndicesInRange(indices, triangleCount * 3, vertexCount))
+        return 0.0f;
+
+    std::vector<unsigned int> cacheTimes(vertexCount, 0);
+    unsigned int time = cacheSize + 1;
+    for (size_t i = 0; i < triangleCount * 3; ++i)
+    {
+        if (time - cacheTimes[indices[i]] > cacheSize)
+            cacheTimes[indices[i]] = time++;
+    }
+    return (float)(time - cacheSize - 1) / triangleCount;
+}
+
+void MeshOptimizer::optimize(MeshData* meshdata, int flags)
+{
+    if (!flags)
+        return;
+
+    const int stride = meshdata->getPerVertexSize();
+    if (stride <= 0 || stride % sizeof(float) != 0)
+        return;
+    meshdata->copyViews();
+    const size_t vertexCount = meshdata->vertex.size() * sizeof(float) / stride;
+
+    if (flags & (VERTEX_CACHE | OVERDRAW))
+    {
+        int positionOffset = findAttribOffset(meshdata, GLProgram::VERTEX_ATTRIB_POSITION);
+        const char* positions = positionOffset >= 0 ? (const char*)meshdata->vertex.data() + positionOffset : nullptr;
+        for (size_t i = 0; i < meshdata->subMeshIndices.size(); ++i)
+        {
+            auto& indices = meshdata->subMeshIndices[i];
+            if (flags & VERTEX_CACHE)
+                optimizeVertexCache(indices.data(), indices.size(), vertexCount);
+            if ((flags & OVERDRAW) && positions)
+                optimizeOverdraw(indices.data(), indices.size(), positions, stride, vertexCount);
+            // the levels of detail are seen from afar, the overdraw matters less than the cache
+            if ((flags & VERTEX_CACHE) && i < meshdata->subMeshLODs.size())
+            {
+                for (auto& lod : meshdata->subMeshLODs[i])
+                    optimizeVertexCache(lod.indices.data(), lod.indices.size(), vertexCount);
+            }
+        }
+    }
+
+    if (flags & VERTEX_FETCH)
+        optimizeVertexFetch(meshdata, stride, vertexCount);
+
+    if (flags & QUANTIZE)
+        quantize(meshdata, stride, meshdata->vertex.size() * sizeof(float) / stride);
+}
+
+NS_CC_END
@@ -0,0 +1,108 @@
+/****************************************************************************
+Copyright (c) 2017-2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+#ifndef __CC_MESH_OPTIMIZER_H__
+#define __CC_MESH_OPTIMIZER_H__
+
+#include <stddef.h>
+
+#include "platform/CCPlatformMacros.h"
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup _3d
+ * @{
+ */
+
+struct MeshData;
+
+/**
+ * Reorders and compresses triangle meshes so that the GPU processes them faster.
+ *
+ * - The triangles are sorted so that their vertices are found in the post-transform cache as often as possible,
+ *   with the linear-speed algorithm of Tom Forsyth.
+ * - The runs of triangles which start with a cold cache are then sorted from the outside of the mesh to
+ *   its inside, so that the depth test rejects more pixels (overdraw), at almost no cost for the cache.
+ * - The vertices are sorted in the order the triangles use them, so that the vertex fetch reads memory
+ *   linearly, and the unused vertices are removed.
+ * - Optionally, the normals, texture coordinates, colors and blend weights are quantized into normalized
+ *   integers, the positions stay floats.
+ *
+ * The optimizations keep the triangles and their winding, only their order changes.
+ * @since v3.18
+ * @js NA
+ * @lua NA
+ */
+class CC_DLL MeshOptimizer
+{
+public:
+    /** the optimizations of optimize() */
+    enum Flags
+    {
+        VERTEX_CACHE = 1,
+        OVERDRAW = 2,
+        VERTEX_FETCH = 4,
+        QUANTIZE = 8,
+        /** the optimizations which don't change the vertex format */
+        REORDER = VERTEX_CACHE | OVERDRAW | VERTEX_FETCH,
+    };
+
+    /**
+     * Reorders the triangles of a triangle list for the post-transform vertex cache.
+     * The list is left unchanged if an index isn't lower than vertexCount.
+     */
+    static void optimizeVertexCache(unsigned short* indices, size_t indexCount, size_t vertexCount);
+
+    /**
+     * Reorders the triangles of a triangle list, which was optimized for the vertex cache, to reduce overdraw.
+     * The list is left unchanged if an index isn't lower than vertexCount.
+     *
+     * @param positions Position of the first vertex, 3 floats which don't need to be aligned.
+     * @param stride Number of bytes between the positions of two vertices.
+     */
+    static void optimizeOverdraw(unsigned short* indices, size_t indexCount, const void* positions, size_t stride, size_t vertexCount);
+
+    /**
+     * Average number of vertices transformed per triangle with a FIFO cache (ACMR), between 0.5 and 3, lower is better.
+     * It is 0 if an index isn't lower than vertexCount.
+     */
+    static float getACMR(const unsigned short* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize = 16);
+
+    /**
+     * Optimizes all the sub meshes and levels of detail of a mesh data, which share its vertices.
+     * The buffers viewed in a bundle are copied first.
+     *
+     * @param flags Combination of Flags.
+     */
+    static void optimize(MeshData* meshdata, int flags);
+};
+
+// end of 3d group
+/// @}
+
+NS_CC_END
+
+#endif // __CC_MESH_OPTIMIZER_H__
@@ -0,0 +1,477 @@
+/****************************************************************************
+Copyright (c) 2017-2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "3d/CCMeshSimplifier.h"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <unordered_set>
+#include <string.h>
+#include <float.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "3d/CCBundle3DData.h"
+#include "math/Vec3.h"
+#include "renderer/CCGLProgram.h"
+
+NS_CC_BEGIN
+
+namespace
+{
+    // symmetric 4x4 matrix, the sum of the squared distances to a set of planes
+    struct Quadric
+    {
+        double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+    };
+
+    void addPlane(Quadric& q, double a, double b, double c, double d)
+    {
+        q.a2 += a * a; q.ab += a * b; q.ac += a * c; q.ad += a * d;
+        q.b2 += b * b; q.bc += b * c; q.bd += b * d;
+        q.c2 += c * c; q.cd += c * d;
+        q.d2 += d * d;
+    }
+
+    void addQuadric(Quadric& q, const Quadric& other)
+    {
+        q.a2 += other.a2; q.ab += other.ab; q.ac += other.ac; q.ad += other.ad;
+        q.b2 += other.b2; q.bc += other.bc; q.bd += other.bd;
+        q.c2 += other.c2; q.cd += other.cd;
+        q.d2 += other.d2;
+    }
+
+    double evaluate(const Quadric& q, const Quadric& other, const Vec3& p)
+    {
+        const double x = p.x, y = p.y, z = p.z;
+        const double a2 = q.a2 + other.a2, ab = q.ab + other.ab, ac = q.ac + other.ac, ad = q.ad + other.ad;
+        const double b2 = q.b2 + other.b2, bc = q.bc + other.bc, bd = q.bd + other.bd;
+        const double c2 = q.c2 + other.c2, cd = q.cd + other.cd;
+        const double d2 = q.d2 + other.d2;
+        double cost = a2 * x * x + b2 * y * y + c2 * z * z + d2
+                    + 2 * (ab * x * y + ac * x * z + bc * y * z + ad * x + bd * y + cd * z);
+        return cost > 0 ? cost : 0;
+    }
+
+    struct Collapse
+    {
+        unsigned short from;
+        unsigned short to;
+        double cost;
+
+        bool operator<(const Collapse& other) const { return cost < other.cost; }
+    };
+
+    Vec3 triangleNormal(const Vec3& p0, const Vec3& p1, const Vec3& p2)
+    {
+        Vec3 normal;
+        Vec3::cross(p1 - p0, p2 - p0, &normal);
+        return normal;
+    }
+}
+
+std::vector<unsigned short> MeshSimplifier::simplify(const void* positions, size_t stride, size_t vertexCount,
+                                                     const unsigned short* indices, size_t indexCount,
+                                                     size_t targetIndexCount, float maxError, float* resultError)
+{
+    std::vector<unsigned short> result(indices, indices + (indexCount - indexCount % 3));
+    if (resultError)
+        *resultError = 0;
+    if (vertexCount == 0 || result.size() <= targetIndexCount)
+        return result;
+
+    // the positions may come from a mapped file, they are not aligned
+    std::vector<Vec3> points(vertexCount);
+    const unsigned char* bytes = (const unsigned char*)positions;
+    Vec3 minimum(FLT_MAX, FLT_MAX, FLT_MAX), maximum(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        float point[3];
+        memcpy(point, bytes + i * stride, sizeof(point));
+        points[i].set(point);
+        minimum.set(std::min(minimum.x, points[i].x), std::min(minimum.y, points[i].y), std::min(minimum.z, points[i].z));
+        maximum.set(std::max(maximum.x, points[i].x), std::max(maximum.y, points[i].y), std::max(maximum.z, points[i].z));
+    }
+    const double scale = (maximum - minimum).length();
+    if (scale <= 0)
+        return result;
+    const double maxCost = (maxError * scale) * (maxError * scale);
+
+    // the vertices at the same position are wedges of one position, identified by the smallest of them
+    std::vector<unsigned int> order(vertexCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&points](unsigned int a, unsigned int b) {
+        const Vec3& pa = points[a];
+        const Vec3& pb = points[b];
+        if (pa.x != pb.x) return pa.x < pb.x;
+        if (pa.y != pb.y) return pa.y < pb.y;
+        if (pa.z != pb.z) return pa.z < pb.z;
+        return a < b;
+    });
+    std::vector<unsigned short> positionIds(vertexCount);
+    std::vector<unsigned int> wedgeCounts(vertexCount, 0);
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        bool samePosition = i > 0 && points[order[i]] == points[order[i - 1]];
+        positionIds[order[i]] = samePosition ? positionIds[order[i - 1]] : (unsigned short)order[i];
+        ++wedgeCounts[positionIds[order[i]]];
+    }
+    // the other wedge of the positions which have two
+    std::vector<unsigned short> twins(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i)
+        twins[i] = (unsigned short)i;
+    for (size_t i = 1; i < vertexCount; ++i)
+    {
+        if (positionIds[order[i]] == positionIds[order[i - 1]] && wedgeCounts[positionIds[order[i]]] == 2)
+        {
+            twins[order[i]] = (unsigned short)order[i - 1];
+            twins[order[i - 1]] = (unsigned short)order[i];
+        }
+    }
+
+    auto edgeKey = [](unsigned short a, unsigned short b) { return (uint32_t)a << 16 | b; };
+    std::unordered_set<uint32_t> edges;
+    std::unordered_set<uint32_t> positionEdges;
+    edges.reserve(result.size());
+    positionEdges.reserve(result.size());
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            unsigned short a = result[i + k];
+            unsigned short b = result[i + (k + 1) % 3];
+            edges.insert(edgeKey(a, b));
+            positionEdges.insert(edgeKey(positionIds[a], positionIds[b]));
+        }
+    }
+
+    // The vertices of the open borders, which have an edge without the opposite one, can't move.
+    // The edges of an attribute seam have the opposite one between other wedges of the same positions,
+    // their vertices only move along the seam, together with their twin, so that the seam stays closed.
+    enum { FREE, SEAM, LOCKED };
+    std::vector<unsigned char> kinds(vertexCount, FREE);
+    const unsigned short NO_NEIGHBOR = 0xffff;
+    std::vector<std::array<unsigned short, 2>> seamNeighbors(vertexCount, {{ NO_NEIGHBOR, NO_NEIGHBOR }});
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            unsigned short a = result[i + k];
+            unsigned short b = result[i + (k + 1) % 3];
+            unsigned short pa = positionIds[a];
+            unsigned short pb = positionIds[b];
+            if (positionEdges.find(edgeKey(pb, pa)) == positionEdges.end())
+            {
+                kinds[pa] = kinds[pb] = LOCKED;
+            }
+            else if (edges.find(edgeKey(b, a)) == edges.end())
+            {
+                // a position with more than two seam edges is a corner of the seam
+                for (auto edge : { std::make_pair(pa, pb), std::make_pair(pb, pa) })
+                {
+                    auto& neighbors = seamNeighbors[edge.first];
+                    if (neighbors[0] == NO_NEIGHBOR || neighbors[0] == edge.second)
+                        neighbors[0] = edge.second;
+                    else if (neighbors[1] == NO_NEIGHBOR || neighbors[1] == edge.second)
+                        neighbors[1] = edge.second;
+                    else
+                        kinds[edge.first] = LOCKED;
+                }
+            }
+        }
+    }
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        unsigned short position = positionIds[i];
+        if (kinds[position] == FREE && wedgeCounts[position] > 1)
+        {
+            // two wedges on a seam which isn't a loop by itself, anything else is left as it is
+            bool isSeam = wedgeCounts[position] == 2 && seamNeighbors[position][1] != NO_NEIGHBOR;
+            kinds[position] = isSeam ? SEAM : LOCKED;
+        }
+        kinds[i] = kinds[position];
+    }
+
+    // the quadrics are shared by the wedges of a position
+    std::vector<Quadric> quadrics(vertexCount, Quadric());
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+        const Vec3& p0 = points[result[i]];
+        Vec3 normal = triangleNormal(p0, points[result[i + 1]], points[result[i + 2]]);
+        float length = normal.length();
+        if (length <= 0)
+            continue;
+        normal *= 1.0f / length;
+        const double d = -normal.dot(p0);
+        for (int k = 0; k < 3; ++k)
+            addPlane(quadrics[positionIds[result[i + k]]], normal.x, normal.y, normal.z, d);
+
+        // the seams keep their shape, the planes along their edges penalize moving across them
+        for (int k = 0; k < 3; ++k)
+        {
+            unsigned short a = result[i + k];
+            unsigned short b = result[i + (k + 1) % 3];
+            if (kinds[a] == FREE && kinds[b] == FREE)
+                continue;
+            if (edges.find(edgeKey(b, a)) != edges.end())
+                continue;
+            Vec3 edgeNormal;
+            Vec3::cross(points[b] - points[a], normal, &edgeNormal);
+            if (edgeNormal.lengthSquared() <= 0)
+                continue;
+            edgeNormal.normalize();
+            const double edgeD = -edgeNormal.dot(points[a]);
+            addPlane(quadrics[positionIds[a]], edgeNormal.x, edgeNormal.y, edgeNormal.z, edgeD);
+            addPlane(quadrics[positionIds[b]], edgeNormal.x, edgeNormal.y, edgeNormal.z, edgeD);
+        }
+    }
+
+    std::vector<unsigned int> adjacencyOffsets(vertexCount + 1);
+    std::vector<unsigned int> adjacency;
+    std::vector<unsigned short> remap(vertexCount);
+    std::vector<unsigned char> touched(vertexCount);
+    std::vector<Collapse> collapses;
+    double largestCost = 0;
+
+    // the wedge of a position next to a vertex, or NO_NEIGHBOR
+    auto findNeighborWedge = [&](unsigned short vertex, unsigned short position) -> unsigned short {
+        for (unsigned int j = adjacencyOffsets[vertex]; j < adjacencyOffsets[vertex + 1]; ++j)
+        {
+            const unsigned short* triangle = &result[adjacency[j] * 3];
+            for (int k = 0; k < 3; ++k)
+            {
+                if (positionIds[triangle[k]] == position)
+                    return triangle[k];
+            }
+        }
+        return NO_NEIGHBOR;
+    };
+
+    // whether the triangles of from which don't disappear would flip, counts the ones which do
+    auto flips = [&](unsigned short from, unsigned short to, size_t& disappearing) -> bool {
+        for (unsigned int j = adjacencyOffsets[from]; j < adjacencyOffsets[from + 1]; ++j)
+        {
+            const unsigned short* triangle = &result[adjacency[j] * 3];
+            if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+            {
+                ++disappearing;
+                continue;
+            }
+
+            Vec3 before = triangleNormal(points[triangle[0]], points[triangle[1]], points[triangle[2]]);
+            Vec3 moved[3];
+            for (int k = 0; k < 3; ++k)
+                moved[k] = points[triangle[k] == from ? to : triangle[k]];
+            Vec3 after = triangleNormal(moved[0], moved[1], moved[2]);
+            if (before.dot(after) <= 0 && before.lengthSquared() > 0)
+                return true;
+        }
+        return false;
+    };
+
+    auto touch = [&](unsigned short vertex) {
+        for (unsigned int j = adjacencyOffsets[vertex]; j < adjacencyOffsets[vertex + 1]; ++j)
+        {
+            const unsigned short* triangle = &result[adjacency[j] * 3];
+            touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = 1;
+        }
+    };
+
+    // every pass collapses the cheapest edges whose neighborhoods don't overlap
+    while (result.size() > targetIndexCount)
+    {
+        const size_t triangleCount = result.size() / 3;
+
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (auto index : result)
+            ++adjacencyOffsets[index + 1];
+        for (size_t i = 0; i < vertexCount; ++i)
+            adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+        adjacency.resize(result.size());
+        std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t t = 0; t < triangleCount; ++t)
+        {
+            for (int k = 0; k < 3; ++k)
+                adjacency[fill[result[t * 3 + k]]++] = (unsigned int)t;
+        }
+
+        auto canCollapse = [&](unsigned short from, unsigned short to) {
+            if (kinds[from] == FREE)
+                return true;
+            const auto& neighbors = seamNeighbors[positionIds[from]];
+            return kinds[from] == SEAM && (neighbors[0] == positionIds[to] || neighbors[1] == positionIds[to]);
+        };
+
+        collapses.clear();
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                unsigned short a = result[i + k];
+                unsigned short b = result[i + (k + 1) % 3];
+                const Quadric& qa = quadrics[positionIds[a]];
+                const Quadric& qb = quadrics[positionIds[b]];
+                if (canCollapse(a, b))
+                    collapses.push_back({ a, b, evaluate(qa, qb, points[b]) });
+                if (canCollapse(b, a))
+                    collapses.push_back({ b, a, evaluate(qa, qb, points[a]) });
+            }
+        }
+        std::sort(collapses.begin(), collapses.end());
+
+        for (size_t i = 0; i < vertexCount; ++i)
+            remap[i] = (unsigned short)i;
+        std::fill(touched.begin(), touched.end(), 0);
+
+        const size_t removableTriangles = (result.size() - targetIndexCount + 2) / 3;
+        size_t removedTriangles = 0;
+        for (const auto& collapse : collapses)
+        {
+            if (collapse.cost > maxCost || removedTriangles >= removableTriangles)
+                break;
+            if (touched[collapse.from] || touched[collapse.to])
+                continue;
+
+            size_t disappearing = 0;
+            if (flips(collapse.from, collapse.to, disappearing))
+                continue;
+
+            // the twin wedge moves to the wedge of the same position on its side of the seam
+            unsigned short twinFrom = NO_NEIGHBOR;
+            unsigned short twinTo = NO_NEIGHBOR;
+            if (kinds[collapse.from] == SEAM)
+            {
+                twinFrom = twins[collapse.from];
+                twinTo = findNeighborWedge(twinFrom, positionIds[collapse.to]);
+                if (twinTo == NO_NEIGHBOR || twinTo == collapse.to || touched[twinFrom] || touched[twinTo])
+                    continue;
+                if (flips(twinFrom, twinTo, disappearing))
+                    continue;
+            }
+
+            const unsigned short fromPosition = positionIds[collapse.from];
+            const unsigned short toPosition = positionIds[collapse.to];
+            remap[collapse.from] = collapse.to;
+            touch(collapse.from);
+            if (twinFrom != NO_NEIGHBOR)
+            {
+                remap[twinFrom] = twinTo;
+                touch(twinFrom);
+
+                // the seam goes on from the target to the other neighbor of the removed position
+                auto& neighbors = seamNeighbors[fromPosition];
+                unsigned short next = neighbors[0] == toPosition ? neighbors[1] : neighbors[0];
+                for (auto edge : { std::make_pair(toPosition, next), std::make_pair(next, toPosition) })
+                {
+                    auto& replaced = seamNeighbors[edge.first];
+                    for (auto& neighbor : replaced)
+                    {
+                        if (neighbor == fromPosition)
+                            neighbor = edge.second;
+                    }
+                }
+            }
+            addQuadric(quadrics[toPosition], quadrics[fromPosition]);
+            largestCost = std::max(largestCost, collapse.cost);
+            removedTriangles += disappearing;
+        }
+
+        if (removedTriangles == 0)
+            break;
+
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            unsigned short a = remap[result[i]];
+            unsigned short b = remap[result[i + 1]];
+            unsigned short c = remap[result[i + 2]];
+            if (a != b && b != c && a != c)
+            {
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+        }
+        result.resize(write);
+    }
+
+    if (resultError)
+        *resultError = (float)(sqrt(largestCost) / scale);
+    return result;
+}
+
+void MeshSimplifier::generateLODs(MeshData* meshdata, int levels, float maxError)
+{
+    meshdata->subMeshLODs.clear();
+    if (levels <= 0)
+        return;
+
+    int positionOffset = -1;
+    int offset = 0;
+    for (const auto& attrib : meshdata->attribs)
+    {
+        if (attrib.vertexAttrib == GLProgram::VERTEX_ATTRIB_POSITION && attrib.size >= 3)
+        {
+            positionOffset = offset;
+            break;
+        }
+        offset += attrib.attribSizeBytes;
+    }
+    const int stride = meshdata->getPerVertexSize();
+    if (positionOffset < 0 || stride <= 0)
+        return;
+
+    const size_t vertexCount = (size_t)meshdata->getVertexSizeInFloat() * sizeof(float) / stride;
+    const char* positions = (const char*)meshdata->getVertexData() + positionOffset;
+
+    meshdata->subMeshLODs.resize(meshdata->getSubMeshCount());
+    for (size_t i = 0; i < meshdata->getSubMeshCount(); ++i)
+    {
+        // the indices may be a view of a mapped file, they are not aligned
+        std::vector<unsigned short> current(meshdata->getIndexCount(i));
+        if (!current.empty())
+            memcpy(current.data(), meshdata->getIndexData(i), current.size() * sizeof(unsigned short));
+
+        float error = 0;
+        for (int level = 0; level < levels; ++level)
+        {
+            float levelError = 0;
+            auto simplified = simplify(positions, stride, vertexCount, current.data(), current.size(),
+                                       current.size() / 6 * 3, maxError - error, &levelError);
+            // not worth a level if it doesn't remove a quarter of the triangles
+            if (simplified.empty() || simplified.size() > current.size() * 3 / 4)
+                break;
+
+            error += levelError;
+            MeshData::LOD lod;
+            lod.indices = simplified;
+            lod.error = error;
+            meshdata->subMeshLODs[i].push_back(lod);
+            current.swap(simplified);
+        }
+    }
+}
+
+NS_CC_END
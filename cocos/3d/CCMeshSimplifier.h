@@ -0,0 +1,89 @@
+/****************************************************************************
+Copyright (c) 2017-2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CC_MESH_SIMPLIFIER_H__
+#define __CC_MESH_SIMPLIFIER_H__
+
+#include <vector>
+
+#include "platform/CCPlatformMacros.h"
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup _3d
+ * @{
+ */
+
+struct MeshData;
+
+/**
+ * Builds simplified versions of triangle meshes for levels of detail.
+ *
+ * Edges are collapsed in order of quadric error (the sum of the squared distances to the planes of the
+ * original triangles around the vertices). A vertex is always collapsed onto one of its neighbors, so the
+ * simplified meshes only need new indices and share the vertex buffer of the original. Vertices on the
+ * borders of the mesh are never removed. The two vertices of a position on an attribute seam (e.g. with
+ * different texture coordinates on each side) collapse together along the seam, so the simplification
+ * doesn't open holes nor tear textures. The corners of the seams and the positions with more than two
+ * vertices are kept.
+ * @since v3.18
+ * @js NA
+ * @lua NA
+ */
+class CC_DLL MeshSimplifier
+{
+public:
+    /**
+     * Simplifies a triangle list.
+     *
+     * @param positions Position of the first vertex, 3 floats which don't need to be aligned.
+     * @param stride Number of bytes between the positions of two vertices.
+     * @param vertexCount Number of vertices.
+     * @param indices Triangle list.
+     * @param indexCount Number of indices.
+     * @param targetIndexCount The simplification stops when there are no more indices than this.
+     * @param maxError Maximum error of a collapse, relative to the size of the mesh.
+     * @param resultError If not null, receives the largest error of the collapses, relative to the size of the mesh.
+     * @return The simplified triangle list, it may have more indices than targetIndexCount if the error bound is reached first.
+     */
+    static std::vector<unsigned short> simplify(const void* positions, size_t stride, size_t vertexCount,
+                                                const unsigned short* indices, size_t indexCount,
+                                                size_t targetIndexCount, float maxError, float* resultError = nullptr);
+
+    /**
+     * Generates the levels of detail of every sub mesh of a mesh data, see MeshData::subMeshLODs.
+     *
+     * Each level has about half the triangles of the previous one. The generation stops at `levels` levels,
+     * when the error bound is reached or when a level doesn't remove enough triangles to be worth it.
+     */
+    static void generateLODs(MeshData* meshdata, int levels, float maxError);
+};
+
+// end of 3d group
+/// @}
+
+NS_CC_END
+
+#endif // __CC_MESH_SIMPLIFIER_H__
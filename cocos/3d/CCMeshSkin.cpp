@@ -35,6 +35,7 @@ MeshSkin::MeshSkin()
 : _rootBone(nullptr)
 , _skeleton(nullptr)
 , _matrixPalette(nullptr)
+, _paletteVersion(0)
 {
     
 }
@@ -104,9 +105,15 @@ Vec4* MeshSkin::getMatrixPalette()
     if (_matrixPalette == nullptr)
     {
         _matrixPalette = new (std::nothrow) Vec4[_skinBones.size() * PALETTE_ROWS];
+        _paletteVersion = 0;
     }
+    // the palette is read by every draw of the meshes, but only changes with the pose
+    if (_skeleton && _paletteVersion != 0 && _paletteVersion == _skeleton->getPoseVersion())
+        return _matrixPalette;
+    
     int i = 0, paletteIndex = 0;
-    static Mat4 t;
+    // may run on several threads at once, for different skins
+    Mat4 t;
     for (auto it : _skinBones )
     {
         Mat4::multiply(it->getWorldMat(), _invBindPoses[i++], &t);
@@ -114,6 +121,7 @@ Vec4* MeshSkin::getMatrixPalette()
         _matrixPalette[paletteIndex++].set(t.m[1], t.m[5], t.m[9], t.m[13]);
         _matrixPalette[paletteIndex++].set(t.m[2], t.m[6], t.m[10], t.m[14]);
     }
+    _paletteVersion = _skeleton ? _skeleton->getPoseVersion() : 0;
     
     return _matrixPalette;
 }
@@ -127,12 +135,15 @@ void MeshSkin::removeAllBones()
 {
     _skinBones.clear();
     CC_SAFE_DELETE_ARRAY(_matrixPalette);
+    _paletteVersion = 0;
     CC_SAFE_RELEASE(_rootBone);
 }
 
 void MeshSkin::addSkinBone(Bone3D* bone)
 {
     _skinBones.pushBack(bone);
+    CC_SAFE_DELETE_ARRAY(_matrixPalette);
+    _paletteVersion = 0;
 }
 
 Bone3D* MeshSkin::getRootBone() const
@@ -68,7 +68,7 @@ public:
     /**get bone index*/
     int getBoneIndex(Bone3D* bone) const;
     
-    /**compute matrix palette used by gpu skin*/
+    /**compute matrix palette used by gpu skin, only when the pose of the skeleton changed*/
     Vec4* getMatrixPalette();
     
     /**getSkinBoneCount() * 3*/
@@ -105,6 +105,8 @@ protected:
     // Each 4x3 row-wise matrix is represented as 3 Vec4's.
     // The number of Vec4's is (_skinBones.size() * 3).
     Vec4* _matrixPalette;
+    // Skeleton3D::getPoseVersion() when the palette was computed, 0 if it must be computed
+    unsigned int _paletteVersion;
 };
 
 // end of 3d group
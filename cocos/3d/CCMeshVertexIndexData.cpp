@@ -68,6 +68,18 @@ const VertexBuffer* MeshIndexData::getVertexBuffer() const
     return _vertexData->getVertexBuffer();
 }
 
+int MeshIndexData::getIndexCount(int lod) const
+{
+    if (lod > 0)
+        return _lods[lod - 1].indexCount;
+    return _lods.empty() ? (int)_indexBuffer->getIndexNumber() : _lods.front().indexStart;
+}
+
+void MeshIndexData::addLOD(int indexStart, int indexCount, float error)
+{
+    _lods.push_back({ indexStart, indexCount, error });
+}
+
 MeshIndexData::MeshIndexData()
 : _indexBuffer(nullptr)
 , _vertexData(nullptr)
@@ -80,44 +92,74 @@ MeshIndexData::~MeshIndexData()
     CC_SAFE_RELEASE(_indexBuffer);
 }
 
-MeshVertexData* MeshVertexData::create(const MeshData& meshdata)
+MeshVertexData* MeshVertexData::create(const MeshData& meshdata, bool fillBuffers)
 {
     auto vertexdata = new (std::nothrow) MeshVertexData();
     int pervertexsize = meshdata.getPerVertexSize();
-    vertexdata->_vertexBuffer = VertexBuffer::create(pervertexsize, (int)(meshdata.vertex.size() / (pervertexsize / 4)));
+    vertexdata->_vertexBuffer = VertexBuffer::create(pervertexsize, (int)(meshdata.getVertexSizeInFloat() / (pervertexsize / 4)));
     vertexdata->_vertexData = VertexData::create();
     CC_SAFE_RETAIN(vertexdata->_vertexData);
     CC_SAFE_RETAIN(vertexdata->_vertexBuffer);
     
     int offset = 0;
     for (const auto& it : meshdata.attribs) {
-        vertexdata->_vertexData->setStream(vertexdata->_vertexBuffer, VertexStreamAttribute(offset, it.vertexAttrib, it.type, it.size));
+        vertexdata->_vertexData->setStream(vertexdata->_vertexBuffer, VertexStreamAttribute(offset, it.vertexAttrib, it.type, it.size, it.type != GL_FLOAT));
         offset += it.attribSizeBytes;
     }
     
     vertexdata->_attribs = meshdata.attribs;
     
-    if(vertexdata->_vertexBuffer)
+    if(vertexdata->_vertexBuffer && fillBuffers)
     {
-        vertexdata->_vertexBuffer->updateVertices((void*)&meshdata.vertex[0], (int)meshdata.vertex.size() * 4 / vertexdata->_vertexBuffer->getSizePerVertex(), 0);
+        vertexdata->_vertexBuffer->updateVertices(meshdata.getVertexData(), meshdata.getVertexSizeInFloat() * 4 / vertexdata->_vertexBuffer->getSizePerVertex(), 0);
     }
     
-    bool needCalcAABB = (meshdata.subMeshAABB.size() != meshdata.subMeshIndices.size());
-    for (size_t i = 0, size = meshdata.subMeshIndices.size(); i < size; ++i) {
-
-        auto& index = meshdata.subMeshIndices[i];
-        auto indexBuffer = IndexBuffer::create(IndexBuffer::IndexType::INDEX_TYPE_SHORT_16, (int)(index.size()));
-        indexBuffer->updateIndices(&index[0], (int)index.size(), 0);
+    // the AABBs are always loaded with the buffer views
+    bool needCalcAABB = (meshdata.subMeshAABB.size() != meshdata.getSubMeshCount());
+    for (size_t i = 0, size = meshdata.getSubMeshCount(); i < size; ++i) {
+
+        // the levels of detail follow the full resolution indices in the same buffer
+        int indexCount = (int)meshdata.getIndexCount(i);
+        int lodIndexCount = 0;
+        const auto* lods = i < meshdata.subMeshLODs.size() ? &meshdata.subMeshLODs[i] : nullptr;
+        if (lods)
+        {
+            for (const auto& lod : *lods)
+                lodIndexCount += (int)lod.indices.size();
+        }
+        auto indexBuffer = IndexBuffer::create(IndexBuffer::IndexType::INDEX_TYPE_SHORT_16, indexCount + lodIndexCount);
+        if (fillBuffers)
+        {
+            indexBuffer->updateIndices(meshdata.getIndexData(i), indexCount, 0);
+            if (lods)
+            {
+                int start = indexCount;
+                for (const auto& lod : *lods)
+                {
+                    indexBuffer->updateIndices(lod.indices.data(), (int)lod.indices.size(), start);
+                    start += (int)lod.indices.size();
+                }
+            }
+        }
         std::string id = (i < meshdata.subMeshIds.size() ? meshdata.subMeshIds[i] : "");
         MeshIndexData* indexdata = nullptr;
         if (needCalcAABB)
         {
-            auto aabb = Bundle3D::calculateAABB(meshdata.vertex, meshdata.getPerVertexSize(), index);
+            auto aabb = Bundle3D::calculateAABB(meshdata.vertex, meshdata.getPerVertexSize(), meshdata.subMeshIndices[i]);
             indexdata = MeshIndexData::create(id, vertexdata, indexBuffer, aabb);
         }
         else
             indexdata = MeshIndexData::create(id, vertexdata, indexBuffer, meshdata.subMeshAABB[i]);
         
+        if (lods)
+        {
+            int start = indexCount;
+            for (const auto& lod : *lods)
+            {
+                indexdata->addLOD(start, (int)lod.indices.size(), lod.error);
+                start += (int)lod.indices.size();
+            }
+        }
         vertexdata->_indexs.pushBack(indexdata);
     }
     
@@ -81,6 +81,21 @@ public:
     GLenum getPrimitiveType() const { return _primitiveType; }
     void   setPrimitiveType(GLenum primitive) { _primitiveType = primitive; }
     
+    /**
+     * Levels of detail (since v3.18). Level 0 is the full resolution triangle list at the start of the
+     * index buffer, the simplified ones follow it in the same buffer so they can be drawn with the same
+     * vertex attribute bindings.
+     */
+    int getLODCount() const { return (int)_lods.size() + 1; }
+    /** first index of a level of detail in the index buffer */
+    int getIndexStart(int lod) const { return lod > 0 ? _lods[lod - 1].indexStart : 0; }
+    /** index count of a level of detail */
+    int getIndexCount(int lod) const;
+    /** error of a level of detail, relative to the size of the mesh */
+    float getLODError(int lod) const { return lod > 0 ? _lods[lod - 1].error : 0.0f; }
+    /** adds a level of detail, coarser than the previous ones */
+    void addLOD(int indexStart, int indexCount, float error);
+    
 CC_CONSTRUCTOR_ACCESS:
     MeshIndexData();
     virtual ~MeshIndexData();
@@ -92,6 +107,14 @@ protected:
     std::string    _id; //id
     GLenum         _primitiveType;
     
+    struct LOD
+    {
+        int indexStart;
+        int indexCount;
+        float error;
+    };
+    std::vector<LOD> _lods; // levels of detail after the first one
+    
     friend class MeshVertexData;
     friend class Sprite3D;
 };
@@ -105,8 +128,12 @@ class CC_DLL MeshVertexData : public Ref
     friend class Sprite3D;
     friend class Mesh;
 public:
-    /**create*/
-    static MeshVertexData* create(const MeshData& meshdata);
+    /**
+     * create
+     * @param fillBuffers whether the vertex and index buffers are filled from meshdata, or left empty
+     * to be filled later, e.g. over several frames (since v3.18)
+     */
+    static MeshVertexData* create(const MeshData& meshdata, bool fillBuffers = true);
     
     /** get vertexbuffer */
     const VertexBuffer* getVertexBuffer() const { return _vertexBuffer; }
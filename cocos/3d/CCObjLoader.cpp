@@ -27,14 +27,18 @@
 #include <cassert>
 #include <cmath>
 #include <cstddef>
+#include <climits>
 
+#include <algorithm>
 #include <string>
+#include <thread>
 #include <vector>
 #include <map>
 #include <fstream>
 #include <sstream>
 #include "platform/CCFileUtils.h"
 #include "base/ccUtils.h"
+#include "base/CCAsyncTaskPool.h"
 
 #include "3d/CCObjLoader.h"
 
@@ -651,6 +655,493 @@ namespace tinyobj {
         return err;
     }
     
+    // The buffer parser: the lines are tokenized by chunks in parallel, then the chunks are walked in order to
+    // split the shapes, load the materials and index the vertices, like the std::istream parser does line by line.
+    
+    // the chunks parsed by a job are at least this big
+    static const size_t OBJ_CHUNK_SIZE = 256 * 1024;
+    
+    static const double POWERS_OF_10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    
+    // statement which ends the current face group, kept in order with the faces of its chunk
+    struct obj_statement {
+        enum Type { USEMTL, MTLLIB, GROUP, OBJECT };
+        Type type;
+        size_t faceCount;  // faces of the chunk before it
+        size_t indexCount; // vertex indices of the chunk before it
+        std::string name;
+    };
+    
+    struct obj_chunk {
+        const char *begin;
+        const char *end;
+        std::vector<float> v;
+        std::vector<float> vn;
+        std::vector<float> vt;
+        std::vector<vertex_index> indices;
+        std::vector<unsigned int> faceSizes;
+        // indices relative to the end of the arrays, resolved against the counts of the chunk only
+        std::vector<size_t> relativeV;
+        std::vector<size_t> relativeVn;
+        std::vector<size_t> relativeVt;
+        std::vector<obj_statement> statements;
+    };
+    
+    // faces of a chunk which belong to a face group
+    struct obj_face_range {
+        const obj_chunk *chunk;
+        size_t faceBegin;
+        size_t faceEnd;
+        size_t indexBegin;
+    };
+    
+    static inline bool isDigit(const char c) { return c >= '0' && c <= '9'; }
+    
+    static inline const char *skipSpaces(const char *p, const char *end) {
+        while (p < end && isSpace(*p))
+            ++p;
+        return p;
+    }
+    
+    static inline const char *skipToken(const char *p, const char *end) {
+        while (p < end && !isSpace(*p))
+            ++p;
+        return p;
+    }
+    
+    static inline bool isKeyword(const char *p, const char *end, const char *keyword, size_t length) {
+        return static_cast<size_t>(end - p) > length && memcmp(p, keyword, length) == 0 && isSpace(p[length]);
+    }
+    
+    static inline std::string parseName(const char *p, const char *end) {
+        p = skipSpaces(p, end);
+        return std::string(p, skipToken(p, end));
+    }
+    
+    // Same grammar as tryParseDouble(), and a leading '.', the first 19 significant digits are kept.
+    // An invalid number is 0, the rest of the token is skipped.
+    static inline float parseFloatFast(const char *&p, const char *end) {
+        p = skipSpaces(p, end);
+        bool negative = false;
+        if (p < end && (*p == '+' || *p == '-')) {
+            negative = *p == '-';
+            ++p;
+        }
+        
+        unsigned long long mantissa = 0;
+        int exponent = 0;
+        int digits = 0;
+        bool valid = false;
+        for (; p < end && isDigit(*p); ++p) {
+            valid = true;
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                if (mantissa)
+                    ++digits;
+            } else {
+                ++exponent;
+            }
+        }
+        if (p < end && *p == '.') {
+            for (++p; p < end && isDigit(*p); ++p) {
+                valid = true;
+                if (digits < 19) {
+                    mantissa = mantissa * 10 + (*p - '0');
+                    if (mantissa)
+                        ++digits;
+                    --exponent;
+                }
+            }
+        }
+        if (valid && p < end && (*p == 'e' || *p == 'E')) {
+            ++p;
+            bool negativeExponent = false;
+            if (p < end && (*p == '+' || *p == '-')) {
+                negativeExponent = *p == '-';
+                ++p;
+            }
+            int value = 0;
+            valid = p < end && isDigit(*p);
+            for (; p < end && isDigit(*p); ++p) {
+                if (value < 10000)
+                    value = value * 10 + (*p - '0');
+            }
+            exponent += negativeExponent ? -value : value;
+        }
+        p = skipToken(p, end);
+        if (!valid)
+            return 0.0f;
+        
+        double result = static_cast<double>(mantissa);
+        if (exponent < 0 && exponent >= -22)
+            result /= POWERS_OF_10[-exponent];
+        else if (exponent > 0 && exponent <= 22)
+            result *= POWERS_OF_10[exponent];
+        else if (exponent != 0)
+            result *= pow(10.0, exponent);
+        return static_cast<float>(negative ? -result : result);
+    }
+    
+    // like atoi()
+    static inline int parseIntFast(const char *&p, const char *end) {
+        bool negative = false;
+        if (p < end && (*p == '+' || *p == '-')) {
+            negative = *p == '-';
+            ++p;
+        }
+        // saturated far from INT_MIN, which no index resolves to, see ABSENT_INDEX
+        int value = 0;
+        for (; p < end && isDigit(*p); ++p) {
+            if (value < 100000000)
+                value = value * 10 + (*p - '0');
+        }
+        return negative ? -value : value;
+    }
+    
+    static inline const char *skipIndex(const char *p, const char *end) {
+        while (p < end && *p != '/' && !isSpace(*p))
+            ++p;
+        return p;
+    }
+    
+    // Texture coordinates or normal missing from a face vertex. A resolved relative index may be -1, e.g. "f 1//-5"
+    // with 4 normals, which is out of range and not a missing normal.
+    static const int ABSENT_INDEX = INT_MIN;
+    
+    // Makes an index zero-based, the relative ones are resolved against the count of the chunk and recorded.
+    static inline int fixChunkIndex(int idx, int n, std::vector<size_t> &relative, size_t position) {
+        if (idx > 0) return idx - 1;
+        if (idx == 0) return 0;
+        relative.push_back(position);
+        return n + idx;
+    }
+    
+    static void parseFace(obj_chunk &chunk, const char *p, const char *end) {
+        const int vCount = static_cast<int>(chunk.v.size() / 3);
+        const int vnCount = static_cast<int>(chunk.vn.size() / 3);
+        const int vtCount = static_cast<int>(chunk.vt.size() / 2);
+        unsigned int faceSize = 0;
+        p = skipSpaces(p, end);
+        while (p < end) {
+            // i, i/j/k, i//k, i/j
+            const size_t position = chunk.indices.size();
+            vertex_index vi(0, ABSENT_INDEX, ABSENT_INDEX);
+            vi.v_idx = fixChunkIndex(parseIntFast(p, end), vCount, chunk.relativeV, position);
+            p = skipIndex(p, end);
+            if (p < end && *p == '/') {
+                ++p;
+                if (p < end && *p == '/') {
+                    ++p;
+                    vi.vn_idx = fixChunkIndex(parseIntFast(p, end), vnCount, chunk.relativeVn, position);
+                    p = skipIndex(p, end);
+                } else {
+                    vi.vt_idx = fixChunkIndex(parseIntFast(p, end), vtCount, chunk.relativeVt, position);
+                    p = skipIndex(p, end);
+                    if (p < end && *p == '/') {
+                        ++p;
+                        vi.vn_idx = fixChunkIndex(parseIntFast(p, end), vnCount, chunk.relativeVn, position);
+                        p = skipIndex(p, end);
+                    }
+                }
+            }
+            chunk.indices.push_back(vi);
+            ++faceSize;
+            p = skipSpaces(p, end);
+        }
+        chunk.faceSizes.push_back(faceSize);
+    }
+    
+    static void addStatement(obj_chunk &chunk, obj_statement::Type type, std::string name) {
+        obj_statement statement;
+        statement.type = type;
+        statement.faceCount = chunk.faceSizes.size();
+        statement.indexCount = chunk.indices.size();
+        statement.name = std::move(name);
+        chunk.statements.push_back(std::move(statement));
+    }
+    
+    static void parseChunk(obj_chunk &chunk) {
+        const char *p = chunk.begin;
+        while (p < chunk.end) {
+            const char *lineEnd = static_cast<const char *>(memchr(p, '\n', chunk.end - p));
+            const char *next = lineEnd ? lineEnd + 1 : chunk.end;
+            if (!lineEnd)
+                lineEnd = chunk.end;
+            while (lineEnd > p && (lineEnd[-1] == '\r' || lineEnd[-1] == '\0'))
+                --lineEnd;
+            
+            const char *token = skipSpaces(p, lineEnd);
+            p = next;
+            if (token == lineEnd || token[0] == '#')
+                continue;
+            
+            if (isKeyword(token, lineEnd, "v", 1)) {
+                token += 2;
+                for (int i = 0; i < 3; ++i)
+                    chunk.v.push_back(parseFloatFast(token, lineEnd));
+            } else if (isKeyword(token, lineEnd, "vn", 2)) {
+                token += 3;
+                for (int i = 0; i < 3; ++i)
+                    chunk.vn.push_back(parseFloatFast(token, lineEnd));
+            } else if (isKeyword(token, lineEnd, "vt", 2)) {
+                token += 3;
+                for (int i = 0; i < 2; ++i)
+                    chunk.vt.push_back(parseFloatFast(token, lineEnd));
+            } else if (isKeyword(token, lineEnd, "f", 1)) {
+                parseFace(chunk, token + 2, lineEnd);
+            } else if (isKeyword(token, lineEnd, "usemtl", 6)) {
+                addStatement(chunk, obj_statement::USEMTL, parseName(token + 7, lineEnd));
+            } else if (isKeyword(token, lineEnd, "mtllib", 6)) {
+                addStatement(chunk, obj_statement::MTLLIB, parseName(token + 7, lineEnd));
+            } else if (isKeyword(token, lineEnd, "g", 1)) {
+                addStatement(chunk, obj_statement::GROUP, parseName(token + 2, lineEnd));
+            } else if (isKeyword(token, lineEnd, "o", 1)) {
+                addStatement(chunk, obj_statement::OBJECT, parseName(token + 2, lineEnd));
+            }
+            // Ignore unknown command.
+        }
+    }
+    
+    static void resolveRelativeIndices(obj_chunk &chunk, int vOffset, int vnOffset, int vtOffset) {
+        for (auto position : chunk.relativeV)
+            chunk.indices[position].v_idx += vOffset;
+        for (auto position : chunk.relativeVn)
+            chunk.indices[position].vn_idx += vnOffset;
+        for (auto position : chunk.relativeVt)
+            chunk.indices[position].vt_idx += vtOffset;
+    }
+    
+    // Open addressing hash table of the vertices of a shape, replaces the std::map of the std::istream parser.
+    class VertexIndexTable {
+    public:
+        void reset(size_t maxVertexCount) {
+            size_t capacity = 16;
+            while (capacity < maxVertexCount * 2)
+                capacity *= 2;
+            _slots.assign(capacity, -1);
+            _keys.clear();
+        }
+        
+        // the index of the vertex in the shape, and whether it was added
+        unsigned int insert(const vertex_index &key, bool &added) {
+            const size_t mask = _slots.size() - 1;
+            size_t slot = (static_cast<unsigned int>(key.v_idx) * 73856093u
+                           ^ static_cast<unsigned int>(key.vt_idx) * 19349663u
+                           ^ static_cast<unsigned int>(key.vn_idx) * 83492791u) & mask;
+            while (_slots[slot] >= 0) {
+                const vertex_index &other = _keys[_slots[slot]];
+                if (other.v_idx == key.v_idx && other.vt_idx == key.vt_idx && other.vn_idx == key.vn_idx) {
+                    added = false;
+                    return static_cast<unsigned int>(_slots[slot]);
+                }
+                slot = (slot + 1) & mask;
+            }
+            _slots[slot] = static_cast<int>(_keys.size());
+            _keys.push_back(key);
+            added = true;
+            return static_cast<unsigned int>(_slots[slot]);
+        }
+        
+    private:
+        std::vector<int> _slots;
+        std::vector<vertex_index> _keys;
+    };
+    
+    static bool exportFaceRangesToShape(shape_t &shape, VertexIndexTable &vertexTable,
+                                        const std::vector<float> &in_positions,
+                                        const std::vector<float> &in_normals,
+                                        const std::vector<float> &in_texcoords,
+                                        const std::vector<obj_face_range> &faceGroup,
+                                        const int material_id, const std::string &name,
+                                        std::string &err) {
+        if (faceGroup.empty())
+            return false;
+        
+        size_t cornerCount = 0;
+        size_t triangleCount = 0;
+        for (const auto &range : faceGroup) {
+            for (size_t i = range.faceBegin; i < range.faceEnd; ++i) {
+                cornerCount += range.chunk->faceSizes[i];
+                triangleCount += range.chunk->faceSizes[i] > 2 ? range.chunk->faceSizes[i] - 2 : 0;
+            }
+        }
+        
+        const int vCount = static_cast<int>(in_positions.size() / 3);
+        const int vnCount = static_cast<int>(in_normals.size() / 3);
+        const int vtCount = static_cast<int>(in_texcoords.size() / 2);
+        vertexTable.reset(cornerCount);
+        shape.mesh.indices.reserve(triangleCount * 3);
+        shape.mesh.material_ids.reserve(triangleCount);
+        
+        auto isInRange = [](int idx, int count) {
+            return idx >= 0 && idx < count;
+        };
+        auto addVertex = [&](const vertex_index &vi) -> unsigned int {
+            bool added;
+            unsigned int idx = vertexTable.insert(vi, added);
+            if (added) {
+                shape.mesh.positions.insert(shape.mesh.positions.end(), &in_positions[3 * vi.v_idx], &in_positions[3 * vi.v_idx] + 3);
+                if (vi.vn_idx != ABSENT_INDEX)
+                    shape.mesh.normals.insert(shape.mesh.normals.end(), &in_normals[3 * vi.vn_idx], &in_normals[3 * vi.vn_idx] + 3);
+                if (vi.vt_idx != ABSENT_INDEX)
+                    shape.mesh.texcoords.insert(shape.mesh.texcoords.end(), &in_texcoords[2 * vi.vt_idx], &in_texcoords[2 * vi.vt_idx] + 2);
+            }
+            return idx;
+        };
+        
+        for (const auto &range : faceGroup) {
+            const vertex_index *face = &range.chunk->indices[range.indexBegin];
+            for (size_t i = range.faceBegin; i < range.faceEnd; ++i) {
+                const unsigned int npolys = range.chunk->faceSizes[i];
+                for (unsigned int k = 0; k < npolys; ++k) {
+                    const vertex_index &vi = face[k];
+                    if (!isInRange(vi.v_idx, vCount)
+                        || (vi.vn_idx != ABSENT_INDEX && !isInRange(vi.vn_idx, vnCount))
+                        || (vi.vt_idx != ABSENT_INDEX && !isInRange(vi.vt_idx, vtCount))) {
+                        err = "Face index out of range.";
+                        return false;
+                    }
+                }
+                
+                // Polygon -> triangle fan conversion
+                for (unsigned int k = 2; k < npolys; k++) {
+                    unsigned int v0 = addVertex(face[0]);
+                    unsigned int v1 = addVertex(face[k - 1]);
+                    unsigned int v2 = addVertex(face[k]);
+                    
+                    shape.mesh.indices.push_back(v0);
+                    shape.mesh.indices.push_back(v1);
+                    shape.mesh.indices.push_back(v2);
+                    
+                    shape.mesh.material_ids.push_back(material_id);
+                }
+                face += npolys;
+            }
+        }
+        
+        shape.name = name;
+        return true;
+    }
+    
+    std::string LoadObj(std::vector<shape_t> &shapes,
+                        std::vector<material_t> &materials, // [output]
+                        const char *buffer, size_t size, MaterialReader &readMatFn) {
+        shapes.clear();
+        
+        // The chunks are parsed by this thread and by the workers.
+        std::vector<obj_chunk> chunks;
+        const size_t maxChunkCount = std::max(1u, std::thread::hardware_concurrency()) * 4;
+        const size_t chunkCount = std::min(size / OBJ_CHUNK_SIZE + 1, maxChunkCount);
+        const char *end = buffer + size;
+        const char *begin = buffer;
+        for (size_t i = 1; i <= chunkCount && begin < end; ++i) {
+            const char *chunkEnd = i == chunkCount ? end : buffer + size / chunkCount * i;
+            if (chunkEnd <= begin)
+                continue;
+            // the chunks end with their last line
+            const char *newLine = static_cast<const char *>(memchr(chunkEnd - 1, '\n', end - chunkEnd + 1));
+            chunkEnd = newLine ? newLine + 1 : end;
+            
+            obj_chunk chunk;
+            chunk.begin = begin;
+            chunk.end = chunkEnd;
+            chunks.push_back(std::move(chunk));
+            begin = chunkEnd;
+        }
+        
+        cocos2d::AsyncTaskPool::getInstance()->parallelFor(chunks.size(), 1, [&chunks](size_t beginChunk, size_t endChunk) {
+            for (size_t i = beginChunk; i < endChunk; ++i) {
+                parseChunk(chunks[i]);
+            }
+        });
+        
+        size_t vSize = 0, vnSize = 0, vtSize = 0;
+        for (const auto &chunk : chunks) {
+            vSize += chunk.v.size();
+            vnSize += chunk.vn.size();
+            vtSize += chunk.vt.size();
+        }
+        std::vector<float> v;
+        std::vector<float> vn;
+        std::vector<float> vt;
+        v.reserve(vSize);
+        vn.reserve(vnSize);
+        vt.reserve(vtSize);
+        for (auto &chunk : chunks) {
+            resolveRelativeIndices(chunk, static_cast<int>(v.size() / 3), static_cast<int>(vn.size() / 3),
+                                   static_cast<int>(vt.size() / 2));
+            v.insert(v.end(), chunk.v.begin(), chunk.v.end());
+            vn.insert(vn.end(), chunk.vn.begin(), chunk.vn.end());
+            vt.insert(vt.end(), chunk.vt.begin(), chunk.vt.end());
+            std::vector<float>().swap(chunk.v);
+            std::vector<float>().swap(chunk.vn);
+            std::vector<float>().swap(chunk.vt);
+        }
+        
+        // material
+        std::map<std::string, int> material_map;
+        int material = -1;
+        std::string name;
+        std::vector<obj_face_range> faceGroup;
+        VertexIndexTable vertexTable;
+        std::string err;
+        
+        auto exportFaceGroup = [&]() -> bool {
+            shape_t shape;
+            if (exportFaceRangesToShape(shape, vertexTable, v, vn, vt, faceGroup, material, name, err)) {
+                shapes.push_back(std::move(shape));
+            }
+            faceGroup.clear();
+            return err.empty();
+        };
+        
+        for (const auto &chunk : chunks) {
+            obj_face_range range;
+            range.chunk = &chunk;
+            range.faceBegin = 0;
+            range.indexBegin = 0;
+            for (const auto &statement : chunk.statements) {
+                range.faceEnd = statement.faceCount;
+                if (range.faceEnd > range.faceBegin)
+                    faceGroup.push_back(range);
+                range.faceBegin = statement.faceCount;
+                range.indexBegin = statement.indexCount;
+                
+                switch (statement.type) {
+                    case obj_statement::USEMTL: {
+                        // Create face group per material.
+                        if (!exportFaceGroup())
+                            return err;
+                        auto it = material_map.find(statement.name);
+                        material = it != material_map.end() ? it->second : -1;
+                        break;
+                    }
+                    case obj_statement::MTLLIB: {
+                        std::string err_mtl = readMatFn(statement.name, materials, material_map);
+                        if (!err_mtl.empty())
+                            return err_mtl;
+                        break;
+                    }
+                    case obj_statement::GROUP:
+                    case obj_statement::OBJECT:
+                        if (!exportFaceGroup())
+                            return err;
+                        name = statement.name;
+                        break;
+                }
+            }
+            range.faceEnd = chunk.faceSizes.size();
+            if (range.faceEnd > range.faceBegin)
+                faceGroup.push_back(range);
+        }
+        exportFaceGroup();
+        
+        return err;
+    }
+    
     std::string LoadObj(std::vector<shape_t> &shapes,
                         std::vector<material_t> &materials, // [output]
                         const char *filename, const char *mtl_basepath) {
@@ -659,8 +1150,9 @@ namespace tinyobj {
         
         std::stringstream err;
         
-        std::istringstream ifs(cocos2d::FileUtils::getInstance()->getStringFromFile(filename));
-        if (!ifs) {
+        // mapped when possible, nothing is copied
+        cocos2d::Data data = cocos2d::FileUtils::getInstance()->getMappedDataFromFile(filename);
+        if (data.isNull()) {
             err << "Cannot open file [" << filename << "]" << std::endl;
             return err.str();
         }
@@ -671,7 +1163,8 @@ namespace tinyobj {
         }
         MaterialFileReader matFileReader(basePath);
         
-        return LoadObj(shapes, materials, ifs, matFileReader);
+        return LoadObj(shapes, materials, reinterpret_cast<const char *>(data.getBytes()),
+                       static_cast<size_t>(data.getSize()), matFileReader);
     }
     
     std::string LoadObj(std::vector<shape_t> &shapes,
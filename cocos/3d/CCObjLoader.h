@@ -97,6 +97,15 @@ namespace tinyobj {
                         std::vector<material_t> &materials, // [output]
                         const char *filename, const char *mtl_basepath = NULL);
     
+    /// Loads .obj from a buffer in memory, which doesn't need to be null terminated.
+    /// The lines are parsed in parallel by chunks on the AsyncTaskPool, the shapes are
+    /// the same as the ones of the std::istream version, which parses line by line.
+    /// The file version maps the file and uses this one.
+    /// Returns empty string when loading .obj success.
+    std::string LoadObj(std::vector<shape_t> &shapes,       // [output]
+                        std::vector<material_t> &materials, // [output]
+                        const char *buffer, size_t size, MaterialReader &readMatFn);
+    
     /// Loads object from a std::istream, uses GetMtlIStreamFn to retrieve
     /// std::istream for materials.
     /// Returns empty string when loading .obj success.
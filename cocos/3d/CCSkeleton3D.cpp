@@ -25,6 +25,8 @@
 
 #include "3d/CCSkeleton3D.h"
 
+#include <algorithm>
+#include <unordered_map>
 
 NS_CC_BEGIN
 
@@ -51,6 +53,7 @@ void Bone3D::setOriPose(const Mat4& m)
 void Bone3D::resetPose()
 {
     _local =_oriPose;
+    _localDirty = true;
     
     for (auto it : _children) {
         it->resetPose();
@@ -142,7 +145,8 @@ Bone3D* Bone3D::create(const std::string& id)
 void Bone3D::updateJointMatrix(Vec4* matrixPalette)
 {
     {
-        static Mat4 t;
+        // may run on several threads at once, for different skeletons
+        Mat4 t;
         Mat4::multiply(_world, getInverseBindPose(), &t);
 
         matrixPalette[0].set(t.m[0], t.m[4], t.m[8], t.m[12]);
@@ -185,6 +189,7 @@ Bone3D::Bone3D(const std::string& id)
 : _name(id)
 , _parent(nullptr)
 , _worldDirty(true)
+, _localDirty(true)
 {
     
 }
@@ -247,6 +252,9 @@ void Bone3D::updateLocalMat()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 Skeleton3D::Skeleton3D()
+: _bonesSorted(false)
+, _poseValid(false)
+, _poseVersion(1)
 {
     
 }
@@ -315,21 +323,87 @@ int Skeleton3D::getBoneIndex(Bone3D* bone) const
 //refresh bone world matrix
 void Skeleton3D::updateBoneMatrix()
 {
-    for (const auto& it : _rootBones) {
-        it->setWorldMatDirty(true);
-        it->updateWorldMat();
+    if (!_bonesSorted)
+        sortBones();
+    
+    // parents come first, so one pass updates the hierarchy. Only the bones that were animated,
+    // reset, or whose parent moved are recomputed, a second call in the same frame costs nothing.
+    bool changed = false;
+    for (size_t i = 0, count = _sortedBones.size(); i < count; ++i)
+    {
+        auto bone = _sortedBones[i];
+        int parent = _boneParents[i];
+        bool externalParent = parent < 0 && bone->_parent;
+        bool dirty = !_poseValid || externalParent || bone->_localDirty || !bone->_blendStates.empty()
+            || (parent >= 0 && _boneChanged[parent]);
+        _boneChanged[i] = dirty;
+        if (!dirty)
+            continue;
+        
+        bone->updateLocalMat();
+        if (parent >= 0)
+            Mat4::multiply(_sortedBones[parent]->_world, bone->_local, &bone->_world);
+        else if (externalParent)
+            Mat4::multiply(bone->_parent->getWorldMat(), bone->_local, &bone->_world);
+        else
+            bone->_world = bone->_local;
+        bone->_localDirty = false;
+        bone->_worldDirty = false;
+        changed = true;
+    }
+    
+    _poseValid = true;
+    if (changed)
+        ++_poseVersion;
+}
+
+void Skeleton3D::sortBones()
+{
+    _sortedBones.clear();
+    _boneParents.clear();
+    
+    // stable sort by depth, parents are less deep than their children
+    std::vector<std::pair<int, Bone3D*>> depths;
+    depths.reserve(_bones.size());
+    for (const auto& bone : _bones) {
+        int depth = 0;
+        for (auto parent = bone->_parent; parent; parent = parent->_parent)
+            ++depth;
+        depths.push_back(std::make_pair(depth, bone));
     }
+    std::stable_sort(depths.begin(), depths.end(), [](const std::pair<int, Bone3D*>& a, const std::pair<int, Bone3D*>& b) {
+        return a.first < b.first;
+    });
+    
+    std::unordered_map<Bone3D*, int> indices;
+    for (const auto& it : depths) {
+        indices[it.second] = static_cast<int>(_sortedBones.size());
+        _sortedBones.push_back(it.second);
+    }
+    for (const auto& bone : _sortedBones) {
+        auto parent = bone->_parent ? indices.find(bone->_parent) : indices.end();
+        _boneParents.push_back(parent != indices.end() ? parent->second : -1);
+    }
+    _boneChanged.assign(_sortedBones.size(), 0);
+    
+    _bonesSorted = true;
+    _poseValid = false;
 }
 
 void Skeleton3D::removeAllBones()
 {
     _bones.clear();
     _rootBones.clear();
+    _sortedBones.clear();
+    _boneParents.clear();
+    _boneChanged.clear();
+    _bonesSorted = false;
 }
 
 void Skeleton3D::addBone(Bone3D* bone)
 {
     _bones.pushBack(bone);
+    _bonesSorted = false;
 }
 
 Bone3D* Skeleton3D::createBone3D(const NodeData& nodedata)
@@ -341,6 +415,7 @@ Bone3D* Skeleton3D::createBone3D(const NodeData& nodedata)
         child->_parent = bone;
     }
     _bones.pushBack(bone);
+    _bonesSorted = false;
     bone->_oriPose = nodedata.transform;
     return bone;
 }
@@ -181,6 +181,7 @@ protected:
     
     std::vector<BoneBlendState> _blendStates;
     
+    bool          _localDirty; // local matrix changed outside of the blend states, see resetPose
 };
 
 /**
@@ -212,6 +213,13 @@ public:
     /**refresh bone world matrix*/
     void updateBoneMatrix();
     
+    /**
+     * Gets a counter incremented each time updateBoneMatrix() changes the world matrix of a bone,
+     * MeshSkin uses it to compute the matrix palettes once per pose.
+     * @since v3.18
+     */
+    unsigned int getPoseVersion() const { return _poseVersion; }
+    
 CC_CONSTRUCTOR_ACCESS:
     
     Skeleton3D();
@@ -229,9 +237,20 @@ CC_CONSTRUCTOR_ACCESS:
     
 protected:
     
+    /** sorts the bones so that every bone comes after its parent */
+    void sortBones();
+    
     Vector<Bone3D*> _bones; // bones
 
     Vector<Bone3D*> _rootBones;
+    
+    // flat hierarchy, updated in a single pass by updateBoneMatrix()
+    std::vector<Bone3D*> _sortedBones; // parents before their children
+    std::vector<int>     _boneParents; // index of the parent in _sortedBones, -1 for roots
+    std::vector<char>    _boneChanged; // whether the world matrix changed in the last pass
+    bool                 _bonesSorted;
+    bool                 _poseValid; // whether all world matrices were computed once
+    unsigned int         _poseVersion;
 };
 
 // end of 3d group
@@ -24,18 +24,25 @@
  ****************************************************************************/
 
 #include "3d/CCSprite3D.h"
+
+#include <algorithm>
+
 #include "3d/CCObjLoader.h"
 #include "3d/CCMeshSkin.h"
 #include "3d/CCBundle3D.h"
 #include "3d/CCSprite3DMaterial.h"
 #include "3d/CCAttachNode.h"
 #include "3d/CCMesh.h"
+#include "3d/CCMeshSimplifier.h"
+#include "3d/CCMeshOptimizer.h"
+#include "3d/CCAABBTree.h"
 
 #include "base/CCDirector.h"
 #include "base/CCAsyncTaskPool.h"
 #include "base/ccUTF8.h"
 #include "2d/CCLight.h"
 #include "2d/CCCamera.h"
+#include "2d/CCScene.h"
 #include "base/ccMacros.h"
 #include "platform/CCPlatformMacros.h"
 #include "platform/CCFileUtils.h"
@@ -51,6 +58,37 @@ NS_CC_BEGIN
 
 static Sprite3DMaterial* getSprite3DMaterialForAttribs(MeshVertexData* meshVertexData, bool usesLight);
 
+// sprites created by createAsync() whose buffers are being filled
+static Vector<Sprite3D*> s_pendingUploads;
+static unsigned int s_asyncUploadBudget = 1024 * 1024;
+static int s_lodLevels = 0;
+static float s_lodMaxError = 0.02f;
+static int s_meshOptimization = 0;
+
+// generates the levels of detail and optimizes the meshes, on the loading thread for createAsync()
+static void processMeshDatas(MeshDatas* meshdatas, int lodLevels, float lodMaxError, int meshOptimization)
+{
+    if (lodLevels > 0)
+    {
+        for (auto meshdata : meshdatas->meshDatas)
+        {
+            if (meshdata)
+                MeshSimplifier::generateLODs(meshdata, lodLevels, lodMaxError);
+        }
+    }
+    // after the levels of detail, whose indices are reordered too
+    if (meshOptimization)
+    {
+        for (auto meshdata : meshdatas->meshDatas)
+        {
+            if (meshdata)
+                MeshOptimizer::optimize(meshdata, meshOptimization);
+        }
+    }
+}
+// fraction of the size change needed to switch back to the previous level of detail, against popping
+static const float LOD_HYSTERESIS = 0.1f;
+
 Sprite3D* Sprite3D::create()
 {
     //
@@ -113,66 +151,233 @@ void Sprite3D::createAsync(const std::string& modelPath, const std::string& text
     sprite->_asyncLoadParam.materialdatas = new (std::nothrow) MaterialDatas();
     sprite->_asyncLoadParam.meshdatas = new (std::nothrow) MeshDatas();
     sprite->_asyncLoadParam.nodeDatas = new (std::nothrow) NodeDatas();
-    AsyncTaskPool::getInstance()->enqueue(AsyncTaskPool::TaskType::TASK_IO, CC_CALLBACK_1(Sprite3D::afterAsyncLoad, sprite), (void*)(&sprite->_asyncLoadParam), [sprite]()
+    sprite->_asyncLoadParam.uploadBudget = s_asyncUploadBudget;
+    sprite->_asyncLoadParam.lodLevels = s_lodLevels;
+    sprite->_asyncLoadParam.lodMaxError = s_lodMaxError;
+    sprite->_asyncLoadParam.meshOptimization = s_meshOptimization;
+    // resolved here, so that the loading thread doesn't go through the search paths
+    std::string fullPath = FileUtils::getInstance()->fullPathForFilename(modelPath);
+    AsyncTaskPool::getInstance()->enqueue(AsyncTaskPool::TaskType::TASK_IO, CC_CALLBACK_1(Sprite3D::afterAsyncLoad, sprite), (void*)(&sprite->_asyncLoadParam), [sprite, fullPath]()
     {
-        sprite->_asyncLoadParam.result = sprite->loadFromFile(sprite->_asyncLoadParam.modelPath, sprite->_asyncLoadParam.nodeDatas, sprite->_asyncLoadParam.meshdatas, sprite->_asyncLoadParam.materialdatas);
+        auto& param = sprite->_asyncLoadParam;
+        param.result = !fullPath.empty() && sprite->loadFromFile(fullPath, param.nodeDatas, param.meshdatas, param.materialdatas);
+        if (param.result)
+            processMeshDatas(param.meshdatas, param.lodLevels, param.lodMaxError, param.meshOptimization);
     });
     
 }
 
+void Sprite3D::setAsyncUploadBudget(unsigned int bytesPerFrame)
+{
+    // large enough for any vertex, every frame makes progress
+    s_asyncUploadBudget = bytesPerFrame > 0 ? std::max(bytesPerFrame, 4096u) : 0;
+}
+
+unsigned int Sprite3D::getAsyncUploadBudget()
+{
+    return s_asyncUploadBudget;
+}
+
+void Sprite3D::setLODGeneration(int levels, float maxError)
+{
+    s_lodLevels = std::max(levels, 0);
+    s_lodMaxError = maxError;
+}
+
+int Sprite3D::getLODGenerationLevels()
+{
+    return s_lodLevels;
+}
+
+void Sprite3D::setMeshOptimization(int flags)
+{
+    s_meshOptimization = flags;
+}
+
+int Sprite3D::getMeshOptimization()
+{
+    return s_meshOptimization;
+}
+
 void Sprite3D::afterAsyncLoad(void* param)
 {
     Sprite3D::AsyncLoadParam* asyncParam = (Sprite3D::AsyncLoadParam*)param;
+    if (asyncParam && asyncParam->result)
+    {
+        _meshes.clear();
+        _meshVertexDatas.clear();
+        CC_SAFE_RELEASE_NULL(_skeleton);
+        removeAllAttachNode();
+        
+        // one MeshVertexData per mesh data, in order
+        auto& meshDatas = asyncParam->meshdatas->meshDatas;
+        meshDatas.erase(std::remove(meshDatas.begin(), meshDatas.end(), nullptr), meshDatas.end());
+
+        //create in the main thread, the buffers are filled by uploadPendingBuffers() over the next frames
+        if (initFrom(*asyncParam->nodeDatas, *asyncParam->meshdatas, *asyncParam->materialdatas, false))
+        {
+            asyncParam->uploadMesh = 0;
+            asyncParam->uploadBuffer = 0;
+            asyncParam->uploadOffset = 0;
+            // scheduled again if needed, a reset of the director unschedules it even with uploads left
+            auto scheduler = Director::getInstance()->getScheduler();
+            if (!scheduler->isScheduled("uploadPendingBuffers", &s_pendingUploads))
+                scheduler->schedule(&Sprite3D::uploadPendingBuffers, &s_pendingUploads, 0, false, "uploadPendingBuffers");
+            s_pendingUploads.pushBack(this);
+            return;
+        }
+    }
+    finishAsyncLoad(false);
+}
+
+void Sprite3D::finishAsyncLoad(bool initialized)
+{
+    auto asyncParam = &_asyncLoadParam;
     autorelease();
-    if (asyncParam)
+    if (asyncParam->result)
     {
-        if (asyncParam->result)
+        auto& meshdatas = asyncParam->meshdatas;
+        auto& materialdatas = asyncParam->materialdatas;
+        auto&   nodeDatas = asyncParam->nodeDatas;
+        if (initialized)
         {
-            _meshes.clear();
-            _meshVertexDatas.clear();
-            CC_SAFE_RELEASE_NULL(_skeleton);
-            removeAllAttachNode();
-            
-            //create in the main thread
-            auto& meshdatas = asyncParam->meshdatas;
-            auto& materialdatas = asyncParam->materialdatas;
-            auto&   nodeDatas = asyncParam->nodeDatas;
-            if (initFrom(*nodeDatas, *meshdatas, *materialdatas))
+            auto spritedata = Sprite3DCache::getInstance()->getSpriteData(asyncParam->modelPath);
+            if (spritedata == nullptr)
             {
-                auto spritedata = Sprite3DCache::getInstance()->getSpriteData(asyncParam->modelPath);
-                if (spritedata == nullptr)
-                {
-                    //add to cache
-                    auto data = new (std::nothrow) Sprite3DCache::Sprite3DData();
-                    data->materialdatas = materialdatas;
-                    data->nodedatas = nodeDatas;
-                    data->meshVertexDatas = _meshVertexDatas;
-                    for (const auto mesh : _meshes) {
-                        data->glProgramStates.pushBack(mesh->getGLProgramState());
-                    }
-                    
-                    Sprite3DCache::getInstance()->addSprite3DData(asyncParam->modelPath, data);
-                    
-                    CC_SAFE_DELETE(meshdatas);
-                    materialdatas = nullptr;
-                    nodeDatas = nullptr;
+                //add to cache
+                auto data = new (std::nothrow) Sprite3DCache::Sprite3DData();
+                data->materialdatas = materialdatas;
+                data->nodedatas = nodeDatas;
+                data->meshVertexDatas = _meshVertexDatas;
+                for (const auto mesh : _meshes) {
+                    data->glProgramStates.pushBack(mesh->getGLProgramState());
                 }
+                
+                Sprite3DCache::getInstance()->addSprite3DData(asyncParam->modelPath, data);
+                
+                CC_SAFE_DELETE(meshdatas);
+                materialdatas = nullptr;
+                nodeDatas = nullptr;
             }
-            CC_SAFE_DELETE(meshdatas);
-            CC_SAFE_DELETE(materialdatas);
-            CC_SAFE_DELETE(nodeDatas);
-            
-            if (asyncParam->texPath != "")
+        }
+        CC_SAFE_DELETE(meshdatas);
+        CC_SAFE_DELETE(materialdatas);
+        CC_SAFE_DELETE(nodeDatas);
+        
+        if (asyncParam->texPath != "")
+        {
+            setTexture(asyncParam->texPath);
+        }
+    }
+    else
+    {
+        CCLOG("file load failed: %s ", asyncParam->modelPath.c_str());
+    }
+    asyncParam->afterLoadCallback(this, asyncParam->callbackParam);
+}
+
+bool Sprite3D::uploadBuffers(size_t* budget)
+{
+    auto& param = _asyncLoadParam;
+    while (param.uploadMesh < (size_t)_meshVertexDatas.size())
+    {
+        const MeshData& meshdata = *param.meshdatas->meshDatas[param.uploadMesh];
+        MeshVertexData* vertexdata = _meshVertexDatas.at(param.uploadMesh);
+
+        // buffer 0 is the vertices, then every sub mesh has its indices followed by its levels of detail
+        size_t subMesh = 0;
+        size_t lod = 0;
+        if (param.uploadBuffer > 0)
+        {
+            lod = param.uploadBuffer - 1;
+            while (subMesh < meshdata.getSubMeshCount())
             {
-                setTexture(asyncParam->texPath);
+                size_t lodCount = subMesh < meshdata.subMeshLODs.size() ? meshdata.subMeshLODs[subMesh].size() : 0;
+                if (lod <= lodCount)
+                    break;
+                lod -= lodCount + 1;
+                ++subMesh;
             }
         }
+        if (subMesh == meshdata.getSubMeshCount())
+        {
+            ++param.uploadMesh;
+            param.uploadBuffer = 0;
+            continue;
+        }
+
+        // whole vertices and indices are uploaded, the chunks are multiples of the element size
+        const char* bytes = nullptr;
+        size_t elementSize = 0;
+        size_t elementCount = 0;
+        if (param.uploadBuffer == 0)
+        {
+            bytes = (const char*)meshdata.getVertexData();
+            elementSize = vertexdata->_vertexBuffer ? vertexdata->_vertexBuffer->getSizePerVertex() : 0;
+            elementCount = vertexdata->_vertexBuffer ? vertexdata->_vertexBuffer->getVertexNumber() : 0;
+        }
+        else if (lod == 0)
+        {
+            bytes = (const char*)meshdata.getIndexData(subMesh);
+            elementSize = sizeof(unsigned short);
+            elementCount = meshdata.getIndexCount(subMesh);
+        }
         else
         {
-            CCLOG("file load failed: %s ", asyncParam->modelPath.c_str());
+            const auto& indices = meshdata.subMeshLODs[subMesh][lod - 1].indices;
+            bytes = (const char*)indices.data();
+            elementSize = sizeof(unsigned short);
+            elementCount = indices.size();
+        }
+
+        size_t count = elementSize > 0 ? std::min(elementCount - param.uploadOffset, *budget / elementSize) : 0;
+        if (count == 0 && param.uploadOffset < elementCount && elementSize > 0)
+            return false;
+
+        if (count > 0)
+        {
+            const char* chunk = bytes + param.uploadOffset * elementSize;
+            if (param.uploadBuffer == 0)
+            {
+                vertexdata->_vertexBuffer->updateVertices(chunk, (int)count, (int)param.uploadOffset);
+            }
+            else
+            {
+                MeshIndexData* indexdata = vertexdata->_indexs.at(subMesh);
+                indexdata->_indexBuffer->updateIndices(chunk, (int)count, indexdata->getIndexStart((int)lod) + (int)param.uploadOffset);
+            }
+            param.uploadOffset += count;
+            *budget -= count * elementSize;
+        }
+
+        if (param.uploadOffset == elementCount)
+        {
+            ++param.uploadBuffer;
+            param.uploadOffset = 0;
         }
-        asyncParam->afterLoadCallback(this, asyncParam->callbackParam);
     }
+    return true;
+}
+
+void Sprite3D::uploadPendingBuffers(float /*dt*/)
+{
+    // the budget of the frame is the one set when the oldest pending model was requested
+    unsigned int bytesPerFrame = s_pendingUploads.empty() ? 0 : s_pendingUploads.front()->_asyncLoadParam.uploadBudget;
+    size_t budget = bytesPerFrame > 0 ? bytesPerFrame : SIZE_MAX;
+    // first come first served, the callbacks are called in the order of the requests
+    while (!s_pendingUploads.empty())
+    {
+        Sprite3D* sprite = s_pendingUploads.front();
+        if (!sprite->uploadBuffers(&budget))
+            break;
+
+        // the sprite is still owned by its loading, finishAsyncLoad() autoreleases it
+        s_pendingUploads.erase(0);
+        sprite->finishAsyncLoad(true);
+    }
+
+    if (s_pendingUploads.empty())
+        Director::getInstance()->getScheduler()->unschedule("uploadPendingBuffers", &s_pendingUploads);
 }
 
 AABB Sprite3D::getAABBRecursivelyImp(Node *node)
@@ -233,27 +438,27 @@ bool Sprite3D::loadFromFile(const std::string& path, NodeDatas* nodedatas, MeshD
     std::string fullPath = FileUtils::getInstance()->fullPathForFilename(path);
     
     std::string ext = FileUtils::getInstance()->getFileExtension(path);
+    bool ret = false;
     if (ext == ".obj")
     {
-        return Bundle3D::loadObj(*meshdatas, *materialdatas, *nodedatas, fullPath);
+        ret = Bundle3D::loadObj(*meshdatas, *materialdatas, *nodedatas, fullPath);
     }
     else if (ext == ".c3b" || ext == ".c3t")
     {
-        //load from .c3b or .c3t
+        //load from .c3b or .c3t, the meshes are only used to fill the buffers and don't need copies
         auto bundle = Bundle3D::createBundle();
+        bundle->setMeshBufferViewsEnabled(true);
         if (!bundle->load(fullPath))
         {
             Bundle3D::destroyBundle(bundle);
             return false;
         }
         
-        auto ret = bundle->loadMeshDatas(*meshdatas)
+        ret = bundle->loadMeshDatas(*meshdatas)
             && bundle->loadMaterials(*materialdatas) && bundle->loadNodes(*nodedatas);
         Bundle3D::destroyBundle(bundle);
-        
-        return ret;
     }
-    return false;
+    return ret;
 }
 
 Sprite3D::Sprite3D()
@@ -264,6 +469,7 @@ Sprite3D::Sprite3D()
 , _shaderUsingLight(false)
 , _forceDepthWrite(false)
 , _usingAutogeneratedGLProgram(true)
+, _lodThreshold(0.25f)
 {
 }
 
@@ -300,6 +506,7 @@ bool Sprite3D::initWithFile(const std::string& path)
     NodeDatas* nodeDatas = new (std::nothrow) NodeDatas();
     if (loadFromFile(path, nodeDatas, meshdatas, materialdatas))
     {
+        processMeshDatas(meshdatas, s_lodLevels, s_lodMaxError, s_meshOptimization);
         if (initFrom(*nodeDatas, *meshdatas, *materialdatas))
         {
             //add to cache
@@ -324,7 +531,7 @@ bool Sprite3D::initWithFile(const std::string& path)
     return false;
 }
 
-bool Sprite3D::initFrom(const NodeDatas& nodeDatas, const MeshDatas& meshdatas, const MaterialDatas& materialdatas)
+bool Sprite3D::initFrom(const NodeDatas& nodeDatas, const MeshDatas& meshdatas, const MaterialDatas& materialdatas, bool fillBuffers)
 {
     for(const auto& it : meshdatas.meshDatas)
     {
@@ -332,7 +539,7 @@ bool Sprite3D::initFrom(const NodeDatas& nodeDatas, const MeshDatas& meshdatas,
         {
 //            Mesh* mesh = Mesh::create(*it);
 //            _meshes.pushBack(mesh);
-            auto meshvertex = MeshVertexData::create(*it);
+            auto meshvertex = MeshVertexData::create(*it, fillBuffers);
             _meshVertexDatas.pushBack(meshvertex);
         }
     }
@@ -719,6 +926,18 @@ void Sprite3D::visit(cocos2d::Renderer *renderer, const cocos2d::Mat4 &parentTra
     uint32_t flags = processParentFlags(parentTransform, parentFlags);
     flags |= FLAGS_RENDER_AS_3D;
     
+    if (_aabbTreeProxy.isAttached() && ((flags & FLAGS_DIRTY_MASK) || _aabbDirty))
+    {
+        _aabbTreeProxy.move(getAABB());
+    }
+#if CC_USE_CULLING
+    // culled out through the tree, there is nothing else to do without children
+    if (_children.empty() && !_skeleton && _aabbTreeProxy.isOutOfFrustum(Camera::getVisitingCamera()))
+    {
+        return;
+    }
+#endif
+    
     //
     Director* director = Director::getInstance();
     director->pushMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW);
@@ -760,7 +979,7 @@ void Sprite3D::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
 {
 #if CC_USE_CULLING
     // camera clipping
-    if(_children.size() == 0 && Camera::getVisitingCamera() && !Camera::getVisitingCamera()->isVisibleInFrustum(&getAABB()))
+    if(_children.size() == 0 && Camera::getVisitingCamera() && !isInFrustum(Camera::getVisitingCamera()))
         return;
 #endif
     
@@ -789,8 +1008,10 @@ void Sprite3D::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
         }
     }
     
+    int lod = selectLOD(Camera::getVisitingCamera());
     for (auto mesh: _meshes)
     {
+        mesh->setLOD(lod);
         mesh->draw(renderer,
                    _globalZOrder,
                    transform,
@@ -802,6 +1023,76 @@ void Sprite3D::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
     }
 }
 
+void Sprite3D::onEnter()
+{
+    Node::onEnter();
+    
+    _aabbTreeProxy.attach(this, getAABB());
+}
+
+void Sprite3D::onExit()
+{
+    _aabbTreeProxy.detach();
+    _cameraLODs.clear();
+    
+    Node::onExit();
+}
+
+bool Sprite3D::isInFrustum(const Camera* camera)
+{
+    // the tree was culled before the visit, it doesn't know about the sprites moved since
+    // and the skinned ones change their bounds without moving
+    if (!_skeleton && _aabbTreeProxy.isCulledFor(camera))
+    {
+        return _aabbTreeProxy.isVisible();
+    }
+    return camera->isVisibleInFrustum(&getAABB());
+}
+
+int Sprite3D::selectLOD(const Camera* camera)
+{
+    int lodCount = 1;
+    for (auto mesh : _meshes)
+    {
+        if (mesh->getMeshIndexData())
+            lodCount = std::max(lodCount, mesh->getMeshIndexData()->getLODCount());
+    }
+    if (lodCount == 1 || _lodThreshold <= 0 || !camera)
+        return 0;
+
+    // size of the bounding sphere relative to the viewport height
+    const AABB& aabb = getAABB();
+    float radius = (aabb._max - aabb._min).length() * 0.5f;
+    const Mat4& projection = camera->getProjectionMatrix();
+    float size = radius * fabsf(projection.m[5]);
+    if (camera->getType() == Camera::Type::PERSPECTIVE)
+    {
+        Vec3 center = (aabb._min + aabb._max) * 0.5f;
+        camera->getViewMatrix().transformPoint(&center);
+        float distance = center.length();
+        size = distance > radius ? size / distance : FLT_MAX;
+    }
+
+    // the cameras which didn't draw the sprite since the last frame are forgotten, they may be gone
+    unsigned int frame = Director::getInstance()->getTotalFrames();
+    _cameraLODs.erase(std::remove_if(_cameraLODs.begin(), _cameraLODs.end(),
+                                     [frame](const CameraLOD& it) { return frame - it.frame > 1; }), _cameraLODs.end());
+    auto state = std::find_if(_cameraLODs.begin(), _cameraLODs.end(),
+                              [camera](const CameraLOD& it) { return it.camera == camera; });
+    if (state == _cameraLODs.end())
+        state = _cameraLODs.insert(_cameraLODs.end(), CameraLOD{ camera, 0, frame });
+
+    // level n is drawn below threshold / 2^(n-1), the size has to go past a level boundary by the hysteresis
+    int lod = std::min(state->lod, lodCount - 1);
+    while (lod + 1 < lodCount && size * (1 + LOD_HYSTERESIS) < _lodThreshold / (1 << lod))
+        ++lod;
+    while (lod > 0 && size * (1 - LOD_HYSTERESIS) > _lodThreshold / (1 << (lod - 1)))
+        --lod;
+    state->lod = lod;
+    state->frame = frame;
+    return lod;
+}
+
 void Sprite3D::setGLProgramState(GLProgramState* glProgramState)
 {
     Node::setGLProgramState(glProgramState);
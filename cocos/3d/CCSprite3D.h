@@ -36,6 +36,7 @@
 #include "renderer/CCGLProgramState.h"
 #include "3d/CCSkeleton3D.h" // need to include for lua-binding
 #include "3d/CCAABB.h"
+#include "3d/CCAABBTree.h"
 #include "3d/CCBundle3DData.h"
 #include "3d/CCMeshVertexIndexData.h"
 
@@ -80,6 +81,35 @@ public:
     static void createAsync(const std::string &modelPath, const std::function<void(Sprite3D*, void*)>& callback, void* callbackparam);
     
     static void createAsync(const std::string &modelPath, const std::string &texturePath, const std::function<void(Sprite3D*, void*)>& callback, void* callbackparam);
+
+    /**
+     * Sets how many bytes of vertex and index buffers the sprites created by createAsync() upload per frame.
+     * The buffers of large models are filled over several frames, the callback is called once they are complete.
+     * It applies to the models requested afterwards.
+     * @param bytesPerFrame Upload budget of a frame, at least 4KB, 0 uploads every model at once. Defaults to 1MB.
+     * @since v3.18
+     */
+    static void setAsyncUploadBudget(unsigned int bytesPerFrame);
+    static unsigned int getAsyncUploadBudget();
+    
+    /**
+     * Generates levels of detail for the models loaded afterwards, see MeshSimplifier.
+     * Each level has about half the triangles of the previous one, they share the vertices of the full mesh.
+     * @param levels Number of levels besides the full resolution mesh, 0 disables the generation (default).
+     * @param maxError Largest error of the coarsest level, relative to the size of the model.
+     * @since v3.18
+     */
+    static void setLODGeneration(int levels, float maxError = 0.02f);
+    static int getLODGenerationLevels();
+    
+    /**
+     * Optimizes the meshes of the models loaded afterwards, see MeshOptimizer.
+     * Quantized attributes need shaders which don't expect values out of the range they were found in.
+     * @param flags Combination of MeshOptimizer::Flags, 0 disables the optimization (default).
+     * @since v3.18
+     */
+    static void setMeshOptimization(int flags);
+    static int getMeshOptimization();
     
     /**set diffuse texture, set the first if multiple textures exist*/
     void setTexture(const std::string& texFile);
@@ -175,9 +205,21 @@ public:
     void setLightMask(unsigned int mask) { _lightMask = mask; }
     unsigned int getLightMask() const { return _lightMask; }
     
+    /**
+     * Sets when the levels of detail of the meshes are drawn, per camera: level 1 is drawn once the bounding sphere
+     * is smaller than screenSize times the viewport height, and every next level at half the size of the previous one.
+     * 0 always draws the full resolution meshes. Defaults to 0.25.
+     * @since v3.18
+     */
+    void setLODThreshold(float screenSize) { _lodThreshold = screenSize; }
+    float getLODThreshold() const { return _lodThreshold; }
+    
     /**draw*/
     virtual void draw(Renderer *renderer, const Mat4 &transform, uint32_t flags) override;
 
+    virtual void onEnter() override;
+    virtual void onExit() override;
+
     /** Adds a new material to the sprite.
      The Material will be applied to all the meshes that belong to the sprite.
      Internally it will call `setMaterial(material,-1)`
@@ -215,7 +257,7 @@ CC_CONSTRUCTOR_ACCESS:
     
     bool initWithFile(const std::string &path);
     
-    bool initFrom(const NodeDatas& nodedatas, const MeshDatas& meshdatas, const MaterialDatas& materialdatas);
+    bool initFrom(const NodeDatas& nodedatas, const MeshDatas& meshdatas, const MaterialDatas& materialdatas, bool fillBuffers = true);
     
     /**load sprite3d from cache, return true if succeed, false otherwise*/
     bool loadFromCache(const std::string& path);
@@ -244,9 +286,19 @@ CC_CONSTRUCTOR_ACCESS:
     void onAABBDirty() { _aabbDirty = true; }
     
     void afterAsyncLoad(void* param);
+    void finishAsyncLoad(bool initialized);
+    /** fills the buffers of an asynchronous load within the budget, returns true once they are complete */
+    bool uploadBuffers(size_t* budget);
+    static void uploadPendingBuffers(float dt);
 
     static AABB getAABBRecursivelyImp(Node *node);
     
+    /** whether the sprite may be seen by the camera, through the AABBTree of the scene when it can be used */
+    bool isInFrustum(const Camera* camera);
+    
+    /** level of detail to draw for a camera, with some hysteresis around the previous choice for that camera */
+    int selectLOD(const Camera* camera);
+    
 protected:
 
     Skeleton3D*                  _skeleton; //skeleton
@@ -266,6 +318,15 @@ protected:
     bool                         _shaderUsingLight; // is current shader using light ?
     bool                         _forceDepthWrite; // Always write to depth buffer
     bool                         _usingAutogeneratedGLProgram;
+    float                        _lodThreshold;
+    struct CameraLOD
+    {
+        const Camera* camera;
+        int lod;
+        unsigned int frame; // last frame drawn by the camera
+    };
+    std::vector<CameraLOD>       _cameraLODs; // last level of detail drawn for each camera
+    AABBTreeProxy                _aabbTreeProxy; // culls the sprite through the tree of the scene
     
     struct AsyncLoadParam
     {
@@ -277,6 +338,15 @@ protected:
         MeshDatas* meshdatas;
         MaterialDatas* materialdatas;
         NodeDatas*   nodeDatas;
+        // upload progress: mesh, buffer of the mesh (0 for vertices, then the sub meshes) and elements uploaded
+        size_t                          uploadMesh;
+        size_t                          uploadBuffer;
+        size_t                          uploadOffset;
+        // settings of the static setters when createAsync() was called, the loading thread can't read them
+        unsigned int                    uploadBudget;
+        int                             lodLevels;
+        float                           lodMaxError;
+        int                             meshOptimization;
     };
     AsyncLoadParam             _asyncLoadParam;
 };
@@ -29,6 +29,7 @@ USING_NS_CC;
 #include <stdlib.h>
 #include <float.h>
 #include <set>
+#include <algorithm>
 #include "renderer/CCGLProgram.h"
 #include "renderer/CCGLProgramCache.h"
 #include "renderer/CCGLProgramState.h"
@@ -38,8 +39,10 @@ USING_NS_CC;
 #include "renderer/CCRenderState.h"
 #include "base/CCDirector.h"
 #include "base/CCEventType.h"
+#include "base/ccUTF8.h"
 #include "2d/CCCamera.h"
 #include "platform/CCImage.h"
+#include "platform/CCFileUtils.h"
 
 NS_CC_BEGIN
 
@@ -52,6 +55,23 @@ static bool isPOT(int number)
     return flag;
 }
 
+// amount of chunks a job evaluates the LOD of
+static const int CHUNKS_PER_LOD_JOB = 256;
+
+// bytes per pixel of a heightmap, the height is in the first byte.
+static int getByteStride(Texture2D::PixelFormat format)
+{
+    switch (format)
+    {
+    case Texture2D::PixelFormat::BGRA8888:
+        return 4;
+    case  Texture2D::PixelFormat::RGB888:
+        return 3;
+    default:
+        return 1;
+    }
+}
+
 Terrain * Terrain::create(TerrainData &parameter, CrackFixedType fixedType)
 {
     Terrain * terrain = new (std::nothrow)Terrain();
@@ -74,7 +94,13 @@ bool Terrain::initWithTerrainData(TerrainData &parameter, CrackFixedType fixedTy
     bool initResult = true;
 
     //init heightmap
-    initResult &= this->initHeightMap(parameter._heightMapSrc);
+    if (isPaged())
+    {
+        initResult &= this->initPagedHeightMap();
+    }else
+    {
+        initResult &= this->initHeightMap(parameter._heightMapSrc);
+    }
     //init textures alpha map,detail Maps
     initResult &= this->initTextures();
     initResult &= this->initProperties();
@@ -123,6 +149,20 @@ bool Terrain::initProperties()
 
 void Terrain::draw(cocos2d::Renderer *renderer, const cocos2d::Mat4 &transform, uint32_t flags)
 {
+    if (_aabbTreeProxy.isAttached() && (flags & FLAGS_DIRTY_MASK))
+    {
+        // the box is needed before onDraw, which only updates it when the terrain moved
+        _terrainModelMatrix = getNodeToWorldTransform();
+        _quadRoot->preCalculateAABB(_terrainModelMatrix);
+        _aabbTreeProxy.move(getAABB());
+    }
+#if CC_USE_CULLING
+    // the chunks are culled by the quad tree while drawing, the whole terrain through the tree of the scene
+    if (_isEnableFrustumCull && _aabbTreeProxy.isOutOfFrustum(Camera::getVisitingCamera()))
+    {
+        return;
+    }
+#endif
     _customCommand.func = CC_CALLBACK_0(Terrain::onDraw, this, transform, flags);
     renderer->addCommand(&_customCommand);
 }
@@ -198,6 +238,10 @@ void Terrain::onDraw(const Mat4 &transform, uint32_t /*flags*/)
         auto m = camera->getNodeToWorldTransform();
         //set lod
         setChunksLOD(Vec3(m.m[12], m.m[13], m.m[14]));
+        if (isPaged())
+        {
+            updatePages(Vec3(m.m[12], m.m[13], m.m[14]));
+        }
     }
 
     if(_isCameraViewChanged )
@@ -252,19 +296,7 @@ bool Terrain::initHeightMap(const std::string& heightMap)
             }
         }
 
-        //calculate the neighbor
-        for(int m =0;m<chunk_amount_y;m++)
-        {
-            for(int n =0; n<chunk_amount_x;n++)
-            {
-                if(n-1>=0) _chunkesArray[m][n]->_left = _chunkesArray[m][n-1];
-                if(n+1<chunk_amount_x) _chunkesArray[m][n]->_right = _chunkesArray[m][n+1];
-                if(m-1>=0) _chunkesArray[m][n]->_back = _chunkesArray[m-1][n];
-                if(m+1<chunk_amount_y) _chunkesArray[m][n]->_front = _chunkesArray[m+1][n];
-            }
-        }
-        _quadRoot = new (std::nothrow) QuadTree(0,0,_imageWidth,_imageHeight,this);
-        setLODDistance(_chunkSize.width,2*_chunkSize.width,3*_chunkSize.width);
+        setupChunks(chunk_amount_x, chunk_amount_y);
         return true;
     }else
     {
@@ -273,10 +305,79 @@ bool Terrain::initHeightMap(const std::string& heightMap)
     }
 }
 
+bool Terrain::initPagedHeightMap()
+{
+    int chunk_amount_x = _terrainData._tileCount.width;
+    int chunk_amount_y = _terrainData._tileCount.height;
+    //the quad tree splits the terrain in four until it reaches the chunks
+    if(!isPOT(chunk_amount_x) || chunk_amount_x != chunk_amount_y || chunk_amount_x > MAX_CHUNKES)
+    {
+        CCLOG("warning: the tile count of a paged terrain is not the same POT in X and Y");
+        return false;
+    }
+    _heightMapImage = nullptr;
+    _data = nullptr;
+    _imageWidth = chunk_amount_x*_chunkSize.width + 1;
+    _imageHeight = chunk_amount_y*_chunkSize.height + 1;
+    //the tiles are not loaded yet, so take the whole range of the heights
+    _minHeight = -0.5f*_terrainData._mapHeight;
+    _maxHeight = 0.5f*_terrainData._mapHeight;
+    //every chunk has a full tile, so their skirts start at the same vertices
+    int width = _chunkSize.width;
+    int height = _chunkSize.height;
+    _skirtVerticesOffset[0] = (height+1)*(width+1);
+    _skirtVerticesOffset[1] = _skirtVerticesOffset[0] + height+1;
+    _skirtVerticesOffset[2] = _skirtVerticesOffset[1] + width+1;
+    _skirtVerticesOffset[3] = _skirtVerticesOffset[2] + height+1;
+
+    float scale = _terrainData._mapScale;
+    float skirtHeight = _skirtRatio*scale*8;
+    memset(_chunkesArray, 0, sizeof(_chunkesArray));
+    for(int m =0;m<chunk_amount_y;m++)
+    {
+        for(int n =0; n<chunk_amount_x;n++)
+        {
+            auto chunk = new (std::nothrow) Chunk();
+            chunk->_terrain = this;
+            chunk->_size = _chunkSize;
+            chunk->_posX = n;
+            chunk->_posY = m;
+            //until the chunk is loaded, its AABB is the biggest it can be
+            chunk->_aabb.set(Vec3(n*width*scale - _imageWidth/2*scale, _minHeight - skirtHeight, m*height*scale - _imageHeight/2*scale),
+                             Vec3((n+1)*width*scale - _imageWidth/2*scale, _maxHeight, (m+1)*height*scale - _imageHeight/2*scale));
+            _chunkesArray[m][n] = chunk;
+        }
+    }
+    setupChunks(chunk_amount_x, chunk_amount_y);
+    return true;
+}
+
+void Terrain::setupChunks(int chunkAmountX, int chunkAmountY)
+{
+    //calculate the neighbor
+    for(int m =0;m<chunkAmountY;m++)
+    {
+        for(int n =0; n<chunkAmountX;n++)
+        {
+            if(n-1>=0) _chunkesArray[m][n]->_left = _chunkesArray[m][n-1];
+            if(n+1<chunkAmountX) _chunkesArray[m][n]->_right = _chunkesArray[m][n+1];
+            if(m-1>=0) _chunkesArray[m][n]->_back = _chunkesArray[m-1][n];
+            if(m+1<chunkAmountY) _chunkesArray[m][n]->_front = _chunkesArray[m+1][n];
+        }
+    }
+    _quadRoot = new (std::nothrow) QuadTree(0,0,_imageWidth,_imageHeight,this);
+    initIndicesLOD();
+    setLODDistance(_chunkSize.width,2*_chunkSize.width,3*_chunkSize.width);
+    setPageDistance(4*_chunkSize.width,5*_chunkSize.width);
+}
+
 Terrain::Terrain()
-: _alphaMap(nullptr)
+: _data(nullptr)
+, _alphaMap(nullptr)
 , _lightMap(nullptr)
 , _lightDir(-1.f, -1.f, 0.f)
+, _quadRoot(nullptr)
+, _heightMapImage(nullptr)
 , _stateBlock(nullptr)
 #if CC_ENABLE_CACHE_TEXTURE_DATA
 , _backToForegroundListener(nullptr)
@@ -284,6 +385,8 @@ Terrain::Terrain()
 {
     _stateBlock = RenderState::StateBlock::create();
     CC_SAFE_RETAIN(_stateBlock);
+    memset(_chunkLodIndices, 0, sizeof(_chunkLodIndices));
+    memset(_chunkLodIndicesSkirt, 0, sizeof(_chunkLodIndicesSkirt));
 
     _customCommand.setTransparent(false);
     _customCommand.set3D(true);
@@ -302,22 +405,34 @@ void Terrain::setChunksLOD(const Vec3& cameraPos)
 {
     int chunk_amount_y = _imageHeight/_chunkSize.height;
     int chunk_amount_x = _imageWidth/_chunkSize.width;
-    for(int m=0;m<chunk_amount_y;m++)
-        for(int n =0;n<chunk_amount_x;n++)
-        {
-            AABB aabb = _chunkesArray[m][n]->_parent->_worldSpaceAABB;
-            auto center = aabb.getCenter();
-            float dist = Vec2(center.x, center.z).distance(Vec2(cameraPos.x, cameraPos.z));
-            _chunkesArray[m][n]->_currentLod = 3;
-            for(int i =0;i<3;++i)
+
+    // The rows of chunks are claimed by groups by this thread and by the workers, which also smooth the
+    // vertices of the chunks changing LOD, so that only the upload is left to the draw.
+    int rowsPerGroup = std::max(1, CHUNKS_PER_LOD_JOB/chunk_amount_x);
+    bool updateVertices = _crackFixedType == CrackFixedType::INCREASE_LOWER;
+    AsyncTaskPool::getInstance()->parallelFor(chunk_amount_y, rowsPerGroup, [&](size_t begin, size_t end) {
+        for(size_t m=begin;m<end;m++)
+            for(int n =0;n<chunk_amount_x;n++)
             {
-                if(dist<=_lodDistance[i])
+                auto chunk = _chunkesArray[m][n];
+                AABB aabb = chunk->_parent->_worldSpaceAABB;
+                auto center = aabb.getCenter();
+                float dist = Vec2(center.x, center.z).distance(Vec2(cameraPos.x, cameraPos.z));
+                chunk->_currentLod = 3;
+                for(int i =0;i<3;++i)
                 {
-                    _chunkesArray[m][n]->_currentLod = i;
-                    break;
+                    if(dist<=_lodDistance[i])
+                    {
+                        chunk->_currentLod = i;
+                        break;
+                    }
+                }
+                if(updateVertices && chunk->_pageState == Chunk::PageState::LOADED)
+                {
+                    chunk->updateVerticesForLOD();
                 }
             }
-        }
+    });
 }
 
 float Terrain::getHeight(float x, float z, Vec3 * normal) const
@@ -380,21 +495,19 @@ float Terrain::getHeight(const Vec2& pos, Vec3* normal) const
 
 float Terrain::getImageHeight(int pixel_x,int pixel_y) const
 {
-    int byte_stride =1;
-    switch (_heightMapImage->getRenderFormat())
+    if (isPaged())
     {
-    case Texture2D::PixelFormat::BGRA8888:
-        byte_stride = 4;
-        break;
-    case  Texture2D::PixelFormat::RGB888:
-        byte_stride =3;
-        break;
-    case Texture2D::PixelFormat::I8:
-        byte_stride =1;
-        break;
-    default:
-        break;
+        //the heights are the ones of the vertices of the loaded chunks
+        auto chunk = getChunkByPixel(pixel_x, pixel_y);
+        if (!chunk || chunk->_pageState != Chunk::PageState::LOADED)
+        {
+            return 0;
+        }
+        int i = pixel_y - chunk->_posY*(int)_chunkSize.height;
+        int j = pixel_x - chunk->_posX*(int)_chunkSize.width;
+        return chunk->_originalVertices[i*((int)_chunkSize.width+1) + j]._position.y;
     }
+    int byte_stride = getByteStride(_heightMapImage->getRenderFormat());
     return _data[(pixel_y*_imageWidth+pixel_x)*byte_stride]*1.0/255*_terrainData._mapHeight -0.5*_terrainData._mapHeight;
 }
 
@@ -423,42 +536,46 @@ void Terrain::loadVertices()
 
 void Terrain::calculateNormal()
 {
-    _indices.clear();
-    //we generate whole terrain indices(global indices) for correct normal calculate
-    for(int i =0;i<_imageHeight-1;i+=1)
+    //we use the whole terrain for correct normal calculate
+    calculateNormal(_vertices, _imageWidth, _imageHeight);
+}
+
+void Terrain::calculateNormal(std::vector<TerrainVertexData>& vertices, int width, int height)
+{
+    std::vector<unsigned int> indices;
+    indices.reserve((width-1)*(height-1)*6);
+    for(int i =0;i<height-1;i+=1)
     {
-        for(int j = 0;j<_imageWidth-1;j+=1)
+        for(int j = 0;j<width-1;j+=1)
         {
 
-            int nLocIndex = i * _imageWidth + j;
-            _indices.push_back (nLocIndex);
-            _indices.push_back (nLocIndex + _imageWidth);
-            _indices.push_back (nLocIndex + 1);
+            int nLocIndex = i * width + j;
+            indices.push_back (nLocIndex);
+            indices.push_back (nLocIndex + width);
+            indices.push_back (nLocIndex + 1);
 
-            _indices.push_back (nLocIndex + 1);
-            _indices.push_back (nLocIndex + _imageWidth);
-            _indices.push_back (nLocIndex + _imageWidth+1);
+            indices.push_back (nLocIndex + 1);
+            indices.push_back (nLocIndex + width);
+            indices.push_back (nLocIndex + width+1);
         }
     }
-    for (size_t i = 0, size = _indices.size(); i < size; i += 3) {
-        unsigned int Index0 = _indices[i];
-        unsigned int Index1 = _indices[i + 1];
-        unsigned int Index2 = _indices[i + 2];
-        Vec3 v1 = _vertices[Index1]._position - _vertices[Index0]._position;
-        Vec3 v2 = _vertices[Index2]._position - _vertices[Index0]._position;
+    for (size_t i = 0, size = indices.size(); i < size; i += 3) {
+        unsigned int Index0 = indices[i];
+        unsigned int Index1 = indices[i + 1];
+        unsigned int Index2 = indices[i + 2];
+        Vec3 v1 = vertices[Index1]._position - vertices[Index0]._position;
+        Vec3 v2 = vertices[Index2]._position - vertices[Index0]._position;
         Vec3 Normal;
         Vec3::cross(v1,v2,&Normal);
         Normal.normalize();
-        _vertices[Index0]._normal += Normal;
-        _vertices[Index1]._normal += Normal;
-        _vertices[Index2]._normal += Normal;
+        vertices[Index0]._normal += Normal;
+        vertices[Index1]._normal += Normal;
+        vertices[Index2]._normal += Normal;
     }
 
-    for (auto &vertex : _vertices) {
+    for (auto &vertex : vertices) {
         vertex._normal.normalize();
     }
-    //global indices no need at all
-    _indices.clear();
 }
 
 void Terrain::setDrawWire(bool bool_value)
@@ -473,6 +590,60 @@ void Terrain::setLODDistance(float lod_1, float lod_2, float lod_3)
     _lodDistance[2] = lod_3;
 }
 
+void Terrain::setPageDistance(float loadDistance, float unloadDistance)
+{
+    _pageLoadDistance = loadDistance;
+    _pageUnloadDistance = unloadDistance;
+}
+
+void Terrain::updatePages(const Vec3& cameraPos)
+{
+    int chunk_amount_y = _imageHeight/_chunkSize.height;
+    int chunk_amount_x = _imageWidth/_chunkSize.width;
+    for(int m=0;m<chunk_amount_y;m++)
+        for(int n =0;n<chunk_amount_x;n++)
+        {
+            auto chunk = _chunkesArray[m][n];
+            auto center = chunk->_parent->_worldSpaceAABB.getCenter();
+            float dist = Vec2(center.x, center.z).distance(Vec2(cameraPos.x, cameraPos.z));
+            if (chunk->_pageState == Chunk::PageState::UNLOADED)
+            {
+                if (dist <= _pageLoadDistance)
+                {
+                    chunk->loadPage();
+                }
+            }else if (dist > _pageUnloadDistance)
+            {
+                chunk->unloadPage();
+            }
+        }
+}
+
+bool Terrain::isHeightLoaded(float x, float z) const
+{
+    if (!isPaged())
+    {
+        return true;
+    }
+    auto pos = convertToTerrainSpace(Vec2(x, z));
+    if(pos.x>=_imageWidth-1 || pos.y >=_imageHeight-1 || pos.x<0 || pos.y<0)
+    {
+        return false;
+    }
+    //getHeight samples the next pixels too, which may be in the next chunks
+    int i = (int)pos.x;
+    int j = (int)pos.y;
+    for (int k = 0; k < 4; ++k)
+    {
+        auto chunk = getChunkByPixel(i + (k & 1), j + (k >> 1));
+        if (!chunk || chunk->_pageState != Chunk::PageState::LOADED)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 void Terrain::setIsEnableFrustumCull(bool bool_value)
 {
     _isEnableFrustumCull = bool_value;
@@ -503,15 +674,7 @@ Terrain::~Terrain()
         }
     }
 
-    for(size_t i =0, size = _chunkLodIndicesSet.size(); i < size; ++i)
-    {
-        glDeleteBuffers(1,&(_chunkLodIndicesSet[i]._chunkIndices._indices));
-    }
-
-    for(size_t i =0, size = _chunkLodIndicesSkirtSet.size(); i < size; ++i)
-    {
-        glDeleteBuffers(1,&(_chunkLodIndicesSkirtSet[i]._chunkIndices._indices));
-    }
+    releaseIndicesLOD();
 
 #if CC_ENABLE_CACHE_TEXTURE_DATA
     Director::getInstance()->getEventDispatcher()->removeEventListener(_backToForegroundListener);
@@ -636,6 +799,11 @@ cocos2d::Vec2 Terrain::convertToTerrainSpace(const Vec2& worldSpaceXZ) const
 
 void Terrain::resetHeightMap(const std::string& heightMap)
 {
+    if (isPaged())
+    {
+        CCLOG("warning: the height map of a paged terrain can not be reset");
+        return;
+    }
     _heightMapImage->release();
     _vertices.clear();
     free(_data);
@@ -681,7 +849,7 @@ std::vector<float> Terrain::getHeightData() const
     for (int i = 0; i < _imageHeight; ++i) {
         for (int j = 0; j < _imageWidth; j++) {
             int idx = i * _imageWidth + j;
-            data[idx] = (_vertices[idx]._position.y);
+            data[idx] = isPaged() ? getImageHeight(j, i) : _vertices[idx]._position.y;
         }
     }
     return data;
@@ -693,6 +861,15 @@ Terrain::Chunk * cocos2d::Terrain::getChunkByIndex(int x, int y) const
     return _chunkesArray[y][x];
 }
 
+Terrain::Chunk * cocos2d::Terrain::getChunkByPixel(int pixelX, int pixelY) const
+{
+    if (pixelX<0 || pixelY<0 || pixelX>=_imageWidth || pixelY>=_imageHeight) return nullptr;
+    //the last pixels are the border of the last chunks
+    int chunk_amount_y = _imageHeight/_chunkSize.height;
+    int chunk_amount_x = _imageWidth/_chunkSize.width;
+    return getChunkByIndex(std::min(pixelX/(int)_chunkSize.width, chunk_amount_x-1), std::min(pixelY/(int)_chunkSize.height, chunk_amount_y-1));
+}
+
 void Terrain::setAlphaMap(cocos2d::Texture2D * newAlphaMapTexture)
 {
     CC_SAFE_RETAIN(newAlphaMapTexture);
@@ -719,79 +896,299 @@ void Terrain::setDetailMap(unsigned int index, DetailMap detailMap)
     delete textImage;
 }
 
-Terrain::ChunkIndices Terrain::lookForIndicesLOD(int neighborLod[4], int selfLod, bool * result)
+void Terrain::initIndicesLOD()
 {
-    (* result) =false;
-    ChunkIndices tmp;
-    tmp._indices = 0;
-    tmp._size = 0;
-    if(_chunkLodIndicesSet.empty())
-    {
-        (* result) =false;
-        return tmp;
-    }else
+    releaseIndicesLOD();
+    //the indices only depend on the LOD of the chunk and on its neighbors with a greater LOD
+    std::vector<GLushort> indices;
+    for(int lod =0;lod<4;++lod)
     {
-        int test[5];
-        memcpy(test,neighborLod,sizeof(int [4]));
-        test[4] = selfLod;
-        for(size_t i =0, size = _chunkLodIndicesSet.size(); i < size; ++i)
+        for(int neighborMask =0;neighborMask<NEIGHBOR_MASK_COUNT;++neighborMask)
         {
-            if(memcmp(test,_chunkLodIndicesSet[i]._relativeLod,sizeof(test))==0)
+            ChunkIndices * chunkIndices;
+            indices.clear();
+            if(_crackFixedType == CrackFixedType::SKIRT)
+            {
+                //the skirts hide the cracks whatever the neighbors are
+                if(neighborMask) break;
+                generateIndicesLODSkirt(lod, indices);
+                chunkIndices = &_chunkLodIndicesSkirt[lod];
+            }else
             {
-                (*result) = true;
-                return _chunkLodIndicesSet[i]._chunkIndices;
+                //no neighbor has a greater LOD than the last one
+                if(lod == 3 && neighborMask) break;
+                generateIndicesLOD(lod, neighborMask, indices);
+                chunkIndices = &_chunkLodIndices[lod][neighborMask];
             }
+            chunkIndices->_size = (unsigned short)indices.size();
+            glGenBuffers(1,&(chunkIndices->_indices));
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, chunkIndices->_indices);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER,sizeof(GLushort)*indices.size(),indices.data(),GL_STATIC_DRAW);
         }
     }
-    (* result) =false;
-    return tmp;
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
-Terrain::ChunkIndices Terrain::insertIndicesLOD(int neighborLod[4], int selfLod, GLushort * indices,int size)
+void Terrain::releaseIndicesLOD()
 {
-    ChunkLODIndices lodIndices;
-    memcpy(lodIndices._relativeLod,neighborLod,sizeof(int [4]));
-    lodIndices._relativeLod[4] = selfLod;
-    lodIndices._chunkIndices._size = size;
-    glGenBuffers(1,&(lodIndices._chunkIndices._indices));
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lodIndices._chunkIndices._indices);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,sizeof(GLushort)*size,indices,GL_STATIC_DRAW);
-    this->_chunkLodIndicesSet.push_back(lodIndices);
-    return lodIndices._chunkIndices;
+    for(int lod =0;lod<4;++lod)
+    {
+        for(int neighborMask =0;neighborMask<NEIGHBOR_MASK_COUNT;++neighborMask)
+        {
+            if(_chunkLodIndices[lod][neighborMask]._indices)
+            {
+                glDeleteBuffers(1,&(_chunkLodIndices[lod][neighborMask]._indices));
+            }
+        }
+        if(_chunkLodIndicesSkirt[lod]._indices)
+        {
+            glDeleteBuffers(1,&(_chunkLodIndicesSkirt[lod]._indices));
+        }
+    }
+    memset(_chunkLodIndices, 0, sizeof(_chunkLodIndices));
+    memset(_chunkLodIndicesSkirt, 0, sizeof(_chunkLodIndicesSkirt));
 }
 
-Terrain::ChunkIndices Terrain::lookForIndicesLODSkrit(int selfLod, bool * result)
+void Terrain::generateIndicesLOD(int lod, int neighborMask, std::vector<GLushort>& indices) const
 {
-    ChunkIndices badResult;
-    badResult._indices = 0;
-    badResult._size = 0;
-    if(this->_chunkLodIndicesSkirtSet.empty())
-    {
-    (*result) = false;
-    return badResult;
-    }
-    for(size_t i = 0, size = _chunkLodIndicesSkirtSet.size(); i < size; ++i)
+    int gridY = _chunkSize.height;
+    int gridX = _chunkSize.width;
+
+    int step = 1<<lod;
+    if(neighborMask)//stitch the borders to the coarser neighbors
     {
-        if(_chunkLodIndicesSkirtSet[i]._selfLod == selfLod)
+        //t-junction inner
+        for(int i =step;i<gridY-step;i+=step)
         {
-            (*result) = true;
-            return _chunkLodIndicesSkirtSet[i]._chunkIndices;
+            for(int j = step;j<gridX-step;j+=step)
+            {
+                int nLocIndex = i * (gridX+1) + j;
+                indices.push_back (nLocIndex);
+                indices.push_back (nLocIndex + step * (gridX+1));
+                indices.push_back (nLocIndex + step);
+
+                indices.push_back (nLocIndex + step);
+                indices.push_back (nLocIndex + step * (gridX+1));
+                indices.push_back (nLocIndex + step * (gridX+1) + step);
+            }
         }
-    }
-    (*result) = false;
-    return badResult;
+        //fix T-crack
+        int next_step = 1<<(lod+1);
+        if(neighborMask & NEIGHBOR_LEFT)//left
+        {
+            for(int i =0;i<gridY;i+=next_step)
+            {
+                indices.push_back(i*(gridX+1)+step);
+                indices.push_back(i*(gridX+1));
+                indices.push_back((i+next_step)*(gridX+1));
+
+                indices.push_back(i*(gridX+1)+step);
+                indices.push_back((i+next_step)*(gridX+1));
+                indices.push_back((i+step)*(gridX+1)+step);
+
+                indices.push_back((i+step)*(gridX+1)+step);
+                indices.push_back((i+next_step)*(gridX+1));
+                indices.push_back((i+next_step)*(gridX+1)+step);
+            }
+        }else{
+            int start=0;
+            int end =gridY;
+            if(neighborMask & NEIGHBOR_FRONT) end -=step;
+            if(neighborMask & NEIGHBOR_BACK) start +=step;
+            for(int i =start;i<end;i+=step)
+            {
+                indices.push_back(i*(gridX+1)+step);
+                indices.push_back(i*(gridX+1));
+                indices.push_back((i+step)*(gridX+1));
+
+                indices.push_back(i*(gridX+1)+step);
+                indices.push_back((i+step)*(gridX+1));
+                indices.push_back((i+step)*(gridX+1)+step);
+            }
+        }
+
+        if(neighborMask & NEIGHBOR_RIGHT)//LEFT
+        {
+            for(int i =0;i<gridY;i+=next_step)
+            {
+                indices.push_back(i*(gridX+1)+gridX);
+                indices.push_back(i*(gridX+1)+gridX-step);
+                indices.push_back((i+step)*(gridX+1)+gridX-step);
+
+                indices.push_back(i*(gridX+1)+gridX);
+                indices.push_back((i+step)*(gridX+1)+gridX-step);
+                indices.push_back((i+next_step)*(gridX+1)+gridX-step);
+
+                indices.push_back(i*(gridX+1)+gridX);
+                indices.push_back((i+next_step)*(gridX+1)+gridX-step);
+                indices.push_back((i+next_step)*(gridX+1)+gridX);
+            }
+        }else{
+            int start=0;
+            int end =gridY;
+            if(neighborMask & NEIGHBOR_FRONT) end -=step;
+            if(neighborMask & NEIGHBOR_BACK) start +=step;
+            for(int i =start;i<end;i+=step)
+            {
+                indices.push_back(i*(gridX+1)+gridX);
+                indices.push_back(i*(gridX+1)+gridX-step);
+                indices.push_back((i+step)*(gridX+1)+gridX-step);
+
+                indices.push_back(i*(gridX+1)+gridX);
+                indices.push_back((i+step)*(gridX+1)+gridX-step);
+                indices.push_back((i+step)*(gridX+1)+gridX);
+            }
+        }
+        if(neighborMask & NEIGHBOR_FRONT)//front
+        {
+            for(int i =0;i<gridX;i+=next_step)
+            {
+                indices.push_back((gridY-step)*(gridX+1)+i);
+                indices.push_back(gridY*(gridX+1)+i);
+                indices.push_back((gridY-step)*(gridX+1)+i+step);
+
+                indices.push_back((gridY-step)*(gridX+1)+i+step);
+                indices.push_back(gridY*(gridX+1)+i);
+                indices.push_back(gridY*(gridX+1)+i+next_step);
+
+                indices.push_back((gridY-step)*(gridX+1)+i+step);
+                indices.push_back(gridY*(gridX+1)+i+next_step);
+                indices.push_back((gridY-step)*(gridX+1)+i+next_step);
+            }
+        }else
+        {
+            for(int i =step;i<gridX-step;i+=step)
+            {
+                indices.push_back((gridY-step)*(gridX+1)+i);
+                indices.push_back(gridY*(gridX+1)+i);
+                indices.push_back((gridY-step)*(gridX+1)+i+step);
+
+                indices.push_back((gridY-step)*(gridX+1)+i+step);
+                indices.push_back(gridY*(gridX+1)+i);
+                indices.push_back(gridY*(gridX+1)+i+step);
+            }
+        }
+        if(neighborMask & NEIGHBOR_BACK)//back
+        {
+            for(int i =0;i<gridX;i+=next_step)
+            {
+                indices.push_back(i);
+                indices.push_back(step*(gridX+1) +i);
+                indices.push_back(step*(gridX+1) +i+step);
+
+                indices.push_back(i);
+                indices.push_back(step*(gridX+1) +i+step);
+                indices.push_back(i+next_step);
+
+                indices.push_back(i+next_step);
+                indices.push_back(step*(gridX+1) +i+step);
+                indices.push_back(step*(gridX+1) +i+next_step);
+            }
+        }else{
+            for(int i =step;i<gridX-step;i+=step)
+            {
+                indices.push_back(i);
+                indices.push_back(step*(gridX+1)+i);
+                indices.push_back(step*(gridX+1)+i+step);
+
+                indices.push_back(i);
+                indices.push_back(step*(gridX+1)+i+step);
+                indices.push_back(i+step);
+            }
+        }
+    }else{
+        //No lod difference, use simple method
+        for(int i =0;i<gridY;i+=step)
+        {
+            for(int j = 0;j<gridX;j+=step)
+            {
+
+                int nLocIndex = i * (gridX+1) + j;
+                indices.push_back (nLocIndex);
+                indices.push_back (nLocIndex + step * (gridX+1));
+                indices.push_back (nLocIndex + step);
+
+                indices.push_back (nLocIndex + step);
+                indices.push_back (nLocIndex + step * (gridX+1));
+                indices.push_back (nLocIndex + step * (gridX+1) + step);
+            }
+        }    }
 }
 
-Terrain::ChunkIndices Terrain::insertIndicesLODSkirt(int selfLod, GLushort * indices, int size)
+
+void Terrain::generateIndicesLODSkirt(int lod, std::vector<GLushort>& indices) const
 {
-    ChunkLODIndicesSkirt skirtIndices;
-    skirtIndices._selfLod = selfLod;
-    skirtIndices._chunkIndices._size = size;
-    glGenBuffers(1,&(skirtIndices._chunkIndices._indices));
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, skirtIndices._chunkIndices._indices);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,sizeof(GLushort)*size,indices,GL_STATIC_DRAW);
-    this->_chunkLodIndicesSkirtSet.push_back(skirtIndices);
-    return skirtIndices._chunkIndices;
+    int gridY = _chunkSize.height;
+    int gridX = _chunkSize.width;
+    int step = 1<<lod;
+    int k =0;
+    for(int i =0;i<gridY;i+=step,k+=step)
+    {
+        for(int j = 0;j<gridX;j+=step)
+        {
+            int nLocIndex = i * (gridX+1) + j;
+            indices.push_back (nLocIndex);
+            indices.push_back (nLocIndex + step * (gridX+1));
+            indices.push_back (nLocIndex + step);
+
+            indices.push_back (nLocIndex + step);
+            indices.push_back (nLocIndex + step * (gridX+1));
+            indices.push_back (nLocIndex + step * (gridX+1) + step);
+        }
+    }
+    //add skirt
+    //#1
+    for(int i =0;i<gridY;i+=step)
+    {
+        int nLocIndex = i * (gridX+1) + gridX;
+        indices.push_back (nLocIndex);
+        indices.push_back (nLocIndex + step * (gridX+1));
+        indices.push_back ((gridY+1) *(gridX+1)+i);
+
+        indices.push_back ((gridY+1) *(gridX+1)+i);
+        indices.push_back (nLocIndex + step * (gridX+1));
+        indices.push_back ((gridY+1) *(gridX+1)+i+step);
+    }
+
+    //#2
+    for(int j =0;j<gridX;j+=step)
+    {
+        int nLocIndex = (gridY)* (gridX+1) + j;
+        indices.push_back (nLocIndex);
+        indices.push_back (_skirtVerticesOffset[1] +j);
+        indices.push_back (nLocIndex + step);
+
+        indices.push_back (nLocIndex + step);
+        indices.push_back (_skirtVerticesOffset[1] +j);
+        indices.push_back (_skirtVerticesOffset[1] +j + step);
+    }
+
+    //#3
+    for(int i =0;i<gridY;i+=step)
+    {
+        int nLocIndex = i * (gridX+1);
+        indices.push_back (nLocIndex);
+        indices.push_back (_skirtVerticesOffset[2]+i);
+        indices.push_back ((i+step)*(gridX+1));
+
+        indices.push_back ((i+step)*(gridX+1));
+        indices.push_back (_skirtVerticesOffset[2]+i);
+        indices.push_back (_skirtVerticesOffset[2]+i +step);
+    }
+
+    //#4
+    for(int j =0;j<gridX;j+=step)
+    {
+        int nLocIndex = j;
+        indices.push_back (nLocIndex + step);
+        indices.push_back (_skirtVerticesOffset[3]+j);
+        indices.push_back (nLocIndex);
+
+
+        indices.push_back (_skirtVerticesOffset[3] + j + step);
+        indices.push_back (_skirtVerticesOffset[3] +j);
+        indices.push_back (nLocIndex + step);
+    }
 }
 
 void Terrain::setSkirtHeightRatio(float ratio)
@@ -812,9 +1209,24 @@ void Terrain::onEnter()
     Node::onEnter();
     _terrainModelMatrix = getNodeToWorldTransform();
     _quadRoot->preCalculateAABB(_terrainModelMatrix);
+    _aabbTreeProxy.attach(this, getAABB());
     cacheUniformAttribLocation();
 }
 
+void Terrain::onExit()
+{
+#if CC_ENABLE_SCRIPT_BINDING
+    if (_scriptType == kScriptTypeJavascript)
+    {
+        if (ScriptEngineManager::sendNodeEventToJSExtended(this, kNodeOnExit))
+            return;
+    }
+#endif
+
+    _aabbTreeProxy.detach();
+    Node::onExit();
+}
+
 void Terrain::cacheUniformAttribLocation()
 {
 
@@ -916,13 +1328,20 @@ void Terrain::reload()
     {
         for(int n =0; n<chunk_amount_x;n++)
         {
-            _chunkesArray[m][n]->finish();
+            //the chunks being loaded finish once they are
+            if (_chunkesArray[m][n]->_pageState == Chunk::PageState::LOADED)
+            {
+                _chunkesArray[m][n]->finish();
+            }
         }
     }
 
     initTextures();
-    _chunkLodIndicesSet.clear();
-    _chunkLodIndicesSkirtSet.clear();
+    //the buffers were lost with the context
+    memset(_chunkLodIndices, 0, sizeof(_chunkLodIndices));
+    memset(_chunkLodIndicesSkirt, 0, sizeof(_chunkLodIndicesSkirt));
+    initIndicesLOD();
+    _isCameraViewChanged = true;
 }
 
 void Terrain::Chunk::finish()
@@ -937,22 +1356,21 @@ void Terrain::Chunk::finish()
 
     glBindBuffer(GL_ARRAY_BUFFER,0);
 
-    calculateSlope();
-
-    for(int i =0;i<4;++i)
-    {
-        int step = 1<<_currentLod;
-        //reserve the indices size, the first part is the core part of the chunk, the second part & third part is for fix crack
-        int indicesAmount =(_terrain->_chunkSize.width/step+1)*(_terrain->_chunkSize.height/step+1)*6+(_terrain->_chunkSize.height/step)*6
-            +(_terrain->_chunkSize.width/step)*6;
-        _lod[i]._indices.reserve(indicesAmount);
-    }
+    //the original vertices were uploaded
+    std::vector<TerrainVertexData>().swap(_currentVertices);
+    _verticesLod = 0;
+    _verticesDirty = false;
     _oldLod = -1;
 }
 
 void Terrain::Chunk::bindAndDraw()
 {
+    if (_pageState != PageState::LOADED)
+    {
+        return;
+    }
     glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+    uploadVertices();
     if(_terrain->_isCameraViewChanged || _oldLod <0)
     {
         switch (_terrain->_crackFixedType)
@@ -962,7 +1380,6 @@ void Terrain::Chunk::bindAndDraw()
             updateIndicesLODSkirt();
             break;
         case CrackFixedType::INCREASE_LOWER:
-            updateVerticesForLOD();
             updateIndicesLOD();
             break;
         default:
@@ -987,76 +1404,72 @@ void Terrain::Chunk::generate(int imgWidth, int imageHei, int m, int n, const un
 {
     _posY = m;
     _posX = n;
-    switch (_terrain->_crackFixedType)
+    for(int i=_size.height*m;i<=_size.height*(m+1);++i)
     {
-    case CrackFixedType::SKIRT:
+        if(i>=imageHei) break;
+        for(int j=_size.width*n;j<=_size.width*(n+1);j++)
         {
-            for(int i=_size.height*m;i<=_size.height*(m+1);++i)
-            {
-                if(i>=imageHei) break;
-                for(int j=_size.width*n;j<=_size.width*(n+1);j++)
-                {
-                    if(j>=imgWidth)break;
-                    auto v =_terrain->_vertices[i*imgWidth + j];
-                    _originalVertices.push_back (v);
-                }
-            }
-            // add four skirts
+            if(j>=imgWidth)break;
+            auto v =_terrain->_vertices[i*imgWidth + j];
+            _originalVertices.push_back (v);
+        }
+    }
+    if (_terrain->_crackFixedType == CrackFixedType::SKIRT)
+    {
+        // add four skirts
+        float skirtHeight =  _terrain->_skirtRatio *_terrain->_terrainData._mapScale*8;
+        appendSkirts(&_terrain->_vertices[_size.height*m*imgWidth + _size.width*n], imgWidth, _size, skirtHeight,
+                     _originalVertices, _terrain->_skirtVerticesOffset);
+    }
+    generateTriangles();
+    calculateAABB();
+    _slope = calculateSlope(_originalVertices);
+    finish();
+    _pageState = PageState::LOADED;
+}
 
-            float skirtHeight =  _terrain->_skirtRatio *_terrain->_terrainData._mapScale*8;
-            //#1
-            _terrain->_skirtVerticesOffset[0] = (int)_originalVertices.size();
-            for(int i =_size.height*m;i<=_size.height*(m+1);++i)
-            {
-                auto v = _terrain->_vertices[i*imgWidth +_size.width*(n+1)];
-                v._position.y -= skirtHeight;
-                _originalVertices.push_back (v);
-            }
+void Terrain::Chunk::appendSkirts(const TerrainVertexData * grid, int gridWidth, const Size& size, float skirtHeight,
+                                  std::vector<TerrainVertexData>& vertices, int skirtVerticesOffset[4])
+{
+    //#1
+    skirtVerticesOffset[0] = (int)vertices.size();
+    for(int i =0;i<=size.height;++i)
+    {
+        auto v = grid[i*gridWidth + (int)size.width];
+        v._position.y -= skirtHeight;
+        vertices.push_back (v);
+    }
 
-            //#2
-            _terrain->_skirtVerticesOffset[1] = (int)_originalVertices.size();
-            for(int j =_size.width*n;j<=_size.width*(n+1);j++)
-            {
-                auto v = _terrain->_vertices[_size.height*(m+1)*imgWidth + j];
-                v._position.y -=skirtHeight;
-                _originalVertices.push_back (v);
-            }
+    //#2
+    skirtVerticesOffset[1] = (int)vertices.size();
+    for(int j =0;j<=size.width;j++)
+    {
+        auto v = grid[(int)size.height*gridWidth + j];
+        v._position.y -=skirtHeight;
+        vertices.push_back (v);
+    }
 
-            //#3
-            _terrain->_skirtVerticesOffset[2] = (int)_originalVertices.size();
-            for(int i =_size.height*m;i<=_size.height*(m+1);++i)
-            {
-                auto v = _terrain->_vertices[i*imgWidth + _size.width*n];
-                v._position.y -= skirtHeight;
-                _originalVertices.push_back (v);
-            }
+    //#3
+    skirtVerticesOffset[2] = (int)vertices.size();
+    for(int i =0;i<=size.height;++i)
+    {
+        auto v = grid[i*gridWidth];
+        v._position.y -= skirtHeight;
+        vertices.push_back (v);
+    }
 
-            //#4
-            _terrain->_skirtVerticesOffset[3] = (int)_originalVertices.size();
-            for(int j =_size.width*n;j<=_size.width*(n+1);j++)
-            {
-                auto v = _terrain->_vertices[_size.height*m*imgWidth+j];
-                v._position.y -= skirtHeight;
-                //v.position.y = -5;
-                _originalVertices.push_back (v);
-            }
-        }
-        break;
-    case CrackFixedType::INCREASE_LOWER:
-        {
-            for(int i=_size.height*m;i<=_size.height*(m+1);++i)
-            {
-                if(i>=imageHei) break;
-                for(int j=_size.width*n;j<=_size.width*(n+1);j++)
-                {
-                    if(j>=imgWidth)break;
-                    auto v =_terrain->_vertices[i*imgWidth + j];
-                    _originalVertices.push_back (v);
-                }
-            }
-        }
-        break;
+    //#4
+    skirtVerticesOffset[3] = (int)vertices.size();
+    for(int j =0;j<=size.width;j++)
+    {
+        auto v = grid[j];
+        v._position.y -= skirtHeight;
+        vertices.push_back (v);
     }
+}
+
+void Terrain::Chunk::generateTriangles()
+{
     //store triangle:
     for (int i = 0; i < _size.height; ++i)
     {
@@ -1070,227 +1483,264 @@ void Terrain::Chunk::generate(int imgWidth, int imageHei, int m, int n, const un
             _trianglesList.push_back(b);
         }
     }
-
-    calculateAABB();
-    finish();
 }
 
-Terrain::Chunk::Chunk()
+void Terrain::Chunk::loadPage()
 {
-    _currentLod = 0;
-    _left = nullptr;
-    _right = nullptr;
-    _back = nullptr;
-    _front = nullptr;
-    _oldLod = -1;
-    for(int i =0;i<4;++i)
+    auto page = std::make_shared<ChunkPage>();
+    // resolved here, so that the loading thread doesn't go through the search paths
+    auto path = StringUtils::format(_terrain->_terrainData._heightMapTileFormat.c_str(), _posX, _posY);
+    page->_path = FileUtils::getInstance()->fullPathForFilename(path);
+    int tileCountX = _terrain->_terrainData._tileCount.width;
+    int tileCountY = _terrain->_terrainData._tileCount.height;
+    for (int dy = -1; dy <= 1; ++dy)
     {
-        _neighborOldLOD[i] = -1;
+        for (int dx = -1; dx <= 1; ++dx)
+        {
+            //the triangles around the corners (-1, -1) and (+1, +1) don't touch the tile
+            if (dx == dy) continue;
+            int x = _posX + dx;
+            int y = _posY + dy;
+            if (x < 0 || y < 0 || x >= tileCountX || y >= tileCountY) continue;
+            auto neighborPath = StringUtils::format(_terrain->_terrainData._heightMapTileFormat.c_str(), x, y);
+            page->_neighborPaths[dy + 1][dx + 1] = FileUtils::getInstance()->fullPathForFilename(neighborPath);
+        }
     }
+    page->_posX = _posX;
+    page->_posY = _posY;
+    page->_size = _size;
+    page->_imageWidth = _terrain->_imageWidth;
+    page->_imageHeight = _terrain->_imageHeight;
+    page->_mapHeight = _terrain->_terrainData._mapHeight;
+    page->_mapScale = _terrain->_terrainData._mapScale;
+    page->_crackFixedType = _terrain->_crackFixedType;
+    page->_skirtHeight = _terrain->_skirtRatio*_terrain->_terrainData._mapScale*8;
+    page->_loaded = false;
+    page->_discarded = false;
+    _page = page;
+    _pageState = PageState::LOADING;
+
+    //the chunks at the first LOD are the closest ones
+    auto priority = _currentLod == 0 ? AsyncTaskPool::Priority::HIGH : AsyncTaskPool::Priority::NORMAL;
+    _pageTask = AsyncTaskPool::getInstance()->submit([page]()
+    {
+        page->load();
+    }, [this, page]()
+    {
+        //the chunk is freed or doesn't want the page anymore
+        if (!page->_discarded)
+        {
+            onPageLoaded();
+        }
+    }, priority);
 }
 
-void Terrain::Chunk::updateIndicesLOD()
+void Terrain::Chunk::onPageLoaded()
 {
-    int currentNeighborLOD[4];
-    if(_left)
-    {
-        currentNeighborLOD[0] = _left->_currentLod;
-    }else{currentNeighborLOD[0] = -1;}
-    if(_right)
-    {
-        currentNeighborLOD[1] = _right->_currentLod;
-    }else{currentNeighborLOD[1] = -1;}
-    if(_back)
+    _pageTask = nullptr;
+    if (!_page->_loaded)
     {
-        currentNeighborLOD[2] = _back->_currentLod;
-    }else{currentNeighborLOD[2] = -1;}
-    if(_front)
+        //stays loading, so that it is tried again only once it was unloaded
+        CCLOG("warning: can not load the height map tile %s", _page->_path.c_str());
+        return;
+    }
+    _originalVertices.swap(_page->_vertices);
+    _slope = _page->_slope;
+    _page = nullptr;
+
+    generateTriangles();
+    _aabb.reset();
+    calculateAABB();
+    finish();
+    _pageState = PageState::LOADED;
+
+    //the quad tree has the AABB the chunk could have at most until now
+    _parent->_localAABB = _aabb;
+    _parent->_worldSpaceAABB = _aabb;
+    _parent->_worldSpaceAABB.transform(_terrain->_terrainModelMatrix);
+    for (auto & triangle : _trianglesList)
     {
-        currentNeighborLOD[3] = _front->_currentLod;
-    }else{currentNeighborLOD[3] = -1;}
+        triangle.transform(_terrain->getNodeToWorldTransform());
+    }
+    //update the culling, and the indices of the neighbors
+    _terrain->_isCameraViewChanged = true;
+}
 
-    if(_oldLod == _currentLod &&(memcmp(currentNeighborLOD,_neighborOldLOD,sizeof(currentNeighborLOD))==0) )
+void Terrain::Chunk::unloadPage()
+{
+    if (_pageTask)
     {
-        return;// no need to update
+        _pageTask->cancel();
+        _pageTask = nullptr;
     }
-    bool isOk;
-    _chunkIndices = _terrain->lookForIndicesLOD(currentNeighborLOD,_currentLod,&isOk);
-    if(isOk)
+    if (_page)
     {
-        return;
+        _page->_discarded = true;
+        _page = nullptr;
     }
-    memcpy(_neighborOldLOD,currentNeighborLOD,sizeof(currentNeighborLOD));
-    _oldLod = _currentLod;
-    int gridY = _size.height;
-    int gridX = _size.width;
+    glDeleteBuffers(1,&_vbo);
+    _vbo = 0;
+    std::vector<TerrainVertexData>().swap(_originalVertices);
+    std::vector<TerrainVertexData>().swap(_currentVertices);
+    std::vector<Triangle>().swap(_trianglesList);
+    _oldLod = -1;
+    _oldNeighborMask = -1;
+    _verticesLod = 0;
+    _verticesDirty = false;
+    _pageState = PageState::UNLOADED;
+}
 
-    int step = 1<<_currentLod;
-    if((_left&&_left->_currentLod > _currentLod) ||(_right&&_right->_currentLod > _currentLod)
-        ||(_back&&_back->_currentLod > _currentLod) || (_front && _front->_currentLod > _currentLod))
-        //need update indices.
-    {
-        //t-junction inner
-        _lod[_currentLod]._indices.clear();
-        for(int i =step;i<gridY-step;i+=step)
-        {
-            for(int j = step;j<gridX-step;j+=step)
-            {
-                int nLocIndex = i * (gridX+1) + j;
-                _lod[_currentLod]._indices.push_back (nLocIndex);
-                _lod[_currentLod]._indices.push_back (nLocIndex + step * (gridX+1));
-                _lod[_currentLod]._indices.push_back (nLocIndex + step);
+void Terrain::ChunkPage::load()
+{
+    int width = _size.width + 1;
+    int height = _size.height + 1;
+    //the heights of the tile with a one pixel apron from its neighbors around it
+    int apronWidth = width + 2;
+    int apronHeight = height + 2;
+    std::vector<float> heights(apronWidth*apronHeight);
+    std::vector<bool> hasHeight(apronWidth*apronHeight, false);
 
-                _lod[_currentLod]._indices.push_back (nLocIndex + step);
-                _lod[_currentLod]._indices.push_back (nLocIndex + step * (gridX+1));
-                _lod[_currentLod]._indices.push_back (nLocIndex + step * (gridX+1) + step);
-            }
+    auto readTile = [&](const std::string& path, int dx, int dy) {
+        auto image = new (std::nothrow) Image();
+        if (path.empty() || !image->initWithImageFile(path) || image->getWidth() != width || image->getHeight() != height)
+        {
+            image->release();
+            return false;
         }
-        //fix T-crack
-        int next_step = 1<<(_currentLod+1);
-        if(_left&&_left->_currentLod > _currentLod)//left
+        auto data = image->getData();
+        int byte_stride = getByteStride(image->getRenderFormat());
+        //the rows and columns of the tile, or only the one next to it for a neighbor
+        int firstRow = dy < 0 ? -1 : (dy > 0 ? height : 0);
+        int lastRow = dy < 0 ? -1 : (dy > 0 ? height : height - 1);
+        int firstColumn = dx < 0 ? -1 : (dx > 0 ? width : 0);
+        int lastColumn = dx < 0 ? -1 : (dx > 0 ? width : width - 1);
+        for (int i = firstRow; i <= lastRow; ++i)
         {
-            for(int i =0;i<gridY;i+=next_step)
-            {
-                _lod[_currentLod]._indices.push_back(i*(gridX+1)+step);
-                _lod[_currentLod]._indices.push_back(i*(gridX+1));
-                _lod[_currentLod]._indices.push_back((i+next_step)*(gridX+1));
-
-                _lod[_currentLod]._indices.push_back(i*(gridX+1)+step);
-                _lod[_currentLod]._indices.push_back((i+next_step)*(gridX+1));
-                _lod[_currentLod]._indices.push_back((i+step)*(gridX+1)+step);
-
-                _lod[_currentLod]._indices.push_back((i+step)*(gridX+1)+step);
-                _lod[_currentLod]._indices.push_back((i+next_step)*(gridX+1));
-                _lod[_currentLod]._indices.push_back((i+next_step)*(gridX+1)+step);
-            }
-        }else{
-            int start=0;
-            int end =gridY;
-            if(_front&&_front->_currentLod > _currentLod) end -=step;
-            if(_back&&_back->_currentLod > _currentLod) start +=step;
-            for(int i =start;i<end;i+=step)
+            for (int j = firstColumn; j <= lastColumn; ++j)
             {
-                _lod[_currentLod]._indices.push_back(i*(gridX+1)+step);
-                _lod[_currentLod]._indices.push_back(i*(gridX+1));
-                _lod[_currentLod]._indices.push_back((i+step)*(gridX+1));
-
-                _lod[_currentLod]._indices.push_back(i*(gridX+1)+step);
-                _lod[_currentLod]._indices.push_back((i+step)*(gridX+1));
-                _lod[_currentLod]._indices.push_back((i+step)*(gridX+1)+step);
+                //the tiles share their border pixels
+                int row = i - dy*(height - 1);
+                int column = j - dx*(width - 1);
+                int index = (i + 1)*apronWidth + j + 1;
+                heights[index] = data[(row*width + column)*byte_stride]*1.0/255*_mapHeight - 0.5*_mapHeight;
+                hasHeight[index] = true;
             }
         }
-
-        if(_right&&_right->_currentLod > _currentLod)//LEFT
+        image->release();
+        return true;
+    };
+    if (!readTile(_path, 0, 0))
+    {
+        return;
+    }
+    for (int dy = -1; dy <= 1; ++dy)
+    {
+        for (int dx = -1; dx <= 1; ++dx)
         {
-            for(int i =0;i<gridY;i+=next_step)
+            if (dx != 0 || dy != 0)
             {
-                _lod[_currentLod]._indices.push_back(i*(gridX+1)+gridX);
-                _lod[_currentLod]._indices.push_back(i*(gridX+1)+gridX-step);
-                _lod[_currentLod]._indices.push_back((i+step)*(gridX+1)+gridX-step);
-
-                _lod[_currentLod]._indices.push_back(i*(gridX+1)+gridX);
-                _lod[_currentLod]._indices.push_back((i+step)*(gridX+1)+gridX-step);
-                _lod[_currentLod]._indices.push_back((i+next_step)*(gridX+1)+gridX-step);
-
-                _lod[_currentLod]._indices.push_back(i*(gridX+1)+gridX);
-                _lod[_currentLod]._indices.push_back((i+next_step)*(gridX+1)+gridX-step);
-                _lod[_currentLod]._indices.push_back((i+next_step)*(gridX+1)+gridX);
-            }
-        }else{
-            int start=0;
-            int end =gridY;
-            if(_front&&_front->_currentLod > _currentLod) end -=step;
-            if(_back&&_back->_currentLod > _currentLod) start +=step;
-            for(int i =start;i<end;i+=step)
-            {
-                _lod[_currentLod]._indices.push_back(i*(gridX+1)+gridX);
-                _lod[_currentLod]._indices.push_back(i*(gridX+1)+gridX-step);
-                _lod[_currentLod]._indices.push_back((i+step)*(gridX+1)+gridX-step);
-
-                _lod[_currentLod]._indices.push_back(i*(gridX+1)+gridX);
-                _lod[_currentLod]._indices.push_back((i+step)*(gridX+1)+gridX-step);
-                _lod[_currentLod]._indices.push_back((i+step)*(gridX+1)+gridX);
+                readTile(_neighborPaths[dy + 1][dx + 1], dx, dy);
             }
         }
-        if(_front&&_front->_currentLod > _currentLod)//front
-        {
-            for(int i =0;i<gridX;i+=next_step)
-            {
-                _lod[_currentLod]._indices.push_back((gridY-step)*(gridX+1)+i);
-                _lod[_currentLod]._indices.push_back(gridY*(gridX+1)+i);
-                _lod[_currentLod]._indices.push_back((gridY-step)*(gridX+1)+i+step);
+    }
 
-                _lod[_currentLod]._indices.push_back((gridY-step)*(gridX+1)+i+step);
-                _lod[_currentLod]._indices.push_back(gridY*(gridX+1)+i);
-                _lod[_currentLod]._indices.push_back(gridY*(gridX+1)+i+next_step);
+    auto positionAt = [&](int i, int j) {
+        //the position in the whole terrain
+        int x = _posX*_size.width + j;
+        int y = _posY*_size.height + i;
+        return Vec3(x*_mapScale- _imageWidth/2*_mapScale, heights[(i + 1)*apronWidth + j + 1], y*_mapScale - _imageHeight/2*_mapScale);
+    };
 
-                _lod[_currentLod]._indices.push_back((gridY-step)*(gridX+1)+i+step);
-                _lod[_currentLod]._indices.push_back(gridY*(gridX+1)+i+next_step);
-                _lod[_currentLod]._indices.push_back((gridY-step)*(gridX+1)+i+next_step);
-            }
-        }else
+    //reserved for the skirts too, which are made from the vertices of the grid
+    _vertices.reserve(width*height + 2*(width+height));
+    for(int i =0;i<height;++i)
+    {
+        for(int j =0;j<width;j++)
         {
-            for(int i =step;i<gridX-step;i+=step)
-            {
-                _lod[_currentLod]._indices.push_back((gridY-step)*(gridX+1)+i);
-                _lod[_currentLod]._indices.push_back(gridY*(gridX+1)+i);
-                _lod[_currentLod]._indices.push_back((gridY-step)*(gridX+1)+i+step);
+            int x = _posX*_size.width + j;
+            int y = _posY*_size.height + i;
+            TerrainVertexData v;
+            v._position = positionAt(i, j);
+            v._texcoord = Tex2F(x*1.0/_imageWidth,y*1.0/_imageHeight);
+            _vertices.push_back (v);
+        }
+    }
 
-                _lod[_currentLod]._indices.push_back((gridY-step)*(gridX+1)+i+step);
-                _lod[_currentLod]._indices.push_back(gridY*(gridX+1)+i);
-                _lod[_currentLod]._indices.push_back(gridY*(gridX+1)+i+step);
-            }
+    //the same triangles as calculateNormal, over the apron too, so that both tiles sharing a border get the normals of the whole terrain.
+    //the triangles missing a height, at the borders of the terrain, are left out
+    auto addTriangleNormal = [&](int i0, int j0, int i1, int j1, int i2, int j2) {
+        if (!hasHeight[(i0 + 1)*apronWidth + j0 + 1] || !hasHeight[(i1 + 1)*apronWidth + j1 + 1] || !hasHeight[(i2 + 1)*apronWidth + j2 + 1])
+        {
+            return;
         }
-        if(_back&&_back->_currentLod > _currentLod)//back
+        Vec3 p0 = positionAt(i0, j0);
+        Vec3 normal;
+        Vec3::cross(positionAt(i1, j1) - p0, positionAt(i2, j2) - p0, &normal);
+        normal.normalize();
+        int vertices[3][2] = {{i0, j0}, {i1, j1}, {i2, j2}};
+        for (auto& vertex : vertices)
         {
-            for(int i =0;i<gridX;i+=next_step)
+            if (vertex[0] >= 0 && vertex[0] < height && vertex[1] >= 0 && vertex[1] < width)
             {
-                _lod[_currentLod]._indices.push_back(i);
-                _lod[_currentLod]._indices.push_back(step*(gridX+1) +i);
-                _lod[_currentLod]._indices.push_back(step*(gridX+1) +i+step);
-
-                _lod[_currentLod]._indices.push_back(i);
-                _lod[_currentLod]._indices.push_back(step*(gridX+1) +i+step);
-                _lod[_currentLod]._indices.push_back(i+next_step);
-
-                _lod[_currentLod]._indices.push_back(i+next_step);
-                _lod[_currentLod]._indices.push_back(step*(gridX+1) +i+step);
-                _lod[_currentLod]._indices.push_back(step*(gridX+1) +i+next_step);
-            }
-        }else{
-            for(int i =step;i<gridX-step;i+=step)
-            {
-                _lod[_currentLod]._indices.push_back(i);
-                _lod[_currentLod]._indices.push_back(step*(gridX+1)+i);
-                _lod[_currentLod]._indices.push_back(step*(gridX+1)+i+step);
-
-                _lod[_currentLod]._indices.push_back(i);
-                _lod[_currentLod]._indices.push_back(step*(gridX+1)+i+step);
-                _lod[_currentLod]._indices.push_back(i+step);
+                _vertices[vertex[0]*width + vertex[1]]._normal += normal;
             }
         }
-
-        _chunkIndices = _terrain->insertIndicesLOD(currentNeighborLOD,_currentLod,&_lod[_currentLod]._indices[0],(int)_lod[_currentLod]._indices.size());
-    }else{
-        //No lod difference, use simple method
-        _lod[_currentLod]._indices.clear();
-        for(int i =0;i<gridY;i+=step)
+    };
+    for (int i = -1; i < height; ++i)
+    {
+        for (int j = -1; j < width; ++j)
         {
-            for(int j = 0;j<gridX;j+=step)
-            {
+            addTriangleNormal(i, j, i + 1, j, i, j + 1);
+            addTriangleNormal(i, j + 1, i + 1, j, i + 1, j + 1);
+        }
+    }
+    for (auto& vertex : _vertices)
+    {
+        vertex._normal.normalize();
+    }
 
-                int nLocIndex = i * (gridX+1) + j;
-                _lod[_currentLod]._indices.push_back (nLocIndex);
-                _lod[_currentLod]._indices.push_back (nLocIndex + step * (gridX+1));
-                _lod[_currentLod]._indices.push_back (nLocIndex + step);
+    if (_crackFixedType == CrackFixedType::SKIRT)
+    {
+        //made apart, appending to _vertices while reading the grid from it could move it
+        std::vector<TerrainVertexData> skirts;
+        int skirtVerticesOffset[4];
+        Chunk::appendSkirts(&_vertices[0], width, _size, _skirtHeight, skirts, skirtVerticesOffset);
+        _vertices.insert(_vertices.end(), skirts.begin(), skirts.end());
+    }
+    _slope = Chunk::calculateSlope(_vertices);
+    _loaded = true;
+}
 
-                _lod[_currentLod]._indices.push_back (nLocIndex + step);
-                _lod[_currentLod]._indices.push_back (nLocIndex + step * (gridX+1));
-                _lod[_currentLod]._indices.push_back (nLocIndex + step * (gridX+1) + step);
-            }
-        }
-        _chunkIndices = _terrain->insertIndicesLOD(currentNeighborLOD,_currentLod,&_lod[_currentLod]._indices[0],(int)_lod[_currentLod]._indices.size());
+Terrain::Chunk::Chunk()
+{
+    _vbo = 0;
+    _pageState = PageState::UNLOADED;
+    _currentLod = 0;
+    _left = nullptr;
+    _right = nullptr;
+    _back = nullptr;
+    _front = nullptr;
+    _oldLod = -1;
+    _oldNeighborMask = -1;
+    _verticesLod = 0;
+    _verticesDirty = false;
+}
+
+void Terrain::Chunk::updateIndicesLOD()
+{
+    int neighborMask = 0;
+    if(_left && _left->_currentLod > _currentLod) neighborMask |= NEIGHBOR_LEFT;
+    if(_right && _right->_currentLod > _currentLod) neighborMask |= NEIGHBOR_RIGHT;
+    if(_back && _back->_currentLod > _currentLod) neighborMask |= NEIGHBOR_BACK;
+    if(_front && _front->_currentLod > _currentLod) neighborMask |= NEIGHBOR_FRONT;
+
+    if(_oldLod == _currentLod && _oldNeighborMask == neighborMask)
+    {
+        return;// no need to update
     }
+    _oldLod = _currentLod;
+    _oldNeighborMask = neighborMask;
+    _chunkIndices = _terrain->_chunkLodIndices[_currentLod][neighborMask];
 }
 
 void Terrain::Chunk::calculateAABB()
@@ -1303,29 +1753,26 @@ void Terrain::Chunk::calculateAABB()
     _aabb.updateMinMax(&pos[0],pos.size());
 }
 
-void Terrain::Chunk::calculateSlope()
+float Terrain::Chunk::calculateSlope(const std::vector<TerrainVertexData>& vertices)
 {
     //find max slope
-    auto lowest = _originalVertices[0]._position;
-    for(size_t i = 0, size = _originalVertices.size(); i < size; ++i)
+    auto lowest = vertices[0]._position;
+    auto highest = vertices[0]._position;
+    for(size_t i = 0, size = vertices.size(); i < size; ++i)
     {
-        if(_originalVertices[i]._position.y< lowest.y)
+        if(vertices[i]._position.y< lowest.y)
         {
-            lowest = _originalVertices[i]._position;
+            lowest = vertices[i]._position;
         }
-    }
-    auto highest = _originalVertices[0]._position;
-    for(size_t i = 0, size = _originalVertices.size(); i < size; ++i)
-    {
-        if(_originalVertices[i]._position.y> highest.y)
+        if(vertices[i]._position.y> highest.y)
         {
-            highest = _originalVertices[i]._position;
+            highest = vertices[i]._position;
         }
     }
     Vec2 a(lowest.x,lowest.z);
     Vec2 b(highest.x,highest.z);
     float dist = a.distance(b);
-    _slope = (highest.y - lowest.y)/dist;
+    return (highest.y - lowest.y)/dist;
 }
 
 bool Terrain::Chunk::getIntersectPointWithRay(const Ray& ray, Vec3& intersectPoint)
@@ -1360,123 +1807,58 @@ bool Terrain::Chunk::getInsterctPointWithRay(const Ray& ray, Vec3& intersectPoin
 
 void Terrain::Chunk::updateVerticesForLOD()
 {
-    if(_oldLod == _currentLod){ return;} // no need to update vertices
+    //only the steep chunks are smoothed, at the coarse LODs
+    int verticesLod = (_currentLod >= 2 && std::abs(_slope) > 1.2f) ? _currentLod : 0;
+    if(_verticesLod == verticesLod){ return;} // no need to update vertices
+    _verticesLod = verticesLod;
+    _verticesDirty = true;
+    if(verticesLod == 0)
+    {
+        std::vector<TerrainVertexData>().swap(_currentVertices);
+        return;
+    }
     _currentVertices = _originalVertices;
     int gridY = _size.height;
     int gridX = _size.width;
 
-    if (_currentLod >= 2 && std::abs(_slope) > 1.2f)
-    {
-        int step = 1<<_currentLod;
-        for(int i =step;i<gridY-step;i+=step)
-            for(int j = step; j<gridX-step;j+=step)
+    int step = 1<<_currentLod;
+    for(int i =step;i<gridY-step;i+=step)
+        for(int j = step; j<gridX-step;j+=step)
+        {
+            // use linear-sample adjust vertices height
+            float height = 0;
+            float count = 0;
+            for(int n = i-step/2;n<i+step/2;n++)
             {
-                // use linear-sample adjust vertices height
-                float height = 0;
-                float count = 0;
-                for(int n = i-step/2;n<i+step/2;n++)
+                for(int m = j-step/2;m<j+step/2;m++)
                 {
-                    for(int m = j-step/2;m<j+step/2;m++)
-                    {
-                        float weight = (step/2 - std::abs(n-i))*(step/2 - std::abs(m-j));
-                        height += _originalVertices[m*(gridX+1)+n]._position.y;
-                        count += weight;
-                    }
+                    float weight = (step/2 - std::abs(n-i))*(step/2 - std::abs(m-j));
+                    height += _originalVertices[m*(gridX+1)+n]._position.y;
+                    count += weight;
                 }
-                _currentVertices[i*(gridX+1)+j]._position.y = height/count;
             }
-    }
+            _currentVertices[i*(gridX+1)+j]._position.y = height/count;
+        }
+}
 
-    glBufferData(GL_ARRAY_BUFFER, sizeof(TerrainVertexData)*_currentVertices.size(), &_currentVertices[0], GL_STREAM_DRAW);
-    _oldLod = _currentLod;
+void Terrain::Chunk::uploadVertices()
+{
+    if(!_verticesDirty) return;
+    auto& vertices = _currentVertices.empty() ? _originalVertices : _currentVertices;
+    glBufferData(GL_ARRAY_BUFFER, sizeof(TerrainVertexData)*vertices.size(), &vertices[0], GL_STREAM_DRAW);
+    _verticesDirty = false;
 }
 
 Terrain::Chunk::~Chunk()
 {
-    glDeleteBuffers(1,&_vbo);
+    unloadPage();
 }
 
 void Terrain::Chunk::updateIndicesLODSkirt()
 {
     if(_oldLod == _currentLod) return;
     _oldLod = _currentLod;
-    bool isOk;
-    _chunkIndices =  _terrain->lookForIndicesLODSkrit(_currentLod,&isOk);
-    if(isOk) return;
-
-    int gridY = _size.height;
-    int gridX = _size.width;
-    int step = 1<<_currentLod;
-    int k =0;
-    for(int i =0;i<gridY;i+=step,k+=step)
-    {
-        for(int j = 0;j<gridX;j+=step)
-        {
-            int nLocIndex = i * (gridX+1) + j;
-            _lod[_currentLod]._indices.push_back (nLocIndex);
-            _lod[_currentLod]._indices.push_back (nLocIndex + step * (gridX+1));
-            _lod[_currentLod]._indices.push_back (nLocIndex + step);
-
-            _lod[_currentLod]._indices.push_back (nLocIndex + step);
-            _lod[_currentLod]._indices.push_back (nLocIndex + step * (gridX+1));
-            _lod[_currentLod]._indices.push_back (nLocIndex + step * (gridX+1) + step);
-        }
-    }
-    //add skirt
-    //#1
-    for(int i =0;i<gridY;i+=step)
-    {
-        int nLocIndex = i * (gridX+1) + gridX;
-        _lod[_currentLod]._indices.push_back (nLocIndex);
-        _lod[_currentLod]._indices.push_back (nLocIndex + step * (gridX+1));
-        _lod[_currentLod]._indices.push_back ((gridY+1) *(gridX+1)+i);
-
-        _lod[_currentLod]._indices.push_back ((gridY+1) *(gridX+1)+i);
-        _lod[_currentLod]._indices.push_back (nLocIndex + step * (gridX+1));
-        _lod[_currentLod]._indices.push_back ((gridY+1) *(gridX+1)+i+step);
-    }
-
-    //#2
-    for(int j =0;j<gridX;j+=step)
-    {
-        int nLocIndex = (gridY)* (gridX+1) + j;
-        _lod[_currentLod]._indices.push_back (nLocIndex);
-        _lod[_currentLod]._indices.push_back (_terrain->_skirtVerticesOffset[1] +j);
-        _lod[_currentLod]._indices.push_back (nLocIndex + step);
-
-        _lod[_currentLod]._indices.push_back (nLocIndex + step);
-        _lod[_currentLod]._indices.push_back (_terrain->_skirtVerticesOffset[1] +j);
-        _lod[_currentLod]._indices.push_back (_terrain->_skirtVerticesOffset[1] +j + step);
-    }
-
-    //#3
-    for(int i =0;i<gridY;i+=step)
-    {
-        int nLocIndex = i * (gridX+1);
-        _lod[_currentLod]._indices.push_back (nLocIndex);
-        _lod[_currentLod]._indices.push_back (_terrain->_skirtVerticesOffset[2]+i);
-        _lod[_currentLod]._indices.push_back ((i+step)*(gridX+1));
-
-        _lod[_currentLod]._indices.push_back ((i+step)*(gridX+1));
-        _lod[_currentLod]._indices.push_back (_terrain->_skirtVerticesOffset[2]+i);
-        _lod[_currentLod]._indices.push_back (_terrain->_skirtVerticesOffset[2]+i +step);
-    }
-
-    //#4
-    for(int j =0;j<gridX;j+=step)
-    {
-        int nLocIndex = j;
-        _lod[_currentLod]._indices.push_back (nLocIndex + step);
-        _lod[_currentLod]._indices.push_back (_terrain->_skirtVerticesOffset[3]+j);
-        _lod[_currentLod]._indices.push_back (nLocIndex);
-
-
-        _lod[_currentLod]._indices.push_back (_terrain->_skirtVerticesOffset[3] + j + step);
-        _lod[_currentLod]._indices.push_back (_terrain->_skirtVerticesOffset[3] +j);
-        _lod[_currentLod]._indices.push_back (nLocIndex + step);
-    }
-
-    _chunkIndices = _terrain->insertIndicesLODSkirt(_currentLod,&_lod[_currentLod]._indices[0], (int)_lod[_currentLod]._indices.size());
+    _chunkIndices = _terrain->_chunkLodIndicesSkirt[_currentLod];
 }
 
 Terrain::QuadTree::QuadTree(int x, int y, int w, int h, Terrain * terrain)
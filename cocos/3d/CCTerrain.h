@@ -25,6 +25,7 @@ THE SOFTWARE.
 #ifndef CC_TERRAIN_H
 #define CC_TERRAIN_H
 
+#include <memory>
 #include <vector>
 
 #include "2d/CCNode.h"
@@ -33,9 +34,11 @@ THE SOFTWARE.
 #include "renderer/CCCustomCommand.h"
 #include "renderer/CCRenderState.h"
 #include "3d/CCAABB.h"
+#include "3d/CCAABBTree.h"
 #include "3d/CCRay.h"
 #include "base/CCEventListenerCustom.h"
 #include "base/CCEventDispatcher.h"
+#include "base/CCAsyncTaskPool.h"
 
 NS_CC_BEGIN
 
@@ -84,6 +87,11 @@ NS_CC_BEGIN
     * 
     * We can use ray-terrain intersection to pick a point of the terrain;
     * Also we can get an arbitrary point of the terrain's height and normal vector for convenience .
+    *
+    * Large terrains can be paged: the heightmap is split into one image per chunk, see TerrainData::_heightMapTileFormat.
+    * The chunks are then loaded on worker threads as the camera comes closer than the page load distance,
+    * and freed when it goes farther than the page unload distance. Only the loaded chunks are drawn,
+    * picked and give their heights.
     **/
 class CC_DLL Terrain : public Node
 {
@@ -158,6 +166,14 @@ public:
         int _detailMapAmount;
         /**the skirt height ratio, only effect when terrain use skirt to fix crack*/
         float _skirtHeightRatio;
+        /**
+        * the path format of the heightmap tiles of a paged terrain, given the X and Y index of the tile, e.g. "terrain/height_%d_%d.png".
+        * each tile is the heightmap of one chunk, so its size is (_chunkSize.width + 1) x (_chunkSize.height + 1) and it shares its border pixels with its neighbors.
+        * when it is set, _heightMapSrc isn't used.
+        */
+        std::string _heightMapTileFormat;
+        /**the amount of tiles of a paged terrain in X and Y, the same power of two in both directions*/
+        Size _tileCount;
     };
 private:
 
@@ -167,17 +183,14 @@ private:
         unsigned short _size;
     };
 
-    struct ChunkLODIndices
+    /**the neighbors of a chunk which have a greater LOD, the border of the chunk is stitched to theirs*/
+    enum NeighborMask
     {
-        int _relativeLod[5];
-        ChunkIndices _chunkIndices;
-    };
-
-
-    struct ChunkLODIndicesSkirt
-    {
-        int _selfLod;
-        ChunkIndices _chunkIndices;
+        NEIGHBOR_LEFT = 1,
+        NEIGHBOR_RIGHT = 2,
+        NEIGHBOR_BACK = 4,
+        NEIGHBOR_FRONT = 8,
+        NEIGHBOR_MASK_COUNT = 16,
     };
     /*
     *terrain vertices internal data format
@@ -197,6 +210,38 @@ private:
         cocos2d::Vec3 _normal;
     };
 
+    /*
+    *the data of a chunk of a paged terrain, loaded on a worker thread
+    **/
+    struct ChunkPage
+    {
+        /*the heightmap tile*/
+        std::string _path;
+        /*
+        *the tiles around it, indexed by [dy + 1][dx + 1], empty when there is none.
+        *a one pixel apron is read from them, so that the normals of the borders match the neighbors
+        */
+        std::string _neighborPaths[3][3];
+        int _posX;
+        int _posY;
+        Size _size;
+        int _imageWidth;
+        int _imageHeight;
+        float _mapHeight;
+        float _mapScale;
+        CrackFixedType _crackFixedType;
+        float _skirtHeight;
+        /*the vertices of the chunk, as Chunk::generate makes them*/
+        std::vector<TerrainVertexData> _vertices;
+        float _slope;
+        bool _loaded;
+        /*set when the chunk doesn't want the page anymore*/
+        bool _discarded;
+
+        /**loads the tile and makes the vertices, thread safe*/
+        void load();
+    };
+
     struct CC_DLL QuadTree;
     /*
     *the terminal node of quad, use to subdivision terrain mesh and LOD
@@ -209,36 +254,45 @@ private:
         ~Chunk();
         /*vertices*/
         std::vector<TerrainVertexData> _originalVertices;
-        /*LOD indices*/
-        struct LOD{
-            std::vector<GLushort> _indices;
-        };
         GLuint _vbo;
+        /**the indices of the current LOD, shared by the chunks*/
         ChunkIndices _chunkIndices; 
-        /**we now support four levels of detail*/
-        LOD _lod[4];
         /**AABB in local space*/
         AABB _aabb;
         /**setup Chunk data*/
         void generate(int map_width, int map_height, int m, int n, const unsigned char * data);
+        /**store the triangles used by the ray intersection*/
+        void generateTriangles();
+        /**append the vertices of the four skirts, grid is the top left vertex of the chunk in a grid of gridWidth vertices per row*/
+        static void appendSkirts(const TerrainVertexData * grid, int gridWidth, const Size& size, float skirtHeight,
+                                 std::vector<TerrainVertexData>& vertices, int skirtVerticesOffset[4]);
         /**calculateAABB*/
         void calculateAABB();
         /**internal use draw function*/
         void bindAndDraw();
         /**finish opengl setup*/
         void finish();
-        /*use linear-sample vertices for LOD mesh*/
+        /*use linear-sample vertices for LOD mesh, thread safe*/
         void updateVerticesForLOD();
+        /*upload the vertices updated for the LOD*/
+        void uploadVertices();
         /*updateIndices */
         void updateIndicesLOD();
 
         void updateIndicesLODSkirt();
 
         /**calculate the average slop of chunk*/
-        void calculateSlope();
+        static float calculateSlope(const std::vector<TerrainVertexData>& vertices);
 
         bool getIntersectPointWithRay(const Ray& ray, Vec3& intersectPoint);
 
+        /**loads the page of the chunk on a worker thread*/
+        void loadPage();
+        /**sets the chunk up with its loaded page*/
+        void onPageLoaded();
+        /**cancels the loading of the page or frees the loaded one*/
+        void unloadPage();
+
         /** @deprecated Use getIntersectPointWithRay instead. */
         CC_DEPRECATED_ATTRIBUTE bool getInsterctPointWithRay(const Ray& ray, Vec3& intersectPoint);
 
@@ -247,7 +301,12 @@ private:
 
         int _oldLod;
 
-        int _neighborOldLOD[4];
+        int _oldNeighborMask;
+
+        /**the LOD the vertices are linear-sampled for, 0 if they are the original ones*/
+        int _verticesLod;
+        /**whether the vertices changed since they were uploaded*/
+        bool _verticesDirty;
         /*the left,right,front,back neighbors*/
         Chunk * _left;
         Chunk * _right;
@@ -269,6 +328,17 @@ private:
         std::vector<TerrainVertexData> _currentVertices;
 
         std::vector<Triangle> _trianglesList;
+
+        /**whether the chunk of a paged terrain is unloaded, loading or loaded*/
+        enum class PageState
+        {
+            UNLOADED,
+            LOADING,
+            LOADED,
+        };
+        PageState _pageState;
+        std::shared_ptr<ChunkPage> _page;
+        AsyncTaskPool::TaskHandle _pageTask;
     };
 
    /**
@@ -436,9 +506,28 @@ public:
     
     /**
      * get the terrain's height data
+     * @note the heights of the unloaded chunks of a paged terrain are 0.
      */
     std::vector<float> getHeightData() const;
 
+    /**
+     * whether the terrain is paged, see TerrainData::_heightMapTileFormat.
+     */
+    bool isPaged() const { return !_terrainData._heightMapTileFormat.empty(); }
+
+    /**
+     * Set the distances to the camera under which the chunks of a paged terrain are loaded,
+     * and over which they are freed. unloadDistance should be greater than loadDistance so that
+     * the chunks at the limit aren't loaded and freed over and over.
+     * @note when invoke initHeightMap, the distances will be automatic calculated.
+     */
+    void setPageDistance(float loadDistance, float unloadDistance);
+
+    /**
+     * whether the heights at the position (X,Z) are loaded, which is always the case if the terrain isn't paged.
+     */
+    bool isHeightLoaded(float x, float z) const;
+
 CC_CONSTRUCTOR_ACCESS:
     Terrain();
     virtual ~Terrain();
@@ -462,8 +551,30 @@ protected:
      **/
     void calculateNormal();
 
+    /**
+     * calculate the normals of a grid of vertices
+     **/
+    static void calculateNormal(std::vector<TerrainVertexData>& vertices, int width, int height);
+
+    /**
+     * initialize the chunks of a paged terrain, which are loaded later.
+     **/
+    bool initPagedHeightMap();
+
+    /**
+     * link the chunks to their neighbors, and build the quad tree.
+     **/
+    void setupChunks(int chunkAmountX, int chunkAmountY);
+
+    /**
+     * load the chunks of a paged terrain close to the camera, and free the far ones.
+     * @param cameraPos the camera position in world space
+     **/
+    void updatePages(const Vec3& cameraPos);
+
     //override
     virtual void onEnter() override;
+    virtual void onExit() override;
 
     /**
      * cache all uniform locations in GLSL.
@@ -471,25 +582,32 @@ protected:
     void cacheUniformAttribLocation();
 
     //IBO generate & cache
-    ChunkIndices lookForIndicesLODSkrit(int selfLod, bool * result);
+    /**
+     * create the indices of every LOD and neighbor mask, shared by all the chunks.
+     **/
+    void initIndicesLOD();
 
-    ChunkIndices lookForIndicesLOD(int neighborLod[4], int selfLod, bool * result);
+    void releaseIndicesLOD();
 
-    ChunkIndices insertIndicesLOD(int neighborLod[4], int selfLod, GLushort * indices, int size);
+    void generateIndicesLOD(int lod, int neighborMask, std::vector<GLushort>& indices) const;
 
-    ChunkIndices insertIndicesLODSkirt(int selfLod, GLushort * indices, int size);
+    void generateIndicesLODSkirt(int lod, std::vector<GLushort>& indices) const;
     
     Chunk * getChunkByIndex(int x,int y) const;
 
+    Chunk * getChunkByPixel(int pixelX, int pixelY) const;
+
 protected:
-    std::vector <ChunkLODIndices> _chunkLodIndicesSet;
-    std::vector<ChunkLODIndicesSkirt> _chunkLodIndicesSkirtSet;
+    ChunkIndices _chunkLodIndices[4][NEIGHBOR_MASK_COUNT];
+    ChunkIndices _chunkLodIndicesSkirt[4];
     Mat4 _CameraMatrix;
     bool _isCameraViewChanged;
     TerrainData _terrainData;
     bool _isDrawWire;
     unsigned char * _data;
     float _lodDistance[3];
+    float _pageLoadDistance;
+    float _pageUnloadDistance;
     Texture2D * _detailMapTextures[4];
     Texture2D * _alphaMap;
     Texture2D * _lightMap;
@@ -507,6 +625,7 @@ protected:
     cocos2d::Image * _heightMapImage;
     Mat4 _oldCameraModelMatrix;
     Mat4 _terrainModelMatrix;
+    AABBTreeProxy _aabbTreeProxy; // culls the whole terrain through the tree of the scene
     GLuint _normalLocation;
     GLuint _positionLocation;
     GLuint _texcoordLocation;
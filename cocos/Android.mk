@@ -65,9 +65,12 @@ cocos2d.cpp \
 2d/CCNodeGrid.cpp \
 2d/CCParallaxNode.cpp \
 2d/CCParticleBatchNode.cpp \
+2d/CCParticleDefinition.cpp \
 2d/CCParticleExamples.cpp \
+2d/CCParticleKernels.cpp \
 2d/CCParticleSystem.cpp \
 2d/CCParticleSystemQuad.cpp \
+2d/CCParticleSystemGPU.cpp \
 2d/CCProgressTimer.cpp \
 2d/CCProtectedNode.cpp \
 2d/CCRenderTexture.cpp \
@@ -76,6 +79,7 @@ cocos2d.cpp \
 2d/CCSpriteBatchNode.cpp \
 2d/CCSpriteFrame.cpp \
 2d/CCSpriteFrameCache.cpp \
+2d/CCSpriteSheet.cpp \
 2d/CCTMXLayer.cpp \
 2d/CCTMXObjectGroup.cpp \
 2d/CCTMXTiledMap.cpp \
@@ -89,9 +93,12 @@ cocos2d.cpp \
 2d/CCAutoPolygon.cpp \
 3d/CCFrustum.cpp \
 3d/CCPlane.cpp \
+platform/CCAssetPack.cpp \
+platform/CCFileLoadBatch.cpp \
 platform/CCFileUtils.cpp \
 platform/CCGLView.cpp \
 platform/CCImage.cpp \
+platform/CCMappedFile.cpp \
 platform/CCInput.cpp \
 platform/CCSAXParser.cpp \
 platform/CCThread.cpp \
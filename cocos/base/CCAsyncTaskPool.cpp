@@ -26,10 +26,23 @@ THE SOFTWARE.
 
 #include "base/CCAsyncTaskPool.h"
 
+#include <algorithm>
+#include <chrono>
+
 NS_CC_BEGIN
 
 AsyncTaskPool* AsyncTaskPool::s_asyncTaskPool = nullptr;
 
+AsyncTaskPool::Task::Task(std::function<void()> work, std::function<void()> completion, Priority priority)
+: _work(std::move(work))
+, _completion(std::move(completion))
+, _priority(priority)
+, _cancelled(false)
+, _done(false)
+, _pendingDependencies(1)
+{
+}
+
 AsyncTaskPool* AsyncTaskPool::getInstance()
 {
     if (s_asyncTaskPool == nullptr)
@@ -46,11 +59,457 @@ void AsyncTaskPool::destroyInstance()
 }
 
 AsyncTaskPool::AsyncTaskPool()
+: _queuedCount(0)
+, _stop(false)
+, _completionBudget(0.004f)
 {
+    for (auto& serialQueue : _serialQueues)
+    {
+        serialQueue.stop = false;
+    }
+
+    // the main thread keeps running, leave it a core
+    unsigned int workerCount = std::max(std::thread::hardware_concurrency(), 3u) - 1;
+
+    // workers don't look up their index before the map is complete
+    std::lock_guard<std::mutex> lock(_sharedMutex);
+    for (unsigned int i = 0; i < workerCount; ++i)
+    {
+        _workers.emplace_back(new Worker());
+        _workers.back()->thread = std::thread(&AsyncTaskPool::workerLoop, this, (int)i);
+        _workerIndices[_workers.back()->thread.get_id()] = (int)i;
+    }
 }
 
 AsyncTaskPool::~AsyncTaskPool()
 {
+    // the tasks of the types run first, they may submit tasks to the workers
+    for (auto& serialQueue : _serialQueues)
+    {
+        {
+            std::lock_guard<std::mutex> lock(serialQueue.mutex);
+            serialQueue.stop = true;
+        }
+        serialQueue.condition.notify_all();
+        if (serialQueue.thread.joinable())
+            serialQueue.thread.join();
+    }
+
+    // the workers stop once no task is queued, the tasks released by the last ones run too
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _stop = true;
+    }
+    _sleepCondition.notify_all();
+
+    for (auto& worker : _workers)
+    {
+        worker->thread.join();
+    }
+
+    // nobody is left to post completions, run them now rather than dropping them
+    for (auto& completion : _completions)
+    {
+        completion();
+    }
+    _completions.clear();
+}
+
+void AsyncTaskPool::stopTasks(TaskType type)
+{
+    auto& serialQueue = _serialQueues[(int)type];
+    std::lock_guard<std::mutex> lock(serialQueue.mutex);
+    while (!serialQueue.entries.empty())
+        serialQueue.entries.pop();
+}
+
+void AsyncTaskPool::enqueue(AsyncTaskPool::TaskType type, TaskCallBack callback, void* callbackParam, std::function<void()> task)
+{
+    SerialQueue::Entry entry;
+    entry.task = std::move(task);
+    entry.callback = std::move(callback);
+    entry.callbackParam = callbackParam;
+
+    auto& serialQueue = _serialQueues[(int)type];
+    {
+        std::lock_guard<std::mutex> lock(serialQueue.mutex);
+        serialQueue.entries.push(std::move(entry));
+        if (!serialQueue.thread.joinable())
+        {
+            serialQueue.thread = std::thread(&AsyncTaskPool::runSerialQueue, this, type);
+        }
+    }
+    serialQueue.condition.notify_one();
+}
+
+void AsyncTaskPool::runSerialQueue(TaskType type)
+{
+    auto& serialQueue = _serialQueues[(int)type];
+    for (;;)
+    {
+        SerialQueue::Entry entry;
+        {
+            std::unique_lock<std::mutex> lock(serialQueue.mutex);
+            serialQueue.condition.wait(lock, [&serialQueue] { return serialQueue.stop || !serialQueue.entries.empty(); });
+            // the tasks enqueued before the pool is destroyed still run
+            if (serialQueue.entries.empty())
+                return;
+            entry = std::move(serialQueue.entries.front());
+            serialQueue.entries.pop();
+        }
+
+        entry.task();
+        if (entry.callback)
+        {
+            addCompletion(std::bind(entry.callback, entry.callbackParam));
+        }
+    }
+}
+
+AsyncTaskPool::TaskHandle AsyncTaskPool::submit(std::function<void()> work, std::function<void()> completion, Priority priority)
+{
+    return submitAfter(std::vector<TaskHandle>(), std::move(work), std::move(completion), priority);
+}
+
+AsyncTaskPool::TaskHandle AsyncTaskPool::submitAfter(const std::vector<TaskHandle>& dependencies, std::function<void()> work,
+                                                     std::function<void()> completion, Priority priority)
+{
+    TaskHandle task(new Task(std::move(work), std::move(completion), priority));
+
+    for (const auto& dependency : dependencies)
+    {
+        if (!dependency)
+            continue;
+
+        std::lock_guard<std::mutex> lock(dependency->_mutex);
+        if (dependency->isDone())
+        {
+            if (dependency->isCancelled())
+                task->cancel();
+        }
+        else
+        {
+            ++task->_pendingDependencies;
+            dependency->_continuations.push_back(task);
+        }
+    }
+
+    release(task);
+    return task;
+}
+
+void AsyncTaskPool::release(const TaskHandle& task)
+{
+    if (--task->_pendingDependencies != 0)
+        return;
+
+    if (task->isCancelled())
+    {
+        // nothing to run, finish it right away so its continuations are cancelled too
+        execute(task);
+    }
+    else
+    {
+        schedule(task);
+    }
+}
+
+void AsyncTaskPool::schedule(TaskHandle task)
+{
+    int priority = (int)task->_priority;
+    int workerIndex = getCurrentWorkerIndex();
+    if (workerIndex >= 0)
+    {
+        auto& worker = *_workers[workerIndex];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.queues[priority].push_back(std::move(task));
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(_sharedMutex);
+        _sharedQueues[priority].push_back(std::move(task));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        ++_queuedCount;
+    }
+    _sleepCondition.notify_one();
+}
+
+void AsyncTaskPool::execute(const TaskHandle& task)
+{
+    if (!task->isCancelled())
+    {
+        task->_work();
+    }
+    task->_work = nullptr;
+
+    std::vector<TaskHandle> continuations;
+    {
+        std::lock_guard<std::mutex> lock(task->_mutex);
+        task->_done.store(true, std::memory_order_release);
+        continuations.swap(task->_continuations);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_doneMutex);
+    }
+    _doneCondition.notify_all();
+
+    if (task->_completion)
+    {
+        if (!task->isCancelled())
+        {
+            addCompletion(std::move(task->_completion));
+        }
+        task->_completion = nullptr;
+    }
+
+    for (const auto& continuation : continuations)
+    {
+        if (task->isCancelled())
+            continuation->cancel();
+        release(continuation);
+    }
+}
+
+AsyncTaskPool::TaskHandle AsyncTaskPool::findTask(int workerIndex)
+{
+    TaskHandle task;
+    int workerCount = (int)_workers.size();
+
+    for (int priority = 0; priority < (int)Priority::MAX_PRIORITY && !task; ++priority)
+    {
+        // newest task of our own queue first, it's likely to use what we just touched
+        if (workerIndex >= 0)
+        {
+            auto& worker = *_workers[workerIndex];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            auto& queue = worker.queues[priority];
+            if (!queue.empty())
+            {
+                task = std::move(queue.back());
+                queue.pop_back();
+                break;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_sharedMutex);
+            auto& queue = _sharedQueues[priority];
+            if (!queue.empty())
+            {
+                task = std::move(queue.front());
+                queue.pop_front();
+                break;
+            }
+        }
+
+        // steal the oldest task of another worker
+        for (int i = 1; i <= workerCount; ++i)
+        {
+            int victim = (std::max(workerIndex, 0) + i) % workerCount;
+            if (victim == workerIndex)
+                continue;
+
+            auto& worker = *_workers[victim];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            auto& queue = worker.queues[priority];
+            if (!queue.empty())
+            {
+                task = std::move(queue.front());
+                queue.pop_front();
+                break;
+            }
+        }
+    }
+
+    if (task)
+    {
+        --_queuedCount;
+    }
+    return task;
+}
+
+int AsyncTaskPool::getCurrentWorkerIndex() const
+{
+    auto iter = _workerIndices.find(std::this_thread::get_id());
+    return iter != _workerIndices.end() ? iter->second : -1;
+}
+
+void AsyncTaskPool::workerLoop(int workerIndex)
+{
+    {
+        // wait until the constructor filled _workerIndices
+        std::lock_guard<std::mutex> lock(_sharedMutex);
+    }
+
+    for (;;)
+    {
+        auto task = findTask(workerIndex);
+        if (task)
+        {
+            execute(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+        _sleepCondition.wait(lock, [this] { return _stop || _queuedCount > 0; });
+        if (_stop && _queuedCount == 0)
+            return;
+    }
+}
+
+void AsyncTaskPool::wait(const TaskHandle& task)
+{
+    if (!task)
+        return;
+
+    int workerIndex = getCurrentWorkerIndex();
+    while (!task->isDone())
+    {
+        // a worker waiting on another task keeps working, otherwise the pool could run out of workers
+        if (workerIndex >= 0)
+        {
+            auto other = findTask(workerIndex);
+            if (other)
+            {
+                execute(other);
+                continue;
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(_doneMutex);
+        if (workerIndex >= 0)
+        {
+            // tasks queued meanwhile don't wake us up, look for them again soon
+            _doneCondition.wait_for(lock, std::chrono::milliseconds(1), [&task] { return task->isDone(); });
+        }
+        else
+        {
+            _doneCondition.wait(lock, [&task] { return task->isDone(); });
+        }
+    }
+}
+
+void AsyncTaskPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& function)
+{
+    grain = std::max<size_t>(grain, 1);
+    size_t rangeCount = (count + grain - 1) / grain;
+    if (rangeCount <= 1)
+    {
+        if (count > 0)
+            function(0, count);
+        return;
+    }
+
+    // the tasks starting late find no range left and never call the function, which may be gone by then
+    struct Batch
+    {
+        const std::function<void(size_t, size_t)>* function;
+        size_t count;
+        size_t grain;
+        size_t rangeCount;
+        std::atomic<size_t> nextRange;
+        std::atomic<size_t> doneRanges;
+        // signalled by the thread finishing the last range
+        std::mutex mutex;
+        std::condition_variable condition;
+    };
+    auto batch = std::make_shared<Batch>();
+    batch->function = &function;
+    batch->count = count;
+    batch->grain = grain;
+    batch->rangeCount = rangeCount;
+    batch->nextRange = 0;
+    batch->doneRanges = 0;
+
+    auto runRanges = [](Batch& batch) {
+        for (size_t range = batch.nextRange++; range < batch.rangeCount; range = batch.nextRange++)
+        {
+            size_t begin = range * batch.grain;
+            (*batch.function)(begin, std::min(begin + batch.grain, batch.count));
+            if (++batch.doneRanges == batch.rangeCount)
+            {
+                std::lock_guard<std::mutex> lock(batch.mutex);
+                batch.condition.notify_all();
+            }
+        }
+    };
+
+    size_t taskCount = std::min(rangeCount - 1, _workers.size());
+    for (size_t i = 0; i < taskCount; ++i)
+    {
+        submit([batch, runRanges]() {
+            runRanges(*batch);
+        }, nullptr, Priority::HIGH);
+    }
+    runRanges(*batch);
+
+    // the ranges claimed by the workers may take long, e.g. if they are preempted: sleep, or keep a worker busy
+    int workerIndex = getCurrentWorkerIndex();
+    auto isDone = [&batch, rangeCount] { return batch->doneRanges == rangeCount; };
+    while (!isDone())
+    {
+        if (workerIndex >= 0)
+        {
+            auto other = findTask(workerIndex);
+            if (other)
+            {
+                execute(other);
+                continue;
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(batch->mutex);
+        if (workerIndex >= 0)
+        {
+            // tasks queued meanwhile don't wake us up, look for them again soon
+            batch->condition.wait_for(lock, std::chrono::milliseconds(1), isDone);
+        }
+        else
+        {
+            batch->condition.wait(lock, isDone);
+        }
+    }
+}
+
+void AsyncTaskPool::addCompletion(std::function<void()> completion)
+{
+    std::lock_guard<std::mutex> lock(_completionMutex);
+    _completions.push_back(std::move(completion));
+}
+
+void AsyncTaskPool::dispatchCompletions()
+{
+    if (s_asyncTaskPool)
+    {
+        s_asyncTaskPool->runCompletions();
+    }
+}
+
+void AsyncTaskPool::runCompletions()
+{
+    auto start = std::chrono::steady_clock::now();
+    auto budget = std::chrono::duration<float>(_completionBudget);
+
+    for (;;)
+    {
+        std::function<void()> completion;
+        {
+            std::lock_guard<std::mutex> lock(_completionMutex);
+            if (_completions.empty())
+                return;
+            completion = std::move(_completions.front());
+            _completions.pop_front();
+        }
+
+        completion();
+
+        if (_completionBudget > 0 && std::chrono::steady_clock::now() - start >= budget)
+            return;
+    }
 }
 
 NS_CC_END
@@ -31,6 +31,9 @@ THE SOFTWARE.
 #include "base/CCScheduler.h"
 #include <vector>
 #include <queue>
+#include <deque>
+#include <unordered_map>
+#include <atomic>
 #include <memory>
 #include <thread>
 #include <mutex>
@@ -49,6 +52,22 @@ NS_CC_BEGIN
 /**
  * @class AsyncTaskPool
  * @brief This class allows to perform background operations without having to manipulate threads.
+ *
+ * Tasks run on a work-stealing pool of worker threads sized to the hardware concurrency. Each worker
+ * has its own queues; tasks submitted from a worker (e.g. continuations) stay on its queues, the other
+ * tasks go to a shared queue, and idle workers steal from the others. Higher priority tasks always
+ * run first.
+ *
+ * Tasks may have dependencies, may be cancelled, and may have a completion callback. Completion
+ * callbacks run on the cocos thread, at most for the duration of the completion budget per frame,
+ * so that many tasks finishing together don't cause a frame hitch.
+ *
+ * The tasks enqueued with a TaskType keep their historical behavior: the tasks of one type run one
+ * at a time, in the order they were enqueued, on a thread of their own, so that blocking IO or network
+ * tasks don't hold the workers.
+ *
+ * When the pool is destroyed, the tasks already submitted or enqueued still run, and so do their
+ * completion callbacks.
  * @js NA
  */
 class CC_DLL AsyncTaskPool
@@ -64,6 +83,50 @@ public:
         TASK_MAX_TYPE,
     };
 
+    /** Priority of a task, higher priorities run first. */
+    enum class Priority
+    {
+        HIGH,
+        NORMAL,
+        LOW,
+        MAX_PRIORITY,
+    };
+
+    /**
+     * Handle of a submitted task.
+     */
+    class CC_DLL Task
+    {
+    public:
+        /**
+         * Cancels the task: if it isn't running yet, its work and completion callback won't run,
+         * and the tasks depending on it are cancelled too.
+         */
+        void cancel() { _cancelled = true; }
+
+        /** Whether the task was cancelled. */
+        bool isCancelled() const { return _cancelled; }
+
+        /** Whether the work of the task is finished (or was skipped because the task was cancelled). */
+        bool isDone() const { return _done.load(std::memory_order_acquire); }
+
+    private:
+        friend class AsyncTaskPool;
+
+        Task(std::function<void()> work, std::function<void()> completion, Priority priority);
+
+        std::function<void()> _work;
+        std::function<void()> _completion;
+        Priority _priority;
+        std::atomic<bool> _cancelled;
+        std::atomic<bool> _done;
+        // dependencies not finished yet, plus one while the task is being submitted
+        std::atomic<int> _pendingDependencies;
+        std::mutex _mutex;
+        std::vector<std::shared_ptr<Task>> _continuations;
+    };
+    typedef std::shared_ptr<Task> TaskHandle;
+
     /**
      * Returns the shared instance of the async task pool.
      */
@@ -87,7 +150,7 @@ public:
     /**
      * Enqueue a asynchronous task.
      *
-     * @param type task type is io task, network task or others, each type of task has a thread to deal with it.
+     * @param type task type is io task, network task or others, the tasks of a type run one after the other.
      * @param callback callback when the task is finished. The callback is called in the main thread instead of task thread.
      * @param callbackParam parameter used by the callback.
      * @param task: task can be lambda function to be performed off thread.
@@ -98,130 +161,142 @@ public:
     /**
     * Enqueue a asynchronous task.
     *
-    * @param type task type is io task, network task or others, each type of task has a thread to deal with it.
+    * @param type task type is io task, network task or others, the tasks of a type run one after the other.
     * @param task: task can be lambda function to be performed off thread.
     * @lua NA
     */
     void enqueue(AsyncTaskPool::TaskType type, std::function<void()> task);
+
+    /**
+     * Submits a task to the worker threads.
+     *
+     * @param work The work performed off thread.
+     * @param completion Optional callback called on the cocos thread once the work is done.
+     * @param priority The priority of the task.
+     * @return The handle of the task.
+     * @lua NA
+     */
+    TaskHandle submit(std::function<void()> work, std::function<void()> completion = nullptr, Priority priority = Priority::NORMAL);
+
+    /**
+     * Submits a task which runs once all its dependencies are done.
+     *
+     * @param dependencies The tasks to wait for, null handles are ignored.
+     * @param work The work performed off thread.
+     * @param completion Optional callback called on the cocos thread once the work is done.
+     * @param priority The priority of the task.
+     * @return The handle of the task.
+     * @lua NA
+     */
+    TaskHandle submitAfter(const std::vector<TaskHandle>& dependencies, std::function<void()> work,
+                           std::function<void()> completion = nullptr, Priority priority = Priority::NORMAL);
+
+    /**
+     * Blocks until the work of a task is done. The calling thread runs other tasks while it waits,
+     * so it is safe to wait from a task.
+     * @lua NA
+     */
+    void wait(const TaskHandle& task);
+
+    /**
+     * Runs a function over the ranges of [0, count) on the calling thread and on the workers, and
+     * returns once all of them are done. The calling thread doesn't wait for busy workers to start,
+     * the ranges are claimed by whichever thread is free, so it is safe to call from a task. While the
+     * last ranges finish, the calling thread sleeps, or runs other tasks if it is a worker.
+     *
+     * @param count The number of items.
+     * @param grain The number of items per range, the last range may be shorter.
+     * @param function Called with the beginning and the end of each range.
+     * @lua NA
+     */
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& function);
+
+    /** Number of worker threads. */
+    unsigned int getWorkerCount() const { return (unsigned int)_workers.size(); }
+
+    /**
+     * Sets the time spent at most per frame running completion callbacks on the cocos thread,
+     * at least one callback runs every frame. 0 means no limit.
+     *
+     * @param seconds The budget in seconds, 4ms by default.
+     */
+    void setCompletionBudget(float seconds) { _completionBudget = seconds; }
+
+    /** Gets the time spent at most per frame running completion callbacks. */
+    float getCompletionBudget() const { return _completionBudget; }
+
+    /**
+     * Runs the pending completion callbacks within the budget of the frame.
+     * Called by the Director every frame, it does nothing if the pool was never created.
+     * @lua NA
+     */
+    static void dispatchCompletions();
     
 CC_CONSTRUCTOR_ACCESS:
     AsyncTaskPool();
     ~AsyncTaskPool();
     
 protected:
-    
-    // thread tasks internally used
-    class ThreadTasks {
-        struct AsyncTaskCallBack
+    // tasks of a TaskType, run one at a time in order
+    struct SerialQueue
+    {
+        struct Entry
         {
-            TaskCallBack          callback;
-            void*                 callbackParam;
+            std::function<void()> task;
+            TaskCallBack callback;
+            void* callbackParam;
         };
-    public:
-        ThreadTasks()
-        : _stop(false)
-        {
-            _thread = std::thread(
-                                  [this]
-                                  {
-                                      for(;;)
-                                      {
-                                          std::function<void()> task;
-                                          AsyncTaskCallBack callback;
-                                          {
-                                              std::unique_lock<std::mutex> lock(this->_queueMutex);
-                                              this->_condition.wait(lock,
-                                                                    [this]{ return this->_stop || !this->_tasks.empty(); });
-                                              if(this->_stop && this->_tasks.empty())
-                                                  return;
-                                              task = std::move(this->_tasks.front());
-                                              callback = std::move(this->_taskCallBacks.front());
-                                              this->_tasks.pop();
-                                              this->_taskCallBacks.pop();
-                                          }
-                                          
-                                          task();
-                                          Director::getInstance()->getScheduler()->performFunctionInCocosThread(std::bind(callback.callback, callback.callbackParam));
-                                      }
-                                  }
-                                  );
-        }
-        ~ThreadTasks()
-        {
-            {
-                std::unique_lock<std::mutex> lock(_queueMutex);
-                _stop = true;
-                
-                while(_tasks.size())
-                    _tasks.pop();
-                while (_taskCallBacks.size())
-                    _taskCallBacks.pop();
-            }
-            _condition.notify_all();
-            _thread.join();
-        }
-        void clear()
-        {
-            std::unique_lock<std::mutex> lock(_queueMutex);
-            while(_tasks.size())
-                _tasks.pop();
-            while (_taskCallBacks.size())
-                _taskCallBacks.pop();
-        }
-
-        void enqueue(TaskCallBack callback, void* callbackParam, std::function<void()> task)
-        {
-            AsyncTaskCallBack taskCallBack;
-            taskCallBack.callback = std::move(callback);
-            taskCallBack.callbackParam = callbackParam;
-
-            {
-                std::unique_lock<std::mutex> lock(_queueMutex);
-                
-                // don't allow enqueueing after stopping the pool
-                if(_stop)
-                {
-                    CC_ASSERT(0 && "already stop");
-                    return;
-                }
-                
-                _tasks.push(std::move(task));
-                _taskCallBacks.push(std::move(taskCallBack));
-            }
-            _condition.notify_one();
-        }
-    private:
-        
-        // need to keep track of thread so we can join them
-        std::thread _thread;
-        // the task queue
-        std::queue< std::function<void()> > _tasks;
-        std::queue<AsyncTaskCallBack> _taskCallBacks;
-        
-        // synchronization
-        std::mutex _queueMutex;
-        std::condition_variable _condition;
-        bool _stop;
+
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::queue<Entry> entries;
+        // started by the first task of the type
+        std::thread thread;
+        bool stop;
     };
-    
-    //tasks
-    ThreadTasks _threadTasks[int(TaskType::TASK_MAX_TYPE)];
-    
-    static AsyncTaskPool* s_asyncTaskPool;
-};
 
-inline void AsyncTaskPool::stopTasks(TaskType type)
-{
-    auto& threadTask = _threadTasks[(int)type];
-    threadTask.clear();
-}
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<TaskHandle> queues[int(Priority::MAX_PRIORITY)];
+        std::thread thread;
+    };
 
-inline void AsyncTaskPool::enqueue(AsyncTaskPool::TaskType type, TaskCallBack callback, void* callbackParam, std::function<void()> task)
-{
-    auto& threadTask = _threadTasks[(int)type];
+    void schedule(TaskHandle task);
+    void release(const TaskHandle& task);
+    void execute(const TaskHandle& task);
+    TaskHandle findTask(int workerIndex);
+    int getCurrentWorkerIndex() const;
+    void workerLoop(int workerIndex);
+    void runSerialQueue(TaskType type);
+    void addCompletion(std::function<void()> completion);
+    void runCompletions();
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::unordered_map<std::thread::id, int> _workerIndices;
+
+    // tasks submitted from outside the workers
+    std::mutex _sharedMutex;
+    std::deque<TaskHandle> _sharedQueues[int(Priority::MAX_PRIORITY)];
+
+    // idle workers sleep until tasks are queued
+    std::mutex _sleepMutex;
+    std::condition_variable _sleepCondition;
+    std::atomic<int> _queuedCount;
+    std::atomic<bool> _stop;
+
+    // threads blocked in wait()
+    std::mutex _doneMutex;
+    std::condition_variable _doneCondition;
+
+    SerialQueue _serialQueues[int(TaskType::TASK_MAX_TYPE)];
+
+    std::mutex _completionMutex;
+    std::deque<std::function<void()>> _completions;
+    float _completionBudget;
     
-    threadTask.enqueue(std::move(callback), callbackParam, std::move(task));
-}
+    static AsyncTaskPool* s_asyncTaskPool;
+};
 
 inline void AsyncTaskPool::enqueue(AsyncTaskPool::TaskType type, std::function<void()> task)
 {
@@ -86,6 +86,7 @@ void Data::move(Data& other)
     
     _bytes = other._bytes;
     _size = other._size;
+    _owner = std::move(other._owner);
 
     other._bytes = nullptr;
     other._size = 0;
@@ -130,17 +131,36 @@ void Data::fastSet(unsigned char* bytes, const ssize_t size)
     //CCASSERT(bytes, "bytes should not be nullptr");
     _bytes = bytes;
     _size = size;
+    _owner.reset();
 }
 
 void Data::clear()
 {
-    if(_bytes) free(_bytes);
+    if (_owner)
+        _owner.reset();
+    else if (_bytes)
+        free(_bytes);
     _bytes = nullptr;
     _size = 0;
 }
 
 unsigned char* Data::takeBuffer(ssize_t* size)
 {
+    if (_owner)
+    {
+        // the buffer is not ours, hand out a copy that can be freed by the caller
+        unsigned char* buffer = nullptr;
+        if (_size > 0)
+        {
+            buffer = (unsigned char*)malloc(sizeof(unsigned char) * _size);
+            memcpy(buffer, _bytes, _size);
+        }
+        if (size)
+            *size = buffer ? _size : 0;
+        clear();
+        return buffer;
+    }
+
     auto buffer = getBytes();
     if (size)
         *size = getSize();
@@ -148,4 +168,18 @@ unsigned char* Data::takeBuffer(ssize_t* size)
     return buffer;
 }
 
+void Data::setView(unsigned char* bytes, const ssize_t size, std::shared_ptr<void> owner)
+{
+    CCASSERT(size >= 0, "setView size should be non-negative");
+    clear();
+    _bytes = bytes;
+    _size = size;
+    _owner = std::move(owner);
+}
+
+bool Data::isView() const
+{
+    return _owner != nullptr;
+}
+
 NS_CC_END
@@ -30,6 +30,7 @@
 #include "platform/CCPlatformMacros.h"
 #include <stdint.h> // for ssize_t on android
 #include <string>   // for ssize_t on linux
+#include <memory>
 #include "platform/CCStdC.h" // for ssize_t on window
 
 /**
@@ -143,12 +144,34 @@ public:
      * @return the internal data buffer, free it after use.
      */
     unsigned char* takeBuffer(ssize_t* size);
+
+    /**
+     * Makes the data a read-only view of memory owned by someone else, e.g. a memory-mapped AssetPack.
+     *
+     * The buffer is not freed by Data, instead a reference to `owner` is kept to keep the memory alive
+     * as long as the data is used. Copying a view creates a regular data object owning its own buffer,
+     * moving a view moves the reference to the owner.
+     *
+     * @param bytes The buffer pointer, it must stay valid as long as `owner` is alive.
+     * @param size The size of the buffer.
+     * @param owner The object that owns the buffer.
+     * @see AssetPack
+     */
+    void setView(unsigned char* bytes, const ssize_t size, std::shared_ptr<void> owner);
+
+    /**
+     * Check whether the data is a view of memory owned by another object.
+     *
+     * @return True if the buffer is not owned by the Data object.
+     */
+    bool isView() const;
 private:
     void move(Data& other);
 
 private:
     unsigned char* _bytes;
     ssize_t _size;
+    std::shared_ptr<void> _owner;
 };
 
 
@@ -265,6 +265,7 @@ void Director::drawScene()
     {
         _eventDispatcher->dispatchEvent(_eventBeforeUpdate);
         _scheduler->update(_deltaTime);
+        AsyncTaskPool::dispatchCompletions();
         _eventDispatcher->dispatchEvent(_eventAfterUpdate);
     }
 
@@ -130,8 +130,10 @@ THE SOFTWARE.
 #include "2d/CCNodeGrid.h"
 #include "2d/CCParticleBatchNode.h"
 #include "2d/CCParticleExamples.h"
+#include "2d/CCParticleDefinition.h"
 #include "2d/CCParticleSystem.h"
 #include "2d/CCParticleSystemQuad.h"
+#include "2d/CCParticleSystemGPU.h"
 #include "2d/CCProgressTimer.h"
 #include "2d/CCProtectedNode.h"
 #include "2d/CCRenderTexture.h"
@@ -189,7 +191,10 @@ THE SOFTWARE.
 #include "platform/CCCommon.h"
 #include "platform/CCDevice.h"
 #include "platform/CCFileUtils.h"
+#include "platform/CCAssetPack.h"
+#include "platform/CCFileLoadBatch.h"
 #include "platform/CCImage.h"
+#include "platform/CCMappedFile.h"
 #include "platform/CCPlatformConfig.h"
 #include "platform/CCPlatformMacros.h"
 #include "platform/CCSAXParser.h"
@@ -244,6 +249,7 @@ THE SOFTWARE.
 #include "2d/CCSpriteBatchNode.h"
 #include "2d/CCSpriteFrame.h"
 #include "2d/CCSpriteFrameCache.h"
+#include "2d/CCSpriteSheet.h"
 
 // text_input_node
 #include "2d/CCTextFieldTTF.h"
@@ -267,12 +273,15 @@ THE SOFTWARE.
 
 //3d
 #include "3d/CCAABB.h"
+#include "3d/CCAABBTree.h"
 #include "3d/CCAnimate3D.h"
 #include "3d/CCAnimation3D.h"
 #include "3d/CCAttachNode.h"
 #include "3d/CCBillBoard.h"
 #include "3d/CCFrustum.h"
 #include "3d/CCMesh.h"
+#include "3d/CCMeshSimplifier.h"
+#include "3d/CCMeshOptimizer.h"
 #include "3d/CCMeshSkin.h"
 #include "3d/CCMotionStreak3D.h"
 #include "3d/CCMeshVertexIndexData.h"
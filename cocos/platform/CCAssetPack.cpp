@@ -0,0 +1,361 @@
+/****************************************************************************
+Copyright (c) 2017-2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "platform/CCAssetPack.h"
+
+#include <string.h>
+
+#include "platform/CCFileUtils.h"
+#include "platform/CCMappedFile.h"
+#include "base/ccMacros.h"
+
+NS_CC_BEGIN
+
+/*
+ * Pack layout, all the values are little endian:
+ *
+ *   Header      32 bytes
+ *   payloads    each entry starts at a multiple of its alignment
+ *   IndexEntry  32 bytes * entryCount, sorted by (nameHash, name)
+ *   names       entry names, not null terminated
+ */
+static const char PACK_MAGIC[4] = { 'C', 'C', 'P', 'K' };
+static const uint32_t PACK_VERSION = 1;
+
+struct AssetPack::Header
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+    uint64_t indexOffset;
+    uint64_t namesOffset;
+};
+
+struct AssetPack::IndexEntry
+{
+    uint64_t offset;
+    uint32_t storedSize;
+    uint32_t size;
+    uint32_t nameOffset;
+    uint32_t nameHash;
+    uint16_t nameLength;
+    uint8_t compression;
+    uint8_t alignmentLog2;
+    uint32_t reserved;
+};
+
+// FNV-1a, must match tools/asset-pack/pack_assets.py
+static uint32_t hashName(const char* name, size_t length)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i)
+    {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+std::shared_ptr<AssetPack> AssetPack::open(const std::string& fullPath)
+{
+    std::shared_ptr<AssetPack> pack(new (std::nothrow) AssetPack());
+    if (pack && pack->init(fullPath))
+        return pack;
+    return nullptr;
+}
+
+AssetPack::AssetPack()
+: _mapping(nullptr)
+, _mappingSize(0)
+, _index(nullptr)
+, _names(nullptr)
+, _entryCount(0)
+{
+}
+
+AssetPack::~AssetPack()
+{
+}
+
+bool AssetPack::init(const std::string& fullPath)
+{
+    static_assert(sizeof(Header) == 32, "pack header must be 32 bytes");
+    static_assert(sizeof(IndexEntry) == 32, "pack index entry must be 32 bytes");
+
+    _path = fullPath;
+
+    _file = MappedFile::open(fullPath);
+    if (!_file || _file->getSize() < sizeof(Header))
+    {
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WINRT)
+        CCLOG("AssetPack: memory mapped packs are not supported on this platform");
+#endif
+        return false;
+    }
+    _mapping = _file->getBytes();
+    _mappingSize = _file->getSize();
+
+    auto header = reinterpret_cast<const Header*>(_mapping);
+    if (memcmp(header->magic, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0 || header->version != PACK_VERSION)
+    {
+        CCLOG("AssetPack: %s is not a valid asset pack", fullPath.c_str());
+        return false;
+    }
+
+    if (header->indexOffset > _mappingSize
+        || (uint64_t)header->entryCount * sizeof(IndexEntry) > _mappingSize - header->indexOffset
+        || header->namesOffset > _mappingSize)
+    {
+        CCLOG("AssetPack: %s is truncated", fullPath.c_str());
+        return false;
+    }
+
+    _entryCount = header->entryCount;
+    _index = reinterpret_cast<const IndexEntry*>(_mapping + header->indexOffset);
+    _names = reinterpret_cast<const char*>(_mapping + header->namesOffset);
+
+    // Validate the index once, so lookups don't have to check bounds.
+    const uint64_t namesSize = _mappingSize - header->namesOffset;
+    for (uint32_t i = 0; i < _entryCount; ++i)
+    {
+        const IndexEntry& entry = _index[i];
+        if (entry.offset > _mappingSize
+            || entry.storedSize > _mappingSize - entry.offset
+            || (uint64_t)entry.nameOffset + entry.nameLength > namesSize
+            || entry.compression > (uint8_t)Compression::LZ4
+            || (entry.compression == (uint8_t)Compression::NONE && entry.storedSize != entry.size))
+        {
+            CCLOG("AssetPack: %s has a corrupted index", fullPath.c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+const AssetPack::IndexEntry* AssetPack::findEntry(const std::string& name) const
+{
+    const uint32_t hash = hashName(name.c_str(), name.length());
+
+    // lower bound on the hash
+    uint32_t first = 0;
+    uint32_t count = _entryCount;
+    while (count > 0)
+    {
+        uint32_t step = count / 2;
+        if (_index[first + step].nameHash < hash)
+        {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else
+        {
+            count = step;
+        }
+    }
+
+    for (uint32_t i = first; i < _entryCount && _index[i].nameHash == hash; ++i)
+    {
+        const IndexEntry* entry = &_index[i];
+        if (entry->nameLength == name.length()
+            && memcmp(_names + entry->nameOffset, name.c_str(), name.length()) == 0)
+        {
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+bool AssetPack::hasEntry(const std::string& name) const
+{
+    return findEntry(name) != nullptr;
+}
+
+bool AssetPack::getEntryInfo(const std::string& name, EntryInfo* info) const
+{
+    auto entry = findEntry(name);
+    if (!entry)
+        return false;
+
+    if (info)
+    {
+        info->name = name;
+        info->size = entry->size;
+        info->storedSize = entry->storedSize;
+        info->compression = (Compression)entry->compression;
+    }
+    return true;
+}
+
+bool AssetPack::decodeEntry(const IndexEntry* entry, unsigned char* dst) const
+{
+    const unsigned char* src = _mapping + entry->offset;
+    if (entry->compression == (uint8_t)Compression::NONE)
+    {
+        memcpy(dst, src, entry->size);
+        return true;
+    }
+
+    int decoded = decompressLZ4(src, entry->storedSize, dst, entry->size);
+    if (decoded != (int)entry->size)
+    {
+        CCLOG("AssetPack: failed to decompress %.*s in %s", (int)entry->nameLength, _names + entry->nameOffset, _path.c_str());
+        return false;
+    }
+    return true;
+}
+
+Data AssetPack::getData(const std::string& name) const
+{
+    Data data;
+    auto entry = findEntry(name);
+    if (!entry || entry->size == 0)
+        return data;
+
+    if (entry->compression == (uint8_t)Compression::NONE)
+    {
+        auto owner = std::const_pointer_cast<AssetPack>(shared_from_this());
+        data.setView(_mapping + entry->offset, entry->size, owner);
+        return data;
+    }
+
+    auto bytes = (unsigned char*)malloc(entry->size);
+    if (!bytes)
+        return data;
+
+    if (!decodeEntry(entry, bytes))
+    {
+        free(bytes);
+        return data;
+    }
+    data.fastSet(bytes, entry->size);
+    return data;
+}
+
+bool AssetPack::getContents(const std::string& name, ResizableBuffer* buffer) const
+{
+    auto entry = findEntry(name);
+    if (!entry)
+        return false;
+
+    buffer->resize(entry->size);
+    if (entry->size == 0)
+        return true;
+
+    if (!decodeEntry(entry, (unsigned char*)buffer->buffer()))
+    {
+        buffer->resize(0);
+        return false;
+    }
+    return true;
+}
+
+std::vector<std::string> AssetPack::listEntries() const
+{
+    std::vector<std::string> names;
+    names.reserve(_entryCount);
+    for (uint32_t i = 0; i < _entryCount; ++i)
+    {
+        names.emplace_back(_names + _index[i].nameOffset, _index[i].nameLength);
+    }
+    return names;
+}
+
+int AssetPack::decompressLZ4(const unsigned char* src, size_t srcSize, unsigned char* dst, size_t dstSize)
+{
+    const unsigned char* ip = src;
+    const unsigned char* const iend = src + srcSize;
+    unsigned char* op = dst;
+    unsigned char* const oend = dst + dstSize;
+
+    while (ip < iend)
+    {
+        const unsigned token = *ip++;
+
+        // literals
+        size_t literalLength = token >> 4;
+        if (literalLength == 15)
+        {
+            unsigned char b;
+            do
+            {
+                if (ip >= iend)
+                    return -1;
+                b = *ip++;
+                literalLength += b;
+            } while (b == 255);
+        }
+        if (literalLength > (size_t)(iend - ip) || literalLength > (size_t)(oend - op))
+            return -1;
+        memcpy(op, ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+
+        // the last sequence only contains literals
+        if (ip >= iend)
+            break;
+
+        // match
+        if (iend - ip < 2)
+            return -1;
+        const size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst))
+            return -1;
+
+        size_t matchLength = token & 15;
+        if (matchLength == 15)
+        {
+            unsigned char b;
+            do
+            {
+                if (ip >= iend)
+                    return -1;
+                b = *ip++;
+                matchLength += b;
+            } while (b == 255);
+        }
+        matchLength += 4;
+        if (matchLength > (size_t)(oend - op))
+            return -1;
+
+        const unsigned char* match = op - offset;
+        if (offset >= matchLength)
+        {
+            memcpy(op, match, matchLength);
+            op += matchLength;
+        }
+        else
+        {
+            // overlapping copy, repeats the last `offset` bytes
+            for (size_t i = 0; i < matchLength; ++i)
+                *op++ = *match++;
+        }
+    }
+
+    return (int)(op - dst);
+}
+
+NS_CC_END
@@ -0,0 +1,173 @@
+/****************************************************************************
+Copyright (c) 2017-2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CC_ASSET_PACK_H__
+#define __CC_ASSET_PACK_H__
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdint.h>
+
+#include "platform/CCPlatformMacros.h"
+#include "base/CCData.h"
+
+NS_CC_BEGIN
+
+class ResizableBuffer;
+class MappedFile;
+
+/**
+ * @addtogroup platform
+ * @{
+ */
+
+/**
+ * Read-only, memory-mapped archive of asset files.
+ *
+ * An asset pack is a single file made of a fixed size header, the payload of every entry
+ * (each one aligned as requested when the pack was built), an index sorted by name hash
+ * and a table of entry names. The whole file is mapped into memory when it is opened, so
+ * opening a pack doesn't parse anything and looking up an entry is a binary search in the
+ * mapped index.
+ *
+ * Entries which are stored uncompressed are returned as Data views aliasing the mapping,
+ * nothing is read or copied until the bytes are touched. Entries can optionally be
+ * compressed with LZ4 (block format), they are decompressed straight into the destination
+ * buffer.
+ *
+ * Packs are usually used through FileUtils::mountAssetPack(), which makes their entries
+ * available through the regular search path rules. Use `tools/asset-pack/pack_assets.py`
+ * to build them.
+ *
+ * An AssetPack is immutable once opened, all its methods can be called from any thread.
+ *
+ * @note Packs must be plain files on the file system (bundle resources on iOS/Mac, writable path,
+ * expansion files...). Files inside an Android APK can't be mapped, and packs are not supported on WinRT.
+ * @since v3.18
+ */
+class CC_DLL AssetPack : public std::enable_shared_from_this<AssetPack>
+{
+public:
+    /** Compression methods of pack entries. */
+    enum class Compression : uint8_t
+    {
+        NONE = 0,
+        LZ4 = 1
+    };
+
+    /** Description of an entry of the pack. */
+    struct EntryInfo
+    {
+        std::string name;
+        /** size of the decompressed data */
+        uint32_t size;
+        /** size of the data stored in the pack */
+        uint32_t storedSize;
+        Compression compression;
+    };
+
+    /**
+     * Maps a pack file in memory.
+     *
+     * @param fullPath Full path of the pack file.
+     * @return The pack, or nullptr if the file can't be mapped or is not a valid pack.
+     */
+    static std::shared_ptr<AssetPack> open(const std::string& fullPath);
+
+    ~AssetPack();
+
+    /** Full path of the pack file. */
+    const std::string& getPath() const { return _path; }
+
+    /** Number of entries in the pack. */
+    uint32_t getEntryCount() const { return _entryCount; }
+
+    /**
+     * Checks whether an entry exists.
+     *
+     * @param name Name of the entry relative to the root of the pack, e.g. "images/hero.png".
+     */
+    bool hasEntry(const std::string& name) const;
+
+    /**
+     * Gets the description of an entry.
+     *
+     * @return True if the entry exists.
+     */
+    bool getEntryInfo(const std::string& name, EntryInfo* info) const;
+
+    /**
+     * Gets the content of an entry.
+     *
+     * Uncompressed entries are returned as views of the mapping (see Data::isView()), which
+     * keep the pack alive until they are released. Compressed entries are decompressed into
+     * a newly allocated buffer.
+     *
+     * @return The data, or Data::Null if the entry doesn't exist or can't be decompressed.
+     */
+    Data getData(const std::string& name) const;
+
+    /**
+     * Gets the content of an entry into a resizable buffer. The data is always copied,
+     * prefer getData() when possible.
+     *
+     * @return True if the entry exists and was read successfully.
+     */
+    bool getContents(const std::string& name, ResizableBuffer* buffer) const;
+
+    /** Lists the names of all the entries of the pack. */
+    std::vector<std::string> listEntries() const;
+
+    /**
+     * Decompresses a LZ4 block.
+     *
+     * @return The number of bytes written to dst, or -1 if the input is malformed or dst is too small.
+     */
+    static int decompressLZ4(const unsigned char* src, size_t srcSize, unsigned char* dst, size_t dstSize);
+
+private:
+    struct Header;
+    struct IndexEntry;
+
+    AssetPack();
+    bool init(const std::string& fullPath);
+    const IndexEntry* findEntry(const std::string& name) const;
+    bool decodeEntry(const IndexEntry* entry, unsigned char* dst) const;
+
+    std::string _path;
+    std::shared_ptr<MappedFile> _file;
+    unsigned char* _mapping;
+    size_t _mappingSize;
+    const IndexEntry* _index;
+    const char* _names;
+    uint32_t _entryCount;
+};
+
+// end of platform group
+/// @}
+
+NS_CC_END
+
+#endif // __CC_ASSET_PACK_H__
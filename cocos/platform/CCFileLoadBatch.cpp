@@ -0,0 +1,228 @@
+/****************************************************************************
+Copyright (c) 2017-2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "platform/CCFileLoadBatch.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "platform/CCAssetPack.h"
+#include "base/CCAsyncTaskPool.h"
+#include "base/ccMacros.h"
+
+NS_CC_BEGIN
+
+// entries of a pack handed to a job at once, keeps some parallelism for big packs
+static const size_t MAX_PACK_ENTRIES_PER_ITEM = 64;
+
+FileLoadBatch::FileLoadBatch(const std::vector<std::string>& filenames, unsigned int concurrency)
+: _filenames(filenames)
+, _fullPaths(filenames.size())
+, _entryNames(filenames.size())
+, _results(filenames.size())
+, _statuses(filenames.size(), FileUtils::Status::ReadFailed)
+, _concurrency(std::max(concurrency, 1u))
+, _nextItem(0)
+, _runningJobs(0)
+, _filesLoaded(0)
+, _bytesLoaded(0)
+, _cancelled(false)
+, _done(false)
+, _durationMicroseconds(0)
+{
+    _future = _promise.get_future().share();
+}
+
+FileLoadBatch::~FileLoadBatch()
+{
+    cancel();
+    auto pool = AsyncTaskPool::getInstance();
+    for (auto& job : _jobs)
+    {
+        pool->wait(job);
+    }
+}
+
+void FileLoadBatch::start()
+{
+    _startTime = std::chrono::steady_clock::now();
+    _runningJobs = _concurrency;
+
+    // the read jobs don't take a worker before the files are planned
+    auto pool = AsyncTaskPool::getInstance();
+    auto planJob = pool->submit([this]() { plan(); });
+    _jobs.push_back(planJob);
+    for (unsigned int i = 0; i < _concurrency; ++i)
+    {
+        _jobs.push_back(pool->submitAfter({ planJob }, [this]() { work(); }));
+    }
+}
+
+void FileLoadBatch::plan()
+{
+    auto fs = FileUtils::getInstance();
+    std::unordered_map<AssetPack*, size_t> openPackItems;
+    std::vector<size_t> looseFiles;
+
+    for (size_t i = 0; i < _filenames.size() && !_cancelled; ++i)
+    {
+        _fullPaths[i] = fs->fullPathForFilename(_filenames[i]);
+        if (_fullPaths[i].empty())
+        {
+            finishFile(i, Data(), FileUtils::Status::NotExists);
+            continue;
+        }
+
+        auto pack = fs->findAssetPack(_fullPaths[i], &_entryNames[i]);
+        if (!pack)
+        {
+            looseFiles.push_back(i);
+            continue;
+        }
+
+        // coalesce the entries of the same pack
+        auto iter = openPackItems.find(pack.get());
+        if (iter == openPackItems.end() || _items[iter->second].files.size() >= MAX_PACK_ENTRIES_PER_ITEM)
+        {
+            Item item;
+            item.pack = pack;
+            _items.push_back(std::move(item));
+            openPackItems[pack.get()] = _items.size() - 1;
+            iter = openPackItems.find(pack.get());
+        }
+        _items[iter->second].files.push_back(i);
+    }
+
+    // reading the files of a directory one after the other is friendlier to the disk
+    std::sort(looseFiles.begin(), looseFiles.end(), [this](size_t a, size_t b) {
+        return _fullPaths[a] < _fullPaths[b];
+    });
+    for (auto index : looseFiles)
+    {
+        Item item;
+        item.files.push_back(index);
+        _items.push_back(std::move(item));
+    }
+}
+
+void FileLoadBatch::work()
+{
+    for (;;)
+    {
+        size_t index = _nextItem.fetch_add(1);
+        if (index >= _items.size())
+            break;
+
+        // cancelled items are still walked so their files are counted
+        processItem(_items[index]);
+    }
+
+    if (_runningJobs.fetch_sub(1) == 1)
+    {
+        auto duration = std::chrono::steady_clock::now() - _startTime;
+        _durationMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+        _done.store(true, std::memory_order_release);
+        _promise.set_value();
+    }
+}
+
+void FileLoadBatch::processItem(const Item& item)
+{
+    auto fs = FileUtils::getInstance();
+    for (auto index : item.files)
+    {
+        if (_cancelled)
+        {
+            finishFile(index, Data(), FileUtils::Status::ReadFailed);
+            continue;
+        }
+
+        if (item.pack)
+        {
+            AssetPack::EntryInfo info;
+            if (!item.pack->getEntryInfo(_entryNames[index], &info))
+            {
+                finishFile(index, Data(), FileUtils::Status::NotExists);
+                continue;
+            }
+
+            Data data = item.pack->getData(_entryNames[index]);
+            bool succeeded = info.size == 0 || !data.isNull();
+            finishFile(index, std::move(data), succeeded ? FileUtils::Status::OK : FileUtils::Status::ReadFailed);
+        }
+        else
+        {
+            Data data;
+            auto status = fs->getContents(_fullPaths[index], &data);
+            finishFile(index, std::move(data), status);
+        }
+    }
+}
+
+void FileLoadBatch::finishFile(size_t index, Data&& data, FileUtils::Status status)
+{
+    _bytesLoaded += data.getSize();
+    _results[index] = std::move(data);
+    _statuses[index] = status;
+    ++_filesLoaded;
+}
+
+FileLoadBatch::Progress FileLoadBatch::getProgress() const
+{
+    Progress progress;
+    progress.fileCount = _filenames.size();
+    progress.filesLoaded = _filesLoaded;
+    progress.bytesLoaded = _bytesLoaded;
+
+    if (isDone())
+    {
+        progress.elapsedTime = _durationMicroseconds / 1000000.0f;
+    }
+    else
+    {
+        auto duration = std::chrono::steady_clock::now() - _startTime;
+        progress.elapsedTime = std::chrono::duration_cast<std::chrono::microseconds>(duration).count() / 1000000.0f;
+    }
+    progress.throughput = progress.elapsedTime > 0 ? progress.bytesLoaded / progress.elapsedTime : 0;
+    return progress;
+}
+
+FileUtils::Status FileLoadBatch::getStatus(size_t index) const
+{
+    CCASSERT(isDone(), "FileLoadBatch: the batch is not done yet");
+    return _statuses[index];
+}
+
+Data FileLoadBatch::takeData(size_t index)
+{
+    CCASSERT(isDone(), "FileLoadBatch: the batch is not done yet");
+    return std::move(_results[index]);
+}
+
+void FileLoadBatch::cancel()
+{
+    _cancelled = true;
+}
+
+NS_CC_END
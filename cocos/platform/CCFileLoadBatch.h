@@ -0,0 +1,160 @@
+/****************************************************************************
+Copyright (c) 2017-2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CC_FILE_LOAD_BATCH_H__
+#define __CC_FILE_LOAD_BATCH_H__
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <future>
+#include <chrono>
+
+#include "platform/CCPlatformMacros.h"
+#include "platform/CCFileUtils.h"
+#include "base/CCData.h"
+#include "base/CCAsyncTaskPool.h"
+
+NS_CC_BEGIN
+
+class AssetPack;
+
+/**
+ * @addtogroup platform
+ * @{
+ */
+
+/**
+ * A set of files read in the background, returned by FileUtils::loadFilesAsync().
+ *
+ * There is no callback: poll isDone() / getProgress() (e.g. from a loading scene update),
+ * block with wait(), or use getFuture(). Once the batch is done, the content of every file
+ * is available with takeData().
+ *
+ * Files are read by a bounded number of AsyncTaskPool jobs. The files stored in the same asset
+ * pack are handed to a job together, since serving them doesn't need any I/O.
+ *
+ * Destroying the batch cancels the files not read yet and waits for the jobs.
+ * @since v3.18
+ * @js NA
+ * @lua NA
+ */
+class CC_DLL FileLoadBatch
+{
+public:
+    /** Snapshot of the progress of a batch. */
+    struct Progress
+    {
+        size_t fileCount;
+        /** files processed, including the ones that failed */
+        size_t filesLoaded;
+        size_t bytesLoaded;
+        /** seconds since the batch started, or total duration once done */
+        float elapsedTime;
+        /** bytes per second */
+        float throughput;
+    };
+
+    ~FileLoadBatch();
+
+    /** Number of files of the batch. */
+    size_t getFileCount() const { return _filenames.size(); }
+
+    /** The filename at the given index, as passed to FileUtils::loadFilesAsync(). */
+    const std::string& getFilename(size_t index) const { return _filenames[index]; }
+
+    /** Whether all the files were processed (or the batch was cancelled). */
+    bool isDone() const { return _done.load(std::memory_order_acquire); }
+
+    /** Blocks until the batch is done. */
+    void wait() const { _future.wait(); }
+
+    /** Future which becomes ready when the batch is done. */
+    std::shared_future<void> getFuture() const { return _future; }
+
+    /** Gets the progress, can be called at any time from any thread. */
+    Progress getProgress() const;
+
+    /**
+     * Gets the result of the read of a file.
+     * @note Only valid once the batch is done.
+     */
+    FileUtils::Status getStatus(size_t index) const;
+
+    /**
+     * Moves the content of a file out of the batch, files stored uncompressed in an asset pack are
+     * views of the pack (see Data::isView()).
+     * @note Only valid once the batch is done.
+     */
+    Data takeData(size_t index);
+
+    /** Stops reading files, the files not read yet are reported as Status::ReadFailed. */
+    void cancel();
+
+private:
+    friend class FileUtils;
+
+    // files handed to a job at once
+    struct Item
+    {
+        std::shared_ptr<AssetPack> pack;
+        std::vector<size_t> files;
+    };
+
+    FileLoadBatch(const std::vector<std::string>& filenames, unsigned int concurrency);
+    void start();
+    void plan();
+    void work();
+    void processItem(const Item& item);
+    void finishFile(size_t index, Data&& data, FileUtils::Status status);
+
+    std::vector<std::string> _filenames;
+    std::vector<std::string> _fullPaths;
+    std::vector<std::string> _entryNames;
+    std::vector<Data> _results;
+    std::vector<FileUtils::Status> _statuses;
+    std::vector<Item> _items;
+
+    unsigned int _concurrency;
+    std::vector<AsyncTaskPool::TaskHandle> _jobs;
+    std::atomic<size_t> _nextItem;
+    std::atomic<unsigned int> _runningJobs;
+    std::atomic<size_t> _filesLoaded;
+    std::atomic<size_t> _bytesLoaded;
+    std::atomic<bool> _cancelled;
+    std::atomic<bool> _done;
+
+    std::chrono::steady_clock::time_point _startTime;
+    std::atomic<long long> _durationMicroseconds;
+    std::promise<void> _promise;
+    std::shared_future<void> _future;
+};
+
+// end of platform group
+/// @}
+
+NS_CC_END
+
+#endif // __CC_FILE_LOAD_BATCH_H__
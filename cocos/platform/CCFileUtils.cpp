@@ -32,6 +32,9 @@ THE SOFTWARE.
 #include "base/ccMacros.h"
 #include "base/CCDirector.h"
 #include "platform/CCSAXParser.h"
+#include "platform/CCAssetPack.h"
+#include "platform/CCMappedFile.h"
+#include "platform/CCFileLoadBatch.h"
 //#include "base/ccUtils.h"
 
 #include "tinyxml2/tinyxml2.h"
@@ -554,7 +557,8 @@ void FileUtils::setDelegate(FileUtils *delegate)
 }
 
 FileUtils::FileUtils()
-    : _writablePath("")
+    : _fullPathIndexDirty(false)
+    , _writablePath("")
 {
 }
 
@@ -646,11 +650,44 @@ void FileUtils::getStringFromFile(const std::string &path, std::function<void (s
 
 Data FileUtils::getDataFromFile(const std::string& filename) const
 {
+    std::shared_ptr<AssetPack> pack;
+    std::string entryName;
+    {
+        DECLARE_GUARD;
+        if (!_assetPacks.empty())
+            pack = findAssetPack(fullPathForFilename(filename), &entryName);
+    }
+    // uncompressed entries are returned without copying
+    if (pack)
+        return pack->getData(entryName);
+
     Data d;
     getContents(filename, &d);
     return d;
 }
 
+Data FileUtils::getMappedDataFromFile(const std::string& filename) const
+{
+    std::string fullPath = fullPathForFilename(filename);
+    if (fullPath.empty())
+        return Data::Null;
+
+    std::shared_ptr<AssetPack> pack;
+    {
+        DECLARE_GUARD;
+        if (!_assetPacks.empty())
+            pack = findAssetPack(fullPath, nullptr);
+    }
+
+    if (!pack)
+    {
+        auto file = MappedFile::open(fullPath);
+        if (file)
+            return file->getData(0, file->getSize());
+    }
+    return getDataFromFile(fullPath);
+}
+
 void FileUtils::getDataFromFile(const std::string& filename, std::function<void(Data)> callback) const
 {
     auto fullPath = fullPathForFilename(filename);
@@ -659,6 +696,20 @@ void FileUtils::getDataFromFile(const std::string& filename, std::function<void(
     }, std::move(callback));
 }
 
+std::shared_ptr<FileLoadBatch> FileUtils::loadFilesAsync(const std::vector<std::string>& filenames, unsigned int maxConcurrency) const
+{
+    if (maxConcurrency == 0)
+    {
+        // reads are bound by the storage, more threads don't help
+        maxConcurrency = std::min(std::max(std::thread::hardware_concurrency(), 1u), 4u);
+    }
+
+    std::shared_ptr<FileLoadBatch> batch(new (std::nothrow) FileLoadBatch(filenames, maxConcurrency));
+    if (batch)
+        batch->start();
+    return batch;
+}
+
 FileUtils::Status FileUtils::getContents(const std::string& filename, ResizableBuffer* buffer) const
 {
     if (filename.empty())
@@ -670,6 +721,10 @@ FileUtils::Status FileUtils::getContents(const std::string& filename, ResizableB
     if (fullPath.empty())
         return Status::NotExists;
 
+    Status packStatus;
+    if (getContentsFromAssetPack(fullPath, buffer, &packStatus))
+        return packStatus;
+
     std::string suitableFullPath = fs->getSuitableFOpen(fullPath);
 
     struct stat statBuf;
@@ -793,6 +848,38 @@ std::string FileUtils::getNewFilename(const std::string &filename) const
     return newFileName;
 }
 
+struct FileUtils::FullPathIndex
+{
+    // shared between snapshots, only the resolution changes with the search paths
+    std::shared_ptr<const std::unordered_set<std::string>> files;
+    std::shared_ptr<const std::vector<std::string>> roots;
+
+    // filename -> full path, only filled when every search path is indexed
+    std::unordered_map<std::string, std::string> resolved;
+    // copy of the filename lookup dictionary
+    std::unordered_map<std::string, std::string> lookup;
+    bool complete;
+
+    bool covers(const std::string& path) const
+    {
+        for (const auto& root : *roots)
+        {
+            if (path.compare(0, root.length(), root) == 0)
+                return true;
+        }
+        return false;
+    }
+};
+
+// "dir/file.png" + "resources-hd/" -> "dir/resources-hd/file.png"
+static std::string insertResolutionDirectory(const std::string& filename, const std::string& resolutionDirectory)
+{
+    std::string path = filename;
+    size_t pos = path.find_last_of('/');
+    path.insert(pos == std::string::npos ? 0 : pos + 1, resolutionDirectory);
+    return path;
+}
+
 std::string FileUtils::getPathForFilename(const std::string& filename, const std::string& resolutionDirectory, const std::string& searchPath) const
 {
     std::string file = filename;
@@ -816,14 +903,40 @@ std::string FileUtils::getPathForFilename(const std::string& filename, const std
 
 std::string FileUtils::fullPathForFilename(const std::string &filename) const
 {
-    
-    DECLARE_GUARD;
-
     if (filename.empty())
     {
         return "";
     }
 
+    // The search paths changed since the index was resolved, it is resolved again once for all of them.
+    if (_fullPathIndexDirty)
+    {
+        DECLARE_GUARD;
+        if (_fullPathIndexDirty)
+            updateFullPathIndex();
+    }
+
+    // Every search path is indexed, answer without locking nor touching the file system.
+    auto index = std::atomic_load(&_fullPathIndex);
+    if (index && index->complete && !isAbsolutePath(filename))
+    {
+        auto lookupIter = index->lookup.find(filename);
+        const std::string& newFilename = (lookupIter == index->lookup.end()) ? filename : lookupIter->second;
+
+        auto iter = index->resolved.find(newFilename);
+        if (iter != index->resolved.end())
+        {
+            return iter->second;
+        }
+
+        if(isPopupNotify()){
+            CCLOG("cocos2d: fullPathForFilename: No file found at %s. Possible missing file.", filename.c_str());
+        }
+        return "";
+    }
+
+    DECLARE_GUARD;
+
     if (isAbsolutePath(filename))
     {
         return filename;
@@ -840,12 +953,38 @@ std::string FileUtils::fullPathForFilename(const std::string &filename) const
     const std::string newFilename( getNewFilename(filename) );
 
     std::string fullpath;
+    bool probedFileSystem = false;
+    index = std::atomic_load(&_fullPathIndex);
 
     for (const auto& searchIt : _searchPathArray)
     {
+        auto packIter = _assetPacks.empty() ? _assetPacks.end() : _assetPacks.find(searchIt);
+        bool indexed = (packIter == _assetPacks.end()) && index && index->covers(searchIt);
+
         for (const auto& resolutionIt : _searchResolutionsOrderArray)
         {
-            fullpath = this->getPathForFilename(newFilename, resolutionIt, searchIt);
+            if (packIter != _assetPacks.end())
+            {
+                // mounted pack, look up the index instead of the file system
+                std::string entryName = insertResolutionDirectory(newFilename, resolutionIt);
+
+                fullpath.clear();
+                if (packIter->second->hasEntry(entryName))
+                    fullpath = searchIt + entryName;
+            }
+            else if (indexed)
+            {
+                std::string candidate = searchIt + insertResolutionDirectory(newFilename, resolutionIt);
+
+                fullpath.clear();
+                if (index->files->count(candidate) > 0)
+                    fullpath = candidate;
+            }
+            else
+            {
+                probedFileSystem = true;
+                fullpath = this->getPathForFilename(newFilename, resolutionIt, searchIt);
+            }
 
             if (!fullpath.empty())
             {
@@ -857,6 +996,12 @@ std::string FileUtils::fullPathForFilename(const std::string &filename) const
         }
     }
 
+    // The miss was answered by immutable indexes, remember it.
+    if (!probedFileSystem)
+    {
+        _fullPathCache.emplace(filename, "");
+    }
+
     if(isPopupNotify()){
         CCLOG("cocos2d: fullPathForFilename: No file found at %s. Possible missing file.", filename.c_str());
     }
@@ -958,6 +1103,8 @@ void FileUtils::setSearchResolutionsOrder(const std::vector<std::string>& search
     {
         _searchResolutionsOrderArray.push_back("");
     }
+
+    _fullPathIndexDirty = true;
 }
 
 void FileUtils::addSearchResolutionsOrder(const std::string &order,const bool front)
@@ -974,6 +1121,9 @@ void FileUtils::addSearchResolutionsOrder(const std::string &order,const bool fr
     } else {
         _searchResolutionsOrderArray.push_back(resOrder);
     }
+
+    _fullPathCache.clear();
+    _fullPathIndexDirty = true;
 }
 
 const std::vector<std::string> FileUtils::getSearchResolutionsOrder() const
@@ -1060,6 +1210,8 @@ void FileUtils::setSearchPaths(const std::vector<std::string>& searchPaths)
         //CCLOG("Default root path doesn't exist, adding it.");
         _searchPathArray.push_back(_defaultResRootPath);
     }
+
+    _fullPathIndexDirty = true;
 }
 
 void FileUtils::addSearchPath(const std::string &searchpath,const bool front)
@@ -1082,6 +1234,86 @@ void FileUtils::addSearchPath(const std::string &searchpath,const bool front)
         _originalSearchPaths.push_back(searchpath);
         _searchPathArray.push_back(path);
     }
+
+    _fullPathCache.clear();
+    _fullPathIndexDirty = true;
+}
+
+bool FileUtils::mountAssetPack(const std::string& packPath, bool front)
+{
+    std::string fullPath = isAbsolutePath(packPath) ? packPath : fullPathForFilename(packPath);
+    if (fullPath.empty())
+        return false;
+
+    auto pack = AssetPack::open(fullPath);
+    if (!pack)
+    {
+        CCLOG("cocos2d: mountAssetPack: failed to open %s", packPath.c_str());
+        return false;
+    }
+
+    DECLARE_GUARD;
+    std::string searchPath = fullPath + "/";
+    bool mounted = _assetPacks.find(searchPath) != _assetPacks.end();
+    _assetPacks[searchPath] = pack;
+    if (!mounted)
+    {
+        addSearchPath(searchPath, front);
+    }
+
+    _fullPathCache.clear();
+    return true;
+}
+
+void FileUtils::unmountAssetPack(const std::string& packPath)
+{
+    DECLARE_GUARD;
+    std::string fullPath = isAbsolutePath(packPath) ? packPath : fullPathForFilename(packPath);
+    std::string searchPath = fullPath + "/";
+    if (_assetPacks.erase(searchPath) == 0)
+        return;
+
+    auto iter = std::find(_searchPathArray.begin(), _searchPathArray.end(), searchPath);
+    if (iter != _searchPathArray.end())
+        _searchPathArray.erase(iter);
+    iter = std::find(_originalSearchPaths.begin(), _originalSearchPaths.end(), searchPath);
+    if (iter != _originalSearchPaths.end())
+        _originalSearchPaths.erase(iter);
+
+    _fullPathCache.clear();
+    _fullPathIndexDirty = true;
+}
+
+std::shared_ptr<AssetPack> FileUtils::findAssetPack(const std::string& fullPath, std::string* entryName) const
+{
+    DECLARE_GUARD;
+    for (const auto& iter : _assetPacks)
+    {
+        const std::string& prefix = iter.first;
+        if (fullPath.length() > prefix.length() && fullPath.compare(0, prefix.length(), prefix) == 0)
+        {
+            if (entryName)
+                *entryName = fullPath.substr(prefix.length());
+            return iter.second;
+        }
+    }
+    return nullptr;
+}
+
+bool FileUtils::getContentsFromAssetPack(const std::string& fullPath, ResizableBuffer* buffer, Status* status) const
+{
+    std::string entryName;
+    auto pack = findAssetPack(fullPath, &entryName);
+    if (!pack)
+        return false;
+
+    if (!pack->hasEntry(entryName))
+        *status = Status::NotExists;
+    else if (!pack->getContents(entryName, buffer))
+        *status = Status::ReadFailed;
+    else
+        *status = Status::OK;
+    return true;
 }
 
 void FileUtils::setFilenameLookupDictionary(const ValueMap& filenameLookupDict)
@@ -1090,6 +1322,225 @@ void FileUtils::setFilenameLookupDictionary(const ValueMap& filenameLookupDict)
     _fullPathCache.clear();
     _fullPathCacheDir.clear();
     _filenameLookupDict = filenameLookupDict;
+    _fullPathIndexDirty = true;
+}
+
+bool FileUtils::buildFullPathIndex()
+{
+    DECLARE_GUARD;
+
+    auto files = std::make_shared<std::unordered_set<std::string>>();
+    auto roots = std::make_shared<std::vector<std::string>>();
+    const std::string writablePath = getWritablePath();
+
+    for (const auto& searchPath : _searchPathArray)
+    {
+        // the content of the writable path changes at runtime, keep probing it
+        if (!writablePath.empty() && searchPath.compare(0, writablePath.length(), writablePath) == 0)
+            continue;
+
+        bool alreadyIndexed = false;
+        for (const auto& root : *roots)
+        {
+            if (searchPath.compare(0, root.length(), root) == 0)
+            {
+                alreadyIndexed = true;
+                break;
+            }
+        }
+        if (alreadyIndexed)
+            continue;
+
+        auto packIter = _assetPacks.find(searchPath);
+        if (packIter != _assetPacks.end())
+        {
+            for (const auto& name : packIter->second->listEntries())
+                files->insert(searchPath + name);
+            roots->push_back(searchPath);
+            continue;
+        }
+
+        if (!isDirectoryExistInternal(searchPath))
+            continue;
+
+        std::vector<std::string> found;
+        listFilesRecursively(searchPath, &found);
+
+        // Nothing found may also mean the directory can't be listed (e.g. inside an apk),
+        // don't claim it is empty.
+        if (found.empty())
+            continue;
+
+        for (auto& path : found)
+        {
+            if (path.empty() || path[path.length() - 1] == '/')
+                continue;
+
+            size_t pos;
+            while ((pos = path.find("//")) != std::string::npos)
+                path.erase(pos, 1);
+            files->insert(path);
+        }
+        roots->push_back(searchPath);
+    }
+
+    if (roots->empty())
+    {
+        CCLOG("cocos2d: buildFullPathIndex: none of the search paths could be scanned");
+        return false;
+    }
+
+    _fullPathCache.clear();
+    updateFullPathIndex(files, roots);
+    return true;
+}
+
+bool FileUtils::loadFullPathIndex(const std::string& manifestFile)
+{
+    std::string content = getStringFromFile(manifestFile);
+    if (content.empty())
+    {
+        CCLOG("cocos2d: loadFullPathIndex: can't read %s", manifestFile.c_str());
+        return false;
+    }
+
+    DECLARE_GUARD;
+
+    auto files = std::make_shared<std::unordered_set<std::string>>();
+    auto roots = std::make_shared<std::vector<std::string>>(1, _defaultResRootPath);
+
+    size_t start = 0;
+    while (start < content.length())
+    {
+        size_t end = content.find('\n', start);
+        if (end == std::string::npos)
+            end = content.length();
+
+        size_t length = end - start;
+        if (length > 0 && content[end - 1] == '\r')
+            --length;
+        if (length > 0 && content[start] != '#')
+            files->insert(_defaultResRootPath + content.substr(start, length));
+
+        start = end + 1;
+    }
+
+    _fullPathCache.clear();
+    updateFullPathIndex(files, roots);
+    return true;
+}
+
+bool FileUtils::writeFullPathIndex(const std::string& manifestFullPath) const
+{
+    auto index = std::atomic_load(&_fullPathIndex);
+    if (!index)
+        return false;
+
+    std::string rootPath;
+    {
+        DECLARE_GUARD;
+        rootPath = _defaultResRootPath;
+    }
+
+    std::vector<std::string> names;
+    for (const auto& file : *index->files)
+    {
+        if (file.compare(0, rootPath.length(), rootPath) == 0)
+            names.push_back(file.substr(rootPath.length()));
+    }
+    std::sort(names.begin(), names.end());
+
+    std::string content = "# files of the resource root path, see FileUtils::loadFullPathIndex()\n";
+    for (const auto& name : names)
+    {
+        content += name;
+        content += '\n';
+    }
+    return writeStringToFile(content, manifestFullPath);
+}
+
+void FileUtils::clearFullPathIndex()
+{
+    DECLARE_GUARD;
+    std::atomic_store(&_fullPathIndex, std::shared_ptr<const FullPathIndex>());
+    _fullPathCache.clear();
+}
+
+void FileUtils::updateFullPathIndex(std::shared_ptr<const std::unordered_set<std::string>> files,
+                                    std::shared_ptr<const std::vector<std::string>> roots) const
+{
+    _fullPathIndexDirty = false;
+    if (!files)
+    {
+        auto current = std::atomic_load(&_fullPathIndex);
+        if (!current)
+            return;
+        files = current->files;
+        roots = current->roots;
+    }
+
+    auto index = std::make_shared<FullPathIndex>();
+    index->files = files;
+    index->roots = roots;
+
+    for (const auto& iter : _filenameLookupDict)
+    {
+        index->lookup.emplace(iter.first, iter.second.asString());
+    }
+
+    index->complete = !_searchPathArray.empty();
+    for (const auto& searchPath : _searchPathArray)
+    {
+        if (!index->covers(searchPath))
+        {
+            index->complete = false;
+            break;
+        }
+    }
+
+    if (index->complete)
+    {
+        // Run the search rules backwards: every indexed file is a candidate for the filenames
+        // it can be found with, the candidate with the highest priority wins.
+        std::unordered_map<std::string, size_t> priorities;
+        const size_t resolutionCount = _searchResolutionsOrderArray.size();
+        for (const auto& file : *files)
+        {
+            for (size_t i = 0; i < _searchPathArray.size(); ++i)
+            {
+                const std::string& searchPath = _searchPathArray[i];
+                if (file.compare(0, searchPath.length(), searchPath) != 0)
+                    continue;
+
+                const std::string relative = file.substr(searchPath.length());
+                size_t pos = relative.find_last_of('/');
+                const size_t dirLength = (pos == std::string::npos) ? 0 : pos + 1;
+
+                for (size_t j = 0; j < resolutionCount; ++j)
+                {
+                    const std::string& resolution = _searchResolutionsOrderArray[j];
+                    if (resolution.length() > dirLength)
+                        continue;
+
+                    const size_t start = dirLength - resolution.length();
+                    if (relative.compare(start, resolution.length(), resolution) != 0
+                        || (start > 0 && relative[start - 1] != '/'))
+                        continue;
+
+                    std::string filename = relative.substr(0, start) + relative.substr(dirLength);
+                    const size_t priority = i * resolutionCount + j;
+                    auto iter = priorities.find(filename);
+                    if (iter == priorities.end() || priority < iter->second)
+                    {
+                        priorities[filename] = priority;
+                        index->resolved[filename] = file;
+                    }
+                }
+            }
+        }
+    }
+
+    std::atomic_store(&_fullPathIndex, std::shared_ptr<const FullPathIndex>(index));
 }
 
 void FileUtils::loadFilenameLookupDictionaryFromFile(const std::string &filename)
@@ -1131,6 +1582,15 @@ bool FileUtils::isFileExist(const std::string& filename) const
 {
     if (isAbsolutePath(filename))
     {
+        std::string entryName;
+        auto pack = findAssetPack(filename, &entryName);
+        if (pack)
+            return pack->hasEntry(entryName);
+
+        auto index = std::atomic_load(&_fullPathIndex);
+        if (index && index->covers(filename))
+            return index->files->count(filename) > 0;
+
         return isFileExistInternal(filename);
     }
     else
@@ -29,8 +29,12 @@ THE SOFTWARE.
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
+#include <memory>
 #include <type_traits>
 #include <mutex>
+#include <atomic>
+#include <algorithm>
 
 #include "platform/CCPlatformMacros.h"
 #include "base/ccTypes.h"
@@ -42,6 +46,9 @@ THE SOFTWARE.
 
 NS_CC_BEGIN
 
+class AssetPack;
+class FileLoadBatch;
+
 /**
  * @addtogroup platform
  * @{
@@ -106,7 +113,14 @@ public:
     explicit ResizableBufferAdapter(BufferType* buffer) : _buffer(buffer) {}
     virtual void resize(size_t size) override {
         size_t oldSize = static_cast<size_t>(_buffer->getSize());
-        if (oldSize != size) {
+        if (oldSize != size && _buffer->isView()) {
+            // views don't own their bytes, so they can't be reallocated
+            void* buffer = malloc(size);
+            if (buffer) {
+                memcpy(buffer, _buffer->getBytes(), std::min(oldSize, size));
+                _buffer->fastSet((unsigned char*)buffer, size);
+            }
+        } else if (oldSize != size) {
             auto old = _buffer->getBytes();
             void* buffer = realloc(old, size);
             if (buffer)
@@ -121,6 +135,8 @@ public:
 /** Helper class to handle file operations. */
 class CC_DLL FileUtils
 {
+    friend class FileLoadBatch;
+
 public:
     /**
      *  Gets the instance of FileUtils.
@@ -195,6 +211,46 @@ public:
      */
     virtual void getDataFromFile(const std::string& filename, std::function<void(Data)> callback) const;
 
+    /**
+     * Gets the content of a file without reading it, as a view of a memory mapping of the file.
+     *
+     * Pages are read from the storage when they are touched, and the mapping stays alive as long
+     * as the data or a copy of its owner does (see Data::isView()). Files which can't be mapped, e.g.
+     * the ones inside the Android APK or compressed asset pack entries, are read with getDataFromFile().
+     * Given a full path, it doesn't touch the search path caches and can be called from any thread.
+     *
+     * @param filename filepath for the data to be read. Can be relative or absolute path
+     * @return A data object.
+     * @since v3.18
+     * @js NA
+     * @lua NA
+     */
+    Data getMappedDataFromFile(const std::string& filename) const;
+
+    /**
+     * Reads a list of files in the background, without callbacks.
+     *
+     * The files are resolved and read by up to `maxConcurrency` AsyncTaskPool jobs, the returned batch
+     * reports the progress and holds the content of the files once it is done. Use it for loading
+     * screens reading many files, e.g.:
+     * @code
+     * _batch = FileUtils::getInstance()->loadFilesAsync(plistFiles);
+     * // in update()
+     * if (_batch->isDone())
+     *     for (size_t i = 0; i < _batch->getFileCount(); ++i)
+     *         parse(_batch->getFilename(i), _batch->takeData(i));
+     * @endcode
+     *
+     * @param filenames The files to read, relative or absolute paths.
+     * @param maxConcurrency The maximum number of files read at the same time, 0 for the default (4 at most).
+     * @return The batch, it can be polled from any thread.
+     * @see FileLoadBatch
+     * @since v3.18
+     * @js NA
+     * @lua NA
+     */
+    std::shared_ptr<FileLoadBatch> loadFilesAsync(const std::vector<std::string>& filenames, unsigned int maxConcurrency = 0) const;
+
     enum class Status
     {
         OK = 0,
@@ -856,6 +912,87 @@ public:
      */
     virtual std::string getNewFilename(const std::string &filename) const;
 
+    /**
+     *  Maps an asset pack in memory and adds it to the search paths.
+     *
+     *  The pack behaves like a directory: a file "images/hero.png" stored in "packs/base.ccpk" is found
+     *  with the regular search rules (resolution directories, filename lookup dictionary...) and its full
+     *  path is "<resource root>/packs/base.ccpk/images/hero.png". getDataFromFile() returns uncompressed
+     *  entries as views of the mapping without reading or copying them.
+     *
+     *  The pack stays mounted until unmountAssetPack() is called, even if the search paths are reset with
+     *  setSearchPaths(). To search it again, add the path of the pack to the search paths.
+     *
+     *  @note On Android the pack has to be a file, e.g. in the writable path: the assets of the apk can't be mapped.
+     *
+     *  @param packPath The path of the pack file, it could be a relative or an absolute path.
+     *  @param front If true, the pack is searched before the other search paths.
+     *  @return True if the pack was mapped successfully.
+     *  @see AssetPack
+     *  @since v3.18
+     */
+    bool mountAssetPack(const std::string& packPath, bool front = false);
+
+    /**
+     *  Unmounts an asset pack mounted with mountAssetPack() and removes it from the search paths.
+     *  Data views of its entries which are still alive keep the mapping valid until they are released.
+     *
+     *  @param packPath The path used to mount the pack.
+     *  @since v3.18
+     */
+    void unmountAssetPack(const std::string& packPath);
+
+    /**
+     *  Builds an index of the files in the search paths, so fullPathForFilename() and isFileExist()
+     *  can answer without probing the file system.
+     *
+     *  Every search path is scanned once, except the writable path and the directories under it,
+     *  since their content is expected to change at runtime: they are still probed as usual.
+     *  Lookups of missing files are answered by the index too, so misses are as cheap as hits.
+     *
+     *  When every search path is covered by the index, fullPathForFilename() doesn't take the
+     *  FileUtils mutex at all and can be called concurrently from worker threads.
+     *
+     *  The index is a snapshot: files added to or removed from the indexed directories afterwards
+     *  are not seen until the index is built again. Changing the search paths, the resolution order
+     *  or the filename lookup dictionary doesn't need a rebuild.
+     *
+     *  @note Directories inside an Android APK can't be scanned, use loadFullPathIndex() instead.
+     *  @return True if the index was built.
+     *  @see loadFullPathIndex, clearFullPathIndex
+     *  @since v3.18
+     */
+    bool buildFullPathIndex();
+
+    /**
+     *  Loads an index of the files of the default resource root path from a manifest, see buildFullPathIndex().
+     *
+     *  The manifest is a text file listing one file per line, relative to the default resource root path
+     *  (e.g. "fonts/arial.ttf"). Empty lines and lines starting with '#' are ignored. The manifest can be
+     *  generated at build time, or with writeFullPathIndex().
+     *
+     *  @param manifestFile The path of the manifest file.
+     *  @return True if the manifest was loaded.
+     *  @since v3.18
+     */
+    bool loadFullPathIndex(const std::string& manifestFile);
+
+    /**
+     *  Writes the files of the current index which are under the default resource root path to a manifest
+     *  that can be loaded with loadFullPathIndex().
+     *
+     *  @param manifestFullPath The full path of the manifest to write.
+     *  @return True if the manifest was written.
+     *  @since v3.18
+     */
+    bool writeFullPathIndex(const std::string& manifestFullPath) const;
+
+    /**
+     *  Drops the index built by buildFullPathIndex() or loadFullPathIndex(), files are probed on the file system again.
+     *  @since v3.18
+     */
+    void clearFullPathIndex();
+
 protected:
     /**
      *  The default constructor.
@@ -915,6 +1052,40 @@ protected:
      */
     virtual std::string fullPathForDirectory(const std::string &dirname) const;
 
+    /**
+     *  Finds the mounted asset pack containing a full path.
+     *
+     *  @param fullPath The full path of a file.
+     *  @param entryName Filled with the name of the entry inside the pack if a pack is found.
+     *  @return The pack, or nullptr if the path doesn't belong to a mounted pack.
+     */
+    std::shared_ptr<AssetPack> findAssetPack(const std::string& fullPath, std::string* entryName) const;
+
+    /**
+     *  Reads a file from the mounted asset packs, platform implementations of getContents()
+     *  should call it before looking at the file system.
+     *
+     *  @param fullPath The full path of the file.
+     *  @param buffer The buffer to fill.
+     *  @param status Filled with the result of the read if the file belongs to a pack.
+     *  @return True if the file belongs to a mounted pack.
+     */
+    bool getContentsFromAssetPack(const std::string& fullPath, ResizableBuffer* buffer, Status* status) const;
+
+    /** Immutable snapshot of the indexed files, see buildFullPathIndex(). */
+    struct FullPathIndex;
+
+    /**
+     *  Publishes a new index snapshot for the current search paths, resolution order and filename lookup dictionary.
+     *  Must be called with `_mutex` held. When one of them changes, `_fullPathIndexDirty` is set instead,
+     *  and the next fullPathForFilename() calls it, so that a batch of changes resolves the index once.
+     *
+     *  @param files The full paths of the indexed files, or nullptr to keep the files of the current index.
+     *  @param roots The indexed directories, or nullptr to keep the roots of the current index.
+     */
+    void updateFullPathIndex(std::shared_ptr<const std::unordered_set<std::string>> files = nullptr,
+                             std::shared_ptr<const std::vector<std::string>> roots = nullptr) const;
+
     /**
     * mutex used to protect fields. 
     */
@@ -968,6 +1139,22 @@ protected:
      */
     mutable std::unordered_map<std::string, std::string> _fullPathCacheDir;
 
+    /**
+     * Mounted asset packs, the key is the search path of the pack (its full path followed by '/').
+     */
+    std::unordered_map<std::string, std::shared_ptr<AssetPack>> _assetPacks;
+
+    /**
+     * Current index snapshot, it is replaced atomically and can be read without holding `_mutex`.
+     */
+    mutable std::shared_ptr<const FullPathIndex> _fullPathIndex;
+
+    /**
+     * Whether the search paths, the resolution order or the filename lookup dictionary changed since
+     * the index was resolved, written with `_mutex` held.
+     */
+    mutable std::atomic<bool> _fullPathIndexDirty;
+
     /**
      * Writable path.
      */
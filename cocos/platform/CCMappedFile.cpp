@@ -0,0 +1,132 @@
+/****************************************************************************
+Copyright (c) 2017-2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "platform/CCMappedFile.h"
+
+#include "base/ccMacros.h"
+
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32)
+#include <windows.h>
+#elif (CC_TARGET_PLATFORM != CC_PLATFORM_WINRT)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+NS_CC_BEGIN
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string& fullPath)
+{
+    std::shared_ptr<MappedFile> file(new (std::nothrow) MappedFile());
+    if (file && file->init(fullPath))
+        return file;
+    return nullptr;
+}
+
+MappedFile::MappedFile()
+: _bytes(nullptr)
+, _size(0)
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32)
+, _fileHandle(INVALID_HANDLE_VALUE)
+, _mappingHandle(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32)
+    if (_bytes)
+        ::UnmapViewOfFile(_bytes);
+    if (_mappingHandle)
+        ::CloseHandle(_mappingHandle);
+    if (_fileHandle != INVALID_HANDLE_VALUE)
+        ::CloseHandle(_fileHandle);
+#elif (CC_TARGET_PLATFORM != CC_PLATFORM_WINRT)
+    if (_bytes)
+        munmap(_bytes, _size);
+#endif
+}
+
+bool MappedFile::init(const std::string& fullPath)
+{
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32)
+    int wlen = ::MultiByteToWideChar(CP_UTF8, 0, fullPath.c_str(), -1, nullptr, 0);
+    std::wstring wpath(wlen, L'\0');
+    ::MultiByteToWideChar(CP_UTF8, 0, fullPath.c_str(), -1, &wpath[0], wlen);
+
+    _fileHandle = ::CreateFileW(wpath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (_fileHandle == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!::GetFileSizeEx(_fileHandle, &fileSize) || fileSize.QuadPart <= 0)
+        return false;
+    _size = (size_t)fileSize.QuadPart;
+
+    _mappingHandle = ::CreateFileMappingW(_fileHandle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    if (!_mappingHandle)
+        return false;
+
+    _bytes = (unsigned char*)::MapViewOfFile(_mappingHandle, FILE_MAP_COPY, 0, 0, 0);
+    return _bytes != nullptr;
+#elif (CC_TARGET_PLATFORM == CC_PLATFORM_WINRT)
+    CC_UNUSED_PARAM(fullPath);
+    return false;
+#else
+    int fd = ::open(fullPath.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat statBuf;
+    if (fstat(fd, &statBuf) != 0 || statBuf.st_size <= 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    _size = (size_t)statBuf.st_size;
+
+    void* mapping = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    // the mapping keeps a reference to the file, the descriptor isn't needed anymore
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        return false;
+    _bytes = (unsigned char*)mapping;
+    return true;
+#endif
+}
+
+Data MappedFile::getData(size_t offset, size_t size) const
+{
+    Data data;
+    if (offset > _size || size > _size - offset || size == 0)
+        return data;
+
+    auto owner = std::const_pointer_cast<MappedFile>(shared_from_this());
+    data.setView(_bytes + offset, size, owner);
+    return data;
+}
+
+NS_CC_END
@@ -0,0 +1,94 @@
+/****************************************************************************
+Copyright (c) 2017-2018 Xiamen Yaji Software Co., Ltd.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CC_MAPPED_FILE_H__
+#define __CC_MAPPED_FILE_H__
+
+#include <string>
+#include <memory>
+
+#include "platform/CCPlatformMacros.h"
+#include "base/CCData.h"
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup platform
+ * @{
+ */
+
+/**
+ * A whole file mapped into memory.
+ *
+ * The mapping is private and writable: pages are shared with the page cache as long as they
+ * are only read, and copied on write if someone modifies them. Nothing is read from the storage
+ * until the bytes are touched.
+ *
+ * Mapping is not available for files inside the Android APK nor on WinRT, open() fails and
+ * the file has to be read the regular way.
+ * @since v3.18
+ * @js NA
+ * @lua NA
+ */
+class CC_DLL MappedFile : public std::enable_shared_from_this<MappedFile>
+{
+public:
+    /**
+     * Maps a file in memory.
+     *
+     * @param fullPath Full path of the file.
+     * @return The mapping, or nullptr if the file doesn't exist, is empty or can't be mapped.
+     */
+    static std::shared_ptr<MappedFile> open(const std::string& fullPath);
+
+    ~MappedFile();
+
+    unsigned char* getBytes() const { return _bytes; }
+    size_t getSize() const { return _size; }
+
+    /**
+     * Gets a Data view of a part of the mapping, which keeps the mapping alive until it is released.
+     *
+     * @return The view, or Data::Null if the range is outside of the file.
+     */
+    Data getData(size_t offset, size_t size) const;
+
+private:
+    MappedFile();
+    bool init(const std::string& fullPath);
+
+    unsigned char* _bytes;
+    size_t _size;
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32)
+    void* _fileHandle;
+    void* _mappingHandle;
+#endif
+};
+
+// end of platform group
+/// @}
+
+NS_CC_END
+
+#endif // __CC_MAPPED_FILE_H__
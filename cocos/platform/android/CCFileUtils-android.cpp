@@ -351,6 +351,13 @@ FileUtils::Status FileUtilsAndroid::getContents(const std::string& filename, Res
         return FileUtils::Status::NotExists;
 
     string fullPath = fullPathForFilename(filename);
+    if (fullPath.empty())
+        return FileUtils::Status::NotExists;
+
+    // entries of a mounted pack, which is mapped from a file outside of the apk
+    Status packStatus;
+    if (getContentsFromAssetPack(fullPath, buffer, &packStatus))
+        return packStatus;
 
     if (fullPath[0] == '/')
         return FileUtils::getContents(fullPath, buffer);
@@ -220,6 +220,10 @@ FileUtils::Status FileUtilsWin32::getContents(const std::string& filename, Resiz
 	// read the file from hardware
 	std::string fullPath = FileUtils::getInstance()->fullPathForFilename(filename);
 
+	Status packStatus;
+	if (getContentsFromAssetPack(fullPath, buffer, &packStatus))
+		return packStatus;
+
 	HANDLE fileHandle = ::CreateFileW(StringUtf8ToWideChar(fullPath).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, NULL, nullptr);
 	if (fileHandle == INVALID_HANDLE_VALUE)
 		return FileUtils::Status::OpenFailed;
@@ -216,6 +216,14 @@ public:
     static const char* SHADER_NAME_LABEL_OUTLINE;
     static const char* SHADER_NAME_LABEL_DISTANCEFIELD_NORMAL;
     static const char* SHADER_NAME_LABEL_DISTANCEFIELD_GLOW;
+    /** @} */
+    /** @{
+        Built in shader for label, the vertices are already in world space so that labels can be batched.
+        @since v3.18
+    */
+    static const char* SHADER_NAME_LABEL_NORMAL_NO_MVP;
+    static const char* SHADER_NAME_LABEL_DISTANCEFIELD_NORMAL_NO_MVP;
+    /** @} */
 
     /**Built in shader used for 3D, support Position vertex attribute, with color specified by a uniform.*/
     static const char* SHADER_3D_POSITION;
@@ -276,6 +284,11 @@ public:
      Built in shader for camera clear
      */
     static const char* SHADER_CAMERA_CLEAR;
+    /**
+     Built in shader for ParticleSystemGPU, the particles are evaluated from their spawn parameters
+     @since v3.18
+     */
+    static const char* SHADER_NAME_PARTICLE_GPU;
     /**
     end of built shader types.
     @}
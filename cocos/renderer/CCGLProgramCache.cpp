@@ -56,6 +56,8 @@ enum {
     kShaderType_UIGrayScale,
     kShaderType_LabelNormal,
     kShaderType_LabelOutline,
+    kShaderType_LabelNormal_noMVP,
+    kShaderType_LabelDistanceFieldNormal_noMVP,
     kShaderType_3DPosition,
     kShaderType_3DPositionTex,
     kShaderType_3DSkinPositionTex,
@@ -69,6 +71,7 @@ enum {
     kShaderType_3DSkyBox,
     kShaderType_3DTerrain,
     kShaderType_CameraClear,
+    kShaderType_ParticleGPU,
     // ETC1 ALPHA supports.
     kShaderType_ETC1ASPositionTextureColor,
     kShaderType_ETC1ASPositionTextureColor_noMVP,
@@ -233,6 +236,14 @@ void GLProgramCache::loadDefaultGLPrograms()
     loadDefaultGLProgram(p, kShaderType_LabelOutline);
     _programs.emplace(GLProgram::SHADER_NAME_LABEL_OUTLINE, p);
 
+    p = new (std::nothrow) GLProgram();
+    loadDefaultGLProgram(p, kShaderType_LabelNormal_noMVP);
+    _programs.emplace(GLProgram::SHADER_NAME_LABEL_NORMAL_NO_MVP, p);
+
+    p = new (std::nothrow) GLProgram();
+    loadDefaultGLProgram(p, kShaderType_LabelDistanceFieldNormal_noMVP);
+    _programs.emplace(GLProgram::SHADER_NAME_LABEL_DISTANCEFIELD_NORMAL_NO_MVP, p);
+
     p = new (std::nothrow) GLProgram();
     loadDefaultGLProgram(p, kShaderType_3DPosition);
     _programs.emplace(GLProgram::SHADER_3D_POSITION, p);
@@ -285,6 +296,10 @@ void GLProgramCache::loadDefaultGLPrograms()
     loadDefaultGLProgram(p, kShaderType_CameraClear);
     _programs.emplace(GLProgram::SHADER_CAMERA_CLEAR, p);
 
+    p = new (std::nothrow) GLProgram();
+    loadDefaultGLProgram(p, kShaderType_ParticleGPU);
+    _programs.emplace(GLProgram::SHADER_NAME_PARTICLE_GPU, p);
+
     /// ETC1 ALPHA supports.
     p = new(std::nothrow) GLProgram();
     loadDefaultGLProgram(p, kShaderType_ETC1ASPositionTextureColor);
@@ -404,6 +419,14 @@ void GLProgramCache::reloadDefaultGLPrograms()
     p->reset();
     loadDefaultGLProgram(p, kShaderType_LabelOutline);
 
+    p = getGLProgram(GLProgram::SHADER_NAME_LABEL_NORMAL_NO_MVP);
+    p->reset();
+    loadDefaultGLProgram(p, kShaderType_LabelNormal_noMVP);
+
+    p = getGLProgram(GLProgram::SHADER_NAME_LABEL_DISTANCEFIELD_NORMAL_NO_MVP);
+    p->reset();
+    loadDefaultGLProgram(p, kShaderType_LabelDistanceFieldNormal_noMVP);
+
     p = getGLProgram(GLProgram::SHADER_3D_POSITION);
     p->reset();
     loadDefaultGLProgram(p, kShaderType_3DPosition);
@@ -456,6 +479,10 @@ void GLProgramCache::reloadDefaultGLPrograms()
     p->reset();
     loadDefaultGLProgram(p, kShaderType_CameraClear);
 
+    p = getGLProgram(GLProgram::SHADER_NAME_PARTICLE_GPU);
+    p->reset();
+    loadDefaultGLProgram(p, kShaderType_ParticleGPU);
+
     // ETC1 ALPHA supports.
     p = getGLProgram(GLProgram::SHADER_NAME_ETC1AS_POSITION_TEXTURE_COLOR);
     p->reset();
@@ -558,6 +585,12 @@ void GLProgramCache::loadDefaultGLProgram(GLProgram *p, int type)
         case kShaderType_LabelOutline:
             p->initWithByteArrays(ccLabel_vert, ccLabelOutline_frag);
             break;
+        case kShaderType_LabelNormal_noMVP:
+            p->initWithByteArrays(ccPositionTextureColor_noMVP_vert, ccLabelNormal_frag);
+            break;
+        case kShaderType_LabelDistanceFieldNormal_noMVP:
+            p->initWithByteArrays(ccPositionTextureColor_noMVP_vert, ccLabelDistanceFieldNormal_frag);
+            break;
         case kShaderType_3DPosition:
             p->initWithByteArrays(cc3D_PositionTex_vert, cc3D_Color_frag);
             break;
@@ -616,6 +649,9 @@ void GLProgramCache::loadDefaultGLProgram(GLProgram *p, int type)
         case kShaderType_CameraClear:
             p->initWithByteArrays(ccCameraClearVert, ccCameraClearFrag);
             break;
+        case kShaderType_ParticleGPU:
+            p->initWithByteArrays(ccParticleGPU_vert, ccPositionTextureColor_frag);
+            break;
             /// ETC1 ALPHA supports.
         case kShaderType_ETC1ASPositionTextureColor:
             p->initWithByteArrays(ccPositionTextureColor_vert, ccETC1ASPositionTextureColor_frag);
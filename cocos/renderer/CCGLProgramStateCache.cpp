@@ -40,6 +40,7 @@ GLProgramStateCache::GLProgramStateCache()
 GLProgramStateCache::~GLProgramStateCache()
 {
     _glProgramStates.clear();
+    _keyedGLProgramStates.clear();
 }
 
 GLProgramStateCache* GLProgramStateCache::getInstance()
@@ -74,6 +75,16 @@ GLProgramState* GLProgramStateCache::getGLProgramState(GLProgram* glprogram)
     return ret;
 }
 
+GLProgramState* GLProgramStateCache::getGLProgramState(const std::string& key)
+{
+    return _keyedGLProgramStates.at(key);
+}
+
+void GLProgramStateCache::addGLProgramState(GLProgramState* glProgramState, const std::string& key)
+{
+    _keyedGLProgramStates.insert(key, glProgramState);
+}
+
 void GLProgramStateCache::removeUnusedGLProgramState()
 {
     for( auto it=_glProgramStates.cbegin(); it!=_glProgramStates.cend(); /* nothing */) {
@@ -87,11 +98,19 @@ void GLProgramStateCache::removeUnusedGLProgramState()
             ++it;
         }
     }
+    for( auto it=_keyedGLProgramStates.cbegin(); it!=_keyedGLProgramStates.cend(); /* nothing */) {
+        if( it->second->getReferenceCount() == 1 ) {
+            it = _keyedGLProgramStates.erase(it);
+        } else {
+            ++it;
+        }
+    }
 }
 
 void GLProgramStateCache::removeAllGLProgramState()
 {
     _glProgramStates.clear();
+    _keyedGLProgramStates.clear();
 }
 
 NS_CC_END
@@ -58,6 +58,14 @@ public:
     
     /**Get the shared GLProgramState by the owner GLProgram.*/
     GLProgramState* getGLProgramState(GLProgram* program);
+    /**Get a shared GLProgramState added with the given key, nullptr if there is none.
+     @since v3.18
+     */
+    GLProgramState* getGLProgramState(const std::string& key);
+    /**Add a shared GLProgramState with the given key, it is retained until the cache is purged.
+     @since v3.18
+     */
+    void addGLProgramState(GLProgramState* glProgramState, const std::string& key);
     /**Remove all the cached GLProgramState.*/
 	void removeAllGLProgramState();
     /**Remove unused GLProgramState.*/
@@ -68,6 +76,7 @@ protected:
     ~GLProgramStateCache();
     
     Map<GLProgram*, GLProgramState*> _glProgramStates;
+    Map<std::string, GLProgramState*> _keyedGLProgramStates;
     static GLProgramStateCache* s_instance;
 };
 
@@ -51,6 +51,7 @@ MeshCommand::MeshCommand()
 , _matrixPaletteSize(0)
 , _materialID(0)
 , _vao(0)
+, _indexOffset(0)
 , _material(nullptr)
 , _glProgramState(nullptr)
 , _stateBlock(nullptr)
@@ -90,6 +91,7 @@ void MeshCommand::init(float globalZOrder,
     _primitive = primitive;
     _indexFormat = indexFormat;
     _indexCount = indexCount;
+    _indexOffset = 0;
     _mv.set(mv);
 
     _is3D = true;
@@ -125,6 +127,7 @@ void MeshCommand::init(float globalZOrder,
     _primitive = primitive;
     _indexFormat = indexFormat;
     _indexCount = indexCount;
+    _indexOffset = 0;
     _mv.set(mv);
     
     _is3D = true;
@@ -222,7 +225,7 @@ void MeshCommand::batchDraw()
         {
             pass->bind(_mv);
 
-            glDrawElements(_primitive, (GLsizei)_indexCount, _indexFormat, 0);
+            glDrawElements(_primitive, (GLsizei)_indexCount, _indexFormat, (GLvoid*)_indexOffset);
             CC_INCREMENT_GL_DRAWN_BATCHES_AND_VERTICES(1, _indexCount);
 
             pass->unbind();
@@ -236,7 +239,7 @@ void MeshCommand::batchDraw()
         applyRenderState();
 
         // Draw
-        glDrawElements(_primitive, (GLsizei)_indexCount, _indexFormat, 0);
+        glDrawElements(_primitive, (GLsizei)_indexCount, _indexFormat, (GLvoid*)_indexOffset);
         CC_INCREMENT_GL_DRAWN_BATCHES_AND_VERTICES(1, _indexCount);
     }
 }
@@ -273,7 +276,7 @@ void MeshCommand::execute()
         {
             pass->bind(_mv, true);
 
-            glDrawElements(_primitive, (GLsizei)_indexCount, _indexFormat, 0);
+            glDrawElements(_primitive, (GLsizei)_indexCount, _indexFormat, (GLvoid*)_indexOffset);
             CC_INCREMENT_GL_DRAWN_BATCHES_AND_VERTICES(1, _indexCount);
 
             pass->unbind();
@@ -287,7 +290,7 @@ void MeshCommand::execute()
         applyRenderState();
 
         // Draw
-        glDrawElements(_primitive, (GLsizei)_indexCount, _indexFormat, 0);
+        glDrawElements(_primitive, (GLsizei)_indexCount, _indexFormat, (GLvoid*)_indexOffset);
         
         CC_INCREMENT_GL_DRAWN_BATCHES_AND_VERTICES(1, _indexCount);
     }
@@ -55,6 +55,8 @@ public:
     void setMatrixPalette(const Vec4* matrixPalette);
     void setMatrixPaletteSize(int size);
     void setLightMask(unsigned int lightmask);
+    /** offset in bytes of the first index to draw in the index buffer, reset to 0 by init() */
+    void setIndexOffset(GLintptr offset) { _indexOffset = offset; }
 
     void execute();
     
@@ -95,6 +97,7 @@ protected:
     GLenum _primitive;
     GLenum _indexFormat;
     ssize_t _indexCount;
+    GLintptr _indexOffset;
     
     // States, default value all false
 
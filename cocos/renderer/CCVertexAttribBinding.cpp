@@ -135,7 +135,7 @@ bool VertexAttribBinding::init(MeshIndexData* meshIndexData, GLProgramState* glP
                                s_attributeNames[meshattribute.vertexAttrib],
                                meshattribute.size,
                                meshattribute.type,
-                               GL_FALSE,
+                               meshattribute.type == GL_FLOAT ? GL_FALSE : GL_TRUE,
                                meshVertexData->getVertexBuffer()->getSizePerVertex(),
                                (GLvoid*)offset);
         offset += meshattribute.attribSizeBytes;
@@ -9,6 +9,7 @@ varying vec2 v_texCoord;
 
 uniform vec4 u_effectColor;
 uniform vec4 u_textColor;
+uniform float u_smoothing;
 
 void main()
 {
@@ -16,7 +17,8 @@ void main()
     //TODO: Implementation 'fwidth' for glsl 1.0
     //float width = fwidth(dist);
     //assign width for constant will lead to a little bit fuzzy,it's temporary measure.
-    float width = 0.04;
+    //Label sets u_smoothing according to the scale of the letters.
+    float width = u_smoothing > 0.0 ? u_smoothing : 0.04;
     float alpha = smoothstep(0.5-width, 0.5+width, dist);
     //glow
     float mu = smoothstep(0.5, 1.0, sqrt(dist));
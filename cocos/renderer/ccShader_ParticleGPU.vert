@@ -0,0 +1,78 @@
+/****************************************************************************
+ Copyright (c) 2017-2018 Xiamen Yaji Software Co., Ltd.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+// ParticleSystemGPU: every particle slot is respawned each period with the same parameters,
+// its age gives its state in closed form.
+const char* ccParticleGPU_vert = R"(
+// xy: corner of the quad, z: spawn time in the period, w: time to live
+attribute vec4 a_position;
+attribute vec4 a_color;
+attribute vec4 a_endColor;
+// gravity mode: start position, velocity; radius mode: angle, angular speed, radius, radius speed
+attribute vec4 a_motion;
+// start size, end size, start rotation, end rotation
+attribute vec4 a_sizeRotation;
+
+// x: time, y: time emission stopped, z: period, w: y coordinate flip
+uniform vec4 u_time;
+// xy: gravity, z: 1 in radius mode, w: 1 to premultiply the colors by alpha
+uniform vec4 u_mode;
+
+#ifdef GL_ES
+varying lowp vec4 v_fragmentColor;
+varying mediump vec2 v_texCoord;
+#else
+varying vec4 v_fragmentColor;
+varying vec2 v_texCoord;
+#endif
+
+void main()
+{
+    float sinceFirstSpawn = u_time.x - a_position.z;
+    float age = mod(sinceFirstSpawn, u_time.z);
+    float spawnTime = u_time.x - age;
+    float alive = step(0.0, sinceFirstSpawn) * step(spawnTime, u_time.y) * step(age, a_position.w);
+    float progress = age / max(a_position.w, 0.0001);
+
+    vec2 gravityPosition = a_motion.xy + (a_motion.zw + 0.5 * u_mode.xy * age) * age * u_time.w;
+    float angle = a_motion.x + a_motion.y * age;
+    float radius = a_motion.z + a_motion.w * age;
+    vec2 radiusPosition = vec2(-cos(angle), -sin(angle) * u_time.w) * radius;
+    vec2 center = mix(gravityPosition, radiusPosition, u_mode.z);
+
+    float size = max(mix(a_sizeRotation.x, a_sizeRotation.y, progress), 0.0) * alive;
+    float rotation = -radians(mix(a_sizeRotation.z, a_sizeRotation.w, progress));
+    float c = cos(rotation);
+    float s = sin(rotation);
+    vec2 corner = a_position.xy * size;
+    vec2 position = center + vec2(corner.x * c - corner.y * s, corner.x * s + corner.y * c);
+
+    gl_Position = CC_MVPMatrix * vec4(position, 0.0, 1.0);
+
+    vec4 color = clamp(mix(a_color, a_endColor, progress), 0.0, 1.0);
+    color.rgb *= mix(1.0, color.a, u_mode.w);
+    v_fragmentColor = color;
+    v_texCoord = vec2(a_position.x + 0.5, 0.5 - a_position.y);
+}
+)";
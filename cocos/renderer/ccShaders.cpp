@@ -93,6 +93,8 @@ NS_CC_BEGIN
 #include "renderer/ccShader_CameraClear.vert"
 #include "renderer/ccShader_CameraClear.frag"
 
+#include "renderer/ccShader_ParticleGPU.vert"
+
 // ETC1 ALPHA support
 #include "renderer/ccShader_ETC1AS_PositionTextureColor.frag"
 #include "renderer/ccShader_ETC1AS_PositionTextureGray.frag"
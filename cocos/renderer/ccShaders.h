@@ -93,6 +93,7 @@ extern CC_DLL const GLchar * cc3D_Terrain_vert;
 extern CC_DLL const GLchar * cc3D_Terrain_frag;
 extern CC_DLL const GLchar * ccCameraClearVert;
 extern CC_DLL const GLchar * ccCameraClearFrag;
+extern CC_DLL const GLchar * ccParticleGPU_vert;
 // ETC1 ALPHA supports.
 extern CC_DLL const GLchar* ccETC1ASPositionTextureColor_frag;
 extern CC_DLL const GLchar* ccETC1ASPositionTextureGray_frag;
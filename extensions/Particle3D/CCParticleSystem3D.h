@@ -31,6 +31,7 @@
 #include <vector>
 #include <map>
 #include <list>
+#include <iterator>
 
 NS_CC_BEGIN
 
@@ -137,6 +138,28 @@ public:
         _locked.clear();
     }
 
+    /** Removes all the datas without deleting them, for the datas the pool doesn't own. */
+    void clearAllDatas(){
+        lockAllDatas();
+        _locked.clear();
+    }
+
+    /** Locks the active datas of datas, which must be in the same order as the active list. */
+    void lockDatas(T* const* datas, size_t count){
+        size_t index = 0;
+        for (auto iter = _released.begin(); iter != _released.end() && index < count;){
+            if (*iter == datas[index]){
+                auto next = std::next(iter);
+                _locked.splice(_locked.end(), _released, iter);
+                iter = next;
+                ++index;
+            }else{
+                ++iter;
+            }
+        }
+        _releasedIter = _released.begin();
+    }
+
 private:
 
     PoolIterator _releasedIter;
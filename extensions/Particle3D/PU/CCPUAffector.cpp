@@ -27,6 +27,7 @@
 #include "extensions/Particle3D/PU/CCPUAffector.h"
 #include "extensions/Particle3D/PU/CCPUEmitter.h"
 #include "extensions/Particle3D/PU/CCPUParticleSystem3D.h"
+#include <algorithm>
 
 NS_CC_BEGIN
 
@@ -48,6 +49,14 @@ void PUAffector::updatePUAffector(PUParticle3D* /*particle*/, float /*delta*/)
     
 }
 
+void PUAffector::updatePUAffectorBatch(PUParticle3D** particles, int count, float delta)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        updatePUAffector(particles[i], delta);
+    }
+}
+
 const Vec3& PUAffector::getDerivedPosition()
 {
     PUParticleSystem3D *ps = static_cast<PUParticleSystem3D *>(_particleSystem);
@@ -232,4 +241,37 @@ void PUAffector::process( PUParticle3D* particle, float delta, bool firstParticl
     updatePUAffector(particle, delta);
 }
 
+void PUAffector::process( PUParticle3D** particles, int count, float delta, bool firstParticle )
+{
+    if (count <= 0)
+        return;
+
+    if (firstParticle){
+        firstParticleUpdate(particles[0], delta);
+    }
+
+    if (_excludedEmitters.empty()){
+        updatePUAffectorBatch(particles, count, delta);
+        return;
+    }
+
+    // the particles of an emitter are usually consecutive, the name is looked up once per run
+    _includedParticles.clear();
+    PUEmitter* emitter = nullptr;
+    bool excluded = false;
+    for (int i = 0; i < count; ++i){
+        PUParticle3D* particle = particles[i];
+        if (particle->parentEmitter != emitter || i == 0){
+            emitter = particle->parentEmitter;
+            excluded = emitter && std::find(_excludedEmitters.begin(), _excludedEmitters.end(), emitter->getName()) != _excludedEmitters.end();
+        }
+        if (!excluded){
+            _includedParticles.push_back(particle);
+        }
+    }
+    if (!_includedParticles.empty()){
+        updatePUAffectorBatch(_includedParticles.data(), (int)_includedParticles.size(), delta);
+    }
+}
+
 NS_CC_END
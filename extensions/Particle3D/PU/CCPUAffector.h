@@ -62,10 +62,19 @@ public:
     virtual void unPrepare();
     virtual void preUpdateAffector(float deltaTime);
     virtual void updatePUAffector(PUParticle3D* particle, float delta);
+    /** Updates count particles at once, calls updatePUAffector() for each of them by default.
+        Affectors override it to keep the work that doesn't depend on the particle out of the loop.
+        @since v3.18
+    */
+    virtual void updatePUAffectorBatch(PUParticle3D** particles, int count, float delta);
     virtual void postUpdateAffector(float deltaTime);
     virtual void firstParticleUpdate(PUParticle3D *particle, float deltaTime);
     virtual void initParticleForEmission(PUParticle3D* particle);
     void process(PUParticle3D* particle, float delta, bool firstParticle);
+    /** Same as process() for count particles, firstParticle tells whether particles[0] is the first one of the frame.
+        @since v3.18
+    */
+    void process(PUParticle3D** particles, int count, float delta, bool firstParticle);
 
     void setLocalPosition(const Vec3 &pos) { _position = pos; };
     const Vec3 getLocalPosition() const { return _position; };
@@ -140,6 +149,9 @@ protected:
     std::string _name;
 
     float _mass;
+
+    /** particles not excluded by _excludedEmitters, reused by the batches */
+    std::vector<PUParticle3D*> _includedParticles;
 };
 
 NS_CC_END
@@ -126,6 +126,56 @@ void PUColorAffector::updatePUAffector( PUParticle3D *particle, float /*deltaTim
     }
 }
 
+void PUColorAffector::updatePUAffectorBatch( PUParticle3D** particles, int count, float /*deltaTime*/ )
+{
+    // Fast rejection
+    if (_colorMap.empty())
+        return;
+
+    // Same interpolation as updatePUAffector() without walking the map for every particle
+    _batchTimes.clear();
+    _batchColors.clear();
+    for (const auto& iter : _colorMap)
+    {
+        _batchTimes.push_back(iter.first);
+        _batchColors.push_back(iter.second);
+    }
+    const int keys = (int)_batchTimes.size();
+    const float* times = _batchTimes.data();
+    const Vec4* colors = _batchColors.data();
+
+    for (int i = 0; i < count; ++i)
+    {
+        PUParticle3D* particle = particles[i];
+        float timeFraction = (particle->totalTimeToLive - particle->timeToLive) / particle->totalTimeToLive;
+
+        // last key not after timeFraction, or the first key when timeFraction is before all of them
+        int k = 0;
+        while (k + 1 < keys && !(timeFraction < times[k + 1]))
+            ++k;
+
+        Vec4 color;
+        if (k + 1 < keys)
+        {
+            color = colors[k] + ((colors[k + 1] - colors[k]) * ((timeFraction - times[k]) / (times[k + 1] - times[k])));
+        }
+        else
+        {
+            color = colors[k];
+        }
+
+        if (_colorOperation == CAO_SET)
+        {
+            particle->color = color;
+        }
+        else
+        {
+            const Vec4& original = particle->originalColor;
+            particle->color = Vec4(color.x * original.x, color.y * original.y, color.z * original.z, color.w * original.w);
+        }
+    }
+}
+
 PUColorAffector* PUColorAffector::create()
 {
     auto pca = new (std::nothrow) PUColorAffector();
@@ -51,6 +51,7 @@ public:
     static PUColorAffector* create();
 
     virtual void updatePUAffector(PUParticle3D *particle, float deltaTime) override;
+    virtual void updatePUAffectorBatch(PUParticle3D** particles, int count, float deltaTime) override;
 
     /** 
     */
@@ -88,6 +89,10 @@ protected:
 
     ColorMap _colorMap;
     ColorOperation _colorOperation;
+
+    /** _colorMap copied in arrays by updatePUAffectorBatch() */
+    std::vector<float> _batchTimes;
+    std::vector<Vec4> _batchColors;
 };
 NS_CC_END
 
@@ -77,6 +77,23 @@ void PUGravityAffector::updatePUAffector( PUParticle3D *particle, float deltaTim
     }
 }
 
+void PUGravityAffector::updatePUAffectorBatch( PUParticle3D** particles, int count, float deltaTime )
+{
+    float scaleVelocity = (static_cast<PUParticleSystem3D *>(_particleSystem))->getParticleSystemScaleVelocity();
+    float gravity = scaleVelocity * _gravity * _mass * deltaTime;
+    for (int i = 0; i < count; ++i)
+    {
+        PUParticle3D *particle = particles[i];
+        Vec3 distance = _derivedPosition - particle->position;
+        float length = distance.lengthSquared();
+        if (length > 0)
+        {
+            float force = gravity * particle->mass / length;
+            particle->direction += force * distance * calculateAffectSpecialisationFactor(particle);
+        }
+    }
+}
+
 void PUGravityAffector::preUpdateAffector( float /*deltaTime*/ )
 {
     getDerivedPosition();
@@ -177,11 +177,14 @@ const unsigned int PUParticleSystem3D::DEFAULT_EMITTED_EMITTER_QUOTA = 50;
 const unsigned int PUParticleSystem3D::DEFAULT_EMITTED_SYSTEM_QUOTA = 10;
 const float PUParticleSystem3D::DEFAULT_MAX_VELOCITY = 9999.0f;
 
+static bool s_batchProcessingEnabled = true;
+
 PUParticleSystem3D::PUParticleSystem3D()
 : _emittedEmitterQuota(DEFAULT_EMITTED_EMITTER_QUOTA)
 , _emittedSystemQuota(DEFAULT_EMITTED_SYSTEM_QUOTA)
 , _prepared(false)
 , _poolPrepared(false)
+, _particleStorage(nullptr)
 , _particleSystemScaleVelocity(1.0f)
 , _timeElapsedSinceStart(0.0f)
 , _defaultWidth(DEFAULT_WIDTH)
@@ -199,7 +202,7 @@ PUParticleSystem3D::~PUParticleSystem3D()
     stopParticleSystem();
     unPrepared();
 
-    _particlePool.removeAllDatas();
+    releaseParticleStorage();
 
     for (auto iter : _emittedEmitterParticlePool){
         auto pool = iter.second;
@@ -534,8 +537,10 @@ void PUParticleSystem3D::prepared()
 
             }
 
-            for (unsigned int i = 0; i < _particleQuota; ++i){
-                auto p = new (std::nothrow) PUParticle3D();
+            // the visual particles are contiguous, the affectors go through them in batches
+            _particleStorage = new (std::nothrow) PUParticle3D[_particleQuota];
+            for (unsigned int i = 0; _particleStorage && i < _particleQuota; ++i){
+                auto p = &_particleStorage[i];
                 p->copyBehaviours(_behaviourTemplates);
                 _particlePool.addData(p);
             }
@@ -658,6 +663,19 @@ void PUParticleSystem3D::updator( float elapsedTime )
 {
     bool firstActiveParticle = true;
     bool firstParticle = true;
+    if (s_batchProcessingEnabled){
+        processParticleBatch(_particlePool, firstActiveParticle, firstParticle, elapsedTime);
+
+        for (auto &iter : _emittedEmitterParticlePool){
+            processParticleBatch(iter.second, firstActiveParticle, firstParticle, elapsedTime);
+        }
+
+        for (auto &iter : _emittedSystemParticlePool){
+            processParticleBatch(iter.second, firstActiveParticle, firstParticle, elapsedTime);
+        }
+        return;
+    }
+
     processParticle(_particlePool, firstActiveParticle, firstParticle, elapsedTime);
 
     for (auto &iter : _emittedEmitterParticlePool){
@@ -1073,7 +1091,7 @@ void PUParticleSystem3D::copyAttributesTo(PUParticleSystem3D* system )
     system->removerAllObserver();
     system->removeAllBehaviourTemplate();
     system->removeAllListener();
-    system->_particlePool.removeAllDatas();
+    system->releaseParticleStorage();
     for (auto iter : system->_emittedEmitterParticlePool){
         iter.second.removeAllDatas();
     }
@@ -1298,6 +1316,128 @@ void PUParticleSystem3D::processParticle( ParticlePool &pool, bool &firstActiveP
     }
 }
 
+void PUParticleSystem3D::processParticleBatch( ParticlePool &pool, bool &firstActiveParticle, bool &firstParticle, float elapsedTime )
+{
+    Vec3 scale = getDerivedScale();
+
+    // Same steps as processParticle(), except that every affector processes all the live particles
+    // of the pool in a row. The particles emitted in the pool meanwhile are appended to it, they are
+    // processed by the next rounds. The expired particles are locked at the end of their round.
+    size_t processed = 0;
+    while (true){
+        _batchParticles.clear();
+        _batchAliveParticles.clear();
+        _batchExpiredParticles.clear();
+        _batchAlive.clear();
+
+        size_t index = 0;
+        PUParticle3D *particle = static_cast<PUParticle3D *>(pool.getFirst());
+        while (particle){
+            if (index++ >= processed)
+                _batchParticles.push_back(particle);
+            particle = static_cast<PUParticle3D *>(pool.getNext());
+        }
+        if (_batchParticles.empty())
+            break;
+
+        const int count = (int)_batchParticles.size();
+        for (int i = 0; i < count; ++i){
+            particle = _batchParticles[i];
+            bool alive = !isExpired(particle, elapsedTime);
+            if (alive){
+                particle->process(elapsedTime);
+
+                for (auto it : _emitters) {
+                    if (it->isEnabled() && !it->isMarkedForEmission()){
+                        (static_cast<PUEmitter*>(it))->updateEmitter(particle, elapsedTime);
+                    }
+                }
+                _batchAliveParticles.push_back(particle);
+            }else{
+                initParticleForExpiration(particle, elapsedTime);
+                _batchExpiredParticles.push_back(particle);
+            }
+            _batchAlive.push_back(alive);
+        }
+
+        const int aliveCount = (int)_batchAliveParticles.size();
+        if (aliveCount > 0){
+            for (auto& it : _affectors) {
+                if (it->isEnabled()){
+                    (static_cast<PUAffector*>(it))->process(_batchAliveParticles.data(), aliveCount, elapsedTime, firstActiveParticle);
+                }
+            }
+        }
+
+        for (int i = 0; i < count; ++i){
+            particle = _batchParticles[i];
+            if (_batchAlive[i]){
+                if (_render)
+                    static_cast<PURender *>(_render)->updateRender(particle, elapsedTime, firstActiveParticle);
+
+                if (_isEnabled && particle->particleType != PUParticle3D::PT_VISUAL){
+                    if (particle->particleType == PUParticle3D::PT_EMITTER){
+                        auto emitter = static_cast<PUEmitter *>(particle->particleEntityPtr);
+                        emitter->setLocalPosition(particle->position);
+                        executeEmitParticles(emitter, emitter->calculateRequestedParticles(elapsedTime), elapsedTime);
+                    }else if (particle->particleType == PUParticle3D::PT_TECHNIQUE){
+                        auto system = static_cast<PUParticleSystem3D *>(particle->particleEntityPtr);
+                        system->setPosition3D(particle->position);
+                        system->setRotationQuat(particle->orientation);
+                        system->forceUpdate(elapsedTime);
+                    }
+                }
+
+                firstActiveParticle = false;
+                // Keep latest position
+                particle->latestPosition = particle->position;
+                processMotion(particle, elapsedTime, scale, firstActiveParticle);
+            }
+
+            for (auto it : _observers){
+                if (it->isEnabled()){
+                    it->updateObserver(particle, elapsedTime, firstParticle);
+                }
+            }
+
+            if (particle->hasEventFlags(PUParticle3D::PEF_EXPIRED))
+            {
+                particle->setEventFlags(0);
+                particle->addEventFlags(PUParticle3D::PEF_EXPIRED);
+            }
+            else
+            {
+                particle->setEventFlags(0);
+            }
+
+            particle->timeToLive -= elapsedTime;
+            firstParticle = false;
+        }
+
+        if (!_batchExpiredParticles.empty())
+            pool.lockDatas(_batchExpiredParticles.data(), _batchExpiredParticles.size());
+        processed += aliveCount;
+    }
+}
+
+void PUParticleSystem3D::releaseParticleStorage()
+{
+    // the visual particles belong to _particleStorage
+    _particlePool.clearAllDatas();
+    delete [] _particleStorage;
+    _particleStorage = nullptr;
+}
+
+void PUParticleSystem3D::setBatchProcessingEnabled( bool enabled )
+{
+    s_batchProcessingEnabled = enabled;
+}
+
+bool PUParticleSystem3D::isBatchProcessingEnabled()
+{
+    return s_batchProcessingEnabled;
+}
+
 bool PUParticleSystem3D::makeParticleLocal( PUParticle3D* particle )
 {
     if (!particle)
@@ -229,6 +229,15 @@ public:
     static PUParticleSystem3D* create();
     static PUParticleSystem3D* create(const std::string &filePath);
     static PUParticleSystem3D* create(const std::string &filePath, const std::string &materialPath);
+
+    /**
+     * Whether the affectors process the particles of a pool in batches, true by default.
+     * When it is false every particle goes through all the affectors in turn, e.g. to compare them in a benchmark.
+     * Should be called between two frames.
+     * @since v3.18
+     */
+    static void setBatchProcessingEnabled(bool enabled);
+    static bool isBatchProcessingEnabled();
     
     virtual void draw(Renderer *renderer, const Mat4 &transform, uint32_t flags) override;
 
@@ -374,6 +383,8 @@ protected:
     void executeEmitParticles(PUEmitter* emitter, unsigned requested, float elapsedTime);
     void emitParticles(ParticlePool &pool, PUEmitter* emitter, unsigned requested, float elapsedTime);
     void processParticle(ParticlePool &pool, bool &firstActiveParticle, bool &firstParticle, float elapsedTime);
+    void processParticleBatch(ParticlePool &pool, bool &firstActiveParticle, bool &firstParticle, float elapsedTime);
+    void releaseParticleStorage();
     void processMotion(PUParticle3D* particle, float timeElapsed, const Vec3 &scl, bool firstParticle);
     void notifyRescaled(const Vec3 &scl);
     void initParticleForEmission(PUParticle3D* particle);
@@ -402,6 +413,12 @@ protected:
     bool                                _prepared;
     bool                                _poolPrepared;
 
+    PUParticle3D*                       _particleStorage; //The visual particles of _particlePool, allocated at once.
+    std::vector<PUParticle3D*>          _batchParticles; //The particles of the batch being processed, in the order of the pool.
+    std::vector<PUParticle3D*>          _batchAliveParticles;
+    std::vector<Particle3D*>            _batchExpiredParticles;
+    std::vector<bool>                   _batchAlive;
+
     float                               _particleSystemScaleVelocity;
     float                               _timeElapsedSinceStart;
 
@@ -27,8 +27,141 @@
 #include "CCPUScriptCompiler.h"
 #include "extensions/Particle3D/PU/CCPUTranslateManager.h"
 #include "platform/CCFileUtils.h"
+#include "base/CCData.h"
+#include <string.h>
 NS_CC_BEGIN
 
+namespace
+{
+    // Compiled script layout, all values little endian.
+    // Must match tools/particle/compile_particles.py.
+    struct BinaryHeader
+    {
+        char magic[4];              // "CCPU"
+        uint32_t version;
+        uint32_t nodeCount;
+        uint32_t rootCount;
+        uint32_t nodesOffset;
+        uint32_t stringsOffset;
+        uint32_t stringsSize;
+        uint32_t reserved;
+    };
+
+    // The nodes are stored depth first: a node, then its values, then its children.
+    struct BinaryNode
+    {
+        uint32_t type;              // PUAbstractNodeType: atom, object or property
+        uint32_t line;
+        uint32_t valueOffset;       // atom value, object class or property name
+        uint32_t valueLength;
+        uint32_t nameOffset;        // object name
+        uint32_t nameLength;
+        uint32_t valueCount;
+        uint32_t childCount;
+    };
+
+    const char BINARY_MAGIC[4] = { 'C', 'C', 'P', 'U' };
+    const uint32_t BINARY_VERSION = 1;
+
+    bool inRange(size_t offset, size_t length, size_t size)
+    {
+        return offset <= size && length <= size - offset;
+    }
+
+    class BinaryReader
+    {
+    public:
+        BinaryReader(const unsigned char* bytes, const BinaryHeader& header, const std::string& file)
+        : _nodes(bytes + header.nodesOffset)
+        , _strings((const char*)bytes + header.stringsOffset)
+        , _header(header)
+        , _file(file)
+        , _next(0)
+        {
+        }
+
+        PUAbstractNode* readNode(PUAbstractNode* parent)
+        {
+            if (_next >= _header.nodeCount)
+                return nullptr;
+
+            BinaryNode record;
+            memcpy(&record, _nodes + (size_t)_next * sizeof(BinaryNode), sizeof(record));
+            ++_next;
+
+            std::string value, name;
+            if (!getString(record.valueOffset, record.valueLength, &value)
+                || !getString(record.nameOffset, record.nameLength, &name))
+                return nullptr;
+
+            PUAbstractNode* node = nullptr;
+            PUAbstractNodeList* values = nullptr;
+            PUAbstractNodeList* children = nullptr;
+            if (record.type == ANT_OBJECT)
+            {
+                auto object = new (std::nothrow) PUObjectAbstractNode(parent);
+                object->cls = value;
+                object->name = name;
+                values = &object->values;
+                children = &object->children;
+                node = object;
+            }
+            else if (record.type == ANT_PROPERTY)
+            {
+                auto property = new (std::nothrow) PUPropertyAbstractNode(parent);
+                property->name = value;
+                values = &property->values;
+                node = property;
+            }
+            else if (record.type == ANT_ATOM)
+            {
+                auto atom = new (std::nothrow) PUAtomAbstractNode(parent);
+                atom->value = value;
+                node = atom;
+            }
+            if (!node)
+                return nullptr;
+            node->file = _file;
+            node->line = record.line;
+
+            if ((record.valueCount > 0 && !values) || (record.childCount > 0 && !children)
+                || !readNodes(node, record.valueCount, values) || !readNodes(node, record.childCount, children))
+            {
+                delete node;
+                return nullptr;
+            }
+            return node;
+        }
+
+    private:
+        bool readNodes(PUAbstractNode* parent, uint32_t count, PUAbstractNodeList* list)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                PUAbstractNode* node = readNode(parent);
+                if (!node)
+                    return false;
+                list->push_back(node);
+            }
+            return true;
+        }
+
+        bool getString(uint32_t offset, uint32_t length, std::string* value) const
+        {
+            if (!inRange(offset, length, _header.stringsSize))
+                return false;
+            value->assign(_strings + offset, length);
+            return true;
+        }
+
+        const unsigned char* _nodes;
+        const char* _strings;
+        const BinaryHeader& _header;
+        const std::string& _file;
+        uint32_t _next;
+    };
+}
+
 // ObjectAbstractNode
 PUObjectAbstractNode::PUObjectAbstractNode(PUAbstractNode *ptr)
 :PUAbstractNode(ptr), id(0), abstract(false)
@@ -228,21 +361,28 @@ const PUAbstractNodeList* PUScriptCompiler::compile(const std::string &file, boo
         return &iter->second;
     }
 
-    std::string data = FileUtils::getInstance()->getStringFromFile(file);
-    PUScriptLexer lexer;
-    PUScriptParser parser;
-    PUScriptTokenList tokenList;
-    PUConcreteNodeList creteNodeList;
-    lexer.openLexer(data, file, tokenList);
-    parser.parse(creteNodeList, tokenList);
-    bool state = compile(creteNodeList, file);
-
-    for (auto iter1 : creteNodeList){
-        delete iter1;
+    Data fileData = FileUtils::getInstance()->getDataFromFile(file);
+    bool state = false;
+    if (isBinary(fileData.getBytes(), fileData.getSize())){
+        state = compileBinary(fileData.getBytes(), fileData.getSize(), file);
     }
+    else{
+        std::string data((const char*)fileData.getBytes(), fileData.getSize());
+        PUScriptLexer lexer;
+        PUScriptParser parser;
+        PUScriptTokenList tokenList;
+        PUConcreteNodeList creteNodeList;
+        lexer.openLexer(data, file, tokenList);
+        parser.parse(creteNodeList, tokenList);
+        state = compile(creteNodeList, file);
+
+        for (auto iter1 : creteNodeList){
+            delete iter1;
+        }
 
-    for (auto iter2 : tokenList){
-        delete iter2;
+        for (auto iter2 : tokenList){
+            delete iter2;
+        }
     }
 
     isFirstCompile = true;
@@ -399,6 +539,42 @@ void PUScriptCompiler::visit(PUConcreteNode *node)
     }
 }
 
+bool PUScriptCompiler::isBinary(const unsigned char* bytes, size_t size)
+{
+    return bytes && size >= sizeof(BinaryHeader) && memcmp(bytes, BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0;
+}
+
+bool PUScriptCompiler::compileBinary(const unsigned char* bytes, size_t size, const std::string &file)
+{
+    BinaryHeader header;
+    memcpy(&header, bytes, sizeof(header));
+    if (header.version != BINARY_VERSION
+        || !inRange(header.nodesOffset, (size_t)header.nodeCount * sizeof(BinaryNode), size)
+        || !inRange(header.stringsOffset, header.stringsSize, size)
+        || header.rootCount == 0)
+    {
+        CCLOG("PUScriptCompiler: malformed compiled script %s", file.c_str());
+        return false;
+    }
+
+    BinaryReader reader(bytes, header, file);
+    PUAbstractNodeList aNodes;
+    for (uint32_t i = 0; i < header.rootCount; ++i){
+        PUAbstractNode* node = reader.readNode(nullptr);
+        if (!node){
+            CCLOG("PUScriptCompiler: malformed compiled script %s", file.c_str());
+            for (auto iter : aNodes){
+                delete iter;
+            }
+            return false;
+        }
+        aNodes.push_back(node);
+    }
+
+    _compiledScripts[file] = aNodes;
+    return true;
+}
+
 void PUScriptCompiler::setParticleSystem3D( PUParticleSystem3D *pu )
 {
     _PUParticleSystem3D = pu;
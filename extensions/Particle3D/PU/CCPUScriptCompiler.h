@@ -134,6 +134,8 @@ class CC_DLL PUScriptCompiler
 
 private:
     bool compile(const PUConcreteNodeList &nodes, const std::string &file);
+    //compiled scripts hold the abstract nodes, nothing is parsed//
+    bool compileBinary(const unsigned char* bytes, size_t size, const std::string &file);
     //is it excluded?//
     bool isNameExcluded(const std::string &cls, PUAbstractNode *parent);
     
@@ -144,7 +146,15 @@ public:
 
     void setParticleSystem3D(PUParticleSystem3D *pu);
 
+    /** Compiles a script or material file, either text or compiled by tools/particle/compile_particles.py.
+        The result is cached by file name.
+    */
     const PUAbstractNodeList* compile(const std::string &file, bool &isFirstCompile);
+
+    /** Checks whether the data starts like a compiled script.
+        @since v3.18
+    */
+    static bool isBinary(const unsigned char* bytes, size_t size);
     
     void convertToAST(const PUConcreteNodeList &nodes,PUAbstractNodeList &aNodes);
     
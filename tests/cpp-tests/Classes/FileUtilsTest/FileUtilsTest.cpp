@@ -49,6 +49,10 @@ FileUtilsTests::FileUtilsTests()
     ADD_TEST_CASE(TestWriteDataAsync);
     ADD_TEST_CASE(TestListFiles);
     ADD_TEST_CASE(TestIsFileExistRejectFolder);
+    ADD_TEST_CASE(TestAssetPack);
+    ADD_TEST_CASE(TestFullPathIndex);
+    ADD_TEST_CASE(TestLoadFilesAsync);
+    ADD_TEST_CASE(TestMappedData);
 }
 
 // TestResolutionDirectories
@@ -1484,3 +1488,280 @@ std::string TestIsFileExistRejectFolder::subtitle() const
 {
     return "";
 }
+
+// TestAssetPack
+
+void TestAssetPack::onEnter()
+{
+    FileUtilsDemo::onEnter();
+    auto fs = FileUtils::getInstance();
+    auto winSize = Director::getInstance()->getWinSize();
+
+    auto readResult = Label::createWithTTF("show readResult", "fonts/Thonburi.ttf", 18);
+    this->addChild(readResult);
+    readResult->setPosition(winSize.width / 2, winSize.height / 2);
+
+    // packs can't be mapped from inside an apk, copy it to the writable path first
+    _packPath = fs->getWritablePath() + "assets.ccpk";
+    fs->writeDataToFile(fs->getDataFromFile("Misc/assets.ccpk"), _packPath);
+
+    auto runTests = [&]() {
+        if (!fs->mountAssetPack(_packPath, true))
+            return std::string("failed: mount");
+
+        if (!fs->isFileExist("pack/hello.txt") || fs->isFileExist("pack/missing.txt"))
+            return std::string("failed: isFileExist");
+
+        // stored entry, returned without copy
+        Data hello = fs->getDataFromFile("pack/hello.txt");
+        if (!hello.isView())
+            return std::string("failed: hello.txt is not a view");
+        if (std::string((const char*)hello.getBytes(), hello.getSize()) != "Hello from an asset pack!")
+            return std::string("failed: hello.txt content");
+
+        // lz4 entry
+        ValueMap frames = fs->getValueMapFromFile("pack/frames.plist");
+        if (frames["frames"].asValueMap().size() != 40)
+            return std::string("failed: frames.plist content");
+
+        fs->unmountAssetPack(_packPath);
+        if (fs->isFileExist("pack/hello.txt"))
+            return std::string("failed: unmount");
+
+        // views keep the mapping alive
+        if (std::string((const char*)hello.getBytes(), hello.getSize()) != "Hello from an asset pack!")
+            return std::string("failed: view after unmount");
+
+        return std::string("read success");
+    };
+    readResult->setString("AssetPack: " + runTests());
+}
+
+void TestAssetPack::onExit()
+{
+    auto fs = FileUtils::getInstance();
+    fs->unmountAssetPack(_packPath);
+    fs->removeFile(_packPath);
+
+    FileUtilsDemo::onExit();
+}
+
+std::string TestAssetPack::title() const
+{
+    return "FileUtils: memory mapped asset pack";
+}
+
+std::string TestAssetPack::subtitle() const
+{
+    return "";
+}
+
+// TestFullPathIndex
+
+void TestFullPathIndex::onEnter()
+{
+    FileUtilsDemo::onEnter();
+    auto fs = FileUtils::getInstance();
+    auto winSize = Director::getInstance()->getWinSize();
+
+    auto readResult = Label::createWithTTF("show readResult", "fonts/Thonburi.ttf", 18);
+    this->addChild(readResult);
+    readResult->setPosition(winSize.width / 2, winSize.height / 2);
+
+    fs->purgeCachedEntries();
+    _defaultSearchPathArray = fs->getOriginalSearchPaths();
+    _defaultResolutionsOrderArray = fs->getSearchResolutionsOrder();
+
+    std::vector<std::string> searchPaths = _defaultSearchPathArray;
+    searchPaths.insert(searchPaths.begin(), "Misc");
+    fs->setSearchPaths(searchPaths);
+
+    std::vector<std::string> resolutionsOrder = _defaultResolutionsOrderArray;
+    resolutionsOrder.insert(resolutionsOrder.begin(), "resources-ipadhd");
+    resolutionsOrder.insert(resolutionsOrder.begin() + 1, "resources-hd");
+    fs->setSearchResolutionsOrder(resolutionsOrder);
+
+    std::vector<std::string> filenames = { "fileLookup.plist", "test1.txt", "test2.txt", "test5.txt", "fonts/Thonburi.ttf", "missing.txt" };
+
+    auto runTests = [&]() {
+        std::vector<std::string> expected;
+        for (const auto& filename : filenames)
+            expected.push_back(fs->fullPathForFilename(filename));
+
+        if (!fs->buildFullPathIndex())
+            return std::string("index not supported on this platform");
+
+        for (size_t i = 0; i < filenames.size(); ++i)
+        {
+            auto fullPath = fs->fullPathForFilename(filenames[i]);
+            log("%s -> %s", filenames[i].c_str(), fullPath.c_str());
+            if (fullPath != expected[i])
+                return "failed: " + filenames[i] + " -> " + fullPath + ", expected " + expected[i];
+        }
+        return std::string("same results with and without index");
+    };
+    readResult->setString("FullPathIndex: " + runTests());
+}
+
+void TestFullPathIndex::onExit()
+{
+    auto fs = FileUtils::getInstance();
+    fs->clearFullPathIndex();
+    fs->setSearchPaths(_defaultSearchPathArray);
+    fs->setSearchResolutionsOrder(_defaultResolutionsOrderArray);
+
+    FileUtilsDemo::onExit();
+}
+
+std::string TestFullPathIndex::title() const
+{
+    return "FileUtils: full path index";
+}
+
+std::string TestFullPathIndex::subtitle() const
+{
+    return "See the console";
+}
+
+// TestLoadFilesAsync
+
+void TestLoadFilesAsync::onEnter()
+{
+    FileUtilsDemo::onEnter();
+    auto fs = FileUtils::getInstance();
+    auto winSize = Director::getInstance()->getWinSize();
+
+    auto progressLabel = Label::createWithTTF("loading...", "fonts/Thonburi.ttf", 18);
+    this->addChild(progressLabel);
+    progressLabel->setPosition(winSize.width / 2, winSize.height / 2);
+
+    std::vector<std::string> filenames;
+    auto files = fs->listFiles("Particles");
+    for (const auto& file : files)
+    {
+        if (fs->getFileExtension(file) == ".plist")
+            filenames.push_back(file);
+    }
+    filenames.push_back("missing.plist");
+
+    _batch = fs->loadFilesAsync(filenames);
+
+    schedule([=](float) {
+        auto progress = _batch->getProgress();
+        if (!_batch->isDone())
+        {
+            progressLabel->setString(StringUtils::format("%zu / %zu files", progress.filesLoaded, progress.fileCount));
+            return;
+        }
+
+        size_t failed = 0;
+        for (size_t i = 0; i < _batch->getFileCount(); ++i)
+        {
+            if (_batch->getStatus(i) != FileUtils::Status::OK)
+                ++failed;
+        }
+        progressLabel->setString(StringUtils::format("%zu files, %zu KB in %.1f ms (%.1f MB/s), %zu failed (expected 1)",
+                                                     progress.fileCount, progress.bytesLoaded / 1024,
+                                                     progress.elapsedTime * 1000, progress.throughput / (1024 * 1024), failed));
+        unschedule("progress");
+    }, "progress");
+}
+
+void TestLoadFilesAsync::onExit()
+{
+    _batch.reset();
+    FileUtilsDemo::onExit();
+}
+
+std::string TestLoadFilesAsync::title() const
+{
+    return "FileUtils: loadFilesAsync";
+}
+
+std::string TestLoadFilesAsync::subtitle() const
+{
+    return "Reads every particle plist";
+}
+
+// TestMappedData
+
+void TestMappedData::onEnter()
+{
+    FileUtilsDemo::onEnter();
+    auto fs = FileUtils::getInstance();
+    auto winSize = Director::getInstance()->getWinSize();
+
+    auto readResult = Label::createWithTTF("show readResult", "fonts/Thonburi.ttf", 18);
+    this->addChild(readResult);
+    readResult->setPosition(winSize.width / 2, winSize.height / 2);
+
+    _filePath = fs->getWritablePath() + "mapped.txt";
+    _emptyFilePath = fs->getWritablePath() + "mapped_empty.txt";
+    _packPath = fs->getWritablePath() + "assets.ccpk";
+
+    auto sameData = [](const Data& data, const Data& expected) {
+        return data.getSize() == expected.getSize()
+            && (data.getSize() == 0 || memcmp(data.getBytes(), expected.getBytes(), data.getSize()) == 0);
+    };
+
+    auto runTests = [&]() {
+        std::string content = "Hello from a mapped file!";
+        if (!fs->writeStringToFile(content, _filePath) || !fs->writeStringToFile("", _emptyFilePath))
+            return std::string("failed: write");
+
+        // a regular file is mapped, the data is a view of the mapping
+        Data mapped = fs->getMappedDataFromFile(_filePath);
+#if CC_TARGET_PLATFORM != CC_PLATFORM_WINRT
+        if (!mapped.isView())
+            return std::string("failed: mapped.txt is not a view");
+#endif
+        if (std::string((const char*)mapped.getBytes(), mapped.getSize()) != content)
+            return std::string("failed: mapped.txt content");
+
+        // the files which can't be mapped are read the regular way: empty files, the resources inside
+        // an apk, and the compressed entries of asset packs
+        if (!sameData(fs->getMappedDataFromFile(_emptyFilePath), fs->getDataFromFile(_emptyFilePath)))
+            return std::string("failed: empty file");
+        if (!sameData(fs->getMappedDataFromFile("Particles/Galaxy.plist"), fs->getDataFromFile("Particles/Galaxy.plist")))
+            return std::string("failed: Galaxy.plist content");
+
+        fs->writeDataToFile(fs->getDataFromFile("Misc/assets.ccpk"), _packPath);
+        if (!fs->mountAssetPack(_packPath, true))
+            return std::string("failed: mount");
+        Data frames = fs->getMappedDataFromFile("pack/frames.plist");
+        if (frames.isNull() || !sameData(frames, fs->getDataFromFile("pack/frames.plist")))
+            return std::string("failed: frames.plist content");
+
+        if (!fs->getMappedDataFromFile("missing.txt").isNull())
+            return std::string("failed: missing file");
+
+        // the view keeps the mapping alive
+        fs->removeFile(_filePath);
+        if (std::string((const char*)mapped.getBytes(), mapped.getSize()) != content)
+            return std::string("failed: view after remove");
+
+        return std::string("read success");
+    };
+    readResult->setString("MappedData: " + runTests());
+}
+
+void TestMappedData::onExit()
+{
+    auto fs = FileUtils::getInstance();
+    fs->unmountAssetPack(_packPath);
+    fs->removeFile(_packPath);
+    fs->removeFile(_filePath);
+    fs->removeFile(_emptyFilePath);
+
+    FileUtilsDemo::onExit();
+}
+
+std::string TestMappedData::title() const
+{
+    return "FileUtils: getMappedDataFromFile";
+}
+
+std::string TestMappedData::subtitle() const
+{
+    return "";
+}
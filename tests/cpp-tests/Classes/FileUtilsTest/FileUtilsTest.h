@@ -280,4 +280,59 @@ public:
     virtual std::string subtitle() const override;
 };
 
+class TestAssetPack : public FileUtilsDemo
+{
+public:
+    CREATE_FUNC(TestAssetPack);
+
+    virtual void onEnter() override;
+    virtual void onExit() override;
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+private:
+    std::string _packPath;
+};
+
+class TestFullPathIndex : public FileUtilsDemo
+{
+public:
+    CREATE_FUNC(TestFullPathIndex);
+
+    virtual void onEnter() override;
+    virtual void onExit() override;
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+private:
+    std::vector<std::string> _defaultSearchPathArray;
+    std::vector<std::string> _defaultResolutionsOrderArray;
+};
+
+class TestLoadFilesAsync : public FileUtilsDemo
+{
+public:
+    CREATE_FUNC(TestLoadFilesAsync);
+
+    virtual void onEnter() override;
+    virtual void onExit() override;
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+private:
+    std::shared_ptr<cocos2d::FileLoadBatch> _batch;
+};
+
+class TestMappedData : public FileUtilsDemo
+{
+public:
+    CREATE_FUNC(TestMappedData);
+
+    virtual void onEnter() override;
+    virtual void onExit() override;
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+private:
+    std::string _filePath;
+    std::string _emptyFilePath;
+    std::string _packPath;
+};
+
 #endif /* __FILEUTILSTEST_H__ */
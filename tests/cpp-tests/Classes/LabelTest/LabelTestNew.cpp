@@ -23,9 +23,12 @@
  ****************************************************************************/
 
 #include "LabelTestNew.h"
+#include <algorithm>
+#include <set>
 #include "../testResource.h"
 #include "renderer/CCRenderer.h"
 #include "2d/CCFontAtlasCache.h"
+#include "2d/CCFontAtlas.h"
 
 USING_NS_CC;
 using namespace ui;
@@ -141,6 +144,10 @@ NewLabelTests::NewLabelTests()
     ADD_TEST_CASE(LabelIssueLineGap);
     ADD_TEST_CASE(LabelIssue17902);
     ADD_TEST_CASE(LabelLetterColorsTest);
+    ADD_TEST_CASE(LabelTTFAsyncRasterization);
+    ADD_TEST_CASE(LabelTTFSharedDistanceField);
+    ADD_TEST_CASE(LabelIncrementalLayout);
+    ADD_TEST_CASE(LabelBatchedLeaderboard);
 };
 
 LabelFNTColorAndOpacity::LabelFNTColorAndOpacity()
@@ -3600,3 +3607,231 @@ void LabelLetterColorsTest::setLetterColors(cocos2d::Label* label, const cocos2d
             letter->setColor(color);
     }
 }
+
+//
+// LabelTTFAsyncRasterization
+//
+LabelTTFAsyncRasterization::LabelTTFAsyncRasterization()
+{
+    auto center = VisibleRect::center();
+
+    // a size no other test uses, so that the atlas is not shared
+    TTFConfig ttfConfig("fonts/HKYuanMini.ttf", 27, GlyphCollection::DYNAMIC);
+    auto label = Label::createWithTTF(ttfConfig, "", TextHAlignment::CENTER, VisibleRect::getVisibleRect().size.width * 0.8f);
+    label->getFontAtlas()->setAsyncRasterizationEnabled(true);
+    label->setString("五六七八This is a very long sentence一二三四.\n" "中国中国中国中国中国");
+    label->setPosition(center.x, center.y + 40);
+    addChild(label);
+
+    auto status = Label::createWithTTF("Prewarming...", "fonts/arial.ttf", 20);
+    status->setPosition(center.x, center.y - 60);
+    addChild(status);
+
+    auto startTime = std::chrono::steady_clock::now();
+    retain();
+    label->getFontAtlas()->prewarmCharset("的一是不了人我在有他这为之大来以个中上们到说国和地也子时道出而要于就下得可你年生自会那后能对着事其里所去行过家十用发天如然作方成者多日都三小军二无同么经法当起与好看学进种将还分此心前面又定见只主没公从",
+        [this, status, startTime]() {
+            auto duration = std::chrono::steady_clock::now() - startTime;
+            status->setString(StringUtils::format("Prewarmed in %d ms", (int)std::chrono::duration_cast<std::chrono::milliseconds>(duration).count()));
+            release();
+        });
+}
+
+std::string LabelTTFAsyncRasterization::title() const
+{
+    return "Background glyph rasterization";
+}
+
+std::string LabelTTFAsyncRasterization::subtitle() const
+{
+    return "The glyphs appear a few frames later, without moving the text";
+}
+
+//
+// LabelTTFSharedDistanceField
+//
+LabelTTFSharedDistanceField::LabelTTFSharedDistanceField()
+{
+    auto visibleRect = VisibleRect::getVisibleRect();
+    FontAtlasCache::setSharedDistanceFieldEnabled(true);
+
+    std::set<FontAtlas*> atlases;
+    float y = visibleRect.getMaxY() - 60;
+    for (int i = 0; i < 12; ++i)
+    {
+        TTFConfig ttfConfig("fonts/arial.ttf", 8 + i * 3, GlyphCollection::DYNAMIC, nullptr, true);
+        auto label = Label::createWithTTF(ttfConfig, StringUtils::format("Size %d, shared atlas", (int)ttfConfig.fontSize));
+        label->setAnchorPoint(Vec2::ANCHOR_MIDDLE_TOP);
+        label->setPosition(i < 6 ? visibleRect.origin.x + visibleRect.size.width * 0.25f : visibleRect.origin.x + visibleRect.size.width * 0.75f, y);
+        if (i == 11)
+        {
+            label->enableGlow(Color4B::YELLOW);
+        }
+        addChild(label);
+        atlases.insert(label->getFontAtlas());
+
+        y -= label->getContentSize().height + 6;
+        if (i == 5)
+        {
+            y = visibleRect.getMaxY() - 60;
+        }
+    }
+
+    auto info = Label::createWithTTF(StringUtils::format("12 sizes, %d atlas", (int)atlases.size()), "fonts/arial.ttf", 18);
+    info->setPosition(visibleRect.getMidX(), visibleRect.origin.y + 40);
+    addChild(info);
+
+    FontAtlasCache::setSharedDistanceFieldEnabled(false);
+}
+
+std::string LabelTTFSharedDistanceField::title() const
+{
+    return "Shared distance field atlas";
+}
+
+std::string LabelTTFSharedDistanceField::subtitle() const
+{
+    return "All the sizes should be sharp and use a single atlas";
+}
+
+//
+// LabelIncrementalLayout
+//
+LabelIncrementalLayout::LabelIncrementalLayout()
+: _frames(0)
+{
+    auto visibleRect = VisibleRect::getVisibleRect();
+
+    // the digits of arial have the same advance, the counter only swaps quads
+    _counter = Label::createWithTTF("Score: 0000000", "fonts/arial.ttf", 24);
+    _counter->setAnchorPoint(Vec2::ANCHOR_TOP_LEFT);
+    _counter->setPosition(visibleRect.origin.x + 20, visibleRect.getMaxY() - 50);
+    addChild(_counter);
+
+    // appending a line only lays out the last lines
+    _chat = Label::createWithTTF("", "fonts/arial.ttf", 16, Size(visibleRect.size.width * 0.5f, 0));
+    _chat->setAnchorPoint(Vec2::ANCHOR_TOP_LEFT);
+    _chat->setPosition(visibleRect.origin.x + 20, visibleRect.getMaxY() - 90);
+    addChild(_chat);
+
+    Size shrinkSize(visibleRect.size.width * 0.35f, 80);
+    _shrink = Label::createWithTTF("", "fonts/arial.ttf", 40, shrinkSize);
+    _shrink->setOverflow(Label::Overflow::SHRINK);
+    _shrink->setPosition(visibleRect.origin.x + visibleRect.size.width * 0.78f, visibleRect.getMidY());
+    addChild(_shrink);
+
+    auto drawNode = DrawNode::create();
+    drawNode->drawRect(Vec2::ZERO, Vec2(shrinkSize.width, shrinkSize.height), Color4F::WHITE);
+    drawNode->setPosition(_shrink->getPosition() - Vec2(shrinkSize.width / 2, shrinkSize.height / 2));
+    addChild(drawNode);
+
+    // the alignment and the dimensions change together with the text, the letters must move
+    _aligned = Label::createWithTTF("0000", "fonts/arial.ttf", 24, Size(160, 60));
+    _aligned->setAnchorPoint(Vec2::ANCHOR_BOTTOM_LEFT);
+    _aligned->setPosition(visibleRect.origin.x + 20, visibleRect.origin.y + 30);
+    addChild(_aligned);
+
+    _alignedBox = DrawNode::create();
+    _alignedBox->setPosition(_aligned->getPosition());
+    addChild(_alignedBox);
+    _alignedBox->drawRect(Vec2::ZERO, Vec2(160, 60), Color4F::WHITE);
+
+    schedule(CC_CALLBACK_1(LabelIncrementalLayout::step, this), "step_key");
+}
+
+void LabelIncrementalLayout::step(float /*dt*/)
+{
+    ++_frames;
+    _counter->setString(StringUtils::format("Score: %07d", _frames * 37));
+
+    if (_frames % 30 == 0)
+    {
+        static const TextHAlignment hAlignments[] = { TextHAlignment::LEFT, TextHAlignment::CENTER, TextHAlignment::RIGHT };
+        static const TextVAlignment vAlignments[] = { TextVAlignment::TOP, TextVAlignment::CENTER, TextVAlignment::BOTTOM };
+        int step = _frames / 30;
+        Size size(step % 2 ? 220.f : 160.f, step % 2 ? 90.f : 60.f);
+        _aligned->setAlignment(hAlignments[step % 3], vAlignments[(step / 3) % 3]);
+        _aligned->setDimensions(size.width, size.height);
+        _aligned->setString(StringUtils::format("%04d", step % 10000));
+
+        _alignedBox->clear();
+        _alignedBox->drawRect(Vec2::ZERO, Vec2(size.width, size.height), Color4F::WHITE);
+    }
+
+    if (_frames % 20 == 0)
+    {
+        auto text = _chat->getString();
+        if (std::count(text.begin(), text.end(), '\n') >= 12)
+        {
+            text.clear();
+        }
+        text += StringUtils::format("Player%d: message number %d, long enough to be wrapped on two lines\n", _frames % 7, _frames / 20);
+        _chat->setString(text);
+
+        auto shrinkText = _shrink->getString();
+        if (shrinkText.length() > 200)
+        {
+            shrinkText.clear();
+        }
+        _shrink->setString(shrinkText + "Shrink ");
+    }
+}
+
+std::string LabelIncrementalLayout::title() const
+{
+    return "Incremental layout";
+}
+
+std::string LabelIncrementalLayout::subtitle() const
+{
+    return "The texts should stay in their boxes, the bottom left one follows the alignment";
+}
+
+//
+// LabelBatchedLeaderboard
+//
+LabelBatchedLeaderboard::LabelBatchedLeaderboard()
+{
+    auto visibleRect = VisibleRect::getVisibleRect();
+    const int rows = 16;
+    const int columns = 4;
+    float rowHeight = (visibleRect.size.height - 100) / rows;
+    float columnWidth = visibleRect.size.width / columns;
+
+    // same font and size, so every label uses the same atlas page: the colors and the shadows
+    // are in the vertices and all the labels are batched together
+    for (int column = 0; column < columns; ++column)
+    {
+        for (int row = 0; row < rows; ++row)
+        {
+            int rank = column * rows + row + 1;
+            auto label = Label::createWithTTF(StringUtils::format("%2d. Player %d  %d", rank, rank * 7919 % 1000, 100000 - rank * 1234),
+                                              "fonts/arial.ttf", 14);
+            label->setAnchorPoint(Vec2::ANCHOR_MIDDLE_LEFT);
+            label->setPosition(visibleRect.origin.x + column * columnWidth + 10, visibleRect.getMaxY() - 60 - row * rowHeight);
+            if (rank <= 3)
+            {
+                label->setTextColor(Color4B::YELLOW);
+            }
+            else if (rank % 2)
+            {
+                label->setTextColor(Color4B(180, 200, 255, 255));
+            }
+            if (rank % 3 == 0)
+            {
+                label->enableShadow(Color4B::BLACK, Size(1, -1));
+            }
+            addChild(label);
+        }
+    }
+}
+
+std::string LabelBatchedLeaderboard::title() const
+{
+    return "Batched labels";
+}
+
+std::string LabelBatchedLeaderboard::subtitle() const
+{
+    return "64 labels, with colors and shadows, in one draw call";
+}
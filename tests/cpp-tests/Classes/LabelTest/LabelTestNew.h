@@ -993,4 +993,58 @@ private:
     static void setLetterColors(cocos2d::Label* label, const cocos2d::Color3B& color);
 };
 
+class LabelTTFAsyncRasterization : public AtlasDemoNew
+{
+public:
+    CREATE_FUNC(LabelTTFAsyncRasterization);
+
+    LabelTTFAsyncRasterization();
+
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+};
+
+class LabelTTFSharedDistanceField : public AtlasDemoNew
+{
+public:
+    CREATE_FUNC(LabelTTFSharedDistanceField);
+
+    LabelTTFSharedDistanceField();
+
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+};
+
+class LabelBatchedLeaderboard : public AtlasDemoNew
+{
+public:
+    CREATE_FUNC(LabelBatchedLeaderboard);
+
+    LabelBatchedLeaderboard();
+
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+};
+
+class LabelIncrementalLayout : public AtlasDemoNew
+{
+public:
+    CREATE_FUNC(LabelIncrementalLayout);
+
+    LabelIncrementalLayout();
+
+    void step(float dt);
+
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+
+private:
+    cocos2d::Label* _counter;
+    cocos2d::Label* _chat;
+    cocos2d::Label* _shrink;
+    cocos2d::Label* _aligned;
+    cocos2d::DrawNode* _alignedBox;
+    int _frames;
+};
+
 #endif
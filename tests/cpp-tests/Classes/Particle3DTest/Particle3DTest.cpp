@@ -49,6 +49,7 @@ Particle3DTests::Particle3DTests()
     ADD_TEST_CASE(Particle3DRibbonTrailDemo);
     ADD_TEST_CASE(Particle3DWeaponTrailDemo);
     ADD_TEST_CASE(Particle3DWithSprite3DDemo);
+    ADD_TEST_CASE(Particle3DCompiledScriptDemo);
 }
 
 std::string Particle3DTestDemo::title() const 
@@ -478,3 +479,23 @@ bool Particle3DWithSprite3DDemo::init()
 
     return true;
 }
+
+std::string Particle3DCompiledScriptDemo::subtitle() const
+{
+    return "Compiled Hypno, same as the script";
+}
+
+bool Particle3DCompiledScriptDemo::init()
+{
+    if (!Particle3DTestDemo::init())
+        return false;
+
+    // converted by tools/particle/compile_particles.py, the material is still a script
+    auto rootps = PUParticleSystem3D::create("Particle3D/compiled/hypno.pu", "pu_mediapack_01.material");
+    rootps->setCameraMask((unsigned short)CameraFlag::USER1);
+    rootps->startParticleSystem();
+
+    this->addChild(rootps, 0, PARTICLE_SYSTEM_TAG);
+
+    return true;
+}
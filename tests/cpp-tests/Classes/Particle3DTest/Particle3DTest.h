@@ -251,4 +251,17 @@ public:
     virtual bool init() override;
 };
 
+class Particle3DCompiledScriptDemo : public Particle3DTestDemo
+{
+public:
+
+    CREATE_FUNC(Particle3DCompiledScriptDemo);
+    Particle3DCompiledScriptDemo(){};
+    virtual ~Particle3DCompiledScriptDemo(){};
+
+    virtual std::string subtitle() const override;
+
+    virtual bool init() override;
+};
+
 #endif
\ No newline at end of file
@@ -1073,6 +1073,9 @@ ParticleTests::ParticleTests()
 
     ADD_TEST_CASE(ParticleIssue12310);
     ADD_TEST_CASE(ParticleSpriteFrame);
+    ADD_TEST_CASE(ParticleParallelSimulation);
+    ADD_TEST_CASE(ParticleGPUSnow);
+    ADD_TEST_CASE(ParticleBinaryDefinition);
 }
 
 ParticleDemo::~ParticleDemo(void)
@@ -2110,3 +2113,217 @@ std::string ParticleSpriteFrame::subtitle() const
 {
     return "Should not use entire texture atlas";
 }
+
+//
+// ParticleParallelSimulation
+//
+void ParticleParallelSimulation::onEnter()
+{
+    ParticleDemo::onEnter();
+
+    _color->setColor(Color3B::BLACK);
+    removeChild(_background, true);
+    _background = nullptr;
+
+    Size s = Director::getInstance()->getWinSize();
+
+    // 48 emitters of 500 particles
+    for (int i = 0; i < 48; ++i)
+    {
+        ParticleSystemQuad* particle = nullptr;
+        switch (i % 4)
+        {
+            case 0: particle = ParticleSun::createWithTotalParticles(500); break;
+            case 1: particle = ParticleGalaxy::createWithTotalParticles(500); break;
+            case 2: particle = ParticleFire::createWithTotalParticles(500); break;
+            default: particle = ParticleFlower::createWithTotalParticles(500); break;
+        }
+        particle->setTexture(Director::getInstance()->getTextureCache()->addImage(s_fire));
+        particle->setScale(0.3f);
+        particle->setPosition(Vec2((i % 8 + 0.5f) * s.width / 8, (i / 8 + 0.5f) * (s.height - 100) / 6 + 20));
+        addChild(particle, 10);
+    }
+
+    auto toggle = MenuItemFont::create("Parallel simulation: on", [](Ref* sender) {
+        ParticleSystem::setParallelSimulationEnabled(!ParticleSystem::isParallelSimulationEnabled());
+        static_cast<MenuItemFont*>(sender)->setString(ParticleSystem::isParallelSimulationEnabled() ?
+                                                      "Parallel simulation: on" : "Parallel simulation: off");
+    });
+    toggle->setFontSizeObj(20);
+    auto menu = Menu::create(toggle, nullptr);
+    menu->setPosition(Vec2(s.width / 2, 30));
+    addChild(menu, 100);
+
+    auto label = Label::createWithTTF("", "fonts/arial.ttf", 16);
+    label->setPosition(Vec2(s.width / 2, s.height - 80));
+    addChild(label, 100);
+
+    // time from the start of the scheduler to the end of the particle simulation, averaged per second
+    _updateTime = 0;
+    _updateCount = 0;
+    auto dispatcher = Director::getInstance()->getEventDispatcher();
+    _beforeUpdateListener = dispatcher->addCustomEventListener(Director::EVENT_BEFORE_UPDATE, [this](EventCustom*) {
+        _updateStart = std::chrono::steady_clock::now();
+    });
+    _afterUpdateListener = dispatcher->addCustomEventListener(Director::EVENT_AFTER_UPDATE, [this, label](EventCustom*) {
+        _updateTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _updateStart).count();
+        if (++_updateCount == 60)
+        {
+            char str[64];
+            sprintf(str, "update: %.2f ms", _updateTime / _updateCount);
+            label->setString(str);
+            _updateTime = 0;
+            _updateCount = 0;
+        }
+    });
+}
+
+void ParticleParallelSimulation::onExit()
+{
+    auto dispatcher = Director::getInstance()->getEventDispatcher();
+    dispatcher->removeEventListener(_beforeUpdateListener);
+    dispatcher->removeEventListener(_afterUpdateListener);
+    ParticleSystem::setParallelSimulationEnabled(true);
+
+    ParticleDemo::onExit();
+}
+
+std::string ParticleParallelSimulation::title() const
+{
+    return "Parallel simulation";
+}
+
+std::string ParticleParallelSimulation::subtitle() const
+{
+    return "48 emitters, the particles look the same with and without";
+}
+
+//
+// ParticleGPUSnow
+//
+void ParticleGPUSnow::onEnter()
+{
+    ParticleDemo::onEnter();
+
+    _color->setColor(Color3B::BLACK);
+    removeChild(_background, true);
+    _background = nullptr;
+
+    Size s = Director::getInstance()->getWinSize();
+
+    _snow = nullptr;
+    createSnow(true);
+
+    auto toggle = MenuItemToggle::createWithCallback([this](Ref* sender) {
+        createSnow(static_cast<MenuItemToggle*>(sender)->getSelectedIndex() == 0);
+    }, MenuItemFont::create("ParticleSystemGPU: 100000"), MenuItemFont::create("ParticleSystemQuad: 16000"), nullptr);
+    auto menu = Menu::create(toggle, nullptr);
+    menu->setPosition(Vec2(s.width / 2, 30));
+    addChild(menu, 100);
+
+    _countLabel = Label::createWithTTF("", "fonts/arial.ttf", 16);
+    _countLabel->setPosition(Vec2(s.width / 2, s.height - 80));
+    addChild(_countLabel, 100);
+}
+
+void ParticleGPUSnow::createSnow(bool gpu)
+{
+    if (_snow)
+    {
+        removeChild(_snow, true);
+    }
+
+    // a ParticleSystemQuad is drawn by a single QuadCommand, limited to 16383 quads
+    const int totalParticles = gpu ? 100000 : 16000;
+    _snow = gpu ? static_cast<ParticleSystem*>(ParticleSystemGPU::createWithTotalParticles(totalParticles))
+                : ParticleSystemQuad::createWithTotalParticles(totalParticles);
+
+    // ParticleSnow, denser and without radial nor tangential acceleration
+    Size s = Director::getInstance()->getWinSize();
+    _snow->setDuration(ParticleSystem::DURATION_INFINITY);
+    _snow->setEmitterMode(ParticleSystem::Mode::GRAVITY);
+    _snow->setPositionType(ParticleSystem::PositionType::GROUPED);
+    _snow->setGravity(Vec2(0, -10));
+    _snow->setSpeed(40);
+    _snow->setSpeedVar(10);
+    _snow->setPosition(Vec2(s.width / 2, s.height + 10));
+    _snow->setPosVar(Vec2(s.width / 2, 0));
+    _snow->setAngle(-90);
+    _snow->setAngleVar(10);
+    _snow->setLife(8);
+    _snow->setLifeVar(2);
+    _snow->setStartSize(4);
+    _snow->setStartSizeVar(2);
+    _snow->setEndSize(ParticleSystem::START_SIZE_EQUAL_TO_END_SIZE);
+    _snow->setStartSpin(0);
+    _snow->setStartSpinVar(180);
+    _snow->setEndSpin(360);
+    _snow->setEndSpinVar(180);
+    _snow->setStartColor(Color4F(1, 1, 1, 1));
+    _snow->setStartColorVar(Color4F(0, 0, 0.2f, 0));
+    _snow->setEndColor(Color4F(1, 1, 1, 0));
+    _snow->setEndColorVar(Color4F(0, 0, 0, 0));
+    _snow->setEmissionRate(totalParticles / 10.0f);
+    _snow->setBlendAdditive(false);
+    _snow->setTexture(Director::getInstance()->getTextureCache()->addImage(s_snow));
+    // ParticleSystemGPU reads the properties when it is reset
+    _snow->resetSystem();
+    addChild(_snow, 10);
+}
+
+void ParticleGPUSnow::update(float dt)
+{
+    char str[32];
+    sprintf(str, "%u particles", _snow->getParticleCount());
+    _countLabel->setString(str);
+}
+
+std::string ParticleGPUSnow::title() const
+{
+    return "GPU particles";
+}
+
+std::string ParticleGPUSnow::subtitle() const
+{
+    return "Snow simulated by the vertex shader or by the CPU";
+}
+
+//
+// ParticleBinaryDefinition
+//
+void ParticleBinaryDefinition::onEnter()
+{
+    ParticleDemo::onEnter();
+
+    _color->setColor(Color3B::BLACK);
+    removeChild(_background, true);
+    _background = nullptr;
+
+    auto s = Director::getInstance()->getWinSize();
+
+    // converted by tools/particle/compile_particles.py, the texture is loaded in the background
+    _emitter = ParticleSystemQuad::create("Particles/compiled/Phoenix.plist");
+    _emitter->retain();
+    addChild(_emitter, 10);
+    _emitter->setPosition(Vec2(s.width / 2, s.height / 2));
+
+    // batched right away, before their texture is loaded: they are drawn with the texture of the batch
+    auto batch = ParticleBatchNode::createWithTexture(Director::getInstance()->getTextureCache()->addImage("Images/fire.png"));
+    for (int i = 0; i < 2; ++i)
+    {
+        auto emitter = ParticleSystemQuad::create("Particles/compiled/SpinningPeas.plist");
+        emitter->setPosition(Vec2(s.width * (i + 1) / 3, s.height / 4));
+        batch->addChild(emitter);
+    }
+    addChild(batch, 10);
+}
+
+std::string ParticleBinaryDefinition::title() const
+{
+    return "Binary particle definitions";
+}
+
+std::string ParticleBinaryDefinition::subtitle() const
+{
+    return "Phoenix with its own texture, the batched peas with the fire texture";
+}
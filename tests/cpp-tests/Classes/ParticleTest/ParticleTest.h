@@ -26,6 +26,7 @@
 #define _PARTICLE_TEST_H_
 
 #include "../BaseTest.h"
+#include <chrono>
 
 DEFINE_TEST_SUITE(ParticleTests);
 
@@ -422,4 +423,46 @@ public:
     virtual std::string subtitle() const override;
 };
 
+class ParticleParallelSimulation : public ParticleDemo
+{
+public:
+    CREATE_FUNC(ParticleParallelSimulation);
+    virtual void onEnter() override;
+    virtual void onExit() override;
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+
+protected:
+    cocos2d::EventListenerCustom* _beforeUpdateListener;
+    cocos2d::EventListenerCustom* _afterUpdateListener;
+    std::chrono::steady_clock::time_point _updateStart;
+    double _updateTime;
+    int _updateCount;
+};
+
+class ParticleGPUSnow : public ParticleDemo
+{
+public:
+    CREATE_FUNC(ParticleGPUSnow);
+    virtual void onEnter() override;
+    virtual void update(float dt) override;
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+
+protected:
+    void createSnow(bool gpu);
+
+    cocos2d::ParticleSystem* _snow;
+    cocos2d::Label* _countLabel;
+};
+
+class ParticleBinaryDefinition : public ParticleDemo
+{
+public:
+    CREATE_FUNC(ParticleBinaryDefinition);
+    virtual void onEnter() override;
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+};
+
 #endif
@@ -29,10 +29,12 @@
 #include "2d/CCCameraBackgroundBrush.h"
 #include "3d/CCSprite3DMaterial.h"
 #include "3d/CCMotionStreak3D.h"
+#include "3d/CCAABBTree.h"
 
 #include "extensions/Particle3D/PU/CCPUParticleSystem3D.h"
 
 #include <algorithm>
+#include <set>
 #include "../testResource.h"
 
 USING_NS_CC;
@@ -42,6 +44,7 @@ Sprite3DTests::Sprite3DTests()
     ADD_TEST_CASE(Sprite3DBasicTest);
     ADD_TEST_CASE(Sprite3DHitTest);
     ADD_TEST_CASE(AsyncLoadSprite3DTest);
+    ADD_TEST_CASE(AsyncUploadSprite3DTest);
     // 3DEffect use custom shader which is not supported on WP8/WinRT yet. 
     ADD_TEST_CASE(Sprite3DEffectTest);
     ADD_TEST_CASE(Sprite3DUVAnimationTest);
@@ -71,6 +74,10 @@ Sprite3DTests::Sprite3DTests()
     ADD_TEST_CASE(Sprite3DPropertyTest);
     ADD_TEST_CASE(Sprite3DNormalMappingTest);
     ADD_TEST_CASE(Issue16155Test);
+    ADD_TEST_CASE(Animate3DParallelEvaluationTest);
+    ADD_TEST_CASE(Animate3DCompressedTest);
+    ADD_TEST_CASE(Sprite3DLODTest);
+    ADD_TEST_CASE(Sprite3DAABBTreeTest);
 };
 
 //------------------------------------------------------------------
@@ -891,6 +898,57 @@ void AsyncLoadSprite3DTest::asyncLoad_Callback(Sprite3D* sprite, void* param)
 }
 
 
+AsyncUploadSprite3DTest::AsyncUploadSprite3DTest()
+: _alive(std::make_shared<bool>(true))
+, _budget(Sprite3D::getAsyncUploadBudget())
+, _frames(0)
+{
+    auto s = Director::getInstance()->getWinSize();
+    _label = Label::createWithTTF("", "fonts/arial.ttf", 15);
+    _label->setPosition(Vec2(s.width / 2, s.height / 4));
+    addChild(_label, 10);
+
+    // 4KB per frame, the buffers of every model are filled over many frames
+    Sprite3D::setAsyncUploadBudget(4096);
+    Sprite3DCache::getInstance()->removeAllSprite3DData();
+
+    std::vector<std::string> paths = { "Sprite3DTest/boss.obj", "Sprite3DTest/orc.c3b", "Sprite3DTest/girl.c3b" };
+    auto alive = _alive;
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        Vec2 position(s.width * (i + 0.5f) / paths.size(), s.height / 2.f);
+        std::string path = paths[i];
+        Sprite3D::createAsync(path, [this, alive, position, path](Sprite3D* sprite, void* /*param*/) {
+            // the uploads outlive the test when it is left early
+            if (!*alive)
+                return;
+            sprite->setPosition(position);
+            addChild(sprite);
+            _label->setString(_label->getString() + StringUtils::format("%s: ready after %d frames\n", path.c_str(), _frames));
+        }, nullptr);
+    }
+
+    schedule([this](float /*dt*/) {
+        ++_frames;
+    }, "count_frames");
+}
+
+AsyncUploadSprite3DTest::~AsyncUploadSprite3DTest()
+{
+    *_alive = false;
+    Sprite3D::setAsyncUploadBudget(_budget);
+}
+
+std::string AsyncUploadSprite3DTest::title() const
+{
+    return "Sprite3D::createAsync upload budget";
+}
+
+std::string AsyncUploadSprite3DTest::subtitle() const
+{
+    return "4KB per frame, the models appear one after the other";
+}
+
 Sprite3DWithSkinTest::Sprite3DWithSkinTest()
 {
     auto listener = EventListenerTouchAllAtOnce::create();
@@ -2733,3 +2791,336 @@ std::string Issue16155Test::subtitle() const
 {
     return "Should not leak texture. See console";
 }
+
+//
+// Animate3DParallelEvaluationTest
+//
+Animate3DParallelEvaluationTest::Animate3DParallelEvaluationTest()
+: _label(nullptr)
+, _beforeUpdateListener(nullptr)
+, _afterUpdateListener(nullptr)
+, _updateTime(0)
+, _updateCount(0)
+{
+    auto s = Director::getInstance()->getWinSize();
+
+    // a crowd of 200 orcs, with different speeds so that they don't share the same pose
+    std::string fileName = "Sprite3DTest/orc.c3b";
+    auto animation = Animation3D::create(fileName);
+    for (int i = 0; i < 200; ++i)
+    {
+        auto sprite = Sprite3D::create(fileName);
+        sprite->setScale(1.2f);
+        sprite->setRotation3D(Vec3(0, 180, 0));
+        sprite->setPosition(Vec2((i % 20 + 0.5f) * s.width / 20, (i / 20 + 0.5f) * (s.height - 120) / 10 + 50));
+        addChild(sprite);
+
+        if (animation)
+        {
+            auto animate = Animate3D::create(animation);
+            animate->setSpeed(0.5f + (i % 7) * 0.15f);
+            sprite->runAction(RepeatForever::create(animate));
+        }
+    }
+
+    auto toggle = MenuItemFont::create("Parallel evaluation: on", [](Ref* sender) {
+        Animate3D::setParallelEvaluationEnabled(!Animate3D::isParallelEvaluationEnabled());
+        static_cast<MenuItemFont*>(sender)->setString(Animate3D::isParallelEvaluationEnabled() ?
+                                                      "Parallel evaluation: on" : "Parallel evaluation: off");
+    });
+    toggle->setFontSizeObj(20);
+    auto menu = Menu::create(toggle, nullptr);
+    menu->setPosition(Vec2(s.width / 2, 30));
+    addChild(menu, 1);
+
+    _label = Label::createWithTTF("", "fonts/arial.ttf", 16);
+    _label->setPosition(Vec2(s.width / 2, s.height - 80));
+    addChild(_label, 1);
+}
+
+void Animate3DParallelEvaluationTest::onEnter()
+{
+    Sprite3DTestDemo::onEnter();
+
+    // time from the start of the scheduler to the end of the animation evaluation, averaged per second
+    _updateTime = 0;
+    _updateCount = 0;
+    auto dispatcher = Director::getInstance()->getEventDispatcher();
+    _beforeUpdateListener = dispatcher->addCustomEventListener(Director::EVENT_BEFORE_UPDATE, [this](EventCustom*) {
+        _updateStart = std::chrono::steady_clock::now();
+    });
+    _afterUpdateListener = dispatcher->addCustomEventListener(Director::EVENT_AFTER_UPDATE, [this](EventCustom*) {
+        _updateTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _updateStart).count();
+        if (++_updateCount == 60)
+        {
+            char str[64];
+            sprintf(str, "update: %.2f ms", _updateTime / _updateCount);
+            _label->setString(str);
+            _updateTime = 0;
+            _updateCount = 0;
+        }
+    });
+}
+
+void Animate3DParallelEvaluationTest::onExit()
+{
+    auto dispatcher = Director::getInstance()->getEventDispatcher();
+    dispatcher->removeEventListener(_beforeUpdateListener);
+    dispatcher->removeEventListener(_afterUpdateListener);
+    Animate3D::setParallelEvaluationEnabled(true);
+
+    Sprite3DTestDemo::onExit();
+}
+
+std::string Animate3DParallelEvaluationTest::title() const
+{
+    return "Animate3D Parallel Evaluation";
+}
+
+std::string Animate3DParallelEvaluationTest::subtitle() const
+{
+    return "200 skinned sprites, they look the same with and without";
+}
+
+//------------------------------------------------------------------
+//
+// Animate3DCompressedTest
+//
+//------------------------------------------------------------------
+Animate3DCompressedTest::Animate3DCompressedTest()
+{
+    auto s = Director::getInstance()->getWinSize();
+
+    // orc_compressed.c3b is orc.c3b converted by tools/c3b/compress_animations.py
+    const char* fileNames[] = { "Sprite3DTest/orc.c3b", "Sprite3DTest/orc_compressed.c3b" };
+    const char* captions[] = { "Original", "Compressed" };
+    for (int i = 0; i < 2; ++i)
+    {
+        auto sprite = Sprite3D::create(fileNames[i]);
+        sprite->setScale(5);
+        sprite->setRotation3D(Vec3(0, 180, 0));
+        sprite->setPosition(Vec2(s.width * (i + 1) / 3, s.height / 4));
+        addChild(sprite);
+
+        auto animation = Animation3D::create(fileNames[i]);
+        if (animation)
+        {
+            sprite->runAction(RepeatForever::create(Animate3D::create(animation)));
+        }
+
+        auto label = Label::createWithTTF(captions[i], "fonts/arial.ttf", 16);
+        label->setPosition(Vec2(s.width * (i + 1) / 3, s.height / 4 - 30));
+        addChild(label);
+    }
+}
+
+std::string Animate3DCompressedTest::title() const
+{
+    return "Compressed Animation";
+}
+
+std::string Animate3DCompressedTest::subtitle() const
+{
+    return "Both orcs should move the same way";
+}
+
+//------------------------------------------------------------------
+//
+// Sprite3DLODTest
+//
+//------------------------------------------------------------------
+Sprite3DLODTest::Sprite3DLODTest()
+: _sprite(nullptr)
+, _label(nullptr)
+, _generated(false)
+{
+    auto s = Director::getInstance()->getWinSize();
+
+    // the levels are generated when the model is loaded, not when it comes from the cache
+    Sprite3DCache::getInstance()->removeAllSprite3DData();
+    Sprite3D::setLODGeneration(3);
+    _sprite = Sprite3D::create("Sprite3DTest/orc.c3b");
+    Sprite3D::setLODGeneration(0);
+    Sprite3DCache::getInstance()->removeAllSprite3DData();
+
+    _sprite->setScale(5);
+    _sprite->setRotation3D(Vec3(0, 180, 0));
+    _sprite->setPosition(Vec2(s.width / 2, s.height / 4));
+    addChild(_sprite);
+
+    // from close to far away and back, the levels change with the size on screen
+    auto moveAway = MoveBy::create(4, Vec3(0, 0, -2000));
+    _sprite->runAction(RepeatForever::create(Sequence::create(moveAway, moveAway->reverse(), nullptr)));
+
+    // up to 3 levels within the error bound, every level has fewer triangles than the previous one
+    _generated = !_sprite->getMeshes().empty();
+    for (const auto& mesh : _sprite->getMeshes())
+    {
+        auto indexData = mesh->getMeshIndexData();
+        _generated = _generated && indexData->getLODCount() > 1 && indexData->getLODCount() <= 4;
+        for (int lod = 1; _generated && lod < indexData->getLODCount(); ++lod)
+        {
+            _generated = indexData->getIndexCount(lod) < indexData->getIndexCount(lod - 1);
+        }
+    }
+
+    _label = Label::createWithTTF("", "fonts/arial.ttf", 15);
+    _label->setPosition(Vec2(s.width / 2, s.height - 80));
+    addChild(_label, 1);
+
+    scheduleUpdate();
+}
+
+void Sprite3DLODTest::update(float /*dt*/)
+{
+    auto mesh = _sprite->getMeshes().empty() ? nullptr : _sprite->getMeshes().at(0);
+    if (!mesh)
+        return;
+    int lod = mesh->getLOD();
+    _label->setString(StringUtils::format("levels generated: %s, drawn level: %d, %d triangles",
+                                          _generated ? "yes" : "no", lod, mesh->getMeshIndexData()->getIndexCount(lod) / 3));
+}
+
+std::string Sprite3DLODTest::title() const
+{
+    return "Sprite3D levels of detail";
+}
+
+std::string Sprite3DLODTest::subtitle() const
+{
+    return "The level drawn goes up as the orc goes away";
+}
+
+//------------------------------------------------------------------
+//
+// Sprite3DAABBTreeTest
+//
+//------------------------------------------------------------------
+Sprite3DAABBTreeTest::Sprite3DAABBTreeTest()
+: _picked(nullptr)
+, _cullingLabel(nullptr)
+, _pickingLabel(nullptr)
+{
+    auto s = Director::getInstance()->getWinSize();
+
+    auto listener = EventListenerTouchAllAtOnce::create();
+    listener->onTouchesEnded = CC_CALLBACK_2(Sprite3DAABBTreeTest::onTouchesEnded, this);
+    _eventDispatcher->addEventListenerWithSceneGraphPriority(listener, this);
+
+    // the grid is twice as wide as the screen, so about half of the ships are culled
+    const int columns = 16;
+    const int rows = 5;
+    for (int row = 0; row < rows; ++row)
+    {
+        for (int column = 0; column < columns; ++column)
+        {
+            auto ship = Sprite3D::create("Sprite3DTest/boss1.obj");
+            ship->setTexture("Sprite3DTest/boss.png");
+            ship->setScale(3);
+            ship->setRotation3D(Vec3(90, 0, 0));
+            ship->setPosition(Vec2(-s.width / 2 + (column + 0.5f) * s.width * 2 / columns, (row + 1) * s.height / (rows + 2)));
+            addChild(ship);
+            _sprites.push_back(ship);
+
+            // every other row goes in and out of the screen, so the tree has to move their proxies
+            if (row % 2)
+            {
+                auto move = MoveBy::create(3, Vec2(s.width / 2, 0));
+                ship->runAction(RepeatForever::create(Sequence::create(move, move->reverse(), nullptr)));
+            }
+        }
+    }
+
+    _cullingLabel = Label::createWithTTF("", "fonts/arial.ttf", 15);
+    _cullingLabel->setPosition(Vec2(s.width / 2, s.height - 70));
+    addChild(_cullingLabel, 1);
+
+    _pickingLabel = Label::createWithTTF("Touch a ship", "fonts/arial.ttf", 15);
+    _pickingLabel->setPosition(Vec2(s.width / 2, s.height - 90));
+    addChild(_pickingLabel, 1);
+
+    scheduleUpdate();
+}
+
+void Sprite3DAABBTreeTest::update(float /*dt*/)
+{
+    auto scene = getScene();
+    auto tree = scene ? scene->getAABBTree() : nullptr;
+    if (!tree)
+        return;
+    auto camera = scene->getDefaultCamera();
+
+    // the ships found through the tree must contain all those the camera sees
+    std::set<Node*> found;
+    tree->query(camera->getFrustum(), [&](int proxyId) {
+        found.insert(static_cast<Node*>(tree->getUserData(proxyId)));
+        return true;
+    });
+
+    int visible = 0;
+    int missed = 0;
+    for (auto sprite : _sprites)
+    {
+        if (camera->isVisibleInFrustum(&sprite->getAABB()))
+        {
+            ++visible;
+            if (found.find(sprite) == found.end())
+                ++missed;
+        }
+    }
+
+    _cullingLabel->setString(StringUtils::format("%d ships, %d seen by the camera, %d found through the tree, %d missed",
+                                                 (int)_sprites.size(), visible, (int)found.size(), missed));
+    _cullingLabel->setColor(missed ? Color3B::RED : Color3B::WHITE);
+}
+
+void Sprite3DAABBTreeTest::onTouchesEnded(const std::vector<Touch*>& touches, Event* /*event*/)
+{
+    auto scene = getScene();
+    auto tree = scene ? scene->getAABBTree() : nullptr;
+    if (!tree || touches.empty())
+        return;
+    auto camera = scene->getDefaultCamera();
+
+    auto location = touches[0]->getLocation();
+    auto nearPoint = camera->unprojectGL(Vec3(location.x, location.y, 0));
+    auto farPoint = camera->unprojectGL(Vec3(location.x, location.y, 1));
+    auto direction = farPoint - nearPoint;
+    direction.normalize();
+    Ray ray(nearPoint, direction);
+
+    // the fat boxes of the tree are only a first pass, the hit is the closest actual box
+    Sprite3D* picked = nullptr;
+    float closest = nearPoint.distance(farPoint);
+    int tested = 0;
+    tree->rayCast(ray, closest, [&](int proxyId, float /*fatDistance*/) {
+        ++tested;
+        auto sprite = dynamic_cast<Sprite3D*>(static_cast<Node*>(tree->getUserData(proxyId)));
+        float distance = 0;
+        if (sprite && ray.intersects(sprite->getAABB(), &distance) && distance < closest)
+        {
+            picked = sprite;
+            closest = distance;
+        }
+        return closest;
+    });
+
+    if (_picked)
+        _picked->setColor(Color3B::WHITE);
+    _picked = picked;
+    if (_picked)
+        _picked->setColor(Color3B::RED);
+
+    _pickingLabel->setString(StringUtils::format("%s, %d of %d boxes tested", picked ? "ship picked" : "nothing picked",
+                                                 tested, tree->getProxyCount()));
+}
+
+std::string Sprite3DAABBTreeTest::title() const
+{
+    return "Sprite3D culling and picking with the AABBTree";
+}
+
+std::string Sprite3DAABBTreeTest::subtitle() const
+{
+    return "No ship should be missed, the touched ship turns red";
+}
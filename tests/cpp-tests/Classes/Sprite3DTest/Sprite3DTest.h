@@ -28,6 +28,7 @@
 
 #include "BaseTest.h"
 #include <string>
+#include <chrono>
 
 namespace cocos2d {
     class Animate3D;
@@ -215,6 +216,22 @@ protected:
     std::vector<std::string> _paths; //model paths to be loaded
 };
 
+class AsyncUploadSprite3DTest : public Sprite3DTestDemo
+{
+public:
+    CREATE_FUNC(AsyncUploadSprite3DTest);
+    AsyncUploadSprite3DTest();
+    virtual ~AsyncUploadSprite3DTest();
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+
+protected:
+    std::shared_ptr<bool> _alive;
+    unsigned int _budget;
+    int _frames;
+    cocos2d::Label* _label;
+};
+
 class Sprite3DWithSkinTest : public Sprite3DTestDemo
 {
 public:
@@ -627,4 +644,65 @@ public:
     virtual std::string subtitle() const override;
 };
 
+class Animate3DParallelEvaluationTest : public Sprite3DTestDemo
+{
+public:
+    CREATE_FUNC(Animate3DParallelEvaluationTest);
+    Animate3DParallelEvaluationTest();
+    virtual void onEnter() override;
+    virtual void onExit() override;
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+
+protected:
+    cocos2d::Label* _label;
+    cocos2d::EventListenerCustom* _beforeUpdateListener;
+    cocos2d::EventListenerCustom* _afterUpdateListener;
+    std::chrono::steady_clock::time_point _updateStart;
+    double _updateTime;
+    int _updateCount;
+};
+
+class Animate3DCompressedTest : public Sprite3DTestDemo
+{
+public:
+    CREATE_FUNC(Animate3DCompressedTest);
+    Animate3DCompressedTest();
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+};
+
+class Sprite3DLODTest : public Sprite3DTestDemo
+{
+public:
+    CREATE_FUNC(Sprite3DLODTest);
+    Sprite3DLODTest();
+    virtual void update(float dt) override;
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+
+protected:
+    cocos2d::Sprite3D* _sprite;
+    cocos2d::Label* _label;
+    bool _generated;
+};
+
+class Sprite3DAABBTreeTest : public Sprite3DTestDemo
+{
+public:
+    CREATE_FUNC(Sprite3DAABBTreeTest);
+    Sprite3DAABBTreeTest();
+    virtual void update(float dt) override;
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+
+    void onTouchesEnded(const std::vector<cocos2d::Touch*>& touches, cocos2d::Event* event);
+
+protected:
+    std::vector<cocos2d::Sprite3D*> _sprites;
+    cocos2d::Sprite3D* _picked;
+    cocos2d::Label* _cullingLabel;
+    cocos2d::Label* _pickingLabel;
+};
+
 #endif
@@ -38,6 +38,7 @@ SpriteFrameCacheTests::SpriteFrameCacheTests()
     ADD_TEST_CASE(SpriteFrameCachePixelFormatTest);
     ADD_TEST_CASE(SpriteFrameCacheLoadMultipleTimes);
     ADD_TEST_CASE(SpriteFrameCacheFullCheck);
+    ADD_TEST_CASE(SpriteFrameCacheAsyncTest);
 }
 
 SpriteFrameCachePixelFormatTest::SpriteFrameCachePixelFormatTest()
@@ -140,3 +141,59 @@ void SpriteFrameCacheFullCheck::loadSpriteFrames(const std::string &file, cocos2
     cache->addSpriteFramesWithFile(file);
     CCASSERT(cache->isSpriteFramesWithFileLoaded(file) == true, "Plist should be full after reloaded");
 }
+
+static const char* s_asyncTestFrames[] = { "grossinis_sister1.png", "grossinis_sister2.png", "island_polygon.png" };
+
+SpriteFrameCacheAsyncTest::SpriteFrameCacheAsyncTest()
+{
+    const Size screenSize = Director::getInstance()->getWinSize();
+
+    _infoLabel = Label::createWithTTF("", "fonts/arial.ttf", 14);
+    _infoLabel->setAlignment(cocos2d::TextHAlignment::CENTER);
+    _infoLabel->setPosition(screenSize.width * 0.5f, screenSize.height * 0.3f);
+    addChild(_infoLabel);
+
+    auto cache = SpriteFrameCache::getInstance();
+    cache->removeSpriteFramesFromFile("Images/test_polygon.plist");
+
+    // the test may be left before the frames are loaded
+    retain();
+    cache->addSpriteFramesWithFileAsync("Images/test_polygon.plist", [this, cache](bool succeeded) {
+        CCASSERT(succeeded, "plist should be loaded");
+        CCASSERT(cache->isSpriteFramesWithFileLoaded("Images/test_polygon.plist"), "plist should be full after loaded");
+
+        for (auto name : s_asyncTestFrames)
+        {
+            auto frame = cache->getSpriteFrameByName(name);
+            _plistRects.push_back(frame ? frame->getRect() : Rect::ZERO);
+        }
+        _infoLabel->setString("plist loaded");
+
+        cache->removeSpriteFramesFromFile("Images/test_polygon.plist");
+        loadBinarySheet();
+        release();
+    });
+}
+
+void SpriteFrameCacheAsyncTest::loadBinarySheet()
+{
+    auto cache = SpriteFrameCache::getInstance();
+    retain();
+    cache->addSpriteFramesWithFileAsync("Images/test_polygon.ccss", [this, cache](bool succeeded) {
+        CCASSERT(succeeded, "binary sheet should be loaded");
+
+        bool same = true;
+        for (size_t i = 0; i < _plistRects.size(); ++i)
+        {
+            auto frame = cache->getSpriteFrameByName(s_asyncTestFrames[i]);
+            same = same && frame && frame->getRect().equals(_plistRects[i]) && frame->hasPolygonInfo();
+        }
+        _infoLabel->setString(same ? "plist and binary sheets match" : "ERROR: frames differ");
+
+        const Size screenSize = Director::getInstance()->getWinSize();
+        auto sprite = Sprite::createWithSpriteFrameName("island_polygon.png");
+        sprite->setPosition(screenSize.width * 0.5f, screenSize.height * 0.6f);
+        addChild(sprite);
+        release();
+    });
+}
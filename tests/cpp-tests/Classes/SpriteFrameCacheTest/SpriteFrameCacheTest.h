@@ -76,4 +76,21 @@ public:
 private:
     void loadSpriteFrames(const std::string &file, cocos2d::Texture2D::PixelFormat expectedFormat);
 
-};
\ No newline at end of file
+};
+
+class SpriteFrameCacheAsyncTest : public TestCase
+{
+public:
+    CREATE_FUNC(SpriteFrameCacheAsyncTest);
+
+    virtual std::string title() const override { return "Load sprite frames asynchronously"; }
+    virtual std::string subtitle() const override { return "plist and binary sheets should give the same frames"; }
+
+    SpriteFrameCacheAsyncTest();
+
+private:
+    void loadBinarySheet();
+
+    cocos2d::Label* _infoLabel;
+    std::vector<cocos2d::Rect> _plistRects;
+};
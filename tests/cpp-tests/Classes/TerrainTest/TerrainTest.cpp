@@ -31,6 +31,7 @@ TerrainTests::TerrainTests()
     ADD_TEST_CASE(TerrainSimple);
     ADD_TEST_CASE(TerrainWalkThru);
     ADD_TEST_CASE(TerrainWithLightMap);
+    ADD_TEST_CASE(TerrainPaged);
 }
 
 Vec3 camera_offset(0, 45, 60);
@@ -397,3 +398,86 @@ void TerrainWithLightMap::onTouchesMoved(const std::vector<cocos2d::Touch*>& tou
     cameraPos+=cameraRightDir*newPos.x*0.5*delta;
     _camera->setPosition3D(cameraPos);
 }
+
+#define PAGED_TILE_COUNT 8
+#define PAGED_CHUNK_SIZE 32
+#define PAGED_MAP_SCALE 2.0f
+
+TerrainPaged::TerrainPaged()
+: _time(0)
+{
+    Size visibleSize = Director::getInstance()->getVisibleSize();
+
+    //use custom camera
+    _camera = Camera::createPerspective(60,visibleSize.width/visibleSize.height,0.1f,800);
+    _camera->setCameraFlag(CameraFlag::USER1);
+    addChild(_camera);
+
+    Terrain::DetailMap r("TerrainTest/dirt.jpg"),g("TerrainTest/Grass2.jpg",10),b("TerrainTest/road.jpg"),a("TerrainTest/GreenSkin.jpg",20);
+
+    //one heightmap tile of 33x33 pixels per chunk, instead of the whole heightmap
+    Terrain::TerrainData data("","TerrainTest/alphamap.png",r,g,b,a,Size(PAGED_CHUNK_SIZE,PAGED_CHUNK_SIZE),40.0f,PAGED_MAP_SCALE);
+    data._heightMapTileFormat = "TerrainTest/paged/height_%d_%d.png";
+    data._tileCount = Size(PAGED_TILE_COUNT,PAGED_TILE_COUNT);
+
+    _terrain = Terrain::create(data,Terrain::CrackFixedType::SKIRT);
+    _terrain->setMaxDetailMapAmount(4);
+    _terrain->setCameraMask(2);
+    _terrain->setDrawWire(false);
+    _terrain->setSkirtHeightRatio(3);
+    _terrain->setLODDistance(64,128,192);
+    //a chunk is 64 wide, the chunks within two of the camera are loaded
+    _terrain->setPageDistance(128,192);
+    addChild(_terrain);
+
+    _label = Label::createWithTTF("", "fonts/arial.ttf", 15);
+    _label->setPosition(Vec2(visibleSize.width/2, visibleSize.height - 80));
+    addChild(_label, 1);
+
+    scheduleUpdate();
+}
+
+void TerrainPaged::update(float dt)
+{
+    _time += dt;
+
+    //the camera goes around the terrain, looking ahead
+    float radius = 180;
+    float angle = _time*0.2f;
+    Vec3 position(radius*cosf(angle), 0, radius*sinf(angle));
+    Vec3 ahead(radius*cosf(angle + 0.3f), 0, radius*sinf(angle + 0.3f));
+    bool groundLoaded = _terrain->isHeightLoaded(position.x, position.z);
+    position.y = groundLoaded ? _terrain->getHeight(position.x, position.z) + 10 : 30;
+    ahead.y = position.y - 5;
+    _camera->setPosition3D(position);
+    _camera->lookAt(ahead);
+
+    int loaded = 0;
+    float chunkWidth = PAGED_CHUNK_SIZE*PAGED_MAP_SCALE;
+    float origin = -PAGED_TILE_COUNT*chunkWidth/2;
+    for (int m = 0; m < PAGED_TILE_COUNT; ++m)
+    {
+        for (int n = 0; n < PAGED_TILE_COUNT; ++n)
+        {
+            if (_terrain->isHeightLoaded(origin + (n + 0.5f)*chunkWidth, origin + (m + 0.5f)*chunkWidth))
+                ++loaded;
+        }
+    }
+
+    //the other side of the terrain is farther than the unload distance
+    bool oppositeLoaded = _terrain->isHeightLoaded(-position.x, -position.z);
+    _label->setString(StringUtils::format("%d of %d chunks loaded, ground under the camera %s, other side %s",
+                                          loaded, PAGED_TILE_COUNT*PAGED_TILE_COUNT,
+                                          groundLoaded ? "loaded" : "loading", oppositeLoaded ? "loaded" : "unloaded"));
+    _label->setColor(oppositeLoaded ? Color3B::RED : Color3B::WHITE);
+}
+
+std::string TerrainPaged::title() const
+{
+    return "Paged terrain";
+}
+
+std::string TerrainPaged::subtitle() const
+{
+    return "The chunks around the camera are loaded, the others are freed";
+}
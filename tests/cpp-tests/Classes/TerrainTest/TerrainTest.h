@@ -110,4 +110,20 @@ protected:
     cocos2d::Camera* _camera;
 };
 
+class TerrainPaged : public TerrainTestDemo
+{
+public:
+    CREATE_FUNC(TerrainPaged);
+    TerrainPaged();
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+    virtual void update(float dt) override;
+
+protected:
+    cocos2d::Terrain* _terrain;
+    cocos2d::Camera* _camera;
+    cocos2d::Label* _label;
+    float _time;
+};
+
 #endif // !TERRAIN_TESH_H
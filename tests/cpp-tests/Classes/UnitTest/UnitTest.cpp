@@ -26,6 +26,11 @@
 #include "RefPtrTest.h"
 #include "ui/UIHelper.h"
 #include "network/Uri.h"
+#include "base/CCAsyncTaskPool.h"
+#include "3d/CCMesh.h"
+#include "3d/CCMeshOptimizer.h"
+#include "3d/CCMeshSimplifier.h"
+#include "3d/CCObjLoader.h"
 
 USING_NS_CC;
 using namespace cocos2d::network;
@@ -77,6 +82,11 @@ UnitTests::UnitTests()
     ADD_TEST_CASE(UIHelperSubStringTest);
     ADD_TEST_CASE(ParseUriTest);
     ADD_TEST_CASE(ResizableBufferAdapterTest);
+    ADD_TEST_CASE(AsyncTaskPoolTest);
+    ADD_TEST_CASE(MeshOptimizerTest);
+    ADD_TEST_CASE(MeshSimplifierTest);
+    ADD_TEST_CASE(MeshLightSelectionTest);
+    ADD_TEST_CASE(ObjLoaderTest);
 #ifdef UNIT_TEST_FOR_OPTIMIZED_MATH_UTIL
     ADD_TEST_CASE(MathUtilTest);
 #endif
@@ -1715,3 +1725,434 @@ std::string ResizableBufferAdapterTest::subtitle() const
 }
 
 
+
+// AsyncTaskPoolTest
+
+void AsyncTaskPoolTest::onEnter()
+{
+    UnitTestDemo::onEnter();
+
+    auto pool = AsyncTaskPool::getInstance();
+    struct Order
+    {
+        std::mutex mutex;
+        std::vector<int> values;
+
+        void add(int value)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            values.push_back(value);
+        }
+    };
+
+    // the work of a task starts once the work of its dependencies is done
+    auto order = std::make_shared<Order>();
+    auto first = pool->submit([order]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        order->add(1);
+    });
+    auto second = pool->submitAfter({first}, [order]() { order->add(2); });
+    auto third = pool->submitAfter({first, second}, [order]() { order->add(3); });
+    pool->wait(third);
+    EXPECT_TRUE(first->isDone());
+    EXPECT_TRUE(second->isDone());
+    EXPECT_EQ(order->values, std::vector<int>({1, 2, 3}));
+
+    // a cancelled task doesn't run, and neither do the tasks depending on it
+    auto gate = std::make_shared<std::atomic<bool>>(false);
+    auto runs = std::make_shared<std::atomic<int>>(0);
+    auto gateTask = pool->submit([gate]() {
+        while (!*gate)
+            std::this_thread::yield();
+    });
+    auto cancelled = pool->submitAfter({gateTask}, [runs]() { ++*runs; });
+    auto dependent = pool->submitAfter({cancelled}, [runs]() { ++*runs; });
+    cancelled->cancel();
+    *gate = true;
+    pool->wait(dependent);
+    EXPECT_TRUE(cancelled->isDone());
+    EXPECT_TRUE(dependent->isCancelled());
+    auto late = pool->submitAfter({cancelled}, [runs]() { ++*runs; });
+    pool->wait(late);
+    EXPECT_TRUE(late->isCancelled());
+    EXPECT_EQ(runs->load(), 0);
+
+    // with all the workers busy, the one released first takes the higher priority task first
+    unsigned int workerCount = pool->getWorkerCount();
+    auto started = std::make_shared<std::atomic<unsigned int>>(0);
+    std::shared_ptr<std::atomic<bool>> released(new std::atomic<bool>[workerCount], std::default_delete<std::atomic<bool>[]>());
+    std::vector<AsyncTaskPool::TaskHandle> blockers;
+    for (unsigned int i = 0; i < workerCount; ++i)
+    {
+        released.get()[i] = false;
+        blockers.push_back(pool->submit([started, released, i]() {
+            ++*started;
+            while (!released.get()[i])
+                std::this_thread::yield();
+        }, nullptr, AsyncTaskPool::Priority::HIGH));
+    }
+    while (*started < workerCount)
+        std::this_thread::yield();
+
+    order = std::make_shared<Order>();
+    auto low = pool->submit([order]() { order->add((int)AsyncTaskPool::Priority::LOW); }, nullptr, AsyncTaskPool::Priority::LOW);
+    auto high = pool->submit([order]() { order->add((int)AsyncTaskPool::Priority::HIGH); }, nullptr, AsyncTaskPool::Priority::HIGH);
+    released.get()[0] = true;
+    pool->wait(low);
+    pool->wait(high);
+    EXPECT_EQ(order->values, std::vector<int>({(int)AsyncTaskPool::Priority::HIGH, (int)AsyncTaskPool::Priority::LOW}));
+    for (unsigned int i = 0; i < workerCount; ++i)
+        released.get()[i] = true;
+    for (const auto& blocker : blockers)
+        pool->wait(blocker);
+
+    // every item is visited once, by ranges of the grain at most, also when it is called from a task
+    std::vector<int> visits(1000, 0);
+    auto visit = [&visits](size_t begin, size_t end) {
+        EXPECT_TRUE(begin < end && end - begin <= 7);
+        for (size_t i = begin; i < end; ++i)
+            ++visits[i];
+    };
+    pool->parallelFor(visits.size(), 7, visit);
+    auto nested = pool->submit([pool, &visits, visit]() {
+        pool->parallelFor(visits.size(), 7, visit);
+    });
+    pool->wait(nested);
+    EXPECT_EQ(std::count(visits.begin(), visits.end(), 2), (std::ptrdiff_t)visits.size());
+}
+
+std::string AsyncTaskPoolTest::subtitle() const
+{
+    return "AsyncTaskPool dependencies, cancellation, priorities and parallelFor";
+}
+
+// MeshOptimizerTest
+
+namespace
+{
+    // the triangles by the grid coordinates of their vertices, starting from the smallest to keep the winding
+    std::vector<std::vector<int>> getGridTriangles(const MeshData& meshdata)
+    {
+        int stride = meshdata.getPerVertexSize() / sizeof(float);
+        std::vector<std::vector<int>> triangles;
+        const auto& indices = meshdata.subMeshIndices[0];
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            std::vector<int> triangle;
+            for (size_t j = 0; j < 3; ++j)
+            {
+                const float* position = &meshdata.vertex[indices[i + j] * stride];
+                triangle.push_back((int)position[0] * 1000 + (int)position[2]);
+            }
+            std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+            triangles.push_back(triangle);
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+}
+
+void MeshOptimizerTest::onEnter()
+{
+    UnitTestDemo::onEnter();
+
+    // a grid of quads with a position, a normal and texture coordinates, whose triangles are scattered
+    const int size = 32;
+    const int vertexCount = (size + 1) * (size + 1);
+    const int triangleCount = 2 * size * size;
+    MeshData meshdata;
+    meshdata.attribs = {
+        {3, GL_FLOAT, GLProgram::VERTEX_ATTRIB_POSITION, 12},
+        {3, GL_FLOAT, GLProgram::VERTEX_ATTRIB_NORMAL, 12},
+        {2, GL_FLOAT, GLProgram::VERTEX_ATTRIB_TEX_COORD, 8},
+    };
+    meshdata.attribCount = (int)meshdata.attribs.size();
+    for (int y = 0; y <= size; ++y)
+    {
+        for (int x = 0; x <= size; ++x)
+        {
+            float vertex[] = {(float)x, 0, (float)y, 0, 1, 0, (float)x / size, (float)y / size};
+            meshdata.vertex.insert(meshdata.vertex.end(), vertex, vertex + 8);
+        }
+    }
+    MeshData::IndexArray indices;
+    for (int k = 0; k < triangleCount; ++k)
+    {
+        int triangle = k * 617 % triangleCount;
+        int quad = triangle / 2;
+        unsigned short corner = (unsigned short)(quad / size * (size + 1) + quad % size);
+        if (triangle % 2 == 0)
+            indices.insert(indices.end(), {corner, (unsigned short)(corner + size + 1), (unsigned short)(corner + 1)});
+        else
+            indices.insert(indices.end(), {(unsigned short)(corner + 1), (unsigned short)(corner + size + 1), (unsigned short)(corner + size + 2)});
+    }
+    meshdata.subMeshIndices.push_back(indices);
+    meshdata.numIndex = (int)indices.size();
+    auto triangles = getGridTriangles(meshdata);
+
+    // the reordering keeps the triangles and their winding, and transforms about one vertex per triangle
+    float scatteredACMR = MeshOptimizer::getACMR(indices.data(), indices.size(), vertexCount);
+    MeshOptimizer::optimize(&meshdata, MeshOptimizer::REORDER);
+    const auto& optimized = meshdata.subMeshIndices[0];
+    float optimizedACMR = MeshOptimizer::getACMR(optimized.data(), optimized.size(), vertexCount);
+    EXPECT_TRUE(scatteredACMR > 1.5f);
+    EXPECT_TRUE(optimizedACMR < 0.8f);
+    EXPECT_EQ(getGridTriangles(meshdata), triangles);
+    // the vertices are in the order the triangles use them
+    EXPECT_EQ(optimized[0], 0);
+    EXPECT_EQ((int)meshdata.vertex.size(), vertexCount * 8);
+
+    // an index out of range leaves the triangles as they are
+    auto invalid = indices;
+    invalid.back() = (unsigned short)vertexCount;
+    auto unchanged = invalid;
+    MeshOptimizer::optimizeVertexCache(invalid.data(), invalid.size(), vertexCount);
+    EXPECT_EQ(invalid, unchanged);
+
+    // the normals and the texture coordinates become normalized shorts, the positions stay floats
+    MeshOptimizer::optimize(&meshdata, MeshOptimizer::QUANTIZE);
+    EXPECT_EQ(meshdata.attribs[0].type, (GLenum)GL_FLOAT);
+    EXPECT_EQ(meshdata.attribs[1].type, (GLenum)GL_SHORT);
+    EXPECT_EQ(meshdata.attribs[2].type, (GLenum)GL_UNSIGNED_SHORT);
+    EXPECT_EQ(meshdata.getPerVertexSize(), 12 + 8 + 4);
+    EXPECT_EQ((int)meshdata.vertex.size(), vertexCount * 6);
+    const short* normal = (const short*)&meshdata.vertex[3];
+    EXPECT_TRUE(normal[0] == 0 && normal[1] == 32767 && normal[2] == 0);
+    EXPECT_EQ(getGridTriangles(meshdata), triangles);
+}
+
+std::string MeshOptimizerTest::subtitle() const
+{
+    return "MeshOptimizer reordering and quantization";
+}
+
+// MeshSimplifierTest
+
+void MeshSimplifierTest::onEnter()
+{
+    UnitTestDemo::onEnter();
+
+    // a flat grid whose two halves have their own vertices on the middle column, e.g. for other texture coordinates
+    const int size = 16;
+    const int seam = size / 2;
+    std::vector<Vec3> positions;
+    std::vector<int> sides;
+    std::vector<std::vector<unsigned short>> left(size + 1, std::vector<unsigned short>(size + 1));
+    std::vector<std::vector<unsigned short>> right = left;
+    for (int z = 0; z <= size; ++z)
+    {
+        for (int x = 0; x <= size; ++x)
+        {
+            left[z][x] = right[z][x] = (unsigned short)positions.size();
+            positions.push_back(Vec3((float)x, 0, (float)z));
+            sides.push_back(x > seam);
+            if (x == seam)
+            {
+                right[z][x] = (unsigned short)positions.size();
+                positions.push_back(Vec3((float)x, 0, (float)z));
+                sides.push_back(1);
+            }
+        }
+    }
+    std::vector<unsigned short> indices;
+    for (int z = 0; z < size; ++z)
+    {
+        for (int x = 0; x < size; ++x)
+        {
+            const auto& side = x < seam ? left : right;
+            indices.insert(indices.end(), {side[z][x], side[z + 1][x], side[z][x + 1],
+                                           side[z][x + 1], side[z + 1][x], side[z + 1][x + 1]});
+        }
+    }
+
+    // the seam is simplified like the rest of the grid, only the borders are kept
+    const size_t targetIndexCount = indices.size() / 8;
+    float error = 1.0f;
+    auto simplified = MeshSimplifier::simplify(&positions[0].x, sizeof(Vec3), positions.size(),
+                                               indices.data(), indices.size(), targetIndexCount, 0.05f, &error);
+    EXPECT_TRUE(!simplified.empty() && simplified.size() <= targetIndexCount);
+    EXPECT_TRUE(error < 1e-4f);
+
+    // the triangles keep the vertices of their side, and both sides meet at the same positions of the seam
+    std::set<float> leftSeam, rightSeam;
+    for (size_t i = 0; i < simplified.size(); i += 3)
+    {
+        int side = sides[simplified[i]];
+        for (int k = 0; k < 3; ++k)
+        {
+            const auto vertex = simplified[i + k];
+            EXPECT_EQ(sides[vertex], side);
+            if (positions[vertex].x == seam)
+                (side ? rightSeam : leftSeam).insert(positions[vertex].z);
+        }
+    }
+    EXPECT_TRUE(leftSeam.size() < (size_t)size + 1);
+    EXPECT_EQ(leftSeam, rightSeam);
+}
+
+std::string MeshSimplifierTest::subtitle() const
+{
+    return "MeshSimplifier collapses along the attribute seams";
+}
+
+// MeshLightSelectionTest
+
+namespace
+{
+    // selects the lights of a unit box without drawing it
+    class LightSelectionMesh : public Mesh
+    {
+    public:
+        LightSelectionMesh()
+        {
+            _aabb.set(Vec3(-1, -1, -1), Vec3(1, 1, 1));
+        }
+
+        void select(Scene* scene, unsigned int lightMask, const Mat4& transform)
+        {
+            updateLightUniformValues(scene, lightMask, transform);
+        }
+
+        const std::vector<Vec3>& getPointLightPositions() const { return _pointLightUniformPositionValues; }
+        const std::vector<float>& getPointLightRangeInverses() const { return _pointLightUniformRangeInverseValues; }
+    };
+}
+
+void MeshLightSelectionTest::onEnter()
+{
+    UnitTestDemo::onEnter();
+
+    // in the order of the scene: a dim light, a bright one, one out of range and one of another flag
+    auto dim = PointLight::create(Vec3(0, 0, -2), Color3B(128, 128, 128), 10);
+    auto bright = PointLight::create(Vec3(0, 0, 4), Color3B::WHITE, 10);
+    auto far = PointLight::create(Vec3(50, 0, 0), Color3B::WHITE, 10);
+    auto other = PointLight::create(Vec3(0, 0, 1), Color3B::WHITE, 10);
+    for (auto light : {dim, bright, far})
+    {
+        light->setLightFlag(LightFlag::LIGHT1);
+        addChild(light);
+    }
+    other->setLightFlag(LightFlag::LIGHT2);
+    addChild(other);
+
+    auto worldPosition = [](Node* node) {
+        Mat4 mat = node->getNodeToWorldTransform();
+        return Vec3(mat.m[12], mat.m[13], mat.m[14]);
+    };
+    auto check = [this, worldPosition](const std::vector<Node*>& expected) {
+        auto mesh = new (std::nothrow) LightSelectionMesh();
+        mesh->select(getScene(), (unsigned int)LightFlag::LIGHT1, getNodeToWorldTransform());
+        const auto& positions = mesh->getPointLightPositions();
+        const auto& rangeInverses = mesh->getPointLightRangeInverses();
+        for (size_t i = 0; i < positions.size(); ++i)
+        {
+            if (i < expected.size())
+            {
+                EXPECT_TRUE(positions[i].distanceSquared(worldPosition(expected[i])) < 1e-6f);
+            }
+            else
+            {
+                // the unused slots are uploaded too, the shaders loop over all of them
+                EXPECT_EQ(rangeInverses[i], 0.0f);
+            }
+        }
+        mesh->release();
+    };
+
+    // the lights reaching the box are kept by influence, not in the order of the scene
+    check({bright, dim});
+
+    // outside the render of the scene, e.g. for utils::captureNode(), a moved light is seen at once
+    bright->setPosition3D(Vec3(0, 50, 0));
+    check({dim});
+
+    // and in the next frames, once the scene rendered
+    scheduleOnce([=](float) {
+        bright->setPosition3D(Vec3(0, 0, 4));
+        check({bright, dim});
+    }, 0, "moved");
+}
+
+std::string MeshLightSelectionTest::subtitle() const
+{
+    return "Mesh keeps the point lights lighting it the most";
+}
+
+// ObjLoaderTest
+
+namespace
+{
+    // "mtllib" declares the materials "a" and "b"
+    class TwoMaterialsReader : public tinyobj::MaterialReader
+    {
+    public:
+        virtual std::string operator()(const std::string& /*matId*/,
+                                       std::vector<tinyobj::material_t>& materials,
+                                       std::map<std::string, int>& matMap) override
+        {
+            materials.resize(2);
+            matMap["a"] = 0;
+            matMap["b"] = 1;
+            return "";
+        }
+    };
+
+    std::string loadObj(const std::string& obj, std::vector<tinyobj::shape_t>& shapes)
+    {
+        TwoMaterialsReader reader;
+        std::vector<tinyobj::material_t> materials;
+        return tinyobj::LoadObj(shapes, materials, obj.data(), obj.size(), reader);
+    }
+}
+
+void ObjLoaderTest::onEnter()
+{
+    UnitTestDemo::onEnter();
+
+    const std::string header =
+        "mtllib test.mtl\n"
+        "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+        "vn 0 0 1\nvn 0 1 0\nvn 1 0 0\nvn 0 0 -1\n"
+        "vt 0 0\nvt 1 0\nvt 1 1\n";
+
+    // the buffer is parsed by chunks of 256KB, the comments put the statements and the faces in different chunks
+    std::string padding;
+    while (padding.size() < 768 * 1024)
+        padding += "# the faces are parsed in another chunk than the vertices\n";
+
+    std::vector<tinyobj::shape_t> shapes;
+    std::string err = loadObj(header + "o first\nusemtl a\n" + padding +
+                              "f -4//-4 -3//-3 -2//-2\n"
+                              "g second\nusemtl b\n"
+                              "f 1/1 3/3 4/3\n", shapes);
+    EXPECT_TRUE(err.empty());
+    EXPECT_EQ(shapes.size(), (size_t)2);
+    if (shapes.size() == 2)
+    {
+        // the relative indices resolve against the vertices of the first chunk, "o" and "usemtl" apply to the last one
+        const auto& first = shapes[0];
+        EXPECT_EQ(first.name, std::string("first"));
+        EXPECT_EQ(first.mesh.material_ids, std::vector<int>({0}));
+        EXPECT_EQ(first.mesh.positions, std::vector<float>({0, 0, 0, 1, 0, 0, 1, 1, 0}));
+        EXPECT_EQ(first.mesh.normals, std::vector<float>({0, 0, 1, 0, 1, 0, 1, 0, 0}));
+        EXPECT_TRUE(first.mesh.texcoords.empty());
+
+        const auto& second = shapes[1];
+        EXPECT_EQ(second.name, std::string("second"));
+        EXPECT_EQ(second.mesh.material_ids, std::vector<int>({1}));
+        EXPECT_EQ(second.mesh.positions, std::vector<float>({0, 0, 0, 1, 1, 0, 0, 1, 0}));
+        EXPECT_EQ(second.mesh.texcoords, std::vector<float>({0, 0, 1, 1, 1, 1}));
+        EXPECT_TRUE(second.mesh.normals.empty());
+    }
+
+    // out of range indices, even a relative one resolving to -1, fail instead of being dropped
+    EXPECT_FALSE(loadObj(header + "f 1 2 5\n", shapes).empty());
+    EXPECT_FALSE(loadObj(header + "f 1//-5 2//-5 3//-5\n", shapes).empty());
+    EXPECT_FALSE(loadObj(header + "f 1/4 2/4 3/4\n", shapes).empty());
+    EXPECT_FALSE(loadObj(header + "f -5 1 2\n", shapes).empty());
+}
+
+std::string ObjLoaderTest::subtitle() const
+{
+    return "ObjLoader parses a buffer by chunks";
+}
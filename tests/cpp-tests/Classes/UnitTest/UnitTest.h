@@ -103,5 +103,45 @@ public:
     virtual std::string subtitle() const override;
 };
 
+class AsyncTaskPoolTest : public UnitTestDemo
+{
+public:
+    CREATE_FUNC(AsyncTaskPoolTest);
+    virtual void onEnter() override;
+    virtual std::string subtitle() const override;
+};
+
+class MeshOptimizerTest : public UnitTestDemo
+{
+public:
+    CREATE_FUNC(MeshOptimizerTest);
+    virtual void onEnter() override;
+    virtual std::string subtitle() const override;
+};
+
+class MeshSimplifierTest : public UnitTestDemo
+{
+public:
+    CREATE_FUNC(MeshSimplifierTest);
+    virtual void onEnter() override;
+    virtual std::string subtitle() const override;
+};
+
+class MeshLightSelectionTest : public UnitTestDemo
+{
+public:
+    CREATE_FUNC(MeshLightSelectionTest);
+    virtual void onEnter() override;
+    virtual std::string subtitle() const override;
+};
+
+class ObjLoaderTest : public UnitTestDemo
+{
+public:
+    CREATE_FUNC(ObjLoaderTest);
+    virtual void onEnter() override;
+    virtual std::string subtitle() const override;
+};
+
 
 #endif /* __UNIT_TEST__ */
@@ -0,0 +1,325 @@
+/****************************************************************************
+ Copyright (c) 2017-2018 Xiamen Yaji Software Co., Ltd.
+ 
+ http://www.cocos2d-x.org
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+
+#include "PerformanceCullingTest.h"
+#include "Profile.h"
+
+#define DELAY_TIME              3
+#define STAT_TIME               3
+
+USING_NS_CC;
+
+static int kTagInfoLayer = 1;
+static int kTagSprite = 1001;
+
+static int kMaxSprites = 20000;
+static int kNodesIncrease = 500;
+
+static int autoTestSpriteCounts[] = {
+    2000, 5000, 10000
+};
+
+// every count is tested with the culling through the tree off then on
+static const int kAutoTestCullingModes = 2;
+
+// the sprites are spread on a field much larger than what the camera sees
+static const float kFieldSize = 400.0f;
+
+PerformceCullingTests::PerformceCullingTests()
+{
+    ADD_TEST_CASE(CullingPerformTest);
+}
+
+////////////////////////////////////////////////////////
+//
+// CullingMainScene
+//
+////////////////////////////////////////////////////////
+void CullingMainScene::initScene()
+{
+    isStating = false;
+    auto s = Director::getInstance()->getWinSize();
+
+    _lastRenderedCount = 0;
+    _quantitySprites = 0;
+
+    MenuItemFont::setFontSize(65);
+    auto decrease = MenuItemFont::create(" - ", [=](Ref *sender) {
+        int quantity = std::max(_quantitySprites - kNodesIncrease, 0);
+        while (_quantitySprites > quantity)
+        {
+            --_quantitySprites;
+            removeChildByTag(kTagSprite + _quantitySprites, true);
+        }
+        updateQuantityLabel();
+    });
+    decrease->setColor(Color3B(0,200,20));
+    auto increase = MenuItemFont::create(" + ", [=](Ref *sender) {
+        int quantity = std::min(_quantitySprites + kNodesIncrease, kMaxSprites);
+        while (_quantitySprites < quantity)
+        {
+            createSprite(_quantitySprites);
+            ++_quantitySprites;
+        }
+        updateQuantityLabel();
+    });
+    increase->setColor(Color3B(0,200,20));
+
+    auto menu = Menu::create(decrease, increase, nullptr);
+    menu->alignItemsHorizontally();
+    menu->setPosition(Vec2(s.width/2, s.height/2+15));
+    addChild(menu, 1);
+
+    _cullingItem = MenuItemFont::create("Culling through the tree: on", [=](Ref *sender) {
+        setTreeCulling(!isAABBTreeCullingEnabled());
+    });
+    _cullingItem->setFontSizeObj(20);
+    auto options = Menu::create(_cullingItem, nullptr);
+    options->setPosition(Vec2(s.width/2, s.height/2-40));
+    addChild(options, 1);
+
+    auto infoLabel = Label::createWithTTF("0 Sprite3Ds", "fonts/Marker Felt.ttf", 30);
+    infoLabel->setColor(Color3B(0,200,20));
+    infoLabel->setPosition(Vec2(s.width/2, s.height - 90));
+    addChild(infoLabel, 1, kTagInfoLayer);
+
+    // looks over a small part of the field
+    auto camera = Camera::createPerspective(60.0f, s.width / s.height, 1.0f, 150.0f);
+    camera->setPosition3D(Vec3(0.0f, 30.0f, 60.0f));
+    camera->lookAt(Vec3(0.0f, 0.0f, 0.0f), Vec3(0.0f, 1.0f, 0.0f));
+    camera->setCameraFlag(CameraFlag::USER1);
+    this->addChild(camera);
+
+    TTFConfig config("fonts/tahoma.ttf",10);
+    _spriteLab = Label::createWithTTF(config,"Draw calls: 0",TextHAlignment::LEFT);
+    _spriteLab->setPosition(Vec2(0.0f, s.height / 6.0f));
+    _spriteLab->setAnchorPoint(Vec2(0.0f, 0.0f));
+    this->addChild(_spriteLab);
+
+    _renderTimeLab = Label::createWithTTF(config,"Render: 0.00 ms",TextHAlignment::LEFT);
+    _renderTimeLab->setPosition(Vec2(0.0f, s.height / 6.0f - 15.0f));
+    _renderTimeLab->setAnchorPoint(Vec2(0.0f, 0.0f));
+    this->addChild(_renderTimeLab);
+
+    _renderTime = 0.0;
+    _renderCount = 0;
+    _statRenderTime = 0.0;
+    auto dispatcher = Director::getInstance()->getEventDispatcher();
+    _beforeDrawListener = dispatcher->addCustomEventListener(Director::EVENT_BEFORE_DRAW, [this](EventCustom*) {
+        _renderStart = std::chrono::steady_clock::now();
+    });
+    _afterVisitListener = dispatcher->addCustomEventListener(Director::EVENT_AFTER_VISIT, [this](EventCustom*) {
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _renderStart).count();
+        if (isStating)
+            _statRenderTime += elapsed;
+
+        _renderTime += elapsed;
+        if (++_renderCount == 60)
+        {
+            char str[64];
+            sprintf(str, "Render: %.2f ms", _renderTime / _renderCount);
+            _renderTimeLab->setString(str);
+            _renderTime = 0.0;
+            _renderCount = 0;
+        }
+    });
+    for (_quantitySprites = 0; _quantitySprites < kNodesIncrease; ++_quantitySprites)
+    {
+        createSprite(_quantitySprites);
+    }
+    updateQuantityLabel();
+    
+    schedule(CC_SCHEDULE_SELECTOR(CullingMainScene::step));
+}
+
+void CullingMainScene::onExitTransitionDidStart()
+{
+    Scene::onExitTransitionDidStart();
+    
+    auto director = Director::getInstance();
+    auto sched = director->getScheduler();
+    
+    sched->unscheduleAllForTarget(this);
+
+    auto dispatcher = director->getEventDispatcher();
+    dispatcher->removeEventListener(_beforeDrawListener);
+    dispatcher->removeEventListener(_afterVisitListener);
+}
+
+void CullingMainScene::onEnterTransitionDidFinish()
+{
+    Scene::onEnterTransitionDidFinish();
+    
+    if (this->isAutoTesting()) {
+        Profile::getInstance()->testCaseBegin("CullingTest",
+                                              genStrVector("SpriteCount", "TreeCulling", nullptr),
+                                              genStrVector("Avg", "Min", "Max", "Render(ms)", nullptr));
+        autoTestIndex = 0;
+        
+        doAutoTest();
+    }
+}
+
+void CullingMainScene::removeAllSprites()
+{
+    for (int i = 0; i < _quantitySprites; i++) {
+        removeChildByTag(kTagSprite + i, true);
+    }
+    _quantitySprites = 0;
+}
+
+void CullingMainScene::setTreeCulling(bool enabled)
+{
+    setAABBTreeCullingEnabled(enabled);
+    _cullingItem->setString(enabled ? "Culling through the tree: on" : "Culling through the tree: off");
+}
+
+void CullingMainScene::doAutoTest()
+{
+    isStating = false;
+    statCount = 0;
+    totalStatTime = 0.0f;
+    minFrameRate = -1.0f;
+    maxFrameRate = -1.0f;
+    _statRenderTime = 0.0;
+    
+    setTreeCulling(autoTestIndex % kAutoTestCullingModes != 0);
+    removeAllSprites();
+    _quantitySprites = autoTestSpriteCounts[autoTestIndex / kAutoTestCullingModes];
+    updateQuantityLabel();
+    for (int i = 0; i < _quantitySprites; i++) {
+        createSprite(i);
+    }
+    
+    schedule(CC_SCHEDULE_SELECTOR(CullingMainScene::beginStat), DELAY_TIME);
+    schedule(CC_SCHEDULE_SELECTOR(CullingMainScene::endStat), DELAY_TIME + STAT_TIME);
+}
+
+void CullingMainScene::beginStat(float dt)
+{
+    unschedule(CC_SCHEDULE_SELECTOR(CullingMainScene::beginStat));
+    isStating = true;
+}
+
+void CullingMainScene::endStat(float dt)
+{
+    unschedule(CC_SCHEDULE_SELECTOR(CullingMainScene::endStat));
+    isStating = false;
+
+    // record test data
+    auto avgStr = genStr("%.2f", (float) statCount / totalStatTime);
+    auto renderStr = genStr("%.2f", statCount > 0 ? _statRenderTime / statCount : 0.0);
+    Profile::getInstance()->addTestResult(genStrVector(genStr("%d", _quantitySprites).c_str(),
+                                                       isAABBTreeCullingEnabled() ? "on" : "off", nullptr),
+                                          genStrVector(avgStr.c_str(), genStr("%.2f", minFrameRate).c_str(),
+                                                       genStr("%.2f", maxFrameRate).c_str(), renderStr.c_str(), nullptr));
+
+    // check the auto test is end or not
+    int autoTestCount = sizeof(autoTestSpriteCounts) / sizeof(int) * kAutoTestCullingModes;
+    if (autoTestIndex >= (autoTestCount - 1))
+    {
+        // auto test end
+        Profile::getInstance()->testCaseEnd();
+        setAutoTesting(false);
+        return;
+    }
+
+    autoTestIndex++;
+    doAutoTest();
+}
+
+void CullingMainScene::step(float dt)
+{
+    char str[64];
+    sprintf(str, "Draw calls: %d", (int)Director::getInstance()->getRenderer()->getDrawnBatches());
+    _spriteLab->setString(str);
+    
+    if (isStating)
+    {
+        totalStatTime += dt;
+        statCount++;
+        
+        auto curFrameRate = Director::getInstance()->getFrameRate();
+        if (maxFrameRate < 0 || curFrameRate > maxFrameRate)
+            maxFrameRate = curFrameRate;
+        
+        if (minFrameRate < 0 || curFrameRate < minFrameRate)
+            minFrameRate = curFrameRate;
+    }
+}
+
+void CullingMainScene::createSprite(int idx)
+{
+    auto sprite = Sprite3D::create("Sprite3D/box.obj");
+    sprite->setTexture("Images/grossini.png");
+    sprite->setCameraMask((unsigned short)CameraFlag::USER1);
+    sprite->setScale(2.0f);
+    sprite->setPosition3D(Vec3(CCRANDOM_MINUS1_1() * kFieldSize, 0.0f, CCRANDOM_MINUS1_1() * kFieldSize));
+    // some of them turn, so their proxies move in the tree
+    if (idx % 8 == 0)
+    {
+        sprite->runAction(RepeatForever::create(RotateBy::create(2.0f, Vec3(0.0f, 360.0f, 0.0f))));
+    }
+    addChild(sprite, 0, kTagSprite + idx);
+}
+
+void CullingMainScene::updateQuantityLabel()
+{
+    if( _quantitySprites != _lastRenderedCount )
+    {
+        auto infoLabel = (Label *) getChildByTag(kTagInfoLayer);
+        char str[64] = {0};
+        sprintf(str, "%d Sprite3Ds", _quantitySprites);
+        infoLabel->setString(str);
+
+        _lastRenderedCount = _quantitySprites;
+    }
+}
+
+////////////////////////////////////////////////////////
+//
+// CullingPerformTest
+//
+////////////////////////////////////////////////////////
+std::string CullingPerformTest::title() const
+{
+    return "Sprite3D Culling Test";
+}
+
+std::string CullingPerformTest::subtitle() const
+{
+    return "Sprite3Ds out of the camera skip their visit when culled through the AABBTree";
+}
+
+bool CullingPerformTest::init()
+{
+    if (CullingMainScene::init())
+    {
+        initScene();
+        return true;
+    }
+
+    return false;
+}
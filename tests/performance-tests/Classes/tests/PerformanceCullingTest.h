@@ -0,0 +1,87 @@
+/****************************************************************************
+ Copyright (c) 2017-2018 Xiamen Yaji Software Co., Ltd.
+ 
+ http://www.cocos2d-x.org
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+
+#ifndef __PERFORMANCE_CULLING_TEST_H__
+#define __PERFORMANCE_CULLING_TEST_H__
+
+#include "BaseTest.h"
+#include <chrono>
+
+DEFINE_TEST_SUITE(PerformceCullingTests);
+
+class CullingMainScene : public TestCase
+{
+public:
+    virtual void initScene();
+
+    void step(float dt);
+    void createSprite(int idx);
+    void updateQuantityLabel();
+    virtual void doTest() = 0;
+
+    // overrides
+    virtual void onExitTransitionDidStart() override;
+    virtual void onEnterTransitionDidFinish() override;
+    void beginStat(float dt);
+    void endStat(float dt);
+    void doAutoTest();
+    void removeAllSprites();
+    void setTreeCulling(bool enabled);
+    
+protected:
+    int             _lastRenderedCount;
+    int             _quantitySprites;
+    cocos2d::Label *_spriteLab;
+    cocos2d::Label *_renderTimeLab;
+    cocos2d::MenuItemFont *_cullingItem;
+
+    // time spent visiting and drawing the scene, the culling happens there
+    cocos2d::EventListenerCustom *_beforeDrawListener;
+    cocos2d::EventListenerCustom *_afterVisitListener;
+    std::chrono::steady_clock::time_point _renderStart;
+    double     _renderTime;
+    int        _renderCount;
+    double     _statRenderTime;
+
+    bool       isStating;
+    int        autoTestIndex;
+    int        statCount;
+    float      totalStatTime;
+    float      minFrameRate;
+    float      maxFrameRate;
+};
+
+class CullingPerformTest : public CullingMainScene
+{
+public:
+    CREATE_FUNC(CullingPerformTest);
+
+    virtual bool init() override;
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+    virtual void doTest()override{};
+};
+
+#endif
@@ -0,0 +1,218 @@
+/****************************************************************************
+ Copyright (c) 2017-2018 Xiamen Yaji Software Co., Ltd.
+ 
+ http://www.cocos2d-x.org
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "PerformanceObjLoaderTest.h"
+#include "Profile.h"
+#include "3d/CCObjLoader.h"
+
+#include <sstream>
+
+USING_NS_CC;
+
+// Enable profiles for this file
+#undef CC_PROFILER_DISPLAY_TIMERS
+#define CC_PROFILER_DISPLAY_TIMERS() Profiler::getInstance()->displayTimers()
+#undef CC_PROFILER_PURGE_ALL
+#define CC_PROFILER_PURGE_ALL() Profiler::getInstance()->releaseAllTimers()
+
+#undef CC_PROFILER_START
+#define CC_PROFILER_START(__name__) ProfilingBeginTimingBlock(__name__)
+#undef CC_PROFILER_STOP
+#define CC_PROFILER_STOP(__name__) ProfilingEndTimingBlock(__name__)
+#undef CC_PROFILER_RESET
+#define CC_PROFILER_RESET(__name__) ProfilingResetTimingBlock(__name__)
+
+#undef CC_PROFILER_START_CATEGORY
+#define CC_PROFILER_START_CATEGORY(__cat__, __name__) do{ if(__cat__) ProfilingBeginTimingBlock(__name__); } while(0)
+#undef CC_PROFILER_STOP_CATEGORY
+#define CC_PROFILER_STOP_CATEGORY(__cat__, __name__) do{ if(__cat__) ProfilingEndTimingBlock(__name__); } while(0)
+#undef CC_PROFILER_RESET_CATEGORY
+#define CC_PROFILER_RESET_CATEGORY(__cat__, __name__) do{ if(__cat__) ProfilingResetTimingBlock(__name__); } while(0)
+
+#undef CC_PROFILER_START_INSTANCE
+#define CC_PROFILER_START_INSTANCE(__id__, __name__) do{ ProfilingBeginTimingBlock( String::createWithFormat("%08X - %s", __id__, __name__)->getCString() ); } while(0)
+#undef CC_PROFILER_STOP_INSTANCE
+#define CC_PROFILER_STOP_INSTANCE(__id__, __name__) do{ ProfilingEndTimingBlock(    String::createWithFormat("%08X - %s", __id__, __name__)->getCString() ); } while(0)
+#undef CC_PROFILER_RESET_INSTANCE
+#define CC_PROFILER_RESET_INSTANCE(__id__, __name__) do{ ProfilingResetTimingBlock( String::createWithFormat("%08X - %s", __id__, __name__)->getCString() ); } while(0)
+
+static const int K_INFO_GRID_TAG = 1581;
+
+
+static int autoTestGridSizes[] = {
+    100, 200, 400
+};
+
+PerformceObjLoaderTests::PerformceObjLoaderTests()
+{
+    ADD_TEST_CASE(PerformanceObjLoaderLayer1);
+    ADD_TEST_CASE(PerformanceObjLoaderLayer2);
+}
+
+void PerformanceObjLoaderLayer::onEnter()
+{
+    TestCase::onEnter();
+    
+    CC_PROFILER_PURGE_ALL();
+    
+    if (isAutoTesting()) {
+        autoTestIndex = 0;
+        _gridSize = autoTestGridSizes[autoTestIndex];
+        Profile::getInstance()->testCaseBegin("ObjLoaderTest",
+                                              genStrVector("Type", "GridSize", nullptr),
+                                              genStrVector("Avg", "Min", "Max", nullptr));
+    }
+    
+    auto s = Director::getInstance()->getWinSize();
+    
+    MenuItemFont::setFontSize(65);
+    auto decrease = MenuItemFont::create(" - ", CC_CALLBACK_1(PerformanceObjLoaderLayer::subGridSize, this));
+    decrease->setColor(Color3B(0,200,20));
+    auto increase = MenuItemFont::create(" + ", CC_CALLBACK_1(PerformanceObjLoaderLayer::addGridSize, this));
+    increase->setColor(Color3B(0,200,20));
+    
+    auto menu = Menu::create(decrease, increase, nullptr);
+    menu->alignItemsHorizontally();
+    menu->setPosition(Vec2(s.width/2, s.height/2));
+    addChild(menu, 1);
+    
+    auto infoLabel = Label::createWithTTF("0", "fonts/Marker Felt.ttf", 30);
+    infoLabel->setColor(Color3B(0,200,20));
+    infoLabel->setPosition(Vec2(s.width/2, s.height/2 + 40));
+    addChild(infoLabel, 1, K_INFO_GRID_TAG);
+    generateObj();
+    
+    // a parse takes a while, not every frame
+    getScheduler()->schedule(schedule_selector(PerformanceObjLoaderLayer::doPerformanceTest), this, 0.2f, false);
+    getScheduler()->schedule(schedule_selector(PerformanceObjLoaderLayer::dumpProfilerInfo), this, 2, false);
+}
+
+void PerformanceObjLoaderLayer::addGridSize(Ref *sender)
+{
+    _gridSize += _stepSize;
+    CC_PROFILER_PURGE_ALL();
+    generateObj();
+}
+
+void PerformanceObjLoaderLayer::subGridSize(Ref *sender)
+{
+    _gridSize -= _stepSize;
+    _gridSize = std::max(_gridSize, _stepSize);
+    CC_PROFILER_PURGE_ALL();
+    generateObj();
+}
+
+void PerformanceObjLoaderLayer::generateObj()
+{
+    // the same file for both parsers
+    _obj.clear();
+    char line[128];
+    const int rowSize = _gridSize + 1;
+    for (int object = 0; object < 4; ++object)
+    {
+        sprintf(line, "o object%d\n", object);
+        _obj += line;
+        for (int y = 0; y < rowSize; ++y)
+        {
+            for (int x = 0; x < rowSize; ++x)
+            {
+                float u = (float)x / _gridSize;
+                float v = (float)y / _gridSize;
+                sprintf(line, "v %f %f %f\nvn %f %f %f\nvt %f %f\n", u * 100.0f, sinf(u * 10.0f) * cosf(v * 10.0f), v * 100.0f + object * 100.0f, 0.0f, 1.0f, 0.0f, u, v);
+                _obj += line;
+            }
+        }
+        const int base = object * rowSize * rowSize + 1;
+        for (int y = 0; y < _gridSize; ++y)
+        {
+            for (int x = 0; x < _gridSize; ++x)
+            {
+                int a = base + y * rowSize + x;
+                int b = a + rowSize;
+                sprintf(line, "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, b + 1, b + 1, b + 1, a + 1, a + 1, a + 1);
+                _obj += line;
+            }
+        }
+    }
+    updateGridLabel();
+}
+
+void PerformanceObjLoaderLayer::updateGridLabel()
+{
+    auto infoLabel = (Label *) getChildByTag(K_INFO_GRID_TAG);
+    char str[64] = {0};
+    sprintf(str, "%d x %d x 4 quads, %.1f MB", _gridSize, _gridSize, _obj.size() / (1024.0f * 1024.0f));
+    infoLabel->setString(str);
+}
+
+void PerformanceObjLoaderLayer::dumpProfilerInfo(float dt)
+{
+    CC_PROFILER_DISPLAY_TIMERS();
+    
+    if (this->isAutoTesting()) {
+        // record the test result to class Profile
+        auto timer = Profiler::getInstance()->_activeTimers.at(_profileName);
+        auto numStr = genStr("%d", _gridSize);
+        auto avgStr = genStr("%ldµ", timer->_averageTime2);
+        auto minStr = genStr("%ldµ", timer->minTime);
+        auto maxStr = genStr("%ldµ", timer->maxTime);
+        Profile::getInstance()->addTestResult(genStrVector(_profileName.c_str(), numStr.c_str(), nullptr),
+                                              genStrVector(avgStr.c_str(), minStr.c_str(), maxStr.c_str(), nullptr));
+
+        auto testsSize = sizeof(autoTestGridSizes)/sizeof(int);
+        if (autoTestIndex >= (testsSize - 1)) {
+            this->setAutoTesting(false);
+            Profile::getInstance()->testCaseEnd();
+        }
+        else
+        {
+            // update the auto test index
+            autoTestIndex++;
+            _gridSize = autoTestGridSizes[autoTestIndex];
+            generateObj();
+            CC_PROFILER_PURGE_ALL();
+        }
+    }
+}
+
+void PerformanceObjLoaderLayer1::doPerformanceTest(float dt)
+{
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    tinyobj::MaterialFileReader materialReader("");
+    CC_PROFILER_START(_profileName.c_str());
+    std::istringstream stream(_obj);
+    tinyobj::LoadObj(shapes, materials, stream, materialReader);
+    CC_PROFILER_STOP(_profileName.c_str());
+}
+
+void PerformanceObjLoaderLayer2::doPerformanceTest(float dt)
+{
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    tinyobj::MaterialFileReader materialReader("");
+    CC_PROFILER_START(_profileName.c_str());
+    tinyobj::LoadObj(shapes, materials, _obj.data(), _obj.size(), materialReader);
+    CC_PROFILER_STOP(_profileName.c_str());
+}
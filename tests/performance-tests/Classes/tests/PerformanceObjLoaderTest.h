@@ -0,0 +1,95 @@
+/****************************************************************************
+ Copyright (c) 2017-2018 Xiamen Yaji Software Co., Ltd.
+ 
+ http://www.cocos2d-x.org
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __PERFORMANCE_OBJ_LOADER_TEST_H__
+#define __PERFORMANCE_OBJ_LOADER_TEST_H__
+
+#include "BaseTest.h"
+
+DEFINE_TEST_SUITE(PerformceObjLoaderTests);
+
+class PerformanceObjLoaderLayer : public TestCase
+{
+public:
+    PerformanceObjLoaderLayer()
+    : _gridSize(200)
+    , _stepSize(50)
+    , _profileName("")
+    {
+        
+    }
+    
+    virtual void onEnter() override;
+    
+    virtual std::string title() const override{ return "ObjLoader Performance Test"; }
+    virtual std::string subtitle() const override{ return "PerformanceObjLoaderLayer subTitle"; }
+    
+    void addGridSize(cocos2d::Ref* sender);
+    void subGridSize(cocos2d::Ref* sender);
+protected:
+    virtual void doPerformanceTest(float dt) {};
+    
+    void generateObj();
+    void dumpProfilerInfo(float dt);
+    void updateGridLabel();
+protected:
+    int autoTestIndex;
+    int _gridSize;
+    int _stepSize;
+    std::string _profileName;
+    // a grid of quads with normals and texture coordinates, in 4 objects
+    std::string _obj;
+};
+
+class PerformanceObjLoaderLayer1 : public PerformanceObjLoaderLayer
+{
+public:
+    CREATE_FUNC(PerformanceObjLoaderLayer1);
+
+    PerformanceObjLoaderLayer1()
+    {
+        _profileName = "ObjLoader: istream";
+    }
+    
+    virtual void doPerformanceTest(float dt) override;
+    
+    virtual std::string subtitle() const override{ return "std::istream, line by line"; }
+};
+
+class PerformanceObjLoaderLayer2 : public PerformanceObjLoaderLayer
+{
+public:
+    CREATE_FUNC(PerformanceObjLoaderLayer2);
+
+    PerformanceObjLoaderLayer2()
+    {
+        _profileName = "ObjLoader: buffer";
+    }
+    
+    virtual void doPerformanceTest(float dt) override;
+    
+    virtual std::string subtitle() const override{ return "Buffer, chunks in parallel"; }
+};
+
+#endif //__PERFORMANCE_OBJ_LOADER_TEST_H__
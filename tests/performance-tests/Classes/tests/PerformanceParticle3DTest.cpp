@@ -42,6 +42,18 @@ static int autoTestParticleCounts[] = {
     200, 500, 800
 };
 
+// every count is tested with batch processing off then on
+static const int kAutoTestBatchModes = 2;
+
+static const struct {
+    const char *script;
+    const char *material;
+} kParticleScripts[] = {
+    { "Particle3D/scripts/example_004.pu", "Particle3D/materials/pu_example.material" },
+    { "Particle3D/scripts/blackHole.pu", "Particle3D/materials/pu_mediapack_01.material" },
+    { "Particle3D/scripts/flareShield.pu", "Particle3D/materials/pu_mediapack_01.material" },
+};
+
 PerformceParticle3DTests::PerformceParticle3DTests()
 {
     ADD_TEST_CASE(Particle3DPerformTest);
@@ -61,6 +73,7 @@ void Particle3DMainScene::initScene()
 
     _lastRenderedCount = 0;
     _quantityParticles = 0;
+    _scriptIndex = 0;
 
     MenuItemFont::setFontSize(65);
     auto decrease = MenuItemFont::create(" - ", [=](Ref *sender) {
@@ -87,6 +100,26 @@ void Particle3DMainScene::initScene()
     menu->setPosition(Vec2(s.width/2, s.height/2+15));
     addChild(menu, 1);
 
+    _batchItem = MenuItemFont::create("Batch processing: on", [=](Ref *sender) {
+        setBatchProcessing(!PUParticleSystem3D::isBatchProcessingEnabled());
+    });
+    auto script = MenuItemFont::create(kParticleScripts[0].script, [=](Ref *sender) {
+        _scriptIndex = (_scriptIndex + 1) % (sizeof(kParticleScripts) / sizeof(kParticleScripts[0]));
+        static_cast<MenuItemFont *>(sender)->setString(kParticleScripts[_scriptIndex].script);
+        int quantity = _quantityParticles;
+        removeAllParticles();
+        _quantityParticles = quantity;
+        for (int i = 0; i < _quantityParticles; i++) {
+            createParticleSystem(i);
+        }
+    });
+    _batchItem->setFontSizeObj(20);
+    script->setFontSizeObj(20);
+    auto options = Menu::create(_batchItem, script, nullptr);
+    options->alignItemsVertically();
+    options->setPosition(Vec2(s.width/2, s.height/2-40));
+    addChild(options, 1);
+
     auto infoLabel = Label::createWithTTF("0 Particle Systems", "fonts/Marker Felt.ttf", 30);
     infoLabel->setColor(Color3B(0,200,20));
     infoLabel->setPosition(Vec2(s.width/2, s.height - 90));
@@ -103,6 +136,34 @@ void Particle3DMainScene::initScene()
     _particleLab->setPosition(Vec2(0.0f, s.height / 6.0f));
     _particleLab->setAnchorPoint(Vec2(0.0f, 0.0f));
     this->addChild(_particleLab);
+
+    _updateTimeLab = Label::createWithTTF(config,"Update: 0.00 ms",TextHAlignment::LEFT);
+    _updateTimeLab->setPosition(Vec2(0.0f, s.height / 6.0f - 15.0f));
+    _updateTimeLab->setAnchorPoint(Vec2(0.0f, 0.0f));
+    this->addChild(_updateTimeLab);
+
+    _updateTime = 0.0;
+    _updateCount = 0;
+    _statUpdateTime = 0.0;
+    auto dispatcher = Director::getInstance()->getEventDispatcher();
+    _beforeUpdateListener = dispatcher->addCustomEventListener(Director::EVENT_BEFORE_UPDATE, [this](EventCustom*) {
+        _updateStart = std::chrono::steady_clock::now();
+    });
+    _afterUpdateListener = dispatcher->addCustomEventListener(Director::EVENT_AFTER_UPDATE, [this](EventCustom*) {
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _updateStart).count();
+        if (isStating)
+            _statUpdateTime += elapsed;
+
+        _updateTime += elapsed;
+        if (++_updateCount == 60)
+        {
+            char str[64];
+            sprintf(str, "Update: %.2f ms", _updateTime / _updateCount);
+            _updateTimeLab->setString(str);
+            _updateTime = 0.0;
+            _updateCount = 0;
+        }
+    });
     _quantityParticles = 1;
     updateQuantityLabel();
     createParticleSystem(_quantityParticles - 1);
@@ -118,6 +179,11 @@ void Particle3DMainScene::onExitTransitionDidStart()
     auto sched = director->getScheduler();
     
     sched->unscheduleAllForTarget(this);
+
+    auto dispatcher = director->getEventDispatcher();
+    dispatcher->removeEventListener(_beforeUpdateListener);
+    dispatcher->removeEventListener(_afterUpdateListener);
+    PUParticleSystem3D::setBatchProcessingEnabled(true);
 }
 
 void Particle3DMainScene::onEnterTransitionDidFinish()
@@ -126,8 +192,8 @@ void Particle3DMainScene::onEnterTransitionDidFinish()
     
     if (this->isAutoTesting()) {
         Profile::getInstance()->testCaseBegin("Particle3DTest",
-                                              genStrVector("ParticleSystemCount", nullptr),
-                                              genStrVector("Avg", "Min", "Max", nullptr));
+                                              genStrVector("ParticleSystemCount", "BatchProcessing", nullptr),
+                                              genStrVector("Avg", "Min", "Max", "Update(ms)", nullptr));
         autoTestIndex = 0;
         
         doAutoTest();
@@ -142,6 +208,12 @@ void Particle3DMainScene::removeAllParticles()
     _quantityParticles = 0;
 }
 
+void Particle3DMainScene::setBatchProcessing(bool enabled)
+{
+    PUParticleSystem3D::setBatchProcessingEnabled(enabled);
+    _batchItem->setString(enabled ? "Batch processing: on" : "Batch processing: off");
+}
+
 void Particle3DMainScene::doAutoTest()
 {
     isStating = false;
@@ -149,9 +221,11 @@ void Particle3DMainScene::doAutoTest()
     totalStatTime = 0.0f;
     minFrameRate = -1.0f;
     maxFrameRate = -1.0f;
+    _statUpdateTime = 0.0;
     
+    setBatchProcessing(autoTestIndex % kAutoTestBatchModes != 0);
     removeAllParticles();
-    _quantityParticles = autoTestParticleCounts[autoTestIndex];
+    _quantityParticles = autoTestParticleCounts[autoTestIndex / kAutoTestBatchModes];
     updateQuantityLabel();
     for (int i = 0; i < _quantityParticles; i++) {
         createParticleSystem(i);
@@ -174,12 +248,14 @@ void Particle3DMainScene::endStat(float dt)
 
     // record test data
     auto avgStr = genStr("%.2f", (float) statCount / totalStatTime);
-    Profile::getInstance()->addTestResult(genStrVector(genStr("%d", _quantityParticles).c_str(), nullptr),
+    auto updateStr = genStr("%.2f", statCount > 0 ? _statUpdateTime / statCount : 0.0);
+    Profile::getInstance()->addTestResult(genStrVector(genStr("%d", _quantityParticles).c_str(),
+                                                       PUParticleSystem3D::isBatchProcessingEnabled() ? "on" : "off", nullptr),
                                           genStrVector(avgStr.c_str(), genStr("%.2f", minFrameRate).c_str(),
-                                                       genStr("%.2f", maxFrameRate).c_str(), nullptr));
+                                                       genStr("%.2f", maxFrameRate).c_str(), updateStr.c_str(), nullptr));
 
     // check the auto test is end or not
-    int autoTestCount = sizeof(autoTestParticleCounts) / sizeof(int);
+    int autoTestCount = sizeof(autoTestParticleCounts) / sizeof(int) * kAutoTestBatchModes;
     if (autoTestIndex >= (autoTestCount - 1))
     {
         // auto test end
@@ -230,7 +306,7 @@ void Particle3DMainScene::step(float dt)
 
 void Particle3DMainScene::createParticleSystem(int idx)
 {
-    auto ps = PUParticleSystem3D::create("Particle3D/scripts/example_004.pu", "Particle3D/materials/pu_example.material");
+    auto ps = PUParticleSystem3D::create(kParticleScripts[_scriptIndex].script, kParticleScripts[_scriptIndex].material);
     ps->setCameraMask((unsigned short)CameraFlag::USER1);
     ps->setPosition(CCRANDOM_MINUS1_1() * 50.0f, CCRANDOM_MINUS1_1() * 20.0f);
     ps->startParticleSystem();
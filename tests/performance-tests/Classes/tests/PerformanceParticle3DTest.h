@@ -26,6 +26,7 @@
 #define __PERFORMANCE_PARTICLE_3D_TEST_H__
 
 #include "BaseTest.h"
+#include <chrono>
 
 DEFINE_TEST_SUITE(PerformceParticle3DTests);
 
@@ -47,11 +48,23 @@ public:
     void endStat(float dt);
     void doAutoTest();
     void removeAllParticles();
+    void setBatchProcessing(bool enabled);
     
 protected:
     int             _lastRenderedCount;
     int             _quantityParticles;
     cocos2d::Label *_particleLab;
+    cocos2d::Label *_updateTimeLab;
+    cocos2d::MenuItemFont *_batchItem;
+    int             _scriptIndex;
+
+    // time spent in the scheduler, the particle systems update there
+    cocos2d::EventListenerCustom *_beforeUpdateListener;
+    cocos2d::EventListenerCustom *_afterUpdateListener;
+    std::chrono::steady_clock::time_point _updateStart;
+    double     _updateTime;
+    int        _updateCount;
+    double     _statUpdateTime;
 
     bool       isStating;
     int        autoTestIndex;
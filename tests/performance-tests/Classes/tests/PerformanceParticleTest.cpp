@@ -23,6 +23,8 @@
  ****************************************************************************/
 
 #include "PerformanceParticleTest.h"
+#include <chrono>
+#include "2d/CCParticleKernels.h"
 #include "Profile.h"
 
 USING_NS_CC;
@@ -37,6 +39,7 @@ enum {
     kTagParticleSystem = 3,
     kTagLabelAtlas = 4,
     kTagTitle = 5,
+    kTagKernelsLabel = 6,
     kTagMenuLayer = 1000,
 
     TEST_COUNT = 4,
@@ -54,6 +57,65 @@ static int autoTestParticleCounts[] = {
     1000, 2000, 3000
 };
 
+static const char* kernelsName()
+{
+    return ParticleKernels::isVectorized() ? "SIMD" : "Scalar";
+}
+
+// Measures the particles processed per millisecond by update(), from the simulation to the
+// update of the quads. Uploading the quads isn't counted.
+class TimedParticleSystemQuad : public ParticleSystemQuad
+{
+public:
+    static TimedParticleSystemQuad* create(int numberOfParticles)
+    {
+        auto ret = new (std::nothrow) TimedParticleSystemQuad();
+        if (ret && ret->initWithTotalParticles(numberOfParticles))
+        {
+            ret->autorelease();
+            return ret;
+        }
+        CC_SAFE_DELETE(ret);
+        return nullptr;
+    }
+
+    virtual void update(float dt) override
+    {
+        _updating = true;
+        _updateStart = std::chrono::steady_clock::now();
+        // not deferred to ParticleSystem::simulatePendingSystems(), so that the whole update is timed
+        step(dt, false);
+        _updating = false;
+    }
+
+    virtual void updateParticleQuads() override
+    {
+        ParticleSystemQuad::updateParticleQuads();
+        if (_updating)
+        {
+            _updateTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _updateStart).count();
+            _updatedParticles += getParticleCount();
+        }
+    }
+
+    void resetStat()
+    {
+        _updateTime = 0;
+        _updatedParticles = 0;
+    }
+
+    double getParticlesPerMillisecond() const
+    {
+        return _updateTime > 0 ? _updatedParticles / _updateTime : 0;
+    }
+
+private:
+    bool _updating = false;
+    std::chrono::steady_clock::time_point _updateStart;
+    double _updateTime = 0;
+    double _updatedParticles = 0;
+};
+
 PerformceParticleTests::PerformceParticleTests()
 {
     ADD_TEST_CASE(ParticlePerformTest1);
@@ -69,6 +131,8 @@ PerformceParticleTests::PerformceParticleTests()
 ////////////////////////////////////////////////////////
 ParticleMainScene::ParticleMainScene()
 : particleSize(4)
+, autoTestScalar(true)
+, kernelsStatTime(0)
 {
     
 }
@@ -120,11 +184,29 @@ void ParticleMainScene::initWithSubTest(int asubtest, int particles)
     menu->setPosition(Vec2(s.width/2, s.height/2+15));
     addChild(menu, 1);
 
+    // switches between the SIMD and scalar particle kernels
+    MenuItemFont::setFontSize(30);
+    auto kernels = MenuItemFont::create(kernelsName(), [&](Ref *sender) {
+        ParticleKernels::setVectorized(!ParticleKernels::isVectorized());
+        static_cast<MenuItemFont*>(sender)->setString(kernelsName());
+        static_cast<TimedParticleSystemQuad*>(getChildByTag(kTagParticleSystem))->resetStat();
+        kernelsStatTime = 0;
+    });
+    kernels->setColor(Color3B(0,200,20));
+    auto kernelsMenu = Menu::create(kernels, nullptr);
+    kernelsMenu->setPosition(Vec2(s.width/2, s.height/2-40));
+    addChild(kernelsMenu, 1);
+
     auto infoLabel = Label::createWithTTF("0 nodes", "fonts/Marker Felt.ttf", 30);
     infoLabel->setColor(Color3B(0,200,20));
     infoLabel->setPosition(Vec2(s.width/2, s.height - 90));
     addChild(infoLabel, 1, kTagInfoLayer);
 
+    auto kernelsLabel = Label::createWithTTF("", "fonts/arial.ttf", 20);
+    kernelsLabel->setColor(Color3B(0,200,20));
+    kernelsLabel->setPosition(Vec2(s.width/2, s.height - 125));
+    addChild(kernelsLabel, 1, kTagKernelsLabel);
+
     // particles on stage
     auto labelAtlas = LabelAtlas::create("0000", "fps_images.png", 12, 32, '.');
     addChild(labelAtlas, 0, kTagLabelAtlas);
@@ -172,6 +254,8 @@ void ParticleMainScene::onExitTransitionDidStart()
     auto sched = director->getScheduler();
 
     sched->unscheduleAllForTarget(this);
+
+    ParticleKernels::setVectorized(true);
 }
 
 void ParticleMainScene::onEnterTransitionDidFinish()
@@ -180,9 +264,10 @@ void ParticleMainScene::onEnterTransitionDidFinish()
 
     if (this->isAutoTesting()) {
         Profile::getInstance()->testCaseBegin("ParticleTest",
-                                              genStrVector("Size", "TextureFormat", "ParticleCount", nullptr),
-                                              genStrVector("Avg", "Min", "Max", nullptr));
+                                              genStrVector("Size", "TextureFormat", "ParticleCount", "Kernels", nullptr),
+                                              genStrVector("Avg", "Min", "Max", "ParticlesPerMs", nullptr));
         autoTestIndex = 0;
+        autoTestScalar = true;
         subtestNumber = 1;
         
         doAutoTest();
@@ -197,6 +282,8 @@ void ParticleMainScene::doAutoTest()
     minFrameRate = -1.0f;
     maxFrameRate = -1.0f;
     
+    // every case runs with the scalar kernels, then with the SIMD ones
+    ParticleKernels::setVectorized(!autoTestScalar);
     quantityParticles = autoTestParticleCounts[autoTestIndex];
     updateQuantityLabel();
     updateTitle();
@@ -210,6 +297,9 @@ void ParticleMainScene::beginStat(float dt)
 {
     unschedule(CC_SCHEDULE_SELECTOR(ParticleMainScene::beginStat));
     isStating = true;
+
+    auto emitter = static_cast<TimedParticleSystemQuad*>(getChildByTag(kTagParticleSystem));
+    emitter->resetStat();
 }
 
 void ParticleMainScene::endStat(float dt)
@@ -233,11 +323,21 @@ void ParticleMainScene::endStat(float dt)
             tf = "unknown";
             break;
     }
+    auto emitter = static_cast<TimedParticleSystemQuad*>(getChildByTag(kTagParticleSystem));
     auto avgStr = genStr("%.2f", (float) statCount / totalStatTime);
     Profile::getInstance()->addTestResult(genStrVector(genStr("%d", particleSize).c_str(), tf.c_str(),
-                                                       genStr("%d", quantityParticles).c_str(), nullptr),
+                                                       genStr("%d", quantityParticles).c_str(), kernelsName(), nullptr),
                                           genStrVector(avgStr.c_str(), genStr("%.2f", minFrameRate).c_str(),
-                                                       genStr("%.2f", maxFrameRate).c_str(), nullptr));
+                                                       genStr("%.2f", maxFrameRate).c_str(),
+                                                       genStr("%.1f", emitter->getParticlesPerMillisecond()).c_str(), nullptr));
+
+    if (autoTestScalar)
+    {
+        autoTestScalar = false;
+        doAutoTest();
+        return;
+    }
+    autoTestScalar = true;
 
     // check the auto test is end or not
     int autoTestCount = sizeof(autoTestParticleCounts) / sizeof(int);
@@ -247,6 +347,7 @@ void ParticleMainScene::endStat(float dt)
         // auto test end
         Profile::getInstance()->testCaseEnd();
         setAutoTesting(false);
+        ParticleKernels::setVectorized(true);
         return;
     }
 
@@ -283,6 +384,17 @@ void ParticleMainScene::step(float dt)
         if (minFrameRate < 0 || curFrameRate < minFrameRate)
             minFrameRate = curFrameRate;
     }
+    else
+    {
+        // outside of the auto test, show the throughput of the last second
+        kernelsStatTime += dt;
+        if (kernelsStatTime >= 1.0f)
+        {
+            updateKernelsLabel();
+            static_cast<TimedParticleSystemQuad*>(emitter)->resetStat();
+            kernelsStatTime = 0;
+        }
+    }
 }
 
 void ParticleMainScene::createParticleSystem()
@@ -313,7 +425,7 @@ void ParticleMainScene::createParticleSystem()
 //     }
 //     else
     {
-        particleSystem = ParticleSystemQuad::createWithTotalParticles(quantityParticles);
+        particleSystem = TimedParticleSystemQuad::create(quantityParticles);
     }
 
     switch( subtestNumber)
@@ -441,6 +553,15 @@ void ParticleMainScene::updateQuantityLabel()
     }
 }
 
+void ParticleMainScene::updateKernelsLabel()
+{
+    auto kernelsLabel = (Label *) getChildByTag(kTagKernelsLabel);
+    auto emitter = (TimedParticleSystemQuad *) getChildByTag(kTagParticleSystem);
+    char str[64] = {0};
+    sprintf(str, "%s: %.1f particles/ms", kernelsName(), emitter ? emitter->getParticlesPerMillisecond() : 0.0);
+    kernelsLabel->setString(str);
+}
+
 void ParticleMainScene::updateTitle()
 {
     auto titleLabel = (Label *) getChildByTag(kTagTitle);
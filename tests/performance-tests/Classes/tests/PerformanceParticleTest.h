@@ -41,6 +41,7 @@ public:
     void testNCallback(cocos2d::Ref* sender);
     void updateQuantityLabel();
     void updateTitle();
+    void updateKernelsLabel();
     virtual void doTest();
 
     // overrides
@@ -62,6 +63,8 @@ protected:
     float      totalStatTime;
     float      minFrameRate;
     float      maxFrameRate;
+    bool       autoTestScalar;
+    float      kernelsStatTime;
 };
 
 class ParticlePerformTest1 : public ParticleMainScene
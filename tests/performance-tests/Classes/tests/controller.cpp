@@ -56,6 +56,8 @@ public:
         addTest("Callback Tests", []() { return new PerformceCallbackTests(); });
         addTest("Math Tests", []() { return new PerformceMathTests(); });
         addTest("Container Tests", []() { return new PerformceContainerTests(); });
+        addTest("ObjLoader Tests", []() { return new PerformceObjLoaderTests(); });
+        addTest("Culling Tests", []() { return new PerformceCullingTests(); });
     }
 };
 
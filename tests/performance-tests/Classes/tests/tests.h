@@ -38,5 +38,7 @@
 #include "PerformanceCallbackTest.h"
 #include "PerformanceMathTest.h"
 #include "PerformanceContainerTest.h"
+#include "PerformanceObjLoaderTest.h"
+#include "PerformanceCullingTest.h"
 
 #endif
@@ -0,0 +1,182 @@
+#!/usr/bin/python
+# pack_assets.py
+# Builds a memory-mappable asset pack (.ccpk) loaded by cocos2d::AssetPack / FileUtils::mountAssetPack.
+#
+# usage: pack_assets.py [-h] [--align N] [--lz4 EXT] [--lz4-all] -o OUTPUT DIR
+#
+# Entry names are the paths relative to DIR, with '/' separators.
+
+import argparse
+import os
+import struct
+import sys
+
+MAGIC = b'CCPK'
+VERSION = 1
+HEADER_FORMAT = '<4sIIIQQ'
+INDEX_FORMAT = '<QIIIIHBBI'
+
+COMPRESSION_NONE = 0
+COMPRESSION_LZ4 = 1
+
+# LZ4 block format constants
+MIN_MATCH = 4
+LAST_LITERALS = 5
+MF_LIMIT = 12
+MAX_OFFSET = 65535
+
+
+#must match hashName() in cocos/platform/CCAssetPack.cpp
+def fnv1a(name):
+    h = 2166136261
+    for b in bytearray(name):
+        h ^= b
+        h = (h * 16777619) & 0xffffffff
+    return h
+
+
+def write_length(out, length):
+    while length >= 255:
+        out.append(255)
+        length -= 255
+    out.append(length)
+
+
+def write_sequence(out, literals, offset, match_length):
+    lit_len = len(literals)
+    token = min(lit_len, 15) << 4
+    if match_length:
+        token |= min(match_length - MIN_MATCH, 15)
+    out.append(token)
+    if lit_len >= 15:
+        write_length(out, lit_len - 15)
+    out.extend(literals)
+    if match_length:
+        out.extend(struct.pack('<H', offset))
+        if match_length - MIN_MATCH >= 15:
+            write_length(out, match_length - MIN_MATCH - 15)
+
+
+#greedy LZ4 block compressor, good enough for an offline tool
+def lz4_compress(data):
+    out = bytearray()
+    n = len(data)
+    anchor = 0
+    i = 0
+    table = {}
+    match_limit = n - LAST_LITERALS
+    while i < n - MF_LIMIT:
+        key = data[i:i + MIN_MATCH]
+        candidate = table.get(key)
+        table[key] = i
+        if candidate is None or i - candidate > MAX_OFFSET:
+            i += 1
+            continue
+
+        length = MIN_MATCH
+        while i + length < match_limit and data[candidate + length] == data[i + length]:
+            length += 1
+
+        write_sequence(out, data[anchor:i], i - candidate, length)
+        i += length
+        anchor = i
+
+    write_sequence(out, data[anchor:], 0, 0)
+    return bytes(out)
+
+
+def collect_files(root):
+    files = []
+    for dirpath, dirnames, filenames in os.walk(root):
+        dirnames.sort()
+        for filename in sorted(filenames):
+            path = os.path.join(dirpath, filename)
+            name = os.path.relpath(path, root).replace(os.sep, '/')
+            files.append((name, path))
+    return files
+
+
+def build_pack(root, output, alignment, lz4_exts, lz4_all):
+    entries = []
+    payload = bytearray()
+    header_size = struct.calcsize(HEADER_FORMAT)
+
+    for name, path in collect_files(root):
+        with open(path, 'rb') as f:
+            data = f.read()
+
+        compression = COMPRESSION_NONE
+        stored = data
+        ext = os.path.splitext(name)[1].lower()
+        if data and (lz4_all or ext in lz4_exts):
+            compressed = lz4_compress(data)
+            # keep the entry mappable if compression doesn't pay off
+            if len(compressed) < len(data):
+                compression = COMPRESSION_LZ4
+                stored = compressed
+
+        offset = header_size + len(payload)
+        padding = (alignment - offset % alignment) % alignment
+        payload.extend(b'\0' * padding)
+        offset += padding
+        payload.extend(stored)
+
+        encoded_name = name.encode('utf-8')
+        entries.append({
+            'name': encoded_name,
+            'hash': fnv1a(encoded_name),
+            'offset': offset,
+            'stored_size': len(stored),
+            'size': len(data),
+            'compression': compression,
+        })
+
+    entries.sort(key=lambda e: (e['hash'], e['name']))
+
+    index_offset = header_size + len(payload)
+    index_offset += (8 - index_offset % 8) % 8
+    names_offset = index_offset + len(entries) * struct.calcsize(INDEX_FORMAT)
+
+    alignment_log2 = alignment.bit_length() - 1
+    index = bytearray()
+    names = bytearray()
+    for e in entries:
+        index.extend(struct.pack(INDEX_FORMAT, e['offset'], e['stored_size'], e['size'], len(names),
+                                 e['hash'], len(e['name']), e['compression'], alignment_log2, 0))
+        names.extend(e['name'])
+
+    with open(output, 'wb') as f:
+        f.write(struct.pack(HEADER_FORMAT, MAGIC, VERSION, len(entries), 0, index_offset, names_offset))
+        f.write(payload)
+        f.write(b'\0' * (index_offset - header_size - len(payload)))
+        f.write(index)
+        f.write(names)
+
+    stored = sum(e['stored_size'] for e in entries)
+    original = sum(e['size'] for e in entries)
+    print('%s: %d entries, %d bytes stored for %d bytes of assets' % (output, len(entries), stored, original))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Builds a memory-mappable cocos2d-x asset pack.')
+    parser.add_argument('root', metavar='DIR', help='directory to pack')
+    parser.add_argument('-o', '--output', required=True, help='pack file to write')
+    parser.add_argument('--align', type=int, default=16, help='alignment of every entry, power of two (default: 16)')
+    parser.add_argument('--lz4', action='append', default=[], metavar='EXT',
+                        help='compress entries with this extension (e.g. .plist), can be repeated')
+    parser.add_argument('--lz4-all', action='store_true', help='compress every entry')
+    args = parser.parse_args()
+
+    if args.align <= 0 or args.align & (args.align - 1):
+        print('--align must be a power of two')
+        sys.exit(1)
+    if not os.path.isdir(args.root):
+        print(args.root + ' is not a directory')
+        sys.exit(1)
+
+    lz4_exts = set(e.lower() if e.startswith('.') else '.' + e.lower() for e in args.lz4)
+    build_pack(args.root, args.output, args.align, lz4_exts, args.lz4_all)
+
+
+if __name__ == '__main__':
+    main()
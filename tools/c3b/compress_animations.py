@@ -0,0 +1,310 @@
+#!/usr/bin/python
+# compress_animations.py
+# Compresses the skeletal animations of .c3b files for cocos2d-x:
+#  - the key frames that the interpolation of their neighbors reproduces within an error bound are removed,
+#    separately for the rotation, scale and translation of every bone;
+#  - the remaining values are quantized to 16 bits over the range of each component. Half a quantization step
+#    is taken from the error bound of the reduction, tracks whose range is too large for 16 bits to meet the
+#    bound keep all their keys.
+# The engine reads them in Bundle3D::loadAnimationDataBinary() and the curves keep the values quantized, so that the
+# animations take less memory in the files and once loaded. The rest of the file is copied as is.
+#
+# usage: compress_animations.py [-h] [-t ERROR] [-r ERROR] [-s ERROR] (-o OUTPUT | -d DIRECTORY) FILE [FILE ...]
+
+import argparse
+import math
+import os
+import struct
+import sys
+
+# Must match cocos/3d/CCBundle3D.cpp
+BUNDLE_TYPE_ANIMATIONS = 3
+BUNDLE_TYPE_ANIMATIONS_COMPRESSED = 6
+
+
+class Reader(object):
+    def __init__(self, data, position=0):
+        self.data = data
+        self.position = position
+
+    def read(self, fmt):
+        values = struct.unpack_from('<' + fmt, self.data, self.position)
+        self.position += struct.calcsize('<' + fmt)
+        return values
+
+    def read_uint(self):
+        return self.read('I')[0]
+
+    def read_string(self):
+        length = self.read_uint()
+        value = self.data[self.position:self.position + length]
+        self.position += length
+        return value
+
+
+def pack_string(value):
+    return struct.pack('<I', len(value)) + value
+
+
+# ---------------------------------------------------------------------------------------------
+# c3b layout, same as Bundle3D::loadBinary() and Bundle3D::loadAnimationDataBinary()
+# ---------------------------------------------------------------------------------------------
+
+def read_header(data):
+    if data[:4] != b'C3B\0':
+        raise ValueError('not a c3b file')
+    version = (bytearray(data[4:6])[0], bytearray(data[4:6])[1])
+    reader = Reader(data, 6)
+    references = []
+    for i in range(reader.read_uint()):
+        ref_id = reader.read_string()
+        ref_type, offset = reader.read('II')
+        references.append([ref_id, ref_type, offset])
+    return version, references, reader.position
+
+
+def read_animations(data, offset, version):
+    """returns the animations of a section and the end of the section"""
+    reader = Reader(data, offset)
+    flags = version not in ((0, 1), (0, 2), (0, 3))
+    count = reader.read_uint() if version in ((0, 3), (0, 4)) else 1
+
+    animations = []
+    for k in range(count):
+        anim_id = reader.read_string()
+        total_time = reader.read('f')[0]
+        bones = []
+        for i in range(reader.read_uint()):
+            name = reader.read_string()
+            rotations, scales, translations = [], [], []
+            for j in range(reader.read_uint()):
+                time = reader.read('f')[0]
+                flag = reader.read('B')[0] if flags else 0x07
+                if flag & 0x01:
+                    rotations.append((time, reader.read('4f')))
+                if flag & 0x02:
+                    scales.append((time, reader.read('3f')))
+                if flag & 0x04:
+                    translations.append((time, reader.read('3f')))
+            bones.append((name, rotations, scales, translations))
+        animations.append((anim_id, total_time, bones))
+    return animations, reader.position
+
+
+# ---------------------------------------------------------------------------------------------
+# key frame reduction, the error of a removed key is measured against the interpolation the engine
+# uses with Animate3DQuality::QUALITY_HIGH: linear for vectors, slerp for quaternions
+# ---------------------------------------------------------------------------------------------
+
+def lerp(a, b, t):
+    return [x + (y - x) * t for x, y in zip(a, b)]
+
+
+def normalize(q):
+    length = math.sqrt(sum(x * x for x in q))
+    return [x / length for x in q] if length > 0 else list(q)
+
+
+def slerp(a, b, t):
+    # same as Quaternion::slerp, taking the shortest path
+    a, b = normalize(a), normalize(b)
+    cos = sum(x * y for x, y in zip(a, b))
+    if cos < 0:
+        b = [-x for x in b]
+        cos = -cos
+    if cos > 0.9995:
+        return normalize(lerp(a, b, t))
+    angle = math.acos(min(cos, 1.0))
+    sin = math.sin(angle)
+    wa = math.sin((1 - t) * angle) / sin
+    wb = math.sin(t * angle) / sin
+    return [x * wa + y * wb for x, y in zip(a, b)]
+
+
+def vector_error(a, b):
+    return math.sqrt(sum((x - y) ** 2 for x, y in zip(a, b)))
+
+
+def rotation_error(a, b):
+    # angle between the rotations
+    cos = abs(sum(x * y for x, y in zip(normalize(a), normalize(b))))
+    return 2 * math.acos(min(cos, 1.0))
+
+
+def reduce_keys(keys, max_error, interpolate, error):
+    if len(keys) <= 2:
+        return keys
+
+    # constant tracks keep a single key
+    if all(error(keys[0][1], value) <= max_error for time, value in keys):
+        return keys[:1]
+
+    def fits(start, end):
+        t0, v0 = keys[start]
+        t1, v1 = keys[end]
+        for time, value in keys[start + 1:end]:
+            t = (time - t0) / (t1 - t0) if t1 > t0 else 0.0
+            if error(interpolate(v0, v1, t), value) > max_error:
+                return False
+        return True
+
+    # extends every segment as long as the keys it skips are within the error bound
+    kept = [keys[0]]
+    start = 0
+    end = 2
+    while end < len(keys):
+        if not fits(start, end):
+            start = end - 1
+            kept.append(keys[start])
+        end += 1
+    kept.append(keys[-1])
+    return kept
+
+
+# ---------------------------------------------------------------------------------------------
+# compressed section, must match Bundle3D::loadCompressedAnimationDataBinary()
+# ---------------------------------------------------------------------------------------------
+
+def pack_track(keys, component_size):
+    data = struct.pack('<I', len(keys))
+    if not keys:
+        return data
+    data += struct.pack('<%df' % len(keys), *[time for time, value in keys])
+
+    minimum = [min(value[i] for time, value in keys) for i in range(component_size)]
+    maximum = [max(value[i] for time, value in keys) for i in range(component_size)]
+    step = [(hi - lo) / 65535.0 for lo, hi in zip(minimum, maximum)]
+    quantized = []
+    for time, value in keys:
+        for i in range(component_size):
+            q = int((value[i] - minimum[i]) / step[i] + 0.5) if step[i] > 0 else 0
+            quantized.append(max(0, min(q, 65535)))
+
+    data += struct.pack('<%df' % component_size, *minimum)
+    data += struct.pack('<%df' % component_size, *step)
+    data += struct.pack('<I', len(quantized)) + struct.pack('<%dH' % len(quantized), *quantized)
+    return data
+
+
+def quantization_error(keys, component_size, error):
+    # half a quantization step on every component, taken from the error bound of the reduction
+    if not keys:
+        return 0.0
+    half_step = [(max(value[i] for time, value in keys) - min(value[i] for time, value in keys)) / 65535.0 / 2
+                 for i in range(component_size)]
+    return error([0.0] * component_size, half_step) if component_size == 3 else 2 * math.sqrt(sum(x * x for x in half_step))
+
+
+def pack_animations(animations, errors):
+    data = struct.pack('<I', len(animations))
+    keys_before = keys_after = 0
+    for anim_id, total_time, bones in animations:
+        data += pack_string(anim_id) + struct.pack('<fI', total_time, len(bones))
+        for name, rotations, scales, translations in bones:
+            def reduce(keys, max_error, component_size, interpolate, error):
+                max_error = max(0.0, max_error - quantization_error(keys, component_size, vector_error))
+                return reduce_keys(keys, max_error, interpolate, error)
+
+            reduced = (reduce(rotations, errors.rotation, 4, slerp, rotation_error),
+                       reduce(scales, errors.scale, 3, lerp, vector_error),
+                       reduce(translations, errors.translation, 3, lerp, vector_error))
+            data += pack_string(name)
+            data += pack_track(reduced[0], 4) + pack_track(reduced[1], 3) + pack_track(reduced[2], 3)
+            keys_before += len(rotations) + len(scales) + len(translations)
+            keys_after += sum(len(keys) for keys in reduced)
+    return data, keys_before, keys_after
+
+
+def compress_file(path, output_path, errors):
+    with open(path, 'rb') as f:
+        data = f.read()
+
+    try:
+        version, references, table_end = read_header(data)
+    except (ValueError, struct.error) as e:
+        print('%s: %s' % (path, e))
+        return False
+
+    # the sections are replaced in place, the offsets after them move
+    replacements = []
+    keys_before = keys_after = 0
+    for ref in references:
+        if ref[1] != BUNDLE_TYPE_ANIMATIONS:
+            continue
+        try:
+            animations, end = read_animations(data, ref[2], version)
+        except struct.error:
+            print('%s: can\'t read the animations of %s' % (path, ref[0]))
+            return False
+        section, before, after = pack_animations(animations, errors)
+        replacements.append((ref[2], end, section))
+        keys_before += before
+        keys_after += after
+        ref[1] = BUNDLE_TYPE_ANIMATIONS_COMPRESSED
+
+    if not replacements:
+        print('%s: no animation to compress' % path)
+        return False
+
+    replacements.sort()
+    output = bytearray(data[:table_end])
+    position = table_end
+    for start, end, section in replacements:
+        output += data[position:start]
+        output += section
+        position = end
+    output += data[position:]
+
+    def moved(offset):
+        shift = 0
+        for start, end, section in replacements:
+            if end <= offset:
+                shift += len(section) - (end - start)
+        return offset + shift
+
+    # same size as the original table, only the types and offsets change
+    table = bytearray(data[:6]) + struct.pack('<I', len(references))
+    for ref_id, ref_type, offset in references:
+        table += pack_string(ref_id) + struct.pack('<II', ref_type, moved(offset))
+    output[:table_end] = table
+
+    with open(output_path, 'wb') as f:
+        f.write(output)
+
+    print('%s: %d -> %d key frames, %d -> %d bytes' % (output_path, keys_before, keys_after, len(data), len(output)))
+    return True
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compresses the skeletal animations of c3b files.')
+    parser.add_argument('files', metavar='FILE', nargs='+', help='.c3b file to compress')
+    parser.add_argument('-t', '--translation-error', dest='translation', type=float, default=0.001,
+                        help='maximum translation error of a removed key frame, in model units (default 0.001)')
+    parser.add_argument('-r', '--rotation-error', dest='rotation', type=float, default=0.001,
+                        help='maximum rotation error of a removed key frame, in radians (default 0.001)')
+    parser.add_argument('-s', '--scale-error', dest='scale', type=float, default=0.001,
+                        help='maximum scale error of a removed key frame (default 0.001)')
+    group = parser.add_mutually_exclusive_group(required=True)
+    group.add_argument('-o', '--output', help='output file, only when compressing a single file')
+    group.add_argument('-d', '--directory', help='output directory, the files keep their names')
+    args = parser.parse_args()
+
+    if args.output and len(args.files) > 1:
+        print('-o can only be used with a single file')
+        sys.exit(1)
+    if args.directory and not os.path.isdir(args.directory):
+        os.makedirs(args.directory)
+
+    succeeded = True
+    for path in args.files:
+        output = args.output or os.path.join(args.directory, os.path.basename(path))
+        if os.path.abspath(output) == os.path.abspath(path):
+            print('%s: the output would replace the input' % path)
+            succeeded = False
+            continue
+        succeeded = compress_file(path, output, args) and succeeded
+    sys.exit(0 if succeeded else 1)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,593 @@
+#!/usr/bin/python
+# compile_particles.py
+# Converts particle definitions to binary files loaded by cocos2d-x without parsing:
+#  - particle plists (Particle Designer) to binary particle definitions, read by
+#    cocos2d::ParticleDefinition / ParticleSystem::initWithFile(), with the embedded image
+#    stored as is instead of base64 encoded and gzipped;
+#  - Particle Universe scripts (.pu) and materials (.material) to compiled scripts holding
+#    the abstract syntax tree, read by cocos2d::PUScriptCompiler.
+#
+# usage: compile_particles.py [-h] (-o OUTPUT | -d DIRECTORY) FILE [FILE ...]
+#
+# The engine recognizes binary files by their content, so the converted files keep their names
+# and can replace the original ones, e.g. in the resources of a release build.
+
+import argparse
+import base64
+import gzip
+import io
+import os
+import plistlib
+import re
+import struct
+import sys
+import zlib
+
+# Binary particle definition, must match BinaryHeader in cocos/2d/CCParticleDefinition.cpp
+PARTICLE_MAGIC = b'CCPD'
+PARTICLE_VERSION = 1
+PARTICLE_HEADER_FORMAT = '<4sIiiIIiI47f6I'
+
+# Compiled Particle Universe script, must match BinaryHeader and BinaryNode in
+# extensions/Particle3D/PU/CCPUScriptCompiler.cpp
+SCRIPT_MAGIC = b'CCPU'
+SCRIPT_VERSION = 1
+SCRIPT_HEADER_FORMAT = '<4sIIIIIII'
+SCRIPT_NODE_FORMAT = '<8I'
+
+# PUAbstractNodeType
+ANT_ATOM = 1
+ANT_OBJECT = 2
+ANT_PROPERTY = 3
+
+
+class StringTable(object):
+    def __init__(self):
+        self.data = bytearray()
+        self.offsets = {}
+
+    def add(self, value):
+        if value not in self.offsets:
+            self.offsets[value] = len(self.data)
+            self.data.extend(value)
+        return self.offsets[value], len(value)
+
+
+def read_plist(path):
+    with open(path, 'rb') as f:
+        if hasattr(plistlib, 'load'):
+            return plistlib.load(f)
+        return plistlib.readPlist(f)
+
+
+def to_bytes(value):
+    if isinstance(value, bytes):
+        return value
+    return value.encode('utf-8')
+
+
+# ---------------------------------------------------------------------------------------------
+# particle plists, values read the way cocos2d::Value::asFloat(), asInt() and asBool() do
+# ---------------------------------------------------------------------------------------------
+
+NUMBER_PREFIX = re.compile(r'\s*[-+]?(\d+\.?\d*|\.\d+)([eE][-+]?\d+)?')
+INTEGER_PREFIX = re.compile(r'\s*[-+]?\d+')
+
+
+def as_float(value):
+    if value is None:
+        return 0.0
+    if isinstance(value, bool):
+        return 1.0 if value else 0.0
+    if isinstance(value, (int, float)):
+        return float(value)
+    match = NUMBER_PREFIX.match(value)
+    return float(match.group(0)) if match else 0.0
+
+
+def as_int(value):
+    if value is None:
+        return 0
+    if isinstance(value, bool):
+        return 1 if value else 0
+    if isinstance(value, (int, float)):
+        return int(value)
+    match = INTEGER_PREFIX.match(value)
+    return int(match.group(0)) if match else 0
+
+
+def as_bool(value):
+    if value is None:
+        return False
+    if isinstance(value, (bool, int, float)):
+        return value != 0
+    return value not in ('0', 'false')
+
+
+def as_string(value):
+    if value is None:
+        return ''
+    if isinstance(value, bool):
+        return 'true' if value else 'false'
+    return '%s' % value
+
+
+def decode_image(data):
+    if not data:
+        return b''
+    compressed = base64.b64decode(data)
+    try:
+        return gzip.GzipFile(fileobj=io.BytesIO(compressed)).read()
+    except (IOError, OSError):
+        # ZipUtils::inflateMemory also reads zlib streams
+        return zlib.decompress(compressed)
+
+
+# same interpretation as ParticleDefinition::initWithDictionary()
+def compile_particle(path, output_path):
+    d = read_plist(path)
+    get = d.get
+
+    config_name = as_string(get('configName'))
+    designer2 = config_name != ''
+    blend_src = int(as_float(get('blendFuncSource'))) if designer2 else as_int(get('blendFuncSource'))
+
+    mode = as_int(get('emitterType'))
+    gravity = [0.0] * 8
+    rotation_is_dir = 0
+    radius = [0.0] * 6
+    if mode == 0:
+        gravity = [as_float(get('gravityx')), as_float(get('gravityy')),
+                   as_float(get('speed')), as_float(get('speedVariance')),
+                   as_float(get('radialAcceleration')), as_float(get('radialAccelVariance')),
+                   as_float(get('tangentialAcceleration')), as_float(get('tangentialAccelVariance'))]
+        rotation_is_dir = 1 if as_bool(get('rotationIsDir')) else 0
+    elif mode == 1:
+        number = as_int if designer2 else as_float
+        radius = [float(number(get('maxRadius'))), as_float(get('maxRadiusVariance')),
+                  float(number(get('minRadius'))), as_float(get('minRadiusVariance')),
+                  float(number(get('rotatePerSecond'))), as_float(get('rotatePerSecondVariance'))]
+    else:
+        print('%s: invalid emitterType %d' % (path, mode))
+        return False
+
+    def color(prefix):
+        return [as_float(get(prefix + c)) for c in ('Red', 'Green', 'Blue', 'Alpha')]
+
+    floats = [as_float(get('angle')), as_float(get('angleVariance')), as_float(get('duration'))]
+    floats += color('startColor') + color('startColorVariance') + color('finishColor') + color('finishColorVariance')
+    floats += [as_float(get('startParticleSize')), as_float(get('startParticleSizeVariance')),
+               as_float(get('finishParticleSize')), as_float(get('finishParticleSizeVariance'))]
+    floats += [as_float(get('sourcePositionx')), as_float(get('sourcePositiony')),
+               as_float(get('sourcePositionVariancex')), as_float(get('sourcePositionVariancey'))]
+    floats += [as_float(get('rotationStart')), as_float(get('rotationStartVariance')),
+               as_float(get('rotationEnd')), as_float(get('rotationEndVariance'))]
+    floats += gravity + radius
+    floats += [as_float(get('particleLifespan')), as_float(get('particleLifespanVariance'))]
+
+    image = b''
+    if 'textureImageData' in d:
+        try:
+            image = decode_image(as_string(d['textureImageData']))
+        except Exception as e:
+            print('%s: can\'t decode textureImageData: %s' % (path, e))
+            return False
+
+    y_flipped = as_int(d['yCoordFlipped']) if 'yCoordFlipped' in d else 1
+
+    strings = StringTable()
+    header_size = struct.calcsize(PARTICLE_HEADER_FORMAT)
+    config_offset, config_length = strings.add(to_bytes(config_name))
+    texture_offset, texture_length = strings.add(to_bytes(as_string(get('textureFileName'))))
+    image_offset = header_size + len(strings.data)
+
+    header = struct.pack(PARTICLE_HEADER_FORMAT, PARTICLE_MAGIC, PARTICLE_VERSION,
+                         as_int(get('maxParticles')), mode, blend_src & 0xffffffff,
+                         as_int(get('blendFuncDestination')) & 0xffffffff, y_flipped, rotation_is_dir,
+                         *(floats + [header_size + config_offset, config_length,
+                                     header_size + texture_offset, texture_length,
+                                     image_offset, len(image)]))
+
+    with open(output_path, 'wb') as f:
+        f.write(header)
+        f.write(strings.data)
+        f.write(image)
+
+    print('%s: particle definition, %d bytes of embedded image' % (output_path, len(image)))
+    return True
+
+
+# ---------------------------------------------------------------------------------------------
+# Particle Universe scripts, same lexer, parser and abstract tree as PUScriptLexer,
+# PUScriptParser and PUScriptCompiler::convertToAST()
+# ---------------------------------------------------------------------------------------------
+
+TID_LBRACKET, TID_RBRACKET, TID_COLON, TID_VARIABLE, TID_WORD, TID_QUOTE, TID_NEWLINE = range(7)
+CNT_VARIABLE, CNT_VARIABLE_ASSIGN, CNT_WORD, CNT_IMPORT, CNT_QUOTE, CNT_LBRACE, CNT_RBRACE, CNT_COLON = range(8)
+
+
+class Token(object):
+    def __init__(self, lexeme, line):
+        self.lexeme = lexeme
+        self.line = line
+        self.type = TID_WORD
+
+
+def is_newline(c):
+    return c == '\n' or c == '\r'
+
+
+def is_whitespace(c):
+    return c == ' ' or c == '\r' or c == '\t'
+
+
+def set_token(lexeme, line, tokens):
+    token = Token(lexeme, line)
+    if len(lexeme) == 1 and is_newline(lexeme):
+        token.type = TID_NEWLINE
+        if tokens and tokens[-1].type == TID_NEWLINE:
+            return
+    elif lexeme == '{':
+        token.type = TID_LBRACKET
+    elif lexeme == '}':
+        token.type = TID_RBRACKET
+    elif lexeme == ':':
+        token.type = TID_COLON
+    elif lexeme[:1] == '$':
+        token.type = TID_VARIABLE
+    elif len(lexeme) >= 2 and lexeme[0] == '"' and lexeme[-1] == '"':
+        token.type = TID_QUOTE
+    else:
+        token.type = TID_WORD
+    tokens.append(token)
+
+
+def tokenize(text):
+    READY, COMMENT, MULTICOMMENT, WORD, QUOTE, VAR, POSSIBLECOMMENT = range(7)
+    tokens = []
+    lexeme = ''
+    line = 1
+    state = READY
+    c = '\0'
+    for ch in text:
+        lastc = c
+        c = ch
+
+        if state == READY:
+            if c == '/' and lastc == '/':
+                lexeme = ''
+                state = COMMENT
+            elif c == '*' and lastc == '/':
+                lexeme = ''
+                state = MULTICOMMENT
+            elif c == '"':
+                lexeme = c
+                state = QUOTE
+            elif c == '$':
+                lexeme = c
+                state = VAR
+            elif is_newline(c):
+                lexeme = c
+                set_token(lexeme, line, tokens)
+            elif not is_whitespace(c):
+                lexeme = c
+                state = POSSIBLECOMMENT if c == '/' else WORD
+        elif state == COMMENT:
+            if is_newline(c):
+                state = READY
+        elif state == MULTICOMMENT:
+            if c == '/' and lastc == '*':
+                state = READY
+        elif state == QUOTE:
+            if c != '\\':
+                if c == '"' and lastc == '\\':
+                    lexeme += c
+                elif c == '"':
+                    lexeme += c
+                    set_token(lexeme, line, tokens)
+                    state = READY
+                elif lastc == '\\':
+                    lexeme += '\\' + c
+                else:
+                    lexeme += c
+        else:
+            if state == POSSIBLECOMMENT:
+                if c == '/' and lastc == '/':
+                    lexeme = ''
+                    state = COMMENT
+                elif c == '*' and lastc == '/':
+                    lexeme = ''
+                    state = MULTICOMMENT
+                else:
+                    state = WORD
+            # WORD and VAR
+            if state in (WORD, VAR):
+                if is_newline(c):
+                    set_token(lexeme, line, tokens)
+                    lexeme = c
+                    set_token(lexeme, line, tokens)
+                    state = READY
+                elif is_whitespace(c):
+                    set_token(lexeme, line, tokens)
+                    state = READY
+                elif c in '{}:':
+                    set_token(lexeme, line, tokens)
+                    lexeme = c
+                    set_token(lexeme, line, tokens)
+                    state = READY
+                else:
+                    lexeme += c
+
+        if c == '\r' or (c == '\n' and lastc != '\r'):
+            line += 1
+
+    if state in (WORD, VAR) and lexeme:
+        set_token(lexeme, line, tokens)
+    elif state == QUOTE:
+        raise ValueError('no matching " found')
+    return tokens
+
+
+class ConcreteNode(object):
+    def __init__(self, token, line, node_type, parent=None):
+        self.token = token
+        self.line = line
+        self.type = node_type
+        self.parent = parent
+        self.children = []
+
+
+def unquote(lexeme, length):
+    # std::string::substr(1, length - 2)
+    return lexeme[1:1 + max(length - 2, 0)]
+
+
+def token_node(token, use_length=None):
+    node_type = CNT_WORD if token.type == TID_WORD else CNT_QUOTE
+    if node_type == CNT_QUOTE:
+        value = unquote(token.lexeme, len(token.lexeme) if use_length is None else use_length)
+    else:
+        value = token.lexeme
+    return ConcreteNode(value, token.line, node_type)
+
+
+def parse(tokens):
+    READY, OBJECT = range(2)
+    nodes = []
+    parent = [None]
+    end = len(tokens)
+
+    def skip_newlines(i):
+        while i != end and tokens[i].type == TID_NEWLINE:
+            i += 1
+        return i
+
+    def insert(node):
+        node.parent = parent[0]
+        if parent[0]:
+            parent[0].children.append(node)
+        else:
+            nodes.append(node)
+
+    def expect(i, types, message):
+        if i >= end or tokens[i].type not in types:
+            raise ValueError('%s at line %d' % (message, tokens[min(i, end - 1)].line))
+
+    state = READY
+    i = 0
+    while i < end:
+        token = tokens[i]
+        if state == READY:
+            if token.type == TID_WORD:
+                if token.lexeme in ('import', 'set'):
+                    assign = token.lexeme == 'set'
+                    node = ConcreteNode(token.lexeme, token.line, CNT_VARIABLE_ASSIGN if assign else CNT_IMPORT)
+                    i += 1
+                    if assign:
+                        expect(i, (TID_VARIABLE,), 'expected variable')
+                        target = ConcreteNode(tokens[i].lexeme, tokens[i].line, CNT_VARIABLE, node)
+                    else:
+                        expect(i, (TID_WORD, TID_QUOTE), 'expected import target')
+                        # the import target is unquoted with the length of "import"
+                        target = token_node(tokens[i], len(token.lexeme))
+                        target.parent = node
+                    node.children.append(target)
+
+                    # the value of a variable is next, the source of an import is after "from"
+                    i += 1 if assign else 2
+                    expect(i, (TID_WORD, TID_QUOTE), 'expected variable value' if assign else 'expected import source')
+                    source = token_node(tokens[i])
+                    source.parent = node
+                    node.children.append(source)
+                    insert(node)
+                else:
+                    node = ConcreteNode(token.lexeme, token.line, CNT_WORD)
+                    insert(node)
+                    parent[0] = node
+                    state = OBJECT
+            elif token.type == TID_RBRACKET:
+                if parent[0]:
+                    parent[0] = parent[0].parent
+                insert(ConcreteNode(token.lexeme, token.line, CNT_RBRACE))
+                if parent[0]:
+                    parent[0] = parent[0].parent
+        else:
+            if token.type == TID_NEWLINE:
+                following = skip_newlines(i)
+                if following == end or tokens[following].type != TID_LBRACKET:
+                    if parent[0]:
+                        parent[0] = parent[0].parent
+                    state = READY
+            elif token.type == TID_COLON:
+                node = ConcreteNode(token.lexeme, token.line, CNT_COLON)
+                j = skip_newlines(i + 1)
+                expect(j, (TID_WORD, TID_QUOTE), 'expected object identifier')
+                while j != end and tokens[j].type in (TID_WORD, TID_QUOTE):
+                    # the base names keep their quotes
+                    base = ConcreteNode(tokens[j].lexeme, tokens[j].line,
+                                        CNT_WORD if tokens[j].type == TID_WORD else CNT_QUOTE, node)
+                    node.children.append(base)
+                    j += 1
+                i = j - 1
+                insert(node)
+            elif token.type == TID_LBRACKET:
+                node = ConcreteNode(token.lexeme, token.line, CNT_LBRACE)
+                insert(node)
+                parent[0] = node
+                state = READY
+            elif token.type == TID_RBRACKET:
+                if parent[0]:
+                    parent[0] = parent[0].parent
+                if parent[0] and parent[0].type == CNT_LBRACE and parent[0].parent:
+                    parent[0] = parent[0].parent
+                insert(ConcreteNode(token.lexeme, token.line, CNT_RBRACE))
+                if parent[0]:
+                    parent[0] = parent[0].parent
+                state = READY
+            elif token.type == TID_VARIABLE:
+                insert(ConcreteNode(token.lexeme, token.line, CNT_VARIABLE))
+            elif token.type == TID_QUOTE:
+                insert(ConcreteNode(unquote(token.lexeme, len(token.lexeme)), token.line, CNT_QUOTE))
+            elif token.type == TID_WORD:
+                insert(ConcreteNode(token.lexeme, token.line, CNT_WORD))
+        i += 1
+    return nodes
+
+
+class AbstractNode(object):
+    def __init__(self, node_type, line, value, name=''):
+        self.type = node_type
+        self.line = line
+        self.value = value
+        self.name = name
+        self.values = []
+        self.children = []
+
+
+def convert_to_ast(nodes):
+    roots = []
+    current = [None]
+
+    def visit_list(concrete_nodes):
+        for node in concrete_nodes:
+            visit(node)
+
+    def visit(node):
+        if node.children:
+            last = node.children[-1]
+            before_last = node.children[-2] if len(node.children) >= 2 else None
+            if last.type == CNT_RBRACE and before_last and before_last.type == CNT_LBRACE:
+                impl = AbstractNode(ANT_OBJECT, node.line, node.token)
+                sequence = [node] + node.children
+                k = 1
+                if k < len(sequence) and sequence[k].type == CNT_WORD:
+                    impl.name = sequence[k].token
+                    k += 1
+                while k < len(sequence) and sequence[k].type != CNT_LBRACE:
+                    impl.values.append(AbstractNode(ANT_ATOM, sequence[k].line, sequence[k].token))
+                    k += 1
+                saved = current[0]
+                current[0] = impl
+                visit_list(before_last.children)
+                current[0] = saved
+            else:
+                impl = AbstractNode(ANT_PROPERTY, node.line, node.token)
+                saved = current[0]
+                current[0] = impl
+                visit_list(node.children)
+                current[0] = saved
+        else:
+            impl = AbstractNode(ANT_ATOM, node.line, node.token)
+
+        if current[0]:
+            if current[0].type == ANT_PROPERTY:
+                current[0].values.append(impl)
+            else:
+                current[0].children.append(impl)
+        else:
+            roots.append(impl)
+
+    visit_list(nodes)
+    return roots
+
+
+def compile_script(path, output_path):
+    with open(path, 'rb') as f:
+        # one character per byte, as the engine lexer reads it
+        text = f.read().decode('latin-1')
+
+    try:
+        roots = convert_to_ast(parse(tokenize(text)))
+    except ValueError as e:
+        print('%s: %s' % (path, e))
+        return False
+    if not roots:
+        print('%s: nothing to compile' % path)
+        return False
+
+    strings = StringTable()
+    records = bytearray()
+    count = [0]
+
+    def write(node):
+        value_offset, value_length = strings.add(node.value.encode('latin-1'))
+        name_offset, name_length = strings.add(node.name.encode('latin-1'))
+        records.extend(struct.pack(SCRIPT_NODE_FORMAT, node.type, node.line, value_offset, value_length,
+                                   name_offset, name_length, len(node.values), len(node.children)))
+        count[0] += 1
+        for child in node.values:
+            write(child)
+        for child in node.children:
+            write(child)
+
+    for root in roots:
+        write(root)
+
+    nodes_offset = struct.calcsize(SCRIPT_HEADER_FORMAT)
+    strings_offset = nodes_offset + len(records)
+    header = struct.pack(SCRIPT_HEADER_FORMAT, SCRIPT_MAGIC, SCRIPT_VERSION, count[0], len(roots),
+                         nodes_offset, strings_offset, len(strings.data), 0)
+
+    with open(output_path, 'wb') as f:
+        f.write(header)
+        f.write(records)
+        f.write(strings.data)
+
+    print('%s: compiled script, %d nodes' % (output_path, count[0]))
+    return True
+
+
+def compile_file(path, output_path):
+    if os.path.splitext(path)[1].lower() == '.plist':
+        return compile_particle(path, output_path)
+    return compile_script(path, output_path)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Converts particle plists and Particle Universe scripts '
+                                                 'to cocos2d-x binary particle files.')
+    parser.add_argument('files', metavar='FILE', nargs='+', help='.plist, .pu or .material file to convert')
+    group = parser.add_mutually_exclusive_group(required=True)
+    group.add_argument('-o', '--output', help='output file, only when converting a single file')
+    group.add_argument('-d', '--directory', help='output directory, the files keep their names')
+    args = parser.parse_args()
+
+    if args.output and len(args.files) > 1:
+        print('-o can only be used with a single file')
+        sys.exit(1)
+    if args.directory and not os.path.isdir(args.directory):
+        os.makedirs(args.directory)
+
+    succeeded = True
+    for path in args.files:
+        output = args.output or os.path.join(args.directory, os.path.basename(path))
+        if os.path.abspath(output) == os.path.abspath(path):
+            print('%s: the output would replace the input' % path)
+            succeeded = False
+            continue
+        succeeded = compile_file(path, output) and succeeded
+    sys.exit(0 if succeeded else 1)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,183 @@
+#!/usr/bin/python
+# compile_sprite_sheet.py
+# Converts sprite sheet plists (TexturePacker / Zwoptex, formats 0 to 3) to binary sprite sheets (.ccss),
+# loaded by cocos2d::SpriteSheet / SpriteFrameCache without parsing.
+#
+# usage: compile_sprite_sheet.py [-h] [-o OUTPUT] PLIST [PLIST ...]
+#
+# Without -o, every PLIST is written next to itself with the .ccss extension.
+
+import argparse
+import os
+import plistlib
+import re
+import struct
+import sys
+
+MAGIC = b'CCSS'
+VERSION = 1
+#must match BinaryHeader, BinaryFrame and BinaryAlias in cocos/2d/CCSpriteSheet.cpp
+HEADER_FORMAT = '<4sIIIIIIIIIIffIIIII'
+FRAME_FORMAT = '<II10fIIII'
+ALIAS_FORMAT = '<III'
+
+FRAME_ROTATED = 1
+FRAME_HAS_ANCHOR = 2
+
+
+def parse_floats(value):
+    return [float(v) for v in re.findall(r'[-+]?[0-9]*\.?[0-9]+(?:[eE][-+]?[0-9]+)?', value or '')]
+
+
+def point(value):
+    v = parse_floats(value)
+    return (v[0], v[1]) if len(v) == 2 else (0.0, 0.0)
+
+
+def rect(value):
+    v = parse_floats(value)
+    return tuple(v) if len(v) == 4 else (0.0, 0.0, 0.0, 0.0)
+
+
+def int_list(value):
+    return [int(v) for v in value.split()] if value else []
+
+
+#same interpretation as SpriteFrameCache::addSpriteFramesWithDictionary()
+def convert_frame(fmt, d):
+    frame = {'rotated': False, 'anchor': None, 'aliases': [], 'vertices': [], 'verticesUV': [], 'triangles': []}
+    if fmt == 0:
+        frame['rect'] = (float(d.get('x', 0)), float(d.get('y', 0)), float(d.get('width', 0)), float(d.get('height', 0)))
+        frame['offset'] = (float(d.get('offsetX', 0)), float(d.get('offsetY', 0)))
+        frame['original'] = (float(abs(int(d.get('originalWidth', 0)))), float(abs(int(d.get('originalHeight', 0)))))
+    elif fmt in (1, 2):
+        frame['rect'] = rect(d.get('frame'))
+        frame['rotated'] = fmt == 2 and bool(d.get('rotated', False))
+        frame['offset'] = point(d.get('offset'))
+        frame['original'] = point(d.get('sourceSize'))
+    else:
+        size = point(d.get('spriteSize'))
+        texture_rect = rect(d.get('textureRect'))
+        frame['rect'] = (texture_rect[0], texture_rect[1], size[0], size[1])
+        frame['rotated'] = bool(d.get('textureRotated', False))
+        frame['offset'] = point(d.get('spriteOffset'))
+        frame['original'] = point(d.get('spriteSourceSize'))
+        frame['aliases'] = list(d.get('aliases', []))
+        if 'anchor' in d:
+            frame['anchor'] = point(d['anchor'])
+        if 'vertices' in d:
+            frame['vertices'] = int_list(d.get('vertices'))
+            frame['verticesUV'] = int_list(d.get('verticesUV'))
+            frame['triangles'] = int_list(d.get('triangles'))
+    return frame
+
+
+class StringTable(object):
+    def __init__(self):
+        self.data = bytearray()
+        self.offsets = {}
+
+    def add(self, value):
+        encoded = value.encode('utf-8')
+        if encoded not in self.offsets:
+            self.offsets[encoded] = len(self.data)
+            self.data.extend(encoded)
+        return self.offsets[encoded], len(encoded)
+
+
+def compile_sheet(plist_path, output_path):
+    with open(plist_path, 'rb') as f:
+        if hasattr(plistlib, 'load'):
+            root = plistlib.load(f)
+        else:
+            root = plistlib.readPlist(f)
+
+    metadata = root.get('metadata', {})
+    fmt = int(metadata.get('format', 0))
+    if fmt < 0 or fmt > 3:
+        print('%s: format %d is not supported' % (plist_path, fmt))
+        return False
+    texture_size = point(metadata.get('size')) if 'size' in metadata else (0.0, 0.0)
+
+    strings = StringTable()
+    frames = bytearray()
+    aliases = bytearray()
+    polygons = []
+
+    names = sorted(root.get('frames', {}).keys())
+    for index, name in enumerate(names):
+        frame = convert_frame(fmt, root['frames'][name])
+        name_offset, name_length = strings.add(name)
+
+        flags = 0
+        if frame['rotated']:
+            flags |= FRAME_ROTATED
+        anchor = (0.0, 0.0)
+        if frame['anchor'] is not None:
+            flags |= FRAME_HAS_ANCHOR
+            anchor = frame['anchor']
+
+        vertices = frame['vertices']
+        vertices_uv = frame['verticesUV']
+        if len(vertices_uv) != len(vertices):
+            print('%s: %s has %d vertices but %d UVs' % (plist_path, name, len(vertices), len(vertices_uv)))
+            return False
+        polygon_offset = len(polygons)
+        polygons.extend(vertices)
+        polygons.extend(vertices_uv)
+        polygons.extend(frame['triangles'])
+
+        frames.extend(struct.pack(FRAME_FORMAT, name_offset, name_length,
+                                  frame['rect'][0], frame['rect'][1], frame['rect'][2], frame['rect'][3],
+                                  frame['offset'][0], frame['offset'][1],
+                                  frame['original'][0], frame['original'][1],
+                                  anchor[0], anchor[1],
+                                  flags, polygon_offset, len(vertices), len(frame['triangles'])))
+
+        for alias in frame['aliases']:
+            alias_offset, alias_length = strings.add(alias)
+            aliases.extend(struct.pack(ALIAS_FORMAT, alias_offset, alias_length, index))
+
+    texture_offset, texture_length = strings.add(metadata.get('textureFileName', ''))
+    pixel_format_offset, pixel_format_length = strings.add(metadata.get('pixelFormat', ''))
+
+    frames_offset = struct.calcsize(HEADER_FORMAT)
+    aliases_offset = frames_offset + len(frames)
+    polygons_offset = aliases_offset + len(aliases)
+    strings_offset = polygons_offset + len(polygons) * 4
+
+    header = struct.pack(HEADER_FORMAT, MAGIC, VERSION, fmt, len(names), len(aliases) // struct.calcsize(ALIAS_FORMAT),
+                         len(polygons), frames_offset, aliases_offset, polygons_offset, strings_offset, len(strings.data),
+                         texture_size[0], texture_size[1], texture_offset, texture_length,
+                         pixel_format_offset, pixel_format_length, 0)
+
+    with open(output_path, 'wb') as f:
+        f.write(header)
+        f.write(frames)
+        f.write(aliases)
+        f.write(struct.pack('<%di' % len(polygons), *polygons))
+        f.write(strings.data)
+
+    print('%s: %d frames' % (output_path, len(names)))
+    return True
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Converts sprite sheet plists to cocos2d-x binary sprite sheets.')
+    parser.add_argument('plists', metavar='PLIST', nargs='+', help='sprite sheet plist to convert')
+    parser.add_argument('-o', '--output', help='output file, only when converting a single plist')
+    args = parser.parse_args()
+
+    if args.output and len(args.plists) > 1:
+        print('-o can only be used with a single plist')
+        sys.exit(1)
+
+    succeeded = True
+    for plist in args.plists:
+        output = args.output or os.path.splitext(plist)[0] + '.ccss'
+        succeeded = compile_sheet(plist, output) and succeeded
+    sys.exit(0 if succeeded else 1)
+
+
+if __name__ == '__main__':
+    main()